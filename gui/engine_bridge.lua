@@ -23,6 +23,20 @@ ffi.cdef[[
         PLAYER_STATE_PAUSED = 2
     } PlayerState;
 
+    // Onset, tempo and band energy frame
+    typedef struct {
+        float bass;
+        float mid;
+        float high;
+        float centroid_hz;
+        float onset;
+        float bpm;
+        float beat_phase;
+        float beat_confidence;
+        uint32_t onset_count;
+        uint32_t beat_count;
+    } RhythmFeatures;
+
     // Status structure
     typedef struct {
         char* current_file;
@@ -31,11 +45,37 @@ ffi.cdef[[
         float progress;
         int current_time;
         int total_time;
+        bool duration_known;
         PlayerState state;
         float volume;
         float vis_bands[32];
+        RhythmFeatures features;
+        bool shuffle;
     } RhythmStatus;
 
+    // Allocation-free status snapshot filled in place
+    typedef struct {
+        uint32_t sequence;
+        uint32_t file_sequence;
+        char file_name[256];
+        RhythmStatus status;
+    } RhythmStatusFrame;
+
+    // Equalizer settings
+    typedef struct {
+        bool enabled;
+        float preamp_db;
+        float band_frequency[10];
+        float band_gain_db[10];
+    } RhythmEqualizer;
+
+    // Waveform overview bucket
+    typedef struct {
+        float min;
+        float max;
+        float rms;
+    } RhythmWaveformBucket;
+
     // Engine lifecycle management
     RhythmEngine* rhythm_engine_create(void);
     void rhythm_engine_destroy(RhythmEngine* engine);
@@ -53,14 +93,42 @@ ffi.cdef[[
     RhythmError rhythm_engine_seek(RhythmEngine* engine, float position);
     RhythmError rhythm_engine_set_volume(RhythmEngine* engine, float volume);
 
+    // Equalizer
+    RhythmError rhythm_engine_set_eq_enabled(RhythmEngine* engine, bool enabled);
+    RhythmError rhythm_engine_set_eq_band(RhythmEngine* engine, int band, float gain_db);
+    RhythmError rhythm_engine_set_eq_preamp(RhythmEngine* engine, float gain_db);
+    RhythmError rhythm_engine_get_eq(RhythmEngine* engine, RhythmEqualizer* eq);
+
+    // Waveform overview
+    RhythmError rhythm_engine_get_waveform(RhythmEngine* engine, float start, float end,
+                                           RhythmWaveformBucket* buckets, int count, float* ready);
+
     // Status queries and updates
     RhythmStatus rhythm_engine_get_status(RhythmEngine* engine);
+    RhythmError rhythm_engine_get_status_frame(RhythmEngine* engine, RhythmStatusFrame* frame);
+    size_t rhythm_engine_status_frame_size(void);
     void rhythm_engine_update(RhythmEngine* engine);
+    RhythmError rhythm_engine_set_interactive(RhythmEngine* engine, bool interactive);
     RhythmError rhythm_engine_get_last_error(RhythmEngine* engine);
     const char* rhythm_engine_error_string(RhythmError error);
 
     // Memory management
     void free(void* ptr);
+
+    // Client for an engine hosted by the rhythm-gui launcher
+    typedef struct RhythmClient RhythmClient;
+    RhythmClient* rhythm_client_connect(const char* name);
+    void rhythm_client_disconnect(RhythmClient* client);
+    bool rhythm_client_host_alive(RhythmClient* client);
+    RhythmError rhythm_client_get_status_frame(RhythmClient* client, RhythmStatusFrame* frame);
+    size_t rhythm_client_status_frame_size(void);
+    RhythmError rhythm_client_get_eq(RhythmClient* client, RhythmEqualizer* eq);
+    RhythmError rhythm_client_get_waveform(RhythmClient* client, float start, float end,
+                                           RhythmWaveformBucket* buckets, int count, float* ready);
+    int64_t rhythm_client_send(RhythmClient* client, int type, int index, float value, const char* path);
+    RhythmError rhythm_client_wait(RhythmClient* client, int64_t ticket, int timeout_ms);
+    RhythmError rhythm_client_call(RhythmClient* client, int type, int index, float value,
+                                   const char* path, int timeout_ms);
 ]]
 
 local ERROR_MESSAGES = {
@@ -80,6 +148,107 @@ local PLAYER_STATES = {
     [2] = "paused"
 }
 
+-- EngineCommandType in shared/engine_shm.h
+local COMMANDS = {
+    load_file = 0,
+    load_directory = 1,
+    play = 2,
+    pause = 3,
+    stop = 4,
+    next_track = 5,
+    previous_track = 6,
+    seek = 7,
+    set_volume = 8,
+    set_eq_enabled = 9,
+    set_eq_band = 10,
+    set_eq_preamp = 11,
+    set_interactive = 12
+}
+
+local LOAD_TIMEOUT_MS = 10000
+local CALL_TIMEOUT_MS = 2000
+local RHYTHM_ERROR_INVALID_STATE = -7
+
+-- the library fills whole frames, so a cdef that drifted from the C struct would write
+-- past the bridge's own; refuse to start rather than corrupt memory
+local function check_frame_size(size, library)
+    if ffi.sizeof("RhythmStatusFrame") ~= tonumber(size) then
+        error(string.format("RhythmStatusFrame is %d bytes in %s but %d in engine_bridge.lua",
+                            tonumber(size), library, ffi.sizeof("RhythmStatusFrame")))
+    end
+end
+
+local function load_library(names)
+    for _, path in ipairs(names) do
+        local ok, result = pcall(ffi.load, path)
+        if ok then
+            return result
+        end
+    end
+    return nil
+end
+
+-- Stands in for the engine library when the launcher hosts the engine: the same
+-- entry points, routed through the shared-memory client. Transport commands wait for
+-- the host's result; seek, volume and EQ are queued and return at once, so dragging
+-- a slider never waits on the host.
+local function hosted_engine_lib(client_lib)
+    local last_error = 0
+
+    local function call(client, command, index, value, path, timeout_ms)
+        last_error = tonumber(client_lib.rhythm_client_call(client, command, index or 0, value or 0.0,
+                                                            path, timeout_ms or CALL_TIMEOUT_MS))
+        return last_error
+    end
+
+    local function send(client, command, index, value)
+        if client_lib.rhythm_client_send(client, command, index, value, nil) < 0 then
+            last_error = RHYTHM_ERROR_INVALID_STATE
+            return last_error
+        end
+        return 0
+    end
+
+    return {
+        rhythm_engine_destroy = function(client) client_lib.rhythm_client_disconnect(client) end,
+        rhythm_engine_load_file = function(client, path)
+            return call(client, COMMANDS.load_file, 0, 0.0, path, LOAD_TIMEOUT_MS)
+        end,
+        rhythm_engine_load_directory = function(client, path)
+            return call(client, COMMANDS.load_directory, 0, 0.0, path, LOAD_TIMEOUT_MS)
+        end,
+        rhythm_engine_play = function(client) return call(client, COMMANDS.play) end,
+        rhythm_engine_pause = function(client) return call(client, COMMANDS.pause) end,
+        rhythm_engine_stop = function(client) return call(client, COMMANDS.stop) end,
+        rhythm_engine_next_track = function(client) return call(client, COMMANDS.next_track) end,
+        rhythm_engine_previous_track = function(client) return call(client, COMMANDS.previous_track) end,
+        rhythm_engine_seek = function(client, position)
+            return send(client, COMMANDS.seek, 0, position)
+        end,
+        rhythm_engine_set_volume = function(client, volume)
+            return send(client, COMMANDS.set_volume, 0, volume)
+        end,
+        rhythm_engine_set_eq_enabled = function(client, enabled)
+            return send(client, COMMANDS.set_eq_enabled, enabled and 1 or 0, 0.0)
+        end,
+        rhythm_engine_set_eq_band = function(client, band, gain_db)
+            return send(client, COMMANDS.set_eq_band, band, gain_db)
+        end,
+        rhythm_engine_set_eq_preamp = function(client, gain_db)
+            return send(client, COMMANDS.set_eq_preamp, 0, gain_db)
+        end,
+        rhythm_engine_set_interactive = function(client, interactive)
+            return send(client, COMMANDS.set_interactive, interactive and 1 or 0, 0.0)
+        end,
+        rhythm_engine_get_eq = client_lib.rhythm_client_get_eq,
+        rhythm_engine_get_waveform = client_lib.rhythm_client_get_waveform,
+        rhythm_engine_get_status_frame = client_lib.rhythm_client_get_status_frame,
+        -- the host thread keeps the engine updated
+        rhythm_engine_update = function() end,
+        rhythm_engine_get_last_error = function() return last_error end
+    }
+end
+
 local RhythmBridge = {}
 RhythmBridge.__index = RhythmBridge
 
@@ -92,29 +261,43 @@ function RhythmBridge:new()
     }
     setmetatable(bridge, self)
 
-    local success, lib = pcall(function()
-
-        local possible_paths = {
-            "./librhythm_engine.so",
-            "../build/librhythm_engine.so", 
-            "librhythm_engine.so",
-            "./build/librhythm_engine.so"
-        }
-
-        for _, path in ipairs(possible_paths) do
-            local ok, result = pcall(ffi.load, path)
-            if ok then
-                return result
-            end
+    -- rhythm-gui hosts its engine and names the segment here; share it rather than
+    -- decoding the same music a second time
+    local host_name = os.getenv("RHYTHM_ENGINE_SHM")
+    if host_name and host_name ~= "" then
+        local client_lib = load_library({
+            "./librhythm_client.so",
+            "../build/librhythm_client.so",
+            "librhythm_client.so",
+            "./build/librhythm_client.so",
+            "rhythm_client"
+        })
+        if client_lib then
+            check_frame_size(client_lib.rhythm_client_status_frame_size(), "librhythm_client")
         end
+        local client = client_lib and client_lib.rhythm_client_connect(host_name)
+        if client ~= nil then
+            bridge.engine_lib = hosted_engine_lib(client_lib)
+            bridge.engine = client
+            bridge.hosted = true
+            bridge.is_initialized = true
+            return bridge
+        end
+        print("Warning: Engine host " .. host_name .. " unavailable, starting a local engine")
+    end
 
-        return ffi.load("rhythm_engine")
-    end)
-
-    if not success then
-        error("Failed to load rhythm engine library: " .. tostring(lib))
+    local lib = load_library({
+        "./librhythm_engine.so",
+        "../build/librhythm_engine.so",
+        "librhythm_engine.so",
+        "./build/librhythm_engine.so",
+        "rhythm_engine"
+    })
+    if not lib then
+        error("Failed to load rhythm engine library")
     end
 
+    check_frame_size(lib.rhythm_engine_status_frame_size(), "librhythm_engine")
     bridge.engine_lib = lib
 
     bridge.engine = bridge.engine_lib.rhythm_engine_create()
@@ -229,37 +412,153 @@ function RhythmBridge:set_volume(volume)
     return self:_handle_error(result, "set_volume")
 end
 
+function RhythmBridge:set_eq_enabled(enabled)
+    self:_check_engine()
+    local result = self.engine_lib.rhythm_engine_set_eq_enabled(self.engine, enabled and true or false)
+    return self:_handle_error(result, "set_eq_enabled")
+end
+
+function RhythmBridge:set_eq_band(band, gain_db)
+    self:_check_engine()
+    if type(band) ~= "number" or type(gain_db) ~= "number" then
+        return false, "Band and gain must be numbers"
+    end
+    if band < 1 or band > 10 then
+        return false, "Band must be between 1 and 10"
+    end
+
+    local result = self.engine_lib.rhythm_engine_set_eq_band(self.engine, band - 1, gain_db)
+    return self:_handle_error(result, "set_eq_band")
+end
+
+function RhythmBridge:set_eq_preamp(gain_db)
+    self:_check_engine()
+    if type(gain_db) ~= "number" then
+        return false, "Gain must be a number"
+    end
+
+    local result = self.engine_lib.rhythm_engine_set_eq_preamp(self.engine, gain_db)
+    return self:_handle_error(result, "set_eq_preamp")
+end
+
+function RhythmBridge:get_eq()
+    self:_check_engine()
+    local c_eq = ffi.new("RhythmEqualizer")
+    local result = self.engine_lib.rhythm_engine_get_eq(self.engine, c_eq)
+    local ok, err = self:_handle_error(result, "get_eq")
+    if not ok then
+        return nil, err
+    end
+
+    local eq = {
+        enabled = c_eq.enabled,
+        preamp_db = c_eq.preamp_db,
+        frequencies = {},
+        gains = {}
+    }
+    for i = 0, 9 do
+        eq.frequencies[i + 1] = c_eq.band_frequency[i]
+        eq.gains[i + 1] = c_eq.band_gain_db[i]
+    end
+    return eq
+end
+
+-- returns count peaks (0..1) covering [start, finish) of the current track plus the analysed fraction
+function RhythmBridge:get_waveform(count, start, finish)
+    self:_check_engine()
+    start = start or 0.0
+    finish = finish or 1.0
+
+    if not self.waveform_buffer or self.waveform_count ~= count then
+        self.waveform_buffer = ffi.new("RhythmWaveformBucket[?]", count)
+        self.waveform_ready = ffi.new("float[1]")
+        self.waveform_count = count
+    end
+
+    local result = self.engine_lib.rhythm_engine_get_waveform(self.engine, start, finish,
+                                                              self.waveform_buffer, count, self.waveform_ready)
+    if tonumber(result) ~= 0 then
+        return nil, 0.0
+    end
+
+    local peaks = {}
+    for i = 0, count - 1 do
+        local bucket = self.waveform_buffer[i]
+        peaks[i + 1] = math.max(math.abs(bucket.min), math.abs(bucket.max))
+    end
+    return peaks, self.waveform_ready[0]
+end
+
+-- false while the window is hidden: the engine drops to low-power playback
+function RhythmBridge:set_interactive(interactive)
+    self:_check_engine()
+    local result = self.engine_lib.rhythm_engine_set_interactive(self.engine, interactive and true or false)
+    return self:_handle_error(result, "set_interactive")
+end
+
 function RhythmBridge:update()
     self:_check_engine()
     self.engine_lib.rhythm_engine_update(self.engine)
 end
 
-function RhythmBridge:get_status()
+-- The frame is one cdata object owned by the bridge and refilled in place, and the
+-- returned table is reused between calls, so polling every frame makes no garbage.
+-- Copy any field that has to outlive the next call.
+function RhythmBridge:get_status_frame()
     self:_check_engine()
-    local c_status = self.engine_lib.rhythm_engine_get_status(self.engine)
+    if not self.status_frame then
+        self.status_frame = ffi.new("RhythmStatusFrame")
+    end
+    self.engine_lib.rhythm_engine_get_status_frame(self.engine, self.status_frame)
+    return self.status_frame
+end
 
-    local state_num = tonumber(c_status.state)
-    local status = {
-        current_file = nil,
-        current_track = c_status.current_track,
-        total_tracks = c_status.total_tracks,
-        progress = c_status.progress,
-        current_time = c_status.current_time,
-        total_time = c_status.total_time,
-        state = PLAYER_STATES[state_num] or "unknown",
-        state_id = state_num,
-        volume = c_status.volume,
-        vis_bands = {}
-    }
+function RhythmBridge:get_status()
+    local frame = self:get_status_frame()
+    local c_status = frame.status
+
+    local status = self.status
+    if not status then
+        status = { vis_bands = {}, features = {} }
+        self.status = status
+    end
 
-    if c_status.current_file ~= nil then
-        status.current_file = ffi.string(c_status.current_file)
+    if frame.file_sequence ~= self.file_sequence then
+        self.file_sequence = frame.file_sequence
+        status.current_file = frame.file_name[0] ~= 0 and ffi.string(frame.file_name) or nil
     end
 
+    local state_num = tonumber(c_status.state)
+    status.sequence = frame.sequence
+    status.current_track = c_status.current_track
+    status.total_tracks = c_status.total_tracks
+    status.progress = c_status.progress
+    status.current_time = c_status.current_time
+    status.total_time = c_status.total_time
+    status.duration_known = c_status.duration_known
+    status.state = PLAYER_STATES[state_num] or "unknown"
+    status.state_id = state_num
+    status.volume = c_status.volume
+    status.shuffle = c_status.shuffle
+
+    local vis_bands = status.vis_bands
     for i = 0, 31 do
-        status.vis_bands[i + 1] = c_status.vis_bands[i]
+        vis_bands[i + 1] = c_status.vis_bands[i]
     end
 
+    local f = c_status.features
+    local features = status.features
+    features.bass = f.bass
+    features.mid = f.mid
+    features.high = f.high
+    features.centroid_hz = f.centroid_hz
+    features.onset = f.onset
+    features.bpm = f.bpm
+    features.beat_phase = f.beat_phase
+    features.beat_confidence = f.beat_confidence
+    features.onset_count = f.onset_count
+    features.beat_count = f.beat_count
+
     return status
 end
 
@@ -280,6 +579,11 @@ function RhythmBridge:is_valid()
     return self.is_initialized and self.engine ~= nil
 end
 
+-- true when the engine lives in the launcher process and this bridge is its client
+function RhythmBridge:is_hosted()
+    return self.hosted == true
+end
+
 function RhythmBridge:get_state_name(state_id)
     return PLAYER_STATES[state_id] or "unknown"
 end
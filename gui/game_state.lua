@@ -4,11 +4,15 @@ local Controls = require("ui.controls")
 local Visualizer = require("ui.visualizer")
 local GameState = {}
 
+local HIDDEN_STATUS_INTERVAL = 1.0  -- seconds, the engine's low-power tick
+
 GameState.initialized = false
 GameState.window_width = 800
 GameState.window_height = 600
 GameState.engine = nil
 GameState.last_status = nil
+GameState.hidden = false
+GameState.hidden_poll_elapsed = 0
 
 GameState.theme = {
 
@@ -130,7 +134,13 @@ function GameState:init()
         local music_path = os.getenv("RHYTHM_MUSIC_PATH")
         local loaded = false
 
-        if music_path then
+        -- a hosted engine already holds the launcher's playlist
+        if self.engine:is_hosted() and self.engine:get_status().total_tracks > 0 then
+            print("Using the launcher's engine and playlist")
+            loaded = true
+        end
+
+        if music_path and not loaded then
             print("Loading music from launcher:", music_path)
 
             local is_directory = false
@@ -212,32 +222,22 @@ function GameState:update(dt)
 
     self:_updateEngineStatus(dt)
 
+    local status = self.last_status
+    local is_playing = status and status.state == "playing"
+    local features = status and status.features
+
     local audio_energy = 0
     local bass_energy = 0
     local mid_energy = 0
     local high_energy = 0
 
-    if self.visualizer_component and self.visualizer_component.animation then
-
-        for i = 1, 8 do 
-            bass_energy = bass_energy + (self.visualizer_component.animation.current_bands[i] or 0)
-        end
-        for i = 9, 20 do 
-            mid_energy = mid_energy + (self.visualizer_component.animation.current_bands[i] or 0)
-        end
-        for i = 21, 32 do 
-            high_energy = high_energy + (self.visualizer_component.animation.current_bands[i] or 0)
-        end
-
-        bass_energy = math.min(1.0, bass_energy / 4.0)
-        mid_energy = math.min(1.0, mid_energy / 6.0)
-        high_energy = math.min(1.0, high_energy / 6.0)
+    if features then
+        bass_energy = features.bass
+        mid_energy = features.mid
+        high_energy = features.high
         audio_energy = (bass_energy + mid_energy + high_energy) / 3.0
     end
 
-    local status = self.last_status
-    local is_playing = status and status.state == "playing"
-
     local base_glow = 0.6 + 0.15 * math.sin(self.floating_animation.time * 1.1)
     local bass_glow = is_playing and (bass_energy * 0.4) or 0
     local high_glow = is_playing and (high_energy * 0.2) or 0
@@ -268,12 +268,16 @@ function GameState:update(dt)
         b = 0.65 + 0.25 * math.sin(color_cycle + high_energy * 4) + high_color_mod
     }
 
-    local beat_threshold = 0.6
-    local strong_beat_threshold = 0.8
-    local current_bass = bass_energy
-    local previous_bass = self.floating_animation.previous_bass or 0
-    local beat_detected = is_playing and current_bass > beat_threshold and previous_bass < beat_threshold
-    local strong_beat_detected = is_playing and current_bass > strong_beat_threshold and previous_bass < strong_beat_threshold
+    -- beats come from the engine's tracker; until it has a tempo, onsets stand in for them
+    local beat_detected = false
+    local strong_beat_detected = false
+    if is_playing and features then
+        local counter = features.bpm > 0 and features.beat_count or features.onset_count
+        local previous = self.floating_animation.last_beat_counter
+        beat_detected = previous ~= nil and counter ~= previous
+        strong_beat_detected = beat_detected and features.onset > 0.8
+        self.floating_animation.last_beat_counter = counter
+    end
 
     if strong_beat_detected then
         self.floating_animation.beat_pulse = 1.5  
@@ -306,71 +310,30 @@ function GameState:update(dt)
         combined = (bass_energy + mid_energy + high_energy) / 3 * math.sin(harmonic_phase * 1.618) 
     }
 
-    self.floating_animation.previous_bass = current_bass
-
+    -- centroid on a log scale, 100 Hz to 10 kHz
     local spectral_centroid = 0
-    local spectral_rolloff = 0
     local spectral_flux = 0
-
-    if self.visualizer_component and self.visualizer_component.animation then
-
-        local weighted_sum = 0
-        local magnitude_sum = 0
-        for i = 1, 32 do
-            local magnitude = self.visualizer_component.animation.current_bands[i] or 0
-            weighted_sum = weighted_sum + (i * magnitude)
-            magnitude_sum = magnitude_sum + magnitude
+    if features then
+        if features.centroid_hz > 0 then
+            spectral_centroid = math.max(0, math.min(1, math.log(features.centroid_hz / 100) / math.log(100)))
         end
-        spectral_centroid = magnitude_sum > 0 and (weighted_sum / magnitude_sum / 32) or 0
-
-        local energy_threshold = magnitude_sum * 0.85
-        local cumulative_energy = 0
-        for i = 1, 32 do
-            cumulative_energy = cumulative_energy + (self.visualizer_component.animation.current_bands[i] or 0)
-            if cumulative_energy >= energy_threshold then
-                spectral_rolloff = i / 32
-                break
-            end
-        end
-
-        local current_spectrum_sum = 0
-        local previous_spectrum_sum = self.floating_animation.previous_spectrum_sum or 0
-        for i = 1, 32 do
-            current_spectrum_sum = current_spectrum_sum + (self.visualizer_component.animation.current_bands[i] or 0)
-        end
-        spectral_flux = math.abs(current_spectrum_sum - previous_spectrum_sum)
-        self.floating_animation.previous_spectrum_sum = current_spectrum_sum
+        spectral_flux = features.onset
     end
 
     self.floating_animation.spectral_features = {
         centroid = spectral_centroid,
-        rolloff = spectral_rolloff,
         flux = spectral_flux,
         brightness = spectral_centroid * audio_energy,
         warmth = (1 - spectral_centroid) * bass_energy,
-        dynamics = spectral_flux * 0.1
+        dynamics = spectral_flux * 0.5
     }
 
-    if beat_detected then
-        local current_time = self.floating_animation.time
-        local last_beat_time = self.floating_animation.last_beat_time or current_time
-        local beat_interval = current_time - last_beat_time
-
-        if beat_interval > 0.3 and beat_interval < 2.0 then 
-            local estimated_bpm = 60 / beat_interval
-            self.floating_animation.estimated_bpm = estimated_bpm
-            self.floating_animation.beat_phase = 0 
-        end
-
-        self.floating_animation.last_beat_time = current_time
-    end
-
-    if self.floating_animation.estimated_bpm then
-        local beat_duration = 60 / self.floating_animation.estimated_bpm
-        self.floating_animation.beat_phase = (self.floating_animation.beat_phase or 0) + dt / beat_duration
-        if self.floating_animation.beat_phase > 1 then
-            self.floating_animation.beat_phase = self.floating_animation.beat_phase - 1
-        end
+    if is_playing and features and features.bpm > 0 then
+        self.floating_animation.estimated_bpm = features.bpm
+        self.floating_animation.beat_phase = features.beat_phase
+    else
+        self.floating_animation.estimated_bpm = nil
+        self.floating_animation.beat_phase = nil
     end
 
     self.floating_animation.audio_energy = audio_energy
@@ -987,6 +950,7 @@ function GameState:_drawCircularProgress(center_x, center_y, radius)
     local progress = status and status.progress or 0.0
     local current_time = status and status.current_time or 0
     local total_time = status and status.total_time or 0
+    local live = status and status.current_file and status.duration_known == false
 
     self.progress_ring = {
         center_x = center_x,
@@ -1004,6 +968,20 @@ function GameState:_drawCircularProgress(center_x, center_y, radius)
     love.graphics.setLineWidth(6)
     love.graphics.circle("line", center_x, center_y, radius)
 
+    local peaks = self.waveform and self.waveform.peaks
+    if peaks then
+        love.graphics.setLineWidth(2)
+        for i, peak in ipairs(peaks) do
+            local fraction = (i - 0.5) / #peaks
+            local angle = -math.pi / 2 + fraction * 2 * math.pi
+            local length = 4 + peak * 18
+            local alpha = fraction <= progress and 0.6 or 0.25
+            love.graphics.setColor(self.theme.text_secondary[1], self.theme.text_secondary[2], self.theme.text_secondary[3], alpha)
+            love.graphics.line(center_x + math.cos(angle) * (radius + 10), center_y + math.sin(angle) * (radius + 10),
+                               center_x + math.cos(angle) * (radius + 10 + length), center_y + math.sin(angle) * (radius + 10 + length))
+        end
+    end
+
     if progress > 0 then
         local start_angle = -math.pi / 2  
         local end_angle = start_angle + (progress * 2 * math.pi)
@@ -1052,7 +1030,7 @@ function GameState:_drawCircularProgress(center_x, center_y, radius)
     love.graphics.setColor(self.theme.text_secondary)
 
     local current_str = self:_formatTime(current_time)
-    local total_str = self:_formatTime(total_time)
+    local total_str = live and "LIVE" or self:_formatTime(total_time)
 
     love.graphics.print(current_str, center_x - radius - 40, center_y + radius + 25)
 
@@ -1207,6 +1185,15 @@ function GameState:resize(w, h)
     print(string.format("Window resized to %dx%d", w, h))
 end
 
+-- a hidden window lets the engine drop to low-power playback and polls it rarely
+function GameState:setVisible(visible)
+    self.hidden = not visible
+    self.hidden_poll_elapsed = 0
+    if self.engine and self.engine:is_valid() then
+        self.engine:set_interactive(visible)
+    end
+end
+
 function GameState:handleDroppedFile(file)
     local filename = file:getFilename()
     print("Processing dropped file:", filename)
@@ -1519,6 +1506,14 @@ function GameState:_updateEngineStatus(dt)
         return
     end
 
+    if self.hidden then
+        self.hidden_poll_elapsed = self.hidden_poll_elapsed + dt
+        if self.hidden_poll_elapsed < HIDDEN_STATUS_INTERVAL then
+            return
+        end
+        self.hidden_poll_elapsed = 0
+    end
+
     self.engine:update()
     local status = self.engine:get_status()
 
@@ -1539,6 +1534,7 @@ function GameState:_updateEngineStatus(dt)
     self.app_state.volume = status.volume
 
     self:_handleStateChanges(previous_state, current_state, status)
+    self:_refreshWaveform(status)
 
     if status.state == "playing" then
         self.app_state.is_playing = true
@@ -1559,6 +1555,24 @@ function GameState:_updateEngineStatus(dt)
     end
 end
 
+-- the engine analyses the track in the background; poll until it is done, then keep the result
+function GameState:_refreshWaveform(status)
+    local waveform = self.waveform
+    local now = love.timer.getTime()
+    if waveform and waveform.file == status.current_file and
+       (waveform.ready >= 1.0 or now - waveform.fetched_at < 0.5) then
+        return
+    end
+
+    local peaks, ready = self.engine:get_waveform(256)
+    self.waveform = {
+        file = status.current_file,
+        peaks = peaks,
+        ready = peaks and ready or 0.0,
+        fetched_at = now
+    }
+end
+
 function GameState:_handleStateChanges(previous_state, current_state, status)
     if previous_state ~= current_state then
         print(string.format("State change: %s -> %s (track %d/%d, progress %.2f)", 
@@ -1,5 +1,7 @@
 local GameState = require("game_state")
 
+local HIDDEN_FRAME_SLEEP = 0.1  -- seconds; a hidden window has no vsync to pace it
+
 function love.load()
 
     love.window.setTitle("Rhythm")
@@ -25,9 +27,17 @@ end
 
 function love.update(dt)
 
+    if GameState.hidden then
+        love.timer.sleep(HIDDEN_FRAME_SLEEP)
+    end
     GameState:update(dt)
 end
 
+function love.visible(visible)
+
+    GameState:setVisible(visible)
+end
+
 function love.draw()
 
     love.graphics.clear(GameState.theme.background)
@@ -73,11 +73,64 @@ print("\n8. Testing utility functions...")
 print("  Time formatting: " .. bridge:format_time(125) .. " (should be 02:05)")
 print("  State name: " .. bridge:get_state_name(0) .. " (should be 'stopped')")
 
-print("\n9. Testing cleanup...")
+print("\n9. Comparing status fetch paths...")
+local ffi = require("ffi")
+local ITERATIONS = 100000
+
+-- what get_status did before the frame API: a struct by value, a fresh table per call
+-- and a string copied from memory the next call frees
+local function legacy_get_status()
+    local c_status = bridge.engine_lib.rhythm_engine_get_status(bridge.engine)
+    local status = {
+        current_track = c_status.current_track,
+        total_tracks = c_status.total_tracks,
+        progress = c_status.progress,
+        current_time = c_status.current_time,
+        total_time = c_status.total_time,
+        duration_known = c_status.duration_known,
+        state = tonumber(c_status.state),
+        volume = c_status.volume,
+        vis_bands = {}
+    }
+    if c_status.current_file ~= nil then
+        status.current_file = ffi.string(c_status.current_file)
+    end
+    for i = 0, 31 do
+        status.vis_bands[i + 1] = c_status.vis_bands[i]
+    end
+    return status
+end
+
+local function measure(label, fetch)
+    collectgarbage("collect")
+    collectgarbage("stop")
+    local memory_before = collectgarbage("count")
+    local start = os.clock()
+    for _ = 1, ITERATIONS do
+        bridge:update()
+        fetch()
+    end
+    local elapsed = os.clock() - start
+    local garbage_kb = collectgarbage("count") - memory_before
+    collectgarbage("restart")
+    print(string.format("  %-12s %7.2f us/frame  %8.1f bytes/frame garbage",
+        label, elapsed / ITERATIONS * 1e6, garbage_kb * 1024 / ITERATIONS))
+    return garbage_kb
+end
+
+local legacy_garbage = measure("by value", legacy_get_status)
+local frame_garbage = measure("frame", function() return bridge:get_status() end)
+if frame_garbage < legacy_garbage then
+    print("SUCCESS: Frame fetch creates less garbage")
+else
+    print("FAILED: Frame fetch should not allocate per call")
+end
+
+print("\n10. Testing cleanup...")
 bridge:destroy()
 print("SUCCESS: Engine destroyed")
 
-print("\n10. Testing post-cleanup error handling...")
+print("\n11. Testing post-cleanup error handling...")
 local ok, err = pcall(function() bridge:get_status() end)
 if not ok then
     print("SUCCESS: Post-cleanup access properly blocked")
@@ -142,7 +142,7 @@ function Controls:_setupButtons()
             id = "equalizer",
             text = "⫸",
             tooltip = "Equalizer",
-            action = function() print("Equalizer opened") end
+            action = function() self:_toggleEqualizer() end
         }
     }
 end
@@ -172,6 +172,7 @@ function Controls:_drawModernBottomControlBar(x, y, width, height)
     local progress = status and status.progress or 0.0
     local current_time = status and status.current_time or 0
     local total_time = status and status.total_time or 0
+    local live = status and status.current_file and status.duration_known == false
 
     love.graphics.setColor(self.game_state.theme.bg_elevated[1], self.game_state.theme.bg_elevated[2], self.game_state.theme.bg_elevated[3], 0.8)
     love.graphics.rectangle("fill", x, y, width, height)
@@ -213,16 +214,18 @@ function Controls:_drawModernBottomControlBar(x, y, width, height)
     local repeat_button_x = x + width - button_size - 20  
     local shuffle_button_x = repeat_button_x - button_size - button_spacing  
     local volume_button_x = shuffle_button_x - button_size - button_spacing  
+    local equalizer_button_x = volume_button_x - button_size - button_spacing
 
-    local progress_width = volume_button_x - progress_start_x - button_spacing - time_width
+    local progress_width = equalizer_button_x - progress_start_x - button_spacing - time_width
 
-    self:_drawModernProgressBar(progress_start_x, progress_y, progress_width, progress_height, progress, current_time, total_time)
+    self:_drawModernProgressBar(progress_start_x, progress_y, progress_width, progress_height, progress, current_time, total_time, live)
 
     self:_drawModernControlButton(prev_x, control_y, button_size, "previous", "previous")
     self:_drawModernControlButton(play_x, control_y, button_size, "play_pause", self:_getPlayPauseIcon())
     self:_drawModernControlButton(next_x, control_y, button_size, "next", "next")
 
     self:_drawModernVolumeButton(volume_button_x, control_y, button_size)
+    self:_drawEqualizerButton(equalizer_button_x, control_y, button_size)
 
     self:_drawShuffleButton(shuffle_button_x, control_y, button_size)
     self:_drawRepeatButton(repeat_button_x, control_y, button_size)
@@ -234,7 +237,7 @@ function Controls:_getPlayPauseIcon()
     return is_playing and "pause" or "play"
 end
 
-function Controls:_drawModernProgressBar(x, y, width, height, progress, current_time, total_time)
+function Controls:_drawModernProgressBar(x, y, width, height, progress, current_time, total_time, live)
     local radius = height / 2
 
     self.progress_bar = self.progress_bar or {}
@@ -246,6 +249,8 @@ function Controls:_drawModernProgressBar(x, y, width, height, progress, current_
     love.graphics.setColor(self.game_state.theme.progress_bg[1], self.game_state.theme.progress_bg[2], self.game_state.theme.progress_bg[3], 0.6)
     self:_drawRoundedRect(x, y, width, height, radius)
 
+    self:_drawWaveform(x, y, width, height, progress)
+
     local fill_width = width * math.min(1.0, math.max(0.0, progress))
     if fill_width > 0 then
 
@@ -282,7 +287,7 @@ function Controls:_drawModernProgressBar(x, y, width, height, progress, current_
     love.graphics.setFont(time_font)
 
     local current_str = self:_formatTime(current_time)
-    local total_str = self:_formatTime(total_time)
+    local total_str = live and "LIVE" or self:_formatTime(total_time)
 
     love.graphics.setColor(self.game_state.theme.text_secondary)
     local time_y = y + height / 2 - time_font:getHeight() / 2  
@@ -292,6 +297,27 @@ function Controls:_drawModernProgressBar(x, y, width, height, progress, current_
     love.graphics.print(total_str, x + width + 10, time_y)
 end
 
+function Controls:_drawWaveform(x, y, width, height, progress)
+    local waveform = self.game_state.waveform
+    local peaks = waveform and waveform.peaks
+    if not peaks or width <= 0 then
+        return
+    end
+
+    local center_y = y + height / 2
+    local max_height = height * 2
+    local step = 3
+    love.graphics.setLineWidth(2)
+    for column = 0, width - 1, step do
+        local fraction = column / width
+        local peak = peaks[math.min(#peaks, math.floor(fraction * #peaks) + 1)]
+        local half = math.max(1, peak * max_height / 2)
+        local alpha = fraction <= progress and 0.5 or 0.25
+        love.graphics.setColor(1, 1, 1, alpha)
+        love.graphics.line(x + column, center_y - half, x + column, center_y + half)
+    end
+end
+
 function Controls:_drawModernControlButton(x, y, size, button_id, icon_name)
     local radius = size / 2
     local center_x = x + radius
@@ -418,6 +444,127 @@ function Controls:_drawVolumePopup(x, y)
     love.graphics.print(volume_text, popup_x + popup_width / 2 - text_width / 2, popup_y + popup_height + 5)
 end
 
+local EQ_LABELS = { "Pre", "31", "62", "125", "250", "500", "1k", "2k", "4k", "8k", "16k" }
+local EQ_RANGE_DB = 12
+
+function Controls:_toggleEqualizer()
+    if not self.eq_popup then
+        self.eq_popup = { is_open = false, x = 0, y = 0, width = 0, height = 0 }
+    end
+    self.eq_popup.is_open = not self.eq_popup.is_open
+
+    if self.eq_popup.is_open and self.game_state.engine and self.game_state.engine:is_valid() then
+        self.eq_popup.settings = self.game_state.engine:get_eq()
+    end
+end
+
+function Controls:_drawEqualizerButton(x, y, size)
+    local radius = size / 2
+    local center_x = x + radius
+    local center_y = y + radius
+
+    if not self.modern_buttons then self.modern_buttons = {} end
+    self.modern_buttons.equalizer = {
+        x = x, y = y, width = size, height = size,
+        center_x = center_x, center_y = center_y, radius = radius
+    }
+
+    local is_open = self.eq_popup and self.eq_popup.is_open
+    love.graphics.setColor(is_open and self.game_state.theme.accent_blue or self.game_state.theme.text_secondary)
+    local font = love.graphics.newFont(12)
+    love.graphics.setFont(font)
+    love.graphics.print("EQ", center_x - font:getWidth("EQ") / 2, center_y - font:getHeight() / 2)
+
+    if is_open then
+        self:_drawEqualizerPopup(center_x, y - 10)
+    end
+end
+
+function Controls:_drawEqualizerPopup(anchor_x, bottom_y)
+    local eq = self.eq_popup.settings
+    if not eq then
+        return
+    end
+
+    local column_width = 26
+    local popup_width = column_width * #EQ_LABELS + 10
+    local popup_height = 170
+    local popup_x = math.max(10, math.min(anchor_x - popup_width / 2, love.graphics.getWidth() - popup_width - 10))
+    local popup_y = bottom_y - popup_height
+
+    self.eq_popup.x = popup_x
+    self.eq_popup.y = popup_y
+    self.eq_popup.width = popup_width
+    self.eq_popup.height = popup_height
+    self.eq_popup.column_width = column_width
+    self.eq_popup.track_top = popup_y + 30
+    self.eq_popup.track_height = popup_height - 55
+
+    love.graphics.setColor(self.game_state.theme.bg_elevated[1], self.game_state.theme.bg_elevated[2], self.game_state.theme.bg_elevated[3], 0.95)
+    self:_drawRoundedRect(popup_x, popup_y, popup_width, popup_height, 8)
+
+    local font = love.graphics.newFont(10)
+    love.graphics.setFont(font)
+    love.graphics.setColor(eq.enabled and self.game_state.theme.accent_blue or self.game_state.theme.text_disabled)
+    love.graphics.print(eq.enabled and "EQ ON" or "EQ OFF", popup_x + 8, popup_y + 8)
+
+    local zero_y = self.eq_popup.track_top + self.eq_popup.track_height / 2
+    love.graphics.setColor(self.game_state.theme.progress_bg)
+    love.graphics.line(popup_x + 5, zero_y, popup_x + popup_width - 5, zero_y)
+
+    for i, label in ipairs(EQ_LABELS) do
+        local gain = (i == 1) and eq.preamp_db or eq.gains[i - 1]
+        local column_x = popup_x + 5 + (i - 1) * column_width + column_width / 2
+        local fraction = math.max(-1.0, math.min(1.0, gain / EQ_RANGE_DB))
+        local handle_y = zero_y - fraction * self.eq_popup.track_height / 2
+
+        love.graphics.setColor(self.game_state.theme.progress_bg)
+        self:_drawRoundedRect(column_x - 2, self.eq_popup.track_top, 4, self.eq_popup.track_height, 2)
+
+        love.graphics.setColor(self.game_state.theme.accent_blue)
+        love.graphics.rectangle("fill", column_x - 2, math.min(zero_y, handle_y), 4, math.abs(handle_y - zero_y))
+        love.graphics.circle("fill", column_x, handle_y, 6)
+
+        love.graphics.setColor(self.game_state.theme.text_secondary)
+        love.graphics.print(label, column_x - font:getWidth(label) / 2, popup_y + popup_height - 20)
+    end
+end
+
+function Controls:_handleEqualizerPopupClick(x, y, is_press)
+    local engine = self.game_state.engine
+    local eq = self.eq_popup.settings
+    if not engine or not engine:is_valid() or not eq then
+        return
+    end
+
+    if is_press and y < self.eq_popup.track_top - 5 then
+        eq.enabled = not eq.enabled
+        engine:set_eq_enabled(eq.enabled)
+        return
+    end
+
+    local column = self.eq_popup.dragging_column
+    if is_press then
+        column = math.floor((x - self.eq_popup.x - 5) / self.eq_popup.column_width) + 1
+        if column < 1 or column > #EQ_LABELS then
+            return
+        end
+        self.eq_popup.dragging_column = column
+    end
+
+    local zero_y = self.eq_popup.track_top + self.eq_popup.track_height / 2
+    local fraction = math.max(-1.0, math.min(1.0, (zero_y - y) / (self.eq_popup.track_height / 2)))
+    local gain = math.floor(fraction * EQ_RANGE_DB * 2 + 0.5) / 2
+
+    if column == 1 then
+        eq.preamp_db = gain
+        engine:set_eq_preamp(gain)
+    else
+        eq.gains[column - 1] = gain
+        engine:set_eq_band(column - 1, gain)
+    end
+end
+
 function Controls:_formatTime(seconds)
     if not seconds or seconds < 0 then
         return "00:00"
@@ -472,6 +619,8 @@ function Controls:mousepressed(x, y, button)
                             self.volume_popup = { is_open = false }
                         end
                         self.volume_popup.is_open = not self.volume_popup.is_open
+                    elseif button_id == "equalizer" then
+                        self:_toggleEqualizer()
                     end
                     return true
                 end
@@ -504,6 +653,14 @@ function Controls:mousepressed(x, y, button)
             self.volume_popup.is_open = false
         end
 
+        if self.eq_popup and self.eq_popup.is_open then
+            if self:_isPointInRect(x, y, self.eq_popup) then
+                self:_handleEqualizerPopupClick(x, y, true)
+                return true
+            end
+            self.eq_popup.is_open = false
+        end
+
         if self.main_play_button and self:_isPointInCircle(x, y, self.main_play_button) then
             self:_togglePlayback()
             return true
@@ -691,6 +848,11 @@ function Controls:mousereleased(x, y, button)
             return true
         end
 
+        if self.eq_popup and self.eq_popup.dragging_column then
+            self.eq_popup.dragging_column = nil
+            return true
+        end
+
     end
     return false
 end
@@ -713,6 +875,11 @@ function Controls:mousemoved(x, y, dx, dy)
         return true
     end
 
+    if self.eq_popup and self.eq_popup.dragging_column then
+        self:_handleEqualizerPopupClick(x, y, false)
+        return true
+    end
+
     return false
 end
 
@@ -739,6 +906,9 @@ function Controls:keypressed(key, scancode, isrepeat)
     elseif key == "m" then
         self:_toggleMute()
         return true
+    elseif key == "e" then
+        self:_toggleEqualizer()
+        return true
     end
     return false
 end
@@ -2,6 +2,7 @@
 #define CLI_H
 
 #include "core/rhythm_engine.h"
+#include "core/playlist_view.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -11,10 +12,28 @@
 #include <sys/ioctl.h>
 #include <time.h>
 #include <math.h>
+#include <limits.h>
+#include <poll.h>
+
+#define CLI_OUTPUT_BUFFER (64 * 1024)
 
 void cli_init(void);
 void cli_cleanup(void);
 void cli_display_status(const RhythmStatus *status);
+bool cli_stats_visible(void);
+void cli_display_stats(const RhythmStats *stats, const RhythmAudioInfo *info, const RhythmRealtimeStatus *realtime,
+                       const RhythmPrefetchStats *prefetch, const RhythmPcmCacheStats *pcm);
+void cli_display_loudness(const RhythmLoudnessScanStatus *scan, const RhythmTrackLoudness *track);
+// the [tab] pane; draws only the rows on screen and advances a type-ahead search
+void cli_display_playlist(RhythmEngine *engine);
+// frames are buffered and written once, so a remote terminal gets one write per frame
+void cli_present(void);
+// shorter while the playlist pane is being typed into or searched, else idle_ms
+int cli_frame_interval_ms(int idle_ms);
+// false while the output goes nowhere a person is looking
+bool cli_attended(void);
+// returns early when a key arrives
+void cli_wait_for_input(int timeout_ms);
 int cli_handle_input(RhythmEngine *engine);
 
 #endif 
\ No newline at end of file
@@ -0,0 +1,31 @@
+#ifndef RHYTHM_CLIENT_H
+#define RHYTHM_CLIENT_H
+
+#include "shared/engine_shm.h"
+
+// Thin client for an engine served by engine_host. It links neither PortAudio nor
+// mpg123: reads copy the host's latest published state, and commands are queued for
+// the host thread, so nothing a client does can hold up the audio callback.
+typedef struct RhythmClient RhythmClient;
+
+// name NULL uses $RHYTHM_ENGINE_SHM; NULL when there is no host
+RhythmClient* rhythm_client_connect(const char* name);
+void rhythm_client_disconnect(RhythmClient* client);
+bool rhythm_client_host_alive(RhythmClient* client);
+
+RhythmError rhythm_client_get_status_frame(RhythmClient* client, RhythmStatusFrame* frame);
+// same as rhythm_engine_status_frame_size, for bindings loading only the client
+size_t rhythm_client_status_frame_size(void);
+RhythmError rhythm_client_get_eq(RhythmClient* client, RhythmEqualizer* eq);
+// same contract as rhythm_engine_get_waveform, resampled from the host's overview
+RhythmError rhythm_client_get_waveform(RhythmClient* client, float start, float end,
+                                       RhythmWaveformBucket* buckets, int count, float* ready);
+
+// queues a command and returns its ticket, or -1 when the queue is full or path too long.
+// A ticket's result stays readable until ENGINE_SHM_COMMANDS more commands are sent.
+int64_t rhythm_client_send(RhythmClient* client, int type, int index, float value, const char* path);
+RhythmError rhythm_client_wait(RhythmClient* client, int64_t ticket, int timeout_ms);
+RhythmError rhythm_client_call(RhythmClient* client, int type, int index, float value,
+                               const char* path, int timeout_ms);
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef RHYTHM_REMOTE_H
+#define RHYTHM_REMOTE_H
+
+#include "shared/rhythm_protocol.h"
+#include <stddef.h>
+
+// Client side of the rhythmd socket protocol. One connection is meant for one thread.
+typedef struct RhythmRemote RhythmRemote;
+
+typedef struct {
+    RhythmMessageHeader header;
+    union {
+        uint8_t bytes[RHYTHM_PROTOCOL_MAX_PAYLOAD];
+        RhythmResultMessage result;
+        RhythmStatusFrame status;
+        RhythmEventMessage event;
+        RhythmVisMessage vis;
+    } payload;
+} RhythmMessage;
+
+// $RHYTHMD_SOCKET, else rhythmd.sock in $XDG_RUNTIME_DIR, else /tmp/rhythmd-<uid>.sock
+void rhythm_remote_default_path(char* path, size_t size);
+
+// socket_path NULL uses the default path
+RhythmRemote* rhythm_remote_connect(const char* socket_path);
+void rhythm_remote_close(RhythmRemote* remote);
+
+// sends a request without waiting and returns its id, or -1 when the connection failed
+int64_t rhythm_remote_send(RhythmRemote* remote, int type, const void* payload, uint32_t length);
+int64_t rhythm_remote_send_command(RhythmRemote* remote, int command, int index, float value, const char* path);
+// 1 with the next message, 0 on timeout (negative waits forever), -1 when the connection is gone
+int rhythm_remote_receive(RhythmRemote* remote, RhythmMessage* message, int timeout_ms);
+
+// Round trips. Events and vis frames that arrive while waiting are discarded, so a
+// subscriber should read its stream with rhythm_remote_receive instead.
+RhythmError rhythm_remote_ping(RhythmRemote* remote, int timeout_ms);
+RhythmError rhythm_remote_command(RhythmRemote* remote, int command, int index, float value,
+                                  const char* path, int timeout_ms);
+RhythmError rhythm_remote_get_status(RhythmRemote* remote, RhythmStatusFrame* frame, int timeout_ms);
+RhythmError rhythm_remote_subscribe(RhythmRemote* remote, uint32_t mask, int timeout_ms);
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef AUDIO_CONTEXT_H
+#define AUDIO_CONTEXT_H
+
+#include "core/decoder_pool.h"
+#include "core/pcm_cache.h"
+
+// Process-wide state shared by every player, reference counted so any number of engines
+// can come and go in any order: PortAudio is initialized by the first stream and
+// terminated after the last, and one decoder pool serves all players. The pool size
+// comes from RHYTHM_DECODER_THREADS, else one thread per CPU up to four. One PCM cache,
+// and so one memory budget, is shared the same way; RHYTHM_PCM_CACHE_MB and
+// RHYTHM_PCM_CACHE_PACK=1 configure it when it is created.
+int audio_context_acquire_portaudio(void);
+void audio_context_release_portaudio(void);
+
+DecoderPool *audio_context_acquire_pool(void);
+void audio_context_release_pool(void);
+
+PcmCache *audio_context_acquire_pcm_cache(void);
+void audio_context_release_pcm_cache(void);
+
+#endif
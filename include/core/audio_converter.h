@@ -6,5 +6,27 @@
 
 void convert_audio_format(float *input, float *output, int num_samples, int input_channels, int output_channels);
 void resample_audio(float *input, float *output, int input_samples, int output_samples, int channels);
+void apply_volume(float *samples, int num_samples, float volume);
+void compute_vis_bands(const float *samples, int num_samples, float *bands, int num_bands);
+
+typedef void (*ChannelKernel)(const float *input, float *output, int frames);
+typedef void (*ResampleKernel)(const float *input, float *output, int input_frames, int output_frames);
+
+// How one track's decoded audio becomes output audio, resolved once when the track opens
+// or changes format. The kernels are specialized for their exact channel counts, so the
+// decode loop makes no per-chunk format decisions; a NULL kernel means that stage is skipped.
+typedef struct {
+    long in_rate;
+    int in_channels;
+    long out_rate;
+    int out_channels;
+    bool passthrough;           // decoder output can be written straight to the ring
+    ChannelKernel remap;        // in_channels -> out_channels
+    ResampleKernel resample;    // in_rate -> out_rate, at out_channels
+    size_t max_out_samples;     // most a chunk_frames input chunk can produce
+} ConversionPlan;
+
+int conversion_plan_init(ConversionPlan *plan, long in_rate, int in_channels, long out_rate, int out_channels,
+                         size_t chunk_frames);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,49 @@
+#ifndef AUDIO_FEATURES_H
+#define AUDIO_FEATURES_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct {
+    float bass;                 // 20-250 Hz, 0..1 against a slowly decaying peak
+    float mid;                  // 250 Hz-4 kHz
+    float high;                 // 4-16 kHz
+    float centroid_hz;          // 0 in silence
+    float onset;                // strength of the latest onset, decaying until the next
+    float bpm;                  // 0 until a tempo has been found
+    float beat_phase;           // 0 on the beat, rising towards 1 just before the next
+    float beat_confidence;      // 0..1
+    uint32_t onset_count;       // increments on every detected onset
+    uint32_t beat_count;        // increments each time beat_phase wraps
+} AudioFeatures;
+
+// spectral-flux onset detector, autocorrelation tempo estimator and beat tracker fed
+// from the output path. The audio thread only mixes to mono into a lock-free ring; a
+// background thread runs the 1024-point FFT per 512-frame hop and publishes the results.
+typedef struct FeatureAnalyzer FeatureAnalyzer;
+
+// analysis_thread false leaves the work to feature_analyzer_step, which the owner should
+// call about every FEATURE_POLL_MS
+#define FEATURE_POLL_MS 10
+FeatureAnalyzer* feature_analyzer_create(bool analysis_thread);
+void feature_analyzer_destroy(FeatureAnalyzer *analyzer);
+
+// analyses everything queued so far; true if there was anything
+bool feature_analyzer_step(FeatureAnalyzer *analyzer);
+
+// audio thread; drops the block if the analysis thread has fallen behind
+void feature_analyzer_push(FeatureAnalyzer *analyzer, const float *samples, size_t frames,
+                           int channels, int sample_rate);
+
+// forgets tempo and history, e.g. on a track change
+void feature_analyzer_reset(FeatureAnalyzer *analyzer);
+
+// beat phase is extrapolated to the frame now leaving the speakers, lag_frames behind
+// the last pushed one
+void feature_analyzer_get(FeatureAnalyzer *analyzer, AudioFeatures *features, long long lag_frames);
+
+// waits until everything pushed so far has been analysed; -1 on timeout
+int feature_analyzer_drain(FeatureAnalyzer *analyzer, int timeout_ms);
+
+#endif
@@ -3,37 +3,143 @@
 
 #include "shared/common.h"
 #include "core/audio_converter.h"
+#include "core/ring_buffer.h"
+#include "core/decoder.h"
+#include "core/jack_output.h"
+#include "core/audio_stats.h"
+#include "core/dsp_chain.h"
+#include "core/audio_features.h"
+#include "core/mixer.h"
+#include "core/decoder_pool.h"
+#include "core/stream_source.h"
+#include "core/pcm_cache.h"
 #include <unistd.h>
 #include <math.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+
+typedef enum {
+    AUDIO_BACKEND_PORTAUDIO,
+    AUDIO_BACKEND_JACK
+} AudioBackendType;
+
+typedef struct {
+    AudioBackendType backend;
+    int sample_rate;
+    int frames_per_buffer;      // 0 lets the backend choose
+    int channels;
+    double latency;             // seconds, 0 uses the device's low-latency default
+    bool native_rate;           // reopen the stream at each track's rate when supported
+} AudioConfig;
+
+typedef struct {
+    AudioBackendType backend;
+    int sample_rate;
+    int frames_per_buffer;
+    int channels;
+    long source_rate;
+    bool resampling;
+    double output_latency;      // reported by the backend, seconds
+    double buffer_latency;      // decoded audio queued ahead of the device, seconds
+} AudioOutputInfo;
 
 typedef struct {
+    AudioConfig config;
+    AudioBackendType backend;
+    bool pa_initialized;        // holds a reference on the process-wide PortAudio context
     PaStream *stream;
-    mpg123_handle *mh;
+    JackOutput *jack;
+    int sample_rate;
+    int channels;
+    int frames_per_buffer;
+
+    Decoder *mp3_decoder;
+    Decoder *wav_decoder;
+    Decoder *stream_decoder;    // stdin, FIFOs and http:// sources
+    PcmCache *pcm_cache;
+    Decoder *cached_decoder;    // local files, reading through pcm_cache
+    Decoder *decoder;           // source of the loaded track, NULL when none
+    bool duration_known;        // false for streams: no total time, progress or seeking
     PlayerState state;
     float volume;
+    float track_gain;           // per-track loudness correction, applied on top of volume
+    DspChain *dsp;              // runs in the audio callback before volume
+    FeatureAnalyzer *features;  // fed from the callback after the DSP chain
+    Mixer *mixer;               // overlay voices summed onto the music after volume
     char *current_file;
     float vis_level;
     float vis_bands[32];
-    int current_position_seconds;  
-    int total_duration_seconds;   
+    int current_position_seconds;
+    int total_duration_seconds;
+
+    // decoder job on the shared pool feeding the output ring; the audio callback only reads
+    RingBuffer *ring;
+    atomic_int ring_frames;     // fill limit; the ring itself is sized for low power
+    atomic_bool low_power;      // deep ring, long periods, refills in bursts
+    DecoderPool *pool;
+    DecoderJob *decode_job;
+    DecoderJob *mixer_job;
+    DecoderJob *analysis_job;
+    pthread_mutex_t decoder_lock;
+    atomic_bool decoder_eof;
+    atomic_llong decoded_frames;
+    bool track_loaded;
+    long source_rate;
+    int source_channels;
+    ConversionPlan plan;        // rebuilt on open, format change and output reconfiguration
+    atomic_bool plan_stale;     // the output rate changed behind the decoder's back
+    int consecutive_errors;
+    long long resample_in_frames;
+    long long resample_out_frames;
+    float *decode_buffer;
+    float *convert_buffer;
+    float *resample_buffer;
+    size_t resample_capacity;
+    atomic_uint_least64_t start_requested_ns;   // by play_from, cleared by the first decoded samples
+    atomic_uint_least64_t first_sample_ns;      // how long the last start took, 0 while pending
+
+    AudioStats stats;
 } AudioPlayer;
 
 AudioPlayer* audio_player_init(void);
+AudioPlayer* audio_player_init_backend(AudioBackendType backend);
+AudioPlayer* audio_player_init_config(const AudioConfig *config);
 void audio_player_cleanup(AudioPlayer *player);
 
+void audio_config_defaults(AudioConfig *config);
+int audio_player_configure(AudioPlayer *player, const AudioConfig *config);
+void audio_player_get_output_info(AudioPlayer *player, AudioOutputInfo *info);
+// fewer wakeups for playback nobody interacts with: seconds of decode-ahead refilled in
+// bursts, long device periods where the backend takes them (JACK keeps the server's) and
+// lazily polled jobs. Switching moves the ring's fill limit and keeps the output open;
+// only a PortAudio stream whose period changes is reopened, at the position being heard.
+int audio_player_set_low_power(AudioPlayer *player, bool enabled);
+bool audio_player_is_low_power(AudioPlayer *player);
+
 int audio_player_play(AudioPlayer *player, const char *filename);
+// start_frame in the track's own rate; ignored when the track cannot seek there
+int audio_player_play_from(AudioPlayer *player, const char *filename, long long start_frame);
 void audio_player_pause(AudioPlayer *player);
 void audio_player_resume(AudioPlayer *player);
 void audio_player_stop(AudioPlayer *player);
 
 void audio_player_set_volume(AudioPlayer *player, float volume);
+void audio_player_set_track_gain(AudioPlayer *player, float gain);
 int audio_player_seek(AudioPlayer *player, float position);
 
 PlayerState audio_player_get_state(AudioPlayer *player);
 float audio_player_get_volume(AudioPlayer *player);
 int audio_player_get_current_time(AudioPlayer *player);
+// what is being heard now, in frames of the track
+long long audio_player_get_position_frames(AudioPlayer *player);
 int audio_player_get_total_time(AudioPlayer *player);
 float audio_player_get_progress(AudioPlayer *player);
 void audio_player_get_vis_data(AudioPlayer *player, float *vis_bands, int num_bands);
+void audio_player_get_features(AudioPlayer *player, AudioFeatures *features);
+unsigned long audio_player_get_xrun_count(AudioPlayer *player);
+bool audio_player_duration_known(AudioPlayer *player);
+// the last stream played, still readable after it ended
+void audio_player_get_stream_stats(AudioPlayer *player, StreamStats *stats);
 
-#endif 
\ No newline at end of file
+#endif
@@ -0,0 +1,58 @@
+#ifndef AUDIO_STATS_H
+#define AUDIO_STATS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+// log-linear buckets: values below 2*SUB_BUCKETS are exact, above that every
+// power of two is split into SUB_BUCKETS steps (~6% resolution), up to ~18 minutes
+#define LATENCY_HISTOGRAM_SUB_BITS 4
+#define LATENCY_HISTOGRAM_SUB_BUCKETS (1 << LATENCY_HISTOGRAM_SUB_BITS)
+#define LATENCY_HISTOGRAM_MAX_BITS 40
+#define LATENCY_HISTOGRAM_BUCKETS ((LATENCY_HISTOGRAM_MAX_BITS + 2 - LATENCY_HISTOGRAM_SUB_BITS) * LATENCY_HISTOGRAM_SUB_BUCKETS)
+
+// single writer, any number of readers
+typedef struct {
+    atomic_uint_fast64_t counts[LATENCY_HISTOGRAM_BUCKETS];
+    atomic_uint_fast64_t total;
+    atomic_uint_fast64_t max_ns;
+} LatencyHistogram;
+
+typedef struct {
+    LatencyHistogram callback_time;
+    LatencyHistogram decode_time;
+    atomic_uint_fast64_t callbacks;
+    atomic_uint_fast64_t underflows;
+    atomic_uint_fast64_t overflows;
+    atomic_uint_fast64_t starved_callbacks;
+    atomic_uint_fast64_t deadline_misses;
+    atomic_uint_fast64_t last_budget_ns;
+    atomic_uint_fast64_t worst_callback_ns;
+    atomic_int_fast64_t worst_callback_at_ns;
+    atomic_uint_fast64_t ring_fill_frames;
+    atomic_uint_fast64_t ring_min_fill_frames;
+    // resets are carried out by the writers themselves so no increment is lost
+    atomic_bool callback_reset_pending;
+    atomic_bool decode_reset_pending;
+} AudioStats;
+
+uint64_t audio_stats_now_ns(void);
+
+void latency_histogram_reset(LatencyHistogram *histogram);
+void latency_histogram_record(LatencyHistogram *histogram, uint64_t value_ns);
+uint64_t latency_histogram_percentile(LatencyHistogram *histogram, double percentile);
+uint64_t latency_histogram_count(LatencyHistogram *histogram);
+int latency_histogram_bucket_index(uint64_t value_ns);
+uint64_t latency_histogram_bucket_upper(int index);
+
+void audio_stats_init(AudioStats *stats);
+void audio_stats_request_reset(AudioStats *stats);
+void audio_stats_record_decode(AudioStats *stats, uint64_t elapsed_ns);
+uint64_t audio_stats_begin_callback(AudioStats *stats);
+void audio_stats_end_callback(AudioStats *stats, uint64_t start_ns, uint64_t budget_ns);
+void audio_stats_record_starved(AudioStats *stats);
+void audio_stats_record_ring_fill(AudioStats *stats, uint64_t frames);
+void audio_stats_record_status_flags(AudioStats *stats, bool underflow, bool overflow);
+
+#endif
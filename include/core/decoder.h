@@ -0,0 +1,61 @@
+#ifndef DECODER_H
+#define DECODER_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#define DECODER_MAX_CHANNELS 2
+
+typedef enum {
+    DECODER_OK,
+    DECODER_NEW_FORMAT,         // rate/channels changed, nothing was read
+    DECODER_DONE,
+    DECODER_ERROR
+} DecoderStatus;
+
+typedef struct Decoder Decoder;
+
+typedef struct {
+    const char *name;
+    int (*open)(Decoder *decoder, const char *path);
+    DecoderStatus (*read)(Decoder *decoder, float *out, size_t max_frames, size_t *frames_read);
+    int (*seek)(Decoder *decoder, long long frame);
+    void (*close)(Decoder *decoder);
+    void (*destroy)(Decoder *decoder);
+    const char *(*error_string)(Decoder *decoder);
+} DecoderOps;
+
+// implementations embed this as their first member
+struct Decoder {
+    const DecoderOps *ops;
+    long rate;
+    int channels;
+    long long length_frames;    // -1 when unknown
+};
+
+Decoder* mpg123_decoder_create(void);
+Decoder* wav_decoder_create(void);
+bool wav_decoder_probe(const char *path);
+// stdin, FIFOs and http:// URLs (see stream_source.h); MP3 through mpg123's feed API or WAV
+Decoder* stream_decoder_create(void);
+
+typedef void (*WavSampleConverter)(const unsigned char *src, float *out, size_t count);
+
+typedef struct {
+    long rate;
+    int channels;
+    int block_align;
+    WavSampleConverter convert;
+} WavFormat;
+
+// the body of a "fmt " chunk; NULL when supported, otherwise why not
+const char *wav_parse_format(const unsigned char *chunk, size_t size, WavFormat *format);
+
+int decoder_open(Decoder *decoder, const char *path);
+DecoderStatus decoder_read(Decoder *decoder, float *out, size_t max_frames, size_t *frames_read);
+int decoder_seek(Decoder *decoder, long long frame);
+void decoder_close(Decoder *decoder);
+void decoder_destroy(Decoder *decoder);
+const char* decoder_error_string(Decoder *decoder);
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef DECODER_POOL_H
+#define DECODER_POOL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define DECODER_POOL_MAX_THREADS 16
+#define DECODER_POOL_MAX_JOBS 256
+
+// A fixed set of worker threads running the background work of every player in the
+// process (track decoding, overlay decoding, feature analysis) as jobs. Each job is
+// homed on one worker, which polls it and serves it first; an idle worker steals
+// pending jobs homed elsewhere, so a burst on one engine spreads over the pool. A job
+// never runs on two workers at once.
+typedef struct DecoderPool DecoderPool;
+typedef struct DecoderJob DecoderJob;
+
+// returns true while there is more to do; false parks the job until it is woken or
+// its poll interval passes
+typedef bool (*DecoderJobStep)(void *context);
+
+typedef struct {
+    int threads;
+    int jobs;
+    uint64_t steps;             // step calls that did work
+    uint64_t steals;            // jobs run by a worker other than their home
+    uint64_t wakeups;           // times a worker left its wait
+} DecoderPoolStats;
+
+// threads <= 0 picks one per CPU, at most four
+DecoderPool *decoder_pool_create(int threads);
+void decoder_pool_destroy(DecoderPool *pool);
+
+DecoderJob *decoder_pool_add(DecoderPool *pool, DecoderJobStep step, void *context, int poll_ms);
+// returns once the job is not running and will not run again
+void decoder_pool_remove(DecoderPool *pool, DecoderJob *job);
+
+// lock-free and allocation-free, so the audio callback can ask for a refill
+void decoder_pool_wake(DecoderJob *job);
+// changes how often an idle job is polled; low-power playback stretches it to cut wakeups
+void decoder_pool_set_poll(DecoderJob *job, int poll_ms);
+
+void decoder_pool_get_stats(DecoderPool *pool, DecoderPoolStats *stats);
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef DSP_CHAIN_H
+#define DSP_CHAIN_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#define DSP_MAX_STAGES 16
+#define DSP_MAX_CHANNELS 4
+
+typedef enum {
+    DSP_STAGE_PREAMP,
+    DSP_STAGE_PEAKING,
+    DSP_STAGE_LOW_SHELF,
+    DSP_STAGE_HIGH_SHELF
+} DspStageType;
+
+typedef struct {
+    DspStageType type;
+    float frequency;            // Hz, ignored by the preamp
+    float gain_db;
+    float q;                    // bandwidth for peaking stages, slope for shelves
+    bool enabled;
+} DspStageParams;
+
+// ordered in-place processors on the output path. Stages are biquads in transposed
+// direct form II, vectorised across channels. Parameters are published by the control
+// thread through a per-stage sequence counter; the audio thread picks them up at the next
+// block without locking and glides the coefficients towards them to avoid zipper noise.
+typedef struct DspChain DspChain;
+
+DspChain* dsp_chain_create(void);
+void dsp_chain_destroy(DspChain *chain);
+
+// control thread
+int dsp_chain_add_stage(DspChain *chain, const DspStageParams *params);
+int dsp_chain_set_stage(DspChain *chain, int index, const DspStageParams *params);
+int dsp_chain_get_stage(DspChain *chain, int index, DspStageParams *params);
+int dsp_chain_stage_count(DspChain *chain);
+void dsp_chain_set_enabled(DspChain *chain, bool enabled);
+bool dsp_chain_is_enabled(DspChain *chain);
+
+// audio thread; coefficients are redesigned whenever sample_rate changes
+void dsp_chain_process(DspChain *chain, float *samples, size_t frames, int channels, int sample_rate);
+
+#endif
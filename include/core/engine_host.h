@@ -0,0 +1,23 @@
+#ifndef ENGINE_HOST_H
+#define ENGINE_HOST_H
+
+#include "core/rhythm_engine.h"
+
+// Serves one engine to another process through a shared-memory segment (see
+// shared/engine_shm.h). A host thread owns the engine from then on: it runs queued
+// commands, refreshes the status frame and publishes it, so clients never touch the
+// engine or its audio stream directly.
+typedef struct EngineHost EngineHost;
+
+// name is the POSIX shm name, NULL for /rhythm-engine-<pid>. The engine must not be
+// used by other threads until the host is destroyed.
+EngineHost* engine_host_create(RhythmEngine* engine, const char* name);
+// stops the thread and unlinks the segment; the engine is left to the caller
+void engine_host_destroy(EngineHost* host);
+
+const char* engine_host_name(EngineHost* host);
+
+// runs one EngineCommandType against the engine; shared with the socket daemon
+RhythmError engine_host_run_command(RhythmEngine* engine, int type, int index, float value, const char* path);
+
+#endif
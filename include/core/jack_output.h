@@ -0,0 +1,34 @@
+#ifndef JACK_OUTPUT_H
+#define JACK_OUTPUT_H
+
+#include <stdbool.h>
+#include <jack/jack.h>
+
+#define JACK_MAX_PERIOD_FRAMES 8192
+
+typedef struct JackOutput JackOutput;
+
+// fills an interleaved block; runs on the JACK process thread
+typedef void (*JackRenderCallback)(float *interleaved, unsigned long frames, void *user_data);
+// sample rate or period size changed on the server
+typedef void (*JackFormatCallback)(int sample_rate, int period_frames, void *user_data);
+
+JackOutput* jack_output_create(const char *client_name, int channels,
+                               JackRenderCallback render, JackFormatCallback format_changed,
+                               void *user_data);
+void jack_output_destroy(JackOutput *output);
+
+int jack_output_start(JackOutput *output);
+void jack_output_stop(JackOutput *output);
+
+int jack_output_get_sample_rate(JackOutput *output);
+int jack_output_get_period_frames(JackOutput *output);
+unsigned long jack_output_get_xrun_count(JackOutput *output);
+double jack_output_get_latency(JackOutput *output);
+
+void jack_output_set_follow_transport(JackOutput *output, bool follow);
+bool jack_output_transport_rolling(JackOutput *output);
+void jack_output_transport_start(JackOutput *output);
+void jack_output_transport_stop(JackOutput *output);
+
+#endif
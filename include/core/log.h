@@ -0,0 +1,131 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+// Structured logging that is safe from the audio and decoder threads. LOG_* stores a
+// fixed-size record (the format pointer, up to LOG_MAX_ARGS typed arguments and a copy
+// of any strings) in the calling thread's own lock-free ring and returns; nothing is
+// formatted, locked or allocated there. A background thread merges the rings in time
+// order, formats the records and hands them to stderr, a file or a callback. Each call
+// site passes at most LOG_RATE_BURST records per second; the rest are counted and the
+// next record that gets through says how many were suppressed. Process-wide.
+
+#define LOG_MAX_THREADS 64
+#define LOG_RING_RECORDS 128            // per thread, power of two
+#define LOG_MAX_ARGS 6
+#define LOG_TEXT_BYTES 128              // string arguments of one record, truncated past it
+#define LOG_MESSAGE_MAX 512
+#define LOG_RATE_BURST 10
+
+typedef enum {
+    LOG_LEVEL_DEBUG,
+    LOG_LEVEL_INFO,
+    LOG_LEVEL_WARN,
+    LOG_LEVEL_ERROR,
+    LOG_LEVELS
+} LogLevel;
+
+// message is formatted, without a trailing newline; called from the drain thread
+typedef void (*LogCallback)(LogLevel level, const char *message, void *user_data);
+
+typedef struct {
+    uint64_t written;           // records that reached the sink
+    uint64_t dropped;           // lost to a full ring or to more than LOG_MAX_THREADS threads
+    uint64_t suppressed;        // held back by the per-site rate limit
+} LogStats;
+
+typedef enum {
+    LOG_ARG_INT,
+    LOG_ARG_UINT,
+    LOG_ARG_DOUBLE,
+    LOG_ARG_STRING,
+    LOG_ARG_POINTER
+} LogArgType;
+
+typedef struct {
+    LogArgType type;
+    union {
+        int64_t i;
+        uint64_t u;
+        double d;
+        const char *s;
+        const void *p;
+    } value;
+} LogArg;
+
+// one per call site, created by the macros
+typedef struct {
+    const char *file;
+    int line;
+    atomic_uint_least64_t window_start_ns;
+    atomic_uint count;
+    atomic_uint suppressed;
+} LogSite;
+
+// starts the drain thread; the first record does it too. RHYTHM_LOG_LEVEL (debug, info,
+// warn, error) sets the level, default info, and RHYTHM_LOG_FILE appends to a file.
+void log_init(void);
+void log_set_level(LogLevel level);
+LogLevel log_get_level(void);
+// NULL goes back to stderr; -1 if the file cannot be opened
+int log_set_file(const char *path);
+// replaces the stream sink while set; NULL removes it
+void log_set_callback(LogCallback callback, void *user_data);
+// delivers everything logged so far before returning; not for the audio thread
+void log_flush(void);
+void log_get_stats(LogStats *stats);
+const char *log_level_name(LogLevel level);
+
+// format takes printf conversions; length modifiers are ignored, the argument's own
+// type decides. The format must be a string literal: only its address is kept.
+void log_write(LogSite *site, LogLevel level, const char *format, int count, const LogArg *args);
+
+static inline LogArg log_arg_int(long long value) { return (LogArg){ LOG_ARG_INT, { .i = value } }; }
+static inline LogArg log_arg_uint(unsigned long long value) { return (LogArg){ LOG_ARG_UINT, { .u = value } }; }
+static inline LogArg log_arg_double(double value) { return (LogArg){ LOG_ARG_DOUBLE, { .d = value } }; }
+static inline LogArg log_arg_string(const char *value) { return (LogArg){ LOG_ARG_STRING, { .s = value } }; }
+static inline LogArg log_arg_pointer(const void *value) { return (LogArg){ LOG_ARG_POINTER, { .p = value } }; }
+
+#define LOG_ARG(x) _Generic((x), \
+    _Bool: log_arg_int, char: log_arg_int, signed char: log_arg_int, short: log_arg_int, \
+    int: log_arg_int, long: log_arg_int, long long: log_arg_int, \
+    unsigned char: log_arg_uint, unsigned short: log_arg_uint, unsigned int: log_arg_uint, \
+    unsigned long: log_arg_uint, unsigned long long: log_arg_uint, \
+    float: log_arg_double, double: log_arg_double, \
+    char *: log_arg_string, const char *: log_arg_string, \
+    default: log_arg_pointer)(x)
+
+#define LOG_CONCAT_(a, b) a##b
+#define LOG_CONCAT(a, b) LOG_CONCAT_(a, b)
+#define LOG_COUNT_(format, a1, a2, a3, a4, a5, a6, n, ...) n
+#define LOG_COUNT(...) LOG_COUNT_(__VA_ARGS__, 6, 5, 4, 3, 2, 1, 0, _)
+
+#define LOG_CALL_0(s, l, f) log_write(s, l, f, 0, 0)
+#define LOG_CALL_1(s, l, f, a) log_write(s, l, f, 1, (LogArg[]){ LOG_ARG(a) })
+#define LOG_CALL_2(s, l, f, a, b) log_write(s, l, f, 2, (LogArg[]){ LOG_ARG(a), LOG_ARG(b) })
+#define LOG_CALL_3(s, l, f, a, b, c) log_write(s, l, f, 3, (LogArg[]){ LOG_ARG(a), LOG_ARG(b), LOG_ARG(c) })
+#define LOG_CALL_4(s, l, f, a, b, c, d) \
+    log_write(s, l, f, 4, (LogArg[]){ LOG_ARG(a), LOG_ARG(b), LOG_ARG(c), LOG_ARG(d) })
+#define LOG_CALL_5(s, l, f, a, b, c, d, e) \
+    log_write(s, l, f, 5, (LogArg[]){ LOG_ARG(a), LOG_ARG(b), LOG_ARG(c), LOG_ARG(d), LOG_ARG(e) })
+#define LOG_CALL_6(s, l, f, a, b, c, d, e, g) \
+    log_write(s, l, f, 6, (LogArg[]){ LOG_ARG(a), LOG_ARG(b), LOG_ARG(c), LOG_ARG(d), LOG_ARG(e), LOG_ARG(g) })
+
+#define LOG_AT(level, ...) \
+    do { \
+        static LogSite log_site_ = { __FILE__, __LINE__, 0, 0, 0 }; \
+        LOG_CONCAT(LOG_CALL_, LOG_COUNT(__VA_ARGS__))(&log_site_, level, __VA_ARGS__); \
+    } while (0)
+
+// not rate limited, for bounded listings such as the device list
+#define LOG_ALWAYS(level, ...) LOG_CONCAT(LOG_CALL_, LOG_COUNT(__VA_ARGS__))(0, level, __VA_ARGS__)
+
+#define LOG_DEBUG(...) LOG_AT(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#define LOG_INFO(...) LOG_AT(LOG_LEVEL_INFO, __VA_ARGS__)
+#define LOG_WARN(...) LOG_AT(LOG_LEVEL_WARN, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_AT(LOG_LEVEL_ERROR, __VA_ARGS__)
+
+#endif
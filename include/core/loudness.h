@@ -0,0 +1,29 @@
+#ifndef LOUDNESS_H
+#define LOUDNESS_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+// ITU-R BS.1770-4 / EBU R128 loudness measurement
+#define LOUDNESS_ABSOLUTE_GATE -70.0
+#define LOUDNESS_SILENCE -70.0f      // integrated value reported when every block is gated out
+#define LOUDNESS_REFERENCE_LUFS -18.0f
+
+typedef struct {
+    float integrated_lufs;
+    float loudness_range;       // LU, EBU Tech 3342
+    float true_peak_dbtp;       // 4x oversampled
+} LoudnessResult;
+
+typedef struct LoudnessMeter LoudnessMeter;
+
+LoudnessMeter* loudness_meter_create(long sample_rate, int channels);
+void loudness_meter_destroy(LoudnessMeter *meter);
+
+int loudness_meter_add_frames(LoudnessMeter *meter, const float *interleaved, size_t frames);
+void loudness_meter_get_result(LoudnessMeter *meter, LoudnessResult *result);
+
+// gain in dB that brings the track to target_lufs without pushing true peak above -1 dBTP
+float loudness_track_gain_db(const LoudnessResult *result, float target_lufs);
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef LOUDNESS_CACHE_H
+#define LOUDNESS_CACHE_H
+
+#include "core/loudness.h"
+#include <sys/stat.h>
+
+// persistent loudness results keyed by file identity (device, inode, size, mtime);
+// entries are appended as they are measured so an interrupted scan resumes where it stopped
+typedef struct LoudnessCache LoudnessCache;
+
+LoudnessCache* loudness_cache_open(const char *path);
+void loudness_cache_close(LoudnessCache *cache);
+
+// $RHYTHM_LOUDNESS_CACHE, else $XDG_CACHE_HOME/rhythm/loudness.cache, else ~/.cache/rhythm/loudness.cache
+int loudness_cache_default_path(char *buffer, size_t size);
+
+int loudness_cache_lookup(LoudnessCache *cache, const char *path, LoudnessResult *result);
+int loudness_cache_lookup_stat(LoudnessCache *cache, const struct stat *st, LoudnessResult *result);
+int loudness_cache_store(LoudnessCache *cache, const char *path, const struct stat *st, const LoudnessResult *result);
+size_t loudness_cache_count(LoudnessCache *cache);
+
+#endif
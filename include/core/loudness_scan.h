@@ -0,0 +1,31 @@
+#ifndef LOUDNESS_SCAN_H
+#define LOUDNESS_SCAN_H
+
+#include "core/loudness_cache.h"
+#include "core/decoder.h"
+#include <stdbool.h>
+#include <stdatomic.h>
+
+// background analysis of a file list; every worker owns its own decoders,
+// so throughput scales with cores until the disk becomes the limit
+typedef struct LoudnessScan LoudnessScan;
+
+typedef struct {
+    int total;
+    int analysed;
+    int cached;             // already in the cache, skipped
+    int failed;
+    bool finished;
+} LoudnessScanProgress;
+
+LoudnessScan* loudness_scan_start(LoudnessCache *cache, const char *const *files, int count, int threads);
+void loudness_scan_get_progress(LoudnessScan *scan, LoudnessScanProgress *progress);
+void loudness_scan_cancel(LoudnessScan *scan);
+// cancels if still running and waits for the workers
+void loudness_scan_destroy(LoudnessScan *scan);
+
+// decodes a whole file through the meter; returns -1 on decode failure or cancellation
+int loudness_analyse_file(Decoder *decoder, const char *path, float *buffer, size_t buffer_frames,
+                          LoudnessResult *result, const atomic_bool *cancel);
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef MIXER_H
+#define MIXER_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define MIXER_MAX_VOICES 64
+
+// Sums up to MIXER_MAX_VOICES decoded sources on top of an output bus. Each voice has
+// its own decoder and SPSC ring, filled by one decoder thread or pool job for all voices, so
+// the audio thread only reads rings and accumulates. Voices are claimed and configured
+// on the control thread; gain/pan changes are published through a per-voice sequence
+// counter and glide over one block, and voices fade in on start and out on stop, so
+// nothing on the audio thread locks, allocates or clicks.
+typedef struct Mixer Mixer;
+
+typedef struct {
+    float gain;                 // linear
+    float pan;                  // -1 left .. 1 right, far side on a cosine law; ignored for mono
+    bool duck;                  // announcement: lowers the bus while it plays
+    bool loop;                  // restart at the end instead of finishing
+} MixerVoiceParams;
+
+typedef struct {
+    int active;                 // voices claimed and not yet finished
+    uint64_t started;
+    uint64_t finished;
+    uint64_t starved_blocks;    // blocks where a voice's ring ran dry before its end
+    float duck_gain;            // current bus gain from ducking
+} MixerStats;
+
+// decode_thread false leaves decoding to mixer_decode (benchmarks, offline rendering)
+Mixer *mixer_create(bool decode_thread);
+void mixer_destroy(Mixer *mixer);
+
+// control thread. Voice ids carry a generation, so a stale id never reaches a reused slot.
+void mixer_set_format(Mixer *mixer, int sample_rate, int channels);
+int mixer_play(Mixer *mixer, const char *path, const MixerVoiceParams *params);
+int mixer_set_voice(Mixer *mixer, int voice, const MixerVoiceParams *params);
+int mixer_stop(Mixer *mixer, int voice);
+bool mixer_voice_active(Mixer *mixer, int voice);
+// bus attenuation while announcements play, and how fast it moves
+void mixer_set_ducking(Mixer *mixer, float duck_db, float attack_ms, float release_ms);
+void mixer_get_stats(Mixer *mixer, MixerStats *stats);
+
+// one decode pass over every voice that has ring space; true if anything was decoded
+bool mixer_decode(Mixer *mixer);
+// lock-free, for the audio thread: false while there is nothing for mixer_decode to do
+bool mixer_has_voices(Mixer *mixer);
+
+// audio thread: ducks the bus and adds every voice scaled by master
+void mixer_render(Mixer *mixer, float *bus, size_t frames, int channels, int sample_rate, float master);
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef PCM_CACHE_H
+#define PCM_CACHE_H
+
+#include "core/decoder.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define PCM_CACHE_SEGMENT_FRAMES 65536
+#define PCM_CACHE_DEFAULT_BUDGET (64 * 1024 * 1024)
+
+// Decoded PCM of local files in PCM_CACHE_SEGMENT_FRAMES segments, keyed by the file's
+// device, inode, size and mtime and by the segment's frame range, so an edited file is
+// decoded afresh. The least recently used segments are evicted to stay within a byte
+// budget. Segments are float, or 16-bit when packed, at half the memory. Only decoder
+// threads use it; the audio callback reads the player's ring and never waits on it.
+typedef struct PcmCache PcmCache;
+
+typedef struct {
+    uint64_t hits;              // segments served from memory
+    uint64_t misses;            // segments decoded from the file
+    uint64_t evictions;
+    size_t bytes;
+    size_t budget;
+    int segments;
+    bool packed;
+} PcmCacheStats;
+
+// budget 0 keeps nothing
+PcmCache* pcm_cache_create(size_t budget_bytes, bool pack16);
+// after every decoder reading through it
+void pcm_cache_destroy(PcmCache *cache);
+// evicts down to a smaller budget; switching packing empties the cache
+void pcm_cache_configure(PcmCache *cache, size_t budget_bytes, bool pack16);
+void pcm_cache_clear(PcmCache *cache);
+void pcm_cache_get_stats(PcmCache *cache, PcmCacheStats *stats);
+
+// A decoder for local files that serves segments from the cache and decodes the rest
+// with its source decoder. The source is opened with the file, so a miss never opens it
+// on the decode path. Files whose format changes mid-way pass straight through. The
+// source is not owned.
+Decoder* pcm_cache_decoder_create(PcmCache *cache);
+// the decoder for the next open; set it before decoder_open
+void pcm_cache_decoder_set_source(Decoder *decoder, Decoder *source);
+
+#endif
@@ -13,6 +13,10 @@ typedef struct {
     int count;
     int current_index;
     int capacity;
+    int *order;                 // shuffled play order, NULL when playing in sequence
+    int order_position;         // where current_index sits in order
+    void *mapping;              // adopted read-only mapping some files point into
+    size_t mapping_size;
 } Playlist;
 
 Playlist* playlist_create(void);
@@ -20,14 +24,31 @@ void playlist_destroy(Playlist *playlist);
 void playlist_clear(Playlist *playlist);
 
 int playlist_add_file(Playlist *playlist, const char *filename);
+int playlist_reserve(Playlist *playlist, int capacity);
+// the playlist takes over a mapping: entries added with playlist_add_mapped point into
+// it instead of being copied, and it is unmapped when the playlist is cleared
+void playlist_adopt_mapping(Playlist *playlist, void *mapping, size_t size);
+int playlist_add_mapped(Playlist *playlist, const char *filename);
 int playlist_add_directory(Playlist *playlist, const char *directory);
 int is_mp3_file(const char *filename);
+int is_wav_file(const char *filename);
+int is_audio_file(const char *filename);
 
 const char* playlist_get_current(Playlist *playlist);
 int playlist_next(Playlist *playlist);
 int playlist_previous(Playlist *playlist);
 int playlist_set_current(Playlist *playlist, int index);
 
+// next and previous follow a random order starting at the current track; entries added
+// while shuffled play after the rest
+int playlist_set_shuffle(Playlist *playlist, bool enabled, unsigned int seed);
+bool playlist_is_shuffled(Playlist *playlist);
+// a permutation of every index, e.g. a saved order; rejected unless it is one
+int playlist_set_order(Playlist *playlist, const int *order, int position);
+// the next max entries playlist_next would visit, wrapping around but never back to the
+// current one; returns how many were written
+int playlist_get_upcoming(Playlist *playlist, int *indices, int max);
+
 void playlist_get_info(Playlist *playlist, int *current, int *total);
 int playlist_get_count(Playlist *playlist);
 int playlist_get_current_index(Playlist *playlist);
@@ -0,0 +1,43 @@
+#ifndef PLAYLIST_VIEW_H
+#define PLAYLIST_VIEW_H
+
+#include "core/playlist.h"
+#include <stdint.h>
+
+#define PLAYLIST_VIEW_QUERY_MAX 64
+
+// Scroll window and type-ahead filter over a playlist for text browsers. Only the rows
+// in the window are ever resolved, so drawing costs O(rows) whatever the playlist size.
+// Filtering is incremental: a character typed onto the query narrows the previous
+// matches instead of rescanning, and scans run in time-bounded steps between frames,
+// so no keystroke stalls the UI; matches found so far can be browsed while the rest
+// of the playlist is scanned.
+typedef struct PlaylistView PlaylistView;
+
+PlaylistView *playlist_view_create(void);
+void playlist_view_destroy(PlaylistView *view);
+
+// once per frame before reading rows; starts over when the playlist was replaced or resized
+void playlist_view_sync(PlaylistView *view, Playlist *playlist, int rows);
+// scans for at most budget_ns; true while matches are still being looked for
+bool playlist_view_step(PlaylistView *view, Playlist *playlist, uint64_t budget_ns);
+
+// case-insensitive substring of the file name; "" shows everything
+void playlist_view_set_query(PlaylistView *view, const char *query);
+const char *playlist_view_query(PlaylistView *view);
+bool playlist_view_scanning(PlaylistView *view);
+// share of the playlist already checked against the query, 0..1
+float playlist_view_scan_progress(PlaylistView *view);
+
+int playlist_view_count(PlaylistView *view);        // entries shown, matches so far when filtering
+int playlist_view_top(PlaylistView *view);          // first position in the window
+int playlist_view_cursor(PlaylistView *view);
+// playlist index shown at a position, -1 outside the view
+int playlist_view_index_at(PlaylistView *view, int position);
+
+// moves the cursor, scrolling the window just enough to keep it visible
+void playlist_view_move(PlaylistView *view, int delta);
+// puts the cursor on a playlist index, clearing a filter; the window centres on it
+void playlist_view_jump(PlaylistView *view, int index);
+
+#endif
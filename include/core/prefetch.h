@@ -0,0 +1,46 @@
+#ifndef PREFETCH_H
+#define PREFETCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define PREFETCH_DEFAULT_TRACKS 2
+#define PREFETCH_DEFAULT_BUDGET (64 * 1024 * 1024)
+#define PREFETCH_MAX_TRACKS 16
+#define PREFETCH_CHUNK_BYTES (1024 * 1024)
+
+// Warms the page cache with the files about to be played, so opening and scanning the
+// next track does not wait on a cold disk or NFS. A background thread reads the queued
+// files ahead in PREFETCH_CHUNK_BYTES steps with readahead(2), falling back to
+// posix_fadvise(WILLNEED), until the byte budget for the whole queue is spent. Scheduling
+// a different queue cancels the current one between chunks. Nothing is evicted.
+typedef struct Prefetcher Prefetcher;
+
+typedef struct {
+    uint64_t scheduled;         // files queued for warming
+    uint64_t warmed;            // files read ahead up to their share of the budget
+    uint64_t cancelled;         // dropped half way or unread because the order changed
+    uint64_t bytes;             // asked to be read ahead, whether already cached or not
+    uint64_t hits;              // tracks whose data was cached when they started
+    uint64_t misses;
+} PrefetchStats;
+
+// budget_bytes covers the whole queue; the thread starts with the first schedule
+Prefetcher* prefetch_create(size_t budget_bytes);
+// cancels what is in flight and waits for the thread
+void prefetch_destroy(Prefetcher *prefetcher);
+
+void prefetch_set_budget(Prefetcher *prefetcher, size_t budget_bytes);
+// replaces the queue with paths, nearest first; the same queue again is left running
+int prefetch_schedule(Prefetcher *prefetcher, const char *const *paths, int count);
+void prefetch_cancel(Prefetcher *prefetcher);
+
+// counts a hit when the part of path the budget covers is resident, checked with
+// mincore(2); call it before the track is opened
+bool prefetch_note_start(Prefetcher *prefetcher, const char *path);
+void prefetch_get_stats(Prefetcher *prefetcher, PrefetchStats *stats);
+// true once the queue is done or cancelled
+bool prefetch_is_idle(Prefetcher *prefetcher);
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef REALTIME_H
+#define REALTIME_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define REALTIME_MAX_THREADS 64
+#define REALTIME_MAX_BUFFERS 64
+
+// Opt-in real-time profile for the threads that keep the device fed. Audio threads (the
+// PortAudio callback or JACK process thread) and decoder threads register themselves;
+// with the profile enabled each is moved to SCHED_FIFO, directly when the process is
+// allowed to, else through rtkit's D-Bus service, else to a raised nice level, and
+// pinned to its role's CPUs. Memory is locked with mlockall when the memlock limit
+// allows all of it; otherwise the registered sample rings are locked one by one, or at
+// least prefaulted when even that is refused. Process-wide, like the audio context.
+typedef enum {
+    REALTIME_ROLE_AUDIO,
+    REALTIME_ROLE_DECODER,
+    REALTIME_ROLES
+} RealtimeRole;
+
+// ordered from no guarantee to the strongest
+typedef enum {
+    REALTIME_METHOD_NONE,
+    REALTIME_METHOD_NICE,       // SCHED_OTHER at a raised priority
+    REALTIME_METHOD_RTKIT,      // SCHED_FIFO granted by rtkit, capped at its maximum
+    REALTIME_METHOD_FIFO        // SCHED_FIFO set directly
+} RealtimeMethod;
+
+typedef struct {
+    bool enabled;
+    int priority[REALTIME_ROLES];   // SCHED_FIFO 1-99; decoders should stay below audio
+    bool lock_memory;
+    uint64_t cpus[REALTIME_ROLES];  // CPU n in bit n; 0 leaves the role unpinned
+} RealtimeConfig;
+
+typedef struct {
+    int threads;                // registered and still running
+    int promoted;               // of those, running with some guarantee
+    RealtimeMethod method;      // the weakest any of them got
+    int priority;               // the lowest SCHED_FIFO priority granted, 0 if none
+    int pinned;                 // threads held to the role's CPUs
+} RealtimeRoleStatus;
+
+typedef struct {
+    bool enabled;
+    RealtimeRoleStatus roles[REALTIME_ROLES];
+    bool memory_locked;         // mlockall: everything, now and later
+    size_t buffers_locked;      // otherwise, bytes of sample rings locked one by one
+    size_t buffers_prefaulted;  // and bytes only faulted in, past the memlock limit
+} RealtimeStatus;
+
+// disabled; audio at 70 and decoders at 60, memory locked, nothing pinned
+void realtime_config_defaults(RealtimeConfig *config);
+// RHYTHM_REALTIME=1 enables it; RHYTHM_RT_PRIORITY sets the audio priority (decoders
+// run ten below), RHYTHM_RT_AUDIO_CPUS and RHYTHM_RT_DECODER_CPUS pin ("2", "0-1,3")
+// and RHYTHM_RT_NO_MLOCK=1 leaves memory pageable
+void realtime_config_from_env(RealtimeConfig *config);
+// "0-2,5" style lists; -1 on syntax errors or CPUs past 63
+int realtime_parse_cpus(const char *list, uint64_t *mask);
+
+// applies to threads and buffers registered so far and to later ones; enabling again
+// with another config re-applies it. Returns -1 only for an invalid config: what could
+// not be obtained shows in the status, not as an error.
+int realtime_enable(const RealtimeConfig *config);
+// back to SCHED_OTHER, all CPUs and pageable memory
+void realtime_disable(void);
+
+// Called by the thread itself, as often as convenient: after the first call it is one
+// thread-local check. It never blocks or allocates, so the audio callback calls it on
+// every period; the thread changes on the next realtime_apply().
+void realtime_register_thread(RealtimeRole role);
+// promotes threads registered since the last call and forgets exited ones; may wait
+// for a D-Bus round trip, so never from an audio thread
+void realtime_apply(void);
+
+void realtime_register_buffer(void *data, size_t size);
+void realtime_unregister_buffer(void *data);
+
+void realtime_get_status(RealtimeStatus *status);
+const char *realtime_method_name(RealtimeMethod method);
+
+#endif
@@ -4,6 +4,12 @@
 #include "shared/common.h"
 #include "core/audio_player.h"
 #include "core/playlist.h"
+#include "core/loudness.h"
+#include "core/waveform.h"
+#include "core/search_index.h"
+#include "core/realtime.h"
+#include "core/log.h"
+#include "core/prefetch.h"
 
 typedef struct RhythmEngine RhythmEngine;
 
@@ -18,6 +24,9 @@ typedef enum {
     RHYTHM_ERROR_INVALID_STATE = -7
 } RhythmError;
 
+// onset, tempo and band energy frame published next to vis_bands
+typedef AudioFeatures RhythmFeatures;
+
 typedef struct {
     char* current_file;          
     int current_track;           
@@ -25,14 +34,234 @@ typedef struct {
     float progress;              
     int current_time;           
     int total_time;             
+    bool duration_known;        // false for live streams: total_time and progress stay 0
     PlayerState state;           
     float volume;                
     float vis_bands[32];         
+    RhythmFeatures features;
+    bool shuffle;
 } RhythmStatus;
 
+#define RHYTHM_FILE_NAME_MAX 256
+
+// status written into caller-owned memory in one call; nothing in it is allocated,
+// so a binding can keep one frame alive and read it in place every tick
+typedef struct {
+    uint32_t sequence;          // bumped on every fill
+    uint32_t file_sequence;     // bumped when file_name changes
+    char file_name[RHYTHM_FILE_NAME_MAX];
+    RhythmStatus status;        // status.current_file is always NULL, use file_name
+} RhythmStatusFrame;
+
+typedef struct {
+    AudioBackendType backend;
+    int sample_rate;
+    int frames_per_buffer;
+    int channels;
+    float latency_ms;
+    bool native_rate;
+} RhythmAudioConfig;
+
+typedef struct {
+    AudioBackendType backend;
+    int sample_rate;
+    int frames_per_buffer;
+    int channels;
+    int source_rate;
+    bool resampling;
+    float output_latency_ms;
+    float buffer_latency_ms;
+} RhythmAudioInfo;
+
+typedef struct {
+    uint64_t callbacks;
+    uint64_t underflows;            // reported by the device (PortAudio flags, JACK xruns)
+    uint64_t overflows;
+    uint64_t starved_callbacks;     // decoder fell behind and the period was padded with silence
+    uint64_t deadline_misses;       // callback ran longer than its period
+    float callback_budget_us;
+    float callback_p50_us;
+    float callback_p99_us;
+    float callback_p999_us;
+    float callback_max_us;
+    float decode_p50_us;
+    float decode_p99_us;
+    float decode_max_us;
+    float ring_fill_ms;
+    float ring_min_fill_ms;
+    float ring_capacity_ms;
+    float worst_callback_us;
+    double worst_callback_time;     // unix time, 0 if no callback ran yet
+} RhythmStats;
+
+typedef struct {
+    int total_tracks;
+    int analysed;
+    int cached;                     // skipped, already measured
+    int failed;
+    bool running;
+} RhythmLoudnessScanStatus;
+
+typedef WaveformBucket RhythmWaveformBucket;
+
+typedef MixerVoiceParams RhythmOverlayParams;
+typedef MixerStats RhythmOverlayStats;
+
+typedef StreamStats RhythmStreamStats;
+typedef SearchIndexStats RhythmSearchStats;
+typedef RealtimeConfig RhythmRealtimeConfig;
+typedef RealtimeStatus RhythmRealtimeStatus;
+typedef LogLevel RhythmLogLevel;
+typedef LogCallback RhythmLogCallback;
+typedef LogStats RhythmLogStats;
+typedef PcmCacheStats RhythmPcmCacheStats;
+
+typedef struct {
+    uint64_t scheduled;             // files queued for read-ahead
+    uint64_t warmed;
+    uint64_t cancelled;             // dropped because the play order changed
+    uint64_t bytes;                 // asked to be read ahead, cached or not
+    uint64_t hits;                  // tracks that started with their data in the page cache
+    uint64_t misses;
+    float hit_rate;                 // hits / starts, 0 before the first
+    bool idle;                      // nothing queued or being read
+    float first_sample_ms;          // last start, from play to the first decoded sample; 0 while pending
+    float first_sample_hit_ms;      // average over starts that hit the cache
+    float first_sample_miss_ms;     // and over those that missed
+} RhythmPrefetchStats;
+
+#define RHYTHM_EQ_BANDS 10
+#define RHYTHM_SESSION_INTERVAL_MS 10000
+#define RHYTHM_TICK_MS 100
+#define RHYTHM_LOW_POWER_TICK_MS 1000
+
+typedef enum {
+    RHYTHM_POWER_AUTO,          // low power while no front-end reports an interactive user
+    RHYTHM_POWER_NORMAL,
+    RHYTHM_POWER_LOW
+} RhythmPowerMode;
+
+typedef struct {
+    bool enabled;
+    float preamp_db;
+    float band_frequency[RHYTHM_EQ_BANDS];
+    float band_gain_db[RHYTHM_EQ_BANDS];
+} RhythmEqualizer;
+
+typedef struct {
+    bool measured;                  // false until the track has been scanned
+    float integrated_lufs;
+    float loudness_range;
+    float true_peak_dbtp;
+    float applied_gain_db;
+} RhythmTrackLoudness;
+
 RhythmEngine* rhythm_engine_create(void);
+RhythmEngine* rhythm_engine_create_with_config(const RhythmAudioConfig* config);
 void rhythm_engine_destroy(RhythmEngine* engine);
 
+void rhythm_engine_default_audio_config(RhythmAudioConfig* config);
+RhythmError rhythm_engine_configure_audio(RhythmEngine* engine, const RhythmAudioConfig* config);
+RhythmError rhythm_engine_get_audio_info(RhythmEngine* engine, RhythmAudioInfo* info);
+RhythmError rhythm_engine_get_stats(RhythmEngine* engine, RhythmStats* stats);
+RhythmError rhythm_engine_reset_stats(RhythmEngine* engine);
+RhythmError rhythm_engine_flush_trace(RhythmEngine* engine, const char* path);
+
+RhythmError rhythm_engine_start_loudness_scan(RhythmEngine* engine, int threads);
+RhythmError rhythm_engine_get_loudness_scan_status(RhythmEngine* engine, RhythmLoudnessScanStatus* status);
+RhythmError rhythm_engine_cancel_loudness_scan(RhythmEngine* engine);
+RhythmError rhythm_engine_set_auto_gain(RhythmEngine* engine, bool enabled, float target_lufs);
+RhythmError rhythm_engine_get_track_loudness(RhythmEngine* engine, RhythmTrackLoudness* loudness);
+
+// gains are clamped to +-24 dB; changes glide in over a few milliseconds
+RhythmError rhythm_engine_set_eq_enabled(RhythmEngine* engine, bool enabled);
+RhythmError rhythm_engine_set_eq_band(RhythmEngine* engine, int band, float gain_db);
+RhythmError rhythm_engine_set_eq_preamp(RhythmEngine* engine, float gain_db);
+RhythmError rhythm_engine_get_eq(RhythmEngine* engine, RhythmEqualizer* eq);
+
+// overlays (announcements, stingers) are decoded next to the music and summed after the
+// volume stage while the output stream runs; voice ids stay valid until the voice ends
+RhythmError rhythm_engine_play_overlay(RhythmEngine* engine, const char* path,
+                                       const RhythmOverlayParams* params, int* voice);
+RhythmError rhythm_engine_set_overlay(RhythmEngine* engine, int voice, const RhythmOverlayParams* params);
+RhythmError rhythm_engine_stop_overlay(RhythmEngine* engine, int voice);
+RhythmError rhythm_engine_set_ducking(RhythmEngine* engine, float duck_db, float attack_ms, float release_ms);
+RhythmError rhythm_engine_get_overlay_stats(RhythmEngine* engine, RhythmOverlayStats* stats);
+
+// load_file also takes "-" (stdin), a FIFO or an http:// URL; such tracks play live with
+// no duration or seeking, behind a jitter buffer reported here
+RhythmError rhythm_engine_get_stream_stats(RhythmEngine* engine, RhythmStreamStats* stats);
+
+// ranked lookup over the playlist by title, artist and album (file name and the two
+// directories above it); up to max_results playlist indices, best first, into results
+RhythmError rhythm_engine_search(RhythmEngine* engine, const char* query, int* results, int max_results,
+                                 int* found);
+RhythmError rhythm_engine_get_search_stats(RhythmEngine* engine, RhythmSearchStats* stats);
+
+// Process-wide, whichever engine sets it: real-time scheduling, CPU pinning and locked
+// memory for the audio and decoder threads (see include/core/realtime.h). The first
+// engine created applies RHYTHM_REALTIME and friends from the environment. The status
+// tells which guarantees were actually obtained.
+RhythmError rhythm_engine_set_realtime(RhythmEngine* engine, const RhythmRealtimeConfig* config);
+RhythmError rhythm_engine_get_realtime_status(RhythmEngine* engine, RhythmRealtimeStatus* status);
+
+// Process-wide too: engine messages go through the log ring (see include/core/log.h) to
+// stderr by default, a file (NULL for stderr again) or a callback on the log thread.
+// RHYTHM_LOG_LEVEL and RHYTHM_LOG_FILE set the same from the environment.
+RhythmError rhythm_engine_set_log_level(RhythmEngine* engine, RhythmLogLevel level);
+RhythmError rhythm_engine_set_log_file(RhythmEngine* engine, const char* path);
+RhythmError rhythm_engine_set_log_callback(RhythmEngine* engine, RhythmLogCallback callback, void* user_data);
+RhythmError rhythm_engine_get_log_stats(RhythmEngine* engine, RhythmLogStats* stats);
+
+// A session snapshot keeps the playlist, shuffle order, current track, position and
+// volume; restoring one replaces the playlist and, if it was playing, carries on from the
+// saved position. With a session file set, rhythm_engine_update() saves to it every
+// interval_ms (0 for RHYTHM_SESSION_INTERVAL_MS) when something changed, and destroy saves
+// a last time; NULL stops that. Set the file before restoring from it, so unchanged
+// playlists are not written out again.
+RhythmError rhythm_engine_set_session_file(RhythmEngine* engine, const char* path, int interval_ms);
+RhythmError rhythm_engine_save_session(RhythmEngine* engine, const char* path);
+RhythmError rhythm_engine_restore_session(RhythmEngine* engine, const char* path);
+// next/previous follow a shuffled order that starts at the current track
+RhythmError rhythm_engine_set_shuffle(RhythmEngine* engine, bool enabled);
+bool rhythm_engine_get_shuffle(RhythmEngine* engine);
+
+// While a track plays, the next tracks in play order (shuffled or not) are read into the
+// page cache in the background, so the next start does not wait on a cold disk or NFS
+// mount; jumping or reshuffling cancels and requeues. tracks is how many to look ahead
+// (0 turns it off, at most PREFETCH_MAX_TRACKS) and budget_bytes caps the bytes read
+// ahead (0 for PREFETCH_DEFAULT_BUDGET). RHYTHM_PREFETCH and RHYTHM_PREFETCH_MB set the
+// same from the environment; the default is PREFETCH_DEFAULT_TRACKS tracks.
+RhythmError rhythm_engine_set_prefetch(RhythmEngine* engine, int tracks, size_t budget_bytes);
+RhythmError rhythm_engine_get_prefetch_stats(RhythmEngine* engine, RhythmPrefetchStats* stats);
+
+// Decoded audio of local files is kept in PCM_CACHE_SEGMENT_FRAMES segments, so playing
+// a track again or seeking back reads memory instead of decoding. One cache and budget
+// serve every engine in the process, so this configures it for all of them; the least
+// recently used segments go once budget_bytes is spent (0 turns caching off). pack16
+// stores 16-bit samples for twice the audio per byte. Segments are dropped on decoder
+// threads, never by the audio callback. RHYTHM_PCM_CACHE_MB and RHYTHM_PCM_CACHE_PACK=1
+// set the same from the environment; the default is PCM_CACHE_DEFAULT_BUDGET of float.
+RhythmError rhythm_engine_set_pcm_cache(RhythmEngine* engine, size_t budget_bytes, bool pack16);
+RhythmError rhythm_engine_get_pcm_cache_stats(RhythmEngine* engine, RhythmPcmCacheStats* stats);
+
+// Low power: seconds of decode-ahead refilled in bursts, long device periods and lazily
+// polled background jobs, for playback nobody is watching. The mode comes from
+// RHYTHM_POWER (auto, normal or low), default auto: low power while the front-end says
+// nobody interacts (a backgrounded CLI, a hidden GUI window, a daemon without vis
+// subscribers); engines start out interactive. Switching keeps the output open; only a
+// PortAudio stream whose period changes is reopened, where it is heard. Front-ends tick
+// (update and fetch status) every get_tick_interval_ms.
+RhythmError rhythm_engine_set_power_mode(RhythmEngine* engine, RhythmPowerMode mode);
+RhythmError rhythm_engine_set_interactive(RhythmEngine* engine, bool interactive);
+bool rhythm_engine_is_low_power(RhythmEngine* engine);
+int rhythm_engine_get_tick_interval_ms(RhythmEngine* engine);
+
+// count buckets evenly covering [start, end) of the current track, as fractions 0..1 like
+// seek positions; parts not analysed yet are zero and ready reports how far analysis got
+RhythmError rhythm_engine_get_waveform(RhythmEngine* engine, float start, float end,
+                                       RhythmWaveformBucket* buckets, int count, float* ready);
+
 RhythmError rhythm_engine_load_file(RhythmEngine* engine, const char* filename);
 RhythmError rhythm_engine_load_directory(RhythmEngine* engine, const char* directory);
 
@@ -41,10 +270,17 @@ RhythmError rhythm_engine_pause(RhythmEngine* engine);
 RhythmError rhythm_engine_stop(RhythmEngine* engine);
 RhythmError rhythm_engine_next_track(RhythmEngine* engine);
 RhythmError rhythm_engine_previous_track(RhythmEngine* engine);
+RhythmError rhythm_engine_play_track(RhythmEngine* engine, int index);
+// read-only, for browsers walking the entries with playlist_get_file_at; empty before the
+// first load and replaced by the next one
+Playlist* rhythm_engine_get_playlist(RhythmEngine* engine);
 RhythmError rhythm_engine_seek(RhythmEngine* engine, float position);
 RhythmError rhythm_engine_set_volume(RhythmEngine* engine, float volume);
 
 RhythmStatus rhythm_engine_get_status(RhythmEngine* engine);
+RhythmError rhythm_engine_get_status_frame(RhythmEngine* engine, RhythmStatusFrame* frame);
+// sizeof(RhythmStatusFrame) as built, so bindings that redeclare it can check their copy
+size_t rhythm_engine_status_frame_size(void);
 void rhythm_engine_update(RhythmEngine* engine);
 RhythmError rhythm_engine_get_last_error(RhythmEngine* engine);
 const char* rhythm_engine_error_string(RhythmError error);
@@ -0,0 +1,35 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <stddef.h>
+#include <stdatomic.h>
+
+// single-producer/single-consumer sample ring; positions grow monotonically
+// and are masked on access, so capacity is always a power of two
+typedef struct {
+    float *data;
+    size_t capacity;
+    size_t mask;
+    atomic_size_t write_pos;
+    atomic_size_t read_pos;
+    atomic_size_t flush_pos;
+} RingBuffer;
+
+RingBuffer* ring_buffer_create(size_t min_capacity);
+void ring_buffer_destroy(RingBuffer *ring);
+
+size_t ring_buffer_read_available(RingBuffer *ring);
+size_t ring_buffer_write_available(RingBuffer *ring);
+
+size_t ring_buffer_write(RingBuffer *ring, const float *samples, size_t count);
+size_t ring_buffer_read(RingBuffer *ring, float *samples, size_t count);
+
+// producer side zero-copy write: the contiguous free span at the write position,
+// filled in place and then published with ring_buffer_commit
+size_t ring_buffer_write_region(RingBuffer *ring, float **region);
+void ring_buffer_commit(RingBuffer *ring, size_t count);
+
+// producer side: everything written so far is dropped by the consumer on its next read
+void ring_buffer_flush(RingBuffer *ring);
+
+#endif
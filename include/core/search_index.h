@@ -0,0 +1,49 @@
+#ifndef SEARCH_INDEX_H
+#define SEARCH_INDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SEARCH_INDEX_MAX_TERMS 8
+#define SEARCH_INDEX_SCAN_LIMIT 1024
+
+// Trigram index over playlist entries. Each entry is a title, artist and album,
+// normalized to lower-case ASCII words (other bytes kept as they are). Every trigram
+// inside a word has a posting list of entry ids, delta-coded as varints; entries are
+// appended in playlist order, so lists stay sorted and adding never rewrites them.
+// The first one and two bytes of every word have lists too. A query intersects the
+// lists of its trigrams, rarest first, and checks each candidate for every query word
+// as a substring; words shorter than three bytes use their prefix list and only match
+// at the start of a word. A broad query ranks the first SEARCH_INDEX_SCAN_LIMIT
+// candidates of its rarest list in playlist order and returns the best of those, so
+// type-ahead stays fast at any library size. Not thread-safe: queries reuse scratch
+// buffers in the index.
+typedef struct SearchIndex SearchIndex;
+
+typedef struct {
+    size_t entries;
+    size_t trigrams;            // distinct trigrams and word prefixes with a posting list
+    size_t postings;            // entry ids across all lists
+    size_t memory_bytes;        // everything the index allocated
+} SearchIndexStats;
+
+SearchIndex *search_index_create(void);
+void search_index_destroy(SearchIndex *index);
+void search_index_clear(SearchIndex *index);
+
+// the next entry id is the current count; any field may be NULL
+int search_index_add(SearchIndex *index, const char *title, const char *artist, const char *album);
+// title from the file name without its extension, album and artist from the two
+// directories above it (the usual Artist/Album/Track layout)
+int search_index_add_path(SearchIndex *index, const char *path);
+size_t search_index_count(SearchIndex *index);
+
+// Ids of the best max_results matches, best first: matches in the title rank above the
+// artist, then the album, matches at the start of a word and whole words rank higher,
+// and shorter entries win ties before lower ids. Returns how many were written, -1 on
+// allocation failure.
+int search_index_query(SearchIndex *index, const char *query, int *results, int max_results);
+
+void search_index_get_stats(SearchIndex *index, SearchIndexStats *stats);
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef SESSION_H
+#define SESSION_H
+
+#include "core/playlist.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// What a restart needs to carry on where playback left off. The snapshot is one binary
+// file: a fixed header with this state, then the shuffle order, one offset per path and
+// the paths themselves. A new playlist is written beside its target and renamed over it,
+// so a crash leaves either the old snapshot or the new one. Restoring maps the file and points the
+// playlist's entries into the mapping, so no path is copied and no entry is stat()ed.
+typedef struct {
+    int current_index;
+    long long position_frames;  // in the track's own rate
+    float volume;
+    bool playing;
+} SessionState;
+
+// $RHYTHM_SESSION, else $XDG_STATE_HOME/rhythm/session, else ~/.local/state/rhythm/session
+int session_default_path(char *buffer, size_t size);
+
+// playlist_unchanged: the file at path already holds this playlist and order (from an
+// earlier save or the restore), so only its header is rewritten in place and synced.
+// That trades atomicity for I/O: a crash during the write can restore a mix of the old
+// and new index, position and volume, though never a broken playlist. Falls back to
+// writing everything beside it when the header cannot be rewritten.
+int session_save(const char *path, Playlist *playlist, const SessionState *state, bool playlist_unchanged);
+
+// replaces the playlist's entries, order and current index with the snapshot's
+int session_restore(const char *path, Playlist *playlist, SessionState *state);
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef STREAM_SOURCE_H
+#define STREAM_SOURCE_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "core/decoder.h"
+
+#define STREAM_BUFFER_BYTES (1 << 20)
+#define STREAM_OPEN_TIMEOUT_MS 5000
+#define STREAM_JITTER_MIN_MS 150
+#define STREAM_JITTER_START_MS 500
+#define STREAM_JITTER_MAX_MS 4000
+
+// A live byte source: stdin ("-"), a FIFO or socket on the filesystem, or
+// http://host[:port]/path fetched with a plain HTTP/1.0 GET. A reader thread moves
+// bytes from the descriptor into a bounded buffer, so a stalled sender never blocks a
+// decoder. Consumers take bytes through a jitter buffer measured in milliseconds of
+// audio: nothing is handed out until the target is queued, running dry while the
+// consumer has nothing left downstream counts an underrun and raises the target, and
+// a long stretch without one lowers it again.
+typedef struct StreamSource StreamSource;
+
+typedef enum {
+    STREAM_DATA,
+    STREAM_BUFFERING,           // refilling the jitter buffer, try again later
+    STREAM_END,
+    STREAM_FAILED
+} StreamRead;
+
+typedef struct {
+    bool active;                // a stream is open
+    bool buffering;
+    bool ended;                 // the sender closed the stream
+    uint64_t bytes_received;
+    uint64_t underruns;
+    float buffered_ms;          // queued here plus what the consumer reported downstream
+    float target_ms;
+    float byte_rate;            // bytes per second of audio, measured or from the header
+} StreamStats;
+
+// "-", an http:// URL or a path to a FIFO or socket; regular files are not streams
+bool stream_source_is_stream(const char *path);
+
+StreamSource *stream_source_create(void);
+void stream_source_destroy(StreamSource *source);
+
+int stream_source_open(StreamSource *source, const char *uri);
+void stream_source_close(StreamSource *source);
+
+// blocks up to timeout_ms for at least one byte; 0 on timeout, end or failure.
+// Used for headers while opening and bypasses the jitter buffer.
+size_t stream_source_read(StreamSource *source, void *buffer, size_t size, int timeout_ms);
+
+// converts the fill level to milliseconds; take() hands out multiples of align bytes
+void stream_source_set_rate(StreamSource *source, double bytes_per_second, size_t align);
+
+// never blocks. queued_ms is audio the consumer already holds downstream.
+StreamRead stream_source_take(StreamSource *source, void *buffer, size_t size, float queued_ms,
+                              size_t *taken);
+
+void stream_source_get_stats(StreamSource *source, StreamStats *stats);
+
+// stream_decoder_create() decoders own one source each. Any other decoder is ignored,
+// and its stats read as zero.
+void stream_decoder_set_queued(Decoder *decoder, float queued_ms);
+void stream_decoder_get_stats(Decoder *decoder, StreamStats *stats);
+
+#endif
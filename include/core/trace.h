@@ -0,0 +1,54 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Chrome trace event recorder (load the output in chrome://tracing or ui.perfetto.dev).
+// Built only with -DRHYTHM_TRACING=ON and active only when RHYTHM_TRACE=<file> is set;
+// otherwise every TRACE_* macro compiles away.
+
+#define TRACE_MAX_THREADS 16
+#define TRACE_DEFAULT_EVENTS_PER_THREAD 16384
+
+typedef struct {
+    const char *name;           // must be a string literal
+    uint64_t start_ns;
+} TraceSpan;
+
+#ifdef RHYTHM_TRACING
+
+void trace_init(void);
+bool trace_enabled(void);
+void trace_set_thread_name(const char *name);
+TraceSpan trace_span_begin(const char *name);
+void trace_span_end(TraceSpan *span);
+void trace_instant(const char *name);
+int trace_flush(const char *path);
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+
+// span covering the rest of the enclosing block
+#define TRACE_SCOPE(name) \
+    TraceSpan TRACE_CONCAT(trace_scope_, __LINE__) __attribute__((cleanup(trace_span_end))) = trace_span_begin(name)
+#define TRACE_BEGIN(span, name) TraceSpan span = trace_span_begin(name)
+#define TRACE_END(span) trace_span_end(&(span))
+#define TRACE_INSTANT(name) trace_instant(name)
+#define TRACE_THREAD_NAME(name) trace_set_thread_name(name)
+
+#else
+
+static inline void trace_init(void) {}
+static inline bool trace_enabled(void) { return false; }
+static inline int trace_flush(const char *path) { (void)path; return -1; }
+
+#define TRACE_SCOPE(name) (void)0
+#define TRACE_BEGIN(span, name) (void)0
+#define TRACE_END(span) (void)0
+#define TRACE_INSTANT(name) (void)0
+#define TRACE_THREAD_NAME(name) (void)0
+
+#endif
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef WAVEFORM_H
+#define WAVEFORM_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#define WAVEFORM_BASE_FRAMES 256
+#define WAVEFORM_MAX_LEVELS 32
+
+typedef struct {
+    float min;
+    float max;
+    float rms;
+} WaveformBucket;
+
+// min/max/RMS overview of one file as a pyramid: level 0 summarises WAVEFORM_BASE_FRAMES
+// frames per bin and every level above halves the resolution. A background thread decodes
+// the file (or loads it from the cache directory) and queries can run while it fills in.
+typedef struct Waveform Waveform;
+
+// cache_dir may be NULL to skip the disk cache
+Waveform* waveform_open(const char *path, const char *cache_dir);
+// cancels a running build and waits for it
+void waveform_destroy(Waveform *waveform);
+
+const char* waveform_path(Waveform *waveform);
+bool waveform_is_complete(Waveform *waveform);
+// 0..1, exact once complete
+float waveform_progress(Waveform *waveform);
+// decoder estimate while building, exact once complete; 0 when unknown
+long long waveform_total_frames(Waveform *waveform);
+
+// fills count buckets evenly covering [start_frame, end_frame); each bucket reads a bounded
+// number of bins from the coarsest level that still resolves it, so the cost is O(count)
+// whatever the range. Not yet analysed parts come back as zero.
+int waveform_get_buckets(Waveform *waveform, long long start_frame, long long end_frame,
+                         WaveformBucket *buckets, int count);
+
+// $RHYTHM_WAVEFORM_CACHE, else $XDG_CACHE_HOME/rhythm/waveforms, else ~/.cache/rhythm/waveforms
+int waveform_cache_default_dir(char *buffer, size_t size);
+
+#endif
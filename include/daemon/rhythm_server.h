@@ -0,0 +1,30 @@
+#ifndef RHYTHM_SERVER_H
+#define RHYTHM_SERVER_H
+
+#include "core/rhythm_engine.h"
+#include <stdint.h>
+
+// Serves one engine on a Unix domain socket using the protocol in
+// shared/rhythm_protocol.h. A single epoll thread owns the engine: it accepts any
+// number of non-blocking clients, answers their requests in arrival order and, every
+// tick, pushes events and vis frames to the clients subscribed to them.
+typedef struct RhythmServer RhythmServer;
+
+typedef struct {
+    uint32_t clients;                           // connected now
+    uint64_t accepted;
+    uint64_t requests;
+    uint64_t protocol_errors;                   // clients dropped for malformed messages
+    uint64_t slow_clients;                      // clients dropped because replies backed up
+    uint64_t vis_dropped;                       // vis frames skipped for clients not keeping up
+} RhythmServerStats;
+
+// fails if another daemon is listening on socket_path; a stale socket file is replaced.
+// The engine must not be used by other threads until the server is destroyed.
+RhythmServer* rhythm_server_create(RhythmEngine* engine, const char* socket_path);
+// closes every client and removes the socket file; the engine is left to the caller
+void rhythm_server_destroy(RhythmServer* server);
+
+void rhythm_server_get_stats(RhythmServer* server, RhythmServerStats* stats);
+
+#endif
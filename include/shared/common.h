@@ -7,12 +7,14 @@
 #include <stdbool.h>
 #include <portaudio.h>
 #include <mpg123.h>
+#include "core/log.h"
 
-#define CHECK_ERROR(condition, message) \
+// logs message and returns result from the calling function; never exits the process
+#define CHECK_ERROR(condition, result, message) \
     do { \
         if (condition) { \
-            fprintf(stderr, "Error: %s\n", message); \
-            exit(EXIT_FAILURE); \
+            LOG_ERROR("%s", message); \
+            return result; \
         } \
     } while(0)
 
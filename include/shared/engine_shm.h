@@ -0,0 +1,68 @@
+#ifndef ENGINE_SHM_H
+#define ENGINE_SHM_H
+
+#include "core/rhythm_engine.h"
+#include <stdint.h>
+#include <stdatomic.h>
+#include <semaphore.h>
+
+// Layout of the segment an engine host shares with its clients. The host is the only
+// writer of the published state (guarded by a sequence lock) and the only consumer of
+// the command ring; a single client produces commands.
+
+#define ENGINE_SHM_MAGIC 0x53594852u            // "RHYS"
+#define ENGINE_SHM_VERSION 3
+#define ENGINE_SHM_ENV "RHYTHM_ENGINE_SHM"
+#define ENGINE_SHM_COMMANDS 64                  // power of two
+#define ENGINE_SHM_PATH_MAX 1024
+#define ENGINE_SHM_WAVEFORM_BUCKETS 1024
+
+typedef enum {
+    ENGINE_COMMAND_LOAD_FILE,
+    ENGINE_COMMAND_LOAD_DIRECTORY,
+    ENGINE_COMMAND_PLAY,
+    ENGINE_COMMAND_PAUSE,
+    ENGINE_COMMAND_STOP,
+    ENGINE_COMMAND_NEXT_TRACK,
+    ENGINE_COMMAND_PREVIOUS_TRACK,
+    ENGINE_COMMAND_SEEK,                        // value: position 0..1
+    ENGINE_COMMAND_SET_VOLUME,                  // value: volume
+    ENGINE_COMMAND_SET_EQ_ENABLED,              // index: 0 or 1
+    ENGINE_COMMAND_SET_EQ_BAND,                 // index: band, value: gain in dB
+    ENGINE_COMMAND_SET_EQ_PREAMP,               // value: gain in dB
+    ENGINE_COMMAND_SET_INTERACTIVE              // index: 0 when nobody is looking, e.g. a hidden window
+} EngineCommandType;
+
+typedef struct {
+    int32_t type;
+    int32_t index;
+    float value;
+    int32_t result;                             // RhythmError, written by the host
+    char path[ENGINE_SHM_PATH_MAX];
+} EngineCommand;
+
+typedef struct {
+    float ready;                                // analysed fraction of the current track
+    RhythmWaveformBucket buckets[ENGINE_SHM_WAVEFORM_BUCKETS];
+} EngineShmWaveform;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    int32_t host_pid;
+
+    // published state; odd sequence means the host is writing
+    atomic_uint sequence;
+    RhythmStatusFrame frame;
+    RhythmEqualizer eq;
+    EngineShmWaveform waveform;                 // whole-track overview
+
+    // commands; positions grow monotonically. Once command_read has moved past a slot
+    // its result is valid and the state it led to has been published
+    atomic_uint command_write;
+    atomic_uint command_read;
+    sem_t command_wake;                         // process-shared, posted per command
+    EngineCommand commands[ENGINE_SHM_COMMANDS];
+} EngineShm;
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef RHYTHM_PROTOCOL_H
+#define RHYTHM_PROTOCOL_H
+
+#include "shared/engine_shm.h"
+#include <stdint.h>
+
+// Wire format of rhythmd. Every message is a RhythmMessageHeader followed by `length`
+// payload bytes. Both ends run on the same machine, so fields are in host byte order.
+// Requests carry a client-chosen id that the daemon echoes in its reply; stream
+// messages (events, vis frames) have id 0 and may interleave with replies.
+
+#define RHYTHM_PROTOCOL_VERSION 3
+#define RHYTHM_SOCKET_ENV "RHYTHMD_SOCKET"
+#define RHYTHM_PROTOCOL_MAX_PAYLOAD 2048
+
+typedef enum {
+    // client to daemon
+    RHYTHM_MSG_PING = 1,                        // answered with RESULT
+    RHYTHM_MSG_COMMAND = 2,                     // RhythmCommandMessage + path bytes; answered with RESULT
+    RHYTHM_MSG_GET_STATUS = 3,                  // answered with STATUS
+    RHYTHM_MSG_SUBSCRIBE = 4,                   // RhythmSubscribeMessage; answered with RESULT
+
+    // daemon to client
+    RHYTHM_MSG_RESULT = 64,                     // RhythmResultMessage
+    RHYTHM_MSG_STATUS = 65,                     // RhythmStatusFrame
+    RHYTHM_MSG_EVENT = 66,                      // RhythmEventMessage
+    RHYTHM_MSG_VIS = 67                         // RhythmVisMessage
+} RhythmMessageType;
+
+typedef struct {
+    uint32_t length;                            // payload bytes after the header
+    uint16_t type;
+    uint16_t version;
+    uint32_t id;
+} RhythmMessageHeader;
+
+typedef struct {
+    int32_t command;                            // EngineCommandType
+    int32_t index;
+    float value;
+    // followed by the path for load commands, without a terminator
+} RhythmCommandMessage;
+
+#define RHYTHM_SUBSCRIBE_EVENTS 0x1u
+#define RHYTHM_SUBSCRIBE_VIS 0x2u
+
+typedef struct {
+    uint32_t mask;                              // RHYTHM_SUBSCRIBE_*, replaces the previous mask
+} RhythmSubscribeMessage;
+
+typedef struct {
+    int32_t result;                             // RhythmError
+} RhythmResultMessage;
+
+typedef enum {
+    RHYTHM_EVENT_STATE = 1,                     // value: PlayerState
+    RHYTHM_EVENT_TRACK = 2,                     // value: current track index
+    RHYTHM_EVENT_PLAYLIST = 3,                  // value: total tracks
+    RHYTHM_EVENT_BEAT = 4                       // value: beat count
+} RhythmEventType;
+
+typedef struct {
+    int32_t event;                              // RhythmEventType
+    int32_t value;
+} RhythmEventMessage;
+
+typedef struct {
+    uint32_t sequence;                          // status frame sequence it was taken from
+    float vis_bands[32];
+    RhythmFeatures features;
+} RhythmVisMessage;
+
+#endif
@@ -10,17 +10,43 @@
 #define YELLOW    "\x1B[93m"
 #define RED       "\x1B[91m"
 
-static void clear_input_buffer(void) {
-    int flags = fcntl(STDIN_FILENO, F_GETFL, 0);
-    fcntl(STDIN_FILENO, F_SETFL, flags | O_NONBLOCK);
-
-    char c;
-    while (read(STDIN_FILENO, &c, 1) > 0) {
-
-    }
-
-    fcntl(STDIN_FILENO, F_SETFL, flags);
-}
+#define REVERSE   "\x1B[7m"
+
+#define PLAYLIST_RESERVED_LINES 20          // status, loudness and the pane header
+#define STATS_LINES 7
+#define PLAYLIST_MIN_ROWS 3
+#define PLAYLIST_SCAN_BUDGET_NS 4000000ULL  // filter work per frame, a quarter of 16 ms
+#define BUSY_FRAME_INTERVAL_MS 16
+
+// keys past the byte range, decoded from escape sequences
+enum {
+    KEY_UP = 256,
+    KEY_DOWN,
+    KEY_LEFT,
+    KEY_RIGHT,
+    KEY_PAGE_UP,
+    KEY_PAGE_DOWN,
+    KEY_HOME,
+    KEY_END,
+    KEY_ESCAPE
+};
+
+typedef enum {
+    INPUT_KEYS,
+    INPUT_FILTER,       // typing a type-ahead query
+    INPUT_JUMP          // typing a track number
+} InputMode;
+
+static bool stats_visible = false;
+static bool playlist_visible = false;
+static bool playlist_reveal = false;
+static PlaylistView *playlist_view = NULL;
+static InputMode input_mode = INPUT_KEYS;
+static char filter_text[PLAYLIST_VIEW_QUERY_MAX];
+static char jump_text[12];
+static bool input_closed = false;
+static bool terminal_saved = false;
+static struct termios saved_terminal;
 
 static int get_terminal_width(void) {
     struct winsize w;
@@ -28,6 +54,12 @@ static int get_terminal_width(void) {
     return w.ws_col;
 }
 
+static int get_terminal_height(void) {
+    struct winsize w;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &w) < 0 || w.ws_row == 0) return 24;
+    return w.ws_row;
+}
+
 static void format_time(int seconds, char *buffer) {
     int minutes = seconds / 60;
     seconds %= 60;
@@ -68,6 +100,18 @@ static void set_vis_color(int band, int total_bands, float intensity) {
 }
 
 void cli_init(void) {
+    const char *show_stats = getenv("RHYTHM_CLI_STATS");
+    stats_visible = show_stats && strcmp(show_stats, "0") != 0;
+    playlist_view = playlist_view_create();
+
+    // keys are read as they are typed for the whole session, so nothing echoes between frames
+    if (tcgetattr(STDIN_FILENO, &saved_terminal) == 0) {
+        struct termios raw = saved_terminal;
+        raw.c_lflag &= ~(ICANON | ECHO);
+        tcsetattr(STDIN_FILENO, TCSANOW, &raw);
+        terminal_saved = true;
+    }
+
     printf("\033[?25l");
     printf("\033[2J\033[H");
     // switch to alternate screen
@@ -75,6 +119,13 @@ void cli_init(void) {
 }
 
 void cli_cleanup(void) {
+    if (terminal_saved) {
+        tcsetattr(STDIN_FILENO, TCSANOW, &saved_terminal);
+        terminal_saved = false;
+    }
+    playlist_view_destroy(playlist_view);
+    playlist_view = NULL;
+
     // switch back to main screen
     printf("\e[?10491");
     printf("\033[?25h");
@@ -85,7 +136,6 @@ void cli_cleanup(void) {
 
 void cli_display_status(const RhythmStatus *status) {
     printf("\033[H\033[2J");
-    clear_input_buffer(); 
 
     if (!status->current_file) return;
 
@@ -96,7 +146,7 @@ void cli_display_status(const RhythmStatus *status) {
     strncpy(clean_name, filename, sizeof(clean_name) - 1);
     clean_name[sizeof(clean_name) - 1] = '\0';
     char *ext = strrchr(clean_name, '.');
-    if (ext && strcmp(ext, ".mp3") == 0) *ext = '\0';
+    if (ext && (strcmp(ext, ".mp3") == 0 || strcmp(ext, ".wav") == 0)) *ext = '\0';
 
     char current_time[10], total_time[10];
     format_time(status->current_time, current_time);
@@ -112,11 +162,16 @@ void cli_display_status(const RhythmStatus *status) {
         printf("  %s(%d/%d)%s", GRAY, status->current_track, status->total_tracks, RESET);
     }
     printf("\n");
-    printf("  %s%s / %s%s\n\n", GRAY, current_time, total_time, RESET);
+    if (!status->duration_known && status->state != PLAYER_STATE_STOPPED) {
+        // live stream: nothing to measure progress against
+        printf("  %s%s / live%s\n\n", GRAY, current_time, RESET);
+    } else {
+        printf("  %s%s / %s%s\n\n", GRAY, current_time, total_time, RESET);
 
-    printf("  ");
-    draw_progress_bar(status->progress, content_width - 4);
-    printf("  %s%.0f%%%s\n\n", GRAY, status->progress * 100, RESET);
+        printf("  ");
+        draw_progress_bar(status->progress, content_width - 4);
+        printf("  %s%.0f%%%s\n\n", GRAY, status->progress * 100, RESET);
+    }
 
     int vis_bands = 24;
     int vis_height = 6;
@@ -155,32 +210,334 @@ void cli_display_status(const RhythmStatus *status) {
     }
 
     printf("    Volume: %s%.0f%%%s", WHITE, status->volume * 100, GRAY);
-    printf("    [space] pause  [q] quit  [+/-] volume  [←/→] seek");
+    printf("    [space] pause  [q] quit  [+/-] volume  [←/→] seek  [i] stats  [l] loudness scan  [tab] playlist");
     if (status->total_tracks > 1) {
-        printf("  [n] next  [p] prev");
+        printf("  [n] next  [p] prev  [h] shuffle %s", status->shuffle ? "on" : "off");
     }
     printf("%s\n", RESET);
 
     printf("\n");
 }
 
-int cli_handle_input(RhythmEngine *engine) {
-    struct termios oldt, newt;
-    tcgetattr(STDIN_FILENO, &oldt);
-    newt = oldt;
-    newt.c_lflag &= ~(ICANON | ECHO);
-    tcsetattr(STDIN_FILENO, TCSANOW, &newt);
+bool cli_stats_visible(void) {
+    return stats_visible;
+}
+
+void cli_display_stats(const RhythmStats *stats, const RhythmAudioInfo *info, const RhythmRealtimeStatus *realtime,
+                       const RhythmPrefetchStats *prefetch, const RhythmPcmCacheStats *pcm) {
+    printf("  %s%s  %d Hz  %d frames  out %.1f ms  queued %.1f ms",
+           GRAY, info->backend == AUDIO_BACKEND_JACK ? "jack" : "portaudio",
+           info->sample_rate, info->frames_per_buffer,
+           info->output_latency_ms, info->buffer_latency_ms);
+    if (info->resampling) {
+        printf("  resampling %d → %d", info->source_rate, info->sample_rate);
+    }
+    printf("%s\n", RESET);
+
+    printf("  %scallback  p50 %.0f µs  p99 %.0f µs  p99.9 %.0f µs  max %.0f µs  budget %.0f µs%s\n",
+           GRAY, stats->callback_p50_us, stats->callback_p99_us, stats->callback_p999_us,
+           stats->callback_max_us, stats->callback_budget_us, RESET);
+    printf("  %sdecode    p50 %.0f µs  p99 %.0f µs  max %.0f µs%s\n",
+           GRAY, stats->decode_p50_us, stats->decode_p99_us, stats->decode_max_us, RESET);
+    printf("  %sring      %.0f / %.0f ms  min %.0f ms%s\n",
+           GRAY, stats->ring_fill_ms, stats->ring_capacity_ms, stats->ring_min_fill_ms, RESET);
+    printf("  %sprefetch  cached %llu / %llu starts  first sample %.0f ms (cached %.0f, cold %.0f)  read %.1f MB%s\n",
+           GRAY, (unsigned long long)prefetch->hits, (unsigned long long)(prefetch->hits + prefetch->misses),
+           prefetch->first_sample_ms, prefetch->first_sample_hit_ms, prefetch->first_sample_miss_ms,
+           prefetch->bytes / (1024.0 * 1024.0), RESET);
+    printf("  %spcm cache hit %llu / %llu segments  %.1f / %.0f MB%s  evicted %llu%s\n",
+           GRAY, (unsigned long long)pcm->hits, (unsigned long long)(pcm->hits + pcm->misses),
+           pcm->bytes / (1024.0 * 1024.0), pcm->budget / (1024.0 * 1024.0), pcm->packed ? " 16-bit" : "",
+           (unsigned long long)pcm->evictions, RESET);
+
+    bool trouble = stats->underflows || stats->overflows || stats->starved_callbacks || stats->deadline_misses;
+    printf("  %sxruns     underflow %llu  overflow %llu  starved %llu  late %llu  of %llu callbacks%s\n",
+           trouble ? YELLOW : GRAY,
+           (unsigned long long)stats->underflows, (unsigned long long)stats->overflows,
+           (unsigned long long)stats->starved_callbacks, (unsigned long long)stats->deadline_misses,
+           (unsigned long long)stats->callbacks, RESET);
+
+    if (stats->worst_callback_time > 0) {
+        time_t when = (time_t)stats->worst_callback_time;
+        char stamp[16];
+        strftime(stamp, sizeof(stamp), "%H:%M:%S", localtime(&when));
+        printf("  %sworst     %.0f µs at %s%s\n", GRAY, stats->worst_callback_us, stamp, RESET);
+    }
+
+    if (!realtime->enabled) {
+        printf("  %srealtime  off (RHYTHM_REALTIME=1 to enable)%s\n", GRAY, RESET);
+    } else {
+        printf("  %srealtime ", GRAY);
+        static const char *ROLE_NAMES[REALTIME_ROLES] = { "audio", "decoder" };
+        for (int role = 0; role < REALTIME_ROLES; role++) {
+            const RealtimeRoleStatus *status = &realtime->roles[role];
+            printf(" %s %s", ROLE_NAMES[role], status->threads ? realtime_method_name(status->method) : "-");
+            if (status->priority > 0) printf(" %d", status->priority);
+            if (status->pinned > 0) printf(" pinned %d/%d", status->pinned, status->threads);
+            printf(" ");
+        }
+        if (realtime->memory_locked) {
+            printf(" memory locked");
+        } else {
+            printf(" rings locked %zu KB prefaulted %zu KB", realtime->buffers_locked / 1024,
+                   realtime->buffers_prefaulted / 1024);
+        }
+        printf("%s\n", RESET);
+    }
+    printf("\n");
+}
+
+void cli_display_loudness(const RhythmLoudnessScanStatus *scan, const RhythmTrackLoudness *track) {
+    if (scan->running) {
+        int done = scan->analysed + scan->cached + scan->failed;
+        printf("  %sScanning loudness: %d/%d", GRAY, done, scan->total_tracks);
+        if (scan->failed > 0) {
+            printf("  (%d failed)", scan->failed);
+        }
+        printf("%s\n", RESET);
+    }
+    if (track->measured) {
+        printf("  %s%.1f LUFS  LRA %.1f LU  peak %.1f dBTP  gain %+.1f dB%s\n", GRAY,
+               track->integrated_lufs, track->loudness_range, track->true_peak_dbtp,
+               track->applied_gain_db, RESET);
+    }
+}
+
+// keeps whole code points, counting each as one column
+static int utf8_prefix(const char *text, int columns) {
+    int bytes = 0;
+    for (; text[bytes]; bytes++) {
+        if (((unsigned char)text[bytes] & 0xC0) != 0x80 && columns-- == 0) break;
+    }
+    return bytes;
+}
+
+void cli_display_playlist(RhythmEngine *engine) {
+    if (!playlist_visible || !playlist_view) return;
+
+    Playlist *playlist = rhythm_engine_get_playlist(engine);
+    int rows = get_terminal_height() - PLAYLIST_RESERVED_LINES - (stats_visible ? STATS_LINES : 0);
+    if (rows < PLAYLIST_MIN_ROWS) rows = PLAYLIST_MIN_ROWS;
+
+    playlist_view_sync(playlist_view, playlist, rows);
+    if (playlist_reveal && playlist) {
+        // open on the track that is playing
+        playlist_view_jump(playlist_view, playlist->current_index);
+        playlist_reveal = false;
+    }
+    playlist_view_step(playlist_view, playlist, PLAYLIST_SCAN_BUDGET_NS);
+
+    int count = playlist_view_count(playlist_view);
+    int total = playlist_get_count(playlist);
+    printf("  %s", GRAY);
+    if (input_mode == INPUT_JUMP) {
+        printf("Go to track: %s%s%s_", WHITE, jump_text, GRAY);
+    } else if (input_mode == INPUT_FILTER || playlist_view_query(playlist_view)[0]) {
+        printf("/%s%s%s%s  %d of %d", WHITE, filter_text, GRAY, input_mode == INPUT_FILTER ? "_" : "",
+               count, total);
+        if (playlist_view_scanning(playlist_view)) {
+            printf("  searching %.0f%%", playlist_view_scan_progress(playlist_view) * 100);
+        }
+    } else {
+        printf("Playlist  %d tracks", total);
+    }
+    printf("    [↑/↓] move  [enter] play  [/] filter  [:] go to  [esc] clear%s\n", RESET);
+
+    int digits = 1;
+    for (int n = total; n >= 10; n /= 10) digits++;
+    int name_columns = get_terminal_width() - digits - 8;
+    if (name_columns < 8) name_columns = 8;
+
+    int top = playlist_view_top(playlist_view);
+    int cursor = playlist_view_cursor(playlist_view);
+    int current = playlist ? playlist->current_index : -1;
+    for (int row = 0; row < rows; row++) {
+        int index = playlist_view_index_at(playlist_view, top + row);
+        if (index < 0) {
+            printf("\n");
+            continue;
+        }
+
+        const char *path = playlist_get_file_at(playlist, index);
+        const char *name = strrchr(path, '/');
+        name = name ? name + 1 : path;
 
+        printf("  %s%s%s %*d  %.*s%s\n", top + row == cursor ? REVERSE : "",
+               index == current ? WHITE "▶" : GRAY " ", index == current ? WHITE : "",
+               digits, index + 1, utf8_prefix(name, name_columns), name, RESET);
+    }
+}
+
+void cli_present(void) {
+    fflush(stdout);
+}
+
+int cli_frame_interval_ms(int idle_ms) {
+    bool busy = playlist_visible &&
+                (input_mode != INPUT_KEYS || playlist_view_scanning(playlist_view));
+    return busy ? BUSY_FRAME_INTERVAL_MS : idle_ms;
+}
+
+bool cli_attended(void) {
+    // redirected output, or a job moved to the background, has nobody watching it
+    return isatty(STDOUT_FILENO) && tcgetpgrp(STDOUT_FILENO) == getpgrp();
+}
+
+void cli_wait_for_input(int timeout_ms) {
+    struct pollfd keys = { .fd = STDIN_FILENO, .events = POLLIN };
+    if (input_closed || poll(&keys, 1, timeout_ms) < 0 || (keys.revents & (POLLHUP | POLLERR | POLLNVAL))) {
+        // no keyboard to wait for
+        usleep((useconds_t)timeout_ms * 1000);
+    }
+}
+
+static int decode_key(const unsigned char *keys, int length, int *at) {
+    int i = *at;
+    if (keys[i] != '\033') {
+        *at = i + 1;
+        return keys[i];
+    }
+    if (i + 2 >= length || (keys[i + 1] != '[' && keys[i + 1] != 'O')) {
+        *at = i + 1;
+        return KEY_ESCAPE;
+    }
+
+    unsigned char code = keys[i + 2];
+    *at = i + 3;
+    switch (code) {
+        case 'A': return KEY_UP;
+        case 'B': return KEY_DOWN;
+        case 'C': return KEY_RIGHT;
+        case 'D': return KEY_LEFT;
+        case 'H': return KEY_HOME;
+        case 'F': return KEY_END;
+        default: break;
+    }
+
+    if (code < '0' || code > '9') return 0;
+
+    // ESC [ <n> ~, skipping parameters of keys that are not handled
+    while (*at < length && keys[*at - 1] != '~') (*at)++;
+    switch (code) {
+        case '1': case '7': return KEY_HOME;
+        case '4': case '8': return KEY_END;
+        case '5': return KEY_PAGE_UP;
+        case '6': return KEY_PAGE_DOWN;
+        default: return 0;
+    }
+}
+
+static void play_selected(RhythmEngine *engine) {
+    int index = playlist_view_index_at(playlist_view, playlist_view_cursor(playlist_view));
+    if (index >= 0) rhythm_engine_play_track(engine, index);
+}
+
+// true when the pane took the key
+static bool handle_playlist_key(RhythmEngine *engine, int key) {
+    if (!playlist_visible || !playlist_view) return false;
+
+    int page = get_terminal_height() - PLAYLIST_RESERVED_LINES;
+    if (page < PLAYLIST_MIN_ROWS) page = PLAYLIST_MIN_ROWS;
+
+    switch (key) {
+        case KEY_UP: playlist_view_move(playlist_view, -1); return true;
+        case KEY_DOWN: playlist_view_move(playlist_view, 1); return true;
+        case KEY_PAGE_UP: playlist_view_move(playlist_view, -page); return true;
+        case KEY_PAGE_DOWN: playlist_view_move(playlist_view, page); return true;
+        case KEY_HOME: playlist_view_move(playlist_view, INT_MIN); return true;
+        case KEY_END: playlist_view_move(playlist_view, INT_MAX); return true;
+        default: break;
+    }
+
+    if (input_mode == INPUT_JUMP) {
+        size_t length = strlen(jump_text);
+        if (key >= '0' && key <= '9' && length < sizeof(jump_text) - 1) {
+            jump_text[length] = (char)key;
+            jump_text[length + 1] = '\0';
+        } else if ((key == 127 || key == 8) && length > 0) {
+            jump_text[length - 1] = '\0';
+        } else if (key == '\n' || key == '\r') {
+            if (length > 0) {
+                filter_text[0] = '\0';
+                playlist_view_jump(playlist_view, atoi(jump_text) - 1);
+            }
+            input_mode = INPUT_KEYS;
+        } else if (key == KEY_ESCAPE) {
+            input_mode = INPUT_KEYS;
+        }
+        return true;
+    }
+
+    if (input_mode == INPUT_FILTER) {
+        size_t length = strlen(filter_text);
+        if (key >= 32 && key < 127 && length < sizeof(filter_text) - 1) {
+            filter_text[length] = (char)key;
+            filter_text[length + 1] = '\0';
+            playlist_view_set_query(playlist_view, filter_text);
+        } else if ((key == 127 || key == 8) && length > 0) {
+            filter_text[length - 1] = '\0';
+            playlist_view_set_query(playlist_view, filter_text);
+        } else if (key == '\n' || key == '\r') {
+            play_selected(engine);
+            input_mode = INPUT_KEYS;
+        } else if (key == KEY_ESCAPE) {
+            filter_text[0] = '\0';
+            playlist_view_set_query(playlist_view, "");
+            input_mode = INPUT_KEYS;
+        }
+        return true;
+    }
+
+    switch (key) {
+        case '/':
+            input_mode = INPUT_FILTER;
+            return true;
+        case ':':
+            jump_text[0] = '\0';
+            input_mode = INPUT_JUMP;
+            return true;
+        case '\n':
+        case '\r':
+            play_selected(engine);
+            return true;
+        case KEY_ESCAPE:
+            filter_text[0] = '\0';
+            playlist_view_set_query(playlist_view, "");
+            return true;
+        default:
+            return false;
+    }
+}
+
+int cli_handle_input(RhythmEngine *engine) {
     int flags = fcntl(STDIN_FILENO, F_GETFL, 0);
     fcntl(STDIN_FILENO, F_SETFL, flags | O_NONBLOCK);
 
-    char c;
+    // everything typed since the last frame, so fast typing in the filter is not dropped
+    unsigned char keys[256];
+    ssize_t length = read(STDIN_FILENO, keys, sizeof(keys));
+    fcntl(STDIN_FILENO, F_SETFL, flags);
+    if (length == 0) input_closed = true;
+
     int result = 0;
+    int at = 0;
+    while (at < length && result != 2) {
+        int key = decode_key(keys, (int)length, &at);
+        if (key == '\t') {
+            playlist_visible = !playlist_visible;
+            input_mode = INPUT_KEYS;
+            if (playlist_visible && playlist_view) {
+                filter_text[0] = '\0';
+                playlist_reveal = true;
+            }
+            continue;
+        }
+        if (handle_playlist_key(engine, key)) continue;
 
-    if (read(STDIN_FILENO, &c, 1) > 0) {
         RhythmStatus status = rhythm_engine_get_status(engine);
+        float seek_offset = 0.05f;
 
-        switch (c) {
+        switch (key) {
             case ' ':
                 if (status.state == PLAYER_STATE_PLAYING) {
                     rhythm_engine_pause(engine);
@@ -202,39 +559,40 @@ int cli_handle_input(RhythmEngine *engine) {
             case 'P':
                 result = -1;
                 break;
+            case 'h':
+            case 'H':
+                rhythm_engine_set_shuffle(engine, !status.shuffle);
+                break;
+            case 'l':
+            case 'L':
+                rhythm_engine_start_loudness_scan(engine, 0);
+                break;
+            case 'i':
+            case 'I':
+                stats_visible = !stats_visible;
+                break;
+            case 'r':
+            case 'R':
+                if (stats_visible) {
+                    rhythm_engine_reset_stats(engine);
+                }
+                break;
             case '+':
                 rhythm_engine_set_volume(engine, status.volume + 0.1f);
                 break;
             case '-':
                 rhythm_engine_set_volume(engine, status.volume - 0.1f);
                 break;
-            case '\033':
-                if (read(STDIN_FILENO, &c, 1) == 1 && c == '[') {
-                    if (read(STDIN_FILENO, &c, 1) == 1) {
-                        float seek_offset = 0.05f; 
-
-                        switch (c) {
-                            case 'C': 
-                                rhythm_engine_seek(engine, status.progress + seek_offset);
-                                break;
-                            case 'D': 
-                                rhythm_engine_seek(engine, status.progress - seek_offset);
-                                break;
-                        }
-                    }
-                }
-                while (read(STDIN_FILENO, &c, 1) > 0) {
-                }
+            case KEY_RIGHT:
+                rhythm_engine_seek(engine, status.progress + seek_offset);
+                break;
+            case KEY_LEFT:
+                rhythm_engine_seek(engine, status.progress - seek_offset);
                 break;
             default:
                 break;
         }
     }
 
-    tcsetattr(STDIN_FILENO, TCSANOW, &oldt);
-    fcntl(STDIN_FILENO, F_SETFL, flags);
-
-    clear_input_buffer();
-
     return result;
-}
\ No newline at end of file
+}
@@ -1,8 +1,10 @@
 #include "shared/common.h"
 #include "core/rhythm_engine.h"
+#include "core/session.h"
 #include "cli/cli.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <signal.h>
 #include <sys/stat.h>
@@ -24,11 +26,14 @@ int is_directory(const char *path) {
 }
 
 int main(int argc, char *argv[]) {
-    if (argc != 2) {
-        fprintf(stderr, "Usage: %s <mp3_file_or_directory>\n", argv[0]);
+    if (argc > 2) {
+        fprintf(stderr, "Usage: %s [audio_file_or_directory | - | fifo | http://host[:port]/path]\n", argv[0]);
+        fprintf(stderr, "With no argument, carries on with the playlist and track of the last session\n");
         return 1;
     }
 
+    // a frame goes out in one write when cli_present() flushes it
+    setvbuf(stdout, NULL, _IOFBF, CLI_OUTPUT_BUFFER);
     atexit(cli_cleanup);
 
     signal(SIGINT, cleanup);
@@ -40,8 +45,43 @@ int main(int argc, char *argv[]) {
         return 1;
     }
 
+    // saved every few seconds and on exit, so the next start without an argument resumes here
+    char session_path[4096];
+    bool has_session = session_default_path(session_path, sizeof(session_path)) == 0;
+    if (has_session) {
+        rhythm_engine_set_session_file(engine, session_path, 0);
+    }
+
+    // with audio on stdin, keys come from the terminal instead; the pipe stays reachable
+    // through a duplicate descriptor, which is still a stream to the engine
+    const char *source = argc > 1 ? argv[1] : NULL;
+    char stdin_path[32];
+    if (source && strcmp(source, "-") == 0) {
+        int fd = dup(STDIN_FILENO);
+        if (fd < 0) {
+            fprintf(stderr, "Cannot read audio from stdin\n");
+            rhythm_engine_destroy(engine);
+            return 1;
+        }
+        if (!freopen("/dev/tty", "r", stdin)) {
+            fprintf(stderr, "Keyboard controls need a terminal when playing from stdin\n");
+        }
+        snprintf(stdin_path, sizeof(stdin_path), "/dev/fd/%d", fd);
+        source = stdin_path;
+    }
+
     RhythmError result;
-    if (is_directory(argv[1])) {
+    if (!source) {
+        result = has_session ? rhythm_engine_restore_session(engine, session_path) : RHYTHM_ERROR_FILE_NOT_FOUND;
+        if (result != RHYTHM_OK) {
+            fprintf(stderr, "No session to resume (%s); give a file or directory to play\n",
+                    rhythm_engine_error_string(result));
+            // an unreadable snapshot is left for inspection rather than replaced by an empty one
+            rhythm_engine_set_session_file(engine, NULL, 0);
+            rhythm_engine_destroy(engine);
+            return 1;
+        }
+    } else if (is_directory(argv[1])) {
         result = rhythm_engine_load_directory(engine, argv[1]);
         if (result != RHYTHM_OK) {
             fprintf(stderr, "Failed to load directory: %s - %s\n", argv[1], rhythm_engine_error_string(result));
@@ -51,20 +91,21 @@ int main(int argc, char *argv[]) {
 
         RhythmStatus status = rhythm_engine_get_status(engine);
         if (status.total_tracks <= 0) {
-            fprintf(stderr, "No MP3 files found in directory: %s\n", argv[1]);
+            fprintf(stderr, "No MP3 or WAV files found in directory: %s\n", argv[1]);
             rhythm_engine_destroy(engine);
             return 1;
         }
-        printf("Found %d MP3 files in directory\n", status.total_tracks);
+        printf("Found %d audio files in directory\n", status.total_tracks);
+        fflush(stdout);
         sleep(1);
     } else {
-        if (!is_mp3_file(argv[1])) {
-            fprintf(stderr, "File is not an MP3: %s\n", argv[1]);
+        if (!is_audio_file(source) && !stream_source_is_stream(source)) {
+            fprintf(stderr, "File is not an MP3 or WAV file: %s\n", argv[1]);
             rhythm_engine_destroy(engine);
             return 1;
         }
 
-        result = rhythm_engine_load_file(engine, argv[1]);
+        result = rhythm_engine_load_file(engine, source);
         if (result != RHYTHM_OK) {
             fprintf(stderr, "Failed to load file: %s - %s\n", argv[1], rhythm_engine_error_string(result));
             rhythm_engine_destroy(engine);
@@ -74,7 +115,9 @@ int main(int argc, char *argv[]) {
 
     cli_init();
 
-    result = rhythm_engine_play(engine);
+    // a restored session that was playing is already going, from where it stopped
+    RhythmStatus initial = rhythm_engine_get_status(engine);
+    result = initial.state == PLAYER_STATE_PLAYING ? RHYTHM_OK : rhythm_engine_play(engine);
     if (result != RHYTHM_OK) {
         fprintf(stderr, "Failed to start playback: %s\n", rhythm_engine_error_string(result));
         rhythm_engine_destroy(engine);
@@ -82,10 +125,42 @@ int main(int argc, char *argv[]) {
     }
 
     while (1) {
+        rhythm_engine_set_interactive(engine, cli_attended());
         rhythm_engine_update(engine);
         RhythmStatus status = rhythm_engine_get_status(engine);
 
         cli_display_status(&status);
+
+        RhythmLoudnessScanStatus scan;
+        RhythmTrackLoudness loudness;
+        rhythm_engine_get_loudness_scan_status(engine, &scan);
+        rhythm_engine_get_track_loudness(engine, &loudness);
+        cli_display_loudness(&scan, &loudness);
+
+        if (cli_stats_visible()) {
+            RhythmStats stats;
+            RhythmAudioInfo info;
+            RhythmRealtimeStatus realtime;
+            RhythmPrefetchStats prefetch;
+            RhythmPcmCacheStats pcm;
+            if (rhythm_engine_get_stats(engine, &stats) == RHYTHM_OK &&
+                rhythm_engine_get_audio_info(engine, &info) == RHYTHM_OK &&
+                rhythm_engine_get_realtime_status(engine, &realtime) == RHYTHM_OK &&
+                rhythm_engine_get_prefetch_stats(engine, &prefetch) == RHYTHM_OK &&
+                rhythm_engine_get_pcm_cache_stats(engine, &pcm) == RHYTHM_OK) {
+                cli_display_stats(&stats, &info, &realtime, &prefetch, &pcm);
+            }
+        }
+        cli_display_playlist(engine);
+        cli_present();
+
+        // ticks stretch in low power, but still land on the end of the track
+        int wait_ms = cli_frame_interval_ms(rhythm_engine_get_tick_interval_ms(engine));
+        if (status.state == PLAYER_STATE_PLAYING && status.duration_known && status.total_time > 0) {
+            int until_end_ms = (int)((0.999f - status.progress) * status.total_time * 1000.0f) + 1;
+            if (until_end_ms > 0 && until_end_ms < wait_ms) wait_ms = until_end_ms;
+        }
+        cli_wait_for_input(wait_ms);
         int input_result = cli_handle_input(engine);
 
         if (input_result == 2) {
@@ -104,8 +179,6 @@ int main(int argc, char *argv[]) {
                 rhythm_engine_next_track(engine);
             }
         }
-
-        usleep(100000);
     }
 
     rhythm_engine_destroy(engine);
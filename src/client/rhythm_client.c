@@ -0,0 +1,183 @@
+#include "client/rhythm_client.h"
+#include "core/log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define CLIENT_READ_ATTEMPTS 64
+#define CLIENT_WAIT_POLL_US 500
+
+struct RhythmClient {
+    EngineShm* shm;
+    EngineShmWaveform waveform;         // scratch copy, too large for the stack of a GUI thread
+};
+
+RhythmClient* rhythm_client_connect(const char* name) {
+    if (!name) name = getenv(ENGINE_SHM_ENV);
+    if (!name || !name[0]) return NULL;
+
+    int fd = shm_open(name, O_RDWR, 0);
+    if (fd < 0) {
+        LOG_ERROR("Failed to open engine host %s: %s", name, strerror(errno));
+        return NULL;
+    }
+
+    struct stat st;
+    EngineShm* shm = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(EngineShm)) {
+        shm = mmap(NULL, sizeof(EngineShm), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (shm == MAP_FAILED) {
+        LOG_ERROR("Engine host %s has an unexpected layout", name);
+        return NULL;
+    }
+
+    if (shm->magic != ENGINE_SHM_MAGIC || shm->version != ENGINE_SHM_VERSION) {
+        LOG_WARN("Engine host %s is not ready or has another version", name);
+        munmap(shm, sizeof(EngineShm));
+        return NULL;
+    }
+    atomic_thread_fence(memory_order_acquire);
+
+    RhythmClient* client = calloc(1, sizeof(RhythmClient));
+    if (!client) {
+        munmap(shm, sizeof(EngineShm));
+        return NULL;
+    }
+    client->shm = shm;
+    return client;
+}
+
+void rhythm_client_disconnect(RhythmClient* client) {
+    if (!client) return;
+    munmap(client->shm, sizeof(EngineShm));
+    free(client);
+}
+
+bool rhythm_client_host_alive(RhythmClient* client) {
+    if (!client || client->shm->magic != ENGINE_SHM_MAGIC) return false;
+    return kill((pid_t)client->shm->host_pid, 0) == 0 || errno == EPERM;
+}
+
+// sequence-lock read: retried while the host is mid-publish, never blocks it
+static bool read_published(EngineShm* shm, void* dest, const void* src, size_t size) {
+    for (int attempt = 0; attempt < CLIENT_READ_ATTEMPTS; attempt++) {
+        unsigned seq = atomic_load_explicit(&shm->sequence, memory_order_acquire);
+        if (seq & 1) {
+            sched_yield();
+            continue;
+        }
+        memcpy(dest, src, size);
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&shm->sequence, memory_order_relaxed) == seq) return true;
+    }
+    return false;
+}
+
+RhythmError rhythm_client_get_status_frame(RhythmClient* client, RhythmStatusFrame* frame) {
+    if (!client || !frame) return RHYTHM_ERROR_NULL_POINTER;
+    if (!read_published(client->shm, frame, &client->shm->frame, sizeof(RhythmStatusFrame))) {
+        return RHYTHM_ERROR_INVALID_STATE;
+    }
+    return RHYTHM_OK;
+}
+
+size_t rhythm_client_status_frame_size(void) {
+    return sizeof(RhythmStatusFrame);
+}
+
+RhythmError rhythm_client_get_eq(RhythmClient* client, RhythmEqualizer* eq) {
+    if (!client || !eq) return RHYTHM_ERROR_NULL_POINTER;
+    if (!read_published(client->shm, eq, &client->shm->eq, sizeof(RhythmEqualizer))) {
+        return RHYTHM_ERROR_INVALID_STATE;
+    }
+    return RHYTHM_OK;
+}
+
+RhythmError rhythm_client_get_waveform(RhythmClient* client, float start, float end,
+                                       RhythmWaveformBucket* buckets, int count, float* ready) {
+    if (!client || !buckets) return RHYTHM_ERROR_NULL_POINTER;
+    if (ready) *ready = 0.0f;
+    if (count <= 0 || start < 0.0f || end > 1.0f || end <= start) return RHYTHM_ERROR_INVALID_STATE;
+
+    EngineShmWaveform* overview = &client->waveform;
+    if (!read_published(client->shm, overview, &client->shm->waveform, sizeof(EngineShmWaveform))) {
+        return RHYTHM_ERROR_INVALID_STATE;
+    }
+    if (ready) *ready = overview->ready;
+
+    const int bins = ENGINE_SHM_WAVEFORM_BUCKETS;
+    for (int b = 0; b < count; b++) {
+        int first = (int)((start + (end - start) * b / count) * bins);
+        int last = (int)((start + (end - start) * (b + 1) / count) * bins);
+        if (first >= bins) first = bins - 1;
+        if (last <= first) last = first + 1;
+
+        RhythmWaveformBucket bucket = overview->buckets[first];
+        float square_sum = bucket.rms * bucket.rms;
+        for (int i = first + 1; i < last; i++) {
+            const RhythmWaveformBucket* bin = &overview->buckets[i];
+            if (bin->min < bucket.min) bucket.min = bin->min;
+            if (bin->max > bucket.max) bucket.max = bin->max;
+            square_sum += bin->rms * bin->rms;
+        }
+        bucket.rms = sqrtf(square_sum / (last - first));
+        buckets[b] = bucket;
+    }
+    return RHYTHM_OK;
+}
+
+int64_t rhythm_client_send(RhythmClient* client, int type, int index, float value, const char* path) {
+    if (!client) return -1;
+    if (path && strlen(path) >= ENGINE_SHM_PATH_MAX) return -1;
+
+    EngineShm* shm = client->shm;
+    unsigned write = atomic_load_explicit(&shm->command_write, memory_order_relaxed);
+    unsigned read = atomic_load_explicit(&shm->command_read, memory_order_acquire);
+    if (write - read >= ENGINE_SHM_COMMANDS) return -1;
+
+    EngineCommand* command = &shm->commands[write & (ENGINE_SHM_COMMANDS - 1)];
+    command->type = type;
+    command->index = index;
+    command->value = value;
+    command->result = RHYTHM_OK;
+    snprintf(command->path, sizeof(command->path), "%s", path ? path : "");
+
+    atomic_store_explicit(&shm->command_write, write + 1, memory_order_release);
+    sem_post(&shm->command_wake);
+    return write;
+}
+
+RhythmError rhythm_client_wait(RhythmClient* client, int64_t ticket, int timeout_ms) {
+    if (!client) return RHYTHM_ERROR_NULL_POINTER;
+    if (ticket < 0) return RHYTHM_ERROR_INVALID_STATE;
+
+    EngineShm* shm = client->shm;
+    unsigned target = (unsigned)ticket;
+    for (long waited_us = 0; ; waited_us += CLIENT_WAIT_POLL_US) {
+        unsigned read = atomic_load_explicit(&shm->command_read, memory_order_acquire);
+        if ((int)(read - target) > 0) {
+            return (RhythmError)shm->commands[target & (ENGINE_SHM_COMMANDS - 1)].result;
+        }
+        if (waited_us >= (long)timeout_ms * 1000 || !rhythm_client_host_alive(client)) {
+            return RHYTHM_ERROR_INVALID_STATE;
+        }
+        usleep(CLIENT_WAIT_POLL_US);
+    }
+}
+
+RhythmError rhythm_client_call(RhythmClient* client, int type, int index, float value,
+                               const char* path, int timeout_ms) {
+    int64_t ticket = rhythm_client_send(client, type, index, value, path);
+    if (ticket < 0) return client ? RHYTHM_ERROR_INVALID_STATE : RHYTHM_ERROR_NULL_POINTER;
+    return rhythm_client_wait(client, ticket, timeout_ms);
+}
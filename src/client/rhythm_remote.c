@@ -0,0 +1,213 @@
+#include "client/rhythm_remote.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define REMOTE_INPUT_BYTES (16 * 1024)
+
+struct RhythmRemote {
+    int fd;
+    uint32_t next_id;
+    uint8_t input[REMOTE_INPUT_BYTES];
+    size_t input_start;
+    size_t input_end;
+};
+
+void rhythm_remote_default_path(char* path, size_t size) {
+    const char* configured = getenv(RHYTHM_SOCKET_ENV);
+    const char* runtime_dir = getenv("XDG_RUNTIME_DIR");
+    if (configured && configured[0]) {
+        snprintf(path, size, "%s", configured);
+    } else if (runtime_dir && runtime_dir[0]) {
+        snprintf(path, size, "%s/rhythmd.sock", runtime_dir);
+    } else {
+        snprintf(path, size, "/tmp/rhythmd-%d.sock", (int)getuid());
+    }
+}
+
+RhythmRemote* rhythm_remote_connect(const char* socket_path) {
+    char default_path[sizeof(((struct sockaddr_un*)0)->sun_path)];
+    if (!socket_path) {
+        rhythm_remote_default_path(default_path, sizeof(default_path));
+        socket_path = default_path;
+    }
+
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(socket_path) >= sizeof(address.sun_path)) return NULL;
+    strcpy(address.sun_path, socket_path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return NULL;
+    if (connect(fd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+        close(fd);
+        return NULL;
+    }
+
+    RhythmRemote* remote = calloc(1, sizeof(RhythmRemote));
+    if (!remote) {
+        close(fd);
+        return NULL;
+    }
+    remote->fd = fd;
+    remote->next_id = 1;
+    return remote;
+}
+
+void rhythm_remote_close(RhythmRemote* remote) {
+    if (!remote) return;
+    close(remote->fd);
+    free(remote);
+}
+
+static bool write_all(int fd, const uint8_t* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = send(fd, data, size, MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += written;
+        size -= (size_t)written;
+    }
+    return true;
+}
+
+int64_t rhythm_remote_send(RhythmRemote* remote, int type, const void* payload, uint32_t length) {
+    if (!remote || length > RHYTHM_PROTOCOL_MAX_PAYLOAD) return -1;
+
+    // header and payload go out in one write
+    uint8_t message[sizeof(RhythmMessageHeader) + RHYTHM_PROTOCOL_MAX_PAYLOAD];
+    uint32_t id = remote->next_id++;
+    if (remote->next_id == 0) remote->next_id = 1;
+
+    RhythmMessageHeader header = {.length = length, .type = (uint16_t)type, .version = RHYTHM_PROTOCOL_VERSION, .id = id};
+    memcpy(message, &header, sizeof(header));
+    if (length > 0) memcpy(message + sizeof(header), payload, length);
+
+    if (!write_all(remote->fd, message, sizeof(header) + length)) return -1;
+    return id;
+}
+
+int64_t rhythm_remote_send_command(RhythmRemote* remote, int command, int index, float value, const char* path) {
+    uint8_t payload[RHYTHM_PROTOCOL_MAX_PAYLOAD];
+    RhythmCommandMessage message = {.command = command, .index = index, .value = value};
+    size_t path_length = path ? strlen(path) : 0;
+    if (path_length >= ENGINE_SHM_PATH_MAX) return -1;
+
+    memcpy(payload, &message, sizeof(message));
+    if (path_length > 0) memcpy(payload + sizeof(message), path, path_length);
+    return rhythm_remote_send(remote, RHYTHM_MSG_COMMAND, payload, (uint32_t)(sizeof(message) + path_length));
+}
+
+// 1 when a whole message was taken from the buffer, 0 when more bytes are needed
+static int take_message(RhythmRemote* remote, RhythmMessage* message) {
+    size_t available = remote->input_end - remote->input_start;
+    if (available < sizeof(RhythmMessageHeader)) return 0;
+
+    RhythmMessageHeader header;
+    memcpy(&header, remote->input + remote->input_start, sizeof(header));
+    if (header.version != RHYTHM_PROTOCOL_VERSION || header.length > RHYTHM_PROTOCOL_MAX_PAYLOAD) return -1;
+    if (available < sizeof(header) + header.length) return 0;
+
+    message->header = header;
+    memcpy(message->payload.bytes, remote->input + remote->input_start + sizeof(header), header.length);
+    remote->input_start += sizeof(header) + header.length;
+    return 1;
+}
+
+static long long now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+int rhythm_remote_receive(RhythmRemote* remote, RhythmMessage* message, int timeout_ms) {
+    if (!remote || !message) return -1;
+    long long deadline = now_ms() + timeout_ms;
+
+    for (;;) {
+        int taken = take_message(remote, message);
+        if (taken != 0) return taken;
+
+        if (remote->input_start > 0) {
+            memmove(remote->input, remote->input + remote->input_start, remote->input_end - remote->input_start);
+            remote->input_end -= remote->input_start;
+            remote->input_start = 0;
+        }
+
+        int wait_ms = -1;
+        if (timeout_ms >= 0) {
+            long long left = deadline - now_ms();
+            wait_ms = left > 0 ? (int)left : 0;
+        }
+        struct pollfd poll_fd = {.fd = remote->fd, .events = POLLIN};
+        int ready = poll(&poll_fd, 1, wait_ms);
+        if (ready < 0 && errno == EINTR) continue;
+        if (ready < 0) return -1;
+        if (ready == 0) return 0;
+
+        ssize_t count = read(remote->fd, remote->input + remote->input_end, sizeof(remote->input) - remote->input_end);
+        if (count < 0 && errno == EINTR) continue;
+        if (count <= 0) return -1;
+        remote->input_end += (size_t)count;
+    }
+}
+
+// waits for the reply to id, skipping stream messages
+static int await_reply(RhythmRemote* remote, int64_t id, RhythmMessage* message, int timeout_ms) {
+    if (id < 0) return -1;
+    long long deadline = now_ms() + timeout_ms;
+    for (;;) {
+        long long left = deadline - now_ms();
+        int received = rhythm_remote_receive(remote, message, timeout_ms < 0 ? -1 : (left > 0 ? (int)left : 0));
+        if (received <= 0) return received;
+        if (message->header.id == (uint32_t)id) return 1;
+    }
+}
+
+static RhythmError result_of(RhythmRemote* remote, int64_t id, int timeout_ms) {
+    RhythmMessage message;
+    if (await_reply(remote, id, &message, timeout_ms) != 1 || message.header.type != RHYTHM_MSG_RESULT) {
+        return RHYTHM_ERROR_INVALID_STATE;
+    }
+    return (RhythmError)message.payload.result.result;
+}
+
+RhythmError rhythm_remote_ping(RhythmRemote* remote, int timeout_ms) {
+    if (!remote) return RHYTHM_ERROR_NULL_POINTER;
+    return result_of(remote, rhythm_remote_send(remote, RHYTHM_MSG_PING, NULL, 0), timeout_ms);
+}
+
+RhythmError rhythm_remote_command(RhythmRemote* remote, int command, int index, float value,
+                                  const char* path, int timeout_ms) {
+    if (!remote) return RHYTHM_ERROR_NULL_POINTER;
+    return result_of(remote, rhythm_remote_send_command(remote, command, index, value, path), timeout_ms);
+}
+
+RhythmError rhythm_remote_get_status(RhythmRemote* remote, RhythmStatusFrame* frame, int timeout_ms) {
+    if (!remote || !frame) return RHYTHM_ERROR_NULL_POINTER;
+
+    RhythmMessage message;
+    int64_t id = rhythm_remote_send(remote, RHYTHM_MSG_GET_STATUS, NULL, 0);
+    if (await_reply(remote, id, &message, timeout_ms) != 1 || message.header.type != RHYTHM_MSG_STATUS ||
+        message.header.length != sizeof(RhythmStatusFrame)) {
+        return RHYTHM_ERROR_INVALID_STATE;
+    }
+    *frame = message.payload.status;
+    frame->status.current_file = NULL;
+    return RHYTHM_OK;
+}
+
+RhythmError rhythm_remote_subscribe(RhythmRemote* remote, uint32_t mask, int timeout_ms) {
+    if (!remote) return RHYTHM_ERROR_NULL_POINTER;
+    RhythmSubscribeMessage subscribe = {.mask = mask};
+    return result_of(remote, rhythm_remote_send(remote, RHYTHM_MSG_SUBSCRIBE, &subscribe, sizeof(subscribe)), timeout_ms);
+}
@@ -0,0 +1,82 @@
+#include "core/audio_context.h"
+#include "core/log.h"
+#include <portaudio.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+static pthread_mutex_t context_lock = PTHREAD_MUTEX_INITIALIZER;
+static int portaudio_users;
+static int pool_users;
+static DecoderPool *shared_pool;
+static int pcm_cache_users;
+static PcmCache *shared_pcm_cache;
+
+int audio_context_acquire_portaudio(void) {
+    pthread_mutex_lock(&context_lock);
+    if (portaudio_users == 0) {
+        PaError err = Pa_Initialize();
+        if (err != paNoError) {
+            pthread_mutex_unlock(&context_lock);
+            LOG_ERROR("Failed to initialize PortAudio: %s", Pa_GetErrorText(err));
+            return -1;
+        }
+    }
+    portaudio_users++;
+    pthread_mutex_unlock(&context_lock);
+    return 0;
+}
+
+void audio_context_release_portaudio(void) {
+    pthread_mutex_lock(&context_lock);
+    if (portaudio_users > 0 && --portaudio_users == 0) {
+        Pa_Terminate();
+    }
+    pthread_mutex_unlock(&context_lock);
+}
+
+DecoderPool *audio_context_acquire_pool(void) {
+    pthread_mutex_lock(&context_lock);
+    if (pool_users == 0) {
+        const char *threads = getenv("RHYTHM_DECODER_THREADS");
+        shared_pool = decoder_pool_create(threads && *threads ? atoi(threads) : 0);
+    }
+    DecoderPool *pool = shared_pool;
+    if (pool) pool_users++;
+    pthread_mutex_unlock(&context_lock);
+    return pool;
+}
+
+void audio_context_release_pool(void) {
+    pthread_mutex_lock(&context_lock);
+    if (pool_users > 0 && --pool_users == 0) {
+        decoder_pool_destroy(shared_pool);
+        shared_pool = NULL;
+    }
+    pthread_mutex_unlock(&context_lock);
+}
+
+PcmCache *audio_context_acquire_pcm_cache(void) {
+    pthread_mutex_lock(&context_lock);
+    if (pcm_cache_users == 0) {
+        const char *megabytes = getenv("RHYTHM_PCM_CACHE_MB");
+        const char *pack = getenv("RHYTHM_PCM_CACHE_PACK");
+        size_t budget = PCM_CACHE_DEFAULT_BUDGET;
+        if (megabytes && atoi(megabytes) >= 0) budget = (size_t)atoi(megabytes) * 1024 * 1024;
+        shared_pcm_cache = pcm_cache_create(budget, pack && strcmp(pack, "1") == 0);
+    }
+    PcmCache *cache = shared_pcm_cache;
+    if (cache) pcm_cache_users++;
+    pthread_mutex_unlock(&context_lock);
+    return cache;
+}
+
+void audio_context_release_pcm_cache(void) {
+    pthread_mutex_lock(&context_lock);
+    if (pcm_cache_users > 0 && --pcm_cache_users == 0) {
+        pcm_cache_destroy(shared_pcm_cache);
+        shared_pcm_cache = NULL;
+    }
+    pthread_mutex_unlock(&context_lock);
+}
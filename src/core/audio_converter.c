@@ -71,4 +71,96 @@ void resample_audio(float *input, float *output, int input_samples, int output_s
             }
         }
     }
-} 
\ No newline at end of file
+} 
+
+void apply_volume(float *samples, int num_samples, float volume) {
+    for (int i = 0; i < num_samples; i++) {
+        float sample = samples[i] * volume;
+        if (sample > 1.0f) sample = 1.0f;
+        if (sample < -1.0f) sample = -1.0f;
+        samples[i] = sample;
+    }
+}
+
+void compute_vis_bands(const float *samples, int num_samples, float *bands, int num_bands) {
+    int samples_per_band = num_samples / num_bands;
+    for (int b = 0; b < num_bands; b++) {
+        float sum = 0.0f;
+        int start = b * samples_per_band;
+        int end = (b == num_bands - 1) ? num_samples : (b + 1) * samples_per_band;
+        for (int i = start; i < end; i++) {
+            sum += samples[i] * samples[i];
+        }
+        int count = end - start;
+        bands[b] = count > 0 ? sqrtf(sum / count) : 0.0f;
+    }
+}
+
+static void remap_mono_to_stereo(const float *input, float *output, int frames) {
+    for (int i = 0; i < frames; i++) {
+        output[i * 2] = input[i];
+        output[i * 2 + 1] = input[i];
+    }
+}
+
+static void remap_stereo_to_mono(const float *input, float *output, int frames) {
+    for (int i = 0; i < frames; i++) {
+        output[i] = (input[i * 2] + input[i * 2 + 1]) * 0.5f;
+    }
+}
+
+// same interpolation as resample_audio with the channel loop unrolled and the end-of-input
+// check moved out of the main loop
+#define DEFINE_RESAMPLE_KERNEL(CH) \
+    static void resample_linear_##CH(const float *input, float *output, int input_frames, int output_frames) { \
+        float ratio = (float)input_frames / output_frames; \
+        int i = 0; \
+        for (; i < output_frames; i++) { \
+            float pos = i * ratio; \
+            int pos0 = (int)pos; \
+            if (pos0 + 1 >= input_frames) break; \
+            float frac = pos - pos0; \
+            for (int ch = 0; ch < (CH); ch++) { \
+                float sample0 = input[pos0 * (CH) + ch]; \
+                float sample1 = input[(pos0 + 1) * (CH) + ch]; \
+                output[i * (CH) + ch] = sample0 + (sample1 - sample0) * frac; \
+            } \
+        } \
+        for (; i < output_frames; i++) { \
+            int pos0 = (int)(i * ratio); \
+            for (int ch = 0; ch < (CH); ch++) { \
+                output[i * (CH) + ch] = input[pos0 * (CH) + ch]; \
+            } \
+        } \
+    }
+
+DEFINE_RESAMPLE_KERNEL(1)
+DEFINE_RESAMPLE_KERNEL(2)
+
+int conversion_plan_init(ConversionPlan *plan, long in_rate, int in_channels, long out_rate, int out_channels,
+                         size_t chunk_frames) {
+    if (!plan || in_rate <= 0 || out_rate <= 0) return -1;
+
+    memset(plan, 0, sizeof(ConversionPlan));
+    plan->in_rate = in_rate;
+    plan->in_channels = in_channels;
+    plan->out_rate = out_rate;
+    plan->out_channels = out_channels;
+
+    if (in_channels == 1 && out_channels == 2) {
+        plan->remap = remap_mono_to_stereo;
+    } else if (in_channels == 2 && out_channels == 1) {
+        plan->remap = remap_stereo_to_mono;
+    } else if (in_channels != out_channels) {
+        return -1;
+    }
+
+    if (in_rate != out_rate) {
+        plan->resample = out_channels == 1 ? resample_linear_1 : out_channels == 2 ? resample_linear_2 : NULL;
+        if (!plan->resample) return -1;
+    }
+
+    plan->passthrough = !plan->remap && !plan->resample;
+    plan->max_out_samples = ((size_t)((long long)chunk_frames * out_rate / in_rate) + 2) * (size_t)out_channels;
+    return 0;
+}
@@ -0,0 +1,524 @@
+#include "core/audio_features.h"
+#include "core/ring_buffer.h"
+#include "core/trace.h"
+#include "core/log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#define FEATURE_WINDOW 1024
+#define FEATURE_HOP 512
+#define FEATURE_BINS (FEATURE_WINDOW / 2)
+#define FEATURE_RING_SAMPLES 65536
+#define FEATURE_PUSH_CHUNK 512
+#define FEATURE_HISTORY 512             // onset envelope hops, ~5.5 s at 48 kHz
+#define FEATURE_TEMPO_INTERVAL 32       // hops between tempo and phase updates
+#define FEATURE_TEMPO_MIN_HOPS 256
+#define FEATURE_PHASE_BEATS 8
+#define FEATURE_MIN_BPM 60.0
+#define FEATURE_MAX_BPM 200.0
+#define FEATURE_PREFERRED_BPM 120.0
+#define FEATURE_TEMPO_TOLERANCE 0.04f
+#define FEATURE_TEMPO_SWITCH_HITS 3
+#define FEATURE_ONSET_AVERAGE 16
+#define FEATURE_ONSET_FLOOR 0.01f
+#define FEATURE_ONSET_DECAY 0.85f
+#define FEATURE_REFRACTORY_S 0.1
+#define FEATURE_PEAK_DECAY_S 10.0
+#define FEATURE_LEVEL_FLOOR 1e-3f
+
+typedef struct {
+    double origin;              // frame of one beat, counted like pushed_frames
+    double period;              // frames per beat, 0 without a tempo
+    long long base_count;       // beats before origin
+} BeatGrid;
+
+struct FeatureAnalyzer {
+    RingBuffer *ring;           // mono, audio thread to analysis thread
+    atomic_llong pushed_frames;
+    atomic_llong dropped_frames;
+    atomic_llong consumed_frames;
+    atomic_int sample_rate;
+    atomic_uint reset_generation;
+    atomic_bool running;
+    pthread_t thread;
+    bool thread_started;
+
+    // analysis thread only
+    int rate;
+    unsigned seen_generation;
+    long long seen_dropped;
+    long long position;         // frames consumed so far, dropped ones included
+    float window[FEATURE_WINDOW];
+    int fill;
+    float hann[FEATURE_WINDOW];
+    float cos_table[FEATURE_WINDOW / 2];
+    float sin_table[FEATURE_WINDOW / 2];
+    float re[FEATURE_WINDOW];
+    float im[FEATURE_WINDOW];
+    float previous_log[FEATURE_BINS + 1];
+    float envelope[FEATURE_HISTORY];
+    long long hops;
+    long long last_onset_hop;
+    float flux_peak;
+    float band_peak[3];
+    float pending_bpm;
+    int pending_hits;
+    AudioFeatures current;
+    BeatGrid grid;
+
+    // published for the control thread
+    pthread_mutex_t lock;
+    AudioFeatures published;
+    BeatGrid published_grid;
+};
+
+static void fft(FeatureAnalyzer *analyzer) {
+    float *re = analyzer->re;
+    float *im = analyzer->im;
+
+    for (int i = 1, j = 0; i < FEATURE_WINDOW; i++) {
+        int bit = FEATURE_WINDOW >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if (i < j) {
+            float t = re[i]; re[i] = re[j]; re[j] = t;
+            t = im[i]; im[i] = im[j]; im[j] = t;
+        }
+    }
+
+    for (int len = 2; len <= FEATURE_WINDOW; len <<= 1) {
+        int half = len >> 1;
+        int step = FEATURE_WINDOW / len;
+        for (int i = 0; i < FEATURE_WINDOW; i += len) {
+            for (int k = 0; k < half; k++) {
+                float wr = analyzer->cos_table[k * step];
+                float wi = -analyzer->sin_table[k * step];
+                int a = i + k, b = a + half;
+                float tr = re[b] * wr - im[b] * wi;
+                float ti = re[b] * wi + im[b] * wr;
+                re[b] = re[a] - tr;
+                im[b] = im[a] - ti;
+                re[a] += tr;
+                im[a] += ti;
+            }
+        }
+    }
+}
+
+static float envelope_at(FeatureAnalyzer *analyzer, long long hop) {
+    return analyzer->envelope[hop % FEATURE_HISTORY];
+}
+
+static void clear_state(FeatureAnalyzer *analyzer) {
+    memset(analyzer->window, 0, sizeof(analyzer->window));
+    memset(analyzer->previous_log, 0, sizeof(analyzer->previous_log));
+    memset(analyzer->envelope, 0, sizeof(analyzer->envelope));
+    memset(analyzer->band_peak, 0, sizeof(analyzer->band_peak));
+    memset(&analyzer->current, 0, sizeof(analyzer->current));
+    memset(&analyzer->grid, 0, sizeof(analyzer->grid));
+    analyzer->fill = 0;
+    analyzer->hops = 0;
+    analyzer->last_onset_hop = -FEATURE_HISTORY;
+    analyzer->flux_peak = 0.0f;
+    analyzer->pending_bpm = 0.0f;
+    analyzer->pending_hits = 0;
+}
+
+static void publish(FeatureAnalyzer *analyzer) {
+    pthread_mutex_lock(&analyzer->lock);
+    analyzer->published = analyzer->current;
+    analyzer->published_grid = analyzer->grid;
+    pthread_mutex_unlock(&analyzer->lock);
+}
+
+static void detect_onset(FeatureAnalyzer *analyzer, float decay) {
+    AudioFeatures *current = &analyzer->current;
+    current->onset *= FEATURE_ONSET_DECAY;
+    if (analyzer->hops < 3) return;
+
+    // peak picking one hop late: the candidate must beat both neighbours and a local average
+    long long candidate = analyzer->hops - 2;
+    float peak = envelope_at(analyzer, candidate);
+    float before = envelope_at(analyzer, candidate - 1);
+    float after = envelope_at(analyzer, candidate + 1);
+    analyzer->flux_peak = fmaxf(peak, analyzer->flux_peak * decay);
+
+    float sum = 0.0f;
+    int count = 0;
+    for (long long hop = candidate - 1; hop >= 0 && count < FEATURE_ONSET_AVERAGE; hop--, count++) {
+        sum += envelope_at(analyzer, hop);
+    }
+    float threshold = (count > 0 ? 1.5f * sum / count : 0.0f) + FEATURE_ONSET_FLOOR;
+
+    double hop_seconds = (double)FEATURE_HOP / analyzer->rate;
+    bool refractory = (candidate - analyzer->last_onset_hop) * hop_seconds < FEATURE_REFRACTORY_S;
+    if (peak > before && peak >= after && peak > threshold && !refractory) {
+        analyzer->last_onset_hop = candidate;
+        current->onset_count++;
+        float strength = analyzer->flux_peak > 0.0f ? peak / analyzer->flux_peak : 0.0f;
+        current->onset = fmaxf(current->onset, fminf(strength, 1.0f));
+    }
+}
+
+static void analyze_hop(FeatureAnalyzer *analyzer) {
+    for (int i = 0; i < FEATURE_WINDOW; i++) {
+        analyzer->re[i] = analyzer->window[i] * analyzer->hann[i];
+        analyzer->im[i] = 0.0f;
+    }
+    fft(analyzer);
+
+    float bin_hz = (float)analyzer->rate / FEATURE_WINDOW;
+    float flux = 0.0f, magnitude_sum = 0.0f, weighted_sum = 0.0f;
+    float band[3] = {0.0f, 0.0f, 0.0f};
+    for (int k = 1; k <= FEATURE_BINS; k++) {
+        float re = analyzer->re[k], im = analyzer->im[k];
+        float magnitude = sqrtf(re * re + im * im) * (4.0f / FEATURE_WINDOW);
+
+        // log compression keeps quiet passages from vanishing next to loud ones
+        float compressed = logf(1.0f + 100.0f * magnitude);
+        float rise = compressed - analyzer->previous_log[k];
+        if (rise > 0.0f) flux += rise;
+        analyzer->previous_log[k] = compressed;
+
+        float hz = k * bin_hz;
+        magnitude_sum += magnitude;
+        weighted_sum += hz * magnitude;
+        if (hz < 20.0f) continue;
+        if (hz < 250.0f) band[0] += magnitude * magnitude;
+        else if (hz < 4000.0f) band[1] += magnitude * magnitude;
+        else if (hz < 16000.0f) band[2] += magnitude * magnitude;
+    }
+
+    analyzer->envelope[analyzer->hops % FEATURE_HISTORY] = flux / FEATURE_BINS;
+    analyzer->hops++;
+
+    AudioFeatures *current = &analyzer->current;
+    float decay = (float)exp(-(double)FEATURE_HOP / analyzer->rate / FEATURE_PEAK_DECAY_S);
+    float *levels[3] = {&current->bass, &current->mid, &current->high};
+    for (int b = 0; b < 3; b++) {
+        float level = sqrtf(band[b]);
+        analyzer->band_peak[b] = fmaxf(fmaxf(level, analyzer->band_peak[b] * decay), FEATURE_LEVEL_FLOOR);
+        *levels[b] = level / analyzer->band_peak[b];
+    }
+    current->centroid_hz = magnitude_sum > 1e-6f ? weighted_sum / magnitude_sum : 0.0f;
+
+    detect_onset(analyzer, decay);
+}
+
+static void accept_tempo(FeatureAnalyzer *analyzer, float bpm) {
+    float current = analyzer->current.bpm;
+    if (current <= 0.0f) {
+        analyzer->current.bpm = bpm;
+        return;
+    }
+
+    // small drifts are smoothed in; a different tempo must repeat before it wins
+    if (fabsf(bpm - current) < current * FEATURE_TEMPO_TOLERANCE) {
+        analyzer->current.bpm = current + 0.25f * (bpm - current);
+        analyzer->pending_hits = 0;
+    } else if (analyzer->pending_hits > 0 &&
+               fabsf(bpm - analyzer->pending_bpm) < analyzer->pending_bpm * FEATURE_TEMPO_TOLERANCE) {
+        if (++analyzer->pending_hits >= FEATURE_TEMPO_SWITCH_HITS) {
+            analyzer->current.bpm = bpm;
+            analyzer->pending_hits = 0;
+        }
+    } else {
+        analyzer->pending_bpm = bpm;
+        analyzer->pending_hits = 1;
+    }
+}
+
+static float interpolate(const float *values, int count, double index) {
+    int i = (int)index;
+    double t = index - i;
+    if (i + 1 >= count) return values[count - 1];
+    return (float)(values[i] * (1.0 - t) + values[i + 1] * t);
+}
+
+static void update_grid(FeatureAnalyzer *analyzer, double beat_frame) {
+    BeatGrid *grid = &analyzer->grid;
+    double period = 60.0 * analyzer->rate / analyzer->current.bpm;
+    if (grid->period <= 0.0) {
+        grid->origin = beat_frame;
+        grid->period = period;
+        return;
+    }
+
+    // re-anchor on the newest beat of the old grid so a new period leaves past beats alone
+    double beats = floor((analyzer->position - grid->origin) / grid->period);
+    grid->origin += beats * grid->period;
+    grid->base_count += (long long)beats;
+
+    // half of the phase error per update keeps the visuals from jumping
+    double error = beat_frame - grid->origin;
+    error -= period * floor(error / period + 0.5);
+    grid->origin += 0.5 * error;
+    grid->period = period;
+}
+
+static void update_tempo(FeatureAnalyzer *analyzer) {
+    int n = analyzer->hops < FEATURE_HISTORY ? (int)analyzer->hops : FEATURE_HISTORY;
+    float e[FEATURE_HISTORY];
+    float r[FEATURE_HISTORY];
+
+    double mean = 0.0;
+    for (int i = 0; i < n; i++) {
+        e[i] = envelope_at(analyzer, analyzer->hops - n + i);
+        mean += e[i];
+    }
+    mean /= n;
+    for (int i = 0; i < n; i++) e[i] -= (float)mean;
+
+    double hop_rate = (double)analyzer->rate / FEATURE_HOP;
+    int min_lag = (int)floor(60.0 * hop_rate / FEATURE_MAX_BPM);
+    int max_lag = (int)ceil(60.0 * hop_rate / FEATURE_MIN_BPM);
+    if (min_lag < 1) min_lag = 1;
+    if (max_lag > n / 2) max_lag = n / 2;
+    if (max_lag <= min_lag + 1) return;
+
+    int last_lag = 2 * max_lag + 1 < n ? 2 * max_lag + 1 : n - 1;
+    for (int lag = 0; lag <= last_lag; lag++) {
+        double sum = 0.0;
+        for (int i = lag; i < n; i++) sum += (double)e[i] * e[i - lag];
+        r[lag] = (float)(sum / (n - lag));
+    }
+    if (r[0] <= 1e-12f) return;
+
+    // autocorrelation plus its second harmonic, weighted towards moderate tempi
+    float score[FEATURE_HISTORY];
+    int best = -1;
+    for (int lag = min_lag; lag <= max_lag; lag++) {
+        double octave = log2(60.0 * hop_rate / lag / FEATURE_PREFERRED_BPM);
+        double weight = exp(-0.5 * octave * octave / 0.81);
+        double value = r[lag] + (2 * lag <= last_lag ? 0.5 * r[2 * lag] : 0.0);
+        score[lag] = (float)(weight * value);
+        if (best < 0 || score[lag] > score[best]) best = lag;
+    }
+    if (best < 0 || score[best] <= 0.0f) return;
+
+    double lag = best;
+    if (best > min_lag && best < max_lag) {
+        double left = score[best - 1], centre = score[best], right = score[best + 1];
+        double curvature = left - 2.0 * centre + right;
+        if (curvature < 0.0) lag += 0.5 * (left - right) / curvature;
+    }
+
+    float bpm = (float)(60.0 * hop_rate / lag);
+    if (bpm < FEATURE_MIN_BPM || bpm > FEATURE_MAX_BPM) return;
+    accept_tempo(analyzer, bpm);
+    analyzer->current.beat_confidence = fminf(fmaxf(r[best] / r[0], 0.0f), 1.0f);
+    if (analyzer->current.bpm <= 0.0f) return;
+
+    // comb search for the offset of the most recent beat
+    double period_hops = 60.0 * hop_rate / analyzer->current.bpm;
+    int offsets = (int)period_hops;
+    int beats = (int)((n - 1 - offsets) / period_hops) + 1;
+    if (beats > FEATURE_PHASE_BEATS) beats = FEATURE_PHASE_BEATS;
+    if (offsets < 1 || beats < 2) return;
+
+    int best_offset = 0;
+    float best_sum = -INFINITY;
+    for (int offset = 0; offset < offsets; offset++) {
+        float sum = 0.0f;
+        for (int k = 0; k < beats; k++) {
+            sum += interpolate(e, n, n - 1 - offset - k * period_hops);
+        }
+        if (sum > best_sum) {
+            best_sum = sum;
+            best_offset = offset;
+        }
+    }
+
+    // a transient peaks the flux roughly when it reaches the middle of the window
+    double beat_frame = (double)analyzer->position - (double)best_offset * FEATURE_HOP - FEATURE_WINDOW / 2;
+    update_grid(analyzer, beat_frame);
+}
+
+static void discard_pending(FeatureAnalyzer *analyzer) {
+    size_t got;
+    while ((got = ring_buffer_read(analyzer->ring, analyzer->window, FEATURE_WINDOW)) > 0) {
+        analyzer->position += (long long)got;
+    }
+}
+
+bool feature_analyzer_step(FeatureAnalyzer *analyzer) {
+    if (!analyzer) return false;
+
+    bool analysed = false;
+    unsigned generation = atomic_load(&analyzer->reset_generation);
+    int rate = atomic_load_explicit(&analyzer->sample_rate, memory_order_relaxed);
+    long long dropped = atomic_load(&analyzer->dropped_frames);
+    analyzer->position += dropped - analyzer->seen_dropped;
+    analyzer->seen_dropped = dropped;
+
+    if (generation != analyzer->seen_generation) {
+        analyzer->seen_generation = generation;
+        discard_pending(analyzer);
+        clear_state(analyzer);
+        publish(analyzer);
+    }
+    if (rate != analyzer->rate) {
+        analyzer->rate = rate;
+        clear_state(analyzer);
+        publish(analyzer);
+    }
+
+    if (analyzer->rate > 0 && ring_buffer_read_available(analyzer->ring) > 0) {
+        TRACE_SCOPE("feature_analysis");
+        analysed = true;
+        size_t got;
+        while ((got = ring_buffer_read(analyzer->ring, analyzer->window + analyzer->fill,
+                                       FEATURE_WINDOW - analyzer->fill)) > 0) {
+            analyzer->position += (long long)got;
+            analyzer->fill += (int)got;
+            if (analyzer->fill < FEATURE_WINDOW) continue;
+
+            analyze_hop(analyzer);
+            if (analyzer->hops >= FEATURE_TEMPO_MIN_HOPS && analyzer->hops % FEATURE_TEMPO_INTERVAL == 0) {
+                update_tempo(analyzer);
+            }
+            memmove(analyzer->window, analyzer->window + FEATURE_HOP,
+                    (FEATURE_WINDOW - FEATURE_HOP) * sizeof(float));
+            analyzer->fill = FEATURE_WINDOW - FEATURE_HOP;
+        }
+        publish(analyzer);
+    }
+    atomic_store_explicit(&analyzer->consumed_frames, analyzer->position, memory_order_release);
+
+    return analysed;
+}
+
+static void* analysis_thread_main(void *arg) {
+    FeatureAnalyzer *analyzer = arg;
+    TRACE_THREAD_NAME("analysis");
+
+    while (atomic_load_explicit(&analyzer->running, memory_order_relaxed)) {
+        feature_analyzer_step(analyzer);
+        usleep(FEATURE_POLL_MS * 1000);
+    }
+    return NULL;
+}
+
+FeatureAnalyzer* feature_analyzer_create(bool analysis_thread) {
+    FeatureAnalyzer *analyzer = calloc(1, sizeof(FeatureAnalyzer));
+    if (!analyzer) return NULL;
+
+    analyzer->ring = ring_buffer_create(FEATURE_RING_SAMPLES);
+    if (!analyzer->ring) {
+        free(analyzer);
+        return NULL;
+    }
+
+    for (int i = 0; i < FEATURE_WINDOW; i++) {
+        analyzer->hann[i] = 0.5f - 0.5f * cosf(2.0f * (float)M_PI * i / FEATURE_WINDOW);
+    }
+    for (int i = 0; i < FEATURE_WINDOW / 2; i++) {
+        analyzer->cos_table[i] = cosf(2.0f * (float)M_PI * i / FEATURE_WINDOW);
+        analyzer->sin_table[i] = sinf(2.0f * (float)M_PI * i / FEATURE_WINDOW);
+    }
+    clear_state(analyzer);
+
+    pthread_mutex_init(&analyzer->lock, NULL);
+    atomic_init(&analyzer->pushed_frames, 0);
+    atomic_init(&analyzer->dropped_frames, 0);
+    atomic_init(&analyzer->consumed_frames, 0);
+    atomic_init(&analyzer->sample_rate, 0);
+    atomic_init(&analyzer->reset_generation, 0);
+    atomic_init(&analyzer->running, true);
+    if (!analysis_thread) return analyzer;
+
+    if (pthread_create(&analyzer->thread, NULL, analysis_thread_main, analyzer) != 0) {
+        LOG_ERROR("Failed to start analysis thread");
+        feature_analyzer_destroy(analyzer);
+        return NULL;
+    }
+    analyzer->thread_started = true;
+    return analyzer;
+}
+
+void feature_analyzer_destroy(FeatureAnalyzer *analyzer) {
+    if (!analyzer) return;
+
+    if (analyzer->thread_started) {
+        atomic_store(&analyzer->running, false);
+        pthread_join(analyzer->thread, NULL);
+    }
+    ring_buffer_destroy(analyzer->ring);
+    pthread_mutex_destroy(&analyzer->lock);
+    free(analyzer);
+}
+
+void feature_analyzer_push(FeatureAnalyzer *analyzer, const float *samples, size_t frames,
+                           int channels, int sample_rate) {
+    if (!analyzer || !samples || channels < 1 || sample_rate <= 0) return;
+
+    if (atomic_load_explicit(&analyzer->sample_rate, memory_order_relaxed) != sample_rate) {
+        atomic_store_explicit(&analyzer->sample_rate, sample_rate, memory_order_relaxed);
+    }
+
+    if (ring_buffer_write_available(analyzer->ring) < frames) {
+        atomic_fetch_add_explicit(&analyzer->dropped_frames, (long long)frames, memory_order_relaxed);
+    } else {
+        float mono[FEATURE_PUSH_CHUNK];
+        float scale = 1.0f / channels;
+        for (size_t done = 0; done < frames; ) {
+            size_t count = frames - done < FEATURE_PUSH_CHUNK ? frames - done : FEATURE_PUSH_CHUNK;
+            const float *in = samples + done * channels;
+            for (size_t i = 0; i < count; i++) {
+                float sum = 0.0f;
+                for (int c = 0; c < channels; c++) sum += in[i * channels + c];
+                mono[i] = sum * scale;
+            }
+            ring_buffer_write(analyzer->ring, mono, count);
+            done += count;
+        }
+    }
+    atomic_fetch_add_explicit(&analyzer->pushed_frames, (long long)frames, memory_order_release);
+}
+
+void feature_analyzer_reset(FeatureAnalyzer *analyzer) {
+    if (!analyzer) return;
+
+    atomic_fetch_add(&analyzer->reset_generation, 1);
+    pthread_mutex_lock(&analyzer->lock);
+    memset(&analyzer->published, 0, sizeof(analyzer->published));
+    memset(&analyzer->published_grid, 0, sizeof(analyzer->published_grid));
+    pthread_mutex_unlock(&analyzer->lock);
+}
+
+void feature_analyzer_get(FeatureAnalyzer *analyzer, AudioFeatures *features, long long lag_frames) {
+    if (!features) return;
+    memset(features, 0, sizeof(AudioFeatures));
+    if (!analyzer) return;
+
+    pthread_mutex_lock(&analyzer->lock);
+    *features = analyzer->published;
+    BeatGrid grid = analyzer->published_grid;
+    pthread_mutex_unlock(&analyzer->lock);
+
+    if (grid.period > 0.0) {
+        double now = (double)(atomic_load(&analyzer->pushed_frames) - lag_frames);
+        double beats = (now - grid.origin) / grid.period;
+        double whole = floor(beats);
+        long long count = grid.base_count + (long long)whole;
+        features->beat_phase = (float)(beats - whole);
+        features->beat_count = count > 0 ? (uint32_t)count : 0;
+    }
+}
+
+int feature_analyzer_drain(FeatureAnalyzer *analyzer, int timeout_ms) {
+    if (!analyzer) return -1;
+
+    long long target = atomic_load_explicit(&analyzer->pushed_frames, memory_order_acquire);
+    for (int waited = 0; waited <= timeout_ms; waited++) {
+        if (atomic_load_explicit(&analyzer->consumed_frames, memory_order_acquire) >= target) return 0;
+        usleep(1000);
+    }
+    return -1;
+}
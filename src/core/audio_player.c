@@ -1,173 +1,280 @@
 #include "core/audio_player.h"
+#include "core/trace.h"
+#include "core/audio_context.h"
+#include "core/realtime.h"
+#include "core/log.h"
+#include <strings.h>
+#include <time.h>
 
 #define BUFFER_SIZE 16384
 #define DEFAULT_VOLUME 1.0f 
+#define DECODE_CHUNK_FRAMES 2048
+#define MAX_SOURCE_CHANNELS DECODER_MAX_CHANNELS
+#define DECODER_IDLE_WAIT_MS 20
+// low power: seconds of decode-ahead refilled in bursts, long device periods, lazy polling
+#define LOW_POWER_BUFFER_SIZE 262144
+#define LOW_POWER_PERIOD_FRAMES 4096
+#define LOW_POWER_POLL_MS 1000
+
+static int fill_output(AudioPlayer *player, float *out, unsigned long frames) {
+    int out_channels = player->channels;
+    int out_total = (int)frames * out_channels;
+
+    if (player->state != PLAYER_STATE_PLAYING) {
+        memset(out, 0, out_total * sizeof(float));
+        return paContinue;
+    }
+
+    audio_stats_record_ring_fill(&player->stats, ring_buffer_read_available(player->ring) / out_channels);
+
+    size_t got = ring_buffer_read(player->ring, out, out_total);
+    if (got < (size_t)out_total) {
+        memset(out + got, 0, (out_total - got) * sizeof(float));
+        if (atomic_load_explicit(&player->decoder_eof, memory_order_acquire)) {
+            if (got == 0) {
+                player->state = PLAYER_STATE_STOPPED;
+                return paComplete;
+            }
+        } else {
+            audio_stats_record_starved(&player->stats);
+        }
+    }
+
+    if (!atomic_load_explicit(&player->low_power, memory_order_relaxed)) {
+        decoder_pool_wake(player->decode_job);
+        decoder_pool_wake(player->mixer_job);
+    } else {
+        // the decoder sleeps until the deep ring is half drained, then refills it in one burst
+        size_t limit = (size_t)atomic_load_explicit(&player->ring_frames, memory_order_relaxed) * out_channels;
+        if (ring_buffer_read_available(player->ring) < limit / 2) {
+            decoder_pool_wake(player->decode_job);
+        }
+        if (mixer_has_voices(player->mixer)) decoder_pool_wake(player->mixer_job);
+    }
+
+    dsp_chain_process(player->dsp, out, frames, out_channels, player->sample_rate);
+    feature_analyzer_push(player->features, out, frames, out_channels, player->sample_rate);
+    apply_volume(out, out_total, player->volume * player->track_gain);
+    mixer_render(player->mixer, out, frames, out_channels, player->sample_rate, player->volume);
+    compute_vis_bands(out, out_total, player->vis_bands, 32);
+
+    return paContinue;
+}
+
+static int render_output(AudioPlayer *player, float *out, unsigned long frames, PaStreamCallbackFlags status_flags) {
+    TRACE_THREAD_NAME("audio");
+    realtime_register_thread(REALTIME_ROLE_AUDIO);
+    TRACE_SCOPE("audio_callback");
+    uint64_t start = audio_stats_begin_callback(&player->stats);
+    audio_stats_record_status_flags(&player->stats,
+                                    (status_flags & paOutputUnderflow) != 0,
+                                    (status_flags & paOutputOverflow) != 0);
+
+    int result = fill_output(player, out, frames);
+
+    uint64_t budget = player->sample_rate > 0 ? (uint64_t)frames * 1000000000ULL / player->sample_rate : 0;
+    audio_stats_end_callback(&player->stats, start, budget);
+    return result;
+}
 
 static int pa_callback(const void *inputBuffer, void *outputBuffer,
                       unsigned long framesPerBuffer,
                       const PaStreamCallbackTimeInfo *timeInfo,
                       PaStreamCallbackFlags statusFlags,
                       void *userData) {
-    AudioPlayer *player = (AudioPlayer *)userData;
-    float *out = (float *)outputBuffer;
-    int out_samples = framesPerBuffer;
-    int out_channels = CHANNELS;
-    int out_total = out_samples * out_channels;
+    (void)inputBuffer;
+    (void)timeInfo;
+    return render_output((AudioPlayer *)userData, (float *)outputBuffer, framesPerBuffer, statusFlags);
+}
 
-    if (player->state != PLAYER_STATE_PLAYING) {
-        memset(out, 0, out_total * sizeof(float));
-        return paContinue;
+static void jack_render(float *interleaved, unsigned long frames, void *user_data) {
+    render_output((AudioPlayer *)user_data, interleaved, frames, 0);
+}
+
+static void jack_format_changed(int sample_rate, int period_frames, void *user_data) {
+    AudioPlayer *player = (AudioPlayer *)user_data;
+    player->sample_rate = sample_rate;
+    player->frames_per_buffer = period_frames;
+    atomic_store_explicit(&player->plan_stale, true, memory_order_relaxed);
+}
+
+static int ensure_resample_capacity(AudioPlayer *player, size_t samples) {
+    if (samples <= player->resample_capacity) return 0;
+
+    float *buffer = realloc(player->resample_buffer, samples * sizeof(float));
+    if (!buffer) return -1;
+
+    player->resample_buffer = buffer;
+    player->resample_capacity = samples;
+    return 0;
+}
+
+// resolves the conversion for the current source and output formats and sizes the
+// resample buffer for it; called with decoder_lock held
+static int rebuild_plan(AudioPlayer *player) {
+    atomic_store_explicit(&player->plan_stale, false, memory_order_relaxed);
+    if (conversion_plan_init(&player->plan, player->source_rate, player->source_channels,
+                             player->sample_rate, player->channels, DECODE_CHUNK_FRAMES) != 0) {
+        return -1;
     }
+    player->resample_in_frames = 0;
+    player->resample_out_frames = 0;
+    return player->plan.resample ? ensure_resample_capacity(player, player->plan.max_out_samples) : 0;
+}
 
-    off_t current_pos = mpg123_tell(player->mh);
-    off_t total_length = mpg123_length(player->mh);
-    if (total_length > 0 && current_pos > 0) {
-        float position = (float)current_pos / (float)total_length;
-        if (position > 0.99f) {
+// samples the decoder may still queue: the ring is always low-power deep, but filled
+// only up to the current mode's limit
+static size_t ring_room(AudioPlayer *player, int out_channels) {
+    size_t limit = (size_t)atomic_load_explicit(&player->ring_frames, memory_order_relaxed) * out_channels;
+    size_t queued = ring_buffer_read_available(player->ring);
+    size_t room = queued < limit ? limit - queued : 0;
+    size_t available = ring_buffer_write_available(player->ring);
+    return room < available ? room : available;
+}
 
-            player->state = PLAYER_STATE_STOPPED;
-            memset(out, 0, out_total * sizeof(float));
-            return paComplete;
-        }
+// decodes one chunk into the ring; called with decoder_lock held
+static bool decode_step(AudioPlayer *player) {
+    if (!player->track_loaded || atomic_load(&player->decoder_eof)) return false;
+    TRACE_SCOPE("decoder_fill");
+
+    // the JACK server may have changed the output rate under us
+    if (atomic_load_explicit(&player->plan_stale, memory_order_relaxed) && rebuild_plan(player) != 0) {
+        atomic_store(&player->decoder_eof, true);
+        return false;
     }
 
-    int in_channels, encoding;
-    long in_rate;
-    mpg123_getformat(player->mh, &in_rate, &in_channels, &encoding);
+    const ConversionPlan *plan = &player->plan;
+    int out_channels = plan->out_channels;
+    size_t room = ring_room(player, out_channels);
+    if (room < plan->max_out_samples) {
+        return false;
+    }
 
-    int in_samples_needed = (int)((float)out_samples * ((float)in_rate / (float)SAMPLE_RATE)) + 4;
-    int in_total = in_samples_needed * in_channels;
+    // when no conversion is needed the decoder writes straight into the ring
+    float *target = player->decode_buffer;
+    size_t max_frames = DECODE_CHUNK_FRAMES;
+    if (plan->passthrough) {
+        size_t region = ring_buffer_write_region(player->ring, &target);
+        if (region > room) region = room;
+        if (region / out_channels < max_frames) max_frames = region / out_channels;
+    }
 
-    float *in_buffer = (float *)malloc(in_total * sizeof(float));
-    if (!in_buffer) {
-        fprintf(stderr, "Failed to allocate input buffer\n");
-        memset(out, 0, out_total * sizeof(float));
-        return paAbort;
-    }
-
-    size_t bytes_read = 0;
-    int samples_read = 0;
-    int max_attempts = 10;
-    int attempts = 0;
-    int consecutive_errors = 0;
-    while (samples_read < in_total && attempts < max_attempts) {
-        size_t got = 0;
-        int err = mpg123_read(player->mh, (unsigned char *)(in_buffer + samples_read), (in_total - samples_read) * sizeof(float), &got);
-        if (err == MPG123_DONE) {
-            player->state = PLAYER_STATE_STOPPED;
-            memset(out, 0, out_total * sizeof(float));
-            free(in_buffer);
-            return paComplete;
-        } else if (err != MPG123_OK) {
-            consecutive_errors++;
-
-            if (err == MPG123_NEED_MORE) {
-
-                memset(in_buffer + samples_read, 0, (in_total - samples_read) * sizeof(float));
-                samples_read = in_total;
-                break;
-            } else if (err == MPG123_NEW_FORMAT) {
-
-                continue;
-            } else {
-
-                off_t current_pos = mpg123_tell(player->mh);
-                off_t total_length = mpg123_length(player->mh);
-                bool near_end = false;
-
-                if (total_length > 0 && current_pos > 0) {
-                    float position = (float)current_pos / (float)total_length;
-                    near_end = (position > 0.98f);
-                }
-
-                if (near_end) {
-                    player->state = PLAYER_STATE_STOPPED;
-                    memset(out, 0, out_total * sizeof(float));
-                    free(in_buffer);
-                    return paComplete;
-                }
-
-                if (consecutive_errors == 1 || consecutive_errors % 100 == 0) {
-                    fprintf(stderr, "Error reading audio data: %s (error count: %d)\n", mpg123_strerror(player->mh), consecutive_errors);
-                }
-
-                if (consecutive_errors < 5) {
-                    memset(in_buffer + samples_read, 0, (in_total - samples_read) * sizeof(float));
-                    samples_read = in_total;
-                    break;
-                } else {
-
-                    memset(out, 0, out_total * sizeof(float));
-                    free(in_buffer);
-                    return paAbort;
-                }
-            }
-        } else {
-            consecutive_errors = 0; 
-        }
-        samples_read += got / sizeof(float);
-        attempts++;
+    if (player->decoder == player->stream_decoder) {
+        // what the ring still holds is part of the stream's jitter buffer
+        size_t queued = ring_buffer_read_available(player->ring) / out_channels;
+        stream_decoder_set_queued(player->decoder, queued * 1000.0f / plan->out_rate);
     }
 
-    float *ch_buffer = NULL;
-    if (in_channels != out_channels) {
-        ch_buffer = (float *)malloc(in_samples_needed * out_channels * sizeof(float));
-        if (!ch_buffer) {
-            free(in_buffer);
-            memset(out, 0, out_total * sizeof(float));
-            return paAbort;
+    size_t frames = 0;
+    DecoderStatus status = decoder_read(player->decoder, target, max_frames, &frames);
+    if (status == DECODER_NEW_FORMAT) {
+        player->source_rate = player->decoder->rate;
+        player->source_channels = player->decoder->channels;
+        if (rebuild_plan(player) != 0) {
+            LOG_ERROR("Unsupported stream format: %ld Hz, %d channels", player->source_rate, player->source_channels);
+            atomic_store(&player->decoder_eof, true);
+            return false;
+        }
+        return true;
+    } else if (status == DECODER_DONE) {
+        atomic_store(&player->decoder_eof, true);
+    } else if (status == DECODER_ERROR) {
+        player->consecutive_errors++;
+        if (player->consecutive_errors == 1 || player->consecutive_errors % 100 == 0) {
+            LOG_ERROR("Error reading audio data: %s (error count: %d)", decoder_error_string(player->decoder), player->consecutive_errors);
         }
-        convert_audio_format(in_buffer, ch_buffer, in_samples_needed, in_channels, out_channels);
+        if (player->consecutive_errors >= 5) {
+            atomic_store(&player->decoder_eof, true);
+            return false;
+        }
+        return true;
     } else {
-        ch_buffer = in_buffer;
+        player->consecutive_errors = 0;
     }
 
-    if (in_rate != SAMPLE_RATE) {
-        resample_audio(ch_buffer, out, in_samples_needed, out_samples, out_channels);
-    } else {
-        memcpy(out, ch_buffer, out_total * sizeof(float));
+    if (frames == 0) return false;
+
+    if (atomic_load_explicit(&player->start_requested_ns, memory_order_relaxed) != 0) {
+        uint64_t requested = atomic_exchange(&player->start_requested_ns, 0);
+        if (requested != 0) atomic_store(&player->first_sample_ns, audio_stats_now_ns() - requested);
     }
 
-    for (int i = 0; i < out_total; i++) {
-        float sample = out[i] * player->volume;
-        if (sample > 1.0f) sample = 1.0f;
-        if (sample < -1.0f) sample = -1.0f;
-        out[i] = sample;
+    if (plan->passthrough) {
+        ring_buffer_commit(player->ring, frames * out_channels);
+        player->resample_in_frames += frames;
+        player->resample_out_frames += frames;
+        atomic_fetch_add(&player->decoded_frames, (long long)frames);
+        return true;
     }
 
-    int bands = 32;
-    int samples_per_band = out_total / bands;
-    for (int b = 0; b < bands; b++) {
-        float sum = 0.0f;
-        int start = b * samples_per_band;
-        int end = (b == bands - 1) ? out_total : (b + 1) * samples_per_band;
-        for (int i = start; i < end; i++) {
-            sum += out[i] * out[i];
-        }
-        int count = end - start;
-        player->vis_bands[b] = count > 0 ? sqrtf(sum / count) : 0.0f;
+    float *samples = player->decode_buffer;
+    if (plan->remap) {
+        plan->remap(samples, player->convert_buffer, (int)frames);
+        samples = player->convert_buffer;
     }
 
-    if (ch_buffer != in_buffer) free(ch_buffer);
-    free(in_buffer);
-    return paContinue;
+    size_t out_frames = frames;
+    if (plan->resample) {
+        long long target = (player->resample_in_frames + (long long)frames) * plan->out_rate / plan->in_rate;
+        out_frames = (size_t)(target - player->resample_out_frames);
+        plan->resample(samples, player->resample_buffer, (int)frames, (int)out_frames);
+        samples = player->resample_buffer;
+    }
+    player->resample_in_frames += frames;
+    player->resample_out_frames += out_frames;
+
+    ring_buffer_write(player->ring, samples, out_frames * out_channels);
+    atomic_fetch_add(&player->decoded_frames, (long long)frames);
+    return true;
+}
+
+static bool decoder_job_step(void *arg) {
+    AudioPlayer *player = arg;
+
+    // the lock is held across opening a track, which can scan a whole MP3 or wait on a
+    // stream; a shared worker moves on to other players and is woken once it is free
+    if (pthread_mutex_trylock(&player->decoder_lock) != 0) return false;
+    uint64_t start = audio_stats_now_ns();
+    bool decoded = decode_step(player);
+    if (decoded) {
+        audio_stats_record_decode(&player->stats, audio_stats_now_ns() - start);
+    }
+    pthread_mutex_unlock(&player->decoder_lock);
+    return decoded;
+}
+
+static bool mixer_job_step(void *arg) {
+    return mixer_decode(((AudioPlayer *)arg)->mixer);
+}
+
+static bool analysis_job_step(void *arg) {
+    return feature_analyzer_step(((AudioPlayer *)arg)->features);
+}
+
+static void reset_decoder_position(AudioPlayer *player, long long frame) {
+    atomic_store(&player->decoded_frames, frame);
+    atomic_store(&player->decoder_eof, false);
+    player->resample_in_frames = 0;
+    player->resample_out_frames = 0;
+    player->consecutive_errors = 0;
+    ring_buffer_flush(player->ring);
 }
 
 static void list_audio_devices(void) {
     int numDevices = Pa_GetDeviceCount();
     if (numDevices < 0) {
-        fprintf(stderr, "Error getting device count: %s\n", Pa_GetErrorText(numDevices));
+        LOG_ERROR("Error getting device count: %s", Pa_GetErrorText(numDevices));
         return;
     }
 
-    fprintf(stderr, "Available audio devices:\n");
+    LOG_INFO("Available audio devices:");
     for (int i = 0; i < numDevices; i++) {
         const PaDeviceInfo *deviceInfo = Pa_GetDeviceInfo(i);
         if (deviceInfo) {
-            fprintf(stderr, "Device %d: %s (in: %d, out: %d)\n",
-                    i, deviceInfo->name,
-                    deviceInfo->maxInputChannels,
-                    deviceInfo->maxOutputChannels);
+            LOG_ALWAYS(LOG_LEVEL_INFO, "Device %d: %s (in: %d, out: %d)",
+                       i, deviceInfo->name,
+                       deviceInfo->maxInputChannels,
+                       deviceInfo->maxOutputChannels);
         }
     }
 }
@@ -175,7 +282,7 @@ static void list_audio_devices(void) {
 static PaDeviceIndex find_output_device(void) {
     int numDevices = Pa_GetDeviceCount();
     if (numDevices < 0) {
-        fprintf(stderr, "Error getting device count: %s\n", Pa_GetErrorText(numDevices));
+        LOG_ERROR("Error getting device count: %s", Pa_GetErrorText(numDevices));
         return paNoDevice;
     }
 
@@ -197,73 +304,285 @@ static PaDeviceIndex find_output_device(void) {
     return paNoDevice;
 }
 
-AudioPlayer* audio_player_init(void) {
-    AudioPlayer *player = (AudioPlayer *)malloc(sizeof(AudioPlayer));
-    if (!player) {
-        fprintf(stderr, "Failed to allocate player\n");
-        return NULL;
-    }
-
-    PaError err = Pa_Initialize();
-    if (err != paNoError) {
-        fprintf(stderr, "Failed to initialize PortAudio: %s\n", Pa_GetErrorText(err));
-        free(player);
-        return NULL;
-    }
-
-    player->mh = mpg123_new(NULL, NULL);
-    if (!player->mh) {
-        fprintf(stderr, "Failed to create mpg123 handle\n");
-        Pa_Terminate();
-        free(player);
-        return NULL;
+static int open_portaudio_stream(AudioPlayer *player) {
+    if (!player->pa_initialized) {
+        if (audio_context_acquire_portaudio() != 0) return -1;
+        player->pa_initialized = true;
     }
 
-    mpg123_param(player->mh, MPG123_ADD_FLAGS, MPG123_FORCE_FLOAT, 0.0);
-    mpg123_param(player->mh, MPG123_ADD_FLAGS, MPG123_FORCE_STEREO, 0.0);
-    mpg123_param(player->mh, MPG123_ADD_FLAGS, MPG123_QUIET, 0.0);
-    mpg123_param(player->mh, MPG123_ADD_FLAGS, MPG123_IGNORE_INFOFRAME, 0.0);
-
     PaDeviceIndex device = find_output_device();
     if (device == paNoDevice) {
-        fprintf(stderr, "No suitable audio output device found\n");
+        LOG_ERROR("No suitable audio output device found");
         list_audio_devices();
-        mpg123_delete(player->mh);
-        Pa_Terminate();
-        free(player);
-        return NULL;
+        return -1;
     }
 
-    const PaDeviceInfo *deviceInfo = Pa_GetDeviceInfo(device);
     PaStreamParameters outputParameters = {
         .device = device,
-        .channelCount = CHANNELS,
+        .channelCount = player->channels,
         .sampleFormat = paFloat32,
-        .suggestedLatency = Pa_GetDeviceInfo(device)->defaultLowOutputLatency,
+        .suggestedLatency = player->config.latency > 0.0 ? player->config.latency
+                            : atomic_load(&player->low_power) ? Pa_GetDeviceInfo(device)->defaultHighOutputLatency
+                                                              : Pa_GetDeviceInfo(device)->defaultLowOutputLatency,
         .hostApiSpecificStreamInfo = NULL
     };
 
-    err = Pa_OpenStream(&player->stream,
+    PaError err = Pa_OpenStream(&player->stream,
                        NULL,
                        &outputParameters,
-                       SAMPLE_RATE,
-                       FRAMES_PER_BUFFER,
+                       player->sample_rate,
+                       player->frames_per_buffer > 0 ? (unsigned long)player->frames_per_buffer
+                                                     : paFramesPerBufferUnspecified,
                        paClipOff,
                        pa_callback,
                        player);
 
     if (err != paNoError) {
-        fprintf(stderr, "Failed to open audio stream: %s\n", Pa_GetErrorText(err));
-        fprintf(stderr, "Trying to list available devices...\n");
+        LOG_ERROR("Failed to open audio stream: %s", Pa_GetErrorText(err));
+        LOG_WARN("Trying to list available devices...");
         list_audio_devices();
-        mpg123_delete(player->mh);
-        Pa_Terminate();
-        free(player);
+        player->stream = NULL;
+        return -1;
+    }
+
+    return 0;
+}
+
+static bool portaudio_rate_supported(AudioPlayer *player, long rate) {
+    PaDeviceIndex device = find_output_device();
+    if (device == paNoDevice) return false;
+
+    PaStreamParameters outputParameters = {
+        .device = device,
+        .channelCount = player->channels,
+        .sampleFormat = paFloat32,
+        .suggestedLatency = Pa_GetDeviceInfo(device)->defaultLowOutputLatency,
+        .hostApiSpecificStreamInfo = NULL
+    };
+    return Pa_IsFormatSupported(NULL, &outputParameters, (double)rate) == paFormatIsSupported;
+}
+
+static int open_jack_output(AudioPlayer *player) {
+    player->jack = jack_output_create("rhythm", player->channels, jack_render, jack_format_changed, player);
+    if (!player->jack) return -1;
+
+    player->sample_rate = jack_output_get_sample_rate(player->jack);
+    player->frames_per_buffer = jack_output_get_period_frames(player->jack);
+
+    const char *transport = getenv("RHYTHM_JACK_TRANSPORT");
+    jack_output_set_follow_transport(player->jack, transport && strcmp(transport, "0") != 0);
+
+    if (jack_output_start(player->jack) != 0) {
+        jack_output_destroy(player->jack);
+        player->jack = NULL;
+        return -1;
+    }
+
+    return 0;
+}
+
+static int open_output(AudioPlayer *player) {
+    if (player->config.backend == AUDIO_BACKEND_JACK) {
+        if (open_jack_output(player) == 0) {
+            player->backend = AUDIO_BACKEND_JACK;
+            return 0;
+        }
+        LOG_WARN("JACK output unavailable, falling back to PortAudio");
+    }
+
+    player->backend = AUDIO_BACKEND_PORTAUDIO;
+    return open_portaudio_stream(player);
+}
+
+static void close_output(AudioPlayer *player) {
+    if (player->stream) {
+        Pa_StopStream(player->stream);
+        Pa_CloseStream(player->stream);
+        player->stream = NULL;
+    }
+    if (player->jack) {
+        jack_output_destroy(player->jack);
+        player->jack = NULL;
+    }
+}
+
+// only called while the output is stopped, so the callback cannot observe the swap
+static void switch_to_native_rate(AudioPlayer *player, long rate) {
+    if (player->backend != AUDIO_BACKEND_PORTAUDIO || rate == player->sample_rate) return;
+    if (!portaudio_rate_supported(player, rate)) return;
+
+    int previous_rate = player->sample_rate;
+    close_output(player);
+    player->sample_rate = (int)rate;
+    if (open_portaudio_stream(player) != 0) {
+        LOG_WARN("Cannot reopen output at %ld Hz, staying at %d Hz", rate, previous_rate);
+        player->sample_rate = previous_rate;
+        open_portaudio_stream(player);
+    }
+}
+
+static int backend_start(AudioPlayer *player) {
+    if (player->backend == AUDIO_BACKEND_JACK) {
+        jack_output_transport_start(player->jack);
+        return 0;
+    }
+
+    if (!player->stream) return -1;
+
+    PaError err = Pa_StartStream(player->stream);
+    if (err != paNoError) {
+        LOG_ERROR("Failed to start stream: %s", Pa_GetErrorText(err));
+        return -1;
+    }
+    return 0;
+}
+
+static int backend_stop(AudioPlayer *player) {
+    if (player->backend == AUDIO_BACKEND_JACK) {
+        jack_output_transport_stop(player->jack);
+        return 0;
+    }
+
+    if (!player->stream) return 0;
+    return Pa_StopStream(player->stream) == paNoError ? 0 : -1;
+}
+
+static int ring_frames(AudioPlayer *player) {
+    return atomic_load(&player->low_power) ? LOW_POWER_BUFFER_SIZE : BUFFER_SIZE;
+}
+
+// low power asks for long periods; an explicitly longer one is kept
+static int output_period(AudioPlayer *player, const AudioConfig *config) {
+    if (!atomic_load(&player->low_power) || config->frames_per_buffer >= LOW_POWER_PERIOD_FRAMES) {
+        return config->frames_per_buffer;
+    }
+    return LOW_POWER_PERIOD_FRAMES;
+}
+
+static int env_int(const char *name, int fallback) {
+    const char *value = getenv(name);
+    return (value && *value) ? atoi(value) : fallback;
+}
+
+void audio_config_defaults(AudioConfig *config) {
+    if (!config) return;
+
+    const char *backend = getenv("RHYTHM_AUDIO_BACKEND");
+    config->backend = (backend && strcasecmp(backend, "jack") == 0) ? AUDIO_BACKEND_JACK
+                                                                     : AUDIO_BACKEND_PORTAUDIO;
+    config->sample_rate = env_int("RHYTHM_SAMPLE_RATE", SAMPLE_RATE);
+    config->frames_per_buffer = env_int("RHYTHM_PERIOD_FRAMES", FRAMES_PER_BUFFER);
+    config->channels = CHANNELS;
+    config->latency = env_int("RHYTHM_LATENCY_MS", 0) / 1000.0;
+    config->native_rate = env_int("RHYTHM_NATIVE_RATE", 0) != 0;
+}
+
+static bool config_valid(const AudioConfig *config) {
+    return config->channels >= 1 && config->channels <= MAX_SOURCE_CHANNELS &&
+           config->sample_rate >= 8000 && config->sample_rate <= 384000 &&
+           config->frames_per_buffer >= 0 && config->frames_per_buffer <= JACK_MAX_PERIOD_FRAMES &&
+           config->latency >= 0.0;
+}
+
+AudioPlayer* audio_player_init(void) {
+    AudioConfig config;
+    audio_config_defaults(&config);
+    return audio_player_init_config(&config);
+}
+
+AudioPlayer* audio_player_init_backend(AudioBackendType backend) {
+    AudioConfig config;
+    audio_config_defaults(&config);
+    config.backend = backend;
+    return audio_player_init_config(&config);
+}
+
+AudioPlayer* audio_player_init_config(const AudioConfig *config) {
+    if (!config || !config_valid(config)) {
+        LOG_ERROR("Invalid audio configuration");
+        return NULL;
+    }
+
+    AudioPlayer *player = (AudioPlayer *)calloc(1, sizeof(AudioPlayer));
+    if (!player) {
+        LOG_ERROR("Failed to allocate player");
+        return NULL;
+    }
+
+    player->config = *config;
+    player->sample_rate = config->sample_rate;
+    player->channels = config->channels;
+    player->frames_per_buffer = config->frames_per_buffer;
+    pthread_mutex_init(&player->decoder_lock, NULL);
+    atomic_init(&player->decoder_eof, false);
+    atomic_init(&player->plan_stale, false);
+    atomic_init(&player->decoded_frames, 0);
+    atomic_init(&player->low_power, false);
+    audio_stats_init(&player->stats);
+
+    player->mp3_decoder = mpg123_decoder_create();
+    player->wav_decoder = wav_decoder_create();
+    player->stream_decoder = stream_decoder_create();
+    player->pcm_cache = audio_context_acquire_pcm_cache();
+    player->cached_decoder = pcm_cache_decoder_create(player->pcm_cache);
+    if (!player->mp3_decoder || !player->wav_decoder || !player->stream_decoder || !player->cached_decoder) {
+        LOG_ERROR("Failed to create decoders");
+        audio_player_cleanup(player);
+        return NULL;
+    }
+
+    player->dsp = dsp_chain_create();
+    if (!player->dsp) {
+        LOG_ERROR("Failed to create DSP chain");
+        audio_player_cleanup(player);
+        return NULL;
+    }
+
+    player->features = feature_analyzer_create(false);
+    if (!player->features) {
+        LOG_ERROR("Failed to create feature analyzer");
+        audio_player_cleanup(player);
+        return NULL;
+    }
+
+    player->mixer = mixer_create(false);
+    if (!player->mixer) {
+        LOG_ERROR("Failed to create mixer");
+        audio_player_cleanup(player);
+        return NULL;
+    }
+
+    if (open_output(player) != 0) {
+        audio_player_cleanup(player);
+        return NULL;
+    }
+
+    atomic_init(&player->ring_frames, ring_frames(player));
+    player->ring = ring_buffer_create((size_t)LOW_POWER_BUFFER_SIZE * player->channels);
+    player->decode_buffer = malloc(DECODE_CHUNK_FRAMES * MAX_SOURCE_CHANNELS * sizeof(float));
+    player->convert_buffer = malloc(DECODE_CHUNK_FRAMES * MAX_SOURCE_CHANNELS * sizeof(float));
+    if (!player->ring || !player->decode_buffer || !player->convert_buffer) {
+        LOG_ERROR("Failed to allocate decoder buffers");
+        audio_player_cleanup(player);
+        return NULL;
+    }
+
+    // background work runs on the process-wide pool instead of threads of our own
+    player->pool = audio_context_acquire_pool();
+    if (player->pool) {
+        player->decode_job = decoder_pool_add(player->pool, decoder_job_step, player, DECODER_IDLE_WAIT_MS);
+        player->mixer_job = decoder_pool_add(player->pool, mixer_job_step, player, DECODER_IDLE_WAIT_MS);
+        player->analysis_job = decoder_pool_add(player->pool, analysis_job_step, player, FEATURE_POLL_MS);
+    }
+    if (!player->decode_job || !player->mixer_job || !player->analysis_job) {
+        LOG_ERROR("Failed to start decoder jobs");
+        audio_player_cleanup(player);
         return NULL;
     }
 
     player->state = PLAYER_STATE_STOPPED;
     player->volume = DEFAULT_VOLUME;
+    player->track_gain = 1.0f;
     player->current_file = NULL;
     player->vis_level = 0.0f;
     player->current_position_seconds = 0;
@@ -276,77 +595,123 @@ AudioPlayer* audio_player_init(void) {
 void audio_player_cleanup(AudioPlayer *player) {
     if (!player) return;
 
-    if (player->stream) {
-        Pa_StopStream(player->stream);
-        Pa_CloseStream(player->stream);
-    }
-    if (player->mh) {
-        mpg123_close(player->mh);
-        mpg123_delete(player->mh);
-    }
+    close_output(player);
+    if (player->pa_initialized) {
+        audio_context_release_portaudio();
+    }
+    if (player->pool) {
+        decoder_pool_remove(player->pool, player->decode_job);
+        decoder_pool_remove(player->pool, player->mixer_job);
+        decoder_pool_remove(player->pool, player->analysis_job);
+        audio_context_release_pool();
+    }
+    decoder_destroy(player->mp3_decoder);
+    decoder_destroy(player->wav_decoder);
+    decoder_destroy(player->stream_decoder);
+    decoder_destroy(player->cached_decoder);
+    if (player->pcm_cache) audio_context_release_pcm_cache();
     if (player->current_file) {
         free(player->current_file);
     }
+    ring_buffer_destroy(player->ring);
+    free(player->decode_buffer);
+    free(player->convert_buffer);
+    free(player->resample_buffer);
+    dsp_chain_destroy(player->dsp);
+    feature_analyzer_destroy(player->features);
+    mixer_destroy(player->mixer);
+    pthread_mutex_destroy(&player->decoder_lock);
     free(player);
 }
 
 int audio_player_play(AudioPlayer *player, const char *filename) {
+    return audio_player_play_from(player, filename, 0);
+}
+
+int audio_player_play_from(AudioPlayer *player, const char *filename, long long start_frame) {
     if (!player || !filename) return -1;
 
+    // time to first sample includes opening (and for MP3 scanning) the file
+    uint64_t requested = audio_stats_now_ns();
     audio_player_stop(player);
 
-    if (mpg123_open(player->mh, filename) != MPG123_OK) {
-        fprintf(stderr, "Failed to open file: %s\n", mpg123_strerror(player->mh));
+    pthread_mutex_lock(&player->decoder_lock);
+
+    // streams are checked first: probing a FIFO would eat the start of it
+    Decoder *decoder = player->mp3_decoder;
+    if (stream_source_is_stream(filename)) {
+        decoder = player->stream_decoder;
+    } else if (wav_decoder_probe(filename)) {
+        decoder = player->wav_decoder;
+    }
+    // replays and seeks back are served from decoded segments instead of the file
+    if (decoder != player->stream_decoder) {
+        pcm_cache_decoder_set_source(player->cached_decoder, decoder);
+        decoder = player->cached_decoder;
+    }
+    if (decoder_open(decoder, filename) != 0) {
+        pthread_mutex_unlock(&player->decoder_lock);
         return -1;
     }
 
-    mpg123_scan(player->mh);
-
-    size_t buffer_size = 1024;
-    unsigned char *buffer = malloc(buffer_size);
-    if (!buffer) {
-        fprintf(stderr, "Failed to allocate buffer for format detection\n");
-        mpg123_close(player->mh);
+    long rate = decoder->rate;
+    int channels = decoder->channels;
+    if (rate <= 0 || channels < 1 || channels > MAX_SOURCE_CHANNELS) {
+        LOG_ERROR("Unsupported stream format: %ld Hz, %d channels", rate, channels);
+        decoder_close(decoder);
+        pthread_mutex_unlock(&player->decoder_lock);
         return -1;
     }
 
-    size_t done = 0;
-    int read_err = mpg123_read(player->mh, buffer, buffer_size, &done);
-    free(buffer);
-
-    mpg123_seek(player->mh, 0, SEEK_SET);
+    player->decoder = decoder;
+    player->total_duration_seconds = decoder->length_frames > 0 ? (int)(decoder->length_frames / rate) : 0;
+    player->duration_known = decoder->length_frames > 0;
+    player->current_position_seconds = 0;
 
-    if (read_err != MPG123_OK && read_err != MPG123_DONE && read_err != MPG123_NEW_FORMAT) {
-        fprintf(stderr, "Failed to read initial data: %s (code %d)\n", mpg123_strerror(player->mh), read_err);
-        mpg123_close(player->mh);
-        return -1;
+    if (player->config.native_rate) {
+        switch_to_native_rate(player, rate);
     }
 
-    int channels, encoding;
-    long rate;
-    if (mpg123_getformat(player->mh, &rate, &channels, &encoding) != MPG123_OK) {
-        fprintf(stderr, "Failed to get format: %s (code %d)\n", mpg123_strerror(player->mh), mpg123_errcode(player->mh));
-        mpg123_close(player->mh);
+    player->source_rate = rate;
+    player->source_channels = channels;
+    if (rebuild_plan(player) != 0) {
+        LOG_ERROR("Cannot convert %ld Hz, %d channels for the output", rate, channels);
+        decoder_close(decoder);
+        player->decoder = NULL;
+        pthread_mutex_unlock(&player->decoder_lock);
         return -1;
     }
-
-    off_t length = mpg123_length(player->mh);
-    if (length != MPG123_ERR) {
-        player->total_duration_seconds = (int)(length / rate);
-    } else {
-        player->total_duration_seconds = 0;
+    // positioned before the output starts, so nothing from the top of the track is heard
+    long long length = decoder->length_frames;
+    if (start_frame <= 0 || length <= 0 || start_frame >= length || decoder_seek(decoder, start_frame) != 0) {
+        start_frame = 0;
     }
-    player->current_position_seconds = 0;
+    reset_decoder_position(player, start_frame);
+    player->current_position_seconds = (int)(start_frame / rate);
+    atomic_store(&player->first_sample_ns, 0);
+    atomic_store(&player->start_requested_ns, requested);
+    player->track_loaded = true;
+
+    pthread_mutex_unlock(&player->decoder_lock);
 
     if (player->current_file) {
         free(player->current_file);
     }
     player->current_file = strdup(filename);
-
-    PaError err = Pa_StartStream(player->stream);
-    if (err != paNoError) {
-        fprintf(stderr, "Failed to start stream: %s\n", Pa_GetErrorText(err));
-        mpg123_close(player->mh);
+    feature_analyzer_reset(player->features);
+
+    decoder_pool_wake(player->decode_job);
+
+    TRACE_BEGIN(start_span, "backend_start");
+    int start_err = backend_start(player);
+    TRACE_END(start_span);
+    if (start_err != 0) {
+        pthread_mutex_lock(&player->decoder_lock);
+        atomic_store(&player->start_requested_ns, 0);
+        player->track_loaded = false;
+        decoder_close(player->decoder);
+        player->decoder = NULL;
+        pthread_mutex_unlock(&player->decoder_lock);
         return -1;
     }
 
@@ -357,8 +722,7 @@ int audio_player_play(AudioPlayer *player, const char *filename) {
 void audio_player_pause(AudioPlayer *player) {
     if (!player || player->state != PLAYER_STATE_PLAYING) return;
 
-    PaError err = Pa_StopStream(player->stream);
-    if (err == paNoError) {
+    if (backend_stop(player) == 0) {
         player->state = PLAYER_STATE_PAUSED;
     }
 }
@@ -366,8 +730,7 @@ void audio_player_pause(AudioPlayer *player) {
 void audio_player_resume(AudioPlayer *player) {
     if (!player || player->state != PLAYER_STATE_PAUSED) return;
 
-    PaError err = Pa_StartStream(player->stream);
-    if (err == paNoError) {
+    if (backend_start(player) == 0) {
         player->state = PLAYER_STATE_PLAYING;
     }
 }
@@ -375,15 +738,21 @@ void audio_player_resume(AudioPlayer *player) {
 void audio_player_stop(AudioPlayer *player) {
     if (!player) return;
 
-    if (player->stream) {
-        Pa_StopStream(player->stream);
-    }
-    if (player->mh) {
-        mpg123_close(player->mh);
-    }
     player->state = PLAYER_STATE_STOPPED;
+    backend_stop(player);
+
+    pthread_mutex_lock(&player->decoder_lock);
+    if (player->decoder) {
+        decoder_close(player->decoder);
+        player->decoder = NULL;
+    }
+    player->track_loaded = false;
+    reset_decoder_position(player, 0);
+    pthread_mutex_unlock(&player->decoder_lock);
+
     player->current_position_seconds = 0;
     player->total_duration_seconds = 0;
+    player->duration_known = false;
 }
 
 void audio_player_set_volume(AudioPlayer *player, float volume) {
@@ -393,55 +762,211 @@ void audio_player_set_volume(AudioPlayer *player, float volume) {
     player->volume = volume;
 }
 
+void audio_player_set_track_gain(AudioPlayer *player, float gain) {
+    if (!player || gain < 0.0f) return;
+    player->track_gain = gain;
+}
+
 PlayerState audio_player_get_state(AudioPlayer *player) {
     return player ? player->state : PLAYER_STATE_STOPPED;
 }
 
 int audio_player_seek(AudioPlayer *player, float position) {
-    if (!player || !player->mh) return -1;
+    if (!player) return -1;
     if (position < 0.0f || position > 1.0f) return -1;
 
-    off_t length = mpg123_length(player->mh);
-    if (length == MPG123_ERR) return -1;
+    pthread_mutex_lock(&player->decoder_lock);
+
+    long long length = player->track_loaded && player->decoder ? player->decoder->length_frames : -1;
+    if (length <= 0) {
+        pthread_mutex_unlock(&player->decoder_lock);
+        return -1;
+    }
 
-    off_t target_sample = (off_t)(length * position);
+    long long target_sample = (long long)(length * position);
 
     if (position > 0.99f) {
-        target_sample = (off_t)(length * 0.99f);
+        target_sample = (long long)(length * 0.99f);
         position = 0.99f;
     }
 
-    if (mpg123_seek(player->mh, target_sample, SEEK_SET) < 0) {
+    if (decoder_seek(player->decoder, target_sample) != 0) {
+        pthread_mutex_unlock(&player->decoder_lock);
+        return -1;
+    }
+
+    if (player->source_rate > 0) {
+        player->current_position_seconds = (int)(target_sample / player->source_rate);
+    }
+    reset_decoder_position(player, target_sample);
+
+    pthread_mutex_unlock(&player->decoder_lock);
+    decoder_pool_wake(player->decode_job);
+
+    return 0;
+}
+
+static long long playback_sample(AudioPlayer *player) {
+    // the decoder runs ahead of the output by whatever is still queued in the ring
+    long long decoded = atomic_load(&player->decoded_frames);
+    long long buffered = (long long)(ring_buffer_read_available(player->ring) / player->channels);
+    long long current_sample = decoded - buffered * player->source_rate / player->sample_rate;
+    return current_sample < 0 ? 0 : current_sample;
+}
+
+long long audio_player_get_position_frames(AudioPlayer *player) {
+    if (!player) return 0;
+
+    pthread_mutex_lock(&player->decoder_lock);
+    long long position = player->track_loaded && player->source_rate > 0 ? playback_sample(player) : 0;
+    pthread_mutex_unlock(&player->decoder_lock);
+    return position;
+}
+
+int audio_player_configure(AudioPlayer *player, const AudioConfig *config) {
+    if (!player || !config || !config_valid(config)) return -1;
+
+    PlayerState previous_state = player->state;
+    player->state = PLAYER_STATE_STOPPED;
+    close_output(player);
+
+    pthread_mutex_lock(&player->decoder_lock);
+
+    long long resume_sample = 0;
+    if (player->track_loaded && player->source_rate > 0) {
+        resume_sample = playback_sample(player);
+    }
+
+    player->config = *config;
+    player->sample_rate = config->sample_rate;
+    player->frames_per_buffer = output_period(player, config);
+    if (config->native_rate && player->track_loaded && player->source_rate > 0) {
+        player->sample_rate = (int)player->source_rate;
+    }
+
+    int result = 0;
+    if (config->channels != player->channels) {
+        RingBuffer *ring = ring_buffer_create((size_t)LOW_POWER_BUFFER_SIZE * config->channels);
+        if (ring) {
+            ring_buffer_destroy(player->ring);
+            player->ring = ring;
+            player->channels = config->channels;
+        } else {
+            result = -1;
+        }
+    }
+
+    if (result == 0 && open_output(player) != 0) {
+        if (player->sample_rate != config->sample_rate) {
+            player->sample_rate = config->sample_rate;
+            result = open_output(player);
+        } else {
+            result = -1;
+        }
+    }
+
+    if (player->track_loaded) {
+        decoder_seek(player->decoder, resume_sample);
+        if (rebuild_plan(player) != 0) result = -1;
+        reset_decoder_position(player, resume_sample);
+    }
+
+    pthread_mutex_unlock(&player->decoder_lock);
+
+    if (result != 0) {
+        LOG_ERROR("Failed to reopen audio output with the new configuration");
         return -1;
     }
 
-    int channels, encoding;
-    long rate;
-    if (mpg123_getformat(player->mh, &rate, &channels, &encoding) == MPG123_OK) {
-        player->current_position_seconds = (int)(target_sample / rate);
+    decoder_pool_wake(player->decode_job);
+
+    if (previous_state == PLAYER_STATE_PLAYING) {
+        if (backend_start(player) == 0) {
+            player->state = PLAYER_STATE_PLAYING;
+        }
+    } else if (previous_state == PLAYER_STATE_PAUSED) {
+        player->state = PLAYER_STATE_PAUSED;
     }
 
     return 0;
 }
 
+// the ring is allocated deep enough for low power; the mode only moves its fill limit
+static void set_power_mode(AudioPlayer *player, bool enabled) {
+    atomic_store(&player->low_power, enabled);
+    atomic_store(&player->ring_frames, ring_frames(player));
+    int poll_ms = enabled ? LOW_POWER_POLL_MS : DECODER_IDLE_WAIT_MS;
+    decoder_pool_set_poll(player->decode_job, poll_ms);
+    decoder_pool_set_poll(player->mixer_job, poll_ms);
+    decoder_pool_set_poll(player->analysis_job, enabled ? LOW_POWER_POLL_MS : FEATURE_POLL_MS);
+}
+
+int audio_player_set_low_power(AudioPlayer *player, bool enabled) {
+    if (!player) return -1;
+    if (atomic_load(&player->low_power) == enabled) return 0;
+
+    int period = player->frames_per_buffer;
+    set_power_mode(player, enabled);
+
+    // only a PortAudio stream whose period changes is reopened; JACK keeps the server's period
+    AudioConfig config = player->config;
+    if (player->backend == AUDIO_BACKEND_PORTAUDIO && output_period(player, &config) != period &&
+        audio_player_configure(player, &config) != 0) {
+        set_power_mode(player, !enabled);
+        audio_player_configure(player, &config);
+        return -1;
+    }
+
+    decoder_pool_wake(player->decode_job);
+    return 0;
+}
+
+bool audio_player_is_low_power(AudioPlayer *player) {
+    return player && atomic_load(&player->low_power);
+}
+
+void audio_player_get_output_info(AudioPlayer *player, AudioOutputInfo *info) {
+    if (!info) return;
+    memset(info, 0, sizeof(AudioOutputInfo));
+    if (!player) return;
+
+    info->backend = player->backend;
+    info->sample_rate = player->sample_rate;
+    info->frames_per_buffer = player->frames_per_buffer;
+    info->channels = player->channels;
+
+    if (player->backend == AUDIO_BACKEND_JACK) {
+        info->output_latency = jack_output_get_latency(player->jack);
+    } else if (player->stream) {
+        const PaStreamInfo *stream_info = Pa_GetStreamInfo(player->stream);
+        if (stream_info) {
+            info->output_latency = stream_info->outputLatency;
+            info->sample_rate = (int)stream_info->sampleRate;
+        }
+    }
+
+    if (player->track_loaded) {
+        info->source_rate = player->source_rate;
+        info->resampling = player->source_rate != info->sample_rate;
+    }
+
+    if (player->ring && info->sample_rate > 0) {
+        size_t queued_frames = ring_buffer_read_available(player->ring) / player->channels;
+        info->buffer_latency = (double)queued_frames / info->sample_rate;
+    }
+}
+
 float audio_player_get_volume(AudioPlayer *player) {
     return player ? player->volume : 0.0f;
 }
 
 int audio_player_get_current_time(AudioPlayer *player) {
-    if (!player || !player->mh) return 0;
-
-    off_t current_sample = mpg123_tell(player->mh);
-    if (current_sample == MPG123_ERR) {
+    if (!player) return 0;
+    if (!player->track_loaded || player->source_rate <= 0 || player->sample_rate <= 0) {
         return player->current_position_seconds;
     }
 
-    int channels, encoding;
-    long rate;
-    if (mpg123_getformat(player->mh, &rate, &channels, &encoding) == MPG123_OK) {
-        player->current_position_seconds = (int)(current_sample / rate);
-    }
-
+    player->current_position_seconds = (int)(playback_sample(player) / player->source_rate);
     return player->current_position_seconds;
 }
 
@@ -449,6 +974,15 @@ int audio_player_get_total_time(AudioPlayer *player) {
     return player ? player->total_duration_seconds : 0;
 }
 
+bool audio_player_duration_known(AudioPlayer *player) {
+    return player && player->duration_known;
+}
+
+void audio_player_get_stream_stats(AudioPlayer *player, StreamStats *stats) {
+    if (!player || !stats) return;
+    stream_decoder_get_stats(player->stream_decoder, stats);
+}
+
 float audio_player_get_progress(AudioPlayer *player) {
     if (!player || player->total_duration_seconds <= 0) return 0.0f;
 
@@ -466,4 +1000,22 @@ void audio_player_get_vis_data(AudioPlayer *player, float *vis_bands, int num_ba
     if (num_bands > 32) {
         memset(vis_bands + 32, 0, (num_bands - 32) * sizeof(float));
     }
-}
\ No newline at end of file
+}
+
+void audio_player_get_features(AudioPlayer *player, AudioFeatures *features) {
+    if (!features) return;
+    if (!player) {
+        memset(features, 0, sizeof(AudioFeatures));
+        return;
+    }
+
+    // the analyzer sees samples as they enter the device; line the beat up with the speakers
+    AudioOutputInfo info;
+    audio_player_get_output_info(player, &info);
+    feature_analyzer_get(player->features, features, (long long)(info.output_latency * info.sample_rate));
+}
+
+unsigned long audio_player_get_xrun_count(AudioPlayer *player) {
+    if (!player || player->backend != AUDIO_BACKEND_JACK) return 0;
+    return jack_output_get_xrun_count(player->jack);
+}
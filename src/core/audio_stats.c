@@ -0,0 +1,154 @@
+#include "core/audio_stats.h"
+#include <time.h>
+
+// the only writer is the owning thread, so plain load+store avoids locked RMW instructions
+static inline void bump(atomic_uint_fast64_t *counter, uint64_t amount) {
+    uint64_t value = atomic_load_explicit(counter, memory_order_relaxed);
+    atomic_store_explicit(counter, value + amount, memory_order_relaxed);
+}
+
+uint64_t audio_stats_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static int64_t wall_clock_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + (int64_t)ts.tv_nsec;
+}
+
+int latency_histogram_bucket_index(uint64_t value_ns) {
+    const uint64_t max_value = (1ULL << LATENCY_HISTOGRAM_MAX_BITS) - 1;
+    if (value_ns > max_value) value_ns = max_value;
+    if (value_ns < 2 * LATENCY_HISTOGRAM_SUB_BUCKETS) return (int)value_ns;
+
+    int msb = 63 - __builtin_clzll(value_ns);
+    int shift = msb - LATENCY_HISTOGRAM_SUB_BITS;
+    return shift * LATENCY_HISTOGRAM_SUB_BUCKETS + (int)(value_ns >> shift);
+}
+
+uint64_t latency_histogram_bucket_upper(int index) {
+    if (index < 2 * LATENCY_HISTOGRAM_SUB_BUCKETS) return (uint64_t)index;
+
+    int shift = index / LATENCY_HISTOGRAM_SUB_BUCKETS - 1;
+    uint64_t mantissa = (uint64_t)(index - shift * LATENCY_HISTOGRAM_SUB_BUCKETS);
+    return ((mantissa + 1) << shift) - 1;
+}
+
+void latency_histogram_reset(LatencyHistogram *histogram) {
+    for (int i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++) {
+        atomic_store_explicit(&histogram->counts[i], 0, memory_order_relaxed);
+    }
+    atomic_store_explicit(&histogram->total, 0, memory_order_relaxed);
+    atomic_store_explicit(&histogram->max_ns, 0, memory_order_relaxed);
+}
+
+void latency_histogram_record(LatencyHistogram *histogram, uint64_t value_ns) {
+    bump(&histogram->counts[latency_histogram_bucket_index(value_ns)], 1);
+    bump(&histogram->total, 1);
+    if (value_ns > atomic_load_explicit(&histogram->max_ns, memory_order_relaxed)) {
+        atomic_store_explicit(&histogram->max_ns, value_ns, memory_order_relaxed);
+    }
+}
+
+uint64_t latency_histogram_count(LatencyHistogram *histogram) {
+    return atomic_load_explicit(&histogram->total, memory_order_relaxed);
+}
+
+uint64_t latency_histogram_percentile(LatencyHistogram *histogram, double percentile) {
+    uint64_t total = 0;
+    for (int i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++) {
+        total += atomic_load_explicit(&histogram->counts[i], memory_order_relaxed);
+    }
+    if (total == 0) return 0;
+
+    uint64_t target = (uint64_t)(percentile / 100.0 * (double)total);
+    if (target >= total) target = total - 1;
+
+    uint64_t seen = 0;
+    for (int i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++) {
+        seen += atomic_load_explicit(&histogram->counts[i], memory_order_relaxed);
+        if (seen > target) {
+            uint64_t upper = latency_histogram_bucket_upper(i);
+            uint64_t max_ns = atomic_load_explicit(&histogram->max_ns, memory_order_relaxed);
+            return upper < max_ns ? upper : max_ns;
+        }
+    }
+    return atomic_load_explicit(&histogram->max_ns, memory_order_relaxed);
+}
+
+static void reset_callback_side(AudioStats *stats) {
+    latency_histogram_reset(&stats->callback_time);
+    atomic_store(&stats->callbacks, 0);
+    atomic_store(&stats->underflows, 0);
+    atomic_store(&stats->overflows, 0);
+    atomic_store(&stats->starved_callbacks, 0);
+    atomic_store(&stats->deadline_misses, 0);
+    atomic_store(&stats->last_budget_ns, 0);
+    atomic_store(&stats->worst_callback_ns, 0);
+    atomic_store(&stats->worst_callback_at_ns, 0);
+    atomic_store(&stats->ring_fill_frames, 0);
+    atomic_store(&stats->ring_min_fill_frames, UINT64_MAX);
+}
+
+void audio_stats_init(AudioStats *stats) {
+    reset_callback_side(stats);
+    latency_histogram_reset(&stats->decode_time);
+    atomic_init(&stats->callback_reset_pending, false);
+    atomic_init(&stats->decode_reset_pending, false);
+}
+
+void audio_stats_request_reset(AudioStats *stats) {
+    atomic_store(&stats->callback_reset_pending, true);
+    atomic_store(&stats->decode_reset_pending, true);
+}
+
+void audio_stats_record_decode(AudioStats *stats, uint64_t elapsed_ns) {
+    if (atomic_load_explicit(&stats->decode_reset_pending, memory_order_relaxed) &&
+        atomic_exchange(&stats->decode_reset_pending, false)) {
+        latency_histogram_reset(&stats->decode_time);
+    }
+    latency_histogram_record(&stats->decode_time, elapsed_ns);
+}
+
+uint64_t audio_stats_begin_callback(AudioStats *stats) {
+    if (atomic_load_explicit(&stats->callback_reset_pending, memory_order_relaxed) &&
+        atomic_exchange(&stats->callback_reset_pending, false)) {
+        reset_callback_side(stats);
+    }
+    return audio_stats_now_ns();
+}
+
+void audio_stats_end_callback(AudioStats *stats, uint64_t start_ns, uint64_t budget_ns) {
+    uint64_t elapsed = audio_stats_now_ns() - start_ns;
+
+    latency_histogram_record(&stats->callback_time, elapsed);
+    bump(&stats->callbacks, 1);
+    atomic_store_explicit(&stats->last_budget_ns, budget_ns, memory_order_relaxed);
+
+    if (budget_ns > 0 && elapsed > budget_ns) {
+        bump(&stats->deadline_misses, 1);
+    }
+    if (elapsed > atomic_load_explicit(&stats->worst_callback_ns, memory_order_relaxed)) {
+        atomic_store_explicit(&stats->worst_callback_ns, elapsed, memory_order_relaxed);
+        atomic_store_explicit(&stats->worst_callback_at_ns, wall_clock_ns(), memory_order_relaxed);
+    }
+}
+
+void audio_stats_record_starved(AudioStats *stats) {
+    bump(&stats->starved_callbacks, 1);
+}
+
+void audio_stats_record_ring_fill(AudioStats *stats, uint64_t frames) {
+    atomic_store_explicit(&stats->ring_fill_frames, frames, memory_order_relaxed);
+    if (frames < atomic_load_explicit(&stats->ring_min_fill_frames, memory_order_relaxed)) {
+        atomic_store_explicit(&stats->ring_min_fill_frames, frames, memory_order_relaxed);
+    }
+}
+
+void audio_stats_record_status_flags(AudioStats *stats, bool underflow, bool overflow) {
+    if (underflow) bump(&stats->underflows, 1);
+    if (overflow) bump(&stats->overflows, 1);
+}
@@ -0,0 +1,32 @@
+#include "core/decoder.h"
+
+int decoder_open(Decoder *decoder, const char *path) {
+    if (!decoder || !path) return -1;
+    decoder->rate = 0;
+    decoder->channels = 0;
+    decoder->length_frames = -1;
+    return decoder->ops->open(decoder, path);
+}
+
+DecoderStatus decoder_read(Decoder *decoder, float *out, size_t max_frames, size_t *frames_read) {
+    *frames_read = 0;
+    if (!decoder) return DECODER_ERROR;
+    return decoder->ops->read(decoder, out, max_frames, frames_read);
+}
+
+int decoder_seek(Decoder *decoder, long long frame) {
+    if (!decoder || frame < 0) return -1;
+    return decoder->ops->seek(decoder, frame);
+}
+
+void decoder_close(Decoder *decoder) {
+    if (decoder) decoder->ops->close(decoder);
+}
+
+void decoder_destroy(Decoder *decoder) {
+    if (decoder) decoder->ops->destroy(decoder);
+}
+
+const char* decoder_error_string(Decoder *decoder) {
+    return decoder ? decoder->ops->error_string(decoder) : "no decoder";
+}
@@ -0,0 +1,258 @@
+#include "core/decoder_pool.h"
+#include "core/trace.h"
+#include "core/realtime.h"
+#include "core/log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+
+#define DECODER_POOL_DEFAULT_THREADS 4
+#define DECODER_POOL_BURST 8            // steps before a busy job goes back in line
+#define DECODER_POOL_IDLE_MS 100
+#define DECODER_POOL_MAX_WAIT_MS 1000   // a worker with nothing due sleeps at most this long
+#define DECODER_POOL_SLACK_NS 2000000ULL  // polls this close together share one wakeup
+
+struct DecoderJob {
+    DecoderPool *pool;
+    DecoderJobStep step;
+    void *context;
+    int home;
+    atomic_uint_least64_t poll_ns;
+    atomic_bool pending;
+    atomic_bool running;
+    atomic_uint_least64_t next_poll_ns;
+};
+
+typedef struct {
+    DecoderPool *pool;
+    int index;
+    pthread_t thread;
+} DecoderWorker;
+
+struct DecoderPool {
+    // workers hold it for reading while they scan and run jobs; add/remove write
+    pthread_rwlock_t jobs_lock;
+    DecoderJob *jobs[DECODER_POOL_MAX_JOBS];
+    int job_count;
+    int next_home;
+
+    DecoderWorker workers[DECODER_POOL_MAX_THREADS];
+    int thread_count;
+    atomic_bool running;
+    sem_t wake;
+
+    atomic_uint_least64_t steps;
+    atomic_uint_least64_t steals;
+    atomic_uint_least64_t wakeups;
+};
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// runs a claimed job for up to one burst; true if it did anything
+static bool run_job(DecoderPool *pool, DecoderJob *job, int worker) {
+    bool idle = false;
+    if (!atomic_compare_exchange_strong_explicit(&job->running, &idle, true, memory_order_acquire,
+                                                 memory_order_relaxed)) {
+        return false;
+    }
+
+    // a wake arriving from here on is seen by the steps below or by the next scan
+    atomic_store_explicit(&job->pending, false, memory_order_relaxed);
+    int steps = 0;
+    while (steps < DECODER_POOL_BURST && job->step(job->context)) steps++;
+    if (steps == DECODER_POOL_BURST) atomic_store_explicit(&job->pending, true, memory_order_relaxed);
+
+    uint64_t poll_ns = atomic_load_explicit(&job->poll_ns, memory_order_relaxed);
+    atomic_store_explicit(&job->next_poll_ns, now_ns() + poll_ns, memory_order_relaxed);
+    atomic_store_explicit(&job->running, false, memory_order_release);
+
+    if (steps > 0) {
+        atomic_fetch_add_explicit(&pool->steps, (uint64_t)steps, memory_order_relaxed);
+        if (job->home != worker) atomic_fetch_add_explicit(&pool->steals, 1, memory_order_relaxed);
+    }
+    return steps > 0;
+}
+
+static bool job_due(DecoderJob *job, uint64_t now) {
+    return atomic_load_explicit(&job->pending, memory_order_relaxed) ||
+           now >= atomic_load_explicit(&job->next_poll_ns, memory_order_relaxed);
+}
+
+static void wait_until(DecoderPool *pool, uint64_t deadline) {
+    uint64_t now = now_ns();
+    if (deadline <= now) return;
+
+    uint64_t delay = deadline - now;
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += (time_t)(delay / 1000000000ULL);
+    ts.tv_nsec += (long)(delay % 1000000000ULL);
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+    sem_timedwait(&pool->wake, &ts);
+    atomic_fetch_add_explicit(&pool->wakeups, 1, memory_order_relaxed);
+}
+
+static void *worker_main(void *arg) {
+    DecoderWorker *worker = arg;
+    DecoderPool *pool = worker->pool;
+    TRACE_THREAD_NAME("decoder_pool");
+    realtime_register_thread(REALTIME_ROLE_DECODER);
+
+    while (atomic_load(&pool->running)) {
+        bool worked = false;
+        uint64_t deadline = now_ns() + (uint64_t)DECODER_POOL_MAX_WAIT_MS * 1000000ULL;
+
+        pthread_rwlock_rdlock(&pool->jobs_lock);
+        // own jobs first, then steal whatever is pending elsewhere
+        for (int pass = 0; pass < 2; pass++) {
+            uint64_t now = now_ns() + DECODER_POOL_SLACK_NS;
+            for (int i = 0; i < pool->job_count; i++) {
+                DecoderJob *job = pool->jobs[(i + worker->index) % pool->job_count];
+                bool home = job->home == worker->index;
+                if (home != (pass == 0)) continue;
+
+                if (job_due(job, now)) worked |= run_job(pool, job, worker->index);
+                if (home) {
+                    // a due job still running elsewhere is retried after the slack, not spun on
+                    uint64_t next = atomic_load_explicit(&job->next_poll_ns, memory_order_relaxed);
+                    if (next < now) next = now;
+                    if (next < deadline) deadline = next;
+                }
+            }
+        }
+        pthread_rwlock_unlock(&pool->jobs_lock);
+
+        if (!worked) wait_until(pool, deadline);
+    }
+    return NULL;
+}
+
+DecoderPool *decoder_pool_create(int threads) {
+    if (threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus < 1 ? 1 : cpus > DECODER_POOL_DEFAULT_THREADS ? DECODER_POOL_DEFAULT_THREADS : (int)cpus;
+    }
+    if (threads > DECODER_POOL_MAX_THREADS) threads = DECODER_POOL_MAX_THREADS;
+
+    DecoderPool *pool = calloc(1, sizeof(DecoderPool));
+    if (!pool) return NULL;
+
+    // removal waits out running jobs, so it must not starve behind a stream of scans
+    pthread_rwlockattr_t attr;
+    pthread_rwlockattr_init(&attr);
+    pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+    pthread_rwlock_init(&pool->jobs_lock, &attr);
+    pthread_rwlockattr_destroy(&attr);
+    sem_init(&pool->wake, 0, 0);
+    atomic_init(&pool->running, true);
+
+    for (int i = 0; i < threads; i++) {
+        pool->workers[i].pool = pool;
+        pool->workers[i].index = i;
+        if (pthread_create(&pool->workers[i].thread, NULL, worker_main, &pool->workers[i]) != 0) {
+            LOG_ERROR("Failed to start decoder pool thread");
+            decoder_pool_destroy(pool);
+            return NULL;
+        }
+        pool->thread_count++;
+    }
+    return pool;
+}
+
+void decoder_pool_destroy(DecoderPool *pool) {
+    if (!pool) return;
+
+    atomic_store(&pool->running, false);
+    for (int i = 0; i < pool->thread_count; i++) sem_post(&pool->wake);
+    for (int i = 0; i < pool->thread_count; i++) pthread_join(pool->workers[i].thread, NULL);
+
+    for (int i = 0; i < pool->job_count; i++) free(pool->jobs[i]);
+    sem_destroy(&pool->wake);
+    pthread_rwlock_destroy(&pool->jobs_lock);
+    free(pool);
+}
+
+DecoderJob *decoder_pool_add(DecoderPool *pool, DecoderJobStep step, void *context, int poll_ms) {
+    if (!pool || !step) return NULL;
+
+    DecoderJob *job = calloc(1, sizeof(DecoderJob));
+    if (!job) return NULL;
+
+    job->pool = pool;
+    job->step = step;
+    job->context = context;
+    atomic_init(&job->poll_ns, (uint64_t)(poll_ms > 0 ? poll_ms : DECODER_POOL_IDLE_MS) * 1000000ULL);
+    atomic_init(&job->pending, true);
+    atomic_init(&job->running, false);
+    atomic_init(&job->next_poll_ns, 0);
+
+    pthread_rwlock_wrlock(&pool->jobs_lock);
+    if (pool->job_count == DECODER_POOL_MAX_JOBS) {
+        pthread_rwlock_unlock(&pool->jobs_lock);
+        free(job);
+        return NULL;
+    }
+    job->home = pool->next_home++ % pool->thread_count;
+    pool->jobs[pool->job_count++] = job;
+    pthread_rwlock_unlock(&pool->jobs_lock);
+
+    sem_post(&pool->wake);
+    return job;
+}
+
+void decoder_pool_remove(DecoderPool *pool, DecoderJob *job) {
+    if (!pool || !job) return;
+
+    // holding the write side means no worker is inside a step
+    pthread_rwlock_wrlock(&pool->jobs_lock);
+    for (int i = 0; i < pool->job_count; i++) {
+        if (pool->jobs[i] == job) {
+            pool->jobs[i] = pool->jobs[--pool->job_count];
+            break;
+        }
+    }
+    pthread_rwlock_unlock(&pool->jobs_lock);
+    free(job);
+}
+
+void decoder_pool_wake(DecoderJob *job) {
+    if (!job) return;
+    if (!atomic_exchange_explicit(&job->pending, true, memory_order_release)) {
+        sem_post(&job->pool->wake);
+    }
+}
+
+void decoder_pool_set_poll(DecoderJob *job, int poll_ms) {
+    if (!job) return;
+    uint64_t poll_ns = (uint64_t)(poll_ms > 0 ? poll_ms : DECODER_POOL_IDLE_MS) * 1000000ULL;
+    atomic_store_explicit(&job->poll_ns, poll_ns, memory_order_relaxed);
+    // a shorter interval takes effect now rather than after the old one runs out
+    uint64_t next = now_ns() + poll_ns;
+    if (next < atomic_load_explicit(&job->next_poll_ns, memory_order_relaxed)) {
+        atomic_store_explicit(&job->next_poll_ns, next, memory_order_relaxed);
+        sem_post(&job->pool->wake);
+    }
+}
+
+void decoder_pool_get_stats(DecoderPool *pool, DecoderPoolStats *stats) {
+    if (!pool || !stats) return;
+
+    pthread_rwlock_rdlock(&pool->jobs_lock);
+    stats->threads = pool->thread_count;
+    stats->jobs = pool->job_count;
+    pthread_rwlock_unlock(&pool->jobs_lock);
+    stats->steps = atomic_load_explicit(&pool->steps, memory_order_relaxed);
+    stats->steals = atomic_load_explicit(&pool->steals, memory_order_relaxed);
+    stats->wakeups = atomic_load_explicit(&pool->wakeups, memory_order_relaxed);
+}
@@ -0,0 +1,373 @@
+#include "core/dsp_chain.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+
+#define DSP_SMOOTHING_SECONDS 0.02f
+#define DSP_SNAP_EPSILON 1e-6f
+#define DSP_DENORMAL_LIMIT 1e-25f
+
+// one lane per channel; GCC/Clang lower this to SSE or NEON registers
+typedef float DspVec __attribute__((vector_size(DSP_MAX_CHANNELS * sizeof(float))));
+
+typedef struct {
+    float b0, b1, b2, a1, a2;
+} Coeffs;
+
+typedef struct {
+    // published by the control thread; odd seq means a write is in progress
+    atomic_uint seq;
+    DspStageParams params;
+
+    // audio thread only
+    unsigned seen_seq;
+    DspStageParams live;
+    int design_rate;
+    bool ramping;
+    Coeffs target;
+    Coeffs current;
+    DspVec z1, z2;
+} DspStage;
+
+struct DspChain {
+    DspStage stages[DSP_MAX_STAGES];
+    atomic_int count;
+    atomic_bool enabled;
+
+    // audio thread only
+    bool was_enabled;
+    int channels;
+};
+
+static const Coeffs IDENTITY = { 1.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+
+// RBJ audio EQ cookbook, evaluated in double so low bands at high rates stay accurate
+static void design_stage(const DspStageParams *params, int sample_rate, Coeffs *out) {
+    if (!params->enabled || sample_rate <= 0 || params->gain_db == 0.0f) {
+        *out = IDENTITY;
+        return;
+    }
+
+    if (params->type == DSP_STAGE_PREAMP) {
+        *out = IDENTITY;
+        out->b0 = powf(10.0f, params->gain_db / 20.0f);
+        return;
+    }
+
+    double frequency = params->frequency;
+    if (frequency > sample_rate * 0.45) frequency = sample_rate * 0.45;
+    if (frequency < 1.0) frequency = 1.0;
+    double q = params->q > 0.01f ? params->q : 0.01;
+
+    double A = pow(10.0, params->gain_db / 40.0);
+    double w0 = 2.0 * M_PI * frequency / sample_rate;
+    double cos_w0 = cos(w0);
+    double alpha = sin(w0) / (2.0 * q);
+    double b0, b1, b2, a0, a1, a2;
+
+    if (params->type == DSP_STAGE_PEAKING) {
+        b0 = 1.0 + alpha * A;
+        b1 = -2.0 * cos_w0;
+        b2 = 1.0 - alpha * A;
+        a0 = 1.0 + alpha / A;
+        a1 = -2.0 * cos_w0;
+        a2 = 1.0 - alpha / A;
+    } else {
+        // shelves take q as the slope S, 1.0 being the steepest without overshoot
+        double slope_term = (A + 1.0 / A) * (1.0 / q - 1.0) + 2.0;
+        double shelf_alpha = sin(w0) / 2.0 * sqrt(slope_term > 0.0 ? slope_term : 0.0);
+        double k = 2.0 * sqrt(A) * shelf_alpha;
+        double sign = params->type == DSP_STAGE_LOW_SHELF ? 1.0 : -1.0;
+
+        b0 = A * ((A + 1.0) - sign * (A - 1.0) * cos_w0 + k);
+        b1 = sign * 2.0 * A * ((A - 1.0) - sign * (A + 1.0) * cos_w0);
+        b2 = A * ((A + 1.0) - sign * (A - 1.0) * cos_w0 - k);
+        a0 = (A + 1.0) + sign * (A - 1.0) * cos_w0 + k;
+        a1 = -sign * 2.0 * ((A - 1.0) + sign * (A + 1.0) * cos_w0);
+        a2 = (A + 1.0) + sign * (A - 1.0) * cos_w0 - k;
+    }
+
+    out->b0 = (float)(b0 / a0);
+    out->b1 = (float)(b1 / a0);
+    out->b2 = (float)(b2 / a0);
+    out->a1 = (float)(a1 / a0);
+    out->a2 = (float)(a2 / a0);
+}
+
+static bool coeffs_is_identity(const Coeffs *c) {
+    return c->b0 == 1.0f && c->b1 == 0.0f && c->b2 == 0.0f && c->a1 == 0.0f && c->a2 == 0.0f;
+}
+
+static bool coeffs_is_gain(const Coeffs *c) {
+    return c->b1 == 0.0f && c->b2 == 0.0f && c->a1 == 0.0f && c->a2 == 0.0f;
+}
+
+static inline DspVec load_frame(const float *frame, int channels) {
+    DspVec v = {0};
+    for (int c = 0; c < channels; c++) v[c] = frame[c];
+    return v;
+}
+
+static inline void store_frame(float *frame, DspVec v, int channels) {
+    for (int c = 0; c < channels; c++) frame[c] = v[c];
+}
+
+// channels is a constant at every call site below, so the frame loads and stores unroll
+static inline __attribute__((always_inline)) void ramp_block(DspStage *stage, float *samples, size_t frames,
+                                                             int channels, Coeffs c, const Coeffs *step) {
+    DspVec z1 = stage->z1;
+    DspVec z2 = stage->z2;
+
+    for (size_t i = 0; i < frames; i++) {
+        float *frame = samples + i * channels;
+        DspVec x = load_frame(frame, channels);
+        DspVec y = c.b0 * x + z1;
+        z1 = c.b1 * x - c.a1 * y + z2;
+        z2 = c.b2 * x - c.a2 * y;
+        store_frame(frame, y, channels);
+
+        c.b0 += step->b0;
+        c.b1 += step->b1;
+        c.b2 += step->b2;
+        c.a1 += step->a1;
+        c.a2 += step->a2;
+    }
+
+    // silence decays the state into denormals, which are very slow on x86
+    for (int ch = 0; ch < DSP_MAX_CHANNELS; ch++) {
+        if (fabsf(z1[ch]) < DSP_DENORMAL_LIMIT) z1[ch] = 0.0f;
+        if (fabsf(z2[ch]) < DSP_DENORMAL_LIMIT) z2[ch] = 0.0f;
+    }
+    stage->z1 = z1;
+    stage->z2 = z2;
+}
+
+// steady stages run frame by frame through the whole cascade: each stage's recursion is
+// a serial dependency, and interleaving the stages lets them overlap in the pipeline
+static inline __attribute__((always_inline)) void cascade_block(DspStage **stages, int count, float *samples,
+                                                                size_t frames, int channels) {
+    Coeffs c[DSP_MAX_STAGES];
+    DspVec z1[DSP_MAX_STAGES], z2[DSP_MAX_STAGES];
+    for (int s = 0; s < count; s++) {
+        c[s] = stages[s]->current;
+        z1[s] = stages[s]->z1;
+        z2[s] = stages[s]->z2;
+    }
+
+    for (size_t i = 0; i < frames; i++) {
+        float *frame = samples + i * channels;
+        DspVec x = load_frame(frame, channels);
+        for (int s = 0; s < count; s++) {
+            DspVec y = c[s].b0 * x + z1[s];
+            z1[s] = c[s].b1 * x - c[s].a1 * y + z2[s];
+            z2[s] = c[s].b2 * x - c[s].a2 * y;
+            x = y;
+        }
+        store_frame(frame, x, channels);
+    }
+
+    for (int s = 0; s < count; s++) {
+        for (int ch = 0; ch < DSP_MAX_CHANNELS; ch++) {
+            if (fabsf(z1[s][ch]) < DSP_DENORMAL_LIMIT) z1[s][ch] = 0.0f;
+            if (fabsf(z2[s][ch]) < DSP_DENORMAL_LIMIT) z2[s][ch] = 0.0f;
+        }
+        stages[s]->z1 = z1[s];
+        stages[s]->z2 = z2[s];
+    }
+}
+
+static void run_cascade(DspStage **stages, int count, float *samples, size_t frames, int channels) {
+    if (count == 0) return;
+    if (count == 1 && coeffs_is_gain(&stages[0]->current)) {
+        float gain = stages[0]->current.b0;
+        for (size_t i = 0; i < frames * (size_t)channels; i++) samples[i] *= gain;
+        return;
+    }
+
+    switch (channels) {
+        case 1: cascade_block(stages, count, samples, frames, 1); break;
+        case 2: cascade_block(stages, count, samples, frames, 2); break;
+        default: cascade_block(stages, count, samples, frames, channels); break;
+    }
+}
+
+static void run_ramp(DspStage *stage, float *samples, size_t frames, int channels, const Coeffs *step) {
+    switch (channels) {
+        case 1: ramp_block(stage, samples, frames, 1, stage->current, step); break;
+        case 2: ramp_block(stage, samples, frames, 2, stage->current, step); break;
+        default: ramp_block(stage, samples, frames, channels, stage->current, step); break;
+    }
+}
+
+static void reset_state(DspStage *stage) {
+    DspVec zero = {0};
+    stage->z1 = zero;
+    stage->z2 = zero;
+}
+
+// never waits: a write in progress is simply picked up on the next block
+static bool pickup_params(DspStage *stage) {
+    unsigned seq = atomic_load_explicit(&stage->seq, memory_order_acquire);
+    if (seq == stage->seen_seq || (seq & 1)) return false;
+
+    DspStageParams params = stage->params;
+    atomic_thread_fence(memory_order_acquire);
+    if (atomic_load_explicit(&stage->seq, memory_order_relaxed) != seq) return false;
+
+    stage->live = params;
+    stage->seen_seq = seq;
+    return true;
+}
+
+static void update_stage(DspStage *stage, int sample_rate) {
+    bool changed = pickup_params(stage);
+    if (stage->design_rate != sample_rate) {
+        design_stage(&stage->live, sample_rate, &stage->target);
+        stage->current = stage->target;
+        stage->design_rate = sample_rate;
+        stage->ramping = false;
+    } else if (changed) {
+        design_stage(&stage->live, sample_rate, &stage->target);
+        stage->ramping = true;
+    }
+}
+
+static void ramp_stage(DspStage *stage, float *samples, size_t frames, int channels, int sample_rate) {
+    // glide a fraction of the way to the target per block, linearly within the block
+    float alpha = 1.0f - expf(-(float)frames / (DSP_SMOOTHING_SECONDS * (float)sample_rate));
+    const Coeffs *from = &stage->current;
+    const Coeffs *to = &stage->target;
+    Coeffs end = {
+        from->b0 + (to->b0 - from->b0) * alpha,
+        from->b1 + (to->b1 - from->b1) * alpha,
+        from->b2 + (to->b2 - from->b2) * alpha,
+        from->a1 + (to->a1 - from->a1) * alpha,
+        from->a2 + (to->a2 - from->a2) * alpha,
+    };
+    float remaining = fabsf(to->b0 - end.b0) + fabsf(to->b1 - end.b1) + fabsf(to->b2 - end.b2) +
+                      fabsf(to->a1 - end.a1) + fabsf(to->a2 - end.a2);
+    if (remaining < DSP_SNAP_EPSILON) {
+        end = *to;
+        stage->ramping = false;
+    }
+
+    // both ends are stable and the stability region of (a1, a2) is convex,
+    // so every interpolated filter is stable as well
+    float inv = 1.0f / (float)frames;
+    Coeffs step = {
+        (end.b0 - from->b0) * inv,
+        (end.b1 - from->b1) * inv,
+        (end.b2 - from->b2) * inv,
+        (end.a1 - from->a1) * inv,
+        (end.a2 - from->a2) * inv,
+    };
+    run_ramp(stage, samples, frames, channels, &step);
+    stage->current = end;
+}
+
+DspChain* dsp_chain_create(void) {
+    DspChain *chain = calloc(1, sizeof(DspChain));
+    if (!chain) return NULL;
+
+    atomic_init(&chain->count, 0);
+    atomic_init(&chain->enabled, true);
+    for (int i = 0; i < DSP_MAX_STAGES; i++) {
+        atomic_init(&chain->stages[i].seq, 0);
+    }
+    return chain;
+}
+
+void dsp_chain_destroy(DspChain *chain) {
+    free(chain);
+}
+
+int dsp_chain_add_stage(DspChain *chain, const DspStageParams *params) {
+    if (!chain || !params) return -1;
+
+    int index = atomic_load(&chain->count);
+    if (index >= DSP_MAX_STAGES) return -1;
+
+    // the audio thread does not look at the slot until count is published
+    DspStage *stage = &chain->stages[index];
+    stage->params = *params;
+    stage->seen_seq = 0;
+    stage->design_rate = 0;
+    stage->ramping = false;
+    stage->current = IDENTITY;
+    stage->target = IDENTITY;
+    reset_state(stage);
+    atomic_store_explicit(&stage->seq, 2, memory_order_relaxed);
+    atomic_store_explicit(&chain->count, index + 1, memory_order_release);
+    return index;
+}
+
+int dsp_chain_set_stage(DspChain *chain, int index, const DspStageParams *params) {
+    if (!chain || !params || index < 0 || index >= atomic_load(&chain->count)) return -1;
+
+    DspStage *stage = &chain->stages[index];
+    unsigned seq = atomic_load_explicit(&stage->seq, memory_order_relaxed);
+    atomic_store_explicit(&stage->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    stage->params = *params;
+    atomic_store_explicit(&stage->seq, seq + 2, memory_order_release);
+    return 0;
+}
+
+int dsp_chain_get_stage(DspChain *chain, int index, DspStageParams *params) {
+    if (!chain || !params || index < 0 || index >= atomic_load(&chain->count)) return -1;
+
+    *params = chain->stages[index].params;
+    return 0;
+}
+
+int dsp_chain_stage_count(DspChain *chain) {
+    return chain ? atomic_load(&chain->count) : 0;
+}
+
+void dsp_chain_set_enabled(DspChain *chain, bool enabled) {
+    if (chain) atomic_store(&chain->enabled, enabled);
+}
+
+bool dsp_chain_is_enabled(DspChain *chain) {
+    return chain && atomic_load(&chain->enabled);
+}
+
+void dsp_chain_process(DspChain *chain, float *samples, size_t frames, int channels, int sample_rate) {
+    if (!chain || !samples || frames == 0 || channels <= 0 || channels > DSP_MAX_CHANNELS) return;
+
+    if (!atomic_load_explicit(&chain->enabled, memory_order_relaxed)) {
+        chain->was_enabled = false;
+        return;
+    }
+
+    int count = atomic_load_explicit(&chain->count, memory_order_acquire);
+
+    // filter memory from before a bypass or a layout change would click
+    if (!chain->was_enabled || chain->channels != channels) {
+        for (int i = 0; i < count; i++) {
+            reset_state(&chain->stages[i]);
+            chain->stages[i].design_rate = 0;
+        }
+        chain->was_enabled = true;
+        chain->channels = channels;
+    }
+
+    DspStage *run[DSP_MAX_STAGES];
+    int run_count = 0;
+    for (int i = 0; i < count; i++) {
+        DspStage *stage = &chain->stages[i];
+        update_stage(stage, sample_rate);
+
+        if (stage->ramping) {
+            run_cascade(run, run_count, samples, frames, channels);
+            run_count = 0;
+            ramp_stage(stage, samples, frames, channels, sample_rate);
+        } else if (coeffs_is_identity(&stage->current)) {
+            reset_state(stage);
+        } else {
+            run[run_count++] = stage;
+        }
+    }
+    run_cascade(run, run_count, samples, frames, channels);
+}
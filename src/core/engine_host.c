@@ -0,0 +1,219 @@
+#include "core/engine_host.h"
+#include "core/trace.h"
+#include "shared/engine_shm.h"
+#include "core/log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+#define HOST_PUBLISH_MS 10
+#define HOST_WAVEFORM_TICKS 50          // overview refresh while it is still being built
+
+struct EngineHost {
+    RhythmEngine* engine;
+    EngineShm* shm;
+    char name[64];
+    pthread_t thread;
+    bool thread_started;
+    atomic_bool running;
+
+    // host thread only
+    RhythmStatusFrame frame;
+    RhythmEqualizer eq;
+    EngineShmWaveform waveform;
+    uint32_t waveform_file;
+};
+
+RhythmError engine_host_run_command(RhythmEngine* engine, int type, int index, float value, const char* path) {
+    switch ((EngineCommandType)type) {
+        case ENGINE_COMMAND_LOAD_FILE:
+            return rhythm_engine_load_file(engine, path);
+        case ENGINE_COMMAND_LOAD_DIRECTORY:
+            return rhythm_engine_load_directory(engine, path);
+        case ENGINE_COMMAND_PLAY:
+            return rhythm_engine_play(engine);
+        case ENGINE_COMMAND_PAUSE:
+            return rhythm_engine_pause(engine);
+        case ENGINE_COMMAND_STOP:
+            return rhythm_engine_stop(engine);
+        case ENGINE_COMMAND_NEXT_TRACK:
+            return rhythm_engine_next_track(engine);
+        case ENGINE_COMMAND_PREVIOUS_TRACK:
+            return rhythm_engine_previous_track(engine);
+        case ENGINE_COMMAND_SEEK:
+            return rhythm_engine_seek(engine, value);
+        case ENGINE_COMMAND_SET_VOLUME:
+            return rhythm_engine_set_volume(engine, value);
+        case ENGINE_COMMAND_SET_EQ_ENABLED:
+            return rhythm_engine_set_eq_enabled(engine, index != 0);
+        case ENGINE_COMMAND_SET_EQ_BAND:
+            return rhythm_engine_set_eq_band(engine, index, value);
+        case ENGINE_COMMAND_SET_EQ_PREAMP:
+            return rhythm_engine_set_eq_preamp(engine, value);
+        case ENGINE_COMMAND_SET_INTERACTIVE:
+            return rhythm_engine_set_interactive(engine, index != 0);
+    }
+    return RHYTHM_ERROR_INVALID_STATE;
+}
+
+// returns the position to acknowledge once the resulting state is published
+static unsigned run_commands(EngineHost* host) {
+    EngineShm* shm = host->shm;
+    unsigned read = atomic_load_explicit(&shm->command_read, memory_order_relaxed);
+    unsigned write = atomic_load_explicit(&shm->command_write, memory_order_acquire);
+
+    for (; read != write; read++) {
+        TRACE_SCOPE("host_command");
+        EngineCommand* command = &shm->commands[read & (ENGINE_SHM_COMMANDS - 1)];
+        command->path[ENGINE_SHM_PATH_MAX - 1] = '\0';
+        command->result = engine_host_run_command(host->engine, command->type, command->index,
+                                                  command->value, command->path);
+    }
+    return write;
+}
+
+static void refresh(EngineHost* host, bool full) {
+    rhythm_engine_update(host->engine);
+    rhythm_engine_get_status_frame(host->engine, &host->frame);
+    if (full) {
+        rhythm_engine_get_eq(host->engine, &host->eq);
+    }
+
+    // the overview is fetched again while it fills in and whenever the track changes
+    bool new_file = host->frame.file_sequence != host->waveform_file;
+    if (new_file || (full && host->waveform.ready < 1.0f)) {
+        if (rhythm_engine_get_waveform(host->engine, 0.0f, 1.0f, host->waveform.buckets,
+                                       ENGINE_SHM_WAVEFORM_BUCKETS, &host->waveform.ready) != RHYTHM_OK) {
+            memset(&host->waveform, 0, sizeof(host->waveform));
+        }
+        host->waveform_file = host->frame.file_sequence;
+    }
+}
+
+static void publish(EngineHost* host) {
+    EngineShm* shm = host->shm;
+    unsigned seq = atomic_load_explicit(&shm->sequence, memory_order_relaxed);
+    atomic_store_explicit(&shm->sequence, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    shm->frame = host->frame;
+    shm->eq = host->eq;
+    shm->waveform = host->waveform;
+    atomic_store_explicit(&shm->sequence, seq + 2, memory_order_release);
+}
+
+static void* host_thread_main(void* arg) {
+    EngineHost* host = arg;
+    TRACE_THREAD_NAME("engine_host");
+
+    for (long tick = 1; atomic_load_explicit(&host->running, memory_order_relaxed); tick++) {
+        // commands wake the host at once; otherwise it republishes every HOST_PUBLISH_MS,
+        // or once per engine tick while nobody is looking
+        long interval_ms = rhythm_engine_is_low_power(host->engine) ? rhythm_engine_get_tick_interval_ms(host->engine)
+                                                                     : HOST_PUBLISH_MS;
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += interval_ms / 1000;
+        deadline.tv_nsec += (interval_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        while (sem_timedwait(&host->shm->command_wake, &deadline) != 0 && errno == EINTR) {}
+
+        unsigned done = run_commands(host);
+        bool ran = done != atomic_load_explicit(&host->shm->command_read, memory_order_relaxed);
+        refresh(host, ran || tick % HOST_WAVEFORM_TICKS == 0);
+        publish(host);
+        atomic_store_explicit(&host->shm->command_read, done, memory_order_release);
+    }
+    return NULL;
+}
+
+EngineHost* engine_host_create(RhythmEngine* engine, const char* name) {
+    if (!engine) return NULL;
+
+    EngineHost* host = calloc(1, sizeof(EngineHost));
+    if (!host) return NULL;
+
+    host->engine = engine;
+    if (name) {
+        snprintf(host->name, sizeof(host->name), "%s", name);
+    } else {
+        snprintf(host->name, sizeof(host->name), "/rhythm-engine-%d", (int)getpid());
+    }
+
+    // a segment left by a crashed host with the same name is replaced
+    int fd = shm_open(host->name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0 && errno == EEXIST) {
+        shm_unlink(host->name);
+        fd = shm_open(host->name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    }
+    if (fd < 0) {
+        LOG_ERROR("Failed to create shared memory %s: %s", host->name, strerror(errno));
+        free(host);
+        return NULL;
+    }
+
+    EngineShm* shm = MAP_FAILED;
+    if (ftruncate(fd, sizeof(EngineShm)) == 0) {
+        shm = mmap(NULL, sizeof(EngineShm), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (shm == MAP_FAILED) {
+        LOG_ERROR("Failed to map shared memory %s: %s", host->name, strerror(errno));
+        shm_unlink(host->name);
+        free(host);
+        return NULL;
+    }
+
+    host->shm = shm;
+    shm->version = ENGINE_SHM_VERSION;
+    shm->host_pid = (int32_t)getpid();
+    atomic_init(&shm->sequence, 0);
+    atomic_init(&shm->command_write, 0);
+    atomic_init(&shm->command_read, 0);
+    sem_init(&shm->command_wake, 1, 0);
+
+    host->waveform_file = UINT32_MAX;
+    refresh(host, true);
+    publish(host);
+
+    // clients check the magic, so it goes in last
+    atomic_thread_fence(memory_order_release);
+    shm->magic = ENGINE_SHM_MAGIC;
+
+    atomic_init(&host->running, true);
+    if (pthread_create(&host->thread, NULL, host_thread_main, host) != 0) {
+        LOG_ERROR("Failed to start engine host thread");
+        engine_host_destroy(host);
+        return NULL;
+    }
+    host->thread_started = true;
+    return host;
+}
+
+void engine_host_destroy(EngineHost* host) {
+    if (!host) return;
+
+    if (host->thread_started) {
+        atomic_store(&host->running, false);
+        sem_post(&host->shm->command_wake);
+        pthread_join(host->thread, NULL);
+    }
+
+    host->shm->magic = 0;
+    sem_destroy(&host->shm->command_wake);
+    munmap(host->shm, sizeof(EngineShm));
+    shm_unlink(host->name);
+    free(host);
+}
+
+const char* engine_host_name(EngineHost* host) {
+    return host ? host->name : NULL;
+}
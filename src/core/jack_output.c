@@ -0,0 +1,248 @@
+#include "core/jack_output.h"
+#include "core/log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+
+#define MAX_JACK_CHANNELS 8
+
+struct JackOutput {
+    jack_client_t *client;
+    jack_port_t *ports[MAX_JACK_CHANNELS];
+    int channels;
+    float *scratch;
+
+    JackRenderCallback render;
+    JackFormatCallback format_changed;
+    void *user_data;
+
+    atomic_int sample_rate;
+    atomic_int period_frames;
+    atomic_ulong xruns;
+    atomic_bool follow_transport;
+    atomic_bool transport_rolling;
+    atomic_bool active;
+};
+
+static int jack_process(jack_nframes_t nframes, void *arg) {
+    JackOutput *output = (JackOutput *)arg;
+    float *buffers[MAX_JACK_CHANNELS];
+
+    for (int ch = 0; ch < output->channels; ch++) {
+        buffers[ch] = (float *)jack_port_get_buffer(output->ports[ch], nframes);
+    }
+
+    jack_transport_state_t transport = jack_transport_query(output->client, NULL);
+    bool rolling = (transport == JackTransportRolling);
+    atomic_store_explicit(&output->transport_rolling, rolling, memory_order_relaxed);
+
+    bool follow = atomic_load_explicit(&output->follow_transport, memory_order_relaxed);
+    if (nframes > JACK_MAX_PERIOD_FRAMES || (follow && !rolling)) {
+        for (int ch = 0; ch < output->channels; ch++) {
+            memset(buffers[ch], 0, nframes * sizeof(float));
+        }
+        return 0;
+    }
+
+    output->render(output->scratch, nframes, output->user_data);
+
+    for (int ch = 0; ch < output->channels; ch++) {
+        float *dst = buffers[ch];
+        const float *src = output->scratch + ch;
+        for (jack_nframes_t i = 0; i < nframes; i++) {
+            dst[i] = src[i * output->channels];
+        }
+    }
+
+    return 0;
+}
+
+static int jack_xrun(void *arg) {
+    JackOutput *output = (JackOutput *)arg;
+    atomic_fetch_add_explicit(&output->xruns, 1, memory_order_relaxed);
+    return 0;
+}
+
+static int jack_buffer_size_changed(jack_nframes_t nframes, void *arg) {
+    JackOutput *output = (JackOutput *)arg;
+    if (nframes > JACK_MAX_PERIOD_FRAMES) {
+        LOG_WARN("JACK period of %u frames exceeds supported maximum of %d",
+                 nframes, JACK_MAX_PERIOD_FRAMES);
+    }
+    atomic_store(&output->period_frames, (int)nframes);
+    if (output->format_changed) {
+        output->format_changed(atomic_load(&output->sample_rate), (int)nframes, output->user_data);
+    }
+    return 0;
+}
+
+static int jack_sample_rate_changed(jack_nframes_t nframes, void *arg) {
+    JackOutput *output = (JackOutput *)arg;
+    atomic_store(&output->sample_rate, (int)nframes);
+    if (output->format_changed) {
+        output->format_changed((int)nframes, atomic_load(&output->period_frames), output->user_data);
+    }
+    return 0;
+}
+
+static void jack_shutdown(void *arg) {
+    JackOutput *output = (JackOutput *)arg;
+    atomic_store(&output->active, false);
+    LOG_WARN("JACK server shut down, audio output lost");
+}
+
+static void connect_physical_ports(JackOutput *output) {
+    const char **playback = jack_get_ports(output->client, NULL, JACK_DEFAULT_AUDIO_TYPE,
+                                           JackPortIsPhysical | JackPortIsInput);
+    if (!playback) {
+        LOG_WARN("No physical JACK playback ports to connect to");
+        return;
+    }
+
+    for (int ch = 0; ch < output->channels && playback[ch]; ch++) {
+        if (jack_connect(output->client, jack_port_name(output->ports[ch]), playback[ch]) != 0) {
+            LOG_WARN("Cannot connect %s to %s", jack_port_name(output->ports[ch]), playback[ch]);
+        }
+    }
+
+    jack_free(playback);
+}
+
+JackOutput* jack_output_create(const char *client_name, int channels,
+                               JackRenderCallback render, JackFormatCallback format_changed,
+                               void *user_data) {
+    if (!render || channels < 1 || channels > MAX_JACK_CHANNELS) return NULL;
+
+    JackOutput *output = calloc(1, sizeof(JackOutput));
+    if (!output) return NULL;
+
+    output->channels = channels;
+    output->render = render;
+    output->format_changed = format_changed;
+    output->user_data = user_data;
+    atomic_init(&output->xruns, 0);
+    atomic_init(&output->follow_transport, false);
+    atomic_init(&output->transport_rolling, false);
+    atomic_init(&output->active, false);
+
+    output->scratch = calloc((size_t)JACK_MAX_PERIOD_FRAMES * channels, sizeof(float));
+    if (!output->scratch) {
+        free(output);
+        return NULL;
+    }
+
+    jack_status_t status;
+    output->client = jack_client_open(client_name ? client_name : "rhythm", JackNoStartServer, &status);
+    if (!output->client) {
+        LOG_ERROR("Failed to connect to JACK server (status 0x%x)", (unsigned)status);
+        free(output->scratch);
+        free(output);
+        return NULL;
+    }
+
+    atomic_init(&output->sample_rate, (int)jack_get_sample_rate(output->client));
+    atomic_init(&output->period_frames, (int)jack_get_buffer_size(output->client));
+
+    jack_set_process_callback(output->client, jack_process, output);
+    jack_set_xrun_callback(output->client, jack_xrun, output);
+    jack_set_buffer_size_callback(output->client, jack_buffer_size_changed, output);
+    jack_set_sample_rate_callback(output->client, jack_sample_rate_changed, output);
+    jack_on_shutdown(output->client, jack_shutdown, output);
+
+    for (int ch = 0; ch < channels; ch++) {
+        char port_name[32];
+        if (channels == 2) {
+            snprintf(port_name, sizeof(port_name), "out_%s", ch == 0 ? "L" : "R");
+        } else {
+            snprintf(port_name, sizeof(port_name), "out_%d", ch + 1);
+        }
+
+        output->ports[ch] = jack_port_register(output->client, port_name, JACK_DEFAULT_AUDIO_TYPE,
+                                               JackPortIsOutput | JackPortIsTerminal, 0);
+        if (!output->ports[ch]) {
+            LOG_ERROR("Failed to register JACK port %s", port_name);
+            jack_client_close(output->client);
+            free(output->scratch);
+            free(output);
+            return NULL;
+        }
+    }
+
+    return output;
+}
+
+void jack_output_destroy(JackOutput *output) {
+    if (!output) return;
+
+    jack_output_stop(output);
+    if (output->client) {
+        jack_client_close(output->client);
+    }
+    free(output->scratch);
+    free(output);
+}
+
+int jack_output_start(JackOutput *output) {
+    if (!output || !output->client) return -1;
+    if (atomic_load(&output->active)) return 0;
+
+    if (jack_activate(output->client) != 0) {
+        LOG_ERROR("Failed to activate JACK client");
+        return -1;
+    }
+    atomic_store(&output->active, true);
+
+    if (!getenv("RHYTHM_JACK_NO_CONNECT")) {
+        connect_physical_ports(output);
+    }
+
+    return 0;
+}
+
+void jack_output_stop(JackOutput *output) {
+    if (!output || !output->client || !atomic_load(&output->active)) return;
+
+    jack_deactivate(output->client);
+    atomic_store(&output->active, false);
+}
+
+int jack_output_get_sample_rate(JackOutput *output) {
+    return output ? atomic_load(&output->sample_rate) : 0;
+}
+
+int jack_output_get_period_frames(JackOutput *output) {
+    return output ? atomic_load(&output->period_frames) : 0;
+}
+
+unsigned long jack_output_get_xrun_count(JackOutput *output) {
+    return output ? atomic_load(&output->xruns) : 0;
+}
+
+double jack_output_get_latency(JackOutput *output) {
+    if (!output || !output->client) return 0.0;
+
+    jack_latency_range_t range;
+    jack_port_get_latency_range(output->ports[0], JackPlaybackLatency, &range);
+    int rate = atomic_load(&output->sample_rate);
+    return rate > 0 ? (double)range.max / rate : 0.0;
+}
+
+void jack_output_set_follow_transport(JackOutput *output, bool follow) {
+    if (!output) return;
+    atomic_store(&output->follow_transport, follow);
+}
+
+bool jack_output_transport_rolling(JackOutput *output) {
+    return output ? atomic_load(&output->transport_rolling) : false;
+}
+
+void jack_output_transport_start(JackOutput *output) {
+    if (!output || !output->client || !atomic_load(&output->follow_transport)) return;
+    jack_transport_start(output->client);
+}
+
+void jack_output_transport_stop(JackOutput *output) {
+    if (!output || !output->client || !atomic_load(&output->follow_transport)) return;
+    jack_transport_stop(output->client);
+}
@@ -0,0 +1,394 @@
+#include "core/log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <time.h>
+
+#define LOG_RATE_WINDOW_NS 1000000000ULL
+#define LOG_DRAIN_BATCH 256
+
+typedef struct {
+    uint64_t time_ns;           // CLOCK_REALTIME
+    const char *format;
+    LogLevel level;
+    uint32_t suppressed;        // from this site since the last record that got through
+    uint8_t count;
+    LogArgType types[LOG_MAX_ARGS];
+    union {
+        int64_t i;
+        uint64_t u;
+        double d;
+        uint32_t text;          // strings: offset into text
+        const void *p;
+    } args[LOG_MAX_ARGS];
+    char text[LOG_TEXT_BYTES];
+} LogRecord;
+
+enum {
+    RING_FREE,
+    RING_OWNED,
+    RING_ORPHANED               // owner exited; freed once drained
+};
+
+// one writer (the owning thread) and one reader (whoever holds drain_lock)
+typedef struct {
+    atomic_int state;
+    atomic_uint write_pos;
+    atomic_uint read_pos;
+    LogRecord records[LOG_RING_RECORDS];
+} LogRing;
+
+static LogRing rings[LOG_MAX_THREADS];
+static _Thread_local LogRing *thread_ring;
+static _Thread_local bool thread_ringless;
+
+static pthread_once_t log_once = PTHREAD_ONCE_INIT;
+static pthread_key_t ring_key;
+static sem_t drain_wake;
+static atomic_bool wake_posted;
+static atomic_int min_level = LOG_LEVEL_INFO;
+
+static atomic_uint_least64_t stat_written;
+static atomic_uint_least64_t stat_dropped;
+static atomic_uint_least64_t stat_suppressed;
+
+// drain_lock serialises readers; sink_lock guards the sink settings
+static pthread_mutex_t drain_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t sink_lock = PTHREAD_MUTEX_INITIALIZER;
+static FILE *sink_file;
+static LogCallback sink_callback;
+static void *sink_user_data;
+
+static const char *LEVEL_NAMES[LOG_LEVELS] = { "debug", "info", "warn", "error" };
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// appends one conversion of args[index] to out; spec holds flags, width and precision
+static int format_arg(char *out, size_t size, const char *spec, size_t spec_length, char conversion,
+                      const LogRecord *record, int index) {
+    char format[32];
+    if (spec_length > sizeof(format) - 4) spec_length = sizeof(format) - 4;
+    memcpy(format, spec, spec_length);
+
+    LogArgType type = record->types[index];
+    switch (conversion) {
+        case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': case 'c': {
+            if (type == LOG_ARG_DOUBLE || type == LOG_ARG_STRING) break;
+            if (conversion == 'c') {
+                memcpy(format + spec_length, "c", 2);
+                return snprintf(out, size, format, (int)record->args[index].i);
+            }
+            format[spec_length] = 'l';
+            format[spec_length + 1] = 'l';
+            format[spec_length + 2] = conversion;
+            format[spec_length + 3] = '\0';
+            if (conversion == 'd' || conversion == 'i') {
+                return snprintf(out, size, format, (long long)record->args[index].i);
+            }
+            return snprintf(out, size, format, (unsigned long long)record->args[index].u);
+        }
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            if (type != LOG_ARG_DOUBLE) break;
+            format[spec_length] = conversion;
+            format[spec_length + 1] = '\0';
+            return snprintf(out, size, format, record->args[index].d);
+        case 's':
+            if (type != LOG_ARG_STRING) break;
+            format[spec_length] = 's';
+            format[spec_length + 1] = '\0';
+            return snprintf(out, size, format, record->text + record->args[index].text);
+        case 'p':
+            format[spec_length] = 'p';
+            format[spec_length + 1] = '\0';
+            return snprintf(out, size, format, record->args[index].p);
+    }
+    return snprintf(out, size, "<?>");
+}
+
+static void format_record(const LogRecord *record, char *out, size_t size) {
+    size_t used = 0;
+    int index = 0;
+    const char *p = record->format;
+
+    while (*p && used + 1 < size) {
+        if (*p != '%') {
+            out[used++] = *p++;
+            continue;
+        }
+        if (p[1] == '%') {
+            out[used++] = '%';
+            p += 2;
+            continue;
+        }
+
+        // %[flags][width][.precision][length]conversion; the length is the argument's business
+        const char *spec = p++;
+        while (*p && strchr("-+ #0", *p)) p++;
+        while (*p >= '0' && *p <= '9') p++;
+        if (*p == '.') {
+            p++;
+            while (*p >= '0' && *p <= '9') p++;
+        }
+        size_t spec_length = (size_t)(p - spec);
+        while (*p && strchr("hlLqjzt", *p)) p++;
+        if (!*p) break;
+
+        char conversion = *p++;
+        int written = index < record->count
+                          ? format_arg(out + used, size - used, spec, spec_length, conversion, record, index)
+                          : snprintf(out + used, size - used, "<missing>");
+        index++;
+        if (written > 0) used += (size_t)written < size - used ? (size_t)written : size - used - 1;
+    }
+    out[used] = '\0';
+
+    if (record->suppressed > 0 && used + 1 < size) {
+        snprintf(out + used, size - used, " (%u similar suppressed)", record->suppressed);
+    }
+}
+
+static void emit(const LogRecord *record) {
+    char message[LOG_MESSAGE_MAX];
+    format_record(record, message, sizeof(message));
+
+    pthread_mutex_lock(&sink_lock);
+    if (sink_callback) {
+        sink_callback(record->level, message, sink_user_data);
+    } else {
+        time_t seconds = (time_t)(record->time_ns / 1000000000ULL);
+        struct tm local;
+        localtime_r(&seconds, &local);
+        FILE *out = sink_file ? sink_file : stderr;
+        fprintf(out, "[%02d:%02d:%02d.%03d] %s: %s\n", local.tm_hour, local.tm_min, local.tm_sec,
+                (int)(record->time_ns / 1000000ULL % 1000), LEVEL_NAMES[record->level], message);
+    }
+    pthread_mutex_unlock(&sink_lock);
+    atomic_fetch_add_explicit(&stat_written, 1, memory_order_relaxed);
+}
+
+static int compare_records(const void *a, const void *b) {
+    const LogRecord *left = *(const LogRecord *const *)a;
+    const LogRecord *right = *(const LogRecord *const *)b;
+    return left->time_ns < right->time_ns ? -1 : left->time_ns > right->time_ns;
+}
+
+// caller holds drain_lock
+static void drain(void) {
+    LogRecord *batch[LOG_DRAIN_BATCH];
+    bool more = true;
+
+    while (more) {
+        more = false;
+        int count = 0;
+        unsigned taken[LOG_MAX_THREADS];
+
+        // a slice of every ring, merged by time so threads interleave as they happened
+        for (int i = 0; i < LOG_MAX_THREADS; i++) {
+            LogRing *ring = &rings[i];
+            taken[i] = 0;
+            if (atomic_load_explicit(&ring->state, memory_order_acquire) == RING_FREE) continue;
+
+            unsigned read = atomic_load_explicit(&ring->read_pos, memory_order_relaxed);
+            unsigned write = atomic_load_explicit(&ring->write_pos, memory_order_acquire);
+            while (read + taken[i] != write && count < LOG_DRAIN_BATCH) {
+                batch[count++] = &ring->records[(read + taken[i]) & (LOG_RING_RECORDS - 1)];
+                taken[i]++;
+            }
+            if (read + taken[i] != write) more = true;
+        }
+
+        qsort(batch, (size_t)count, sizeof(batch[0]), compare_records);
+        for (int i = 0; i < count; i++) emit(batch[i]);
+
+        for (int i = 0; i < LOG_MAX_THREADS; i++) {
+            LogRing *ring = &rings[i];
+            if (taken[i] > 0) atomic_fetch_add_explicit(&ring->read_pos, taken[i], memory_order_release);
+
+            // an exited thread's ring goes back to the pool once nothing is left in it
+            int orphaned = RING_ORPHANED;
+            if (atomic_load_explicit(&ring->read_pos, memory_order_relaxed) ==
+                atomic_load_explicit(&ring->write_pos, memory_order_acquire)) {
+                atomic_compare_exchange_strong(&ring->state, &orphaned, RING_FREE);
+            }
+        }
+    }
+
+    pthread_mutex_lock(&sink_lock);
+    fflush(sink_file ? sink_file : stderr);
+    pthread_mutex_unlock(&sink_lock);
+}
+
+static void *drain_main(void *arg) {
+    (void)arg;
+    for (;;) {
+        while (sem_wait(&drain_wake) != 0) {}
+        atomic_store(&wake_posted, false);
+        pthread_mutex_lock(&drain_lock);
+        drain();
+        pthread_mutex_unlock(&drain_lock);
+    }
+    return NULL;
+}
+
+static void release_ring(void *ring) {
+    atomic_store_explicit(&((LogRing *)ring)->state, RING_ORPHANED, memory_order_release);
+    if (!atomic_exchange(&wake_posted, true)) sem_post(&drain_wake);
+}
+
+static void log_setup(void) {
+    const char *level = getenv("RHYTHM_LOG_LEVEL");
+    for (int i = 0; level && i < LOG_LEVELS; i++) {
+        if (strcasecmp(level, LEVEL_NAMES[i]) == 0) atomic_store(&min_level, i);
+    }
+    const char *file = getenv("RHYTHM_LOG_FILE");
+    if (file && *file) log_set_file(file);
+
+    sem_init(&drain_wake, 0, 0);
+    pthread_key_create(&ring_key, release_ring);
+
+    pthread_t thread;
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    if (pthread_create(&thread, &attr, drain_main, NULL) != 0) {
+        fprintf(stderr, "Failed to start the log thread; records are written on log_flush()\n");
+    }
+    pthread_attr_destroy(&attr);
+    atexit(log_flush);
+}
+
+void log_init(void) {
+    pthread_once(&log_once, log_setup);
+}
+
+static LogRing *claim_ring(void) {
+    if (thread_ring || thread_ringless) return thread_ring;
+
+    for (int i = 0; i < LOG_MAX_THREADS; i++) {
+        int expected = RING_FREE;
+        if (atomic_compare_exchange_strong(&rings[i].state, &expected, RING_OWNED)) {
+            thread_ring = &rings[i];
+            pthread_setspecific(ring_key, thread_ring);
+            return thread_ring;
+        }
+    }
+    // more than LOG_MAX_THREADS live loggers: this thread's records are dropped and counted
+    thread_ringless = true;
+    return NULL;
+}
+
+// per call site: LOG_RATE_BURST records per window, the rest counted
+static bool rate_allow(LogSite *site, uint64_t now, uint32_t *suppressed) {
+    uint64_t start = atomic_load_explicit(&site->window_start_ns, memory_order_relaxed);
+    if (now - start >= LOG_RATE_WINDOW_NS &&
+        atomic_compare_exchange_strong(&site->window_start_ns, &start, now)) {
+        atomic_store_explicit(&site->count, 1, memory_order_relaxed);
+        *suppressed = atomic_exchange_explicit(&site->suppressed, 0, memory_order_relaxed);
+        return true;
+    }
+
+    *suppressed = 0;
+    if (atomic_fetch_add_explicit(&site->count, 1, memory_order_relaxed) < LOG_RATE_BURST) return true;
+    atomic_fetch_add_explicit(&site->suppressed, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&stat_suppressed, 1, memory_order_relaxed);
+    return false;
+}
+
+void log_write(LogSite *site, LogLevel level, const char *format, int count, const LogArg *args) {
+    if ((int)level < atomic_load_explicit(&min_level, memory_order_relaxed) || !format) return;
+    log_init();
+
+    uint64_t now = now_ns();
+    uint32_t suppressed = 0;
+    if (site && !rate_allow(site, now, &suppressed)) return;
+
+    LogRing *ring = claim_ring();
+    unsigned write = ring ? atomic_load_explicit(&ring->write_pos, memory_order_relaxed) : 0;
+    if (!ring || write - atomic_load_explicit(&ring->read_pos, memory_order_acquire) >= LOG_RING_RECORDS) {
+        atomic_fetch_add_explicit(&stat_dropped, 1, memory_order_relaxed);
+        return;
+    }
+
+    LogRecord *record = &ring->records[write & (LOG_RING_RECORDS - 1)];
+    record->time_ns = now;
+    record->format = format;
+    record->level = level;
+    record->suppressed = suppressed;
+    record->count = (uint8_t)(count < LOG_MAX_ARGS ? count : LOG_MAX_ARGS);
+
+    // strings are copied, since they rarely outlive the call; everything else is a value
+    size_t text_used = 0;
+    for (int i = 0; i < record->count; i++) {
+        record->types[i] = args[i].type;
+        if (args[i].type != LOG_ARG_STRING) {
+            record->args[i].u = args[i].value.u;
+            continue;
+        }
+        const char *text = args[i].value.s ? args[i].value.s : "(null)";
+        size_t room = text_used < LOG_TEXT_BYTES ? LOG_TEXT_BYTES - text_used - 1 : 0;
+        size_t length = strnlen(text, room);
+        record->args[i].text = (uint32_t)(text_used < LOG_TEXT_BYTES ? text_used : LOG_TEXT_BYTES - 1);
+        memcpy(record->text + record->args[i].text, text, length);
+        record->text[record->args[i].text + length] = '\0';
+        text_used += length + 1;
+    }
+
+    atomic_store_explicit(&ring->write_pos, write + 1, memory_order_release);
+    if (!atomic_exchange_explicit(&wake_posted, true, memory_order_acq_rel)) sem_post(&drain_wake);
+}
+
+void log_flush(void) {
+    pthread_mutex_lock(&drain_lock);
+    drain();
+    pthread_mutex_unlock(&drain_lock);
+}
+
+void log_set_level(LogLevel level) {
+    if (level < LOG_LEVEL_DEBUG || level >= LOG_LEVELS) return;
+    atomic_store(&min_level, level);
+}
+
+LogLevel log_get_level(void) {
+    return (LogLevel)atomic_load(&min_level);
+}
+
+int log_set_file(const char *path) {
+    FILE *file = NULL;
+    if (path) {
+        file = fopen(path, "a");
+        if (!file) return -1;
+    }
+
+    log_flush();
+    pthread_mutex_lock(&sink_lock);
+    if (sink_file) fclose(sink_file);
+    sink_file = file;
+    pthread_mutex_unlock(&sink_lock);
+    return 0;
+}
+
+void log_set_callback(LogCallback callback, void *user_data) {
+    log_flush();
+    pthread_mutex_lock(&sink_lock);
+    sink_callback = callback;
+    sink_user_data = user_data;
+    pthread_mutex_unlock(&sink_lock);
+}
+
+void log_get_stats(LogStats *stats) {
+    if (!stats) return;
+    stats->written = atomic_load_explicit(&stat_written, memory_order_relaxed);
+    stats->dropped = atomic_load_explicit(&stat_dropped, memory_order_relaxed);
+    stats->suppressed = atomic_load_explicit(&stat_suppressed, memory_order_relaxed);
+}
+
+const char *log_level_name(LogLevel level) {
+    return level >= LOG_LEVEL_DEBUG && level < LOG_LEVELS ? LEVEL_NAMES[level] : "unknown";
+}
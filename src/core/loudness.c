@@ -0,0 +1,292 @@
+#include "core/loudness.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define LOUDNESS_MAX_CHANNELS 2
+#define MOMENTARY_SUBBLOCKS 4           // 400 ms gating blocks, 75% overlap
+#define SHORT_TERM_SUBBLOCKS 30         // 3 s windows for loudness range
+#define RELATIVE_GATE_LU -10.0
+#define RANGE_RELATIVE_GATE_LU -20.0
+#define TRUE_PEAK_PHASES 4
+#define TRUE_PEAK_TAPS 12               // per phase, 48-tap interpolator
+
+typedef struct {
+    double b0, b1, b2, a1, a2;
+} Biquad;
+
+typedef struct {
+    double z1, z2;
+} BiquadState;
+
+typedef struct {
+    double *values;
+    size_t count;
+    size_t capacity;
+} EnergyList;
+
+struct LoudnessMeter {
+    long sample_rate;
+    int channels;
+
+    Biquad shelf;
+    Biquad highpass;
+    BiquadState shelf_state[LOUDNESS_MAX_CHANNELS];
+    BiquadState highpass_state[LOUDNESS_MAX_CHANNELS];
+
+    size_t subblock_frames;
+    size_t subblock_pos;
+    double subblock_sum;
+    double subblocks[SHORT_TERM_SUBBLOCKS];
+    size_t subblocks_seen;
+
+    EnergyList momentary;
+    EnergyList short_term;
+
+    double fir[TRUE_PEAK_PHASES][TRUE_PEAK_TAPS];
+    float history[LOUDNESS_MAX_CHANNELS][TRUE_PEAK_TAPS * 2];
+    int history_pos;
+    double peak;
+};
+
+// K-weighting for an arbitrary rate, from the analog prototypes behind the 48 kHz BS.1770 coefficients
+static void design_k_weighting(LoudnessMeter *meter) {
+    double rate = (double)meter->sample_rate;
+
+    double f0 = 1681.974450955533;
+    double gain_db = 3.999843853973347;
+    double q = 0.7071752369554196;
+    double k = tan(M_PI * f0 / rate);
+    double vh = pow(10.0, gain_db / 20.0);
+    double vb = pow(vh, 0.4996667741545416);
+    double a0 = 1.0 + k / q + k * k;
+    meter->shelf.b0 = (vh + vb * k / q + k * k) / a0;
+    meter->shelf.b1 = 2.0 * (k * k - vh) / a0;
+    meter->shelf.b2 = (vh - vb * k / q + k * k) / a0;
+    meter->shelf.a1 = 2.0 * (k * k - 1.0) / a0;
+    meter->shelf.a2 = (1.0 - k / q + k * k) / a0;
+
+    f0 = 38.13547087602444;
+    q = 0.5003270373238773;
+    k = tan(M_PI * f0 / rate);
+    a0 = 1.0 + k / q + k * k;
+    meter->highpass.b0 = 1.0;
+    meter->highpass.b1 = -2.0;
+    meter->highpass.b2 = 1.0;
+    meter->highpass.a1 = 2.0 * (k * k - 1.0) / a0;
+    meter->highpass.a2 = (1.0 - k / q + k * k) / a0;
+}
+
+// windowed-sinc polyphase interpolator; each phase is normalised to unity DC gain
+static void design_true_peak_filter(LoudnessMeter *meter) {
+    const int taps = TRUE_PEAK_PHASES * TRUE_PEAK_TAPS;
+    double center = (taps - 1) / 2.0;
+
+    for (int p = 0; p < TRUE_PEAK_PHASES; p++) {
+        double sum = 0.0;
+        for (int j = 0; j < TRUE_PEAK_TAPS; j++) {
+            int n = p + j * TRUE_PEAK_PHASES;
+            double t = (n - center) / TRUE_PEAK_PHASES;
+            double sinc = fabs(t) < 1e-12 ? 1.0 : sin(M_PI * t) / (M_PI * t);
+            double window = 0.42 - 0.5 * cos(2.0 * M_PI * (n + 0.5) / taps) + 0.08 * cos(4.0 * M_PI * (n + 0.5) / taps);
+            meter->fir[p][j] = sinc * window;
+            sum += meter->fir[p][j];
+        }
+        for (int j = 0; j < TRUE_PEAK_TAPS; j++) {
+            meter->fir[p][j] /= sum;
+        }
+    }
+}
+
+static inline double biquad_process(const Biquad *filter, BiquadState *state, double x) {
+    double y = filter->b0 * x + state->z1;
+    state->z1 = filter->b1 * x - filter->a1 * y + state->z2;
+    state->z2 = filter->b2 * x - filter->a2 * y;
+    return y;
+}
+
+static int energy_list_push(EnergyList *list, double value) {
+    if (list->count == list->capacity) {
+        size_t capacity = list->capacity ? list->capacity * 2 : 1024;
+        double *values = realloc(list->values, capacity * sizeof(double));
+        if (!values) return -1;
+        list->values = values;
+        list->capacity = capacity;
+    }
+    list->values[list->count++] = value;
+    return 0;
+}
+
+static double energy_to_lufs(double energy) {
+    return -0.691 + 10.0 * log10(energy);
+}
+
+static double lufs_to_energy(double lufs) {
+    return pow(10.0, (lufs + 0.691) / 10.0);
+}
+
+LoudnessMeter* loudness_meter_create(long sample_rate, int channels) {
+    if (sample_rate < 8000 || channels < 1 || channels > LOUDNESS_MAX_CHANNELS) return NULL;
+
+    LoudnessMeter *meter = calloc(1, sizeof(LoudnessMeter));
+    if (!meter) return NULL;
+
+    meter->sample_rate = sample_rate;
+    meter->channels = channels;
+    meter->subblock_frames = (size_t)((sample_rate + 5) / 10);
+    design_k_weighting(meter);
+    design_true_peak_filter(meter);
+    return meter;
+}
+
+void loudness_meter_destroy(LoudnessMeter *meter) {
+    if (!meter) return;
+    free(meter->momentary.values);
+    free(meter->short_term.values);
+    free(meter);
+}
+
+static double mean_of_last(const LoudnessMeter *meter, size_t count) {
+    double sum = 0.0;
+    for (size_t i = 0; i < count; i++) {
+        sum += meter->subblocks[(meter->subblocks_seen - 1 - i) % SHORT_TERM_SUBBLOCKS];
+    }
+    return sum / (double)count;
+}
+
+static int finish_subblock(LoudnessMeter *meter) {
+    meter->subblocks[meter->subblocks_seen % SHORT_TERM_SUBBLOCKS] = meter->subblock_sum / (double)meter->subblock_frames;
+    meter->subblocks_seen++;
+    meter->subblock_sum = 0.0;
+    meter->subblock_pos = 0;
+
+    if (meter->subblocks_seen >= MOMENTARY_SUBBLOCKS &&
+        energy_list_push(&meter->momentary, mean_of_last(meter, MOMENTARY_SUBBLOCKS)) != 0) {
+        return -1;
+    }
+    if (meter->subblocks_seen >= SHORT_TERM_SUBBLOCKS &&
+        energy_list_push(&meter->short_term, mean_of_last(meter, SHORT_TERM_SUBBLOCKS)) != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+int loudness_meter_add_frames(LoudnessMeter *meter, const float *interleaved, size_t frames) {
+    if (!meter || !interleaved) return -1;
+
+    int channels = meter->channels;
+    for (size_t i = 0; i < frames; i++) {
+        meter->history_pos = (meter->history_pos + TRUE_PEAK_TAPS - 1) % TRUE_PEAK_TAPS;
+
+        for (int c = 0; c < channels; c++) {
+            float x = interleaved[i * channels + c];
+
+            double y = biquad_process(&meter->shelf, &meter->shelf_state[c], x);
+            y = biquad_process(&meter->highpass, &meter->highpass_state[c], y);
+            meter->subblock_sum += y * y;
+
+            // history is stored twice so the newest TRUE_PEAK_TAPS samples are always contiguous
+            float *history = meter->history[c];
+            history[meter->history_pos] = x;
+            history[meter->history_pos + TRUE_PEAK_TAPS] = x;
+            const float *window = history + meter->history_pos;
+            for (int p = 0; p < TRUE_PEAK_PHASES; p++) {
+                double acc = 0.0;
+                for (int j = 0; j < TRUE_PEAK_TAPS; j++) {
+                    acc += meter->fir[p][j] * window[j];
+                }
+                if (fabs(acc) > meter->peak) meter->peak = fabs(acc);
+            }
+            if (fabsf(x) > meter->peak) meter->peak = fabsf(x);
+        }
+
+        if (++meter->subblock_pos == meter->subblock_frames && finish_subblock(meter) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static double gated_mean(const EnergyList *list, double threshold_energy, size_t *count) {
+    double sum = 0.0;
+    size_t n = 0;
+    for (size_t i = 0; i < list->count; i++) {
+        if (list->values[i] > threshold_energy) {
+            sum += list->values[i];
+            n++;
+        }
+    }
+    if (count) *count = n;
+    return n > 0 ? sum / (double)n : 0.0;
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static float loudness_range(const EnergyList *short_term) {
+    double absolute = lufs_to_energy(LOUDNESS_ABSOLUTE_GATE);
+    size_t count = 0;
+    double mean = gated_mean(short_term, absolute, &count);
+    if (count < 2) return 0.0f;
+
+    double relative = lufs_to_energy(energy_to_lufs(mean) + RANGE_RELATIVE_GATE_LU);
+    double threshold = relative > absolute ? relative : absolute;
+
+    double *values = malloc(count * sizeof(double));
+    if (!values) return 0.0f;
+
+    size_t n = 0;
+    for (size_t i = 0; i < short_term->count; i++) {
+        if (short_term->values[i] > threshold) {
+            values[n++] = energy_to_lufs(short_term->values[i]);
+        }
+    }
+
+    float range = 0.0f;
+    if (n >= 2) {
+        qsort(values, n, sizeof(double), compare_doubles);
+        double low = values[(size_t)(0.10 * (double)(n - 1) + 0.5)];
+        double high = values[(size_t)(0.95 * (double)(n - 1) + 0.5)];
+        range = (float)(high - low);
+    }
+    free(values);
+    return range;
+}
+
+void loudness_meter_get_result(LoudnessMeter *meter, LoudnessResult *result) {
+    if (!result) return;
+    result->integrated_lufs = LOUDNESS_SILENCE;
+    result->loudness_range = 0.0f;
+    result->true_peak_dbtp = LOUDNESS_SILENCE;
+    if (!meter) return;
+
+    double absolute = lufs_to_energy(LOUDNESS_ABSOLUTE_GATE);
+    size_t count = 0;
+    double mean = gated_mean(&meter->momentary, absolute, &count);
+    if (count > 0) {
+        double relative = lufs_to_energy(energy_to_lufs(mean) + RELATIVE_GATE_LU);
+        double gated = gated_mean(&meter->momentary, relative > absolute ? relative : absolute, &count);
+        if (count > 0) {
+            result->integrated_lufs = (float)energy_to_lufs(gated);
+        }
+    }
+
+    result->loudness_range = loudness_range(&meter->short_term);
+    if (meter->peak > 0.0) {
+        result->true_peak_dbtp = (float)(20.0 * log10(meter->peak));
+    }
+}
+
+float loudness_track_gain_db(const LoudnessResult *result, float target_lufs) {
+    if (!result || result->integrated_lufs <= LOUDNESS_SILENCE) return 0.0f;
+
+    // cutting never clips; boosting stops where the true peak would pass -1 dBTP
+    float gain = target_lufs - result->integrated_lufs;
+    float headroom = -1.0f - result->true_peak_dbtp;
+    if (gain > 0.0f && gain > headroom) {
+        gain = headroom > 0.0f ? headroom : 0.0f;
+    }
+    return gain;
+}
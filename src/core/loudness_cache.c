@@ -0,0 +1,255 @@
+#include "core/loudness_cache.h"
+#include "core/log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <pthread.h>
+
+#define CACHE_HEADER "# rhythm loudness cache v1"
+#define CACHE_INITIAL_CAPACITY 1024
+
+typedef struct {
+    unsigned long long dev;
+    unsigned long long ino;
+    unsigned long long size;
+    long long mtime_ns;
+    LoudnessResult result;
+    bool used;
+} CacheEntry;
+
+struct LoudnessCache {
+    char *path;
+    FILE *log;
+    CacheEntry *entries;
+    size_t capacity;
+    size_t count;
+    size_t lines;
+    pthread_mutex_t lock;
+};
+
+static uint64_t hash_identity(unsigned long long dev, unsigned long long ino) {
+    uint64_t x = (uint64_t)ino ^ ((uint64_t)dev << 32 | (uint64_t)dev >> 32);
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+static long long stat_mtime_ns(const struct stat *st) {
+    return (long long)st->st_mtim.tv_sec * 1000000000LL + st->st_mtim.tv_nsec;
+}
+
+static CacheEntry* find_slot(CacheEntry *entries, size_t capacity, unsigned long long dev, unsigned long long ino) {
+    size_t mask = capacity - 1;
+    size_t i = (size_t)hash_identity(dev, ino) & mask;
+    while (entries[i].used && (entries[i].dev != dev || entries[i].ino != ino)) {
+        i = (i + 1) & mask;
+    }
+    return &entries[i];
+}
+
+static int grow(LoudnessCache *cache) {
+    size_t capacity = cache->capacity ? cache->capacity * 2 : CACHE_INITIAL_CAPACITY;
+    CacheEntry *entries = calloc(capacity, sizeof(CacheEntry));
+    if (!entries) return -1;
+
+    for (size_t i = 0; i < cache->capacity; i++) {
+        if (cache->entries[i].used) {
+            *find_slot(entries, capacity, cache->entries[i].dev, cache->entries[i].ino) = cache->entries[i];
+        }
+    }
+    free(cache->entries);
+    cache->entries = entries;
+    cache->capacity = capacity;
+    return 0;
+}
+
+static int insert(LoudnessCache *cache, const CacheEntry *entry) {
+    if ((cache->count + 1) * 2 > cache->capacity && grow(cache) != 0) return -1;
+
+    CacheEntry *slot = find_slot(cache->entries, cache->capacity, entry->dev, entry->ino);
+    if (!slot->used) cache->count++;
+    *slot = *entry;
+    slot->used = true;
+    return 0;
+}
+
+static void write_entry(FILE *file, const CacheEntry *entry, const char *path) {
+    fprintf(file, "%llu %llu %llu %lld %.2f %.2f %.2f %s\n",
+            entry->dev, entry->ino, entry->size, entry->mtime_ns,
+            entry->result.integrated_lufs, entry->result.loudness_range, entry->result.true_peak_dbtp,
+            path ? path : "-");
+}
+
+static void load(LoudnessCache *cache, FILE *file) {
+    char *line = NULL;
+    size_t length = 0;
+    while (getline(&line, &length, file) > 0) {
+        if (line[0] == '#') continue;
+
+        CacheEntry entry = {0};
+        int consumed = 0;
+        if (sscanf(line, "%llu %llu %llu %lld %f %f %f %n",
+                   &entry.dev, &entry.ino, &entry.size, &entry.mtime_ns,
+                   &entry.result.integrated_lufs, &entry.result.loudness_range,
+                   &entry.result.true_peak_dbtp, &consumed) == 7 && consumed > 0) {
+            insert(cache, &entry);
+            cache->lines++;
+        }
+    }
+    free(line);
+}
+
+// superseded entries pile up as files change; rewrite once they dominate the log
+static void compact(LoudnessCache *cache) {
+    if (cache->lines < 2 * cache->count + CACHE_INITIAL_CAPACITY) return;
+
+    char temp_path[4096];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", cache->path);
+    FILE *file = fopen(temp_path, "w");
+    if (!file) return;
+
+    fprintf(file, "%s\n", CACHE_HEADER);
+    for (size_t i = 0; i < cache->capacity; i++) {
+        if (cache->entries[i].used) write_entry(file, &cache->entries[i], NULL);
+    }
+    if (fclose(file) == 0 && rename(temp_path, cache->path) == 0) {
+        cache->lines = cache->count;
+    } else {
+        remove(temp_path);
+    }
+}
+
+static void make_parent_dirs(const char *path) {
+    char buffer[4096];
+    snprintf(buffer, sizeof(buffer), "%s", path);
+    for (char *p = buffer + 1; *p; p++) {
+        if (*p == '/') {
+            *p = '\0';
+            mkdir(buffer, 0755);
+            *p = '/';
+        }
+    }
+}
+
+int loudness_cache_default_path(char *buffer, size_t size) {
+    const char *override = getenv("RHYTHM_LOUDNESS_CACHE");
+    if (override && *override) {
+        snprintf(buffer, size, "%s", override);
+        return 0;
+    }
+
+    const char *xdg = getenv("XDG_CACHE_HOME");
+    if (xdg && *xdg) {
+        snprintf(buffer, size, "%s/rhythm/loudness.cache", xdg);
+        return 0;
+    }
+
+    const char *home = getenv("HOME");
+    if (!home || !*home) return -1;
+    snprintf(buffer, size, "%s/.cache/rhythm/loudness.cache", home);
+    return 0;
+}
+
+LoudnessCache* loudness_cache_open(const char *path) {
+    if (!path) return NULL;
+
+    LoudnessCache *cache = calloc(1, sizeof(LoudnessCache));
+    if (!cache) return NULL;
+
+    pthread_mutex_init(&cache->lock, NULL);
+    cache->path = strdup(path);
+    if (!cache->path || grow(cache) != 0) {
+        loudness_cache_close(cache);
+        return NULL;
+    }
+
+    FILE *existing = fopen(path, "r");
+    bool had_file = existing != NULL;
+    if (existing) {
+        load(cache, existing);
+        fclose(existing);
+        compact(cache);
+    } else {
+        make_parent_dirs(path);
+    }
+
+    cache->log = fopen(path, "a");
+    if (!cache->log) {
+        LOG_ERROR("Failed to open loudness cache %s: %s", path, strerror(errno));
+        loudness_cache_close(cache);
+        return NULL;
+    }
+    if (!had_file) {
+        fprintf(cache->log, "%s\n", CACHE_HEADER);
+        fflush(cache->log);
+    }
+
+    return cache;
+}
+
+void loudness_cache_close(LoudnessCache *cache) {
+    if (!cache) return;
+
+    if (cache->log) fclose(cache->log);
+    pthread_mutex_destroy(&cache->lock);
+    free(cache->entries);
+    free(cache->path);
+    free(cache);
+}
+
+int loudness_cache_lookup_stat(LoudnessCache *cache, const struct stat *st, LoudnessResult *result) {
+    if (!cache || !st) return -1;
+
+    pthread_mutex_lock(&cache->lock);
+    CacheEntry *slot = find_slot(cache->entries, cache->capacity,
+                                 (unsigned long long)st->st_dev, (unsigned long long)st->st_ino);
+    int found = slot->used && slot->size == (unsigned long long)st->st_size &&
+                slot->mtime_ns == stat_mtime_ns(st);
+    if (found && result) *result = slot->result;
+    pthread_mutex_unlock(&cache->lock);
+
+    return found ? 0 : -1;
+}
+
+int loudness_cache_lookup(LoudnessCache *cache, const char *path, LoudnessResult *result) {
+    struct stat st;
+    if (!cache || !path || stat(path, &st) != 0) return -1;
+    return loudness_cache_lookup_stat(cache, &st, result);
+}
+
+int loudness_cache_store(LoudnessCache *cache, const char *path, const struct stat *st, const LoudnessResult *result) {
+    if (!cache || !st || !result) return -1;
+
+    CacheEntry entry = {
+        .dev = (unsigned long long)st->st_dev,
+        .ino = (unsigned long long)st->st_ino,
+        .size = (unsigned long long)st->st_size,
+        .mtime_ns = stat_mtime_ns(st),
+        .result = *result,
+    };
+
+    pthread_mutex_lock(&cache->lock);
+    int status = insert(cache, &entry);
+    if (status == 0) {
+        // flushed per entry: a killed scan loses at most the track in flight
+        write_entry(cache->log, &entry, path);
+        fflush(cache->log);
+        cache->lines++;
+    }
+    pthread_mutex_unlock(&cache->lock);
+    return status;
+}
+
+size_t loudness_cache_count(LoudnessCache *cache) {
+    if (!cache) return 0;
+
+    pthread_mutex_lock(&cache->lock);
+    size_t count = cache->count;
+    pthread_mutex_unlock(&cache->lock);
+    return count;
+}
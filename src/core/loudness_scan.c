@@ -0,0 +1,211 @@
+#include "core/loudness_scan.h"
+#include "core/trace.h"
+#include "core/log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#define SCAN_CHUNK_FRAMES 4096
+#define SCAN_MAX_THREADS 64
+#define SCAN_MAX_ERRORS 5
+
+struct LoudnessScan {
+    LoudnessCache *cache;
+    char **files;
+    int count;
+    pthread_t *threads;
+    int thread_count;
+    atomic_int next;
+    atomic_int analysed;
+    atomic_int cached;
+    atomic_int failed;
+    atomic_int active_workers;
+    atomic_bool cancel;
+};
+
+int loudness_analyse_file(Decoder *decoder, const char *path, float *buffer, size_t buffer_frames,
+                          LoudnessResult *result, const atomic_bool *cancel) {
+    TRACE_SCOPE("loudness_analyse");
+    if (decoder_open(decoder, path) != 0) return -1;
+
+    long rate = decoder->rate;
+    int channels = decoder->channels;
+    LoudnessMeter *meter = loudness_meter_create(rate, channels);
+    if (!meter) {
+        decoder_close(decoder);
+        return -1;
+    }
+
+    int status = 0;
+    int errors = 0;
+    for (;;) {
+        if (cancel && atomic_load_explicit(cancel, memory_order_relaxed)) {
+            status = -1;
+            break;
+        }
+
+        size_t frames = 0;
+        DecoderStatus read_status = decoder_read(decoder, buffer, buffer_frames, &frames);
+        if (frames > 0 && loudness_meter_add_frames(meter, buffer, frames) != 0) {
+            status = -1;
+            break;
+        }
+
+        if (read_status == DECODER_DONE) {
+            break;
+        } else if (read_status == DECODER_NEW_FORMAT) {
+            // a mid-stream format change would need a second meter; not worth it for analysis
+            if (decoder->rate != rate || decoder->channels != channels) {
+                status = -1;
+                break;
+            }
+        } else if (read_status == DECODER_ERROR || frames == 0) {
+            if (++errors >= SCAN_MAX_ERRORS) {
+                status = -1;
+                break;
+            }
+        } else {
+            errors = 0;
+        }
+    }
+
+    if (status == 0) {
+        loudness_meter_get_result(meter, result);
+    }
+    loudness_meter_destroy(meter);
+    decoder_close(decoder);
+    return status;
+}
+
+static void* scan_worker_main(void *arg) {
+    LoudnessScan *scan = (LoudnessScan *)arg;
+    TRACE_THREAD_NAME("loudness");
+
+    Decoder *mp3_decoder = mpg123_decoder_create();
+    Decoder *wav_decoder = wav_decoder_create();
+    float *buffer = malloc(SCAN_CHUNK_FRAMES * DECODER_MAX_CHANNELS * sizeof(float));
+
+    while (mp3_decoder && wav_decoder && buffer && !atomic_load(&scan->cancel)) {
+        int index = atomic_fetch_add(&scan->next, 1);
+        if (index >= scan->count) break;
+
+        const char *path = scan->files[index];
+        // streams have no end to measure, and opening a FIFO would steal its data
+        struct stat st;
+        if (stat(path, &st) != 0 || !S_ISREG(st.st_mode)) {
+            atomic_fetch_add(&scan->failed, 1);
+            continue;
+        }
+
+        // resuming an interrupted scan costs one hash lookup per finished file
+        if (loudness_cache_lookup_stat(scan->cache, &st, NULL) == 0) {
+            atomic_fetch_add(&scan->cached, 1);
+            continue;
+        }
+
+        Decoder *decoder = wav_decoder_probe(path) ? wav_decoder : mp3_decoder;
+        LoudnessResult result;
+        if (loudness_analyse_file(decoder, path, buffer, SCAN_CHUNK_FRAMES, &result, &scan->cancel) == 0) {
+            loudness_cache_store(scan->cache, path, &st, &result);
+            atomic_fetch_add(&scan->analysed, 1);
+        } else if (!atomic_load(&scan->cancel)) {
+            atomic_fetch_add(&scan->failed, 1);
+        }
+    }
+
+    free(buffer);
+    decoder_destroy(mp3_decoder);
+    decoder_destroy(wav_decoder);
+    atomic_fetch_sub(&scan->active_workers, 1);
+    return NULL;
+}
+
+LoudnessScan* loudness_scan_start(LoudnessCache *cache, const char *const *files, int count, int threads) {
+    if (!cache || (!files && count > 0) || count < 0) return NULL;
+
+    if (threads <= 0) {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cores > 0 ? (int)cores : 1;
+    }
+    if (threads > SCAN_MAX_THREADS) threads = SCAN_MAX_THREADS;
+    if (threads > count) threads = count > 0 ? count : 1;
+
+    LoudnessScan *scan = calloc(1, sizeof(LoudnessScan));
+    if (!scan) return NULL;
+
+    scan->cache = cache;
+    scan->count = count;
+    scan->files = calloc(count > 0 ? (size_t)count : 1, sizeof(char *));
+    scan->threads = calloc((size_t)threads, sizeof(pthread_t));
+    if (!scan->files || !scan->threads) {
+        free(scan->files);
+        free(scan->threads);
+        free(scan);
+        return NULL;
+    }
+
+    // the caller's list may change while the scan runs
+    for (int i = 0; i < count; i++) {
+        scan->files[i] = strdup(files[i]);
+        if (!scan->files[i]) {
+            scan->count = i;
+            loudness_scan_destroy(scan);
+            return NULL;
+        }
+    }
+
+    atomic_init(&scan->next, 0);
+    atomic_init(&scan->analysed, 0);
+    atomic_init(&scan->cached, 0);
+    atomic_init(&scan->failed, 0);
+    atomic_init(&scan->cancel, false);
+    atomic_init(&scan->active_workers, threads);
+
+    for (int i = 0; i < threads; i++) {
+        if (pthread_create(&scan->threads[i], NULL, scan_worker_main, scan) != 0) {
+            LOG_ERROR("Failed to start loudness worker %d", i);
+            atomic_fetch_sub(&scan->active_workers, threads - i);
+            break;
+        }
+        scan->thread_count++;
+    }
+
+    if (scan->thread_count == 0) {
+        loudness_scan_destroy(scan);
+        return NULL;
+    }
+    return scan;
+}
+
+void loudness_scan_get_progress(LoudnessScan *scan, LoudnessScanProgress *progress) {
+    if (!progress) return;
+    memset(progress, 0, sizeof(LoudnessScanProgress));
+    if (!scan) return;
+
+    progress->total = scan->count;
+    progress->analysed = atomic_load(&scan->analysed);
+    progress->cached = atomic_load(&scan->cached);
+    progress->failed = atomic_load(&scan->failed);
+    progress->finished = atomic_load(&scan->active_workers) == 0;
+}
+
+void loudness_scan_cancel(LoudnessScan *scan) {
+    if (scan) atomic_store(&scan->cancel, true);
+}
+
+void loudness_scan_destroy(LoudnessScan *scan) {
+    if (!scan) return;
+
+    loudness_scan_cancel(scan);
+    for (int i = 0; i < scan->thread_count; i++) {
+        pthread_join(scan->threads[i], NULL);
+    }
+    for (int i = 0; i < scan->count; i++) {
+        free(scan->files[i]);
+    }
+    free(scan->files);
+    free(scan->threads);
+    free(scan);
+}
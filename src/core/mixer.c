@@ -0,0 +1,580 @@
+#include "core/mixer.h"
+#include "core/audio_converter.h"
+#include "core/decoder.h"
+#include "core/ring_buffer.h"
+#include "core/trace.h"
+#include "core/realtime.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+
+#define MIXER_RING_FRAMES 16384         // per voice, about 340 ms at 48 kHz
+#define MIXER_DECODE_FRAMES 2048
+#define MIXER_BLOCK_FRAMES 256
+#define MIXER_MAX_CHANNELS 2
+#define MIXER_FADE_SECONDS 0.005f
+#define MIXER_IDLE_WAIT_MS 10
+#define MIXER_SLOT_BITS 8
+
+// two interleaved stereo frames per register; GCC/Clang lower this to SSE or NEON
+typedef float MixVec __attribute__((vector_size(4 * sizeof(float))));
+
+enum {
+    VOICE_FREE,
+    VOICE_ACTIVE,               // decoder thread fills, audio thread mixes
+    VOICE_DONE                  // finished on the audio thread, recycled by the decoder thread
+};
+
+typedef struct {
+    atomic_int state;
+    unsigned generation;
+
+    // published by the control thread; odd seq means a write is in progress
+    atomic_uint param_seq;
+    MixerVoiceParams params;
+    atomic_bool stop_requested;
+    atomic_bool loop;                   // read by the decoder thread
+
+    // set up on the control thread before the voice is published
+    Decoder *mp3_decoder;
+    Decoder *wav_decoder;
+    Decoder *decoder;
+    RingBuffer *ring;
+    int channels;
+    int rate;
+
+    // decoder thread
+    atomic_bool eof;
+    ConversionPlan plan;
+    long long resample_in_frames;
+    long long resample_out_frames;
+    int errors;
+
+    // audio thread
+    unsigned seen_seq;
+    MixerVoiceParams live;
+    float gain_l;
+    float gain_r;
+    float fade;
+    bool fading_out;
+    bool sounding;                      // first samples were mixed; later gaps are starvation
+} MixerVoice;
+
+struct Mixer {
+    MixerVoice voices[MIXER_MAX_VOICES];
+    pthread_mutex_t control_lock;
+    atomic_int rate;
+    atomic_int channels;
+    _Atomic float duck_target;
+    _Atomic float duck_attack_ms;
+    _Atomic float duck_release_ms;
+
+    pthread_t thread;
+    bool thread_started;
+    atomic_bool running;
+    sem_t wake;
+
+    // decoder thread
+    float *decode_buffer;
+    float *convert_buffer;
+    float *resample_buffer;
+    size_t resample_capacity;
+
+    // audio thread
+    float scratch[MIXER_BLOCK_FRAMES * MIXER_MAX_CHANNELS];
+    float duck;
+
+    atomic_int active;
+    atomic_uint_least64_t started;
+    atomic_uint_least64_t finished;
+    atomic_uint_least64_t starved;
+    _Atomic float duck_now;
+};
+
+// control thread, with control_lock held
+static MixerVoice *find_voice(Mixer *mixer, int id) {
+    int slot = id & ((1 << MIXER_SLOT_BITS) - 1);
+    if (id < 0 || slot >= MIXER_MAX_VOICES) return NULL;
+
+    MixerVoice *voice = &mixer->voices[slot];
+    if (voice->generation != (unsigned)id >> MIXER_SLOT_BITS ||
+        atomic_load(&voice->state) != VOICE_ACTIVE) {
+        return NULL;
+    }
+    return voice;
+}
+
+static void publish_params(MixerVoice *voice, const MixerVoiceParams *params) {
+    unsigned seq = atomic_load_explicit(&voice->param_seq, memory_order_relaxed);
+    atomic_store_explicit(&voice->param_seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    voice->params = *params;
+    atomic_store_explicit(&voice->param_seq, seq + 2, memory_order_release);
+}
+
+static void pickup_params(MixerVoice *voice) {
+    unsigned seq = atomic_load_explicit(&voice->param_seq, memory_order_acquire);
+    if (seq == voice->seen_seq || (seq & 1)) return;
+
+    MixerVoiceParams params = voice->params;
+    atomic_thread_fence(memory_order_acquire);
+    if (atomic_load_explicit(&voice->param_seq, memory_order_relaxed) != seq) return;
+
+    voice->live = params;
+    voice->seen_seq = seq;
+}
+
+static void pan_gains(const MixerVoiceParams *params, int channels, float master, float *left, float *right) {
+    float gain = params->gain * master;
+    float pan = params->pan < -1.0f ? -1.0f : params->pan > 1.0f ? 1.0f : params->pan;
+    if (channels < 2) pan = 0.0f;
+
+    // the far side follows a cosine law, the near side stays at unity
+    *left = gain * (pan > 0.0f ? cosf(pan * (float)M_PI_2) : 1.0f);
+    *right = gain * (pan < 0.0f ? cosf(-pan * (float)M_PI_2) : 1.0f);
+}
+
+// ---- decoding -------------------------------------------------------------------
+
+static int ensure_resample_capacity(Mixer *mixer, size_t samples) {
+    if (samples <= mixer->resample_capacity) return 0;
+
+    float *buffer = realloc(mixer->resample_buffer, samples * sizeof(float));
+    if (!buffer) return -1;
+
+    mixer->resample_buffer = buffer;
+    mixer->resample_capacity = samples;
+    return 0;
+}
+
+// decodes one chunk of a voice into its ring; same pipeline as the player's decoder
+static bool decode_voice(Mixer *mixer, MixerVoice *voice) {
+    if (atomic_load_explicit(&voice->eof, memory_order_relaxed)) return false;
+
+    const ConversionPlan *plan = &voice->plan;
+    if (ring_buffer_write_available(voice->ring) < plan->max_out_samples) return false;
+
+    size_t frames = 0;
+    DecoderStatus status = decoder_read(voice->decoder, mixer->decode_buffer, MIXER_DECODE_FRAMES, &frames);
+    if (status == DECODER_NEW_FORMAT) {
+        if (conversion_plan_init(&voice->plan, voice->decoder->rate, voice->decoder->channels,
+                                 voice->rate, voice->channels, MIXER_DECODE_FRAMES) != 0) {
+            atomic_store_explicit(&voice->eof, true, memory_order_release);
+            return false;
+        }
+        voice->resample_in_frames = 0;
+        voice->resample_out_frames = 0;
+        return true;
+    } else if (status == DECODER_DONE) {
+        if (atomic_load_explicit(&voice->loop, memory_order_relaxed) && decoder_seek(voice->decoder, 0) == 0) {
+            return true;
+        }
+        atomic_store_explicit(&voice->eof, true, memory_order_release);
+    } else if (status == DECODER_ERROR) {
+        if (++voice->errors >= 5) {
+            atomic_store_explicit(&voice->eof, true, memory_order_release);
+            return false;
+        }
+        return true;
+    } else {
+        voice->errors = 0;
+    }
+    if (frames == 0) return false;
+
+    float *samples = mixer->decode_buffer;
+    if (plan->remap) {
+        plan->remap(samples, mixer->convert_buffer, (int)frames);
+        samples = mixer->convert_buffer;
+    }
+
+    size_t out_frames = frames;
+    if (plan->resample) {
+        long long target = (voice->resample_in_frames + (long long)frames) * plan->out_rate / plan->in_rate;
+        out_frames = (size_t)(target - voice->resample_out_frames);
+        if (ensure_resample_capacity(mixer, plan->max_out_samples) != 0) {
+            atomic_store_explicit(&voice->eof, true, memory_order_release);
+            return false;
+        }
+        plan->resample(samples, mixer->resample_buffer, (int)frames, (int)out_frames);
+        samples = mixer->resample_buffer;
+    }
+    voice->resample_in_frames += frames;
+    voice->resample_out_frames += out_frames;
+
+    ring_buffer_write(voice->ring, samples, out_frames * plan->out_channels);
+    return true;
+}
+
+bool mixer_decode(Mixer *mixer) {
+    if (!mixer) return false;
+    TRACE_SCOPE("mixer_decode");
+
+    bool decoded = false;
+    for (int i = 0; i < MIXER_MAX_VOICES; i++) {
+        MixerVoice *voice = &mixer->voices[i];
+        int state = atomic_load_explicit(&voice->state, memory_order_acquire);
+        if (state == VOICE_ACTIVE) {
+            decoded |= decode_voice(mixer, voice);
+        } else if (state == VOICE_DONE) {
+            // the audio thread is done with it; closing and reuse happen here
+            decoder_close(voice->decoder);
+            voice->decoder = NULL;
+            atomic_fetch_sub_explicit(&mixer->active, 1, memory_order_relaxed);
+            atomic_fetch_add_explicit(&mixer->finished, 1, memory_order_relaxed);
+            atomic_store_explicit(&voice->state, VOICE_FREE, memory_order_release);
+        }
+    }
+    return decoded;
+}
+
+static void *mixer_thread_main(void *arg) {
+    Mixer *mixer = arg;
+    TRACE_THREAD_NAME("mixer_decoder");
+    realtime_register_thread(REALTIME_ROLE_DECODER);
+
+    while (atomic_load(&mixer->running)) {
+        if (mixer_decode(mixer)) continue;
+
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += MIXER_IDLE_WAIT_MS * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        sem_timedwait(&mixer->wake, &deadline);
+    }
+    return NULL;
+}
+
+// ---- control thread -------------------------------------------------------------
+
+Mixer *mixer_create(bool decode_thread) {
+    Mixer *mixer = calloc(1, sizeof(Mixer));
+    if (!mixer) return NULL;
+
+    mixer->decode_buffer = malloc(MIXER_DECODE_FRAMES * DECODER_MAX_CHANNELS * sizeof(float));
+    mixer->convert_buffer = malloc(MIXER_DECODE_FRAMES * MIXER_MAX_CHANNELS * sizeof(float));
+    if (!mixer->decode_buffer || !mixer->convert_buffer) {
+        free(mixer->decode_buffer);
+        free(mixer->convert_buffer);
+        free(mixer);
+        return NULL;
+    }
+
+    pthread_mutex_init(&mixer->control_lock, NULL);
+    sem_init(&mixer->wake, 0, 0);
+    atomic_init(&mixer->rate, SAMPLE_RATE);
+    atomic_init(&mixer->channels, CHANNELS);
+    atomic_init(&mixer->duck_target, powf(10.0f, -12.0f / 20.0f));
+    atomic_init(&mixer->duck_attack_ms, 50.0f);
+    atomic_init(&mixer->duck_release_ms, 400.0f);
+    atomic_init(&mixer->duck_now, 1.0f);
+    mixer->duck = 1.0f;
+
+    if (decode_thread) {
+        atomic_init(&mixer->running, true);
+        if (pthread_create(&mixer->thread, NULL, mixer_thread_main, mixer) != 0) {
+            mixer_destroy(mixer);
+            return NULL;
+        }
+        mixer->thread_started = true;
+    }
+    return mixer;
+}
+
+void mixer_destroy(Mixer *mixer) {
+    if (!mixer) return;
+
+    if (mixer->thread_started) {
+        atomic_store(&mixer->running, false);
+        sem_post(&mixer->wake);
+        pthread_join(mixer->thread, NULL);
+    }
+
+    for (int i = 0; i < MIXER_MAX_VOICES; i++) {
+        MixerVoice *voice = &mixer->voices[i];
+        decoder_destroy(voice->mp3_decoder);
+        decoder_destroy(voice->wav_decoder);
+        ring_buffer_destroy(voice->ring);
+    }
+    sem_destroy(&mixer->wake);
+    pthread_mutex_destroy(&mixer->control_lock);
+    free(mixer->decode_buffer);
+    free(mixer->convert_buffer);
+    free(mixer->resample_buffer);
+    free(mixer);
+}
+
+void mixer_set_format(Mixer *mixer, int sample_rate, int channels) {
+    if (!mixer || sample_rate <= 0 || channels < 1 || channels > MIXER_MAX_CHANNELS) return;
+    atomic_store(&mixer->rate, sample_rate);
+    atomic_store(&mixer->channels, channels);
+}
+
+int mixer_play(Mixer *mixer, const char *path, const MixerVoiceParams *params) {
+    if (!mixer || !path || !params) return -1;
+
+    pthread_mutex_lock(&mixer->control_lock);
+    MixerVoice *voice = NULL;
+    int slot = 0;
+    for (; slot < MIXER_MAX_VOICES; slot++) {
+        if (atomic_load_explicit(&mixer->voices[slot].state, memory_order_acquire) == VOICE_FREE) {
+            voice = &mixer->voices[slot];
+            break;
+        }
+    }
+    if (!voice) {
+        pthread_mutex_unlock(&mixer->control_lock);
+        return -1;
+    }
+
+    // decoders and rings stay with the slot, so a reused slot allocates nothing
+    bool wav = wav_decoder_probe(path);
+    Decoder **decoder = wav ? &voice->wav_decoder : &voice->mp3_decoder;
+    if (!*decoder) *decoder = wav ? wav_decoder_create() : mpg123_decoder_create();
+    if (!voice->ring) voice->ring = ring_buffer_create(MIXER_RING_FRAMES * MIXER_MAX_CHANNELS);
+    if (!*decoder || !voice->ring || decoder_open(*decoder, path) != 0) {
+        pthread_mutex_unlock(&mixer->control_lock);
+        return -1;
+    }
+
+    voice->decoder = *decoder;
+    voice->rate = atomic_load(&mixer->rate);
+    voice->channels = atomic_load(&mixer->channels);
+    long source_rate = voice->decoder->rate > 0 ? voice->decoder->rate : voice->rate;
+    int source_channels = voice->decoder->channels > 0 ? voice->decoder->channels : voice->channels;
+    if (conversion_plan_init(&voice->plan, source_rate, source_channels, voice->rate, voice->channels,
+                             MIXER_DECODE_FRAMES) != 0) {
+        decoder_close(voice->decoder);
+        voice->decoder = NULL;
+        pthread_mutex_unlock(&mixer->control_lock);
+        return -1;
+    }
+    voice->resample_in_frames = 0;
+    voice->resample_out_frames = 0;
+    voice->errors = 0;
+    atomic_store(&voice->eof, false);
+    atomic_store(&voice->stop_requested, false);
+    atomic_store(&voice->loop, params->loop);
+    ring_buffer_flush(voice->ring);
+
+    // the audio thread starts from these and fades in from silence
+    publish_params(voice, params);
+    voice->seen_seq = atomic_load(&voice->param_seq);
+    voice->live = *params;
+    pan_gains(params, voice->channels, 1.0f, &voice->gain_l, &voice->gain_r);
+    voice->fade = 0.0f;
+    voice->fading_out = false;
+    voice->sounding = false;
+
+    voice->generation = (voice->generation + 1) & 0xffffff;
+    int id = (int)(voice->generation << MIXER_SLOT_BITS) | slot;
+    atomic_fetch_add_explicit(&mixer->active, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&mixer->started, 1, memory_order_relaxed);
+    atomic_store_explicit(&voice->state, VOICE_ACTIVE, memory_order_release);
+    pthread_mutex_unlock(&mixer->control_lock);
+
+    sem_post(&mixer->wake);
+    return id;
+}
+
+int mixer_set_voice(Mixer *mixer, int id, const MixerVoiceParams *params) {
+    if (!mixer || !params) return -1;
+
+    pthread_mutex_lock(&mixer->control_lock);
+    MixerVoice *voice = find_voice(mixer, id);
+    if (voice) {
+        atomic_store(&voice->loop, params->loop);
+        publish_params(voice, params);
+    }
+    pthread_mutex_unlock(&mixer->control_lock);
+    return voice ? 0 : -1;
+}
+
+int mixer_stop(Mixer *mixer, int id) {
+    if (!mixer) return -1;
+
+    pthread_mutex_lock(&mixer->control_lock);
+    MixerVoice *voice = find_voice(mixer, id);
+    if (voice) atomic_store(&voice->stop_requested, true);
+    pthread_mutex_unlock(&mixer->control_lock);
+    return voice ? 0 : -1;
+}
+
+bool mixer_voice_active(Mixer *mixer, int id) {
+    if (!mixer) return false;
+
+    pthread_mutex_lock(&mixer->control_lock);
+    bool active = find_voice(mixer, id) != NULL;
+    pthread_mutex_unlock(&mixer->control_lock);
+    return active;
+}
+
+bool mixer_has_voices(Mixer *mixer) {
+    return mixer && atomic_load_explicit(&mixer->active, memory_order_relaxed) > 0;
+}
+
+void mixer_set_ducking(Mixer *mixer, float duck_db, float attack_ms, float release_ms) {
+    if (!mixer) return;
+    if (duck_db > 0.0f) duck_db = 0.0f;
+    atomic_store(&mixer->duck_target, powf(10.0f, duck_db / 20.0f));
+    atomic_store(&mixer->duck_attack_ms, attack_ms > 1.0f ? attack_ms : 1.0f);
+    atomic_store(&mixer->duck_release_ms, release_ms > 1.0f ? release_ms : 1.0f);
+}
+
+void mixer_get_stats(Mixer *mixer, MixerStats *stats) {
+    if (!mixer || !stats) return;
+    stats->active = atomic_load_explicit(&mixer->active, memory_order_relaxed);
+    stats->started = atomic_load_explicit(&mixer->started, memory_order_relaxed);
+    stats->finished = atomic_load_explicit(&mixer->finished, memory_order_relaxed);
+    stats->starved_blocks = atomic_load_explicit(&mixer->starved, memory_order_relaxed);
+    stats->duck_gain = atomic_load_explicit(&mixer->duck_now, memory_order_relaxed);
+}
+
+// ---- audio thread ---------------------------------------------------------------
+
+static inline MixVec load_vec(const float *p) {
+    MixVec v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline void store_vec(float *p, MixVec v) {
+    memcpy(p, &v, sizeof(v));
+}
+
+// bus += in * gain, the gains moving linearly from (l0, r0) to (l1, r1) over the block
+static void accumulate_stereo(float *bus, const float *in, size_t frames, float l0, float r0, float l1, float r1) {
+    float dl = (l1 - l0) / (float)frames;
+    float dr = (r1 - r0) / (float)frames;
+    MixVec gain = {l0, r0, l0 + dl, r0 + dr};
+    MixVec step = {2.0f * dl, 2.0f * dr, 2.0f * dl, 2.0f * dr};
+
+    size_t i = 0;
+    for (; i + 2 <= frames; i += 2) {
+        store_vec(bus + i * 2, load_vec(bus + i * 2) + load_vec(in + i * 2) * gain);
+        gain += step;
+    }
+    if (i < frames) {
+        bus[i * 2] += in[i * 2] * gain[0];
+        bus[i * 2 + 1] += in[i * 2 + 1] * gain[1];
+    }
+}
+
+static void accumulate_mono(float *bus, const float *in, size_t frames, float g0, float g1) {
+    float step = (g1 - g0) / (float)frames;
+    for (size_t i = 0; i < frames; i++) {
+        bus[i] += in[i] * (g0 + step * (float)i);
+    }
+}
+
+static void scale_ramp(float *bus, size_t samples, float g0, float g1) {
+    float step = (g1 - g0) / (float)samples;
+    for (size_t i = 0; i < samples; i++) {
+        bus[i] *= g0 + step * (float)i;
+    }
+}
+
+static void finish_voice(MixerVoice *voice) {
+    atomic_store_explicit(&voice->state, VOICE_DONE, memory_order_release);
+}
+
+// mixes one voice over the whole callback; returns false once it has finished
+static bool mix_voice(Mixer *mixer, MixerVoice *voice, float *bus, size_t frames, int channels,
+                      int sample_rate, float master) {
+    if (atomic_load_explicit(&voice->stop_requested, memory_order_relaxed)) voice->fading_out = true;
+
+    float target_l, target_r;
+    pan_gains(&voice->live, channels, master, &target_l, &target_r);
+    float fade_step = 1.0f / (MIXER_FADE_SECONDS * (float)sample_rate);
+
+    bool starved = false;
+    for (size_t done = 0; done < frames;) {
+        size_t want = frames - done;
+        if (want > MIXER_BLOCK_FRAMES) want = MIXER_BLOCK_FRAMES;
+
+        size_t got = ring_buffer_read(voice->ring, mixer->scratch, want * channels) / channels;
+        if (got < want) {
+            if (atomic_load_explicit(&voice->eof, memory_order_acquire) &&
+                ring_buffer_read_available(voice->ring) == 0) {
+                voice->fading_out = true;
+                if (got == 0) return false;
+            } else if (voice->sounding) {
+                starved = true;
+            }
+        }
+        if (got == 0) break;
+        voice->sounding = true;
+
+        float fade_end = voice->fade + (voice->fading_out ? -fade_step : fade_step) * (float)got;
+        fade_end = fade_end < 0.0f ? 0.0f : fade_end > 1.0f ? 1.0f : fade_end;
+
+        if (channels == 2) {
+            accumulate_stereo(bus + done * 2, mixer->scratch, got, voice->gain_l * voice->fade,
+                              voice->gain_r * voice->fade, target_l * fade_end, target_r * fade_end);
+        } else {
+            accumulate_mono(bus + done, mixer->scratch, got, voice->gain_l * voice->fade, target_l * fade_end);
+        }
+        voice->gain_l = target_l;
+        voice->gain_r = target_r;
+        voice->fade = fade_end;
+        done += got;
+
+        if (voice->fading_out && voice->fade <= 0.0f) return false;
+    }
+
+    if (starved) atomic_fetch_add_explicit(&mixer->starved, 1, memory_order_relaxed);
+    return true;
+}
+
+void mixer_render(Mixer *mixer, float *bus, size_t frames, int channels, int sample_rate, float master) {
+    if (!mixer || !bus || frames == 0 || sample_rate <= 0) return;
+    if (atomic_load_explicit(&mixer->active, memory_order_relaxed) == 0 && mixer->duck == 1.0f) return;
+    TRACE_SCOPE("mixer_render");
+
+    // parameters first: whether any announcement is live decides the bus gain
+    bool ducking = false;
+    for (int i = 0; i < MIXER_MAX_VOICES; i++) {
+        MixerVoice *voice = &mixer->voices[i];
+        if (atomic_load_explicit(&voice->state, memory_order_acquire) != VOICE_ACTIVE) continue;
+        pickup_params(voice);
+        ducking |= voice->live.duck && !voice->fading_out;
+    }
+
+    float target = ducking ? atomic_load_explicit(&mixer->duck_target, memory_order_relaxed) : 1.0f;
+    float time_ms = target < mixer->duck ? atomic_load_explicit(&mixer->duck_attack_ms, memory_order_relaxed)
+                                         : atomic_load_explicit(&mixer->duck_release_ms, memory_order_relaxed);
+    float coef = expf(-(float)frames * 1000.0f / (time_ms * (float)sample_rate));
+    float duck = target + (mixer->duck - target) * coef;
+    if (fabsf(duck - target) < 1e-4f) duck = target;
+    if (mixer->duck != 1.0f || duck != 1.0f) {
+        scale_ramp(bus, frames * channels, mixer->duck, duck);
+    }
+    mixer->duck = duck;
+    atomic_store_explicit(&mixer->duck_now, duck, memory_order_relaxed);
+
+    bool mixed = false;
+    for (int i = 0; i < MIXER_MAX_VOICES; i++) {
+        MixerVoice *voice = &mixer->voices[i];
+        if (atomic_load_explicit(&voice->state, memory_order_acquire) != VOICE_ACTIVE) continue;
+
+        // a voice decoded for another layout cannot be mixed; it just ends
+        if (voice->channels != channels || voice->rate != sample_rate ||
+            !mix_voice(mixer, voice, bus, frames, channels, sample_rate, master)) {
+            finish_voice(voice);
+        }
+        mixed = true;
+    }
+
+    if (mixed) {
+        for (size_t i = 0; i < frames * channels; i++) {
+            if (bus[i] > 1.0f) bus[i] = 1.0f;
+            if (bus[i] < -1.0f) bus[i] = -1.0f;
+        }
+    }
+}
@@ -0,0 +1,146 @@
+#include "core/decoder.h"
+#include "core/trace.h"
+#include "core/log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <mpg123.h>
+
+typedef struct {
+    Decoder base;
+    mpg123_handle *mh;
+    bool is_open;
+} Mpg123Decoder;
+
+static int mpg123_decoder_open(Decoder *decoder, const char *path) {
+    Mpg123Decoder *mp3 = (Mpg123Decoder *)decoder;
+
+    TRACE_BEGIN(open_span, "mpg123_open");
+    int open_err = mpg123_open(mp3->mh, path);
+    TRACE_END(open_span);
+    if (open_err != MPG123_OK) {
+        LOG_ERROR("Failed to open file: %s", mpg123_strerror(mp3->mh));
+        return -1;
+    }
+    mp3->is_open = true;
+
+    TRACE_BEGIN(scan_span, "mpg123_scan");
+    mpg123_scan(mp3->mh);
+    TRACE_END(scan_span);
+
+    size_t buffer_size = 1024;
+    unsigned char *buffer = malloc(buffer_size);
+    if (!buffer) {
+        LOG_ERROR("Failed to allocate buffer for format detection");
+        decoder->ops->close(decoder);
+        return -1;
+    }
+
+    TRACE_BEGIN(probe_span, "probe_read");
+    size_t done = 0;
+    int read_err = mpg123_read(mp3->mh, buffer, buffer_size, &done);
+    free(buffer);
+
+    mpg123_seek(mp3->mh, 0, SEEK_SET);
+    TRACE_END(probe_span);
+
+    if (read_err != MPG123_OK && read_err != MPG123_DONE && read_err != MPG123_NEW_FORMAT) {
+        LOG_ERROR("Failed to read initial data: %s (code %d)", mpg123_strerror(mp3->mh), read_err);
+        decoder->ops->close(decoder);
+        return -1;
+    }
+
+    int channels, encoding;
+    long rate;
+    if (mpg123_getformat(mp3->mh, &rate, &channels, &encoding) != MPG123_OK) {
+        LOG_ERROR("Failed to get format: %s (code %d)", mpg123_strerror(mp3->mh), mpg123_errcode(mp3->mh));
+        decoder->ops->close(decoder);
+        return -1;
+    }
+
+    off_t length = mpg123_length(mp3->mh);
+    decoder->rate = rate;
+    decoder->channels = channels;
+    decoder->length_frames = length != MPG123_ERR ? (long long)length : -1;
+    return 0;
+}
+
+static DecoderStatus mpg123_decoder_read(Decoder *decoder, float *out, size_t max_frames, size_t *frames_read) {
+    Mpg123Decoder *mp3 = (Mpg123Decoder *)decoder;
+    if (!mp3->is_open) return DECODER_ERROR;
+
+    size_t frame_bytes = sizeof(float) * decoder->channels;
+    size_t got = 0;
+    int err = mpg123_read(mp3->mh, (unsigned char *)out, max_frames * frame_bytes, &got);
+    *frames_read = got / frame_bytes;
+
+    if (err == MPG123_NEW_FORMAT) {
+        int channels, encoding;
+        long rate;
+        if (mpg123_getformat(mp3->mh, &rate, &channels, &encoding) == MPG123_OK) {
+            decoder->rate = rate;
+            decoder->channels = channels;
+        }
+        return DECODER_NEW_FORMAT;
+    } else if (err == MPG123_DONE) {
+        return DECODER_DONE;
+    } else if (err != MPG123_OK && err != MPG123_NEED_MORE) {
+        return DECODER_ERROR;
+    }
+    return DECODER_OK;
+}
+
+static int mpg123_decoder_seek(Decoder *decoder, long long frame) {
+    Mpg123Decoder *mp3 = (Mpg123Decoder *)decoder;
+    if (!mp3->is_open) return -1;
+    return mpg123_seek(mp3->mh, (off_t)frame, SEEK_SET) < 0 ? -1 : 0;
+}
+
+static void mpg123_decoder_close(Decoder *decoder) {
+    Mpg123Decoder *mp3 = (Mpg123Decoder *)decoder;
+    if (mp3->is_open) {
+        mpg123_close(mp3->mh);
+        mp3->is_open = false;
+    }
+}
+
+static void mpg123_decoder_destroy(Decoder *decoder) {
+    Mpg123Decoder *mp3 = (Mpg123Decoder *)decoder;
+    mpg123_decoder_close(decoder);
+    mpg123_delete(mp3->mh);
+    free(mp3);
+}
+
+static const char* mpg123_decoder_error_string(Decoder *decoder) {
+    return mpg123_strerror(((Mpg123Decoder *)decoder)->mh);
+}
+
+static const DecoderOps mpg123_decoder_ops = {
+    .name = "mpg123",
+    .open = mpg123_decoder_open,
+    .read = mpg123_decoder_read,
+    .seek = mpg123_decoder_seek,
+    .close = mpg123_decoder_close,
+    .destroy = mpg123_decoder_destroy,
+    .error_string = mpg123_decoder_error_string,
+};
+
+Decoder* mpg123_decoder_create(void) {
+    Mpg123Decoder *mp3 = calloc(1, sizeof(Mpg123Decoder));
+    if (!mp3) return NULL;
+
+    mp3->mh = mpg123_new(NULL, NULL);
+    if (!mp3->mh) {
+        LOG_ERROR("Failed to create mpg123 handle");
+        free(mp3);
+        return NULL;
+    }
+
+    mpg123_param(mp3->mh, MPG123_ADD_FLAGS, MPG123_FORCE_FLOAT, 0.0);
+    mpg123_param(mp3->mh, MPG123_ADD_FLAGS, MPG123_FORCE_STEREO, 0.0);
+    mpg123_param(mp3->mh, MPG123_ADD_FLAGS, MPG123_QUIET, 0.0);
+    mpg123_param(mp3->mh, MPG123_ADD_FLAGS, MPG123_IGNORE_INFOFRAME, 0.0);
+
+    mp3->base.ops = &mpg123_decoder_ops;
+    mp3->base.length_frames = -1;
+    return &mp3->base;
+}
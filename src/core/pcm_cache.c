@@ -0,0 +1,480 @@
+#include "core/pcm_cache.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/stat.h>
+
+#define PCM_CACHE_BUCKETS 256
+
+typedef struct {
+    uint64_t device;
+    uint64_t inode;
+    uint64_t size;
+    int64_t mtime_ns;
+} PcmFileId;
+
+typedef struct PcmSegment {
+    PcmFileId file;
+    long long index;            // frames [index * PCM_CACHE_SEGMENT_FRAMES, + frames)
+    long rate;
+    int channels;
+    long long length_frames;    // of the whole file, as its decoder knew it
+    size_t frames;              // short only for the last segment
+    bool packed;
+    size_t bytes;
+    void *samples;
+    int refs;                   // one for being cached, one per decoder reading it
+    struct PcmSegment *hash_next;
+    struct PcmSegment *lru_prev;
+    struct PcmSegment *lru_next;
+} PcmSegment;
+
+struct PcmCache {
+    pthread_mutex_t lock;
+    PcmSegment *buckets[PCM_CACHE_BUCKETS];
+    PcmSegment *lru_head;       // most recently used
+    PcmSegment *lru_tail;
+    size_t budget;
+    size_t bytes;
+    int segments;
+    bool packed;
+
+    atomic_uint_least64_t hits;
+    atomic_uint_least64_t misses;
+    atomic_uint_least64_t evictions;
+};
+
+static bool same_file(const PcmFileId *a, const PcmFileId *b) {
+    return a->device == b->device && a->inode == b->inode && a->size == b->size && a->mtime_ns == b->mtime_ns;
+}
+
+static size_t bucket_of(const PcmFileId *file, long long index) {
+    uint64_t hash = file->inode * 0x9e3779b97f4a7c15ULL ^ file->device ^ (uint64_t)index * 0xff51afd7ed558ccdULL;
+    return (size_t)(hash >> 32) % PCM_CACHE_BUCKETS;
+}
+
+// caller holds the lock
+static void release_locked(PcmSegment *segment) {
+    if (--segment->refs > 0) return;
+    free(segment->samples);
+    free(segment);
+}
+
+static void lru_unlink(PcmCache *cache, PcmSegment *segment) {
+    if (segment->lru_prev) segment->lru_prev->lru_next = segment->lru_next;
+    else cache->lru_head = segment->lru_next;
+    if (segment->lru_next) segment->lru_next->lru_prev = segment->lru_prev;
+    else cache->lru_tail = segment->lru_prev;
+    segment->lru_prev = segment->lru_next = NULL;
+}
+
+static void lru_push(PcmCache *cache, PcmSegment *segment) {
+    segment->lru_next = cache->lru_head;
+    if (cache->lru_head) cache->lru_head->lru_prev = segment;
+    cache->lru_head = segment;
+    if (!cache->lru_tail) cache->lru_tail = segment;
+}
+
+// a decoder still reading the segment keeps it alive until it lets go
+static void evict_locked(PcmCache *cache, PcmSegment *segment) {
+    PcmSegment **link = &cache->buckets[bucket_of(&segment->file, segment->index)];
+    while (*link != segment) link = &(*link)->hash_next;
+    *link = segment->hash_next;
+    lru_unlink(cache, segment);
+    cache->bytes -= segment->bytes;
+    cache->segments--;
+    atomic_fetch_add_explicit(&cache->evictions, 1, memory_order_relaxed);
+    release_locked(segment);
+}
+
+static void shrink_locked(PcmCache *cache, size_t budget) {
+    while (cache->lru_tail && cache->bytes > budget) {
+        evict_locked(cache, cache->lru_tail);
+    }
+}
+
+// pinned for the caller, who releases it
+static PcmSegment *acquire(PcmCache *cache, const PcmFileId *file, long long index) {
+    pthread_mutex_lock(&cache->lock);
+    PcmSegment *segment = cache->buckets[bucket_of(file, index)];
+    while (segment && !(segment->index == index && same_file(&segment->file, file))) {
+        segment = segment->hash_next;
+    }
+    if (segment) {
+        segment->refs++;
+        lru_unlink(cache, segment);
+        lru_push(cache, segment);
+    }
+    pthread_mutex_unlock(&cache->lock);
+    return segment;
+}
+
+static void release(PcmCache *cache, PcmSegment *segment) {
+    if (!segment) return;
+    pthread_mutex_lock(&cache->lock);
+    release_locked(segment);
+    pthread_mutex_unlock(&cache->lock);
+}
+
+// copies frames of interleaved float in, packing them if the cache does
+static void insert(PcmCache *cache, const PcmFileId *file, long long index, const Decoder *format,
+                   const float *samples, size_t frames) {
+    pthread_mutex_lock(&cache->lock);
+    bool packed = cache->packed;
+    size_t budget = cache->budget;
+    pthread_mutex_unlock(&cache->lock);
+
+    size_t count = frames * (size_t)format->channels;
+    size_t bytes = count * (packed ? sizeof(int16_t) : sizeof(float));
+    if (frames == 0 || bytes > budget) return;
+
+    PcmSegment *segment = calloc(1, sizeof(PcmSegment));
+    void *copy = malloc(bytes);
+    if (!segment || !copy) {
+        free(segment);
+        free(copy);
+        return;
+    }
+    if (packed) {
+        int16_t *out = copy;
+        for (size_t i = 0; i < count; i++) {
+            long value = lrintf(samples[i] * 32768.0f);
+            out[i] = (int16_t)(value > 32767 ? 32767 : value < -32768 ? -32768 : value);
+        }
+    } else {
+        memcpy(copy, samples, bytes);
+    }
+    segment->file = *file;
+    segment->index = index;
+    segment->rate = format->rate;
+    segment->channels = format->channels;
+    segment->length_frames = format->length_frames;
+    segment->frames = frames;
+    segment->packed = packed;
+    segment->bytes = bytes;
+    segment->samples = copy;
+    segment->refs = 1;
+
+    pthread_mutex_lock(&cache->lock);
+    // another decoder of the same file may have got there first, or packing changed
+    PcmSegment *existing = cache->buckets[bucket_of(file, index)];
+    while (existing && !(existing->index == index && same_file(&existing->file, file))) {
+        existing = existing->hash_next;
+    }
+    if (existing || packed != cache->packed) {
+        release_locked(segment);
+    } else {
+        shrink_locked(cache, cache->budget > bytes ? cache->budget - bytes : 0);
+        size_t bucket = bucket_of(file, index);
+        segment->hash_next = cache->buckets[bucket];
+        cache->buckets[bucket] = segment;
+        lru_push(cache, segment);
+        cache->bytes += bytes;
+        cache->segments++;
+    }
+    pthread_mutex_unlock(&cache->lock);
+}
+
+PcmCache* pcm_cache_create(size_t budget_bytes, bool pack16) {
+    PcmCache *cache = calloc(1, sizeof(PcmCache));
+    if (!cache) return NULL;
+
+    pthread_mutex_init(&cache->lock, NULL);
+    cache->budget = budget_bytes;
+    cache->packed = pack16;
+    return cache;
+}
+
+void pcm_cache_destroy(PcmCache *cache) {
+    if (!cache) return;
+    pcm_cache_clear(cache);
+    pthread_mutex_destroy(&cache->lock);
+    free(cache);
+}
+
+void pcm_cache_configure(PcmCache *cache, size_t budget_bytes, bool pack16) {
+    if (!cache) return;
+    pthread_mutex_lock(&cache->lock);
+    cache->budget = budget_bytes;
+    shrink_locked(cache, pack16 == cache->packed ? budget_bytes : 0);
+    cache->packed = pack16;
+    pthread_mutex_unlock(&cache->lock);
+}
+
+void pcm_cache_clear(PcmCache *cache) {
+    if (!cache) return;
+    pthread_mutex_lock(&cache->lock);
+    shrink_locked(cache, 0);
+    pthread_mutex_unlock(&cache->lock);
+}
+
+void pcm_cache_get_stats(PcmCache *cache, PcmCacheStats *stats) {
+    if (!stats) return;
+    memset(stats, 0, sizeof(*stats));
+    if (!cache) return;
+
+    stats->hits = atomic_load(&cache->hits);
+    stats->misses = atomic_load(&cache->misses);
+    stats->evictions = atomic_load(&cache->evictions);
+    pthread_mutex_lock(&cache->lock);
+    stats->bytes = cache->bytes;
+    stats->budget = cache->budget;
+    stats->segments = cache->segments;
+    stats->packed = cache->packed;
+    pthread_mutex_unlock(&cache->lock);
+}
+
+typedef struct {
+    Decoder base;
+    PcmCache *cache;
+    Decoder *source;
+    bool source_open;
+    char *path;
+    PcmFileId file;
+    bool caching;               // false: reads go straight to the source
+    long long position;         // next frame read returns
+    long long source_position;  // next frame the source returns
+    PcmSegment *segment;        // pinned, holds position
+    float *fill;                // the segment being decoded from the source
+    long long fill_index;       // -1 when none
+    size_t fill_frames;
+    bool fill_complete;         // nothing more will be added to it
+    bool format_changed;        // the source switched format after the fill
+    const char *error;
+} CachedDecoder;
+
+static int cached_decoder_open(Decoder *decoder, const char *path) {
+    CachedDecoder *cached = (CachedDecoder *)decoder;
+    if (!cached->source) return -1;
+
+    // a player closes before reopening, but the source may also have been swapped
+    release(cached->cache, cached->segment);
+    cached->segment = NULL;
+    if (cached->source_open) decoder_close(cached->source);
+    cached->source_open = false;
+    free(cached->path);
+    cached->path = strdup(path);
+    if (!cached->path) return -1;
+    cached->position = 0;
+    cached->fill_index = -1;
+    cached->format_changed = false;
+    cached->error = NULL;
+
+    PcmCacheStats stats;
+    pcm_cache_get_stats(cached->cache, &stats);
+    struct stat st;
+    cached->caching = stats.budget > 0 && stat(path, &st) == 0 && S_ISREG(st.st_mode);
+    if (cached->caching) {
+        cached->file = (PcmFileId){ (uint64_t)st.st_dev, (uint64_t)st.st_ino, (uint64_t)st.st_size,
+                                    (int64_t)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec };
+    }
+
+    // opened here, with the track, even when it is cached: a miss after a run of hits then
+    // only seeks the source instead of opening and scanning the file on the decode path
+    if (decoder_open(cached->source, path) != 0) {
+        free(cached->path);
+        cached->path = NULL;
+        return -1;
+    }
+    cached->source_open = true;
+    cached->source_position = 0;
+    decoder->rate = cached->source->rate;
+    decoder->channels = cached->source->channels;
+    decoder->length_frames = cached->source->length_frames;
+    return 0;
+}
+
+static void copy_out(const PcmSegment *segment, size_t offset, float *out, size_t frames) {
+    size_t start = offset * (size_t)segment->channels;
+    size_t count = frames * (size_t)segment->channels;
+    if (segment->packed) {
+        const int16_t *samples = (const int16_t *)segment->samples + start;
+        for (size_t i = 0; i < count; i++) out[i] = samples[i] * (1.0f / 32768.0f);
+    } else {
+        memcpy(out, (const float *)segment->samples + start, count * sizeof(float));
+    }
+}
+
+// the source is told to read the segment from its start, so every cached segment is whole
+static DecoderStatus fill_segment(CachedDecoder *cached, long long index, size_t needed, size_t max_frames) {
+    if (!cached->source_open) return DECODER_ERROR;
+    if (!cached->fill) {
+        cached->fill = malloc(PCM_CACHE_SEGMENT_FRAMES * DECODER_MAX_CHANNELS * sizeof(float));
+        if (!cached->fill) return DECODER_ERROR;
+    }
+
+    if (cached->fill_index != index) {
+        long long start = index * PCM_CACHE_SEGMENT_FRAMES;
+        if (cached->source_position != start && decoder_seek(cached->source, start) != 0) {
+            cached->error = "cannot seek to the segment";
+            return DECODER_ERROR;
+        }
+        cached->source_position = start;
+        cached->fill_index = index;
+        cached->fill_frames = 0;
+        cached->fill_complete = false;
+        atomic_fetch_add_explicit(&cached->cache->misses, 1, memory_order_relaxed);
+    }
+
+    int channels = cached->base.channels;
+    while (cached->fill_frames < needed && !cached->fill_complete) {
+        size_t room = PCM_CACHE_SEGMENT_FRAMES - cached->fill_frames;
+        size_t want = needed - cached->fill_frames > max_frames ? needed - cached->fill_frames : max_frames;
+        size_t frames = 0;
+        DecoderStatus status = decoder_read(cached->source, cached->fill + cached->fill_frames * channels,
+                                            want < room ? want : room, &frames);
+        if (status == DECODER_NEW_FORMAT) {
+            // the fill ends here and is played out, but not cached; then the format switches
+            cached->format_changed = true;
+            cached->fill_complete = true;
+            return DECODER_OK;
+        }
+        if (status == DECODER_ERROR) return status;
+        if (status == DECODER_DONE) cached->fill_complete = true;     // a short last segment
+        if (frames == 0 && status == DECODER_OK) return DECODER_OK;
+
+        cached->fill_frames += frames;
+        cached->source_position += (long long)frames;
+        // a known length finishes the last segment without waiting for DONE
+        long long length = cached->base.length_frames;
+        if (length > 0 && cached->source_position >= length) cached->fill_complete = true;
+        if (cached->fill_frames == PCM_CACHE_SEGMENT_FRAMES || cached->fill_complete) {
+            insert(cached->cache, &cached->file, index, &cached->base, cached->fill, cached->fill_frames);
+            cached->fill_complete = true;
+        }
+    }
+    return DECODER_OK;
+}
+
+// cannot be stored as one format; the rest of the file skips the cache, and the next
+// read reports the new format
+static void stop_caching(CachedDecoder *cached) {
+    cached->caching = false;
+    cached->fill_index = -1;
+    cached->base.rate = cached->source->rate;
+    cached->base.channels = cached->source->channels;
+}
+
+static DecoderStatus cached_decoder_read(Decoder *decoder, float *out, size_t max_frames, size_t *frames_read) {
+    CachedDecoder *cached = (CachedDecoder *)decoder;
+    if (!cached->caching) {
+        if (!cached->source_open) return DECODER_ERROR;
+        if (cached->format_changed) {
+            cached->format_changed = false;
+            return DECODER_NEW_FORMAT;
+        }
+        DecoderStatus status = decoder_read(cached->source, out, max_frames, frames_read);
+        decoder->rate = cached->source->rate;
+        decoder->channels = cached->source->channels;
+        cached->position += (long long)*frames_read;
+        return status;
+    }
+
+    long long length = decoder->length_frames;
+    if (length > 0 && cached->position >= length) return DECODER_DONE;
+
+    long long index = cached->position / PCM_CACHE_SEGMENT_FRAMES;
+    size_t offset = (size_t)(cached->position % PCM_CACHE_SEGMENT_FRAMES);
+    if (cached->segment && cached->segment->index != index) {
+        release(cached->cache, cached->segment);
+        cached->segment = NULL;
+    }
+    if (!cached->segment && cached->fill_index != index) {
+        cached->segment = acquire(cached->cache, &cached->file, index);
+        if (cached->segment) atomic_fetch_add_explicit(&cached->cache->hits, 1, memory_order_relaxed);
+    }
+
+    const PcmSegment *segment = cached->segment;
+    size_t available = 0;
+    if (segment) {
+        available = segment->frames > offset ? segment->frames - offset : 0;
+    } else {
+        DecoderStatus status = fill_segment(cached, index, offset + 1, max_frames);
+        if (status != DECODER_OK) return status;
+        available = cached->fill_frames > offset ? cached->fill_frames - offset : 0;
+        if (available == 0 && cached->format_changed) {
+            stop_caching(cached);
+            cached->format_changed = false;
+            return DECODER_NEW_FORMAT;
+        }
+        if (available == 0 && !cached->fill_complete) return DECODER_OK;
+    }
+    if (available == 0) return DECODER_DONE;
+
+    size_t frames = available < max_frames ? available : max_frames;
+    if (segment) {
+        copy_out(segment, offset, out, frames);
+    } else {
+        memcpy(out, cached->fill + offset * decoder->channels, frames * decoder->channels * sizeof(float));
+    }
+    cached->position += (long long)frames;
+    *frames_read = frames;
+    return DECODER_OK;
+}
+
+// lazy: the source only seeks when the target is not cached
+static int cached_decoder_seek(Decoder *decoder, long long frame) {
+    CachedDecoder *cached = (CachedDecoder *)decoder;
+    if (cached->format_changed && cached->caching) stop_caching(cached);
+    if (!cached->caching) {
+        if (!cached->source_open || decoder_seek(cached->source, frame) != 0) return -1;
+        cached->position = frame;
+        return 0;
+    }
+    if (decoder->length_frames > 0 && frame > decoder->length_frames) return -1;
+    cached->position = frame;
+    return 0;
+}
+
+static void cached_decoder_close(Decoder *decoder) {
+    CachedDecoder *cached = (CachedDecoder *)decoder;
+    release(cached->cache, cached->segment);
+    cached->segment = NULL;
+    if (cached->source_open) decoder_close(cached->source);
+    cached->source_open = false;
+    cached->fill_index = -1;
+    free(cached->path);
+    cached->path = NULL;
+}
+
+static void cached_decoder_destroy(Decoder *decoder) {
+    CachedDecoder *cached = (CachedDecoder *)decoder;
+    cached_decoder_close(decoder);
+    free(cached->fill);
+    free(cached);
+}
+
+static const char *cached_decoder_error_string(Decoder *decoder) {
+    CachedDecoder *cached = (CachedDecoder *)decoder;
+    if (cached->error) return cached->error;
+    return cached->source_open ? decoder_error_string(cached->source) : "no error";
+}
+
+static const DecoderOps cached_decoder_ops = {
+    .name = "pcm_cache",
+    .open = cached_decoder_open,
+    .read = cached_decoder_read,
+    .seek = cached_decoder_seek,
+    .close = cached_decoder_close,
+    .destroy = cached_decoder_destroy,
+    .error_string = cached_decoder_error_string,
+};
+
+Decoder* pcm_cache_decoder_create(PcmCache *cache) {
+    if (!cache) return NULL;
+    CachedDecoder *cached = calloc(1, sizeof(CachedDecoder));
+    if (!cached) return NULL;
+
+    cached->base.ops = &cached_decoder_ops;
+    cached->base.length_frames = -1;
+    cached->cache = cache;
+    cached->fill_index = -1;
+    return &cached->base;
+}
+
+void pcm_cache_decoder_set_source(Decoder *decoder, Decoder *source) {
+    if (!decoder || decoder->ops != &cached_decoder_ops) return;
+    ((CachedDecoder *)decoder)->source = source;
+}
@@ -1,6 +1,8 @@
 #include "core/playlist.h"
+#include "core/trace.h"
 #include <strings.h>
 #include <stdbool.h>
+#include <sys/mman.h>
 
 #define INITIAL_CAPACITY 16
 
@@ -17,16 +19,35 @@ Playlist* playlist_create(void) {
     playlist->count = 0;
     playlist->current_index = 0;
     playlist->capacity = INITIAL_CAPACITY;
+    playlist->order = NULL;
+    playlist->order_position = 0;
+    playlist->mapping = NULL;
+    playlist->mapping_size = 0;
 
     return playlist;
 }
 
-void playlist_destroy(Playlist *playlist) {
-    if (!playlist) return;
+static bool is_mapped(Playlist *playlist, const char *file) {
+    const char *start = playlist->mapping;
+    return start && file >= start && file < start + playlist->mapping_size;
+}
 
+static void release_entries(Playlist *playlist) {
     for (int i = 0; i < playlist->count; i++) {
-        free(playlist->files[i]);
+        if (!is_mapped(playlist, playlist->files[i])) free(playlist->files[i]);
     }
+    free(playlist->order);
+    playlist->order = NULL;
+    playlist->order_position = 0;
+    if (playlist->mapping) munmap(playlist->mapping, playlist->mapping_size);
+    playlist->mapping = NULL;
+    playlist->mapping_size = 0;
+}
+
+void playlist_destroy(Playlist *playlist) {
+    if (!playlist) return;
+
+    release_entries(playlist);
     free(playlist->files);
     free(playlist);
 }
@@ -38,32 +59,87 @@ int is_mp3_file(const char *filename) {
     return (strcasecmp(ext, ".mp3") == 0);
 }
 
-static int expand_playlist(Playlist *playlist) {
-    int new_capacity = playlist->capacity * 2;
-    char **new_files = realloc(playlist->files, sizeof(char*) * new_capacity);
-    if (!new_files) return -1;
+int is_wav_file(const char *filename) {
+    const char *ext = strrchr(filename, '.');
+    if (!ext) return 0;
+
+    return (strcasecmp(ext, ".wav") == 0 || strcasecmp(ext, ".wave") == 0);
+}
+
+int is_audio_file(const char *filename) {
+    return is_mp3_file(filename) || is_wav_file(filename);
+}
+
+int playlist_reserve(Playlist *playlist, int capacity) {
+    if (!playlist) return -1;
+    if (capacity <= playlist->capacity) return 0;
 
+    char **new_files = realloc(playlist->files, sizeof(char*) * capacity);
+    if (!new_files) return -1;
     playlist->files = new_files;
-    playlist->capacity = new_capacity;
+
+    if (playlist->order) {
+        int *new_order = realloc(playlist->order, sizeof(int) * capacity);
+        if (!new_order) return -1;
+        playlist->order = new_order;
+    }
+
+    playlist->capacity = capacity;
     return 0;
 }
 
-int playlist_add_file(Playlist *playlist, const char *filename) {
-    if (!playlist || !filename) return -1;
+static int expand_playlist(Playlist *playlist) {
+    return playlist_reserve(playlist, playlist->capacity * 2);
+}
 
+static int append_entry(Playlist *playlist, char *file) {
     if (playlist->count >= playlist->capacity) {
         if (expand_playlist(playlist) != 0) return -1;
     }
 
-    playlist->files[playlist->count] = strdup(filename);
-    if (!playlist->files[playlist->count]) return -1;
-
+    if (playlist->order) playlist->order[playlist->count] = playlist->count;
+    playlist->files[playlist->count] = file;
     playlist->count++;
     return 0;
 }
 
+int playlist_add_file(Playlist *playlist, const char *filename) {
+    if (!playlist || !filename) return -1;
+
+    char *file = strdup(filename);
+    if (!file) return -1;
+    if (append_entry(playlist, file) != 0) {
+        free(file);
+        return -1;
+    }
+    return 0;
+}
+
+void playlist_adopt_mapping(Playlist *playlist, void *mapping, size_t size) {
+    if (!playlist) return;
+
+    if (playlist->mapping) {
+        // entries still pointing into the old mapping have to survive it
+        for (int i = 0; i < playlist->count; i++) {
+            if (is_mapped(playlist, playlist->files[i])) {
+                char *copy = strdup(playlist->files[i]);
+                if (copy) playlist->files[i] = copy;
+            }
+        }
+        munmap(playlist->mapping, playlist->mapping_size);
+    }
+    playlist->mapping = mapping;
+    playlist->mapping_size = size;
+}
+
+int playlist_add_mapped(Playlist *playlist, const char *filename) {
+    if (!playlist || !filename || !is_mapped(playlist, filename)) return -1;
+    return append_entry(playlist, (char *)filename);
+}
+
 int playlist_add_directory(Playlist *playlist, const char *directory) {
     if (!playlist || !directory) return -1;
+    TRACE_SCOPE("scan_directory");
 
     DIR *dir = opendir(directory);
     if (!dir) return -1;
@@ -77,7 +153,7 @@ int playlist_add_directory(Playlist *playlist, const char *directory) {
             continue;
         }
 
-        if (is_mp3_file(entry->d_name)) {
+        if (is_audio_file(entry->d_name)) {
             snprintf(filepath, sizeof(filepath), "%s/%s", directory, entry->d_name);
 
             struct stat st;
@@ -103,6 +179,12 @@ const char* playlist_get_current(Playlist *playlist) {
 int playlist_next(Playlist *playlist) {
     if (!playlist || playlist->count == 0) return -1;
 
+    if (playlist->order) {
+        playlist->order_position = (playlist->order_position + 1) % playlist->count;
+        playlist->current_index = playlist->order[playlist->order_position];
+        return playlist->current_index;
+    }
+
     playlist->current_index++;
     if (playlist->current_index >= playlist->count) {
         playlist->current_index = 0;
@@ -111,9 +193,29 @@ int playlist_next(Playlist *playlist) {
     return playlist->current_index;
 }
 
+int playlist_get_upcoming(Playlist *playlist, int *indices, int max) {
+    if (!playlist || !indices || playlist->count == 0 || playlist->current_index < 0) return 0;
+
+    int count = 0;
+    for (int step = 1; step < playlist->count && count < max; step++) {
+        if (playlist->order) {
+            indices[count++] = playlist->order[(playlist->order_position + step) % playlist->count];
+        } else {
+            indices[count++] = (playlist->current_index + step) % playlist->count;
+        }
+    }
+    return count;
+}
+
 int playlist_previous(Playlist *playlist) {
     if (!playlist || playlist->count == 0) return -1;
 
+    if (playlist->order) {
+        playlist->order_position = (playlist->order_position + playlist->count - 1) % playlist->count;
+        playlist->current_index = playlist->order[playlist->order_position];
+        return playlist->current_index;
+    }
+
     playlist->current_index--;
     if (playlist->current_index < 0) {
         playlist->current_index = playlist->count - 1;
@@ -136,9 +238,7 @@ void playlist_get_info(Playlist *playlist, int *current, int *total) {
 void playlist_clear(Playlist *playlist) {
     if (!playlist) return;
 
-    for (int i = 0; i < playlist->count; i++) {
-        free(playlist->files[i]);
-    }
+    release_entries(playlist);
     playlist->count = 0;
     playlist->current_index = 0;
 }
@@ -147,9 +247,87 @@ int playlist_set_current(Playlist *playlist, int index) {
     if (!playlist || index < 0 || index >= playlist->count) return -1;
 
     playlist->current_index = index;
+    if (playlist->order) {
+        for (int i = 0; i < playlist->count; i++) {
+            if (playlist->order[i] == index) {
+                playlist->order_position = i;
+                break;
+            }
+        }
+    }
     return playlist->current_index;
 }
 
+int playlist_set_shuffle(Playlist *playlist, bool enabled, unsigned int seed) {
+    if (!playlist) return -1;
+
+    if (!enabled) {
+        free(playlist->order);
+        playlist->order = NULL;
+        playlist->order_position = 0;
+        return 0;
+    }
+
+    int *order = playlist->order ? playlist->order : malloc(sizeof(int) * playlist->capacity);
+    if (!order) return -1;
+    for (int i = 0; i < playlist->count; i++) order[i] = i;
+
+    // Fisher-Yates on a xorshift stream, then the current track moved to the front
+    unsigned int state = seed ? seed : 0x9E3779B9u;
+    for (int i = playlist->count - 1; i > 0; i--) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        int j = (int)(state % (unsigned int)(i + 1));
+        int swap = order[i];
+        order[i] = order[j];
+        order[j] = swap;
+    }
+    for (int i = 0; i < playlist->count; i++) {
+        if (order[i] == playlist->current_index) {
+            order[i] = order[0];
+            order[0] = playlist->current_index;
+            break;
+        }
+    }
+
+    playlist->order = order;
+    playlist->order_position = 0;
+    return 0;
+}
+
+bool playlist_is_shuffled(Playlist *playlist) {
+    return playlist && playlist->order;
+}
+
+int playlist_set_order(Playlist *playlist, const int *order, int position) {
+    if (!playlist || !order || position < 0 || position >= playlist->count) return -1;
+
+    bool *seen = calloc((size_t)playlist->count, sizeof(bool));
+    int *copy = malloc(sizeof(int) * playlist->capacity);
+    if (!seen || !copy) {
+        free(seen);
+        free(copy);
+        return -1;
+    }
+    for (int i = 0; i < playlist->count; i++) {
+        if (order[i] < 0 || order[i] >= playlist->count || seen[order[i]]) {
+            free(seen);
+            free(copy);
+            return -1;
+        }
+        seen[order[i]] = true;
+        copy[i] = order[i];
+    }
+    free(seen);
+
+    free(playlist->order);
+    playlist->order = copy;
+    playlist->order_position = position;
+    playlist->current_index = copy[position];
+    return 0;
+}
+
 int playlist_get_count(Playlist *playlist) {
     return playlist ? playlist->count : 0;
 }
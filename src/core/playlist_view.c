@@ -0,0 +1,234 @@
+#include "core/playlist_view.h"
+#include "core/trace.h"
+#include <ctype.h>
+#include <time.h>
+
+#define PLAYLIST_VIEW_CLOCK_STRIDE 1024     // entries checked between looks at the clock
+
+struct PlaylistView {
+    Playlist *playlist;
+    int playlist_count;
+    int rows;
+    int top;
+    int cursor;
+
+    char query[PLAYLIST_VIEW_QUERY_MAX];    // lower-cased
+    int query_length;
+    bool filtering;
+
+    // matches[0, match_count) hold for the query. matches[narrow_next, narrow_end) held
+    // for a shorter query and are still being rechecked; compaction writes behind the
+    // read position, so both share one array. Entries from scan_next on are unchecked.
+    int *matches;
+    int capacity;
+    int match_count;
+    int narrow_next;
+    int narrow_end;
+    int scan_next;
+};
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+PlaylistView *playlist_view_create(void) {
+    PlaylistView *view = calloc(1, sizeof(PlaylistView));
+    if (!view) return NULL;
+    view->rows = 1;
+    return view;
+}
+
+void playlist_view_destroy(PlaylistView *view) {
+    if (!view) return;
+    free(view->matches);
+    free(view);
+}
+
+static bool ensure_capacity(PlaylistView *view) {
+    if (view->playlist_count <= view->capacity) return true;
+
+    int *matches = realloc(view->matches, (size_t)view->playlist_count * sizeof(int));
+    if (!matches) return false;
+    view->matches = matches;
+    view->capacity = view->playlist_count;
+    return true;
+}
+
+static void restart_scan(PlaylistView *view) {
+    view->match_count = 0;
+    view->narrow_next = 0;
+    view->narrow_end = 0;
+    view->scan_next = 0;
+}
+
+static void clear_query(PlaylistView *view) {
+    view->query[0] = '\0';
+    view->query_length = 0;
+    view->filtering = false;
+}
+
+static void keep_visible(PlaylistView *view) {
+    int count = playlist_view_count(view);
+    if (view->cursor >= count) view->cursor = count - 1;
+    if (view->cursor < 0) view->cursor = 0;
+
+    if (view->cursor < view->top) view->top = view->cursor;
+    if (view->cursor >= view->top + view->rows) view->top = view->cursor - view->rows + 1;
+    int last_top = count > view->rows ? count - view->rows : 0;
+    if (view->top > last_top) view->top = last_top;
+    if (view->top < 0) view->top = 0;
+}
+
+void playlist_view_sync(PlaylistView *view, Playlist *playlist, int rows) {
+    if (!view) return;
+    view->rows = rows > 0 ? rows : 1;
+
+    int count = playlist_get_count(playlist);
+    if (playlist != view->playlist || count != view->playlist_count) {
+        view->playlist = playlist;
+        view->playlist_count = count;
+        restart_scan(view);
+        if (view->filtering && !ensure_capacity(view)) clear_query(view);
+    }
+    keep_visible(view);
+}
+
+static bool name_matches(const char *path, const char *query, int length) {
+    const char *name = strrchr(path, '/');
+    name = name ? name + 1 : path;
+
+    for (const char *p = name; *p; p++) {
+        if (tolower((unsigned char)*p) != query[0]) continue;
+        int k = 1;
+        while (k < length && p[k] && tolower((unsigned char)p[k]) == query[k]) k++;
+        if (k == length) return true;
+    }
+    return false;
+}
+
+bool playlist_view_step(PlaylistView *view, Playlist *playlist, uint64_t budget_ns) {
+    if (!view || !view->filtering || playlist != view->playlist) return false;
+    TRACE_SCOPE("playlist_view_step");
+
+    uint64_t start = now_ns();
+    uint64_t deadline = budget_ns > UINT64_MAX - start ? UINT64_MAX : start + budget_ns;
+    int checked = 0;
+
+    while (view->narrow_next < view->narrow_end) {
+        int index = view->matches[view->narrow_next++];
+        if (name_matches(playlist_get_file_at(playlist, index), view->query, view->query_length)) {
+            view->matches[view->match_count++] = index;
+        }
+        if (++checked % PLAYLIST_VIEW_CLOCK_STRIDE == 0 && now_ns() >= deadline) return true;
+    }
+
+    while (view->scan_next < view->playlist_count) {
+        int index = view->scan_next++;
+        if (name_matches(playlist_get_file_at(playlist, index), view->query, view->query_length)) {
+            view->matches[view->match_count++] = index;
+        }
+        if (++checked % PLAYLIST_VIEW_CLOCK_STRIDE == 0 && now_ns() >= deadline) {
+            return view->scan_next < view->playlist_count;
+        }
+    }
+    return false;
+}
+
+void playlist_view_set_query(PlaylistView *view, const char *query) {
+    if (!view || !query) return;
+
+    char folded[PLAYLIST_VIEW_QUERY_MAX];
+    int length = 0;
+    for (; query[length] && length < PLAYLIST_VIEW_QUERY_MAX - 1; length++) {
+        folded[length] = (char)tolower((unsigned char)query[length]);
+    }
+    folded[length] = '\0';
+    if (length == view->query_length && memcmp(folded, view->query, (size_t)length) == 0) return;
+
+    if (length == 0) {
+        // back to the whole playlist, still on the entry that was selected
+        int selected = playlist_view_index_at(view, view->cursor);
+        clear_query(view);
+        if (selected >= 0) playlist_view_jump(view, selected);
+        return;
+    }
+
+    // every match of the longer query is among the matches of its prefix
+    bool narrows = view->filtering && length > view->query_length &&
+                   memcmp(folded, view->query, (size_t)view->query_length) == 0;
+    memcpy(view->query, folded, (size_t)length + 1);
+    view->query_length = length;
+
+    if (!ensure_capacity(view)) {
+        clear_query(view);
+        return;
+    }
+    if (narrows) {
+        int pending = view->narrow_end - view->narrow_next;
+        memmove(view->matches + view->match_count, view->matches + view->narrow_next, (size_t)pending * sizeof(int));
+        view->narrow_next = 0;
+        view->narrow_end = view->match_count + pending;
+        view->match_count = 0;
+    } else {
+        restart_scan(view);
+    }
+    view->filtering = true;
+    view->cursor = 0;
+    view->top = 0;
+}
+
+const char *playlist_view_query(PlaylistView *view) {
+    return view ? view->query : "";
+}
+
+bool playlist_view_scanning(PlaylistView *view) {
+    return view && view->filtering &&
+           (view->narrow_next < view->narrow_end || view->scan_next < view->playlist_count);
+}
+
+float playlist_view_scan_progress(PlaylistView *view) {
+    if (!playlist_view_scanning(view) || view->playlist_count == 0) return 1.0f;
+
+    float scanned = (float)view->scan_next / (float)view->playlist_count;
+    if (view->narrow_next < view->narrow_end) scanned *= (float)view->narrow_next / (float)view->narrow_end;
+    return scanned;
+}
+
+int playlist_view_count(PlaylistView *view) {
+    if (!view) return 0;
+    return view->filtering ? view->match_count : view->playlist_count;
+}
+
+int playlist_view_top(PlaylistView *view) {
+    return view ? view->top : 0;
+}
+
+int playlist_view_cursor(PlaylistView *view) {
+    return view ? view->cursor : 0;
+}
+
+int playlist_view_index_at(PlaylistView *view, int position) {
+    if (!view || position < 0 || position >= playlist_view_count(view)) return -1;
+    return view->filtering ? view->matches[position] : position;
+}
+
+void playlist_view_move(PlaylistView *view, int delta) {
+    if (!view) return;
+
+    long long cursor = (long long)view->cursor + delta;
+    if (cursor < 0) cursor = 0;
+    if (cursor > view->playlist_count) cursor = view->playlist_count;
+    view->cursor = (int)cursor;
+    keep_visible(view);
+}
+
+void playlist_view_jump(PlaylistView *view, int index) {
+    if (!view || index < 0 || index >= view->playlist_count) return;
+
+    clear_query(view);
+    view->cursor = index;
+    view->top = index - view->rows / 2;
+    keep_visible(view);
+}
@@ -0,0 +1,270 @@
+#define _GNU_SOURCE     // readahead
+#include "core/prefetch.h"
+#include "core/trace.h"
+#include "core/log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+struct Prefetcher {
+    pthread_t thread;
+    bool thread_started;
+
+    // guards everything below that is not atomic
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    bool quit;
+    char *queue[PREFETCH_MAX_TRACKS];
+    int queue_count;
+    int queue_next;             // first entry the thread has not taken yet
+    bool busy;                  // the thread is reading queue[queue_next - 1]
+    size_t budget;
+    size_t budget_left;         // of the current queue
+
+    atomic_uint generation;     // bumped by every new queue; checked between chunks
+
+    atomic_uint_least64_t scheduled;
+    atomic_uint_least64_t warmed;
+    atomic_uint_least64_t cancelled;
+    atomic_uint_least64_t bytes;
+    atomic_uint_least64_t hits;
+    atomic_uint_least64_t misses;
+};
+
+// reads the first limit bytes ahead, stopping early once the queue is replaced; false
+// if the file cannot be read
+static bool warm_file(Prefetcher *prefetcher, const char *path, size_t limit, unsigned generation,
+                      size_t *used) {
+    TRACE_SCOPE("prefetch_file");
+    *used = 0;
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return false;
+    }
+    if ((uint64_t)st.st_size < limit) limit = (size_t)st.st_size;
+
+    // readahead(2) is refused by some filesystems; fadvise asks the same of the rest
+    bool fadvise = false;
+    size_t offset = 0;
+    while (offset < limit && atomic_load_explicit(&prefetcher->generation, memory_order_relaxed) == generation) {
+        size_t chunk = limit - offset < PREFETCH_CHUNK_BYTES ? limit - offset : PREFETCH_CHUNK_BYTES;
+        if (fadvise || readahead(fd, (off64_t)offset, chunk) != 0) {
+            fadvise = true;
+            posix_fadvise(fd, (off_t)offset, (off_t)chunk, POSIX_FADV_WILLNEED);
+        }
+        offset += chunk;
+        atomic_fetch_add_explicit(&prefetcher->bytes, chunk, memory_order_relaxed);
+    }
+    close(fd);
+    *used = offset;
+    return true;
+}
+
+static void *prefetch_thread_main(void *arg) {
+    Prefetcher *prefetcher = arg;
+    TRACE_THREAD_NAME("prefetch");
+
+    pthread_mutex_lock(&prefetcher->lock);
+    for (;;) {
+        while (!prefetcher->quit && prefetcher->queue_next >= prefetcher->queue_count) {
+            pthread_cond_wait(&prefetcher->wake, &prefetcher->lock);
+        }
+        if (prefetcher->quit) break;
+
+        char *path = strdup(prefetcher->queue[prefetcher->queue_next++]);
+        unsigned generation = atomic_load(&prefetcher->generation);
+        size_t limit = prefetcher->budget_left;
+        prefetcher->busy = true;
+        pthread_mutex_unlock(&prefetcher->lock);
+
+        size_t used = 0;
+        bool read = path && warm_file(prefetcher, path, limit, generation, &used);
+        free(path);
+
+        pthread_mutex_lock(&prefetcher->lock);
+        prefetcher->busy = false;
+        if (atomic_load(&prefetcher->generation) != generation) continue;
+
+        if (read) atomic_fetch_add(&prefetcher->warmed, 1);
+        prefetcher->budget_left -= used < prefetcher->budget_left ? used : prefetcher->budget_left;
+        // later entries would only push the nearer ones out of the cache again
+        if (prefetcher->budget_left == 0) prefetcher->queue_next = prefetcher->queue_count;
+    }
+    pthread_mutex_unlock(&prefetcher->lock);
+    return NULL;
+}
+
+static bool queue_contains(char *const *queue, int count, const char *path) {
+    for (int i = 0; i < count; i++) {
+        if (strcmp(queue[i], path) == 0) return true;
+    }
+    return false;
+}
+
+// caller holds the lock; unfinished entries absent from the next queue count as cancelled
+static void drop_queue(Prefetcher *prefetcher, const char *const *next, int next_count) {
+    int first = prefetcher->busy ? prefetcher->queue_next - 1 : prefetcher->queue_next;
+    for (int i = first; i < prefetcher->queue_count; i++) {
+        if (!queue_contains((char *const *)next, next_count, prefetcher->queue[i])) {
+            atomic_fetch_add(&prefetcher->cancelled, 1);
+        }
+    }
+    for (int i = 0; i < prefetcher->queue_count; i++) {
+        free(prefetcher->queue[i]);
+    }
+    prefetcher->queue_count = 0;
+    prefetcher->queue_next = 0;
+    atomic_fetch_add(&prefetcher->generation, 1);
+}
+
+Prefetcher* prefetch_create(size_t budget_bytes) {
+    Prefetcher *prefetcher = calloc(1, sizeof(Prefetcher));
+    if (!prefetcher) return NULL;
+
+    pthread_mutex_init(&prefetcher->lock, NULL);
+    pthread_cond_init(&prefetcher->wake, NULL);
+    prefetcher->budget = budget_bytes;
+    return prefetcher;
+}
+
+void prefetch_destroy(Prefetcher *prefetcher) {
+    if (!prefetcher) return;
+
+    pthread_mutex_lock(&prefetcher->lock);
+    prefetcher->quit = true;
+    drop_queue(prefetcher, NULL, 0);
+    pthread_cond_signal(&prefetcher->wake);
+    pthread_mutex_unlock(&prefetcher->lock);
+
+    if (prefetcher->thread_started) {
+        pthread_join(prefetcher->thread, NULL);
+    }
+    pthread_cond_destroy(&prefetcher->wake);
+    pthread_mutex_destroy(&prefetcher->lock);
+    free(prefetcher);
+}
+
+void prefetch_set_budget(Prefetcher *prefetcher, size_t budget_bytes) {
+    if (!prefetcher) return;
+    pthread_mutex_lock(&prefetcher->lock);
+    prefetcher->budget = budget_bytes;
+    pthread_mutex_unlock(&prefetcher->lock);
+}
+
+int prefetch_schedule(Prefetcher *prefetcher, const char *const *paths, int count) {
+    if (!prefetcher || (count > 0 && !paths)) return -1;
+    if (count > PREFETCH_MAX_TRACKS) count = PREFETCH_MAX_TRACKS;
+
+    pthread_mutex_lock(&prefetcher->lock);
+    bool same = count == prefetcher->queue_count;
+    for (int i = 0; same && i < count; i++) {
+        same = strcmp(paths[i], prefetcher->queue[i]) == 0;
+    }
+    if (same) {
+        pthread_mutex_unlock(&prefetcher->lock);
+        return 0;
+    }
+
+    drop_queue(prefetcher, paths, count);
+    int result = 0;
+    for (int i = 0; i < count; i++) {
+        prefetcher->queue[i] = strdup(paths[i]);
+        if (!prefetcher->queue[i]) {
+            result = -1;
+            break;
+        }
+        prefetcher->queue_count++;
+    }
+    atomic_fetch_add(&prefetcher->scheduled, (uint64_t)prefetcher->queue_count);
+    prefetcher->budget_left = prefetcher->budget;
+
+    if (!prefetcher->thread_started && prefetcher->queue_count > 0) {
+        int err = pthread_create(&prefetcher->thread, NULL, prefetch_thread_main, prefetcher);
+        if (err == 0) {
+            prefetcher->thread_started = true;
+        } else {
+            LOG_ERROR("Failed to start prefetch thread: %s", strerror(err));
+            result = -1;
+        }
+    }
+    pthread_cond_signal(&prefetcher->wake);
+    pthread_mutex_unlock(&prefetcher->lock);
+    return result;
+}
+
+void prefetch_cancel(Prefetcher *prefetcher) {
+    if (!prefetcher) return;
+    pthread_mutex_lock(&prefetcher->lock);
+    drop_queue(prefetcher, NULL, 0);
+    pthread_mutex_unlock(&prefetcher->lock);
+}
+
+bool prefetch_note_start(Prefetcher *prefetcher, const char *path) {
+    if (!prefetcher || !path) return false;
+    TRACE_SCOPE("prefetch_check");
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return false;
+    }
+
+    pthread_mutex_lock(&prefetcher->lock);
+    size_t length = prefetcher->budget;
+    pthread_mutex_unlock(&prefetcher->lock);
+    if ((uint64_t)st.st_size < length) length = (size_t)st.st_size;
+
+    // mapping without touching faults nothing in; mincore only reports what is there
+    bool resident = true;
+    if (length > 0) {
+        size_t page = (size_t)sysconf(_SC_PAGESIZE);
+        size_t pages = (length + page - 1) / page;
+        unsigned char *vector = malloc(pages);
+        void *map = mmap(NULL, length, PROT_READ, MAP_SHARED, fd, 0);
+        if (!vector || map == MAP_FAILED || mincore(map, length, vector) != 0) {
+            resident = false;
+        }
+        for (size_t i = 0; resident && i < pages; i++) {
+            resident = vector[i] & 1;
+        }
+        if (map != MAP_FAILED) munmap(map, length);
+        free(vector);
+    }
+    close(fd);
+
+    atomic_fetch_add(resident ? &prefetcher->hits : &prefetcher->misses, 1);
+    return resident;
+}
+
+void prefetch_get_stats(Prefetcher *prefetcher, PrefetchStats *stats) {
+    if (!stats) return;
+    memset(stats, 0, sizeof(*stats));
+    if (!prefetcher) return;
+
+    stats->scheduled = atomic_load(&prefetcher->scheduled);
+    stats->warmed = atomic_load(&prefetcher->warmed);
+    stats->cancelled = atomic_load(&prefetcher->cancelled);
+    stats->bytes = atomic_load(&prefetcher->bytes);
+    stats->hits = atomic_load(&prefetcher->hits);
+    stats->misses = atomic_load(&prefetcher->misses);
+}
+
+bool prefetch_is_idle(Prefetcher *prefetcher) {
+    if (!prefetcher) return true;
+    pthread_mutex_lock(&prefetcher->lock);
+    bool idle = !prefetcher->busy && prefetcher->queue_next >= prefetcher->queue_count;
+    pthread_mutex_unlock(&prefetcher->lock);
+    return idle;
+}
@@ -0,0 +1,619 @@
+#define _GNU_SOURCE     // sched_setaffinity, SCHED_RESET_ON_FORK, MADV_POPULATE_WRITE
+#include "core/realtime.h"
+#include "core/log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sched.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+#define REALTIME_NICE -11               // what PulseAudio and PipeWire ask for
+#define RTKIT_MAX_PRIORITY 20           // rtkit's default MaxRealtimePriority
+#define RTKIT_RTTIME_USEC 200000        // rtkit only serves processes with RLIMIT_RTTIME at most this
+#define DBUS_SYSTEM_SOCKET "/var/run/dbus/system_bus_socket"
+#define DBUS_MESSAGE_MAX 4096
+#define DBUS_REPLY_SERIAL 5
+#define DBUS_METHOD_RETURN 2
+
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define DBUS_ENDIAN 'B'
+#else
+#define DBUS_ENDIAN 'l'
+#endif
+
+typedef enum {
+    SLOT_FREE,
+    SLOT_CLAIMED,
+    SLOT_READY
+} SlotState;
+
+typedef struct {
+    atomic_int state;
+    pid_t tid;
+    RealtimeRole role;
+    // the rest only under realtime_lock
+    bool applied;
+    bool external;              // already real-time when found (JACK's thread): left as it is
+    RealtimeMethod method;
+    int priority;
+    bool pinned;
+} ThreadSlot;
+
+typedef struct {
+    void *data;
+    size_t size;
+    bool locked;
+    bool prefaulted;
+} BufferEntry;
+
+static pthread_mutex_t realtime_lock = PTHREAD_MUTEX_INITIALIZER;
+static ThreadSlot threads[REALTIME_MAX_THREADS];
+static BufferEntry buffers[REALTIME_MAX_BUFFERS];
+static int buffer_count;
+static RealtimeConfig active;
+static bool memory_locked;
+static cpu_set_t process_cpus;          // affinity before any pinning, restored on disable
+static bool process_cpus_saved;
+
+static _Thread_local bool thread_registered;
+
+void realtime_config_defaults(RealtimeConfig *config) {
+    if (!config) return;
+
+    memset(config, 0, sizeof(*config));
+    config->priority[REALTIME_ROLE_AUDIO] = 70;
+    config->priority[REALTIME_ROLE_DECODER] = 60;
+    config->lock_memory = true;
+}
+
+void realtime_config_from_env(RealtimeConfig *config) {
+    if (!config) return;
+
+    const char *enabled = getenv("RHYTHM_REALTIME");
+    config->enabled = enabled && *enabled && strcmp(enabled, "0") != 0;
+
+    const char *priority = getenv("RHYTHM_RT_PRIORITY");
+    if (priority && *priority) {
+        int value = atoi(priority);
+        if (value >= 1 && value <= 99) {
+            config->priority[REALTIME_ROLE_AUDIO] = value;
+            config->priority[REALTIME_ROLE_DECODER] = value > 10 ? value - 10 : 1;
+        } else {
+            LOG_WARN("Ignoring RHYTHM_RT_PRIORITY=%s (1-99)", priority);
+        }
+    }
+
+    static const char *CPU_VARIABLES[REALTIME_ROLES] = { "RHYTHM_RT_AUDIO_CPUS", "RHYTHM_RT_DECODER_CPUS" };
+    for (int role = 0; role < REALTIME_ROLES; role++) {
+        const char *cpus = getenv(CPU_VARIABLES[role]);
+        if (cpus && *cpus && realtime_parse_cpus(cpus, &config->cpus[role]) != 0) {
+            LOG_WARN("Ignoring %s=%s", CPU_VARIABLES[role], cpus);
+            config->cpus[role] = 0;
+        }
+    }
+
+    const char *no_mlock = getenv("RHYTHM_RT_NO_MLOCK");
+    if (no_mlock && *no_mlock && strcmp(no_mlock, "0") != 0) config->lock_memory = false;
+}
+
+int realtime_parse_cpus(const char *list, uint64_t *mask) {
+    if (!list || !mask) return -1;
+
+    uint64_t result = 0;
+    const char *p = list;
+    while (*p) {
+        char *end;
+        long first = strtol(p, &end, 10);
+        if (end == p || first < 0 || first > 63) return -1;
+        long last = first;
+        p = end;
+        if (*p == '-') {
+            last = strtol(p + 1, &end, 10);
+            if (end == p + 1 || last < first || last > 63) return -1;
+            p = end;
+        }
+        for (long cpu = first; cpu <= last; cpu++) result |= 1ULL << cpu;
+
+        if (*p == ',') {
+            p++;
+        } else if (*p) {
+            return -1;
+        }
+    }
+    if (!result) return -1;
+
+    *mask = result;
+    return 0;
+}
+
+const char *realtime_method_name(RealtimeMethod method) {
+    switch (method) {
+        case REALTIME_METHOD_FIFO:
+            return "SCHED_FIFO";
+        case REALTIME_METHOD_RTKIT:
+            return "rtkit";
+        case REALTIME_METHOD_NICE:
+            return "nice";
+        default:
+            return "none";
+    }
+}
+
+// -- just enough of the D-Bus wire protocol to make one call to rtkit
+
+typedef struct {
+    uint8_t data[DBUS_MESSAGE_MAX];
+    size_t length;
+} DbusMessage;
+
+static void dbus_align(DbusMessage *message, size_t alignment) {
+    while (message->length % alignment) message->data[message->length++] = 0;
+}
+
+static void dbus_put(DbusMessage *message, const void *data, size_t size) {
+    memcpy(message->data + message->length, data, size);
+    message->length += size;
+}
+
+static void dbus_put_u32(DbusMessage *message, uint32_t value) {
+    dbus_align(message, 4);
+    dbus_put(message, &value, 4);
+}
+
+static void dbus_put_string(DbusMessage *message, const char *value) {
+    uint32_t length = (uint32_t)strlen(value);
+    dbus_put_u32(message, length);
+    dbus_put(message, value, length + 1);
+}
+
+static void dbus_put_signature(DbusMessage *message, const char *value) {
+    uint8_t length = (uint8_t)strlen(value);
+    dbus_put(message, &length, 1);
+    dbus_put(message, value, (size_t)length + 1);
+}
+
+// one header field: its code, then a variant of the given type
+static void dbus_put_field(DbusMessage *message, uint8_t code, const char *type, const char *value) {
+    dbus_align(message, 8);
+    dbus_put(message, &code, 1);
+    dbus_put_signature(message, type);
+    if (type[0] == 'g') {
+        dbus_put_signature(message, value);
+    } else {
+        dbus_put_string(message, value);
+    }
+}
+
+static void dbus_build_call(DbusMessage *message, uint32_t serial, const char *destination, const char *path,
+                            const char *interface, const char *member, const char *signature,
+                            const void *body, uint32_t body_size) {
+    message->length = 0;
+    uint8_t fixed[4] = { DBUS_ENDIAN, 1, 0, 1 };    // method call, no flags, protocol 1
+    dbus_put(message, fixed, sizeof(fixed));
+    dbus_put_u32(message, body_size);
+    dbus_put_u32(message, serial);
+
+    size_t fields_at = message->length;
+    dbus_put_u32(message, 0);
+    dbus_put_field(message, 1, "o", path);
+    dbus_put_field(message, 2, "s", interface);
+    dbus_put_field(message, 3, "s", member);
+    dbus_put_field(message, 6, "s", destination);
+    if (signature) dbus_put_field(message, 8, "g", signature);
+
+    uint32_t fields_size = (uint32_t)(message->length - fields_at - 4);
+    memcpy(message->data + fields_at, &fields_size, 4);
+    dbus_align(message, 8);
+    if (body_size > 0) dbus_put(message, body, body_size);
+}
+
+static bool write_full(int fd, const void *data, size_t size) {
+    const char *p = data;
+    while (size > 0) {
+        ssize_t written = send(fd, p, size, MSG_NOSIGNAL);
+        if (written <= 0) return false;
+        p += written;
+        size -= (size_t)written;
+    }
+    return true;
+}
+
+static bool read_full(int fd, void *data, size_t size) {
+    char *p = data;
+    while (size > 0) {
+        ssize_t received = recv(fd, p, size, 0);
+        if (received <= 0) return false;
+        p += received;
+        size -= (size_t)received;
+    }
+    return true;
+}
+
+static bool read_line(int fd, char *line, size_t size) {
+    size_t length = 0;
+    while (length + 1 < size) {
+        if (recv(fd, line + length, 1, 0) != 1) return false;
+        if (line[length++] == '\n') break;
+    }
+    line[length] = '\0';
+    return true;
+}
+
+// the reply serial from a received message's header fields, 0 if it has none
+static uint32_t dbus_reply_serial(const uint8_t *message, size_t end) {
+    size_t pos = 16;
+    while (pos < end) {
+        pos = (pos + 7) & ~(size_t)7;
+        if (pos + 3 > end) break;
+        uint8_t code = message[pos];
+        char type = (char)message[pos + 2];
+        pos += 3 + (size_t)message[pos + 1];    // code, signature length, signature, NUL
+
+        if (type == 'u') {
+            pos = (pos + 3) & ~(size_t)3;
+            if (pos + 4 > end) break;
+            uint32_t value;
+            memcpy(&value, message + pos, 4);
+            if (code == DBUS_REPLY_SERIAL) return value;
+            pos += 4;
+        } else if (type == 's' || type == 'o') {
+            pos = (pos + 3) & ~(size_t)3;
+            if (pos + 4 > end) break;
+            uint32_t length;
+            memcpy(&length, message + pos, 4);
+            pos += 4 + (size_t)length + 1;
+        } else if (type == 'g') {
+            if (pos >= end) break;
+            pos += 1 + (size_t)message[pos] + 1;
+        } else {
+            break;
+        }
+    }
+    return 0;
+}
+
+// 0 once the reply to serial is a method return; the bus sends Hello's reply and a
+// NameAcquired signal first
+static int dbus_wait_reply(int fd, uint32_t serial) {
+    uint8_t message[DBUS_MESSAGE_MAX];
+    for (int i = 0; i < 16; i++) {
+        if (!read_full(fd, message, 16) || message[0] != DBUS_ENDIAN) return -1;
+
+        uint32_t body_size, fields_size;
+        memcpy(&body_size, message + 4, 4);
+        memcpy(&fields_size, message + 12, 4);
+        size_t total = ((16 + (size_t)fields_size + 7) & ~(size_t)7) + body_size;
+        if (total > sizeof(message) || !read_full(fd, message + 16, total - 16)) return -1;
+
+        if (dbus_reply_serial(message, 16 + fields_size) == serial) {
+            return message[1] == DBUS_METHOD_RETURN ? 0 : -1;
+        }
+    }
+    return -1;
+}
+
+static int dbus_connect_system(void) {
+    const char *path = DBUS_SYSTEM_SOCKET;
+    const char *address = getenv("DBUS_SYSTEM_BUS_ADDRESS");
+    if (address && strncmp(address, "unix:path=", 10) == 0) path = address + 10;
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%.*s", (int)strcspn(path, ","), path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    // a wedged bus costs a second, not a hang
+    struct timeval timeout = { 1, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    // SASL EXTERNAL: the bus checks the uid against the socket's peer credentials
+    char uid[16], hex[40], auth[64], reply[128];
+    snprintf(uid, sizeof(uid), "%u", (unsigned int)getuid());
+    for (size_t i = 0; uid[i]; i++) snprintf(hex + 2 * i, 3, "%02x", (unsigned char)uid[i]);
+    int length = snprintf(auth, sizeof(auth), "%cAUTH EXTERNAL %s\r\n", '\0', hex);
+
+    if (!write_full(fd, auth, (size_t)length) || !read_line(fd, reply, sizeof(reply)) ||
+        strncmp(reply, "OK ", 3) != 0 || !write_full(fd, "BEGIN\r\n", 7)) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static int rtkit_call(const char *member, const char *signature, const void *body, uint32_t body_size) {
+    int fd = dbus_connect_system();
+    if (fd < 0) return -1;
+
+    DbusMessage message;
+    dbus_build_call(&message, 1, "org.freedesktop.DBus", "/org/freedesktop/DBus", "org.freedesktop.DBus",
+                    "Hello", NULL, NULL, 0);
+    bool ok = write_full(fd, message.data, message.length);
+    dbus_build_call(&message, 2, "org.freedesktop.RealtimeKit1", "/org/freedesktop/RealtimeKit1",
+                    "org.freedesktop.RealtimeKit1", member, signature, body, body_size);
+    ok = ok && write_full(fd, message.data, message.length) && dbus_wait_reply(fd, 2) == 0;
+    close(fd);
+    return ok ? 0 : -1;
+}
+
+static int rtkit_make_realtime(pid_t tid, int priority) {
+    // rtkit refuses processes that could hog a CPU forever. The lowered hard limit is
+    // permanent; a SCHED_FIFO thread that runs this long without blocking gets SIGXCPU.
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_RTTIME, &limit) == 0 &&
+        (limit.rlim_max == RLIM_INFINITY || limit.rlim_max > RTKIT_RTTIME_USEC)) {
+        limit.rlim_cur = RTKIT_RTTIME_USEC;
+        limit.rlim_max = RTKIT_RTTIME_USEC;
+        setrlimit(RLIMIT_RTTIME, &limit);
+    }
+
+    uint8_t body[12];
+    uint64_t thread = (uint64_t)tid;
+    uint32_t value = (uint32_t)priority;
+    memcpy(body, &thread, 8);
+    memcpy(body + 8, &value, 4);
+    return rtkit_call("MakeThreadRealtime", "tu", body, sizeof(body));
+}
+
+static int rtkit_make_high_priority(pid_t tid, int nice_level) {
+    uint8_t body[12];
+    uint64_t thread = (uint64_t)tid;
+    int32_t value = nice_level;
+    memcpy(body, &thread, 8);
+    memcpy(body + 8, &value, 4);
+    return rtkit_call("MakeThreadHighPriority", "ti", body, sizeof(body));
+}
+
+// -- threads and buffers, under realtime_lock
+
+static bool thread_alive(pid_t tid) {
+    return syscall(SYS_tgkill, getpid(), tid, 0) == 0 || errno != ESRCH;
+}
+
+static void promote_thread(ThreadSlot *slot) {
+    int priority = active.priority[slot->role];
+    struct sched_param param = { .sched_priority = priority };
+
+    slot->method = REALTIME_METHOD_NONE;
+    slot->priority = 0;
+    slot->external = false;
+    int policy = sched_getscheduler(slot->tid);
+    if (policy >= 0 && ((policy & ~SCHED_RESET_ON_FORK) == SCHED_FIFO || (policy & ~SCHED_RESET_ON_FORK) == SCHED_RR)) {
+        struct sched_param current;
+        slot->external = true;
+        slot->method = REALTIME_METHOD_FIFO;
+        slot->priority = sched_getparam(slot->tid, &current) == 0 ? current.sched_priority : 0;
+    } else if (sched_setscheduler(slot->tid, SCHED_FIFO | SCHED_RESET_ON_FORK, &param) == 0) {
+        slot->method = REALTIME_METHOD_FIFO;
+        slot->priority = priority;
+    } else {
+        int capped = priority < RTKIT_MAX_PRIORITY ? priority : RTKIT_MAX_PRIORITY;
+        if (rtkit_make_realtime(slot->tid, capped) == 0) {
+            slot->method = REALTIME_METHOD_RTKIT;
+            slot->priority = capped;
+        } else if (setpriority(PRIO_PROCESS, (id_t)slot->tid, REALTIME_NICE) == 0 ||
+                   rtkit_make_high_priority(slot->tid, REALTIME_NICE) == 0) {
+            slot->method = REALTIME_METHOD_NICE;
+        }
+    }
+
+    slot->pinned = false;
+    uint64_t mask = active.cpus[slot->role];
+    if (mask) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu = 0; cpu < 64; cpu++) {
+            if (mask & (1ULL << cpu)) CPU_SET(cpu, &set);
+        }
+        slot->pinned = sched_setaffinity(slot->tid, sizeof(set), &set) == 0;
+    }
+    slot->applied = true;
+}
+
+static void demote_thread(ThreadSlot *slot) {
+    if (!slot->external && (slot->method == REALTIME_METHOD_FIFO || slot->method == REALTIME_METHOD_RTKIT)) {
+        struct sched_param param = { .sched_priority = 0 };
+        sched_setscheduler(slot->tid, SCHED_OTHER, &param);
+    } else if (slot->method == REALTIME_METHOD_NICE) {
+        setpriority(PRIO_PROCESS, (id_t)slot->tid, 0);
+    }
+    if (slot->pinned && process_cpus_saved) sched_setaffinity(slot->tid, sizeof(process_cpus), &process_cpus);
+
+    slot->applied = false;
+    slot->external = false;
+    slot->method = REALTIME_METHOD_NONE;
+    slot->priority = 0;
+    slot->pinned = false;
+}
+
+// populates the pages without writing them, so a ring already in use is left as it is
+static bool prefault_buffer(void *data, size_t size) {
+#ifdef MADV_POPULATE_WRITE
+    uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+    uintptr_t start = (uintptr_t)data & ~(page - 1);
+    uintptr_t end = ((uintptr_t)data + size + page - 1) & ~(page - 1);
+    return madvise((void *)start, end - start, MADV_POPULATE_WRITE) == 0;
+#else
+    (void)data;
+    (void)size;
+    return false;
+#endif
+}
+
+static void lock_buffer(BufferEntry *entry) {
+    if (memory_locked) return;
+
+    entry->locked = mlock(entry->data, entry->size) == 0;
+    if (!entry->locked) entry->prefaulted = prefault_buffer(entry->data, entry->size);
+}
+
+static void unlock_buffer(BufferEntry *entry) {
+    if (entry->locked) munlock(entry->data, entry->size);
+    entry->locked = false;
+    entry->prefaulted = false;
+}
+
+static void disable_locked(void) {
+    for (int i = 0; i < REALTIME_MAX_THREADS; i++) {
+        ThreadSlot *slot = &threads[i];
+        if (atomic_load_explicit(&slot->state, memory_order_acquire) == SLOT_READY && slot->applied) {
+            demote_thread(slot);
+        }
+    }
+    for (int i = 0; i < buffer_count; i++) unlock_buffer(&buffers[i]);
+    if (memory_locked) munlockall();
+
+    memory_locked = false;
+    active.enabled = false;
+}
+
+// under a finite memlock limit MCL_FUTURE would make allocations fail once the limit is
+// reached, so mlockall is only tried when nothing limits it
+static bool memlock_unlimited(void) {
+    struct rlimit limit;
+    return geteuid() == 0 || (getrlimit(RLIMIT_MEMLOCK, &limit) == 0 && limit.rlim_cur == RLIM_INFINITY);
+}
+
+int realtime_enable(const RealtimeConfig *config) {
+    if (!config) return -1;
+    if (!config->enabled) {
+        realtime_disable();
+        return 0;
+    }
+    for (int role = 0; role < REALTIME_ROLES; role++) {
+        if (config->priority[role] < 1 || config->priority[role] > 99) return -1;
+    }
+
+    pthread_mutex_lock(&realtime_lock);
+    if (active.enabled) disable_locked();
+    active = *config;
+
+    if (!process_cpus_saved) {
+        process_cpus_saved = sched_getaffinity(0, sizeof(process_cpus), &process_cpus) == 0;
+    }
+    if (config->lock_memory) {
+        memory_locked = memlock_unlimited() && mlockall(MCL_CURRENT | MCL_FUTURE) == 0;
+        for (int i = 0; i < buffer_count; i++) lock_buffer(&buffers[i]);
+    }
+    pthread_mutex_unlock(&realtime_lock);
+
+    realtime_apply();
+    return 0;
+}
+
+void realtime_disable(void) {
+    pthread_mutex_lock(&realtime_lock);
+    if (active.enabled) disable_locked();
+    pthread_mutex_unlock(&realtime_lock);
+}
+
+void realtime_register_thread(RealtimeRole role) {
+    if (thread_registered) return;
+    // set even when the table is full, so a full table is not searched every period
+    thread_registered = true;
+
+    pid_t tid = (pid_t)syscall(SYS_gettid);
+    for (int i = 0; i < REALTIME_MAX_THREADS; i++) {
+        int expected = SLOT_FREE;
+        if (atomic_compare_exchange_strong_explicit(&threads[i].state, &expected, SLOT_CLAIMED,
+                                                    memory_order_acquire, memory_order_relaxed)) {
+            threads[i].tid = tid;
+            threads[i].role = role;
+            atomic_store_explicit(&threads[i].state, SLOT_READY, memory_order_release);
+            return;
+        }
+    }
+}
+
+void realtime_apply(void) {
+    pthread_mutex_lock(&realtime_lock);
+    for (int i = 0; i < REALTIME_MAX_THREADS; i++) {
+        ThreadSlot *slot = &threads[i];
+        if (atomic_load_explicit(&slot->state, memory_order_acquire) != SLOT_READY) continue;
+
+        if (!thread_alive(slot->tid)) {
+            slot->applied = false;
+            slot->external = false;
+            slot->method = REALTIME_METHOD_NONE;
+            slot->priority = 0;
+            slot->pinned = false;
+            atomic_store_explicit(&slot->state, SLOT_FREE, memory_order_release);
+            continue;
+        }
+        if (active.enabled && !slot->applied) promote_thread(slot);
+    }
+    pthread_mutex_unlock(&realtime_lock);
+}
+
+void realtime_register_buffer(void *data, size_t size) {
+    if (!data || size == 0) return;
+
+    pthread_mutex_lock(&realtime_lock);
+    if (buffer_count < REALTIME_MAX_BUFFERS) {
+        BufferEntry *entry = &buffers[buffer_count++];
+        entry->data = data;
+        entry->size = size;
+        entry->locked = false;
+        entry->prefaulted = false;
+        if (active.enabled && active.lock_memory) lock_buffer(entry);
+    }
+    pthread_mutex_unlock(&realtime_lock);
+}
+
+void realtime_unregister_buffer(void *data) {
+    if (!data) return;
+
+    pthread_mutex_lock(&realtime_lock);
+    for (int i = 0; i < buffer_count; i++) {
+        if (buffers[i].data == data) {
+            unlock_buffer(&buffers[i]);
+            buffers[i] = buffers[--buffer_count];
+            break;
+        }
+    }
+    pthread_mutex_unlock(&realtime_lock);
+}
+
+void realtime_get_status(RealtimeStatus *status) {
+    if (!status) return;
+
+    memset(status, 0, sizeof(*status));
+    pthread_mutex_lock(&realtime_lock);
+    status->enabled = active.enabled;
+    for (int i = 0; i < REALTIME_MAX_THREADS; i++) {
+        ThreadSlot *slot = &threads[i];
+        if (atomic_load_explicit(&slot->state, memory_order_acquire) != SLOT_READY) continue;
+
+        RealtimeRoleStatus *role = &status->roles[slot->role];
+        RealtimeMethod method = slot->applied ? slot->method : REALTIME_METHOD_NONE;
+        role->threads++;
+        if (method != REALTIME_METHOD_NONE) role->promoted++;
+        if (role->threads == 1 || method < role->method) role->method = method;
+        if (slot->priority > 0 && (role->priority == 0 || slot->priority < role->priority)) {
+            role->priority = slot->priority;
+        }
+        if (slot->pinned) role->pinned++;
+    }
+
+    status->memory_locked = memory_locked;
+    for (int i = 0; i < buffer_count; i++) {
+        if (buffers[i].locked) status->buffers_locked += buffers[i].size;
+        if (buffers[i].prefaulted) status->buffers_prefaulted += buffers[i].size;
+    }
+    pthread_mutex_unlock(&realtime_lock);
+}
@@ -1,6 +1,13 @@
 #include "core/rhythm_engine.h"
+#include "core/trace.h"
+#include "core/loudness_scan.h"
+#include "core/session.h"
 #include <sys/stat.h>
+#include <strings.h>
 #include <libgen.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
 
 struct RhythmEngine {
     AudioPlayer* audio_player;
@@ -8,8 +15,84 @@ struct RhythmEngine {
     RhythmStatus current_status;
     RhythmError last_error;
     bool status_dirty;  
+    unsigned long xrun_baseline;
+
+    LoudnessCache* loudness_cache;
+    LoudnessScan* loudness_scan;
+    bool auto_gain;
+    float target_lufs;
+    bool track_measured;
+    LoudnessResult track_loudness;
+    float applied_gain_db;
+    int scan_results_seen;
+
+    Waveform* waveform;
+    SearchIndex* search_index;      // follows the playlist, entries added as they appear
+
+    char* session_path;             // saved here from rhythm_engine_update when set
+    int session_interval_ms;
+    double session_saved_at;
+    SessionState session_saved;     // what the file holds
+    bool session_playlist_saved;    // the file already holds this playlist and order
+    int resume_index;               // a restored position waits for the first play of this track
+    long long resume_frame;
+
+    RhythmPowerMode power_mode;
+    bool interactive;               // some front-end is being used; auto mode saves power without one
+
+    Prefetcher* prefetch;           // warms the page cache with the next tracks in play order
+    int prefetch_tracks;
+    bool start_pending;             // the last start's first-sample time is not counted yet
+    bool start_cached;
+    double first_sample_ms[2];      // totals over starts that missed / hit the page cache
+    int first_sample_starts[2];
 };
 
+#define EQ_PREAMP_STAGE 0
+#define EQ_MAX_GAIN_DB 24.0f
+
+static const float EQ_FREQUENCIES[RHYTHM_EQ_BANDS] = {
+    31.0f, 62.0f, 125.0f, 250.0f, 500.0f, 1000.0f, 2000.0f, 4000.0f, 8000.0f, 16000.0f
+};
+
+// preamp first, then the bands; flat stages are skipped by the chain so a neutral EQ costs nothing
+static void setup_equalizer(DspChain* dsp) {
+    DspStageParams preamp = { DSP_STAGE_PREAMP, 0.0f, 0.0f, 0.0f, true };
+    dsp_chain_add_stage(dsp, &preamp);
+
+    for (int i = 0; i < RHYTHM_EQ_BANDS; i++) {
+        DspStageParams band = { DSP_STAGE_PEAKING, EQ_FREQUENCIES[i], 0.0f, 1.41f, true };
+        if (i == 0) {
+            band.type = DSP_STAGE_LOW_SHELF;
+            band.q = 1.0f;
+        } else if (i == RHYTHM_EQ_BANDS - 1) {
+            band.type = DSP_STAGE_HIGH_SHELF;
+            band.q = 1.0f;
+        }
+        dsp_chain_add_stage(dsp, &band);
+    }
+}
+
+static float clamp_eq_gain(float gain_db) {
+    if (gain_db > EQ_MAX_GAIN_DB) return EQ_MAX_GAIN_DB;
+    if (gain_db < -EQ_MAX_GAIN_DB) return -EQ_MAX_GAIN_DB;
+    return gain_db;
+}
+
+static RhythmError set_eq_stage_gain(RhythmEngine* engine, int stage, float gain_db) {
+    DspChain* dsp = engine->audio_player->dsp;
+    DspStageParams params;
+    if (dsp_chain_get_stage(dsp, stage, &params) != 0) {
+        engine->last_error = RHYTHM_ERROR_INVALID_STATE;
+        return RHYTHM_ERROR_INVALID_STATE;
+    }
+
+    params.gain_db = clamp_eq_gain(gain_db);
+    dsp_chain_set_stage(dsp, stage, &params);
+    engine->last_error = RHYTHM_OK;
+    return RHYTHM_OK;
+}
+
 static bool is_directory(const char* path) {
     struct stat st;
     return (stat(path, &st) == 0 && S_ISDIR(st.st_mode));
@@ -29,49 +112,259 @@ static float calculate_progress(int current_time, int total_time) {
     return (progress > 1.0f) ? 1.0f : progress;
 }
 
-static void update_status(RhythmEngine* engine) {
-    if (!engine) return;
-
-    RhythmStatus* status = &engine->current_status;
-
-    if (status->current_file) {
-        free(status->current_file);
-        status->current_file = NULL;
-    }
-
+// everything but the file name, which the two status flavours store differently
+static void fill_status(RhythmEngine* engine, RhythmStatus* status) {
     if (engine->playlist && engine->playlist->count > 0) {
         playlist_get_info(engine->playlist, &status->current_track, &status->total_tracks);
-        const char* current_file = playlist_get_current(engine->playlist);
-        if (current_file) {
-            status->current_file = strdup(basename((char*)current_file));
-        }
     } else {
         status->current_track = 0;
         status->total_tracks = 0;
     }
+    status->shuffle = engine->playlist && playlist_is_shuffled(engine->playlist);
 
     if (engine->audio_player) {
         status->state = audio_player_get_state(engine->audio_player);
         status->volume = audio_player_get_volume(engine->audio_player);
 
         audio_player_get_vis_data(engine->audio_player, status->vis_bands, 32);
+        audio_player_get_features(engine->audio_player, &status->features);
 
         status->total_time = get_file_duration(engine->audio_player);
+        status->duration_known = audio_player_duration_known(engine->audio_player);
         status->current_time = get_current_position(engine->audio_player);
         status->progress = audio_player_get_progress(engine->audio_player);
     } else {
         status->state = PLAYER_STATE_STOPPED;
         status->volume = 0.0f;
         status->total_time = 0;
+        status->duration_known = false;
         status->current_time = 0;
         status->progress = 0.0f;
         memset(status->vis_bands, 0, sizeof(status->vis_bands));
+        memset(&status->features, 0, sizeof(status->features));
     }
+}
 
+static const char* current_file_path(RhythmEngine* engine) {
+    if (!engine->playlist || engine->playlist->count <= 0) return NULL;
+    return playlist_get_current(engine->playlist);
+}
+
+static void update_status(RhythmEngine* engine) {
+    if (!engine) return;
+
+    RhythmStatus* status = &engine->current_status;
+
+    if (status->current_file) {
+        free(status->current_file);
+        status->current_file = NULL;
+    }
+
+    const char* current_file = current_file_path(engine);
+    if (current_file) {
+        status->current_file = strdup(basename((char*)current_file));
+    }
+
+    fill_status(engine, status);
     engine->status_dirty = false;
 }
 
+// lookups don't create the cache file; only a scan does
+static LoudnessCache* open_loudness_cache(RhythmEngine* engine, bool create) {
+    if (engine->loudness_cache) return engine->loudness_cache;
+
+    char path[4096];
+    if (loudness_cache_default_path(path, sizeof(path)) != 0) return NULL;
+    if (!create && access(path, F_OK) != 0) return NULL;
+
+    engine->loudness_cache = loudness_cache_open(path);
+    return engine->loudness_cache;
+}
+
+static void apply_track_gain(RhythmEngine* engine) {
+    const char* file = engine->audio_player->current_file;
+    LoudnessCache* cache = open_loudness_cache(engine, false);
+
+    engine->track_measured = file && cache && loudness_cache_lookup(cache, file, &engine->track_loudness) == 0;
+    engine->applied_gain_db = 0.0f;
+    if (engine->track_measured && engine->auto_gain) {
+        engine->applied_gain_db = loudness_track_gain_db(&engine->track_loudness, engine->target_lufs);
+    }
+    audio_player_set_track_gain(engine->audio_player, powf(10.0f, engine->applied_gain_db / 20.0f));
+}
+
+// the overview follows the playing track; replaying the same file keeps it
+static void start_waveform(RhythmEngine* engine) {
+    const char* file = engine->audio_player->current_file;
+    if (!file) return;
+    if (stream_source_is_stream(file)) {
+        // a live stream cannot be read twice
+        waveform_destroy(engine->waveform);
+        engine->waveform = NULL;
+        return;
+    }
+    if (engine->waveform && strcmp(waveform_path(engine->waveform), file) == 0) return;
+
+    waveform_destroy(engine->waveform);
+    char cache_dir[4096];
+    bool cached = waveform_cache_default_dir(cache_dir, sizeof(cache_dir)) == 0;
+    engine->waveform = waveform_open(file, cached ? cache_dir : NULL);
+}
+
+static double monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static void get_session_state(RhythmEngine* engine, SessionState* state) {
+    memset(state, 0, sizeof(*state));
+    state->current_index = playlist_get_current_index(engine->playlist);
+    state->volume = audio_player_get_volume(engine->audio_player);
+
+    PlayerState player_state = audio_player_get_state(engine->audio_player);
+    state->playing = player_state == PLAYER_STATE_PLAYING;
+    if (player_state != PLAYER_STATE_STOPPED) {
+        state->position_frames = audio_player_get_position_frames(engine->audio_player);
+    } else if (engine->resume_index == state->current_index) {
+        // restored but not played since: keep the position for the next restart
+        state->position_frames = engine->resume_frame;
+    }
+}
+
+// only_if_changed skips the write when the file already holds exactly this state
+static int save_session(RhythmEngine* engine, bool only_if_changed) {
+    // nothing to resume from an empty playlist (a failed load), and a stream cannot be
+    // opened again after a restart; either would only replace a useful snapshot
+    const char* current = current_file_path(engine);
+    if (!current || stream_source_is_stream(current)) return 0;
+
+    SessionState state;
+    get_session_state(engine, &state);
+    if (only_if_changed && engine->session_playlist_saved &&
+        memcmp(&state, &engine->session_saved, sizeof(state)) == 0) {
+        return 0;
+    }
+
+    if (session_save(engine->session_path, engine->playlist, &state, engine->session_playlist_saved) != 0) {
+        return -1;
+    }
+    engine->session_saved = state;
+    engine->session_playlist_saved = true;
+    return 0;
+}
+
+// the tracks after the current one in play order, and the current one too while nothing
+// plays so the first start is warm as well; a changed order replaces the queue
+static void schedule_prefetch(RhythmEngine* engine) {
+    if (!engine->prefetch) return;
+
+    const char* paths[PREFETCH_MAX_TRACKS + 1];
+    int indices[PREFETCH_MAX_TRACKS];
+    int count = 0;
+    const char* current = current_file_path(engine);
+    if (current && engine->prefetch_tracks > 0 &&
+        audio_player_get_state(engine->audio_player) == PLAYER_STATE_STOPPED && !stream_source_is_stream(current)) {
+        paths[count++] = current;
+    }
+    int upcoming = playlist_get_upcoming(engine->playlist, indices, engine->prefetch_tracks);
+    for (int i = 0; i < upcoming && count < PREFETCH_MAX_TRACKS; i++) {
+        const char* path = playlist_get_file_at(engine->playlist, indices[i]);
+        if (path && !stream_source_is_stream(path)) paths[count++] = path;
+    }
+    prefetch_schedule(engine->prefetch, paths, count);
+}
+
+// the decoder thread stamps the first sample after the engine has moved on, so the
+// previous start is counted when it is done
+static void collect_first_sample(RhythmEngine* engine) {
+    uint64_t elapsed = atomic_load(&engine->audio_player->first_sample_ns);
+    if (!engine->start_pending || elapsed == 0) return;
+
+    engine->first_sample_ms[engine->start_cached] += elapsed / 1e6;
+    engine->first_sample_starts[engine->start_cached]++;
+    engine->start_pending = false;
+}
+
+static void configure_prefetch_from_env(RhythmEngine* engine) {
+    const char* tracks = getenv("RHYTHM_PREFETCH");
+    const char* megabytes = getenv("RHYTHM_PREFETCH_MB");
+    engine->prefetch_tracks = PREFETCH_DEFAULT_TRACKS;
+    if (tracks && atoi(tracks) >= 0 && atoi(tracks) <= PREFETCH_MAX_TRACKS) engine->prefetch_tracks = atoi(tracks);
+    size_t budget = PREFETCH_DEFAULT_BUDGET;
+    if (megabytes && atoi(megabytes) > 0) budget = (size_t)atoi(megabytes) * 1024 * 1024;
+    engine->prefetch = prefetch_create(budget);
+}
+
+static pthread_once_t realtime_env_once = PTHREAD_ONCE_INIT;
+
+static void enable_realtime_from_env(void) {
+    RealtimeConfig config;
+    realtime_config_defaults(&config);
+    realtime_config_from_env(&config);
+    if (config.enabled) realtime_enable(&config);
+}
+
+static RhythmPowerMode power_mode_from_env(void) {
+    const char* power = getenv("RHYTHM_POWER");
+    if (power && strcasecmp(power, "low") == 0) return RHYTHM_POWER_LOW;
+    if (power && strcasecmp(power, "normal") == 0) return RHYTHM_POWER_NORMAL;
+    return RHYTHM_POWER_AUTO;
+}
+
+static RhythmError apply_power_mode(RhythmEngine* engine) {
+    bool low = engine->power_mode == RHYTHM_POWER_LOW ||
+               (engine->power_mode == RHYTHM_POWER_AUTO && !engine->interactive);
+    if (audio_player_is_low_power(engine->audio_player) == low) return RHYTHM_OK;
+
+    TRACE_SCOPE("engine_power_switch");
+    if (audio_player_set_low_power(engine->audio_player, low) != 0) {
+        engine->last_error = RHYTHM_ERROR_AUDIO_DEVICE;
+        return RHYTHM_ERROR_AUDIO_DEVICE;
+    }
+    engine->status_dirty = true;
+    return RHYTHM_OK;
+}
+
+static void to_audio_config(const RhythmAudioConfig* config, AudioConfig* audio_config) {
+    audio_config->backend = config->backend;
+    audio_config->sample_rate = config->sample_rate;
+    audio_config->frames_per_buffer = config->frames_per_buffer;
+    audio_config->channels = config->channels;
+    audio_config->latency = config->latency_ms / 1000.0;
+    audio_config->native_rate = config->native_rate;
+}
+
+void rhythm_engine_default_audio_config(RhythmAudioConfig* config) {
+    if (!config) return;
+
+    AudioConfig audio_config;
+    audio_config_defaults(&audio_config);
+
+    config->backend = audio_config.backend;
+    config->sample_rate = audio_config.sample_rate;
+    config->frames_per_buffer = audio_config.frames_per_buffer;
+    config->channels = audio_config.channels;
+    config->latency_ms = (float)(audio_config.latency * 1000.0);
+    config->native_rate = audio_config.native_rate;
+}
+
 RhythmEngine* rhythm_engine_create(void) {
+    RhythmAudioConfig config;
+    rhythm_engine_default_audio_config(&config);
+    return rhythm_engine_create_with_config(&config);
+}
+
+RhythmEngine* rhythm_engine_create_with_config(const RhythmAudioConfig* config) {
+    if (!config) return NULL;
+
+    // before anything logs, so the first record from an audio thread never starts the drain thread
+    log_init();
+    trace_init();
+    TRACE_THREAD_NAME("main");
+    TRACE_SCOPE("engine_create");
+    pthread_once(&realtime_env_once, enable_realtime_from_env);
+
     RhythmEngine* engine = malloc(sizeof(RhythmEngine));
     if (!engine) {
         return NULL;
@@ -81,13 +374,21 @@ RhythmEngine* rhythm_engine_create(void) {
     engine->last_error = RHYTHM_OK;
     engine->status_dirty = true;
 
-    engine->audio_player = audio_player_init();
+    const char* auto_gain = getenv("RHYTHM_AUTO_GAIN");
+    engine->auto_gain = !auto_gain || strcmp(auto_gain, "0") != 0;
+    engine->target_lufs = LOUDNESS_REFERENCE_LUFS;
+
+    AudioConfig audio_config;
+    to_audio_config(config, &audio_config);
+    engine->audio_player = audio_player_init_config(&audio_config);
     if (!engine->audio_player) {
         engine->last_error = RHYTHM_ERROR_AUDIO_DEVICE;
         free(engine);
         return NULL;
     }
 
+    setup_equalizer(engine->audio_player->dsp);
+
     engine->playlist = playlist_create();
     if (!engine->playlist) {
         engine->last_error = RHYTHM_ERROR_MEMORY;
@@ -95,6 +396,13 @@ RhythmEngine* rhythm_engine_create(void) {
         free(engine);
         return NULL;
     }
+    // search is optional: without an index rhythm_engine_search() reports the memory error
+    engine->search_index = search_index_create();
+    engine->resume_index = -1;
+    engine->interactive = true;
+    engine->power_mode = power_mode_from_env();
+    apply_power_mode(engine);
+    configure_prefetch_from_env(engine);
 
     update_status(engine);
 
@@ -104,8 +412,18 @@ RhythmEngine* rhythm_engine_create(void) {
 void rhythm_engine_destroy(RhythmEngine* engine) {
     if (!engine) return;
 
+    // the last position, taken before stopping so a restart resumes playing
+    if (engine->session_path) save_session(engine, false);
+    free(engine->session_path);
+
     rhythm_engine_stop(engine);
 
+    prefetch_destroy(engine->prefetch);
+    loudness_scan_destroy(engine->loudness_scan);
+    loudness_cache_close(engine->loudness_cache);
+    waveform_destroy(engine->waveform);
+    search_index_destroy(engine->search_index);
+
     if (engine->audio_player) {
         audio_player_cleanup(engine->audio_player);
     }
@@ -121,12 +439,29 @@ void rhythm_engine_destroy(RhythmEngine* engine) {
     free(engine);
 }
 
+// indexes playlist entries added since the last call; the index is rebuilt if the
+// playlist shrank behind its back
+static void sync_search_index(RhythmEngine* engine) {
+    if (!engine->search_index) return;
+    TRACE_SCOPE("search_index_sync");
+
+    int count = playlist_get_count(engine->playlist);
+    if (search_index_count(engine->search_index) > (size_t)count) search_index_clear(engine->search_index);
+    for (int i = (int)search_index_count(engine->search_index); i < count; i++) {
+        if (search_index_add_path(engine->search_index, playlist_get_file_at(engine->playlist, i)) != 0) break;
+    }
+}
+
 RhythmError rhythm_engine_load_file(RhythmEngine* engine, const char* filename) {
+    TRACE_SCOPE("engine_load_file");
     if (!engine) return RHYTHM_ERROR_NULL_POINTER;
     if (!filename) return RHYTHM_ERROR_NULL_POINTER;
 
+    TRACE_BEGIN(stat_span, "stat");
     struct stat st;
-    if (stat(filename, &st) != 0) {
+    bool found = stream_source_is_stream(filename) || stat(filename, &st) == 0;
+    TRACE_END(stat_span);
+    if (!found) {
         engine->last_error = RHYTHM_ERROR_FILE_NOT_FOUND;
         return RHYTHM_ERROR_FILE_NOT_FOUND;
     }
@@ -142,11 +477,16 @@ RhythmError rhythm_engine_load_file(RhythmEngine* engine, const char* filename)
             return RHYTHM_ERROR_MEMORY;
         }
     }
+    search_index_clear(engine->search_index);
+    engine->session_playlist_saved = false;
+    engine->resume_index = -1;
 
     if (playlist_add_file(engine->playlist, filename) != 0) {
         engine->last_error = RHYTHM_ERROR_INVALID_FORMAT;
         return RHYTHM_ERROR_INVALID_FORMAT;
     }
+    sync_search_index(engine);
+    schedule_prefetch(engine);
 
     engine->status_dirty = true;
     engine->last_error = RHYTHM_OK;
@@ -154,6 +494,7 @@ RhythmError rhythm_engine_load_file(RhythmEngine* engine, const char* filename)
 }
 
 RhythmError rhythm_engine_load_directory(RhythmEngine* engine, const char* directory) {
+    TRACE_SCOPE("engine_load_directory");
     if (!engine) return RHYTHM_ERROR_NULL_POINTER;
     if (!directory) return RHYTHM_ERROR_NULL_POINTER;
 
@@ -174,11 +515,16 @@ RhythmError rhythm_engine_load_directory(RhythmEngine* engine, const char* direc
         }
     }
 
+    search_index_clear(engine->search_index);
+    engine->session_playlist_saved = false;
+    engine->resume_index = -1;
     int added = playlist_add_directory(engine->playlist, directory);
     if (added <= 0) {
         engine->last_error = RHYTHM_ERROR_INVALID_FORMAT;
         return RHYTHM_ERROR_INVALID_FORMAT;
     }
+    sync_search_index(engine);
+    schedule_prefetch(engine);
 
     engine->status_dirty = true;
     engine->last_error = RHYTHM_OK;
@@ -186,6 +532,7 @@ RhythmError rhythm_engine_load_directory(RhythmEngine* engine, const char* direc
 }
 
 RhythmError rhythm_engine_play(RhythmEngine* engine) {
+    TRACE_SCOPE("engine_play");
     if (!engine) return RHYTHM_ERROR_NULL_POINTER;
     if (!engine->audio_player) return RHYTHM_ERROR_INVALID_STATE;
     if (!engine->playlist) return RHYTHM_ERROR_INVALID_STATE;
@@ -199,11 +546,23 @@ RhythmError rhythm_engine_play(RhythmEngine* engine) {
     if (engine->audio_player->state == PLAYER_STATE_PAUSED) {
         audio_player_resume(engine->audio_player);
     } else {
+        long long start_frame = 0;
+        if (engine->resume_index == playlist_get_current_index(engine->playlist)) {
+            start_frame = engine->resume_frame;
+        }
+        engine->resume_index = -1;
 
-        if (audio_player_play(engine->audio_player, current_file) != 0) {
+        collect_first_sample(engine);
+        bool cached = !stream_source_is_stream(current_file) && prefetch_note_start(engine->prefetch, current_file);
+        if (audio_player_play_from(engine->audio_player, current_file, start_frame) != 0) {
             engine->last_error = RHYTHM_ERROR_INVALID_FORMAT;
             return RHYTHM_ERROR_INVALID_FORMAT;
         }
+        engine->start_pending = true;
+        engine->start_cached = cached;
+        apply_track_gain(engine);
+        start_waveform(engine);
+        schedule_prefetch(engine);
     }
 
     engine->status_dirty = true;
@@ -212,6 +571,7 @@ RhythmError rhythm_engine_play(RhythmEngine* engine) {
 }
 
 RhythmError rhythm_engine_pause(RhythmEngine* engine) {
+    TRACE_SCOPE("engine_pause");
     if (!engine) return RHYTHM_ERROR_NULL_POINTER;
     if (!engine->audio_player) return RHYTHM_ERROR_INVALID_STATE;
 
@@ -222,6 +582,7 @@ RhythmError rhythm_engine_pause(RhythmEngine* engine) {
 }
 
 RhythmError rhythm_engine_stop(RhythmEngine* engine) {
+    TRACE_SCOPE("engine_stop");
     if (!engine) return RHYTHM_ERROR_NULL_POINTER;
     if (!engine->audio_player) return RHYTHM_ERROR_INVALID_STATE;
 
@@ -232,9 +593,11 @@ RhythmError rhythm_engine_stop(RhythmEngine* engine) {
 }
 
 RhythmError rhythm_engine_next_track(RhythmEngine* engine) {
+    TRACE_SCOPE("engine_next_track");
     if (!engine) return RHYTHM_ERROR_NULL_POINTER;
     if (!engine->playlist) return RHYTHM_ERROR_INVALID_STATE;
 
+    engine->resume_index = -1;
     if (playlist_next(engine->playlist) < 0) {
         engine->last_error = RHYTHM_ERROR_INVALID_STATE;
         return RHYTHM_ERROR_INVALID_STATE;
@@ -243,6 +606,7 @@ RhythmError rhythm_engine_next_track(RhythmEngine* engine) {
     if (engine->audio_player && engine->audio_player->state == PLAYER_STATE_PLAYING) {
         return rhythm_engine_play(engine);
     }
+    schedule_prefetch(engine);
 
     engine->status_dirty = true;
     engine->last_error = RHYTHM_OK;
@@ -250,9 +614,11 @@ RhythmError rhythm_engine_next_track(RhythmEngine* engine) {
 }
 
 RhythmError rhythm_engine_previous_track(RhythmEngine* engine) {
+    TRACE_SCOPE("engine_previous_track");
     if (!engine) return RHYTHM_ERROR_NULL_POINTER;
     if (!engine->playlist) return RHYTHM_ERROR_INVALID_STATE;
 
+    engine->resume_index = -1;
     if (playlist_previous(engine->playlist) < 0) {
         engine->last_error = RHYTHM_ERROR_INVALID_STATE;
         return RHYTHM_ERROR_INVALID_STATE;
@@ -261,13 +627,33 @@ RhythmError rhythm_engine_previous_track(RhythmEngine* engine) {
     if (engine->audio_player && engine->audio_player->state == PLAYER_STATE_PLAYING) {
         return rhythm_engine_play(engine);
     }
+    schedule_prefetch(engine);
 
     engine->status_dirty = true;
     engine->last_error = RHYTHM_OK;
     return RHYTHM_OK;
 }
 
+RhythmError rhythm_engine_play_track(RhythmEngine* engine, int index) {
+    TRACE_SCOPE("engine_play_track");
+    if (!engine) return RHYTHM_ERROR_NULL_POINTER;
+    if (!engine->playlist || playlist_set_current(engine->playlist, index) < 0) {
+        engine->last_error = RHYTHM_ERROR_INVALID_STATE;
+        return RHYTHM_ERROR_INVALID_STATE;
+    }
+
+    engine->resume_index = -1;
+    // stopped first, so a paused player starts the new track instead of resuming the old one
+    rhythm_engine_stop(engine);
+    return rhythm_engine_play(engine);
+}
+
+Playlist* rhythm_engine_get_playlist(RhythmEngine* engine) {
+    return engine ? engine->playlist : NULL;
+}
+
 RhythmError rhythm_engine_seek(RhythmEngine* engine, float position) {
+    TRACE_SCOPE("engine_seek");
     if (!engine) return RHYTHM_ERROR_NULL_POINTER;
     if (!engine->audio_player) return RHYTHM_ERROR_INVALID_STATE;
 
@@ -302,6 +688,566 @@ RhythmError rhythm_engine_set_volume(RhythmEngine* engine, float volume) {
     return RHYTHM_OK;
 }
 
+RhythmError rhythm_engine_set_eq_enabled(RhythmEngine* engine, bool enabled) {
+    if (!engine) return RHYTHM_ERROR_NULL_POINTER;
+    if (!engine->audio_player) return RHYTHM_ERROR_INVALID_STATE;
+
+    dsp_chain_set_enabled(engine->audio_player->dsp, enabled);
+    engine->last_error = RHYTHM_OK;
+    return RHYTHM_OK;
+}
+
+RhythmError rhythm_engine_set_eq_band(RhythmEngine* engine, int band, float gain_db) {
+    if (!engine) return RHYTHM_ERROR_NULL_POINTER;
+    if (!engine->audio_player || band < 0 || band >= RHYTHM_EQ_BANDS) return RHYTHM_ERROR_INVALID_STATE;
+
+    return set_eq_stage_gain(engine, EQ_PREAMP_STAGE + 1 + band, gain_db);
+}
+
+RhythmError rhythm_engine_set_eq_preamp(RhythmEngine* engine, float gain_db) {
+    if (!engine) return RHYTHM_ERROR_NULL_POINTER;
+    if (!engine->audio_player) return RHYTHM_ERROR_INVALID_STATE;
+
+    return set_eq_stage_gain(engine, EQ_PREAMP_STAGE, gain_db);
+}
+
+RhythmError rhythm_engine_get_eq(RhythmEngine* engine, RhythmEqualizer* eq) {
+    if (!engine || !eq) return RHYTHM_ERROR_NULL_POINTER;
+    if (!engine->audio_player) return RHYTHM_ERROR_INVALID_STATE;
+
+    DspChain* dsp = engine->audio_player->dsp;
+    DspStageParams params;
+    memset(eq, 0, sizeof(RhythmEqualizer));
+    eq->enabled = dsp_chain_is_enabled(dsp);
+    if (dsp_chain_get_stage(dsp, EQ_PREAMP_STAGE, &params) == 0) {
+        eq->preamp_db = params.gain_db;
+    }
+    for (int i = 0; i < RHYTHM_EQ_BANDS; i++) {
+        eq->band_frequency[i] = EQ_FREQUENCIES[i];
+        if (dsp_chain_get_stage(dsp, EQ_PREAMP_STAGE + 1 + i, &params) == 0) {
+            eq->band_gain_db[i] = params.gain_db;
+        }
+    }
+    return RHYTHM_OK;
+}
+
+RhythmError rhythm_engine_play_overlay(RhythmEngine* engine, const char* path,
+                                       const RhythmOverlayParams* params, int* voice) {
+    if (!engine || !path || !params) return RHYTHM_ERROR_NULL_POINTER;
+    if (!engine->audio_player) return RHYTHM_ERROR_INVALID_STATE;
+
+    if (stream_source_is_stream(path)) {
+        engine->last_error = RHYTHM_ERROR_INVALID_FORMAT;
+        return RHYTHM_ERROR_INVALID_FORMAT;
+    }
+
+    AudioPlayer* player = engine->audio_player;
+    mixer_set_format(player->mixer, player->sample_rate, player->channels);
+    int id = mixer_play(player->mixer, path, params);
+    decoder_pool_wake(player->mixer_job);
+    if (id < 0) {
+        engine->last_error = access(path, R_OK) == 0 ? RHYTHM_ERROR_INVALID_STATE : RHYTHM_ERROR_FILE_NOT_FOUND;
+        return engine->last_error;
+    }
+    if (voice) *voice = id;
+    engine->last_error = RHYTHM_OK;
+    return RHYTHM_OK;
+}
+
+RhythmError rhythm_engine_set_overlay(RhythmEngine* engine, int voice, const RhythmOverlayParams* params) {
+    if (!engine || !params) return RHYTHM_ERROR_NULL_POINTER;
+    if (!engine->audio_player) return RHYTHM_ERROR_INVALID_STATE;
+
+    engine->last_error = mixer_set_voice(engine->audio_player->mixer, voice, params) == 0
+        ? RHYTHM_OK : RHYTHM_ERROR_INVALID_STATE;
+    return engine->last_error;
+}
+
+RhythmError rhythm_engine_stop_overlay(RhythmEngine* engine, int voice) {
+    if (!engine) return RHYTHM_ERROR_NULL_POINTER;
+    if (!engine->audio_player) return RHYTHM_ERROR_INVALID_STATE;
+
+    engine->last_error = mixer_stop(engine->audio_player->mixer, voice) == 0 ? RHYTHM_OK : RHYTHM_ERROR_INVALID_STATE;
+    return engine->last_error;
+}
+
+RhythmError rhythm_engine_set_ducking(RhythmEngine* engine, float duck_db, float attack_ms, float release_ms) {
+    if (!engine) return RHYTHM_ERROR_NULL_POINTER;
+    if (!engine->audio_player) return RHYTHM_ERROR_INVALID_STATE;
+
+    mixer_set_ducking(engine->audio_player->mixer, duck_db, attack_ms, release_ms);
+    engine->last_error = RHYTHM_OK;
+    return RHYTHM_OK;
+}
+
+RhythmError rhythm_engine_get_overlay_stats(RhythmEngine* engine, RhythmOverlayStats* stats) {
+    if (!engine || !stats) return RHYTHM_ERROR_NULL_POINTER;
+    if (!engine->audio_player) return RHYTHM_ERROR_INVALID_STATE;
+
+    mixer_get_stats(engine->audio_player->mixer, stats);
+    return RHYTHM_OK;
+}
+
+RhythmError rhythm_engine_get_stream_stats(RhythmEngine* engine, RhythmStreamStats* stats) {
+    if (!engine || !stats) return RHYTHM_ERROR_NULL_POINTER;
+    if (!engine->audio_player) return RHYTHM_ERROR_INVALID_STATE;
+
+    audio_player_get_stream_stats(engine->audio_player, stats);
+    return RHYTHM_OK;
+}
+
+RhythmError rhythm_engine_search(RhythmEngine* engine, const char* query, int* results, int max_results,
+                                 int* found) {
+    TRACE_SCOPE("engine_search");
+    if (!engine || !query || !results || !found) return RHYTHM_ERROR_NULL_POINTER;
+    if (!engine->search_index) return RHYTHM_ERROR_MEMORY;
+
+    sync_search_index(engine);
+    int count = search_index_query(engine->search_index, query, results, max_results);
+    if (count < 0) {
+        *found = 0;
+        engine->last_error = RHYTHM_ERROR_MEMORY;
+        return RHYTHM_ERROR_MEMORY;
+    }
+    *found = count;
+    engine->last_error = RHYTHM_OK;
+    return RHYTHM_OK;
+}
+
+RhythmError rhythm_engine_get_search_stats(RhythmEngine* engine, RhythmSearchStats* stats) {
+    if (!engine || !stats) return RHYTHM_ERROR_NULL_POINTER;
+
+    sync_search_index(engine);
+    search_index_get_stats(engine->search_index, stats);
+    return RHYTHM_OK;
+}
+
+RhythmError rhythm_engine_set_realtime(RhythmEngine* engine, const RhythmRealtimeConfig* config) {
+    TRACE_SCOPE("engine_set_realtime");
+    if (!engine || !config) return RHYTHM_ERROR_NULL_POINTER;
+
+    if (realtime_enable(config) != 0) {
+        engine->last_error = RHYTHM_ERROR_INVALID_STATE;
+        return RHYTHM_ERROR_INVALID_STATE;
+    }
+    engine->last_error = RHYTHM_OK;
+    return RHYTHM_OK;
+}
+
+RhythmError rhythm_engine_get_realtime_status(RhythmEngine* engine, RhythmRealtimeStatus* status) {
+    if (!engine || !status) return RHYTHM_ERROR_NULL_POINTER;
+
+    realtime_apply();
+    realtime_get_status(status);
+    return RHYTHM_OK;
+}
+
+RhythmError rhythm_engine_set_log_level(RhythmEngine* engine, RhythmLogLevel level) {
+    if (!engine) return RHYTHM_ERROR_NULL_POINTER;
+    if (level < LOG_LEVEL_DEBUG || level >= LOG_LEVELS) {
+        engine->last_error = RHYTHM_ERROR_INVALID_STATE;
+        return RHYTHM_ERROR_INVALID_STATE;
+    }
+    log_set_level(level);
+    engine->last_error = RHYTHM_OK;
+    return RHYTHM_OK;
+}
+
+RhythmError rhythm_engine_set_log_file(RhythmEngine* engine, const char* path) {
+    if (!engine) return RHYTHM_ERROR_NULL_POINTER;
+    if (log_set_file(path) != 0) {
+        engine->last_error = RHYTHM_ERROR_FILE_NOT_FOUND;
+        return RHYTHM_ERROR_FILE_NOT_FOUND;
+    }
+    engine->last_error = RHYTHM_OK;
+    return RHYTHM_OK;
+}
+
+RhythmError rhythm_engine_set_log_callback(RhythmEngine* engine, RhythmLogCallback callback, void* user_data) {
+    if (!engine) return RHYTHM_ERROR_NULL_POINTER;
+    log_set_callback(callback, user_data);
+    return RHYTHM_OK;
+}
+
+RhythmError rhythm_engine_get_log_stats(RhythmEngine* engine, RhythmLogStats* stats) {
+    if (!engine || !stats) return RHYTHM_ERROR_NULL_POINTER;
+    log_get_stats(stats);
+    return RHYTHM_OK;
+}
+
+RhythmError rhythm_engine_set_session_file(RhythmEngine* engine, const char* path, int interval_ms) {
+    if (!engine) return RHYTHM_ERROR_NULL_POINTER;
+
+    free(engine->session_path);
+    engine->session_path = NULL;
+    engine->session_playlist_saved = false;
+    if (!path) return RHYTHM_OK;
+
+    engine->session_path = strdup(path);
+    if (!engine->session_path) {
+        engine->last_error = RHYTHM_ERROR_MEMORY;
+        return RHYTHM_ERROR_MEMORY;
+    }
+    engine->session_interval_ms = interval_ms > 0 ? interval_ms : RHYTHM_SESSION_INTERVAL_MS;
+    engine->session_saved_at = monotonic_ms();
+    engine->last_error = RHYTHM_OK;
+    return RHYTHM_OK;
+}
+
+RhythmError rhythm_engine_save_session(RhythmEngine* engine, const char* path) {
+    TRACE_SCOPE("engine_save_session");
+    if (!engine || !path) return RHYTHM_ERROR_NULL_POINTER;
+    if (!engine->playlist || !engine->audio_player) return RHYTHM_ERROR_INVALID_STATE;
+
+    int result;
+    if (engine->session_path && strcmp(engine->session_path, path) == 0) {
+        result = save_session(engine, false);
+    } else {
+        SessionState state;
+        get_session_state(engine, &state);
+        result = session_save(path, engine->playlist, &state, false);
+    }
+    engine->last_error = result == 0 ? RHYTHM_OK : RHYTHM_ERROR_FILE_NOT_FOUND;
+    return engine->last_error;
+}
+
+RhythmError rhythm_engine_restore_session(RhythmEngine* engine, const char* path) {
+    TRACE_SCOPE("engine_restore_session");
+    if (!engine || !path) return RHYTHM_ERROR_NULL_POINTER;
+    if (!engine->playlist || !engine->audio_player) return RHYTHM_ERROR_INVALID_STATE;
+
+    rhythm_engine_stop(engine);
+    search_index_clear(engine->search_index);
+    engine->session_playlist_saved = false;
+    engine->resume_index = -1;
+
+    SessionState state;
+    if (session_restore(path, engine->playlist, &state) != 0) {
+        engine->status_dirty = true;
+        engine->last_error = access(path, F_OK) == 0 ? RHYTHM_ERROR_INVALID_FORMAT : RHYTHM_ERROR_FILE_NOT_FOUND;
+        return engine->last_error;
+    }
+
+    audio_player_set_volume(engine->audio_player, state.volume);
+    engine->resume_index = state.current_index;
+    engine->resume_frame = state.position_frames;
+    engine->session_playlist_saved = engine->session_path && strcmp(engine->session_path, path) == 0;
+    engine->status_dirty = true;
+    schedule_prefetch(engine);
+
+    if (state.playing && state.current_index >= 0) return rhythm_engine_play(engine);
+    engine->last_error = RHYTHM_OK;
+    return RHYTHM_OK;
+}
+
+RhythmError rhythm_engine_set_shuffle(RhythmEngine* engine, bool enabled) {
+    if (!engine) return RHYTHM_ERROR_NULL_POINTER;
+    if (!engine->playlist) return RHYTHM_ERROR_INVALID_STATE;
+    if (playlist_is_shuffled(engine->playlist) == enabled) return RHYTHM_OK;
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    if (playlist_set_shuffle(engine->playlist, enabled, (unsigned int)(ts.tv_nsec ^ ts.tv_sec)) != 0) {
+        engine->last_error = RHYTHM_ERROR_MEMORY;
+        return RHYTHM_ERROR_MEMORY;
+    }
+    schedule_prefetch(engine);
+    engine->session_playlist_saved = false;
+    engine->status_dirty = true;
+    engine->last_error = RHYTHM_OK;
+    return RHYTHM_OK;
+}
+
+bool rhythm_engine_get_shuffle(RhythmEngine* engine) {
+    return engine && engine->playlist && playlist_is_shuffled(engine->playlist);
+}
+
+RhythmError rhythm_engine_set_prefetch(RhythmEngine* engine, int tracks, size_t budget_bytes) {
+    if (!engine) return RHYTHM_ERROR_NULL_POINTER;
+    if (!engine->prefetch || tracks < 0 || tracks > PREFETCH_MAX_TRACKS) {
+        engine->last_error = RHYTHM_ERROR_INVALID_STATE;
+        return RHYTHM_ERROR_INVALID_STATE;
+    }
+
+    engine->prefetch_tracks = tracks;
+    prefetch_set_budget(engine->prefetch, budget_bytes > 0 ? budget_bytes : PREFETCH_DEFAULT_BUDGET);
+    schedule_prefetch(engine);
+    engine->last_error = RHYTHM_OK;
+    return RHYTHM_OK;
+}
+
+RhythmError rhythm_engine_get_prefetch_stats(RhythmEngine* engine, RhythmPrefetchStats* stats) {
+    if (!engine || !stats) return RHYTHM_ERROR_NULL_POINTER;
+    if (!engine->prefetch) return RHYTHM_ERROR_INVALID_STATE;
+
+    PrefetchStats source;
+    prefetch_get_stats(engine->prefetch, &source);
+    collect_first_sample(engine);
+
+    memset(stats, 0, sizeof(*stats));
+    stats->scheduled = source.scheduled;
+    stats->warmed = source.warmed;
+    stats->cancelled = source.cancelled;
+    stats->bytes = source.bytes;
+    stats->hits = source.hits;
+    stats->misses = source.misses;
+    if (source.hits + source.misses > 0) {
+        stats->hit_rate = (float)source.hits / (float)(source.hits + source.misses);
+    }
+    stats->idle = prefetch_is_idle(engine->prefetch);
+
+    stats->first_sample_ms = atomic_load(&engine->audio_player->first_sample_ns) / 1e6f;
+    if (engine->first_sample_starts[1] > 0) {
+        stats->first_sample_hit_ms = (float)(engine->first_sample_ms[1] / engine->first_sample_starts[1]);
+    }
+    if (engine->first_sample_starts[0] > 0) {
+        stats->first_sample_miss_ms = (float)(engine->first_sample_ms[0] / engine->first_sample_starts[0]);
+    }
+    return RHYTHM_OK;
+}
+
+RhythmError rhythm_engine_set_pcm_cache(RhythmEngine* engine, size_t budget_bytes, bool pack16) {
+    if (!engine) return RHYTHM_ERROR_NULL_POINTER;
+    if (!engine->audio_player || !engine->audio_player->pcm_cache) {
+        engine->last_error = RHYTHM_ERROR_INVALID_STATE;
+        return RHYTHM_ERROR_INVALID_STATE;
+    }
+
+    pcm_cache_configure(engine->audio_player->pcm_cache, budget_bytes, pack16);
+    engine->last_error = RHYTHM_OK;
+    return RHYTHM_OK;
+}
+
+RhythmError rhythm_engine_get_pcm_cache_stats(RhythmEngine* engine, RhythmPcmCacheStats* stats) {
+    if (!engine || !stats) return RHYTHM_ERROR_NULL_POINTER;
+    if (!engine->audio_player || !engine->audio_player->pcm_cache) return RHYTHM_ERROR_INVALID_STATE;
+
+    pcm_cache_get_stats(engine->audio_player->pcm_cache, stats);
+    return RHYTHM_OK;
+}
+
+RhythmError rhythm_engine_set_power_mode(RhythmEngine* engine, RhythmPowerMode mode) {
+    if (!engine) return RHYTHM_ERROR_NULL_POINTER;
+    if (!engine->audio_player || mode < RHYTHM_POWER_AUTO || mode > RHYTHM_POWER_LOW) {
+        return RHYTHM_ERROR_INVALID_STATE;
+    }
+
+    engine->power_mode = mode;
+    engine->last_error = RHYTHM_OK;
+    return apply_power_mode(engine);
+}
+
+RhythmError rhythm_engine_set_interactive(RhythmEngine* engine, bool interactive) {
+    if (!engine) return RHYTHM_ERROR_NULL_POINTER;
+    if (!engine->audio_player) return RHYTHM_ERROR_INVALID_STATE;
+
+    engine->interactive = interactive;
+    engine->last_error = RHYTHM_OK;
+    return apply_power_mode(engine);
+}
+
+bool rhythm_engine_is_low_power(RhythmEngine* engine) {
+    return engine && audio_player_is_low_power(engine->audio_player);
+}
+
+int rhythm_engine_get_tick_interval_ms(RhythmEngine* engine) {
+    return rhythm_engine_is_low_power(engine) ? RHYTHM_LOW_POWER_TICK_MS : RHYTHM_TICK_MS;
+}
+
+RhythmError rhythm_engine_configure_audio(RhythmEngine* engine, const RhythmAudioConfig* config) {
+    TRACE_SCOPE("engine_configure_audio");
+    if (!engine || !config) return RHYTHM_ERROR_NULL_POINTER;
+    if (!engine->audio_player) return RHYTHM_ERROR_INVALID_STATE;
+
+    AudioConfig audio_config;
+    to_audio_config(config, &audio_config);
+    if (audio_player_configure(engine->audio_player, &audio_config) != 0) {
+        engine->last_error = RHYTHM_ERROR_AUDIO_DEVICE;
+        return RHYTHM_ERROR_AUDIO_DEVICE;
+    }
+
+    engine->status_dirty = true;
+    engine->last_error = RHYTHM_OK;
+    return RHYTHM_OK;
+}
+
+RhythmError rhythm_engine_get_audio_info(RhythmEngine* engine, RhythmAudioInfo* info) {
+    if (!engine || !info) return RHYTHM_ERROR_NULL_POINTER;
+    if (!engine->audio_player) return RHYTHM_ERROR_INVALID_STATE;
+
+    AudioOutputInfo output_info;
+    audio_player_get_output_info(engine->audio_player, &output_info);
+
+    info->backend = output_info.backend;
+    info->sample_rate = output_info.sample_rate;
+    info->frames_per_buffer = output_info.frames_per_buffer;
+    info->channels = output_info.channels;
+    info->source_rate = (int)output_info.source_rate;
+    info->resampling = output_info.resampling;
+    info->output_latency_ms = (float)(output_info.output_latency * 1000.0);
+    info->buffer_latency_ms = (float)(output_info.buffer_latency * 1000.0);
+
+    return RHYTHM_OK;
+}
+
+static float ns_to_us(uint64_t ns) {
+    return (float)(ns / 1000.0);
+}
+
+static float frames_to_ms(uint64_t frames, int sample_rate) {
+    return sample_rate > 0 ? (float)(frames * 1000.0 / sample_rate) : 0.0f;
+}
+
+RhythmError rhythm_engine_get_stats(RhythmEngine* engine, RhythmStats* stats) {
+    if (!engine || !stats) return RHYTHM_ERROR_NULL_POINTER;
+    if (!engine->audio_player) return RHYTHM_ERROR_INVALID_STATE;
+
+    AudioPlayer* player = engine->audio_player;
+    AudioStats* source = &player->stats;
+    int rate = player->sample_rate;
+
+    memset(stats, 0, sizeof(*stats));
+    stats->callbacks = atomic_load(&source->callbacks);
+    stats->underflows = atomic_load(&source->underflows);
+    unsigned long xruns = audio_player_get_xrun_count(player);
+    if (xruns >= engine->xrun_baseline) stats->underflows += xruns - engine->xrun_baseline;
+    stats->overflows = atomic_load(&source->overflows);
+    stats->starved_callbacks = atomic_load(&source->starved_callbacks);
+    stats->deadline_misses = atomic_load(&source->deadline_misses);
+
+    stats->callback_budget_us = ns_to_us(atomic_load(&source->last_budget_ns));
+    stats->callback_p50_us = ns_to_us(latency_histogram_percentile(&source->callback_time, 50.0));
+    stats->callback_p99_us = ns_to_us(latency_histogram_percentile(&source->callback_time, 99.0));
+    stats->callback_p999_us = ns_to_us(latency_histogram_percentile(&source->callback_time, 99.9));
+    stats->callback_max_us = ns_to_us(atomic_load(&source->callback_time.max_ns));
+    stats->decode_p50_us = ns_to_us(latency_histogram_percentile(&source->decode_time, 50.0));
+    stats->decode_p99_us = ns_to_us(latency_histogram_percentile(&source->decode_time, 99.0));
+    stats->decode_max_us = ns_to_us(atomic_load(&source->decode_time.max_ns));
+
+    stats->ring_fill_ms = frames_to_ms(atomic_load(&source->ring_fill_frames), rate);
+    uint64_t min_fill = atomic_load(&source->ring_min_fill_frames);
+    stats->ring_min_fill_ms = min_fill == UINT64_MAX ? 0.0f : frames_to_ms(min_fill, rate);
+    if (player->ring && player->channels > 0) {
+        stats->ring_capacity_ms = frames_to_ms(atomic_load(&player->ring_frames), rate);
+    }
+
+    stats->worst_callback_us = ns_to_us(atomic_load(&source->worst_callback_ns));
+    stats->worst_callback_time = atomic_load(&source->worst_callback_at_ns) / 1e9;
+
+    return RHYTHM_OK;
+}
+
+RhythmError rhythm_engine_reset_stats(RhythmEngine* engine) {
+    if (!engine) return RHYTHM_ERROR_NULL_POINTER;
+    if (!engine->audio_player) return RHYTHM_ERROR_INVALID_STATE;
+
+    audio_stats_request_reset(&engine->audio_player->stats);
+    engine->xrun_baseline = audio_player_get_xrun_count(engine->audio_player);
+    return RHYTHM_OK;
+}
+
+RhythmError rhythm_engine_flush_trace(RhythmEngine* engine, const char* path) {
+    if (!engine) return RHYTHM_ERROR_NULL_POINTER;
+    if (!trace_enabled()) return RHYTHM_ERROR_INVALID_STATE;
+
+    if (trace_flush(path) != 0) {
+        engine->last_error = RHYTHM_ERROR_FILE_NOT_FOUND;
+        return RHYTHM_ERROR_FILE_NOT_FOUND;
+    }
+    return RHYTHM_OK;
+}
+
+RhythmError rhythm_engine_start_loudness_scan(RhythmEngine* engine, int threads) {
+    if (!engine) return RHYTHM_ERROR_NULL_POINTER;
+    if (!engine->playlist || playlist_is_empty(engine->playlist)) return RHYTHM_ERROR_INVALID_STATE;
+
+    LoudnessCache* cache = open_loudness_cache(engine, true);
+    if (!cache) {
+        engine->last_error = RHYTHM_ERROR_INIT;
+        return RHYTHM_ERROR_INIT;
+    }
+
+    loudness_scan_destroy(engine->loudness_scan);
+    engine->scan_results_seen = 0;
+    engine->loudness_scan = loudness_scan_start(cache, (const char* const*)engine->playlist->files,
+                                                playlist_get_count(engine->playlist), threads);
+    if (!engine->loudness_scan) {
+        engine->last_error = RHYTHM_ERROR_MEMORY;
+        return RHYTHM_ERROR_MEMORY;
+    }
+
+    engine->last_error = RHYTHM_OK;
+    return RHYTHM_OK;
+}
+
+RhythmError rhythm_engine_get_loudness_scan_status(RhythmEngine* engine, RhythmLoudnessScanStatus* status) {
+    if (!engine || !status) return RHYTHM_ERROR_NULL_POINTER;
+
+    memset(status, 0, sizeof(*status));
+    if (!engine->loudness_scan) return RHYTHM_OK;
+
+    LoudnessScanProgress progress;
+    loudness_scan_get_progress(engine->loudness_scan, &progress);
+    status->total_tracks = progress.total;
+    status->analysed = progress.analysed;
+    status->cached = progress.cached;
+    status->failed = progress.failed;
+    status->running = !progress.finished;
+    return RHYTHM_OK;
+}
+
+RhythmError rhythm_engine_cancel_loudness_scan(RhythmEngine* engine) {
+    if (!engine) return RHYTHM_ERROR_NULL_POINTER;
+
+    loudness_scan_cancel(engine->loudness_scan);
+    return RHYTHM_OK;
+}
+
+RhythmError rhythm_engine_set_auto_gain(RhythmEngine* engine, bool enabled, float target_lufs) {
+    if (!engine) return RHYTHM_ERROR_NULL_POINTER;
+    if (!engine->audio_player) return RHYTHM_ERROR_INVALID_STATE;
+    if (target_lufs < -70.0f || target_lufs > 0.0f) return RHYTHM_ERROR_INVALID_STATE;
+
+    engine->auto_gain = enabled;
+    engine->target_lufs = target_lufs;
+    apply_track_gain(engine);
+    return RHYTHM_OK;
+}
+
+RhythmError rhythm_engine_get_track_loudness(RhythmEngine* engine, RhythmTrackLoudness* loudness) {
+    if (!engine || !loudness) return RHYTHM_ERROR_NULL_POINTER;
+
+    memset(loudness, 0, sizeof(*loudness));
+    loudness->measured = engine->track_measured;
+    if (engine->track_measured) {
+        loudness->integrated_lufs = engine->track_loudness.integrated_lufs;
+        loudness->loudness_range = engine->track_loudness.loudness_range;
+        loudness->true_peak_dbtp = engine->track_loudness.true_peak_dbtp;
+    }
+    loudness->applied_gain_db = engine->applied_gain_db;
+    return RHYTHM_OK;
+}
+
+RhythmError rhythm_engine_get_waveform(RhythmEngine* engine, float start, float end,
+                                       RhythmWaveformBucket* buckets, int count, float* ready) {
+    if (!engine || !buckets) return RHYTHM_ERROR_NULL_POINTER;
+    if (ready) *ready = 0.0f;
+    if (count <= 0 || start < 0.0f || end > 1.0f || end <= start) return RHYTHM_ERROR_INVALID_STATE;
+
+    memset(buckets, 0, (size_t)count * sizeof(RhythmWaveformBucket));
+    long long total = waveform_total_frames(engine->waveform);
+    if (!engine->waveform || total <= 0) {
+        return engine->waveform ? RHYTHM_OK : RHYTHM_ERROR_INVALID_STATE;
+    }
+
+    if (ready) *ready = waveform_progress(engine->waveform);
+    long long first = (long long)(start * (double)total);
+    long long last = (long long)(end * (double)total);
+    if (last <= first) last = first + 1;
+    waveform_get_buckets(engine->waveform, first, last, buckets, count);
+    return RHYTHM_OK;
+}
+
 RhythmStatus rhythm_engine_get_status(RhythmEngine* engine) {
     RhythmStatus empty_status = {0};
 
@@ -316,9 +1262,51 @@ RhythmStatus rhythm_engine_get_status(RhythmEngine* engine) {
     return engine->current_status;
 }
 
+RhythmError rhythm_engine_get_status_frame(RhythmEngine* engine, RhythmStatusFrame* frame) {
+    if (!engine || !frame) return RHYTHM_ERROR_NULL_POINTER;
+
+    fill_status(engine, &frame->status);
+    frame->status.current_file = NULL;
+
+    // the name is only rewritten when it changes, so readers can skip re-interning it
+    const char* path = current_file_path(engine);
+    const char* slash = path ? strrchr(path, '/') : NULL;
+    const char* name = slash ? slash + 1 : (path ? path : "");
+    if (strncmp(frame->file_name, name, RHYTHM_FILE_NAME_MAX - 1) != 0) {
+        snprintf(frame->file_name, RHYTHM_FILE_NAME_MAX, "%s", name);
+        frame->file_sequence++;
+    }
+    frame->sequence++;
+
+    return RHYTHM_OK;
+}
+
+size_t rhythm_engine_status_frame_size(void) {
+    return sizeof(RhythmStatusFrame);
+}
+
 void rhythm_engine_update(RhythmEngine* engine) {
     if (!engine) return;
 
+    // pick up the current track's measurement as soon as a running scan produces it
+    if (engine->loudness_scan && !engine->track_measured && engine->audio_player->current_file) {
+        LoudnessScanProgress progress;
+        loudness_scan_get_progress(engine->loudness_scan, &progress);
+        if (progress.analysed != engine->scan_results_seen) {
+            engine->scan_results_seen = progress.analysed;
+            apply_track_gain(engine);
+        }
+    }
+
+    // threads that started since the last update get the real-time profile
+    realtime_apply();
+
+    if (engine->session_path && monotonic_ms() - engine->session_saved_at >= engine->session_interval_ms) {
+        // also after a failed save, so a full disk is retried once per interval, not per frame
+        engine->session_saved_at = monotonic_ms();
+        save_session(engine, true);
+    }
+
     engine->status_dirty = true;
 }
 
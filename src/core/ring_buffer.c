@@ -0,0 +1,117 @@
+#include "core/ring_buffer.h"
+#include "core/realtime.h"
+#include <stdlib.h>
+#include <string.h>
+
+static size_t next_power_of_two(size_t value) {
+    size_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+static size_t consumer_position(RingBuffer *ring) {
+    size_t read = atomic_load_explicit(&ring->read_pos, memory_order_acquire);
+    size_t flush = atomic_load_explicit(&ring->flush_pos, memory_order_acquire);
+    return flush > read ? flush : read;
+}
+
+RingBuffer* ring_buffer_create(size_t min_capacity) {
+    RingBuffer *ring = malloc(sizeof(RingBuffer));
+    if (!ring) return NULL;
+
+    ring->capacity = next_power_of_two(min_capacity);
+    ring->mask = ring->capacity - 1;
+    ring->data = calloc(ring->capacity, sizeof(float));
+    if (!ring->data) {
+        free(ring);
+        return NULL;
+    }
+
+    atomic_init(&ring->write_pos, 0);
+    atomic_init(&ring->read_pos, 0);
+    atomic_init(&ring->flush_pos, 0);
+    // locked or prefaulted with the real-time profile, so the callback never waits on a page fault
+    realtime_register_buffer(ring->data, ring->capacity * sizeof(float));
+
+    return ring;
+}
+
+void ring_buffer_destroy(RingBuffer *ring) {
+    if (!ring) return;
+
+    realtime_unregister_buffer(ring->data);
+    free(ring->data);
+    free(ring);
+}
+
+size_t ring_buffer_read_available(RingBuffer *ring) {
+    size_t write = atomic_load_explicit(&ring->write_pos, memory_order_acquire);
+    return write - consumer_position(ring);
+}
+
+size_t ring_buffer_write_available(RingBuffer *ring) {
+    size_t write = atomic_load_explicit(&ring->write_pos, memory_order_relaxed);
+    return ring->capacity - (write - consumer_position(ring));
+}
+
+size_t ring_buffer_write(RingBuffer *ring, const float *samples, size_t count) {
+    size_t available = ring_buffer_write_available(ring);
+    if (count > available) count = available;
+    if (count == 0) return 0;
+
+    size_t write = atomic_load_explicit(&ring->write_pos, memory_order_relaxed);
+    size_t offset = write & ring->mask;
+    size_t first = ring->capacity - offset;
+    if (first > count) first = count;
+
+    memcpy(ring->data + offset, samples, first * sizeof(float));
+    if (count > first) {
+        memcpy(ring->data, samples + first, (count - first) * sizeof(float));
+    }
+
+    atomic_store_explicit(&ring->write_pos, write + count, memory_order_release);
+    return count;
+}
+
+size_t ring_buffer_write_region(RingBuffer *ring, float **region) {
+    size_t available = ring_buffer_write_available(ring);
+    size_t write = atomic_load_explicit(&ring->write_pos, memory_order_relaxed);
+    size_t offset = write & ring->mask;
+    size_t contiguous = ring->capacity - offset;
+
+    *region = ring->data + offset;
+    return contiguous < available ? contiguous : available;
+}
+
+void ring_buffer_commit(RingBuffer *ring, size_t count) {
+    size_t write = atomic_load_explicit(&ring->write_pos, memory_order_relaxed);
+    atomic_store_explicit(&ring->write_pos, write + count, memory_order_release);
+}
+
+size_t ring_buffer_read(RingBuffer *ring, float *samples, size_t count) {
+    size_t read = consumer_position(ring);
+    size_t write = atomic_load_explicit(&ring->write_pos, memory_order_acquire);
+    size_t available = write - read;
+    if (count > available) count = available;
+
+    if (count > 0) {
+        size_t offset = read & ring->mask;
+        size_t first = ring->capacity - offset;
+        if (first > count) first = count;
+
+        memcpy(samples, ring->data + offset, first * sizeof(float));
+        if (count > first) {
+            memcpy(samples + first, ring->data, (count - first) * sizeof(float));
+        }
+    }
+
+    atomic_store_explicit(&ring->read_pos, read + count, memory_order_release);
+    return count;
+}
+
+void ring_buffer_flush(RingBuffer *ring) {
+    size_t write = atomic_load_explicit(&ring->write_pos, memory_order_relaxed);
+    atomic_store_explicit(&ring->flush_pos, write, memory_order_release);
+}
@@ -0,0 +1,541 @@
+#include "core/search_index.h"
+#include "core/trace.h"
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SEARCH_INITIAL_SLOTS 4096
+#define SEARCH_FIELD_SEPARATOR '\x1f'
+#define SEARCH_FIELD_MAX 256
+#define SEARCH_SKIP_INTERVAL 64     // postings per block a skip entry can jump to
+#define SEARCH_TITLE_SCORE 30
+#define SEARCH_WORD_START_SCORE 8
+#define SEARCH_WHOLE_WORD_SCORE 4
+#define SEARCH_BEST_TERM_SCORE (SEARCH_TITLE_SCORE + SEARCH_WORD_START_SCORE + SEARCH_WHOLE_WORD_SCORE)
+#define SEARCH_PREFIX_KEY 0x01000000u   // above every trigram: word prefixes of one or two bytes
+#define SEARCH_QUERY_CHUNK 1024         // candidates decoded and intersected at a time
+
+typedef struct {
+    uint32_t base;          // id before the block, its deltas start from here
+    uint32_t offset;        // byte where the block starts
+} SkipEntry;
+
+typedef struct {
+    uint32_t key;           // three normalized bytes or a word prefix, never 0; 0 marks an empty slot
+    uint32_t last;          // last id added: the base of the next delta
+    uint32_t count;
+    uint32_t length;
+    uint32_t capacity;
+    uint32_t skip_capacity;
+    uint8_t *bytes;         // varint deltas, the first from 0
+    SkipEntry *skips;       // one per block, so intersections skip what cannot match
+} PostingList;
+
+typedef struct {
+    uint32_t id;
+    int score;
+} SearchHit;
+
+struct SearchIndex {
+    PostingList *slots;
+    size_t slot_count;      // power of two
+    size_t trigrams;
+    size_t postings;
+
+    char *text;             // normalized entries, each "title\x1fartist\x1falbum\0"
+    size_t text_length;
+    size_t text_capacity;
+    uint32_t *offsets;      // entry start in text
+    size_t entries;
+    size_t entry_capacity;
+
+    uint32_t *candidates;
+    size_t candidate_capacity;
+    SearchHit *heap;
+    size_t heap_capacity;
+};
+
+SearchIndex *search_index_create(void) {
+    SearchIndex *index = calloc(1, sizeof(SearchIndex));
+    if (!index) return NULL;
+
+    index->slots = calloc(SEARCH_INITIAL_SLOTS, sizeof(PostingList));
+    if (!index->slots) {
+        free(index);
+        return NULL;
+    }
+    index->slot_count = SEARCH_INITIAL_SLOTS;
+    return index;
+}
+
+void search_index_clear(SearchIndex *index) {
+    if (!index) return;
+
+    for (size_t i = 0; i < index->slot_count; i++) {
+        free(index->slots[i].bytes);
+        free(index->slots[i].skips);
+    }
+    memset(index->slots, 0, index->slot_count * sizeof(PostingList));
+    index->trigrams = 0;
+    index->postings = 0;
+    index->text_length = 0;
+    index->entries = 0;
+}
+
+void search_index_destroy(SearchIndex *index) {
+    if (!index) return;
+
+    search_index_clear(index);
+    free(index->slots);
+    free(index->text);
+    free(index->offsets);
+    free(index->candidates);
+    free(index->heap);
+    free(index);
+}
+
+static size_t slot_of(const SearchIndex *index, uint32_t key) {
+    return (size_t)(((uint64_t)key * 0x9E3779B97F4A7C15ull) >> 40) & (index->slot_count - 1);
+}
+
+static PostingList *find_list(const SearchIndex *index, uint32_t key) {
+    for (size_t i = slot_of(index, key);; i = (i + 1) & (index->slot_count - 1)) {
+        PostingList *list = &index->slots[i];
+        if (list->key == key) return list;
+        if (list->key == 0) return NULL;
+    }
+}
+
+static int grow_slots(SearchIndex *index) {
+    PostingList *old_slots = index->slots;
+    size_t old_count = index->slot_count;
+
+    index->slots = calloc(old_count * 2, sizeof(PostingList));
+    if (!index->slots) {
+        index->slots = old_slots;
+        return -1;
+    }
+    index->slot_count = old_count * 2;
+
+    for (size_t i = 0; i < old_count; i++) {
+        if (old_slots[i].key == 0) continue;
+        size_t slot = slot_of(index, old_slots[i].key);
+        while (index->slots[slot].key != 0) slot = (slot + 1) & (index->slot_count - 1);
+        index->slots[slot] = old_slots[i];
+    }
+    free(old_slots);
+    return 0;
+}
+
+static PostingList *claim_list(SearchIndex *index, uint32_t key) {
+    // kept under 70% full so probe runs stay short
+    if ((index->trigrams + 1) * 10 > index->slot_count * 7 && grow_slots(index) != 0) return NULL;
+
+    size_t slot = slot_of(index, key);
+    while (index->slots[slot].key != 0 && index->slots[slot].key != key) {
+        slot = (slot + 1) & (index->slot_count - 1);
+    }
+    PostingList *list = &index->slots[slot];
+    if (list->key == 0) {
+        list->key = key;
+        index->trigrams++;
+    }
+    return list;
+}
+
+static int add_posting(SearchIndex *index, uint32_t key, uint32_t id) {
+    PostingList *list = find_list(index, key);
+    if (list && list->count > 0 && list->last == id) return 0;
+    if (!list) {
+        list = claim_list(index, key);
+        if (!list) return -1;
+    }
+
+    if (list->length + 5 > list->capacity) {
+        uint32_t capacity = list->capacity ? list->capacity * 2 : 8;
+        uint8_t *bytes = realloc(list->bytes, capacity);
+        if (!bytes) return -1;
+        list->bytes = bytes;
+        list->capacity = capacity;
+    }
+
+    if (list->count % SEARCH_SKIP_INTERVAL == 0) {
+        uint32_t block = list->count / SEARCH_SKIP_INTERVAL;
+        if (block == list->skip_capacity) {
+            uint32_t capacity = list->skip_capacity ? list->skip_capacity * 2 : 1;
+            SkipEntry *skips = realloc(list->skips, capacity * sizeof(SkipEntry));
+            if (!skips) return -1;
+            list->skips = skips;
+            list->skip_capacity = capacity;
+        }
+        list->skips[block] = (SkipEntry){ list->last, list->length };
+    }
+
+    uint32_t delta = id - list->last;
+    while (delta >= 0x80) {
+        list->bytes[list->length++] = (uint8_t)(delta | 0x80);
+        delta >>= 7;
+    }
+    list->bytes[list->length++] = (uint8_t)delta;
+    list->last = id;
+    list->count++;
+    index->postings++;
+    return 0;
+}
+
+static uint32_t read_varint(const uint8_t **p) {
+    uint32_t value = 0;
+    int shift = 0;
+    while (**p & 0x80) {
+        value |= (uint32_t)(*(*p)++ & 0x7f) << shift;
+        shift += 7;
+    }
+    value |= (uint32_t)*(*p)++ << shift;
+    return value;
+}
+
+// lower-case ASCII letters and digits; punctuation and spaces become one space
+static size_t normalize(const char *source, size_t length, char *out, size_t capacity) {
+    size_t written = 0;
+    bool space = true;
+    for (size_t i = 0; i < length && written + 1 < capacity; i++) {
+        unsigned char c = (unsigned char)source[i];
+        if (c >= 'A' && c <= 'Z') c = (unsigned char)(c - 'A' + 'a');
+        bool word = (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c >= 0x80;
+        if (word) {
+            out[written++] = (char)c;
+            space = false;
+        } else if (!space) {
+            out[written++] = ' ';
+            space = true;
+        }
+    }
+    if (written > 0 && out[written - 1] == ' ') written--;
+    out[written] = '\0';
+    return written;
+}
+
+static bool is_boundary(char c) {
+    return c == ' ' || c == SEARCH_FIELD_SEPARATOR || c == '\0';
+}
+
+static uint32_t prefix_key(const char *word, size_t length) {
+    uint32_t key = SEARCH_PREFIX_KEY | (uint32_t)(unsigned char)word[0] << 8;
+    return length > 1 ? key | (uint32_t)(unsigned char)word[1] : key;
+}
+
+static int reserve_text(SearchIndex *index, size_t length) {
+    if (index->text_length + length <= index->text_capacity) return 0;
+
+    size_t capacity = index->text_capacity ? index->text_capacity : 4096;
+    while (capacity < index->text_length + length) capacity *= 2;
+    char *text = realloc(index->text, capacity);
+    if (!text) return -1;
+    index->text = text;
+    index->text_capacity = capacity;
+    return 0;
+}
+
+int search_index_add(SearchIndex *index, const char *title, const char *artist, const char *album) {
+    if (!index || index->entries >= UINT32_MAX) return -1;
+
+    if (index->entries == index->entry_capacity) {
+        size_t capacity = index->entry_capacity ? index->entry_capacity * 2 : 1024;
+        uint32_t *offsets = realloc(index->offsets, capacity * sizeof(uint32_t));
+        if (!offsets) return -1;
+        index->offsets = offsets;
+        index->entry_capacity = capacity;
+    }
+    if (index->text_length > UINT32_MAX - 3 * SEARCH_FIELD_MAX || reserve_text(index, 3 * SEARCH_FIELD_MAX) != 0) {
+        return -1;
+    }
+
+    size_t start = index->text_length;
+    const char *fields[3] = { title, artist, album };
+    char *out = index->text + start;
+    size_t length = 0;
+    for (int f = 0; f < 3; f++) {
+        if (f > 0) out[length++] = SEARCH_FIELD_SEPARATOR;
+        const char *field = fields[f] ? fields[f] : "";
+        length += normalize(field, strlen(field), out + length, SEARCH_FIELD_MAX - 1);
+    }
+    out[length] = '\0';
+
+    uint32_t id = (uint32_t)index->entries;
+    for (size_t i = 0; i + 2 < length; i++) {
+        if (is_boundary(out[i]) || is_boundary(out[i + 1]) || is_boundary(out[i + 2])) continue;
+        uint32_t key = (uint32_t)(unsigned char)out[i] << 16 | (uint32_t)(unsigned char)out[i + 1] << 8 |
+                       (uint32_t)(unsigned char)out[i + 2];
+        if (add_posting(index, key, id) != 0) return -1;
+    }
+    // the first one and two bytes of every word, for query words too short for a trigram
+    for (size_t i = 0; i < length; i++) {
+        if (is_boundary(out[i]) || (i > 0 && !is_boundary(out[i - 1]))) continue;
+        if (add_posting(index, prefix_key(out + i, 1), id) != 0) return -1;
+        if (!is_boundary(out[i + 1]) && add_posting(index, prefix_key(out + i, 2), id) != 0) return -1;
+    }
+
+    index->offsets[index->entries++] = (uint32_t)start;
+    index->text_length = start + length + 1;
+    return 0;
+}
+
+// copies the last path component ending before end, returns where it starts
+static const char *previous_component(const char *path, const char *end, char *out) {
+    while (end > path && end[-1] == '/') end--;
+    const char *start = end;
+    while (start > path && start[-1] != '/') start--;
+
+    size_t length = (size_t)(end - start);
+    if (length >= SEARCH_FIELD_MAX) length = SEARCH_FIELD_MAX - 1;
+    memcpy(out, start, length);
+    out[length] = '\0';
+    return start;
+}
+
+int search_index_add_path(SearchIndex *index, const char *path) {
+    if (!index || !path) return -1;
+
+    char title[SEARCH_FIELD_MAX], album[SEARCH_FIELD_MAX], artist[SEARCH_FIELD_MAX];
+    const char *start = previous_component(path, path + strlen(path), title);
+    char *extension = strrchr(title, '.');
+    if (extension && extension != title) *extension = '\0';
+
+    start = previous_component(path, start, album);
+    previous_component(path, start, artist);
+    return search_index_add(index, title, artist, album);
+}
+
+size_t search_index_count(SearchIndex *index) {
+    return index ? index->entries : 0;
+}
+
+static int reserve_candidates(SearchIndex *index, size_t count) {
+    if (count <= index->candidate_capacity) return 0;
+
+    uint32_t *candidates = realloc(index->candidates, count * sizeof(uint32_t));
+    if (!candidates) return -1;
+    index->candidates = candidates;
+    index->candidate_capacity = count;
+    return 0;
+}
+
+// keeps the candidates that are also in the list; both are ascending. Blocks that end
+// before the next candidate are jumped over instead of decoded.
+static size_t intersect(uint32_t *candidates, size_t count, const PostingList *list) {
+    const uint8_t *p = list->bytes;
+    const uint8_t *end = p + list->length;
+    size_t blocks = (list->count + SEARCH_SKIP_INTERVAL - 1) / SEARCH_SKIP_INTERVAL;
+    size_t block = 0;
+    uint32_t id = 0;
+    bool decoded = false;   // id is a posting rather than a block base
+    size_t kept = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        uint32_t target = candidates[i];
+        if (!decoded || id < target) {
+            // last block starting before target; queries intersect a chunk at a time, so
+            // each call starts from the front of the list
+            size_t next = block, last = blocks - 1;
+            while (next < last) {
+                size_t middle = next + (last - next + 1) / 2;
+                if (list->skips[middle].base < target) next = middle;
+                else last = middle - 1;
+            }
+            if (list->skips[next].offset > (size_t)(p - list->bytes)) {
+                p = list->bytes + list->skips[next].offset;
+                id = list->skips[next].base;
+                decoded = false;
+            }
+            block = next;
+            while (!decoded || id < target) {
+                if (p >= end) return kept;
+                id += read_varint(&p);
+                decoded = true;
+            }
+        }
+        if (id == target) candidates[kept++] = target;
+    }
+    return kept;
+}
+
+static int compare_lists(const void *a, const void *b) {
+    const PostingList *la = *(const PostingList *const *)a;
+    const PostingList *lb = *(const PostingList *const *)b;
+    return (la->count > lb->count) - (la->count < lb->count);
+}
+
+// match quality first, then shorter entries
+static int pack_score(int score, size_t length) {
+    return score * 256 - (int)(length < 255 ? length : 255);
+}
+
+// 0 when a term is missing
+static int score_entry(const char *text, size_t length, char terms[][SEARCH_FIELD_MAX], int term_count) {
+    static const int field_weight[3] = { SEARCH_TITLE_SCORE, 20, 10 };
+    const char *artist = strchr(text, SEARCH_FIELD_SEPARATOR);
+    const char *album = artist ? strchr(artist + 1, SEARCH_FIELD_SEPARATOR) : NULL;
+    int score = 0;
+
+    for (int t = 0; t < term_count; t++) {
+        size_t term_length = strlen(terms[t]);
+        int best = 0;
+        for (const char *hit = strstr(text, terms[t]); hit; hit = strstr(hit + 1, terms[t])) {
+            int field = !artist || hit < artist ? 0 : !album || hit < album ? 1 : 2;
+            int value = field_weight[field];
+            if (hit == text || is_boundary(hit[-1])) {
+                value += SEARCH_WORD_START_SCORE;
+                if (is_boundary(hit[term_length])) value += SEARCH_WHOLE_WORD_SCORE;
+            } else if (term_length < 3) {
+                continue;       // short words only match where a word starts
+            }
+            if (value > best) best = value;
+        }
+        if (best == 0) return 0;
+        score += best;
+    }
+    return pack_score(score, length);
+}
+
+static bool hit_better(const SearchHit *a, const SearchHit *b) {
+    return a->score > b->score || (a->score == b->score && a->id < b->id);
+}
+
+// min-heap on hit_better: the root is the worst hit kept
+static void sift_down(SearchHit *heap, size_t count, size_t i) {
+    for (;;) {
+        size_t worst = i;
+        size_t left = 2 * i + 1;
+        size_t right = left + 1;
+        if (left < count && hit_better(&heap[worst], &heap[left])) worst = left;
+        if (right < count && hit_better(&heap[worst], &heap[right])) worst = right;
+        if (worst == i) return;
+        SearchHit swap = heap[i];
+        heap[i] = heap[worst];
+        heap[worst] = swap;
+        i = worst;
+    }
+}
+
+static void sift_up(SearchHit *heap, size_t i) {
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (!hit_better(&heap[parent], &heap[i])) return;
+        SearchHit swap = heap[i];
+        heap[i] = heap[parent];
+        heap[parent] = swap;
+        i = parent;
+    }
+}
+
+int search_index_query(SearchIndex *index, const char *query, int *results, int max_results) {
+    if (!index || !query || !results || max_results <= 0) return 0;
+    TRACE_SCOPE("search_index_query");
+
+    char normalized[SEARCH_FIELD_MAX];
+    normalize(query, strlen(query), normalized, sizeof(normalized));
+
+    char terms[SEARCH_INDEX_MAX_TERMS][SEARCH_FIELD_MAX];
+    int term_count = 0;
+    char *save = NULL;
+    for (char *word = strtok_r(normalized, " ", &save); word && term_count < SEARCH_INDEX_MAX_TERMS;
+         word = strtok_r(NULL, " ", &save)) {
+        strcpy(terms[term_count++], word);
+    }
+    if (term_count == 0 || index->entries == 0) return 0;
+
+    // every trigram of every term, or the word prefix of a short one; a list no entry has
+    // means no match at all
+    const PostingList *lists[SEARCH_INDEX_MAX_TERMS * SEARCH_FIELD_MAX];
+    int list_count = 0;
+    for (int t = 0; t < term_count; t++) {
+        size_t term_length = strlen(terms[t]);
+        for (size_t i = 0; i == 0 || i + 2 < term_length; i++) {
+            uint32_t key = term_length < 3 ? prefix_key(terms[t], term_length)
+                                           : (uint32_t)(unsigned char)terms[t][i] << 16 |
+                                             (uint32_t)(unsigned char)terms[t][i + 1] << 8 |
+                                             (uint32_t)(unsigned char)terms[t][i + 2];
+            const PostingList *list = find_list(index, key);
+            if (!list) return 0;
+
+            bool seen = false;
+            for (int l = 0; l < list_count && !seen; l++) seen = lists[l] == list;
+            if (!seen) lists[list_count++] = list;
+        }
+    }
+    qsort(lists, (size_t)list_count, sizeof(lists[0]), compare_lists);
+
+    if (reserve_candidates(index, SEARCH_QUERY_CHUNK) != 0) return -1;
+    if ((size_t)max_results > index->heap_capacity) {
+        SearchHit *heap = realloc(index->heap, (size_t)max_results * sizeof(SearchHit));
+        if (!heap) return -1;
+        index->heap = heap;
+        index->heap_capacity = (size_t)max_results;
+    }
+
+    // the rarest list is walked a chunk at a time, so a broad query stops once the results
+    // are full and SEARCH_INDEX_SCAN_LIMIT candidates have been scored
+    const uint8_t *p = lists[0]->bytes;
+    uint32_t id = 0;
+    size_t decoded = 0;
+    size_t scored = 0;
+    size_t kept = 0;
+    while (decoded < lists[0]->count && (kept < (size_t)max_results || scored < SEARCH_INDEX_SCAN_LIMIT)) {
+        size_t count = 0;
+        for (; count < SEARCH_QUERY_CHUNK && decoded < lists[0]->count; count++, decoded++) {
+            id += read_varint(&p);
+            index->candidates[count] = id;
+        }
+        for (int l = 1; l < list_count && count > 0; l++) {
+            count = intersect(index->candidates, count, lists[l]);
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            uint32_t candidate = index->candidates[i];
+            size_t end = candidate + 1 < index->entries ? index->offsets[candidate + 1] : index->text_length;
+            size_t length = end - index->offsets[candidate] - 1;
+
+            // with the results full, an entry that could not win even with its best score is
+            // not searched at all; broad queries mostly end here once short exact titles are in
+            SearchHit hit = { candidate, pack_score(term_count * SEARCH_BEST_TERM_SCORE, length) };
+            if (kept == (size_t)max_results && !hit_better(&hit, &index->heap[0])) continue;
+
+            scored++;
+            hit.score = score_entry(index->text + index->offsets[candidate], length, terms, term_count);
+            if (hit.score == 0) continue;
+
+            if (kept < (size_t)max_results) {
+                index->heap[kept] = hit;
+                sift_up(index->heap, kept++);
+            } else if (hit_better(&hit, &index->heap[0])) {
+                index->heap[0] = hit;
+                sift_down(index->heap, kept, 0);
+            }
+        }
+    }
+
+    // popping the worst into the back leaves the best first
+    for (size_t n = kept; n > 0; n--) {
+        SearchHit worst = index->heap[0];
+        index->heap[0] = index->heap[n - 1];
+        sift_down(index->heap, n - 1, 0);
+        results[n - 1] = (int)worst.id;
+    }
+    return (int)kept;
+}
+
+void search_index_get_stats(SearchIndex *index, SearchIndexStats *stats) {
+    if (!stats) return;
+    memset(stats, 0, sizeof(SearchIndexStats));
+    if (!index) return;
+
+    stats->entries = index->entries;
+    stats->trigrams = index->trigrams;
+    stats->postings = index->postings;
+    stats->memory_bytes = sizeof(SearchIndex) + index->slot_count * sizeof(PostingList) + index->text_capacity +
+                          index->entry_capacity * sizeof(uint32_t) +
+                          index->candidate_capacity * sizeof(uint32_t) + index->heap_capacity * sizeof(SearchHit);
+    for (size_t i = 0; i < index->slot_count; i++) {
+        stats->memory_bytes += index->slots[i].capacity + index->slots[i].skip_capacity * sizeof(SkipEntry);
+    }
+}
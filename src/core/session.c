@@ -0,0 +1,259 @@
+#include "core/session.h"
+#include "core/trace.h"
+#include "core/log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <libgen.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define SESSION_MAGIC "RSES"
+#define SESSION_VERSION 1
+#define SESSION_PLAYING 1u
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t count;
+    int32_t current_index;
+    int32_t order_position;     // -1 when not shuffled
+    uint32_t flags;
+    float volume;
+    uint32_t reserved;
+    int64_t position_frames;
+    uint64_t order_offset;      // int32 per entry, 0 when not shuffled
+    uint64_t paths_offset;      // uint64 per entry, relative to strings_offset
+    uint64_t strings_offset;
+    uint64_t strings_size;
+    uint64_t file_size;
+} SessionHeader;
+
+int session_default_path(char *buffer, size_t size) {
+    const char *override = getenv("RHYTHM_SESSION");
+    if (override && *override) {
+        snprintf(buffer, size, "%s", override);
+        return 0;
+    }
+
+    const char *xdg = getenv("XDG_STATE_HOME");
+    if (xdg && *xdg) {
+        snprintf(buffer, size, "%s/rhythm/session", xdg);
+        return 0;
+    }
+
+    const char *home = getenv("HOME");
+    if (!home || !*home) return -1;
+    snprintf(buffer, size, "%s/.local/state/rhythm/session", home);
+    return 0;
+}
+
+static void make_parent_dirs(const char *path) {
+    char buffer[4096];
+    snprintf(buffer, sizeof(buffer), "%s", path);
+    for (char *p = buffer + 1; *p; p++) {
+        if (*p == '/') {
+            *p = '\0';
+            mkdir(buffer, 0755);
+            *p = '/';
+        }
+    }
+}
+
+static bool header_valid(const SessionHeader *header, uint64_t file_size) {
+    if (memcmp(header->magic, SESSION_MAGIC, 4) != 0 || header->version != SESSION_VERSION) return false;
+    if (header->file_size != file_size || header->count > INT32_MAX) return false;
+    if (header->order_offset > file_size || header->paths_offset > file_size || header->strings_offset > file_size) {
+        return false;
+    }
+
+    uint64_t count = header->count;
+    if (header->order_offset != 0 &&
+        (header->order_offset % 4 != 0 || header->order_offset + count * 4 > header->paths_offset)) {
+        return false;
+    }
+    return header->paths_offset >= sizeof(SessionHeader) && header->paths_offset % 8 == 0 &&
+           header->paths_offset + count * 8 <= header->strings_offset &&
+           header->strings_offset + header->strings_size == file_size &&
+           (count == 0 || header->strings_size > 0);
+}
+
+static void fill_header(SessionHeader *header, Playlist *playlist, const SessionState *state) {
+    memcpy(header->magic, SESSION_MAGIC, 4);
+    header->version = SESSION_VERSION;
+    header->count = (uint32_t)playlist->count;
+    header->current_index = state->current_index;
+    header->order_position = playlist->order ? playlist->order_position : -1;
+    header->flags = state->playing ? SESSION_PLAYING : 0;
+    header->volume = state->volume;
+    header->position_frames = state->position_frames;
+}
+
+static bool write_all(int fd, const void *data, size_t size, off_t offset) {
+    const char *p = data;
+    while (size > 0) {
+        ssize_t written = pwrite(fd, p, size, offset);
+        if (written <= 0) return false;
+        p += written;
+        size -= (size_t)written;
+        offset += written;
+    }
+    return true;
+}
+
+// the snapshot at path already holds the playlist, so only its header is rewritten in
+// place. Not atomic: a crash mid-write can leave the old offsets and count with a mix of
+// old and new index, position and volume, which still validates.
+static bool rewrite_header(const char *path, Playlist *playlist, const SessionState *state) {
+    int fd = open(path, O_RDWR);
+    if (fd < 0) return false;
+
+    SessionHeader header;
+    struct stat st;
+    bool ok = fstat(fd, &st) == 0 && pread(fd, &header, sizeof(header), 0) == sizeof(header) &&
+              header_valid(&header, (uint64_t)st.st_size) && header.count == (uint32_t)playlist->count &&
+              (header.order_offset != 0) == (playlist->order != NULL);
+    if (ok) {
+        fill_header(&header, playlist, state);
+        ok = write_all(fd, &header, sizeof(header), 0) && fdatasync(fd) == 0;
+    }
+    close(fd);
+    return ok;
+}
+
+static bool write_full(int fd, Playlist *playlist, const SessionState *state) {
+    SessionHeader header;
+    memset(&header, 0, sizeof(header));
+    fill_header(&header, playlist, state);
+
+    uint64_t count = (uint64_t)playlist->count;
+    uint64_t offset = sizeof(SessionHeader);
+    if (playlist->order) {
+        header.order_offset = offset;
+        offset += count * 4;
+    }
+    header.paths_offset = (offset + 7) & ~(uint64_t)7;
+    header.strings_offset = header.paths_offset + count * 8;
+
+    uint64_t *paths = malloc(count ? count * 8 : 1);
+    if (!paths) return false;
+    uint64_t strings_size = 0;
+    for (int i = 0; i < playlist->count; i++) {
+        paths[i] = strings_size;
+        strings_size += strlen(playlist->files[i]) + 1;
+    }
+    header.strings_size = strings_size;
+    header.file_size = header.strings_offset + strings_size;
+
+    FILE *file = fdopen(dup(fd), "wb");
+    if (!file) {
+        free(paths);
+        return false;
+    }
+    static const char padding[8];
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              (!playlist->order || fwrite(playlist->order, 4, (size_t)count, file) == count) &&
+              fwrite(padding, 1, header.paths_offset - offset, file) == header.paths_offset - offset &&
+              fwrite(paths, 8, (size_t)count, file) == count;
+    for (int i = 0; ok && i < playlist->count; i++) {
+        size_t length = strlen(playlist->files[i]) + 1;
+        ok = fwrite(playlist->files[i], 1, length, file) == length;
+    }
+    free(paths);
+    return fclose(file) == 0 && ok;
+}
+
+int session_save(const char *path, Playlist *playlist, const SessionState *state, bool playlist_unchanged) {
+    if (!path || !playlist || !state) return -1;
+    TRACE_SCOPE("session_save");
+
+    // the periodic save of a position is a few bytes, not the whole library again
+    if (playlist_unchanged && rewrite_header(path, playlist, state)) return 0;
+
+    char temp_path[4096];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", path);
+    make_parent_dirs(path);
+
+    int fd = open(temp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        LOG_ERROR("Cannot write session %s", temp_path);
+        return -1;
+    }
+
+    bool ok = write_full(fd, playlist, state);
+    // durable before it replaces the old snapshot, or a crash could leave neither
+    ok = ok && fsync(fd) == 0;
+    if (close(fd) != 0 || !ok || rename(temp_path, path) != 0) {
+        remove(temp_path);
+        return -1;
+    }
+
+    char dir_path[4096];
+    snprintf(dir_path, sizeof(dir_path), "%s", path);
+    int dir_fd = open(dirname(dir_path), O_RDONLY | O_DIRECTORY);
+    if (dir_fd >= 0) {
+        fsync(dir_fd);
+        close(dir_fd);
+    }
+    return 0;
+}
+
+int session_restore(const char *path, Playlist *playlist, SessionState *state) {
+    if (!path || !playlist || !state) return -1;
+    TRACE_SCOPE("session_restore");
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(SessionHeader)) {
+        close(fd);
+        return -1;
+    }
+    void *mapping = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) return -1;
+
+    const SessionHeader *header = mapping;
+    const char *base = mapping;
+    const char *strings = base + header->strings_offset;
+    if (!header_valid(header, (uint64_t)st.st_size) || (header->count > 0 && strings[header->strings_size - 1] != '\0')) {
+        LOG_WARN("Session %s is damaged, ignoring it", path);
+        munmap(mapping, (size_t)st.st_size);
+        return -1;
+    }
+
+    int count = (int)header->count;
+    const uint64_t *paths = (const uint64_t *)(base + header->paths_offset);
+    playlist_clear(playlist);
+    if (playlist_reserve(playlist, count) != 0) {
+        munmap(mapping, (size_t)st.st_size);
+        return -1;
+    }
+    playlist_adopt_mapping(playlist, mapping, (size_t)st.st_size);
+
+    // the offsets are the only part read here; paths stay unread until an entry is used
+    for (int i = 0; i < count; i++) {
+        if (paths[i] >= header->strings_size || playlist_add_mapped(playlist, strings + paths[i]) != 0) {
+            LOG_WARN("Session %s is damaged, ignoring it", path);
+            playlist_clear(playlist);
+            return -1;
+        }
+    }
+
+    if (header->order_offset != 0 && count > 0) {
+        if (playlist_set_order(playlist, (const int *)(base + header->order_offset), header->order_position) != 0) {
+            // a bad order only loses the shuffle, not the session
+            playlist_set_shuffle(playlist, false, 0);
+        }
+    }
+    playlist_set_current(playlist, header->current_index);
+
+    state->current_index = playlist->current_index;
+    state->position_frames = header->position_frames;
+    state->volume = header->volume;
+    state->playing = (header->flags & SESSION_PLAYING) != 0;
+    return 0;
+}
@@ -0,0 +1,322 @@
+#include "core/decoder.h"
+#include "core/stream_source.h"
+#include "core/trace.h"
+#include "core/log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <mpg123.h>
+
+#define STREAM_FEED_BYTES 16384
+#define STREAM_PROBE_BYTES (1 << 20)    // ID3 tags with artwork come before the first frame
+#define STREAM_WAV_FMT_MAX 64
+
+typedef enum {
+    STREAM_FORMAT_NONE,
+    STREAM_FORMAT_MP3,
+    STREAM_FORMAT_WAV
+} StreamFormat;
+
+typedef struct {
+    Decoder base;
+    StreamSource *source;
+    mpg123_handle *mh;
+    StreamFormat format;
+    const char *error;
+    float queued_ms;
+
+    // MP3: the byte rate comes from what went in against what came out
+    unsigned char feed[STREAM_FEED_BYTES];
+    uint64_t bytes_fed;
+    uint64_t frames_decoded;
+    uint64_t rate_update_frames;
+
+    // WAV: raw samples are taken whole frames at a time and converted here
+    WavFormat wav;
+    long long data_left;        // -1 when the writer left the data size open
+    unsigned char *scratch;
+    size_t scratch_size;
+} StreamDecoder;
+
+static uint32_t read_u32(const unsigned char *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void stream_decoder_close(Decoder *decoder) {
+    StreamDecoder *stream = (StreamDecoder *)decoder;
+    stream_source_close(stream->source);
+    if (stream->format == STREAM_FORMAT_MP3) {
+        mpg123_close(stream->mh);
+    }
+    stream->format = STREAM_FORMAT_NONE;
+}
+
+static int fail(StreamDecoder *stream, const char *error) {
+    stream->error = error;
+    LOG_ERROR("Failed to open stream: %s", error);
+    stream_decoder_close(&stream->base);
+    return -1;
+}
+
+// headers arrive in pieces; each wait gets the full open timeout
+static int read_exact(StreamDecoder *stream, unsigned char *out, size_t size) {
+    while (size > 0) {
+        size_t got = stream_source_read(stream->source, out, size, STREAM_OPEN_TIMEOUT_MS);
+        if (got == 0) return -1;
+        out += got;
+        size -= got;
+    }
+    return 0;
+}
+
+static int skip_bytes(StreamDecoder *stream, size_t size) {
+    while (size > 0) {
+        size_t run = size < sizeof(stream->feed) ? size : sizeof(stream->feed);
+        if (read_exact(stream, stream->feed, run) != 0) return -1;
+        size -= run;
+    }
+    return 0;
+}
+
+static int open_wav(StreamDecoder *stream) {
+    unsigned char fmt[STREAM_WAV_FMT_MAX];
+    size_t fmt_size = 0;
+
+    for (;;) {
+        unsigned char chunk[8];
+        if (read_exact(stream, chunk, sizeof(chunk)) != 0) return fail(stream, "missing fmt or data chunk");
+        uint32_t size = read_u32(chunk + 4);
+
+        if (memcmp(chunk, "data", 4) == 0) {
+            // live writers leave the size at 0 or all ones
+            stream->data_left = size == 0 || size == 0xFFFFFFFFu ? -1 : (long long)size;
+            break;
+        }
+
+        size_t body = size + (size & 1);
+        if (memcmp(chunk, "fmt ", 4) == 0) {
+            fmt_size = size < sizeof(fmt) ? size : sizeof(fmt);
+            if (read_exact(stream, fmt, fmt_size) != 0) return fail(stream, "truncated fmt chunk");
+            body -= fmt_size;
+        }
+        if (skip_bytes(stream, body) != 0) return fail(stream, "missing fmt or data chunk");
+    }
+
+    const char *error = fmt_size > 0 ? wav_parse_format(fmt, fmt_size, &stream->wav) : "missing fmt or data chunk";
+    if (error) return fail(stream, error);
+
+    stream->format = STREAM_FORMAT_WAV;
+    stream->base.rate = stream->wav.rate;
+    stream->base.channels = stream->wav.channels;
+    stream_source_set_rate(stream->source, (double)stream->wav.rate * stream->wav.block_align,
+                           (size_t)stream->wav.block_align);
+    return 0;
+}
+
+static int open_mp3(StreamDecoder *stream, const unsigned char *head, size_t head_size) {
+    if (mpg123_open_feed(stream->mh) != MPG123_OK) return fail(stream, "cannot start mpg123 feed");
+    stream->format = STREAM_FORMAT_MP3;
+
+    // feed until the first frame header has been parsed; nothing decoded is lost
+    mpg123_feed(stream->mh, head, head_size);
+    stream->bytes_fed = head_size;
+    for (;;) {
+        size_t done = 0;
+        int err = mpg123_read(stream->mh, stream->feed, 0, &done);
+        if (err == MPG123_NEW_FORMAT) break;
+        if (err != MPG123_NEED_MORE && err != MPG123_OK) return fail(stream, "not an MPEG audio stream");
+        if (stream->bytes_fed >= STREAM_PROBE_BYTES) return fail(stream, "no MPEG frame found");
+
+        size_t got = stream_source_read(stream->source, stream->feed, sizeof(stream->feed), STREAM_OPEN_TIMEOUT_MS);
+        if (got == 0) return fail(stream, "no MPEG frame found");
+        mpg123_feed(stream->mh, stream->feed, got);
+        stream->bytes_fed += got;
+    }
+
+    int channels, encoding;
+    long rate;
+    if (mpg123_getformat(stream->mh, &rate, &channels, &encoding) != MPG123_OK) {
+        return fail(stream, "cannot read the stream format");
+    }
+    stream->base.rate = rate;
+    stream->base.channels = channels;
+    return 0;
+}
+
+static int stream_decoder_open(Decoder *decoder, const char *path) {
+    StreamDecoder *stream = (StreamDecoder *)decoder;
+    stream_decoder_close(decoder);
+    stream->error = NULL;
+    stream->queued_ms = 0.0f;
+    stream->bytes_fed = 0;
+    stream->frames_decoded = 0;
+    stream->rate_update_frames = 0;
+
+    TRACE_BEGIN(open_span, "stream_open");
+    if (stream_source_open(stream->source, path) != 0) {
+        TRACE_END(open_span);
+        stream->error = "cannot open stream";
+        return -1;
+    }
+
+    unsigned char head[12];
+    int result;
+    if (read_exact(stream, head, sizeof(head)) != 0) {
+        result = fail(stream, "no data before the open timeout");
+    } else if (memcmp(head, "RIFF", 4) == 0 && memcmp(head + 8, "WAVE", 4) == 0) {
+        result = open_wav(stream);
+    } else {
+        result = open_mp3(stream, head, sizeof(head));
+    }
+    TRACE_END(open_span);
+
+    // a live source has no end to measure and nothing to seek in
+    decoder->length_frames = -1;
+    return result;
+}
+
+static DecoderStatus read_wav(StreamDecoder *stream, float *out, size_t max_frames, size_t *frames_read) {
+    if (stream->data_left == 0) return DECODER_DONE;
+
+    size_t block_align = (size_t)stream->wav.block_align;
+    size_t want = max_frames * block_align;
+    if (stream->data_left > 0 && (long long)want > stream->data_left) want = (size_t)stream->data_left;
+    if (want > stream->scratch_size) {
+        unsigned char *scratch = realloc(stream->scratch, want);
+        if (!scratch) return DECODER_ERROR;
+        stream->scratch = scratch;
+        stream->scratch_size = want;
+    }
+
+    size_t taken = 0;
+    StreamRead result = stream_source_take(stream->source, stream->scratch, want, stream->queued_ms, &taken);
+    if (result == STREAM_END) return DECODER_DONE;
+    if (result == STREAM_FAILED) return DECODER_ERROR;
+
+    size_t frames = taken / block_align;
+    stream->wav.convert(stream->scratch, out, frames * (size_t)stream->wav.channels);
+    if (stream->data_left > 0) stream->data_left -= (long long)taken;
+    *frames_read = frames;
+    return DECODER_OK;
+}
+
+static DecoderStatus read_mp3(StreamDecoder *stream, float *out, size_t max_frames, size_t *frames_read) {
+    Decoder *decoder = &stream->base;
+    size_t frame_bytes = sizeof(float) * decoder->channels;
+
+    for (;;) {
+        size_t got = 0;
+        int err = mpg123_read(stream->mh, (unsigned char *)out, max_frames * frame_bytes, &got);
+        *frames_read = got / frame_bytes;
+
+        if (err == MPG123_NEW_FORMAT) {
+            int channels, encoding;
+            long rate;
+            if (mpg123_getformat(stream->mh, &rate, &channels, &encoding) == MPG123_OK) {
+                decoder->rate = rate;
+                decoder->channels = channels;
+            }
+            return DECODER_NEW_FORMAT;
+        }
+        if (err == MPG123_NEED_MORE && got == 0) {
+            size_t taken = 0;
+            StreamRead result = stream_source_take(stream->source, stream->feed, sizeof(stream->feed),
+                                                   stream->queued_ms, &taken);
+            if (result == STREAM_BUFFERING) return DECODER_OK;
+            if (result == STREAM_END) return DECODER_DONE;
+            if (result == STREAM_FAILED) return DECODER_ERROR;
+
+            mpg123_feed(stream->mh, stream->feed, taken);
+            stream->bytes_fed += taken;
+            continue;
+        }
+        if (err == MPG123_DONE) return DECODER_DONE;
+        if (err != MPG123_OK && err != MPG123_NEED_MORE) return DECODER_ERROR;
+        break;
+    }
+
+    // once a second of audio, so VBR and bitrate switches are followed
+    stream->frames_decoded += *frames_read;
+    if (decoder->rate > 0 && stream->frames_decoded - stream->rate_update_frames >= (uint64_t)decoder->rate) {
+        stream->rate_update_frames = stream->frames_decoded;
+        stream_source_set_rate(stream->source,
+                               (double)stream->bytes_fed * decoder->rate / (double)stream->frames_decoded, 1);
+    }
+    return DECODER_OK;
+}
+
+static DecoderStatus stream_decoder_read(Decoder *decoder, float *out, size_t max_frames, size_t *frames_read) {
+    StreamDecoder *stream = (StreamDecoder *)decoder;
+    switch (stream->format) {
+        case STREAM_FORMAT_WAV: return read_wav(stream, out, max_frames, frames_read);
+        case STREAM_FORMAT_MP3: return read_mp3(stream, out, max_frames, frames_read);
+        default: return DECODER_ERROR;
+    }
+}
+
+static int stream_decoder_seek(Decoder *decoder, long long frame) {
+    (void)decoder;
+    (void)frame;
+    return -1;
+}
+
+static void stream_decoder_destroy(Decoder *decoder) {
+    StreamDecoder *stream = (StreamDecoder *)decoder;
+    stream_decoder_close(decoder);
+    stream_source_destroy(stream->source);
+    mpg123_delete(stream->mh);
+    free(stream->scratch);
+    free(stream);
+}
+
+static const char* stream_decoder_error_string(Decoder *decoder) {
+    StreamDecoder *stream = (StreamDecoder *)decoder;
+    if (stream->error) return stream->error;
+    return stream->format == STREAM_FORMAT_MP3 ? mpg123_strerror(stream->mh) : "no error";
+}
+
+static const DecoderOps stream_decoder_ops = {
+    .name = "stream",
+    .open = stream_decoder_open,
+    .read = stream_decoder_read,
+    .seek = stream_decoder_seek,
+    .close = stream_decoder_close,
+    .destroy = stream_decoder_destroy,
+    .error_string = stream_decoder_error_string,
+};
+
+Decoder* stream_decoder_create(void) {
+    StreamDecoder *stream = calloc(1, sizeof(StreamDecoder));
+    if (!stream) return NULL;
+
+    stream->source = stream_source_create();
+    stream->mh = mpg123_new(NULL, NULL);
+    if (!stream->source || !stream->mh) {
+        LOG_ERROR("Failed to create stream decoder");
+        stream_source_destroy(stream->source);
+        if (stream->mh) mpg123_delete(stream->mh);
+        free(stream);
+        return NULL;
+    }
+
+    mpg123_param(stream->mh, MPG123_ADD_FLAGS, MPG123_FORCE_FLOAT, 0.0);
+    mpg123_param(stream->mh, MPG123_ADD_FLAGS, MPG123_FORCE_STEREO, 0.0);
+    mpg123_param(stream->mh, MPG123_ADD_FLAGS, MPG123_QUIET, 0.0);
+
+    stream->base.ops = &stream_decoder_ops;
+    stream->base.length_frames = -1;
+    return &stream->base;
+}
+
+void stream_decoder_set_queued(Decoder *decoder, float queued_ms) {
+    if (decoder && decoder->ops == &stream_decoder_ops) ((StreamDecoder *)decoder)->queued_ms = queued_ms;
+}
+
+void stream_decoder_get_stats(Decoder *decoder, StreamStats *stats) {
+    if (!stats) return;
+    memset(stats, 0, sizeof(*stats));
+    if (decoder && decoder->ops == &stream_decoder_ops) {
+        stream_source_get_stats(((StreamDecoder *)decoder)->source, stats);
+    }
+}
@@ -0,0 +1,455 @@
+#include "core/stream_source.h"
+#include "core/trace.h"
+#include "core/log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+
+#define STREAM_POLL_MS 100
+#define STREAM_HEADER_MAX 8192
+#define STREAM_DEFAULT_BYTE_RATE 16000.0    // 128 kbit/s until the decoder knows better
+#define STREAM_UNDERRUN_MS 50.0f            // about one decode chunk left downstream
+#define STREAM_STABLE_SECONDS 30.0          // of audio without an underrun before the target shrinks
+
+struct StreamSource {
+    pthread_mutex_t lock;
+    pthread_cond_t data_ready;
+    pthread_cond_t space_ready;
+    pthread_t thread;
+    bool thread_started;
+    bool running;
+    int fd;
+
+    // the reader appends behind head + count, the consumer takes from head
+    unsigned char *data;
+    size_t capacity;
+    size_t head;
+    size_t count;
+    bool ended;
+    bool failed;
+
+    bool buffering;
+    double byte_rate;
+    size_t align;
+    float target_ms;
+    float queued_ms;
+    double stable_bytes;
+    uint64_t bytes_received;
+    uint64_t underruns;
+};
+
+bool stream_source_is_stream(const char *path) {
+    if (!path) return false;
+    if (strcmp(path, "-") == 0 || strncmp(path, "http://", 7) == 0) return true;
+
+    struct stat st;
+    return stat(path, &st) == 0 && (S_ISFIFO(st.st_mode) || S_ISSOCK(st.st_mode));
+}
+
+StreamSource *stream_source_create(void) {
+    StreamSource *source = calloc(1, sizeof(StreamSource));
+    if (!source) return NULL;
+
+    source->data = malloc(STREAM_BUFFER_BYTES);
+    if (!source->data) {
+        free(source);
+        return NULL;
+    }
+    source->capacity = STREAM_BUFFER_BYTES;
+    source->fd = -1;
+    source->byte_rate = STREAM_DEFAULT_BYTE_RATE;
+    source->align = 1;
+    source->target_ms = STREAM_JITTER_START_MS;
+    pthread_mutex_init(&source->lock, NULL);
+    pthread_cond_init(&source->data_ready, NULL);
+    pthread_cond_init(&source->space_ready, NULL);
+    return source;
+}
+
+void stream_source_destroy(StreamSource *source) {
+    if (!source) return;
+
+    stream_source_close(source);
+    pthread_cond_destroy(&source->space_ready);
+    pthread_cond_destroy(&source->data_ready);
+    pthread_mutex_destroy(&source->lock);
+    free(source->data);
+    free(source);
+}
+
+static float capacity_ms(const StreamSource *source) {
+    return (float)(source->capacity * 1000.0 / source->byte_rate);
+}
+
+static float clamp_target(const StreamSource *source, float target_ms) {
+    float max_ms = capacity_ms(source);
+    if (max_ms > STREAM_JITTER_MAX_MS) max_ms = STREAM_JITTER_MAX_MS;
+    if (target_ms > max_ms) target_ms = max_ms;
+    if (target_ms < STREAM_JITTER_MIN_MS) target_ms = STREAM_JITTER_MIN_MS;
+    return target_ms;
+}
+
+// called with lock held
+static void append(StreamSource *source, const unsigned char *bytes, size_t length) {
+    while (length > 0 && source->count < source->capacity) {
+        size_t tail = (source->head + source->count) % source->capacity;
+        size_t run = source->capacity - tail;
+        if (run > source->capacity - source->count) run = source->capacity - source->count;
+        if (run > length) run = length;
+
+        memcpy(source->data + tail, bytes, run);
+        source->count += run;
+        source->bytes_received += run;
+        bytes += run;
+        length -= run;
+    }
+    pthread_cond_broadcast(&source->data_ready);
+}
+
+// called with lock held
+static size_t consume(StreamSource *source, unsigned char *out, size_t size) {
+    if (size > source->count) size = source->count;
+    size_t first = source->capacity - source->head;
+    if (first > size) first = size;
+
+    memcpy(out, source->data + source->head, first);
+    memcpy(out + first, source->data, size - first);
+    source->head = (source->head + size) % source->capacity;
+    source->count -= size;
+    pthread_cond_signal(&source->space_ready);
+    return size;
+}
+
+static void *reader_main(void *arg) {
+    StreamSource *source = arg;
+    TRACE_THREAD_NAME("stream_reader");
+    struct pollfd pfd = {.fd = source->fd, .events = POLLIN};
+
+    pthread_mutex_lock(&source->lock);
+    while (source->running) {
+        if (source->count == source->capacity) {
+            pthread_cond_wait(&source->space_ready, &source->lock);
+            continue;
+        }
+
+        // only this thread writes behind the queued bytes, so the read runs unlocked
+        size_t tail = (source->head + source->count) % source->capacity;
+        size_t room = source->capacity - tail;
+        if (room > source->capacity - source->count) room = source->capacity - source->count;
+        pthread_mutex_unlock(&source->lock);
+
+        ssize_t got = 0;
+        int ready = poll(&pfd, 1, STREAM_POLL_MS);
+        if (ready > 0) {
+            TRACE_SCOPE("stream_read");
+            got = read(source->fd, source->data + tail, room);
+        }
+
+        pthread_mutex_lock(&source->lock);
+        if (got > 0) {
+            source->count += (size_t)got;
+            source->bytes_received += (uint64_t)got;
+            pthread_cond_broadcast(&source->data_ready);
+        } else if (ready > 0 && got == 0) {
+            source->ended = true;
+        } else if ((ready < 0 && errno != EINTR) || (got < 0 && errno != EAGAIN && errno != EINTR)) {
+            LOG_ERROR("Stream read failed: %s", strerror(errno));
+            source->failed = true;
+        }
+        if (source->ended || source->failed) {
+            pthread_cond_broadcast(&source->data_ready);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&source->lock);
+    return NULL;
+}
+
+static int wait_readable(int fd, int events, int timeout_ms) {
+    struct pollfd pfd = {.fd = fd, .events = (short)events};
+    int ready;
+    do {
+        ready = poll(&pfd, 1, timeout_ms);
+    } while (ready < 0 && errno == EINTR);
+    return ready > 0 ? 0 : -1;
+}
+
+// http://host[:port][/path]
+static int parse_url(const char *url, char *host, size_t host_size, char *port, size_t port_size,
+                     const char **path) {
+    const char *start = url + 7;
+    const char *end = start + strcspn(start, ":/");
+    size_t host_length = (size_t)(end - start);
+    if (host_length == 0 || host_length >= host_size) return -1;
+
+    memcpy(host, start, host_length);
+    host[host_length] = '\0';
+    snprintf(port, port_size, "80");
+
+    if (*end == ':') {
+        const char *port_start = end + 1;
+        end = port_start + strcspn(port_start, "/");
+        size_t port_length = (size_t)(end - port_start);
+        if (port_length == 0 || port_length >= port_size) return -1;
+        memcpy(port, port_start, port_length);
+        port[port_length] = '\0';
+    }
+    *path = *end ? end : "/";
+    return 0;
+}
+
+static long long monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// non-blocking, and all addresses together get STREAM_OPEN_TIMEOUT_MS: this runs under
+// the player's decoder lock, so an unreachable host must not wait out the SYN timeout
+static int connect_host(const char *host, const char *port) {
+    struct addrinfo hints = {.ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM};
+    struct addrinfo *addresses;
+    if (getaddrinfo(host, port, &hints, &addresses) != 0) return -1;
+
+    long long deadline = monotonic_ms() + STREAM_OPEN_TIMEOUT_MS;
+    int fd = -1;
+    for (struct addrinfo *ai = addresses; ai; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC | SOCK_NONBLOCK, ai->ai_protocol);
+        if (fd < 0) continue;
+        if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) break;
+
+        long long remaining = deadline - monotonic_ms();
+        int error = 0;
+        socklen_t error_size = sizeof(error);
+        if (errno == EINPROGRESS && remaining > 0 && wait_readable(fd, POLLOUT, (int)remaining) == 0 &&
+            getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &error_size) == 0 && error == 0) {
+            break;
+        }
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(addresses);
+    return fd;
+}
+
+// sends the request and reads the response head; body bytes that came with it are queued
+static int open_http(StreamSource *source, const char *url) {
+    char host[256], port[16];
+    const char *path;
+    if (parse_url(url, host, sizeof(host), port, sizeof(port), &path) != 0) {
+        LOG_ERROR("Invalid stream URL: %s", url);
+        return -1;
+    }
+
+    int fd = connect_host(host, port);
+    if (fd < 0) {
+        LOG_WARN("Cannot connect to %s:%s", host, port);
+        return -1;
+    }
+
+    // HTTP/1.0 keeps the body unchunked; Icy-MetaData stays off so no titles are interleaved
+    char request[1024];
+    int length = snprintf(request, sizeof(request),
+                          "GET %s HTTP/1.0\r\nHost: %s\r\nUser-Agent: rhythm\r\nIcy-MetaData: 0\r\n\r\n", path,
+                          host);
+    if (length < 0 || (size_t)length >= sizeof(request) || send(fd, request, (size_t)length, MSG_NOSIGNAL) != length) {
+        close(fd);
+        return -1;
+    }
+
+    char head[STREAM_HEADER_MAX + 1];
+    size_t used = 0;
+    char *body = NULL;
+    while (!body && used < STREAM_HEADER_MAX) {
+        if (wait_readable(fd, POLLIN, STREAM_OPEN_TIMEOUT_MS) != 0) break;
+        ssize_t got = recv(fd, head + used, STREAM_HEADER_MAX - used, 0);
+        if (got <= 0) break;
+        used += (size_t)got;
+        head[used] = '\0';
+        body = strstr(head, "\r\n\r\n");
+    }
+
+    int status = 0;
+    if (!body || (sscanf(head, "HTTP/%*d.%*d %d", &status) != 1 && sscanf(head, "ICY %d", &status) != 1) ||
+        status != 200) {
+        LOG_ERROR("Stream request failed: %s (status %d)", url, status);
+        close(fd);
+        return -1;
+    }
+
+    body += 4;
+    append(source, (const unsigned char *)body, used - (size_t)(body - head));
+    return fd;
+}
+
+int stream_source_open(StreamSource *source, const char *uri) {
+    if (!source || !uri) return -1;
+    stream_source_close(source);
+
+    pthread_mutex_lock(&source->lock);
+    source->head = 0;
+    source->count = 0;
+    source->ended = false;
+    source->failed = false;
+    source->buffering = true;
+    source->byte_rate = STREAM_DEFAULT_BYTE_RATE;
+    source->align = 1;
+    source->target_ms = STREAM_JITTER_START_MS;
+    source->queued_ms = 0.0f;
+    source->stable_bytes = 0.0;
+    source->bytes_received = 0;
+    source->underruns = 0;
+    pthread_mutex_unlock(&source->lock);
+
+    // non-blocking throughout: a FIFO without a writer must not hang the caller
+    int fd;
+    if (strcmp(uri, "-") == 0) {
+        fd = fcntl(STDIN_FILENO, F_DUPFD_CLOEXEC, 0);
+    } else if (strncmp(uri, "http://", 7) == 0) {
+        fd = open_http(source, uri);
+    } else {
+        fd = open(uri, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    }
+    if (fd < 0) {
+        LOG_ERROR("Cannot open stream: %s", uri);
+        return -1;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    source->fd = fd;
+    source->running = true;
+    if (pthread_create(&source->thread, NULL, reader_main, source) != 0) {
+        LOG_ERROR("Failed to start stream reader");
+        source->running = false;
+        close(fd);
+        source->fd = -1;
+        return -1;
+    }
+    pthread_mutex_lock(&source->lock);
+    source->thread_started = true;
+    pthread_mutex_unlock(&source->lock);
+    return 0;
+}
+
+void stream_source_close(StreamSource *source) {
+    if (!source || !source->thread_started) return;
+
+    pthread_mutex_lock(&source->lock);
+    source->running = false;
+    pthread_cond_broadcast(&source->space_ready);
+    pthread_cond_broadcast(&source->data_ready);
+    pthread_mutex_unlock(&source->lock);
+
+    pthread_join(source->thread, NULL);
+    pthread_mutex_lock(&source->lock);
+    source->thread_started = false;
+    pthread_mutex_unlock(&source->lock);
+    close(source->fd);
+    source->fd = -1;
+}
+
+size_t stream_source_read(StreamSource *source, void *buffer, size_t size, int timeout_ms) {
+    if (!source || !buffer || size == 0) return 0;
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    pthread_mutex_lock(&source->lock);
+    while (source->count == 0 && source->running && !source->ended && !source->failed) {
+        if (pthread_cond_timedwait(&source->data_ready, &source->lock, &deadline) == ETIMEDOUT) break;
+    }
+    size_t got = consume(source, buffer, size);
+    pthread_mutex_unlock(&source->lock);
+    return got;
+}
+
+void stream_source_set_rate(StreamSource *source, double bytes_per_second, size_t align) {
+    if (!source || bytes_per_second <= 0.0) return;
+
+    pthread_mutex_lock(&source->lock);
+    source->byte_rate = bytes_per_second;
+    source->align = align > 0 ? align : 1;
+    source->target_ms = clamp_target(source, source->target_ms);
+    pthread_mutex_unlock(&source->lock);
+}
+
+StreamRead stream_source_take(StreamSource *source, void *buffer, size_t size, float queued_ms, size_t *taken) {
+    *taken = 0;
+    if (!source || !buffer) return STREAM_FAILED;
+
+    pthread_mutex_lock(&source->lock);
+    source->queued_ms = queued_ms;
+    size_t align = source->align;
+    size_t available = source->count - source->count % align;
+    bool finished = source->ended || source->failed || !source->running;
+
+    if (available == 0 && finished) {
+        StreamRead result = source->failed ? STREAM_FAILED : STREAM_END;
+        pthread_mutex_unlock(&source->lock);
+        return result;
+    }
+
+    float level_ms = (float)(source->count * 1000.0 / source->byte_rate) + queued_ms;
+    if (source->buffering) {
+        // a full buffer cannot get any closer to the target
+        bool full = source->count + align > source->capacity;
+        if (level_ms < source->target_ms && !finished && !full) {
+            pthread_mutex_unlock(&source->lock);
+            return STREAM_BUFFERING;
+        }
+        source->buffering = false;
+    }
+
+    if (available == 0) {
+        // dry with audio still queued downstream is jitter; dry with nothing left is an underrun
+        if (queued_ms < STREAM_UNDERRUN_MS) {
+            source->underruns++;
+            source->target_ms = clamp_target(source, source->target_ms * 1.5f);
+            source->buffering = true;
+            source->stable_bytes = 0.0;
+        }
+        pthread_mutex_unlock(&source->lock);
+        return STREAM_BUFFERING;
+    }
+
+    size = size - size % align;
+    *taken = consume(source, buffer, size < available ? size : available);
+
+    source->stable_bytes += (double)*taken;
+    if (source->stable_bytes >= source->byte_rate * STREAM_STABLE_SECONDS) {
+        source->target_ms = clamp_target(source, source->target_ms * 0.9f);
+        source->stable_bytes = 0.0;
+    }
+    pthread_mutex_unlock(&source->lock);
+    return STREAM_DATA;
+}
+
+void stream_source_get_stats(StreamSource *source, StreamStats *stats) {
+    if (!source || !stats) return;
+
+    pthread_mutex_lock(&source->lock);
+    stats->active = source->thread_started;
+    stats->buffering = source->buffering;
+    stats->ended = source->ended;
+    stats->bytes_received = source->bytes_received;
+    stats->underruns = source->underruns;
+    stats->buffered_ms = (float)(source->count * 1000.0 / source->byte_rate) + source->queued_ms;
+    stats->target_ms = source->target_ms;
+    stats->byte_rate = (float)source->byte_rate;
+    pthread_mutex_unlock(&source->lock);
+}
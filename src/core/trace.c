@@ -0,0 +1,249 @@
+#include "core/trace.h"
+#include "core/log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+typedef enum {
+    TRACE_EVENT_SPAN,
+    TRACE_EVENT_INSTANT,
+    TRACE_EVENT_THREAD_NAME,
+} TraceEventKind;
+
+typedef struct {
+    const char *name;
+    uint64_t start_ns;
+    uint64_t duration_ns;
+    long tid;                   // a slot outlives its thread, so each event keeps its own
+    TraceEventKind kind;
+} TraceEvent;
+
+// one writer per buffer; events are published by the release store to count. When its
+// thread exits the slot goes back for the next thread, which appends after the events
+// already there
+typedef struct {
+    TraceEvent *events;
+    size_t capacity;
+    atomic_size_t count;
+    atomic_uint_fast64_t dropped;
+    atomic_bool owned;
+    const char *thread_name;    // last name recorded by the owner
+    long tid;
+} TraceBuffer;
+
+static TraceBuffer buffers[TRACE_MAX_THREADS];
+static atomic_int buffers_claimed;      // slots ever used, for the flush
+static pthread_key_t buffer_key;
+static atomic_bool tracing_active;
+static const char *trace_path;
+static uint64_t epoch_ns;
+static pthread_once_t trace_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t flush_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static _Thread_local TraceBuffer *thread_buffer;
+static _Thread_local bool thread_unbuffered;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void flush_at_exit(void) {
+    if (trace_flush(NULL) == 0) {
+        LOG_INFO("Trace written to %s", trace_path);
+    }
+}
+
+// runs on the exiting thread, which records nothing more
+static void release_buffer(void *arg) {
+    TraceBuffer *buffer = arg;
+    thread_buffer = NULL;
+    thread_unbuffered = true;
+    atomic_store_explicit(&buffer->owned, false, memory_order_release);
+}
+
+static void trace_setup(void) {
+    const char *path = getenv("RHYTHM_TRACE");
+    if (!path || !*path) return;
+
+    size_t capacity = TRACE_DEFAULT_EVENTS_PER_THREAD;
+    const char *events = getenv("RHYTHM_TRACE_EVENTS");
+    if (events && atol(events) > 0) {
+        capacity = (size_t)atol(events);
+    }
+
+    // untouched pages stay unbacked, so only threads that record cost memory
+    for (int i = 0; i < TRACE_MAX_THREADS; i++) {
+        buffers[i].events = calloc(capacity, sizeof(TraceEvent));
+        if (!buffers[i].events) {
+            LOG_ERROR("Failed to allocate trace buffers");
+            for (int j = 0; j < i; j++) {
+                free(buffers[j].events);
+                buffers[j].events = NULL;
+            }
+            return;
+        }
+        buffers[i].capacity = capacity;
+        atomic_init(&buffers[i].count, 0);
+        atomic_init(&buffers[i].dropped, 0);
+        atomic_init(&buffers[i].owned, false);
+    }
+    if (pthread_key_create(&buffer_key, release_buffer) != 0) {
+        LOG_ERROR("Failed to create trace thread key");
+        for (int i = 0; i < TRACE_MAX_THREADS; i++) {
+            free(buffers[i].events);
+            buffers[i].events = NULL;
+        }
+        return;
+    }
+
+    trace_path = path;
+    epoch_ns = now_ns();
+    // the log registers its own exit flush first, so it runs after ours and prints the path
+    log_init();
+    atexit(flush_at_exit);
+    atomic_store(&tracing_active, true);
+}
+
+void trace_init(void) {
+    pthread_once(&trace_once, trace_setup);
+}
+
+bool trace_enabled(void) {
+    return atomic_load_explicit(&tracing_active, memory_order_relaxed);
+}
+
+static TraceBuffer *current_buffer(void) {
+    if (thread_buffer || thread_unbuffered) return thread_buffer;
+
+    for (int index = 0; index < TRACE_MAX_THREADS; index++) {
+        TraceBuffer *buffer = &buffers[index];
+        bool expected = false;
+        if (!atomic_compare_exchange_strong(&buffer->owned, &expected, true)) continue;
+
+        int claimed = atomic_load(&buffers_claimed);
+        while (claimed <= index && !atomic_compare_exchange_weak(&buffers_claimed, &claimed, index + 1)) {}
+        buffer->tid = (long)syscall(SYS_gettid);
+        buffer->thread_name = NULL;
+        pthread_setspecific(buffer_key, buffer);
+        thread_buffer = buffer;
+        return buffer;
+    }
+    thread_unbuffered = true;
+    return NULL;
+}
+
+static void record(const char *name, uint64_t start_ns, uint64_t duration_ns, TraceEventKind kind) {
+    TraceBuffer *buffer = current_buffer();
+    if (!buffer) return;
+
+    size_t index = atomic_load_explicit(&buffer->count, memory_order_relaxed);
+    if (index >= buffer->capacity) {
+        atomic_fetch_add_explicit(&buffer->dropped, 1, memory_order_relaxed);
+        return;
+    }
+
+    TraceEvent *event = &buffer->events[index];
+    event->name = name;
+    event->start_ns = start_ns;
+    event->duration_ns = duration_ns;
+    event->tid = buffer->tid;
+    event->kind = kind;
+    atomic_store_explicit(&buffer->count, index + 1, memory_order_release);
+}
+
+void trace_set_thread_name(const char *name) {
+    if (!trace_enabled()) return;
+
+    TraceBuffer *buffer = current_buffer();
+    if (buffer && buffer->thread_name != name) {
+        buffer->thread_name = name;
+        record(name, now_ns(), 0, TRACE_EVENT_THREAD_NAME);
+    }
+}
+
+TraceSpan trace_span_begin(const char *name) {
+    TraceSpan span = {NULL, 0};
+    if (trace_enabled()) {
+        span.name = name;
+        span.start_ns = now_ns();
+    }
+    return span;
+}
+
+void trace_span_end(TraceSpan *span) {
+    if (!span->name) return;
+    record(span->name, span->start_ns, now_ns() - span->start_ns, TRACE_EVENT_SPAN);
+}
+
+void trace_instant(const char *name) {
+    if (!trace_enabled()) return;
+    record(name, now_ns(), 0, TRACE_EVENT_INSTANT);
+}
+
+static double to_trace_us(uint64_t ns) {
+    return ns >= epoch_ns ? (double)(ns - epoch_ns) / 1000.0 : 0.0;
+}
+
+int trace_flush(const char *path) {
+    if (!trace_enabled()) return -1;
+    if (!path) path = trace_path;
+
+    pthread_mutex_lock(&flush_lock);
+
+    // write beside the target and rename so a viewer never sees a torn file
+    char temp_path[4096];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", path);
+    FILE *file = fopen(temp_path, "w");
+    if (!file) {
+        LOG_ERROR("Failed to open trace file: %s", temp_path);
+        pthread_mutex_unlock(&flush_lock);
+        return -1;
+    }
+
+    int pid = (int)getpid();
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":0,\"args\":{\"name\":\"rhythm\"}}", pid);
+
+    int claimed = atomic_load(&buffers_claimed);
+    if (claimed > TRACE_MAX_THREADS) claimed = TRACE_MAX_THREADS;
+
+    uint64_t dropped = 0;
+    for (int i = 0; i < claimed; i++) {
+        TraceBuffer *buffer = &buffers[i];
+        size_t count = atomic_load_explicit(&buffer->count, memory_order_acquire);
+        dropped += atomic_load_explicit(&buffer->dropped, memory_order_relaxed);
+
+        for (size_t e = 0; e < count; e++) {
+            const TraceEvent *event = &buffer->events[e];
+            if (event->kind == TRACE_EVENT_THREAD_NAME) {
+                fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%ld,\"args\":{\"name\":\"%s\"}}",
+                        pid, event->tid, event->name);
+            } else if (event->kind == TRACE_EVENT_INSTANT) {
+                fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":%d,\"tid\":%ld}",
+                        event->name, to_trace_us(event->start_ns), pid, event->tid);
+            } else {
+                fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%ld}",
+                        event->name, to_trace_us(event->start_ns), event->duration_ns / 1000.0, pid, event->tid);
+            }
+        }
+    }
+
+    fprintf(file, "\n],\"otherData\":{\"dropped_events\":%llu}}\n", (unsigned long long)dropped);
+
+    int result = 0;
+    if (fclose(file) != 0 || rename(temp_path, path) != 0) {
+        LOG_ERROR("Failed to write trace file: %s", path);
+        remove(temp_path);
+        result = -1;
+    }
+
+    pthread_mutex_unlock(&flush_lock);
+    return result;
+}
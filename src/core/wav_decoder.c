@@ -0,0 +1,292 @@
+#include "core/decoder.h"
+#include "core/trace.h"
+#include "core/log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define WAV_FORMAT_PCM 0x0001
+#define WAV_FORMAT_FLOAT 0x0003
+#define WAV_FORMAT_EXTENSIBLE 0xFFFE
+#define WAV_SEEK_READAHEAD_BYTES (1 << 20)
+
+typedef struct {
+    Decoder base;
+    const unsigned char *map;
+    size_t map_size;
+    const unsigned char *data;
+    long long position;
+    WavSampleConverter convert;
+    int block_align;
+    const char *error;
+} WavDecoder;
+
+static uint16_t read_u16(const unsigned char *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t read_u32(const unsigned char *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+bool wav_decoder_probe(const char *path) {
+    FILE *file = fopen(path, "rb");
+    if (!file) return false;
+
+    unsigned char header[12];
+    bool is_wav = fread(header, 1, sizeof(header), file) == sizeof(header) &&
+                  memcmp(header, "RIFF", 4) == 0 && memcmp(header + 8, "WAVE", 4) == 0;
+    fclose(file);
+    return is_wav;
+}
+
+static bool format_supported(int format, int bits) {
+    if (format == WAV_FORMAT_PCM) return bits == 8 || bits == 16 || bits == 24 || bits == 32;
+    if (format == WAV_FORMAT_FLOAT) return bits == 32 || bits == 64;
+    return false;
+}
+
+static inline float load_u8(const unsigned char *p) {
+    return ((int)p[0] - 128) * (1.0f / 128.0f);
+}
+
+static inline float load_s16(const unsigned char *p) {
+    int16_t s;
+    memcpy(&s, p, sizeof(s));
+    return s * (1.0f / 32768.0f);
+}
+
+static inline float load_s24(const unsigned char *p) {
+    int32_t s = (int32_t)((uint32_t)p[0] << 8 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 24) >> 8;
+    return s * (1.0f / 8388608.0f);
+}
+
+static inline float load_s32(const unsigned char *p) {
+    int32_t s;
+    memcpy(&s, p, sizeof(s));
+    return (float)(s * (1.0 / 2147483648.0));
+}
+
+static inline float load_f64(const unsigned char *p) {
+    double s;
+    memcpy(&s, p, sizeof(s));
+    return (float)s;
+}
+
+// one converter per encoding, picked at open so reads never switch on the format
+#define DEFINE_SAMPLE_CONVERTER(NAME, BYTES) \
+    static void convert_##NAME(const unsigned char *src, float *out, size_t count) { \
+        for (size_t i = 0; i < count; i++) { \
+            out[i] = load_##NAME(src + i * (BYTES)); \
+        } \
+    }
+
+DEFINE_SAMPLE_CONVERTER(u8, 1)
+DEFINE_SAMPLE_CONVERTER(s16, 2)
+DEFINE_SAMPLE_CONVERTER(s24, 3)
+DEFINE_SAMPLE_CONVERTER(s32, 4)
+DEFINE_SAMPLE_CONVERTER(f64, 8)
+
+// already in the ring's format: a straight copy out of the page cache
+static void convert_f32(const unsigned char *src, float *out, size_t count) {
+    memcpy(out, src, count * sizeof(float));
+}
+
+static WavSampleConverter pick_converter(int format, int bits) {
+    if (format == WAV_FORMAT_FLOAT) return bits == 32 ? convert_f32 : convert_f64;
+    switch (bits) {
+        case 8: return convert_u8;
+        case 16: return convert_s16;
+        case 24: return convert_s24;
+        default: return convert_s32;
+    }
+}
+
+const char *wav_parse_format(const unsigned char *chunk, size_t size, WavFormat *format) {
+    if (size < 16) return "missing fmt or data chunk";
+
+    int tag = read_u16(chunk);
+    int channels = read_u16(chunk + 2);
+    long rate = (long)read_u32(chunk + 4);
+    int block_align = read_u16(chunk + 12);
+    int bits = read_u16(chunk + 14);
+    if (tag == WAV_FORMAT_EXTENSIBLE && size >= 40) {
+        tag = read_u16(chunk + 24);
+    }
+
+    if (rate <= 0) return "missing fmt or data chunk";
+    if (!format_supported(tag, bits)) return "unsupported sample format";
+    if (channels < 1 || channels > DECODER_MAX_CHANNELS) return "unsupported channel count";
+    if (block_align != channels * bits / 8) return "inconsistent block alignment";
+
+    format->rate = rate;
+    format->channels = channels;
+    format->block_align = block_align;
+    format->convert = pick_converter(tag, bits);
+    return NULL;
+}
+
+static void wav_decoder_close(Decoder *decoder) {
+    WavDecoder *wav = (WavDecoder *)decoder;
+    if (wav->map) {
+        munmap((void *)wav->map, wav->map_size);
+        wav->map = NULL;
+        wav->data = NULL;
+    }
+}
+
+static int fail(WavDecoder *wav, const char *error) {
+    wav->error = error;
+    LOG_ERROR("Failed to open WAV file: %s", error);
+    wav_decoder_close(&wav->base);
+    return -1;
+}
+
+static int wav_decoder_open(Decoder *decoder, const char *path) {
+    WavDecoder *wav = (WavDecoder *)decoder;
+    wav_decoder_close(decoder);
+    wav->position = 0;
+    wav->error = NULL;
+
+    TRACE_BEGIN(open_span, "wav_open");
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        TRACE_END(open_span);
+        return fail(wav, "cannot open file");
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < 12) {
+        close(fd);
+        TRACE_END(open_span);
+        return fail(wav, "file too short");
+    }
+
+    void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    TRACE_END(open_span);
+    if (map == MAP_FAILED) {
+        return fail(wav, "cannot map file");
+    }
+    wav->map = map;
+    wav->map_size = (size_t)st.st_size;
+
+    // the decoder walks the file front to back, so let the kernel read ahead aggressively
+    madvise(map, wav->map_size, MADV_SEQUENTIAL);
+
+    const unsigned char *p = wav->map;
+    if (memcmp(p, "RIFF", 4) != 0 || memcmp(p + 8, "WAVE", 4) != 0) {
+        return fail(wav, "not a RIFF/WAVE file");
+    }
+
+    const unsigned char *fmt = NULL;
+    size_t fmt_size = 0;
+    const unsigned char *data = NULL;
+    size_t data_size = 0;
+
+    size_t offset = 12;
+    while (offset + 8 <= wav->map_size) {
+        const unsigned char *chunk = p + offset;
+        size_t size = read_u32(chunk + 4);
+        size_t body = offset + 8;
+        size_t remaining = wav->map_size - body;
+
+        if (memcmp(chunk, "fmt ", 4) == 0 && size <= remaining) {
+            fmt = chunk + 8;
+            fmt_size = size;
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            // streamed writers leave the size unset; take whatever is on disk
+            data = p + body;
+            data_size = size < remaining ? size : remaining;
+            break;
+        }
+
+        offset = body + size + (size & 1);
+    }
+
+    if (!data || !fmt) {
+        return fail(wav, "missing fmt or data chunk");
+    }
+    WavFormat format;
+    const char *error = wav_parse_format(fmt, fmt_size, &format);
+    if (error) {
+        return fail(wav, error);
+    }
+
+    wav->data = data;
+    wav->convert = format.convert;
+    wav->block_align = format.block_align;
+
+    decoder->rate = format.rate;
+    decoder->channels = format.channels;
+    decoder->length_frames = (long long)(data_size / (size_t)format.block_align);
+    return 0;
+}
+
+static DecoderStatus wav_decoder_read(Decoder *decoder, float *out, size_t max_frames, size_t *frames_read) {
+    WavDecoder *wav = (WavDecoder *)decoder;
+    if (!wav->data) return DECODER_ERROR;
+
+    long long remaining = decoder->length_frames - wav->position;
+    if (remaining <= 0) return DECODER_DONE;
+
+    size_t frames = (long long)max_frames < remaining ? max_frames : (size_t)remaining;
+    const unsigned char *src = wav->data + (size_t)wav->position * wav->block_align;
+    wav->convert(src, out, frames * decoder->channels);
+
+    wav->position += (long long)frames;
+    *frames_read = frames;
+    return DECODER_OK;
+}
+
+static int wav_decoder_seek(Decoder *decoder, long long frame) {
+    WavDecoder *wav = (WavDecoder *)decoder;
+    if (!wav->data) return -1;
+    if (frame > decoder->length_frames) frame = decoder->length_frames;
+
+    wav->position = frame;
+
+    // sequential readahead restarts from the new position; prime it so the first fill doesn't fault
+    const unsigned char *start = wav->data + (size_t)frame * wav->block_align;
+    const unsigned char *end = wav->map + wav->map_size;
+    uintptr_t page_mask = (uintptr_t)sysconf(_SC_PAGESIZE) - 1;
+    const unsigned char *aligned = (const unsigned char *)((uintptr_t)start & ~page_mask);
+    size_t length = (size_t)(end - aligned);
+    if (length > WAV_SEEK_READAHEAD_BYTES) length = WAV_SEEK_READAHEAD_BYTES;
+    madvise((void *)aligned, length, MADV_WILLNEED);
+    return 0;
+}
+
+static void wav_decoder_destroy(Decoder *decoder) {
+    wav_decoder_close(decoder);
+    free(decoder);
+}
+
+static const char* wav_decoder_error_string(Decoder *decoder) {
+    WavDecoder *wav = (WavDecoder *)decoder;
+    return wav->error ? wav->error : "no error";
+}
+
+static const DecoderOps wav_decoder_ops = {
+    .name = "wav",
+    .open = wav_decoder_open,
+    .read = wav_decoder_read,
+    .seek = wav_decoder_seek,
+    .close = wav_decoder_close,
+    .destroy = wav_decoder_destroy,
+    .error_string = wav_decoder_error_string,
+};
+
+Decoder* wav_decoder_create(void) {
+    WavDecoder *wav = calloc(1, sizeof(WavDecoder));
+    if (!wav) return NULL;
+
+    wav->base.ops = &wav_decoder_ops;
+    wav->base.length_frames = -1;
+    return &wav->base;
+}
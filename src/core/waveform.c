@@ -0,0 +1,431 @@
+#include "core/waveform.h"
+#include "core/decoder.h"
+#include "core/trace.h"
+#include "core/log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/stat.h>
+
+#define WAVEFORM_MAGIC "RWPK"
+#define WAVEFORM_VERSION 1
+#define WAVEFORM_CHUNK_FRAMES 4096
+#define WAVEFORM_MIN_CAPACITY 4096
+#define WAVEFORM_MAX_ERRORS 5
+
+typedef struct {
+    float min;
+    float max;
+    float ms;                   // mean square, so bins combine exactly
+} Bin;
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t base_frames;
+    uint32_t rate;
+    uint64_t frames;
+    uint64_t bins;
+} WaveformFileHeader;
+
+struct Waveform {
+    char *path;
+    char *cache_path;
+    pthread_t thread;
+    bool thread_started;
+    atomic_bool cancel;
+
+    // guards the level arrays against reallocation by the builder; bins below
+    // frames_done are never written again, so readers need nothing else
+    pthread_mutex_t lock;
+    Bin *levels[WAVEFORM_MAX_LEVELS];
+    size_t capacity;            // level 0 bins, always a power of two
+    int level_count;
+
+    atomic_llong frames_done;
+    atomic_llong total_frames;
+    atomic_bool complete;
+};
+
+static Bin combine(const Bin *a, const Bin *b) {
+    Bin bin = {
+        a->min < b->min ? a->min : b->min,
+        a->max > b->max ? a->max : b->max,
+        (a->ms + b->ms) * 0.5f,
+    };
+    return bin;
+}
+
+static size_t bins_for_frames(long long frames) {
+    return (size_t)((frames + WAVEFORM_BASE_FRAMES - 1) / WAVEFORM_BASE_FRAMES);
+}
+
+static size_t next_power_of_two(size_t value) {
+    size_t result = 1;
+    while (result < value) result <<= 1;
+    return result;
+}
+
+static int ensure_capacity(Waveform *waveform, size_t bins) {
+    if (bins <= waveform->capacity) return 0;
+
+    size_t capacity = next_power_of_two(bins < WAVEFORM_MIN_CAPACITY ? WAVEFORM_MIN_CAPACITY : bins);
+    int level_count = 1;
+    while (level_count < WAVEFORM_MAX_LEVELS && (capacity >> (level_count - 1)) > 1) level_count++;
+
+    pthread_mutex_lock(&waveform->lock);
+    int status = 0;
+    for (int level = 0; level < level_count; level++) {
+        Bin *bins_at_level = realloc(waveform->levels[level], (capacity >> level) * sizeof(Bin));
+        if (!bins_at_level) {
+            status = -1;
+            break;
+        }
+        waveform->levels[level] = bins_at_level;
+    }
+    if (status == 0) {
+        waveform->capacity = capacity;
+        waveform->level_count = level_count;
+    }
+    pthread_mutex_unlock(&waveform->lock);
+    return status;
+}
+
+// an odd index completes a pair, which completes one bin on the level above
+static void store_bin(Waveform *waveform, size_t index, const Bin *bin) {
+    waveform->levels[0][index] = *bin;
+    for (int level = 0; level + 1 < waveform->level_count && (index & 1); level++) {
+        Bin *bins = waveform->levels[level];
+        waveform->levels[level + 1][index >> 1] = combine(&bins[index - 1], &bins[index]);
+        index >>= 1;
+    }
+}
+
+// only the last bin of each level can still be missing or stale
+static void finish_levels(Waveform *waveform, size_t bins) {
+    for (int level = 0; level + 1 < waveform->level_count && bins > 1; level++) {
+        size_t parent = (bins - 1) >> 1;
+        Bin *children = waveform->levels[level];
+        waveform->levels[level + 1][parent] = (parent * 2 + 1 < bins)
+            ? combine(&children[parent * 2], &children[parent * 2 + 1])
+            : children[parent * 2];
+        bins = parent + 1;
+    }
+}
+
+static void make_dirs(const char *dir) {
+    char buffer[4096];
+    snprintf(buffer, sizeof(buffer), "%s/", dir);
+    for (char *p = buffer + 1; *p; p++) {
+        if (*p == '/') {
+            *p = '\0';
+            mkdir(buffer, 0755);
+            *p = '/';
+        }
+    }
+}
+
+static int load_cache(Waveform *waveform) {
+    if (!waveform->cache_path) return -1;
+
+    FILE *file = fopen(waveform->cache_path, "rb");
+    if (!file) return -1;
+
+    WaveformFileHeader header;
+    int status = -1;
+    if (fread(&header, sizeof(header), 1, file) == 1 &&
+        memcmp(header.magic, WAVEFORM_MAGIC, 4) == 0 &&
+        header.version == WAVEFORM_VERSION &&
+        header.base_frames == WAVEFORM_BASE_FRAMES &&
+        header.bins == bins_for_frames((long long)header.frames) &&
+        header.bins > 0 &&
+        ensure_capacity(waveform, (size_t)header.bins) == 0 &&
+        fread(waveform->levels[0], sizeof(Bin), (size_t)header.bins, file) == header.bins) {
+
+        for (size_t i = 1; i < header.bins; i += 2) {
+            store_bin(waveform, i, &waveform->levels[0][i]);
+        }
+        finish_levels(waveform, (size_t)header.bins);
+        atomic_store(&waveform->total_frames, (long long)header.frames);
+        atomic_store_explicit(&waveform->frames_done, (long long)header.frames, memory_order_release);
+        status = 0;
+    }
+    fclose(file);
+    return status;
+}
+
+static void save_cache(Waveform *waveform, long rate) {
+    if (!waveform->cache_path) return;
+
+    long long frames = atomic_load(&waveform->frames_done);
+    WaveformFileHeader header = {
+        .version = WAVEFORM_VERSION,
+        .base_frames = WAVEFORM_BASE_FRAMES,
+        .rate = (uint32_t)rate,
+        .frames = (uint64_t)frames,
+        .bins = bins_for_frames(frames),
+    };
+    memcpy(header.magic, WAVEFORM_MAGIC, 4);
+
+    char temp_path[4096];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", waveform->cache_path);
+    FILE *file = fopen(temp_path, "wb");
+    if (!file) return;
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(waveform->levels[0], sizeof(Bin), (size_t)header.bins, file) == header.bins;
+    if (fclose(file) != 0 || !ok || rename(temp_path, waveform->cache_path) != 0) {
+        remove(temp_path);
+    }
+}
+
+static int build(Waveform *waveform, Decoder *decoder, float *buffer) {
+    if (decoder_open(decoder, waveform->path) != 0) return -1;
+
+    long long length = decoder->length_frames;
+    if (length > 0) atomic_store(&waveform->total_frames, length);
+    // the decoder's length can be an estimate, leave some room before growing
+    if (ensure_capacity(waveform, bins_for_frames(length > 0 ? length + length / 16 : 0)) != 0) {
+        decoder_close(decoder);
+        return -1;
+    }
+
+    Bin bin = { INFINITY, -INFINITY, 0.0f };
+    double sum_sq = 0.0;
+    int bin_frames = 0;
+    size_t index = 0;
+    long long frames_done = 0;
+    int errors = 0;
+    int status = 0;
+
+    while (!atomic_load_explicit(&waveform->cancel, memory_order_relaxed)) {
+        size_t frames = 0;
+        DecoderStatus read_status = decoder_read(decoder, buffer, WAVEFORM_CHUNK_FRAMES, &frames);
+        int channels = decoder->channels;
+
+        for (size_t i = 0; i < frames; i++) {
+            for (int ch = 0; ch < channels; ch++) {
+                float sample = buffer[i * channels + ch];
+                if (sample < bin.min) bin.min = sample;
+                if (sample > bin.max) bin.max = sample;
+                sum_sq += (double)sample * sample;
+            }
+            if (++bin_frames == WAVEFORM_BASE_FRAMES) {
+                if (ensure_capacity(waveform, index + 1) != 0) {
+                    status = -1;
+                    break;
+                }
+                bin.ms = (float)(sum_sq / ((double)WAVEFORM_BASE_FRAMES * channels));
+                store_bin(waveform, index++, &bin);
+                frames_done += WAVEFORM_BASE_FRAMES;
+                bin = (Bin){ INFINITY, -INFINITY, 0.0f };
+                sum_sq = 0.0;
+                bin_frames = 0;
+            }
+        }
+        atomic_store_explicit(&waveform->frames_done, frames_done, memory_order_release);
+
+        if (status != 0 || read_status == DECODER_DONE) {
+            break;
+        } else if (read_status == DECODER_ERROR || (read_status == DECODER_OK && frames == 0)) {
+            if (++errors >= WAVEFORM_MAX_ERRORS) {
+                status = -1;
+                break;
+            }
+        } else {
+            errors = 0;
+        }
+    }
+
+    if (bin_frames > 0 && status == 0 && ensure_capacity(waveform, index + 1) == 0) {
+        int channels = decoder->channels > 0 ? decoder->channels : 1;
+        bin.ms = (float)(sum_sq / ((double)bin_frames * channels));
+        waveform->levels[0][index++] = bin;
+        frames_done += bin_frames;
+    }
+    if (index > 0) finish_levels(waveform, index);
+
+    atomic_store(&waveform->total_frames, frames_done);
+    atomic_store_explicit(&waveform->frames_done, frames_done, memory_order_release);
+
+    long rate = decoder->rate;
+    decoder_close(decoder);
+    if (status == 0 && index > 0 && !atomic_load(&waveform->cancel)) {
+        save_cache(waveform, rate);
+    }
+    return status;
+}
+
+static void* waveform_thread_main(void *arg) {
+    Waveform *waveform = (Waveform *)arg;
+    TRACE_THREAD_NAME("waveform");
+    TRACE_SCOPE("waveform_build");
+
+    if (load_cache(waveform) != 0) {
+        bool wav = wav_decoder_probe(waveform->path);
+        Decoder *decoder = wav ? wav_decoder_create() : mpg123_decoder_create();
+        float *buffer = malloc(WAVEFORM_CHUNK_FRAMES * DECODER_MAX_CHANNELS * sizeof(float));
+        if (decoder && buffer && build(waveform, decoder, buffer) != 0) {
+            LOG_WARN("Waveform analysis of %s stopped early", waveform->path);
+        }
+        free(buffer);
+        decoder_destroy(decoder);
+    }
+
+    // a failed build still completes, so callers stop waiting for it
+    atomic_store_explicit(&waveform->complete, true, memory_order_release);
+    return NULL;
+}
+
+int waveform_cache_default_dir(char *buffer, size_t size) {
+    const char *override = getenv("RHYTHM_WAVEFORM_CACHE");
+    if (override && *override) {
+        snprintf(buffer, size, "%s", override);
+        return 0;
+    }
+
+    const char *xdg = getenv("XDG_CACHE_HOME");
+    if (xdg && *xdg) {
+        snprintf(buffer, size, "%s/rhythm/waveforms", xdg);
+        return 0;
+    }
+
+    const char *home = getenv("HOME");
+    if (!home || !*home) return -1;
+    snprintf(buffer, size, "%s/.cache/rhythm/waveforms", home);
+    return 0;
+}
+
+Waveform* waveform_open(const char *path, const char *cache_dir) {
+    struct stat st;
+    if (!path || stat(path, &st) != 0) return NULL;
+
+    Waveform *waveform = calloc(1, sizeof(Waveform));
+    if (!waveform) return NULL;
+
+    pthread_mutex_init(&waveform->lock, NULL);
+    atomic_init(&waveform->cancel, false);
+    atomic_init(&waveform->frames_done, 0);
+    atomic_init(&waveform->total_frames, 0);
+    atomic_init(&waveform->complete, false);
+
+    waveform->path = strdup(path);
+    if (!waveform->path) {
+        waveform_destroy(waveform);
+        return NULL;
+    }
+
+    // keyed like the loudness cache, so edited or replaced files are analysed again
+    if (cache_dir) {
+        char cache_path[4096];
+        long long mtime_ns = (long long)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+        snprintf(cache_path, sizeof(cache_path), "%s/%llx-%llx-%llx-%llx.peaks", cache_dir,
+                 (unsigned long long)st.st_dev, (unsigned long long)st.st_ino,
+                 (unsigned long long)st.st_size, (unsigned long long)mtime_ns);
+        make_dirs(cache_dir);
+        waveform->cache_path = strdup(cache_path);
+    }
+
+    if (pthread_create(&waveform->thread, NULL, waveform_thread_main, waveform) != 0) {
+        LOG_ERROR("Failed to start waveform thread: %s", strerror(errno));
+        waveform_destroy(waveform);
+        return NULL;
+    }
+    waveform->thread_started = true;
+    return waveform;
+}
+
+void waveform_destroy(Waveform *waveform) {
+    if (!waveform) return;
+
+    if (waveform->thread_started) {
+        atomic_store(&waveform->cancel, true);
+        pthread_join(waveform->thread, NULL);
+    }
+    for (int level = 0; level < WAVEFORM_MAX_LEVELS; level++) {
+        free(waveform->levels[level]);
+    }
+    pthread_mutex_destroy(&waveform->lock);
+    free(waveform->cache_path);
+    free(waveform->path);
+    free(waveform);
+}
+
+const char* waveform_path(Waveform *waveform) {
+    return waveform ? waveform->path : NULL;
+}
+
+bool waveform_is_complete(Waveform *waveform) {
+    return waveform && atomic_load_explicit(&waveform->complete, memory_order_acquire);
+}
+
+float waveform_progress(Waveform *waveform) {
+    if (!waveform) return 0.0f;
+    if (waveform_is_complete(waveform)) return 1.0f;
+
+    long long total = atomic_load(&waveform->total_frames);
+    long long done = atomic_load(&waveform->frames_done);
+    if (total <= 0) return 0.0f;
+    float progress = (float)done / (float)total;
+    return progress < 0.99f ? progress : 0.99f;
+}
+
+long long waveform_total_frames(Waveform *waveform) {
+    return waveform ? atomic_load(&waveform->total_frames) : 0;
+}
+
+int waveform_get_buckets(Waveform *waveform, long long start_frame, long long end_frame,
+                         WaveformBucket *buckets, int count) {
+    if (!waveform || !buckets || count <= 0 || start_frame < 0 || end_frame <= start_frame) return -1;
+    memset(buckets, 0, (size_t)count * sizeof(WaveformBucket));
+
+    // complete is read first: once set, frames_done is final and the last partial bin is valid
+    bool complete = waveform_is_complete(waveform);
+    long long done = atomic_load_explicit(&waveform->frames_done, memory_order_acquire);
+    size_t done_bins = complete ? bins_for_frames(done) : (size_t)(done / WAVEFORM_BASE_FRAMES);
+    if (done_bins == 0) return 0;
+
+    double span = (double)(end_frame - start_frame) / count;
+
+    pthread_mutex_lock(&waveform->lock);
+    int level = 0;
+    while (level + 1 < waveform->level_count &&
+           (double)((long long)WAVEFORM_BASE_FRAMES << (level + 1)) <= span) {
+        level++;
+    }
+
+    const Bin *bins = waveform->levels[level];
+    long long bin_frames = (long long)WAVEFORM_BASE_FRAMES << level;
+    size_t valid = complete ? (done_bins + ((size_t)1 << level) - 1) >> level : done_bins >> level;
+
+    // the level is chosen so a bucket spans at most three bins
+    for (int b = 0; b < count && valid > 0; b++) {
+        long long first = start_frame + (long long)(span * b);
+        long long last = start_frame + (long long)(span * (b + 1)) - 1;
+        if (last < first) last = first;
+        if (first >= done) break;
+
+        size_t i0 = (size_t)(first / bin_frames);
+        size_t i1 = (size_t)(last / bin_frames);
+        if (i0 >= valid) break;
+        if (i1 >= valid) i1 = valid - 1;
+
+        Bin bin = bins[i0];
+        float ms = bin.ms;
+        for (size_t i = i0 + 1; i <= i1; i++) {
+            if (bins[i].min < bin.min) bin.min = bins[i].min;
+            if (bins[i].max > bin.max) bin.max = bins[i].max;
+            ms += bins[i].ms;
+        }
+        buckets[b].min = bin.min;
+        buckets[b].max = bin.max;
+        buckets[b].rms = sqrtf(ms / (float)(i1 - i0 + 1));
+    }
+    pthread_mutex_unlock(&waveform->lock);
+    return 0;
+}
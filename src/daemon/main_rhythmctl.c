@@ -0,0 +1,172 @@
+#include "client/rhythm_remote.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <sys/stat.h>
+
+#define CTL_TIMEOUT_MS 2000
+#define CTL_LOAD_TIMEOUT_MS 30000
+
+static const char* STATE_NAMES[] = {"stopped", "playing", "paused"};
+
+static void print_usage(const char* program_name) {
+    printf("Usage: %s [-s socket] COMMAND [ARG]\n", program_name);
+    printf("\nCommands:\n");
+    printf("  play | pause | stop | next | prev\n");
+    printf("  load PATH            Load a file or directory (made absolute)\n");
+    printf("  seek POSITION        Seek to 0.0-1.0\n");
+    printf("  volume VOLUME        Set volume 0.0-2.0\n");
+    printf("  eq on|off            Enable or bypass the equalizer\n");
+    printf("  eq BAND GAIN_DB      Set band 1-10\n");
+    printf("  status               Print one status snapshot\n");
+    printf("  watch [vis]          Print events (and vis frames) until interrupted\n");
+    printf("  ping                 Check that the daemon answers\n");
+}
+
+static const char* state_name(int state) {
+    return state >= 0 && state <= 2 ? STATE_NAMES[state] : "unknown";
+}
+
+static int print_status(RhythmRemote* remote) {
+    RhythmStatusFrame frame;
+    RhythmError error = rhythm_remote_get_status(remote, &frame, CTL_TIMEOUT_MS);
+    if (error != RHYTHM_OK) {
+        fprintf(stderr, "status: %s\n", rhythm_engine_error_string(error));
+        return 1;
+    }
+
+    const RhythmStatus* status = &frame.status;
+    printf("state:    %s\n", state_name(status->state));
+    printf("track:    %d/%d %s\n", status->total_tracks > 0 ? status->current_track + 1 : 0,
+           status->total_tracks, frame.file_name);
+    if (status->duration_known || status->state == PLAYER_STATE_STOPPED) {
+        printf("time:     %d:%02d / %d:%02d (%.1f%%)\n", status->current_time / 60, status->current_time % 60,
+               status->total_time / 60, status->total_time % 60, status->progress * 100.0f);
+    } else {
+        printf("time:     %d:%02d (live)\n", status->current_time / 60, status->current_time % 60);
+    }
+    printf("volume:   %.2f\n", status->volume);
+    if (status->features.bpm > 0.0f) {
+        printf("tempo:    %.1f BPM (confidence %.2f)\n", status->features.bpm, status->features.beat_confidence);
+    }
+    return 0;
+}
+
+static const char* event_name(int event) {
+    switch (event) {
+        case RHYTHM_EVENT_STATE: return "state";
+        case RHYTHM_EVENT_TRACK: return "track";
+        case RHYTHM_EVENT_PLAYLIST: return "playlist";
+        case RHYTHM_EVENT_BEAT: return "beat";
+    }
+    return "unknown";
+}
+
+static int watch(RhythmRemote* remote, bool vis) {
+    uint32_t mask = RHYTHM_SUBSCRIBE_EVENTS | (vis ? RHYTHM_SUBSCRIBE_VIS : 0);
+    if (rhythm_remote_subscribe(remote, mask, CTL_TIMEOUT_MS) != RHYTHM_OK) {
+        fprintf(stderr, "watch: subscription failed\n");
+        return 1;
+    }
+
+    static const char levels[] = " .:-=+*#%@";
+    RhythmMessage message;
+    while (rhythm_remote_receive(remote, &message, -1) == 1) {
+        if (message.header.type == RHYTHM_MSG_EVENT) {
+            const RhythmEventMessage* event = &message.payload.event;
+            if (event->event == RHYTHM_EVENT_STATE) {
+                printf("%-8s %s\n", event_name(event->event), state_name(event->value));
+            } else {
+                printf("%-8s %d\n", event_name(event->event), event->value);
+            }
+        } else if (message.header.type == RHYTHM_MSG_VIS) {
+            char bars[33];
+            for (int i = 0; i < 32; i++) {
+                float level = message.payload.vis.vis_bands[i];
+                int index = level <= 0.0f ? 0 : level >= 1.0f ? 9 : (int)(level * 9.0f);
+                bars[i] = levels[index];
+            }
+            bars[32] = '\0';
+            printf("vis      [%s] %5.1f BPM\n", bars, message.payload.vis.features.bpm);
+        }
+        fflush(stdout);
+    }
+    fprintf(stderr, "watch: daemon closed the connection\n");
+    return 1;
+}
+
+static int run_command(RhythmRemote* remote, int command, int index, float value, const char* path, int timeout_ms) {
+    RhythmError error = rhythm_remote_command(remote, command, index, value, path, timeout_ms);
+    if (error != RHYTHM_OK) {
+        fprintf(stderr, "%s\n", rhythm_engine_error_string(error));
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    const char* socket_path = NULL;
+    int first = 1;
+    if (argc > 2 && (strcmp(argv[1], "-s") == 0 || strcmp(argv[1], "--socket") == 0)) {
+        socket_path = argv[2];
+        first = 3;
+    }
+    if (first >= argc || strcmp(argv[first], "-h") == 0 || strcmp(argv[first], "--help") == 0) {
+        print_usage(argv[0]);
+        return first >= argc ? 1 : 0;
+    }
+
+    const char* verb = argv[first];
+    const char* arg = first + 1 < argc ? argv[first + 1] : NULL;
+    const char* arg2 = first + 2 < argc ? argv[first + 2] : NULL;
+
+    RhythmRemote* remote = rhythm_remote_connect(socket_path);
+    if (!remote) {
+        char path[108];
+        rhythm_remote_default_path(path, sizeof(path));
+        fprintf(stderr, "Cannot reach rhythmd at %s\n", socket_path ? socket_path : path);
+        return 1;
+    }
+
+    int result = 1;
+    if (strcmp(verb, "play") == 0) {
+        result = run_command(remote, ENGINE_COMMAND_PLAY, 0, 0.0f, NULL, CTL_TIMEOUT_MS);
+    } else if (strcmp(verb, "pause") == 0) {
+        result = run_command(remote, ENGINE_COMMAND_PAUSE, 0, 0.0f, NULL, CTL_TIMEOUT_MS);
+    } else if (strcmp(verb, "stop") == 0) {
+        result = run_command(remote, ENGINE_COMMAND_STOP, 0, 0.0f, NULL, CTL_TIMEOUT_MS);
+    } else if (strcmp(verb, "next") == 0) {
+        result = run_command(remote, ENGINE_COMMAND_NEXT_TRACK, 0, 0.0f, NULL, CTL_TIMEOUT_MS);
+    } else if (strcmp(verb, "prev") == 0) {
+        result = run_command(remote, ENGINE_COMMAND_PREVIOUS_TRACK, 0, 0.0f, NULL, CTL_TIMEOUT_MS);
+    } else if (strcmp(verb, "seek") == 0 && arg) {
+        result = run_command(remote, ENGINE_COMMAND_SEEK, 0, strtof(arg, NULL), NULL, CTL_TIMEOUT_MS);
+    } else if (strcmp(verb, "volume") == 0 && arg) {
+        result = run_command(remote, ENGINE_COMMAND_SET_VOLUME, 0, strtof(arg, NULL), NULL, CTL_TIMEOUT_MS);
+    } else if (strcmp(verb, "eq") == 0 && arg && !arg2) {
+        result = run_command(remote, ENGINE_COMMAND_SET_EQ_ENABLED, strcmp(arg, "on") == 0, 0.0f, NULL, CTL_TIMEOUT_MS);
+    } else if (strcmp(verb, "eq") == 0 && arg && arg2) {
+        result = run_command(remote, ENGINE_COMMAND_SET_EQ_BAND, atoi(arg) - 1, strtof(arg2, NULL), NULL, CTL_TIMEOUT_MS);
+    } else if (strcmp(verb, "load") == 0 && arg) {
+        // the daemon may run in another directory
+        char absolute[PATH_MAX];
+        const char* path = realpath(arg, absolute) ? absolute : arg;
+        struct stat st;
+        int command = stat(path, &st) == 0 && S_ISDIR(st.st_mode) ? ENGINE_COMMAND_LOAD_DIRECTORY
+                                                                  : ENGINE_COMMAND_LOAD_FILE;
+        result = run_command(remote, command, 0, 0.0f, path, CTL_LOAD_TIMEOUT_MS);
+    } else if (strcmp(verb, "status") == 0) {
+        result = print_status(remote);
+    } else if (strcmp(verb, "watch") == 0) {
+        result = watch(remote, arg && strcmp(arg, "vis") == 0);
+    } else if (strcmp(verb, "ping") == 0) {
+        result = rhythm_remote_ping(remote, CTL_TIMEOUT_MS) == RHYTHM_OK ? 0 : 1;
+        if (result == 0) printf("pong\n");
+    } else {
+        print_usage(argv[0]);
+    }
+
+    rhythm_remote_close(remote);
+    return result;
+}
@@ -0,0 +1,87 @@
+#include "core/rhythm_engine.h"
+#include "daemon/rhythm_server.h"
+#include "client/rhythm_remote.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <sys/stat.h>
+
+static void print_usage(const char* program_name) {
+    printf("Usage: %s [-s socket] [file_or_directory]\n", program_name);
+    printf("\nServes one rhythm engine on a Unix socket; drive it with rhythmctl.\n");
+    printf("\nOptions:\n");
+    printf("  -s, --socket PATH  Socket to listen on (default $%s, then\n", RHYTHM_SOCKET_ENV);
+    printf("                     $XDG_RUNTIME_DIR/rhythmd.sock, then /tmp/rhythmd-<uid>.sock)\n");
+    printf("  -h, --help         Show this help message\n");
+}
+
+int main(int argc, char* argv[]) {
+    char socket_path[108];
+    rhythm_remote_default_path(socket_path, sizeof(socket_path));
+    const char* music_path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if ((strcmp(argv[i], "-s") == 0 || strcmp(argv[i], "--socket") == 0) && i + 1 < argc) {
+            snprintf(socket_path, sizeof(socket_path), "%s", argv[++i]);
+        } else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        } else if (argv[i][0] != '-' && !music_path) {
+            music_path = argv[i];
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    // signals are taken synchronously below, so every thread started from here blocks them
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    sigaddset(&signals, SIGHUP);
+    pthread_sigmask(SIG_BLOCK, &signals, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    RhythmEngine* engine = rhythm_engine_create();
+    if (!engine) {
+        fprintf(stderr, "Failed to create rhythm engine\n");
+        return 1;
+    }
+
+    if (music_path) {
+        struct stat st;
+        bool directory = stat(music_path, &st) == 0 && S_ISDIR(st.st_mode);
+        RhythmError result = directory ? rhythm_engine_load_directory(engine, music_path)
+                                       : rhythm_engine_load_file(engine, music_path);
+        if (result != RHYTHM_OK) {
+            fprintf(stderr, "Failed to load %s - %s\n", music_path, rhythm_engine_error_string(result));
+            rhythm_engine_destroy(engine);
+            return 1;
+        }
+    }
+
+    RhythmServer* server = rhythm_server_create(engine, socket_path);
+    if (!server) {
+        rhythm_engine_destroy(engine);
+        return 1;
+    }
+    printf("rhythmd listening on %s\n", socket_path);
+    fflush(stdout);
+
+    int signal_number = 0;
+    sigwait(&signals, &signal_number);
+
+    RhythmServerStats stats;
+    rhythm_server_get_stats(server, &stats);
+    printf("rhythmd stopping (%s): %llu clients served, %llu requests, %llu protocol errors, "
+           "%llu slow clients, %llu vis frames dropped\n",
+           strsignal(signal_number), (unsigned long long)stats.accepted, (unsigned long long)stats.requests,
+           (unsigned long long)stats.protocol_errors, (unsigned long long)stats.slow_clients,
+           (unsigned long long)stats.vis_dropped);
+
+    rhythm_server_destroy(server);
+    rhythm_engine_destroy(engine);
+    return 0;
+}
@@ -0,0 +1,517 @@
+#include "daemon/rhythm_server.h"
+#include "core/engine_host.h"
+#include "core/trace.h"
+#include "shared/rhythm_protocol.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#define SERVER_TICK_MS 16
+#define SERVER_MAX_EVENTS 64
+#define SERVER_BACKLOG 64
+#define SERVER_OUTPUT_BYTES (64 * 1024)
+#define SERVER_OUTPUT_PAUSE (SERVER_OUTPUT_BYTES / 2)  // stop reading requests past this backlog
+#define SERVER_MESSAGE_BYTES (sizeof(RhythmMessageHeader) + RHYTHM_PROTOCOL_MAX_PAYLOAD)
+
+_Static_assert(sizeof(RhythmStatusFrame) <= RHYTHM_PROTOCOL_MAX_PAYLOAD, "status frame must fit one message");
+
+typedef struct {
+    int fd;
+    uint32_t subscriptions;
+    bool closed;                                // dropped this batch, freed once it is handled
+    uint32_t interest;                          // epoll events currently armed
+
+    uint8_t input[SERVER_MESSAGE_BYTES];
+    size_t input_used;
+
+    uint8_t output[SERVER_OUTPUT_BYTES];
+    size_t output_start;
+    size_t output_end;
+} ServerClient;
+
+struct RhythmServer {
+    RhythmEngine* engine;
+    char path[sizeof(((struct sockaddr_un*)0)->sun_path)];
+    int listen_fd;
+    int wake_fd;
+    int epoll_fd;
+    pthread_t thread;
+    bool thread_started;
+    atomic_bool running;
+
+    // server thread only
+    ServerClient** clients;
+    int client_count;
+    int client_capacity;
+    RhythmStatusFrame frame;
+    RhythmStatusFrame previous;
+
+    atomic_uint stat_clients;
+    atomic_uint_least64_t stat_accepted;
+    atomic_uint_least64_t stat_requests;
+    atomic_uint_least64_t stat_protocol_errors;
+    atomic_uint_least64_t stat_slow_clients;
+    atomic_uint_least64_t stat_vis_dropped;
+};
+
+static long long now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static bool set_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+static void drop_client(RhythmServer* server, ServerClient* client) {
+    if (client->closed) return;
+    client->closed = true;
+    epoll_ctl(server->epoll_fd, EPOLL_CTL_DEL, client->fd, NULL);
+    close(client->fd);
+    client->fd = -1;
+}
+
+// frees the clients dropped while handling a batch of events
+static void sweep_clients(RhythmServer* server) {
+    int kept = 0;
+    for (int i = 0; i < server->client_count; i++) {
+        if (server->clients[i]->closed) {
+            free(server->clients[i]);
+        } else {
+            server->clients[kept++] = server->clients[i];
+        }
+    }
+    server->client_count = kept;
+    atomic_store_explicit(&server->stat_clients, (unsigned)kept, memory_order_relaxed);
+}
+
+static void flush_client(RhythmServer* server, ServerClient* client) {
+    while (client->output_start < client->output_end) {
+        ssize_t written = write(client->fd, client->output + client->output_start,
+                                client->output_end - client->output_start);
+        if (written > 0) {
+            client->output_start += (size_t)written;
+        } else if (written < 0 && errno == EINTR) {
+            continue;
+        } else if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else {
+            drop_client(server, client);
+            return;
+        }
+    }
+
+    size_t backlog = client->output_end - client->output_start;
+    if (backlog == 0) {
+        client->output_start = client->output_end = 0;
+    }
+
+    // a client that does not read its replies is not read from either
+    uint32_t interest = (backlog < SERVER_OUTPUT_PAUSE ? EPOLLIN : 0) | (backlog > 0 ? EPOLLOUT : 0);
+    if (interest != client->interest) {
+        struct epoll_event event = {.events = interest, .data.ptr = client};
+        epoll_ctl(server->epoll_fd, EPOLL_CTL_MOD, client->fd, &event);
+        client->interest = interest;
+    }
+}
+
+// appends one message to the client's output; false when it does not fit
+static bool queue_message(ServerClient* client, uint16_t type, uint32_t id, const void* payload, uint32_t length) {
+    size_t needed = sizeof(RhythmMessageHeader) + length;
+    if (client->output_end + needed > SERVER_OUTPUT_BYTES && client->output_start > 0) {
+        memmove(client->output, client->output + client->output_start, client->output_end - client->output_start);
+        client->output_end -= client->output_start;
+        client->output_start = 0;
+    }
+    if (client->output_end + needed > SERVER_OUTPUT_BYTES) return false;
+
+    RhythmMessageHeader header = {.length = length, .type = type, .version = RHYTHM_PROTOCOL_VERSION, .id = id};
+    memcpy(client->output + client->output_end, &header, sizeof(header));
+    if (length > 0) {
+        memcpy(client->output + client->output_end + sizeof(header), payload, length);
+    }
+    client->output_end += needed;
+    return true;
+}
+
+// replies are never dropped: a client that lets them back up is disconnected instead
+static void reply(RhythmServer* server, ServerClient* client, uint16_t type, uint32_t id,
+                  const void* payload, uint32_t length) {
+    if (!queue_message(client, type, id, payload, length)) {
+        atomic_fetch_add_explicit(&server->stat_slow_clients, 1, memory_order_relaxed);
+        drop_client(server, client);
+    }
+}
+
+static void reply_result(RhythmServer* server, ServerClient* client, uint32_t id, RhythmError error) {
+    RhythmResultMessage result = {.result = error};
+    reply(server, client, RHYTHM_MSG_RESULT, id, &result, sizeof(result));
+}
+
+static bool handle_message(RhythmServer* server, ServerClient* client,
+                           const RhythmMessageHeader* header, const uint8_t* payload) {
+    TRACE_SCOPE("server_request");
+    atomic_fetch_add_explicit(&server->stat_requests, 1, memory_order_relaxed);
+
+    switch (header->type) {
+        case RHYTHM_MSG_PING:
+            reply_result(server, client, header->id, RHYTHM_OK);
+            return true;
+
+        case RHYTHM_MSG_GET_STATUS:
+            rhythm_engine_get_status_frame(server->engine, &server->frame);
+            reply(server, client, RHYTHM_MSG_STATUS, header->id, &server->frame, sizeof(server->frame));
+            return true;
+
+        case RHYTHM_MSG_SUBSCRIBE: {
+            if (header->length < sizeof(RhythmSubscribeMessage)) return false;
+            RhythmSubscribeMessage subscribe;
+            memcpy(&subscribe, payload, sizeof(subscribe));
+            client->subscriptions = subscribe.mask;
+            reply_result(server, client, header->id, RHYTHM_OK);
+            return true;
+        }
+
+        case RHYTHM_MSG_COMMAND: {
+            if (header->length < sizeof(RhythmCommandMessage)) return false;
+            RhythmCommandMessage command;
+            memcpy(&command, payload, sizeof(command));
+
+            char path[ENGINE_SHM_PATH_MAX];
+            size_t path_length = header->length - sizeof(command);
+            if (path_length >= sizeof(path)) return false;
+            memcpy(path, payload + sizeof(command), path_length);
+            path[path_length] = '\0';
+
+            RhythmError error = engine_host_run_command(server->engine, command.command, command.index,
+                                                        command.value, path);
+            reply_result(server, client, header->id, error);
+            return true;
+        }
+    }
+    return false;
+}
+
+static void read_client(RhythmServer* server, ServerClient* client) {
+    while (client->output_end - client->output_start < SERVER_OUTPUT_PAUSE) {
+        ssize_t count = read(client->fd, client->input + client->input_used,
+                             sizeof(client->input) - client->input_used);
+        if (count < 0 && errno == EINTR) continue;
+        if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (count <= 0) {
+            drop_client(server, client);
+            return;
+        }
+        client->input_used += (size_t)count;
+
+        // every complete message in the buffer is handled before reading on
+        size_t offset = 0;
+        while (client->input_used - offset >= sizeof(RhythmMessageHeader)) {
+            RhythmMessageHeader header;
+            memcpy(&header, client->input + offset, sizeof(header));
+            if (header.version != RHYTHM_PROTOCOL_VERSION || header.length > RHYTHM_PROTOCOL_MAX_PAYLOAD) {
+                atomic_fetch_add_explicit(&server->stat_protocol_errors, 1, memory_order_relaxed);
+                drop_client(server, client);
+                return;
+            }
+
+            size_t size = sizeof(header) + header.length;
+            if (client->input_used - offset < size) break;
+            if (!handle_message(server, client, &header, client->input + offset + sizeof(header))) {
+                atomic_fetch_add_explicit(&server->stat_protocol_errors, 1, memory_order_relaxed);
+                drop_client(server, client);
+                return;
+            }
+            if (client->closed) return;
+            offset += size;
+        }
+
+        if (offset > 0) {
+            memmove(client->input, client->input + offset, client->input_used - offset);
+            client->input_used -= offset;
+        }
+    }
+
+    // replies to a whole batch of pipelined requests go out in one write
+    flush_client(server, client);
+}
+
+static void accept_clients(RhythmServer* server) {
+    for (;;) {
+        int fd = accept(server->listen_fd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                fprintf(stderr, "rhythmd: accept failed: %s\n", strerror(errno));
+            }
+            return;
+        }
+
+        if (server->client_count == server->client_capacity) {
+            int capacity = server->client_capacity ? server->client_capacity * 2 : 16;
+            ServerClient** clients = realloc(server->clients, (size_t)capacity * sizeof(ServerClient*));
+            if (!clients) {
+                close(fd);
+                continue;
+            }
+            server->clients = clients;
+            server->client_capacity = capacity;
+        }
+
+        ServerClient* client = calloc(1, sizeof(ServerClient));
+        if (!client || !set_nonblocking(fd)) {
+            free(client);
+            close(fd);
+            continue;
+        }
+        client->fd = fd;
+        client->interest = EPOLLIN;
+
+        struct epoll_event event = {.events = EPOLLIN, .data.ptr = client};
+        if (epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0) {
+            free(client);
+            close(fd);
+            continue;
+        }
+        server->clients[server->client_count++] = client;
+        atomic_fetch_add_explicit(&server->stat_accepted, 1, memory_order_relaxed);
+        atomic_store_explicit(&server->stat_clients, (unsigned)server->client_count, memory_order_relaxed);
+    }
+}
+
+static void broadcast_event(RhythmServer* server, RhythmEventType type, int32_t value) {
+    RhythmEventMessage event = {.event = type, .value = value};
+    for (int i = 0; i < server->client_count; i++) {
+        ServerClient* client = server->clients[i];
+        if (!client->closed && (client->subscriptions & RHYTHM_SUBSCRIBE_EVENTS)) {
+            reply(server, client, RHYTHM_MSG_EVENT, 0, &event, sizeof(event));
+        }
+    }
+}
+
+static void tick(RhythmServer* server) {
+    TRACE_SCOPE("server_tick");
+    rhythm_engine_update(server->engine);
+    rhythm_engine_get_status_frame(server->engine, &server->frame);
+
+    const RhythmStatus* now = &server->frame.status;
+    const RhythmStatus* before = &server->previous.status;
+    if (now->total_tracks != before->total_tracks) {
+        broadcast_event(server, RHYTHM_EVENT_PLAYLIST, now->total_tracks);
+    }
+    if (now->current_track != before->current_track || server->frame.file_sequence != server->previous.file_sequence) {
+        broadcast_event(server, RHYTHM_EVENT_TRACK, now->current_track);
+    }
+    if (now->state != before->state) {
+        broadcast_event(server, RHYTHM_EVENT_STATE, now->state);
+    }
+    if (now->features.beat_count != before->features.beat_count) {
+        broadcast_event(server, RHYTHM_EVENT_BEAT, (int32_t)now->features.beat_count);
+    }
+    server->previous = server->frame;
+
+    // vis frames are best effort: a subscriber with a backlog just misses some
+    RhythmVisMessage vis;
+    vis.sequence = server->frame.sequence;
+    memcpy(vis.vis_bands, now->vis_bands, sizeof(vis.vis_bands));
+    vis.features = now->features;
+    for (int i = 0; i < server->client_count; i++) {
+        ServerClient* client = server->clients[i];
+        if (client->closed || !(client->subscriptions & RHYTHM_SUBSCRIBE_VIS)) continue;
+        if (!queue_message(client, RHYTHM_MSG_VIS, 0, &vis, sizeof(vis))) {
+            atomic_fetch_add_explicit(&server->stat_vis_dropped, 1, memory_order_relaxed);
+        }
+    }
+
+    for (int i = 0; i < server->client_count; i++) {
+        ServerClient* client = server->clients[i];
+        if (!client->closed && client->output_end > client->output_start) {
+            flush_client(server, client);
+        }
+    }
+}
+
+// a vis subscriber is a front-end on screen; with none the engine may drop to low power
+// and the status ticks coalesce with it
+static int tick_interval(RhythmServer* server) {
+    bool watched = false;
+    for (int i = 0; i < server->client_count && !watched; i++) {
+        ServerClient* client = server->clients[i];
+        watched = !client->closed && (client->subscriptions & RHYTHM_SUBSCRIBE_VIS);
+    }
+    rhythm_engine_set_interactive(server->engine, watched);
+    return rhythm_engine_is_low_power(server->engine) ? rhythm_engine_get_tick_interval_ms(server->engine)
+                                                      : SERVER_TICK_MS;
+}
+
+static void* server_thread_main(void* arg) {
+    RhythmServer* server = arg;
+    TRACE_THREAD_NAME("rhythmd");
+
+    struct epoll_event events[SERVER_MAX_EVENTS];
+    long long next_tick = now_ms() + SERVER_TICK_MS;
+
+    while (atomic_load_explicit(&server->running, memory_order_relaxed)) {
+        long long timeout = next_tick - now_ms();
+        int count = epoll_wait(server->epoll_fd, events, SERVER_MAX_EVENTS, timeout > 0 ? (int)timeout : 0);
+        if (count < 0 && errno != EINTR) {
+            fprintf(stderr, "rhythmd: epoll_wait failed: %s\n", strerror(errno));
+            break;
+        }
+
+        for (int i = 0; i < count; i++) {
+            void* source = events[i].data.ptr;
+            if (source == &server->listen_fd) {
+                accept_clients(server);
+            } else if (source == &server->wake_fd) {
+                uint64_t value;
+                ssize_t ignored = read(server->wake_fd, &value, sizeof(value));
+                (void)ignored;
+            } else {
+                ServerClient* client = source;
+                if (client->closed) continue;
+                if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) read_client(server, client);
+                if (!client->closed && (events[i].events & EPOLLOUT)) flush_client(server, client);
+            }
+        }
+
+        long long now = now_ms();
+        int interval = tick_interval(server);
+        if (next_tick - now > interval) next_tick = now + interval;
+        if (now >= next_tick) {
+            tick(server);
+            next_tick = now - next_tick > interval ? now + interval : next_tick + interval;
+        }
+        sweep_clients(server);
+    }
+    return NULL;
+}
+
+static int open_listener(const char* path) {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "rhythmd: socket path too long: %s\n", path);
+        return -1;
+    }
+    strcpy(address.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+
+    int bound = bind(fd, (struct sockaddr*)&address, sizeof(address));
+    if (bound != 0 && errno == EADDRINUSE) {
+        // the file stays behind when a daemon dies; only a live listener keeps the path
+        int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        bool live = probe >= 0 && connect(probe, (struct sockaddr*)&address, sizeof(address)) == 0;
+        if (probe >= 0) close(probe);
+        if (live) {
+            fprintf(stderr, "rhythmd: another daemon is listening on %s\n", path);
+            close(fd);
+            return -1;
+        }
+        unlink(path);
+        bound = bind(fd, (struct sockaddr*)&address, sizeof(address));
+    }
+    if (bound != 0) {
+        fprintf(stderr, "rhythmd: failed to bind %s: %s\n", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    if (listen(fd, SERVER_BACKLOG) != 0 || !set_nonblocking(fd)) {
+        fprintf(stderr, "rhythmd: failed to listen on %s: %s\n", path, strerror(errno));
+        close(fd);
+        unlink(path);
+        return -1;
+    }
+    return fd;
+}
+
+RhythmServer* rhythm_server_create(RhythmEngine* engine, const char* socket_path) {
+    if (!engine || !socket_path) return NULL;
+
+    RhythmServer* server = calloc(1, sizeof(RhythmServer));
+    if (!server) return NULL;
+    server->engine = engine;
+    server->listen_fd = server->wake_fd = server->epoll_fd = -1;
+    snprintf(server->path, sizeof(server->path), "%s", socket_path);
+
+    server->listen_fd = open_listener(server->path);
+    if (server->listen_fd < 0) {
+        free(server);
+        return NULL;
+    }
+
+    server->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    server->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    struct epoll_event listen_event = {.events = EPOLLIN, .data.ptr = &server->listen_fd};
+    struct epoll_event wake_event = {.events = EPOLLIN, .data.ptr = &server->wake_fd};
+    if (server->wake_fd < 0 || server->epoll_fd < 0 ||
+        epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, server->listen_fd, &listen_event) != 0 ||
+        epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, server->wake_fd, &wake_event) != 0) {
+        fprintf(stderr, "rhythmd: failed to set up epoll: %s\n", strerror(errno));
+        rhythm_server_destroy(server);
+        return NULL;
+    }
+
+    rhythm_engine_get_status_frame(engine, &server->previous);
+
+    atomic_init(&server->running, true);
+    if (pthread_create(&server->thread, NULL, server_thread_main, server) != 0) {
+        fprintf(stderr, "rhythmd: failed to start server thread\n");
+        rhythm_server_destroy(server);
+        return NULL;
+    }
+    server->thread_started = true;
+    return server;
+}
+
+void rhythm_server_destroy(RhythmServer* server) {
+    if (!server) return;
+
+    if (server->thread_started) {
+        atomic_store(&server->running, false);
+        uint64_t one = 1;
+        ssize_t ignored = write(server->wake_fd, &one, sizeof(one));
+        (void)ignored;
+        pthread_join(server->thread, NULL);
+    }
+
+    for (int i = 0; i < server->client_count; i++) {
+        if (!server->clients[i]->closed) close(server->clients[i]->fd);
+        free(server->clients[i]);
+    }
+    free(server->clients);
+
+    if (server->epoll_fd >= 0) close(server->epoll_fd);
+    if (server->wake_fd >= 0) close(server->wake_fd);
+    if (server->listen_fd >= 0) {
+        close(server->listen_fd);
+        unlink(server->path);
+    }
+    free(server);
+}
+
+void rhythm_server_get_stats(RhythmServer* server, RhythmServerStats* stats) {
+    if (!server || !stats) return;
+    stats->clients = atomic_load_explicit(&server->stat_clients, memory_order_relaxed);
+    stats->accepted = atomic_load_explicit(&server->stat_accepted, memory_order_relaxed);
+    stats->requests = atomic_load_explicit(&server->stat_requests, memory_order_relaxed);
+    stats->protocol_errors = atomic_load_explicit(&server->stat_protocol_errors, memory_order_relaxed);
+    stats->slow_clients = atomic_load_explicit(&server->stat_slow_clients, memory_order_relaxed);
+    stats->vis_dropped = atomic_load_explicit(&server->stat_vis_dropped, memory_order_relaxed);
+}
@@ -7,9 +7,12 @@
 #include <signal.h>
 #include <errno.h>
 #include "core/rhythm_engine.h"
+#include "core/engine_host.h"
 #include "shared/common.h"
+#include "shared/engine_shm.h"
 
 static RhythmEngine* global_engine = NULL;
+static EngineHost* global_host = NULL;
 static pid_t love2d_pid = -1;
 
 static void cleanup_handler(int sig) {
@@ -20,6 +23,8 @@ static void cleanup_handler(int sig) {
         waitpid(love2d_pid, NULL, 0);
     }
 
+    engine_host_destroy(global_host);
+    global_host = NULL;
     if (global_engine) {
         rhythm_engine_destroy(global_engine);
         global_engine = NULL;
@@ -103,6 +108,16 @@ static int launch_love2d(const char* music_path) {
             exit(1);
         }
 
+        // the GUI drives this process's engine instead of opening a second one
+        char host_arg[128];
+        if (global_host) {
+            snprintf(host_arg, sizeof(host_arg), "%s=%s", ENGINE_SHM_ENV, engine_host_name(global_host));
+            if (putenv(host_arg) != 0) {
+                perror("Error: Failed to set environment variable");
+                exit(1);
+            }
+        }
+
         char ld_path[2048];
         const char* current_ld_path = getenv("LD_LIBRARY_PATH");
         const char* lib_dir = strstr(engine_lib_path, "/usr/lib/") ? "/usr/lib" : exe_path;
@@ -203,10 +218,17 @@ int main(int argc, char* argv[]) {
         printf("Starting GUI with drag-and-drop support...\n");
     }
 
+    global_host = engine_host_create(global_engine, NULL);
+    if (!global_host) {
+        printf("Engine host unavailable, the GUI will open its own engine\n");
+    }
+
     printf("Launching GUI...\n");
     int result = launch_love2d(music_path);
 
     printf("Cleaning up...\n");
+    engine_host_destroy(global_host);
+    global_host = NULL;
     if (global_engine) {
         rhythm_engine_destroy(global_engine);
         global_engine = NULL;
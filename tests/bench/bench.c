@@ -0,0 +1,339 @@
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <math.h>
+#include <sys/utsname.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#define MAX_BENCH_CASES 128
+#define DEFAULT_REPETITIONS 30
+#define DEFAULT_WARMUP 3
+#define DEFAULT_MIN_REP_NS 10000000.0
+
+typedef struct {
+    const char *name;
+    long iterations;
+    int repetitions;
+    double min_ns;
+    double median_ns;
+    double mean_ns;
+    double p99_ns;
+    double stddev_ns;
+    double cycles_per_op;
+    double allocs_per_op;
+    double alloc_bytes_per_op;
+    double mb_per_s;
+    double items_per_s;
+    bool skipped;
+} BenchResult;
+
+typedef struct {
+    const char *filter;
+    const char *json_path;
+    int repetitions;
+    int warmup;
+    double min_rep_ns;
+} BenchOptions;
+
+static BenchCase cases[MAX_BENCH_CASES];
+static int case_count = 0;
+
+// per thread, so pool workers and the logger do not count against the case being timed
+static __thread unsigned long alloc_count;
+static __thread unsigned long alloc_bytes;
+static volatile const void *consume_sink;
+
+// counting allocator: interposes libc so strdup, opendir and friends are seen too
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void __libc_free(void *ptr);
+
+void *malloc(size_t size) {
+    alloc_count++;
+    alloc_bytes += size;
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+    alloc_count++;
+    alloc_bytes += count * size;
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+    alloc_count++;
+    alloc_bytes += size;
+    return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr) {
+    __libc_free(ptr);
+}
+
+void bench_register(const BenchCase *bench_case) {
+    if (case_count >= MAX_BENCH_CASES) {
+        fprintf(stderr, "Too many benchmark cases, dropping %s\n", bench_case->name);
+        return;
+    }
+    cases[case_count++] = *bench_case;
+}
+
+void bench_consume(const void *data) {
+    consume_sink = data;
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static uint64_t read_cycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double da = *(const double *)a;
+    double db = *(const double *)b;
+    return (da > db) - (da < db);
+}
+
+static double percentile(const double *sorted, int count, double p) {
+    if (count == 0) return 0.0;
+    double rank = p * (count - 1);
+    int low = (int)rank;
+    int high = low + 1 < count ? low + 1 : low;
+    double frac = rank - low;
+    return sorted[low] + (sorted[high] - sorted[low]) * frac;
+}
+
+// doubles the iteration count until one repetition takes at least min_rep_ns
+static long calibrate(const BenchCase *bench_case, void *state, double min_rep_ns) {
+    long iterations = 1;
+    while (iterations < (1L << 30)) {
+        double start = now_ns();
+        bench_case->run(state, iterations);
+        double elapsed = now_ns() - start;
+        if (elapsed >= min_rep_ns) break;
+        if (elapsed < min_rep_ns / 100.0) {
+            iterations *= 10;
+        } else {
+            iterations *= 2;
+        }
+    }
+    return iterations;
+}
+
+static void run_case(const BenchCase *bench_case, const BenchOptions *options, BenchResult *result) {
+    memset(result, 0, sizeof(BenchResult));
+    result->name = bench_case->name;
+
+    void *state = bench_case->setup ? bench_case->setup() : NULL;
+    if (bench_case->setup && !state) {
+        result->skipped = true;
+        return;
+    }
+
+    long iterations = calibrate(bench_case, state, options->min_rep_ns);
+    for (int i = 0; i < options->warmup; i++) {
+        bench_case->run(state, iterations);
+    }
+
+    double *samples = __libc_malloc(sizeof(double) * options->repetitions);
+    double *cycles = __libc_malloc(sizeof(double) * options->repetitions);
+    unsigned long allocs_before = alloc_count;
+    unsigned long bytes_before = alloc_bytes;
+
+    for (int rep = 0; rep < options->repetitions; rep++) {
+        uint64_t cycles_start = read_cycles();
+        double start = now_ns();
+        bench_case->run(state, iterations);
+        double elapsed = now_ns() - start;
+        uint64_t cycles_elapsed = read_cycles() - cycles_start;
+
+        samples[rep] = elapsed / iterations;
+        cycles[rep] = (double)cycles_elapsed / iterations;
+    }
+
+    double total_ops = (double)iterations * options->repetitions;
+    result->allocs_per_op = (alloc_count - allocs_before) / total_ops;
+    result->alloc_bytes_per_op = (alloc_bytes - bytes_before) / total_ops;
+
+    if (bench_case->teardown) {
+        bench_case->teardown(state);
+    }
+
+    double sum = 0.0;
+    for (int rep = 0; rep < options->repetitions; rep++) {
+        sum += samples[rep];
+    }
+    double mean = sum / options->repetitions;
+    double variance = 0.0;
+    for (int rep = 0; rep < options->repetitions; rep++) {
+        variance += (samples[rep] - mean) * (samples[rep] - mean);
+    }
+
+    qsort(samples, options->repetitions, sizeof(double), compare_doubles);
+    qsort(cycles, options->repetitions, sizeof(double), compare_doubles);
+
+    result->iterations = iterations;
+    result->repetitions = options->repetitions;
+    result->min_ns = samples[0];
+    result->median_ns = percentile(samples, options->repetitions, 0.5);
+    result->mean_ns = mean;
+    result->p99_ns = percentile(samples, options->repetitions, 0.99);
+    result->stddev_ns = sqrt(variance / options->repetitions);
+    result->cycles_per_op = percentile(cycles, options->repetitions, 0.5);
+    if (result->median_ns > 0.0) {
+        result->mb_per_s = bench_case->bytes_per_op * 1e3 / result->median_ns;
+        result->items_per_s = bench_case->items_per_op * 1e9 / result->median_ns;
+    }
+
+    __libc_free(samples);
+    __libc_free(cycles);
+}
+
+static void print_result(FILE *out, const BenchResult *result) {
+    if (result->skipped) {
+        fprintf(out, "%-36s %s\n", result->name, "skipped");
+        return;
+    }
+
+    fprintf(out, "%-36s %12.1f %12.1f %12.1f %10.1f %9.2f",
+           result->name, result->median_ns, result->p99_ns, result->min_ns,
+           result->cycles_per_op, result->allocs_per_op);
+    if (result->mb_per_s > 0.0) {
+        fprintf(out, " %10.1f MB/s", result->mb_per_s);
+    } else if (result->items_per_s > 0.0) {
+        fprintf(out, " %10.3g it/s", result->items_per_s);
+    }
+    fprintf(out, "\n");
+}
+
+static void write_json(FILE *out, const BenchResult *results, int count, const BenchOptions *options) {
+    struct utsname host;
+    uname(&host);
+
+    fprintf(out, "{\n");
+    fprintf(out, "  \"suite\": \"rhythm_bench\",\n");
+    fprintf(out, "  \"timestamp\": %ld,\n", (long)time(NULL));
+    fprintf(out, "  \"host\": \"%s\",\n", host.nodename);
+    fprintf(out, "  \"machine\": \"%s\",\n", host.machine);
+    fprintf(out, "  \"repetitions\": %d,\n", options->repetitions);
+    fprintf(out, "  \"warmup\": %d,\n", options->warmup);
+    fprintf(out, "  \"results\": [\n");
+
+    int written = 0;
+    for (int i = 0; i < count; i++) {
+        const BenchResult *r = &results[i];
+        if (r->skipped) continue;
+
+        fprintf(out, "%s    {\"name\": \"%s\", \"iterations\": %ld, "
+                "\"ns_per_op\": {\"min\": %.3f, \"median\": %.3f, \"mean\": %.3f, \"p99\": %.3f, \"stddev\": %.3f}, "
+                "\"cycles_per_op\": %.1f, \"allocs_per_op\": %.4f, \"alloc_bytes_per_op\": %.1f, "
+                "\"mb_per_s\": %.3f, \"items_per_s\": %.3f}",
+                written ? ",\n" : "", r->name, r->iterations,
+                r->min_ns, r->median_ns, r->mean_ns, r->p99_ns, r->stddev_ns,
+                r->cycles_per_op, r->allocs_per_op, r->alloc_bytes_per_op,
+                r->mb_per_s, r->items_per_s);
+        written++;
+    }
+
+    fprintf(out, "\n  ]\n}\n");
+}
+
+static void print_usage(const char *program_name) {
+    printf("Usage: %s [options]\n", program_name);
+    printf("  --filter TEXT    Only run cases whose name contains TEXT\n");
+    printf("  --reps N         Timed repetitions per case (default %d)\n", DEFAULT_REPETITIONS);
+    printf("  --warmup N       Untimed warmup repetitions (default %d)\n", DEFAULT_WARMUP);
+    printf("  --min-time MS    Minimum duration of one repetition (default %.0f)\n", DEFAULT_MIN_REP_NS / 1e6);
+    printf("  --json PATH      Write results as JSON to PATH ('-' for stdout)\n");
+    printf("  --list           List available cases\n");
+}
+
+int main(int argc, char *argv[]) {
+    BenchOptions options = {
+        .filter = NULL,
+        .json_path = NULL,
+        .repetitions = DEFAULT_REPETITIONS,
+        .warmup = DEFAULT_WARMUP,
+        .min_rep_ns = DEFAULT_MIN_REP_NS
+    };
+    bool list_only = false;
+
+    bench_register_dsp();
+    bench_register_playlist();
+    bench_register_engine();
+    bench_register_decoder();
+    bench_register_mixer();
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            options.filter = argv[++i];
+        } else if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc) {
+            options.repetitions = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) {
+            options.warmup = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) {
+            options.min_rep_ns = atof(argv[++i]) * 1e6;
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            options.json_path = argv[++i];
+        } else if (strcmp(argv[i], "--list") == 0) {
+            list_only = true;
+        } else {
+            print_usage(argv[0]);
+            return strcmp(argv[i], "--help") == 0 ? 0 : 1;
+        }
+    }
+    if (options.repetitions < 1) options.repetitions = 1;
+    if (options.warmup < 0) options.warmup = 0;
+
+    if (list_only) {
+        for (int i = 0; i < case_count; i++) {
+            printf("%s\n", cases[i].name);
+        }
+        return 0;
+    }
+
+    BenchResult *results = __libc_calloc(case_count, sizeof(BenchResult));
+    int result_count = 0;
+    FILE *table = (options.json_path && strcmp(options.json_path, "-") == 0) ? stderr : stdout;
+
+    fprintf(table, "%-36s %12s %12s %12s %10s %9s %15s\n",
+            "case", "median ns", "p99 ns", "min ns", "cycles", "allocs", "throughput");
+    fflush(table);
+
+    for (int i = 0; i < case_count; i++) {
+        if (options.filter && !strstr(cases[i].name, options.filter)) continue;
+
+        run_case(&cases[i], &options, &results[result_count]);
+        print_result(table, &results[result_count]);
+        fflush(table);
+        result_count++;
+    }
+
+    if (options.json_path) {
+        FILE *out = strcmp(options.json_path, "-") == 0 ? stdout : fopen(options.json_path, "w");
+        if (!out) {
+            fprintf(stderr, "Cannot write %s\n", options.json_path);
+            __libc_free(results);
+            return 1;
+        }
+        write_json(out, results, result_count, &options);
+        if (out != stdout) fclose(out);
+    }
+
+    __libc_free(results);
+    return 0;
+}
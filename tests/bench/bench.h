@@ -0,0 +1,28 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+// setup runs once outside the timed region and may return NULL to skip the case
+typedef struct {
+    const char *name;
+    void *(*setup)(void);
+    void (*run)(void *state, long iterations);
+    void (*teardown)(void *state);
+    size_t bytes_per_op;
+    size_t items_per_op;
+} BenchCase;
+
+void bench_register(const BenchCase *bench_case);
+
+// keeps the optimizer from discarding results computed only for timing
+void bench_consume(const void *data);
+
+void bench_register_dsp(void);
+void bench_register_playlist(void);
+void bench_register_engine(void);
+void bench_register_decoder(void);
+void bench_register_mixer(void);
+
+#endif
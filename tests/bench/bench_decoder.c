@@ -0,0 +1,208 @@
+#include "bench.h"
+#include "core/decoder.h"
+#include "core/loudness.h"
+#include "core/waveform.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#define BLOCK_FRAMES 1024
+#define WAV_FRAMES (48000 * 10)
+
+typedef struct {
+    Decoder *decoder;
+    const char *path;
+    float output[BLOCK_FRAMES * 2];
+} DecoderState;
+
+static int write_wav(const char *path, uint16_t format, uint16_t bits) {
+    FILE *f = fopen(path, "wb");
+    if (!f) return -1;
+
+    uint16_t channels = 2, block_align = (uint16_t)(channels * bits / 8);
+    uint32_t rate = 48000, byte_rate = rate * block_align, fmt_size = 16;
+    uint32_t data_size = (uint32_t)WAV_FRAMES * block_align, riff_size = 36 + data_size;
+
+    fwrite("RIFF", 1, 4, f);
+    fwrite(&riff_size, 4, 1, f);
+    fwrite("WAVEfmt ", 1, 8, f);
+    fwrite(&fmt_size, 4, 1, f);
+    fwrite(&format, 2, 1, f);
+    fwrite(&channels, 2, 1, f);
+    fwrite(&rate, 4, 1, f);
+    fwrite(&byte_rate, 4, 1, f);
+    fwrite(&block_align, 2, 1, f);
+    fwrite(&bits, 2, 1, f);
+    fwrite("data", 1, 4, f);
+    fwrite(&data_size, 4, 1, f);
+
+    for (int i = 0; i < WAV_FRAMES * channels; i++) {
+        if (bits == 16) {
+            int16_t sample = (int16_t)((i * 37) & 0x7fff);
+            fwrite(&sample, sizeof(sample), 1, f);
+        } else {
+            float sample = (float)((i * 37) & 0x7fff) / 32768.0f;
+            fwrite(&sample, sizeof(sample), 1, f);
+        }
+    }
+    fclose(f);
+    return 0;
+}
+
+static void *wav_setup(const char *path, uint16_t format, uint16_t bits) {
+    DecoderState *state = malloc(sizeof(DecoderState));
+    if (!state) return NULL;
+
+    state->path = path;
+    state->decoder = wav_decoder_create();
+    if (!state->decoder || write_wav(path, format, bits) != 0 || decoder_open(state->decoder, path) != 0) {
+        decoder_destroy(state->decoder);
+        unlink(path);
+        free(state);
+        return NULL;
+    }
+    return state;
+}
+
+static void *wav_s16_setup(void) {
+    return wav_setup("/tmp/rhythm_bench_s16.wav", 1, 16);
+}
+
+static void *wav_f32_setup(void) {
+    return wav_setup("/tmp/rhythm_bench_f32.wav", 3, 32);
+}
+
+static void wav_teardown(void *arg) {
+    DecoderState *state = arg;
+    decoder_destroy(state->decoder);
+    unlink(state->path);
+    free(state);
+}
+
+static void run_wav_read(void *arg, long iterations) {
+    DecoderState *state = arg;
+    for (long i = 0; i < iterations; i++) {
+        size_t frames = 0;
+        if (decoder_read(state->decoder, state->output, BLOCK_FRAMES, &frames) != DECODER_OK) {
+            decoder_seek(state->decoder, 0);
+        }
+        bench_consume(state->output);
+    }
+}
+
+static void run_wav_seek(void *arg, long iterations) {
+    DecoderState *state = arg;
+    for (long i = 0; i < iterations; i++) {
+        decoder_seek(state->decoder, (i * 7919) % WAV_FRAMES);
+        size_t frames = 0;
+        decoder_read(state->decoder, state->output, 1, &frames);
+        bench_consume(state->output);
+    }
+}
+
+typedef struct {
+    LoudnessMeter *meter;
+    float input[BLOCK_FRAMES * 2];
+} MeterState;
+
+static void *meter_setup(void) {
+    MeterState *state = malloc(sizeof(MeterState));
+    if (!state) return NULL;
+
+    state->meter = loudness_meter_create(48000, 2);
+    if (!state->meter) {
+        free(state);
+        return NULL;
+    }
+    for (int i = 0; i < BLOCK_FRAMES * 2; i++) {
+        state->input[i] = 0.5f * sinf((float)i * 0.031f);
+    }
+    return state;
+}
+
+static void meter_teardown(void *arg) {
+    MeterState *state = arg;
+    loudness_meter_destroy(state->meter);
+    free(state);
+}
+
+static void run_meter(void *arg, long iterations) {
+    MeterState *state = arg;
+    for (long i = 0; i < iterations; i++) {
+        loudness_meter_add_frames(state->meter, state->input, BLOCK_FRAMES);
+    }
+    bench_consume(state->meter);
+}
+
+typedef struct {
+    Waveform *waveform;
+    WaveformBucket buckets[512];
+    long long start;
+    long long end;
+} WaveformState;
+
+static void *waveform_setup_range(bool zoomed) {
+    const char *path = "/tmp/rhythm_bench_waveform.wav";
+    WaveformState *state = malloc(sizeof(WaveformState));
+    if (!state || write_wav(path, 1, 16) != 0) {
+        free(state);
+        return NULL;
+    }
+
+    state->waveform = waveform_open(path, NULL);
+    for (int i = 0; i < 1000 && state->waveform && !waveform_is_complete(state->waveform); i++) {
+        usleep(1000);
+    }
+    unlink(path);
+    if (!state->waveform || !waveform_is_complete(state->waveform)) {
+        waveform_destroy(state->waveform);
+        free(state);
+        return NULL;
+    }
+
+    long long total = waveform_total_frames(state->waveform);
+    state->start = zoomed ? total / 3 : 0;
+    state->end = zoomed ? state->start + 48000 : total;
+    return state;
+}
+
+static void *waveform_full_setup(void) {
+    return waveform_setup_range(false);
+}
+
+static void *waveform_zoomed_setup(void) {
+    return waveform_setup_range(true);
+}
+
+static void waveform_teardown(void *arg) {
+    WaveformState *state = arg;
+    waveform_destroy(state->waveform);
+    free(state);
+}
+
+static void run_waveform_query(void *arg, long iterations) {
+    WaveformState *state = arg;
+    for (long i = 0; i < iterations; i++) {
+        waveform_get_buckets(state->waveform, state->start, state->end, state->buckets, 512);
+        bench_consume(state->buckets);
+    }
+}
+
+void bench_register_decoder(void) {
+    const size_t stereo_bytes = BLOCK_FRAMES * 2 * sizeof(float);
+
+    bench_register(&(BenchCase){ "wav_decoder_read/s16", wav_s16_setup, run_wav_read,
+                                 wav_teardown, stereo_bytes, BLOCK_FRAMES });
+    bench_register(&(BenchCase){ "wav_decoder_read/f32", wav_f32_setup, run_wav_read,
+                                 wav_teardown, stereo_bytes, BLOCK_FRAMES });
+    bench_register(&(BenchCase){ "wav_decoder_seek/random", wav_s16_setup, run_wav_seek,
+                                 wav_teardown, 0, 1 });
+    bench_register(&(BenchCase){ "loudness_meter_add_frames/stereo", meter_setup, run_meter,
+                                 meter_teardown, stereo_bytes, BLOCK_FRAMES });
+    bench_register(&(BenchCase){ "waveform_get_buckets/full_512", waveform_full_setup, run_waveform_query,
+                                 waveform_teardown, 0, 512 });
+    bench_register(&(BenchCase){ "waveform_get_buckets/1s_512", waveform_zoomed_setup, run_waveform_query,
+                                 waveform_teardown, 0, 512 });
+}
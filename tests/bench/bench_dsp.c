@@ -0,0 +1,197 @@
+#include "bench.h"
+#include "core/audio_converter.h"
+#include "core/dsp_chain.h"
+
+#define BLOCK_FRAMES 1024
+
+typedef struct {
+    float input[BLOCK_FRAMES * 2 + 64];
+    float output[BLOCK_FRAMES * 2 + 64];
+    float scratch[BLOCK_FRAMES * 2 + 64];
+    float bands[32];
+} DspState;
+
+static void fill_signal(float *samples, int count) {
+    for (int i = 0; i < count; i++) {
+        samples[i] = 0.8f * sinf((float)i * 0.031f) + 0.1f * sinf((float)i * 0.47f);
+    }
+}
+
+static void *dsp_setup(void) {
+    DspState *state = malloc(sizeof(DspState));
+    if (!state) return NULL;
+    fill_signal(state->input, BLOCK_FRAMES * 2 + 64);
+    memset(state->output, 0, sizeof(state->output));
+    return state;
+}
+
+static void dsp_teardown(void *state) {
+    free(state);
+}
+
+static void run_mono_to_stereo(void *arg, long iterations) {
+    DspState *state = arg;
+    for (long i = 0; i < iterations; i++) {
+        convert_audio_format(state->input, state->output, BLOCK_FRAMES, 1, 2);
+        bench_consume(state->output);
+    }
+}
+
+static void run_stereo_to_mono(void *arg, long iterations) {
+    DspState *state = arg;
+    for (long i = 0; i < iterations; i++) {
+        convert_audio_format(state->input, state->output, BLOCK_FRAMES, 2, 1);
+        bench_consume(state->output);
+    }
+}
+
+// one 48 kHz period worth of 44.1 kHz input
+static void run_resample_44k_to_48k(void *arg, long iterations) {
+    DspState *state = arg;
+    int input_frames = BLOCK_FRAMES * 44100 / 48000;
+    for (long i = 0; i < iterations; i++) {
+        resample_audio(state->input, state->output, input_frames, BLOCK_FRAMES, 2);
+        bench_consume(state->output);
+    }
+}
+
+// the same conversion through the kernel a track's plan resolves to
+static void run_plan_resample_44k_to_48k(void *arg, long iterations) {
+    DspState *state = arg;
+    ConversionPlan plan;
+    conversion_plan_init(&plan, 44100, 2, 48000, 2, BLOCK_FRAMES);
+    int input_frames = BLOCK_FRAMES * 44100 / 48000;
+    for (long i = 0; i < iterations; i++) {
+        plan.resample(state->input, state->output, input_frames, BLOCK_FRAMES);
+        bench_consume(state->output);
+    }
+}
+
+static void run_plan_mono_44k_to_stereo_48k(void *arg, long iterations) {
+    DspState *state = arg;
+    ConversionPlan plan;
+    conversion_plan_init(&plan, 44100, 1, 48000, 2, BLOCK_FRAMES);
+    int input_frames = BLOCK_FRAMES * 44100 / 48000;
+    for (long i = 0; i < iterations; i++) {
+        plan.remap(state->input, state->scratch, input_frames);
+        plan.resample(state->scratch, state->output, input_frames, BLOCK_FRAMES);
+        bench_consume(state->output);
+    }
+}
+
+static void run_apply_volume(void *arg, long iterations) {
+    DspState *state = arg;
+    for (long i = 0; i < iterations; i++) {
+        memcpy(state->output, state->input, BLOCK_FRAMES * 2 * sizeof(float));
+        apply_volume(state->output, BLOCK_FRAMES * 2, 1.4f);
+        bench_consume(state->output);
+    }
+}
+
+static void run_vis_bands(void *arg, long iterations) {
+    DspState *state = arg;
+    for (long i = 0; i < iterations; i++) {
+        compute_vis_bands(state->input, BLOCK_FRAMES * 2, state->bands, 32);
+        bench_consume(state->bands);
+    }
+}
+
+typedef struct {
+    DspChain *chain;
+    float input[BLOCK_FRAMES * 2];
+    float block[BLOCK_FRAMES * 2];
+    size_t frames;
+    int iteration;
+} EqState;
+
+static const float EQ_GAINS[10] = { 4.0f, 3.0f, 1.5f, -1.0f, -2.0f, 0.5f, 2.0f, 3.5f, 2.5f, -3.0f };
+
+// the engine's 10-band layout with every band active, so nothing is bypassed
+static void *eq_setup_frames(size_t frames) {
+    EqState *state = malloc(sizeof(EqState));
+    if (!state) return NULL;
+
+    state->chain = dsp_chain_create();
+    if (!state->chain) {
+        free(state);
+        return NULL;
+    }
+    state->frames = frames;
+    state->iteration = 0;
+
+    DspStageParams preamp = { DSP_STAGE_PREAMP, 0.0f, -4.0f, 0.0f, true };
+    dsp_chain_add_stage(state->chain, &preamp);
+    for (int i = 0; i < 10; i++) {
+        DspStageType type = i == 0 ? DSP_STAGE_LOW_SHELF : i == 9 ? DSP_STAGE_HIGH_SHELF : DSP_STAGE_PEAKING;
+        DspStageParams band = { type, 31.25f * (float)(1 << i), EQ_GAINS[i], type == DSP_STAGE_PEAKING ? 1.41f : 1.0f, true };
+        dsp_chain_add_stage(state->chain, &band);
+    }
+    fill_signal(state->input, BLOCK_FRAMES * 2);
+    return state;
+}
+
+static void *eq_setup_256(void) {
+    return eq_setup_frames(256);
+}
+
+static void *eq_setup_1024(void) {
+    return eq_setup_frames(BLOCK_FRAMES);
+}
+
+static void eq_teardown(void *arg) {
+    EqState *state = arg;
+    dsp_chain_destroy(state->chain);
+    free(state);
+}
+
+// one call per audio callback, processing in place as on the device buffer; the copy stands in for the ring read
+static void run_eq(void *arg, long iterations) {
+    EqState *state = arg;
+    for (long i = 0; i < iterations; i++) {
+        memcpy(state->block, state->input, state->frames * 2 * sizeof(float));
+        dsp_chain_process(state->chain, state->block, state->frames, 2, 48000);
+        bench_consume(state->block);
+    }
+}
+
+// a slider being dragged: one band changes every callback, so one stage is always gliding
+static void run_eq_ramping(void *arg, long iterations) {
+    EqState *state = arg;
+    DspStageParams band;
+    for (long i = 0; i < iterations; i++) {
+        int stage = 1 + (state->iteration % 10);
+        dsp_chain_get_stage(state->chain, stage, &band);
+        band.gain_db = (state->iteration & 1) ? 6.0f : -6.0f;
+        dsp_chain_set_stage(state->chain, stage, &band);
+        state->iteration++;
+
+        memcpy(state->block, state->input, state->frames * 2 * sizeof(float));
+        dsp_chain_process(state->chain, state->block, state->frames, 2, 48000);
+        bench_consume(state->block);
+    }
+}
+
+void bench_register_dsp(void) {
+    const size_t stereo_bytes = BLOCK_FRAMES * 2 * sizeof(float);
+
+    bench_register(&(BenchCase){ "convert_audio_format/mono_to_stereo", dsp_setup, run_mono_to_stereo,
+                                 dsp_teardown, stereo_bytes, BLOCK_FRAMES });
+    bench_register(&(BenchCase){ "convert_audio_format/stereo_to_mono", dsp_setup, run_stereo_to_mono,
+                                 dsp_teardown, stereo_bytes, BLOCK_FRAMES });
+    bench_register(&(BenchCase){ "resample_audio/44k1_to_48k", dsp_setup, run_resample_44k_to_48k,
+                                 dsp_teardown, stereo_bytes, BLOCK_FRAMES });
+    bench_register(&(BenchCase){ "conversion_plan/resample_44k1_to_48k", dsp_setup, run_plan_resample_44k_to_48k,
+                                 dsp_teardown, stereo_bytes, BLOCK_FRAMES });
+    bench_register(&(BenchCase){ "conversion_plan/mono_44k1_to_stereo_48k", dsp_setup, run_plan_mono_44k_to_stereo_48k,
+                                 dsp_teardown, stereo_bytes, BLOCK_FRAMES });
+    bench_register(&(BenchCase){ "apply_volume/gain_clip", dsp_setup, run_apply_volume,
+                                 dsp_teardown, stereo_bytes, BLOCK_FRAMES });
+    bench_register(&(BenchCase){ "compute_vis_bands/32", dsp_setup, run_vis_bands,
+                                 dsp_teardown, stereo_bytes, BLOCK_FRAMES });
+    bench_register(&(BenchCase){ "dsp_chain_process/eq10_256", eq_setup_256, run_eq,
+                                 eq_teardown, 256 * 2 * sizeof(float), 256 });
+    bench_register(&(BenchCase){ "dsp_chain_process/eq10_1024", eq_setup_1024, run_eq,
+                                 eq_teardown, stereo_bytes, BLOCK_FRAMES });
+    bench_register(&(BenchCase){ "dsp_chain_process/eq10_1024_ramping", eq_setup_1024, run_eq_ramping,
+                                 eq_teardown, stereo_bytes, BLOCK_FRAMES });
+}
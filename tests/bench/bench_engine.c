@@ -0,0 +1,54 @@
+#include "bench.h"
+#include "core/rhythm_engine.h"
+
+// needs a working audio device; the cases are skipped when none is available
+static void *engine_setup(void) {
+    RhythmEngine *engine = rhythm_engine_create();
+    if (!engine) return NULL;
+
+    FILE *f = fopen("/tmp/rhythm_bench_status.mp3", "w");
+    if (f) fclose(f);
+    rhythm_engine_load_file(engine, "/tmp/rhythm_bench_status.mp3");
+    return engine;
+}
+
+static void engine_teardown(void *state) {
+    rhythm_engine_destroy((RhythmEngine *)state);
+    unlink("/tmp/rhythm_bench_status.mp3");
+}
+
+static void run_status_cached(void *state, long iterations) {
+    RhythmEngine *engine = state;
+    for (long i = 0; i < iterations; i++) {
+        RhythmStatus status = rhythm_engine_get_status(engine);
+        bench_consume(&status);
+    }
+}
+
+static void run_status_refresh(void *state, long iterations) {
+    RhythmEngine *engine = state;
+    for (long i = 0; i < iterations; i++) {
+        rhythm_engine_update(engine);
+        RhythmStatus status = rhythm_engine_get_status(engine);
+        bench_consume(&status);
+    }
+}
+
+static void run_status_frame(void *state, long iterations) {
+    RhythmEngine *engine = state;
+    RhythmStatusFrame frame = {0};
+    for (long i = 0; i < iterations; i++) {
+        rhythm_engine_update(engine);
+        rhythm_engine_get_status_frame(engine, &frame);
+        bench_consume(&frame);
+    }
+}
+
+void bench_register_engine(void) {
+    bench_register(&(BenchCase){ "rhythm_engine_get_status/cached", engine_setup, run_status_cached,
+                                 engine_teardown, 0, 0 });
+    bench_register(&(BenchCase){ "rhythm_engine_get_status/refresh", engine_setup, run_status_refresh,
+                                 engine_teardown, 0, 0 });
+    bench_register(&(BenchCase){ "rhythm_engine_get_status_frame/refresh", engine_setup, run_status_frame,
+                                 engine_teardown, 0, 0 });
+}
@@ -0,0 +1,112 @@
+#include "bench.h"
+#include "core/mixer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#define BLOCK_FRAMES 1024
+#define VOICE_FRAMES 48000
+
+typedef struct {
+    Mixer *mixer;
+    const char *path;
+    float bus[BLOCK_FRAMES * 2];
+} MixerState;
+
+// one second of 16-bit stereo; every voice loops it
+static int write_voice(const char *path) {
+    FILE *f = fopen(path, "wb");
+    if (!f) return -1;
+
+    uint16_t format = 1, channels = 2, bits = 16, block_align = 4;
+    uint32_t rate = 48000, byte_rate = rate * block_align, fmt_size = 16;
+    uint32_t data_size = VOICE_FRAMES * block_align, riff_size = 36 + data_size;
+
+    fwrite("RIFF", 1, 4, f);
+    fwrite(&riff_size, 4, 1, f);
+    fwrite("WAVEfmt ", 1, 8, f);
+    fwrite(&fmt_size, 4, 1, f);
+    fwrite(&format, 2, 1, f);
+    fwrite(&channels, 2, 1, f);
+    fwrite(&rate, 4, 1, f);
+    fwrite(&byte_rate, 4, 1, f);
+    fwrite(&block_align, 2, 1, f);
+    fwrite(&bits, 2, 1, f);
+    fwrite("data", 1, 4, f);
+    fwrite(&data_size, 4, 1, f);
+    for (int i = 0; i < VOICE_FRAMES * 2; i++) {
+        int16_t sample = (int16_t)((i * 37) & 0x0fff);
+        fwrite(&sample, sizeof(sample), 1, f);
+    }
+    fclose(f);
+    return 0;
+}
+
+// unthreaded mixer so one iteration is exactly one decode pass plus one callback's mix
+static void *mixer_setup(int voices) {
+    MixerState *state = calloc(1, sizeof(MixerState));
+    if (!state) return NULL;
+
+    state->path = "/tmp/rhythm_bench_mixer.wav";
+    state->mixer = mixer_create(false);
+    if (!state->mixer || write_voice(state->path) != 0) {
+        mixer_destroy(state->mixer);
+        free(state);
+        return NULL;
+    }
+    mixer_set_format(state->mixer, 48000, 2);
+
+    for (int i = 0; i < voices; i++) {
+        MixerVoiceParams params = {0.05f, (float)(i % 9 - 4) / 4.0f, false, true};
+        if (mixer_play(state->mixer, state->path, &params) < 0) {
+            mixer_destroy(state->mixer);
+            unlink(state->path);
+            free(state);
+            return NULL;
+        }
+    }
+    while (mixer_decode(state->mixer)) {}
+    return state;
+}
+
+static void *mixer_8_setup(void) {
+    return mixer_setup(8);
+}
+
+static void *mixer_32_setup(void) {
+    return mixer_setup(32);
+}
+
+static void *mixer_64_setup(void) {
+    return mixer_setup(MIXER_MAX_VOICES);
+}
+
+static void mixer_teardown(void *arg) {
+    MixerState *state = arg;
+    mixer_destroy(state->mixer);
+    unlink(state->path);
+    free(state);
+}
+
+static void run_mixer_block(void *arg, long iterations) {
+    MixerState *state = arg;
+    for (long i = 0; i < iterations; i++) {
+        mixer_decode(state->mixer);
+        memset(state->bus, 0, sizeof(state->bus));
+        mixer_render(state->mixer, state->bus, BLOCK_FRAMES, 2, 48000, 1.0f);
+        bench_consume(state->bus);
+    }
+}
+
+void bench_register_mixer(void) {
+    const size_t stereo_bytes = BLOCK_FRAMES * 2 * sizeof(float);
+
+    bench_register(&(BenchCase){ "mixer_decode_render/8_voices", mixer_8_setup, run_mixer_block,
+                                 mixer_teardown, stereo_bytes, 8 * BLOCK_FRAMES });
+    bench_register(&(BenchCase){ "mixer_decode_render/32_voices", mixer_32_setup, run_mixer_block,
+                                 mixer_teardown, stereo_bytes, 32 * BLOCK_FRAMES });
+    bench_register(&(BenchCase){ "mixer_decode_render/64_voices", mixer_64_setup, run_mixer_block,
+                                 mixer_teardown, stereo_bytes, 64 * BLOCK_FRAMES });
+}
@@ -0,0 +1,216 @@
+#include "bench.h"
+#include "core/playlist.h"
+#include "core/playlist_view.h"
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#define PLAYLIST_ENTRIES 1000
+#define TREE_ARTISTS 10
+#define TREE_ALBUMS 10
+#define TREE_MP3_FILES 1000
+#define TREE_OTHER_FILES 200
+#define VIEW_ENTRIES 500000
+#define VIEW_ROWS 40
+
+typedef struct {
+    char paths[PLAYLIST_ENTRIES][64];
+} AddFileState;
+
+typedef struct {
+    char root[64];
+} TreeState;
+
+static void *add_file_setup(void) {
+    AddFileState *state = malloc(sizeof(AddFileState));
+    if (!state) return NULL;
+    for (int i = 0; i < PLAYLIST_ENTRIES; i++) {
+        snprintf(state->paths[i], sizeof(state->paths[i]), "/music/artist_%03d/track_%04d.mp3", i % 97, i);
+    }
+    return state;
+}
+
+static void add_file_teardown(void *state) {
+    free(state);
+}
+
+static void run_add_file(void *arg, long iterations) {
+    AddFileState *state = arg;
+    for (long i = 0; i < iterations; i++) {
+        Playlist *playlist = playlist_create();
+        for (int j = 0; j < PLAYLIST_ENTRIES; j++) {
+            playlist_add_file(playlist, state->paths[j]);
+        }
+        bench_consume(playlist);
+        playlist_destroy(playlist);
+    }
+}
+
+static void touch_file(const char *path) {
+    FILE *f = fopen(path, "w");
+    if (f) fclose(f);
+}
+
+// artist/album/track layout of a music library: every album holds its tracks and covers
+static void tree_album_path(char *out, size_t size, const char *root, int artist, int album) {
+    snprintf(out, size, "%s/artist_%02d/album_%02d", root, artist, album);
+}
+
+static void *tree_setup(void) {
+    TreeState *state = malloc(sizeof(TreeState));
+    if (!state) return NULL;
+
+    snprintf(state->root, sizeof(state->root), "/tmp/rhythm_bench_XXXXXX");
+    if (!mkdtemp(state->root)) {
+        free(state);
+        return NULL;
+    }
+
+    char album[128], path[192];
+    for (int artist = 0; artist < TREE_ARTISTS; artist++) {
+        snprintf(path, sizeof(path), "%s/artist_%02d", state->root, artist);
+        mkdir(path, 0755);
+        for (int a = 0; a < TREE_ALBUMS; a++) {
+            tree_album_path(album, sizeof(album), state->root, artist, a);
+            mkdir(album, 0755);
+            for (int i = 0; i < TREE_MP3_FILES / (TREE_ARTISTS * TREE_ALBUMS); i++) {
+                snprintf(path, sizeof(path), "%s/track_%02d.mp3", album, i);
+                touch_file(path);
+            }
+            for (int i = 0; i < TREE_OTHER_FILES / (TREE_ARTISTS * TREE_ALBUMS); i++) {
+                snprintf(path, sizeof(path), "%s/cover_%02d.jpg", album, i);
+                touch_file(path);
+            }
+        }
+    }
+    return state;
+}
+
+static void tree_teardown(void *arg) {
+    TreeState *state = arg;
+    char album[128], path[192];
+    for (int artist = 0; artist < TREE_ARTISTS; artist++) {
+        for (int a = 0; a < TREE_ALBUMS; a++) {
+            tree_album_path(album, sizeof(album), state->root, artist, a);
+            for (int i = 0; i < TREE_MP3_FILES / (TREE_ARTISTS * TREE_ALBUMS); i++) {
+                snprintf(path, sizeof(path), "%s/track_%02d.mp3", album, i);
+                unlink(path);
+            }
+            for (int i = 0; i < TREE_OTHER_FILES / (TREE_ARTISTS * TREE_ALBUMS); i++) {
+                snprintf(path, sizeof(path), "%s/cover_%02d.jpg", album, i);
+                unlink(path);
+            }
+            rmdir(album);
+        }
+        snprintf(path, sizeof(path), "%s/artist_%02d", state->root, artist);
+        rmdir(path);
+    }
+    rmdir(state->root);
+    free(state);
+}
+
+// playlist_add_directory reads one level; a library scan walks every subdirectory
+static int add_tree(Playlist *playlist, const char *directory) {
+    int added = playlist_add_directory(playlist, directory);
+    DIR *dir = opendir(directory);
+    if (!dir) return added;
+
+    struct dirent *entry;
+    char path[1024];
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.') continue;
+        snprintf(path, sizeof(path), "%s/%s", directory, entry->d_name);
+        struct stat st;
+        if (stat(path, &st) == 0 && S_ISDIR(st.st_mode)) added += add_tree(playlist, path);
+    }
+    closedir(dir);
+    return added;
+}
+
+static void run_add_directory(void *arg, long iterations) {
+    TreeState *state = arg;
+    for (long i = 0; i < iterations; i++) {
+        Playlist *playlist = playlist_create();
+        add_tree(playlist, state->root);
+        bench_consume(playlist);
+        playlist_destroy(playlist);
+    }
+}
+
+typedef struct {
+    Playlist *playlist;
+    PlaylistView *view;
+} ViewState;
+
+static void *view_setup(void) {
+    ViewState *state = calloc(1, sizeof(ViewState));
+    if (!state) return NULL;
+    state->playlist = playlist_create();
+    state->view = playlist_view_create();
+
+    char path[96];
+    for (int i = 0; i < VIEW_ENTRIES && state->playlist && state->view; i++) {
+        snprintf(path, sizeof(path), "/music/artist_%03d/album_%02d/track_%06d.mp3", i % 997, i % 13, i);
+        if (playlist_add_file(state->playlist, path) < 0) break;
+    }
+    if (playlist_get_count(state->playlist) != VIEW_ENTRIES) {
+        playlist_view_destroy(state->view);
+        playlist_destroy(state->playlist);
+        free(state);
+        return NULL;
+    }
+    return state;
+}
+
+static void view_teardown(void *arg) {
+    ViewState *state = arg;
+    playlist_view_destroy(state->view);
+    playlist_destroy(state->playlist);
+    free(state);
+}
+
+// one frame of scrolling through the whole playlist: sync plus every visible row
+static void run_view_window(void *arg, long iterations) {
+    ViewState *state = arg;
+    playlist_view_set_query(state->view, "");
+    for (long i = 0; i < iterations; i++) {
+        playlist_view_sync(state->view, state->playlist, VIEW_ROWS);
+        playlist_view_move(state->view, 7919);
+        int top = playlist_view_top(state->view);
+        for (int row = 0; row < VIEW_ROWS; row++) {
+            int index = playlist_view_index_at(state->view, top + row);
+            if (index >= 0) bench_consume(playlist_get_file_at(state->playlist, index));
+        }
+    }
+}
+
+// typing "track_0042" one key at a time, each query searched to completion
+static void run_view_type_ahead(void *arg, long iterations) {
+    ViewState *state = arg;
+    static const char query[] = "track_0042";
+    char typed[sizeof(query)];
+
+    for (long i = 0; i < iterations; i++) {
+        playlist_view_set_query(state->view, "");
+        playlist_view_sync(state->view, state->playlist, VIEW_ROWS);
+        for (size_t k = 1; k < sizeof(query); k++) {
+            memcpy(typed, query, k);
+            typed[k] = '\0';
+            playlist_view_set_query(state->view, typed);
+            while (playlist_view_step(state->view, state->playlist, UINT64_MAX)) {
+            }
+        }
+        bench_consume(state->view);
+    }
+}
+
+void bench_register_playlist(void) {
+    bench_register(&(BenchCase){ "playlist_add_file/1000", add_file_setup, run_add_file,
+                                 add_file_teardown, 0, PLAYLIST_ENTRIES });
+    bench_register(&(BenchCase){ "playlist_add_directory/tree_1000+200", tree_setup, run_add_directory,
+                                 tree_teardown, 0, TREE_MP3_FILES + TREE_OTHER_FILES });
+    bench_register(&(BenchCase){ "playlist_view/window_500k", view_setup, run_view_window,
+                                 view_teardown, 0, VIEW_ROWS });
+    bench_register(&(BenchCase){ "playlist_view/type_ahead_500k", view_setup, run_view_type_ahead,
+                                 view_teardown, 0, VIEW_ENTRIES });
+}
@@ -0,0 +1,145 @@
+// Cost of each additional engine in one process: creates N engines (zones), has each
+// play the same WAV, then reports threads, resident memory and CPU time per engine
+// while they run. Without a consuming audio device the CPU figure is the idle cost of
+// keeping a playing engine serviced; with one it includes decoding.
+#include "core/rhythm_engine.h"
+#include "core/audio_context.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define WAV_PATH "/tmp/rhythm_engine_scaling.wav"
+
+static double now_s(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// VmRSS and Threads from /proc/self/status
+static void read_process(long *rss_kb, int *threads) {
+    *rss_kb = 0;
+    *threads = 0;
+    FILE *f = fopen("/proc/self/status", "r");
+    if (!f) return;
+
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        if (strncmp(line, "VmRSS:", 6) == 0) *rss_kb = atol(line + 6);
+        if (strncmp(line, "Threads:", 8) == 0) *threads = atoi(line + 8);
+    }
+    fclose(f);
+}
+
+static int write_wav(int seconds) {
+    FILE *f = fopen(WAV_PATH, "wb");
+    if (!f) return -1;
+
+    uint16_t format = 1, channels = 2, bits = 16, block_align = 4;
+    uint32_t rate = 44100, byte_rate = rate * block_align, fmt_size = 16;
+    uint32_t data_size = rate * (uint32_t)seconds * block_align, riff_size = 36 + data_size;
+
+    fwrite("RIFF", 1, 4, f);
+    fwrite(&riff_size, 4, 1, f);
+    fwrite("WAVEfmt ", 1, 8, f);
+    fwrite(&fmt_size, 4, 1, f);
+    fwrite(&format, 2, 1, f);
+    fwrite(&channels, 2, 1, f);
+    fwrite(&rate, 4, 1, f);
+    fwrite(&byte_rate, 4, 1, f);
+    fwrite(&block_align, 2, 1, f);
+    fwrite(&bits, 2, 1, f);
+    fwrite("data", 1, 4, f);
+    fwrite(&data_size, 4, 1, f);
+    for (uint32_t i = 0; i < data_size / 2; i++) {
+        int16_t sample = (int16_t)((i * 37) & 0x0fff);
+        fwrite(&sample, sizeof(sample), 1, f);
+    }
+    fclose(f);
+    return 0;
+}
+
+static void print_usage(const char *program_name) {
+    printf("Usage: %s [-n engines] [-t seconds]\n", program_name);
+    printf("\n  -n  engines to create (default 32)\n");
+    printf("  -t  seconds to measure while they play (default 5)\n");
+    printf("\nRHYTHM_DECODER_THREADS sets the shared decoder pool size.\n");
+}
+
+int main(int argc, char *argv[]) {
+    int count = 32;
+    int seconds = 5;
+    for (int i = 1; i < argc; i++) {
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(argv[i], "-n") == 0 && value) {
+            count = atoi(value);
+        } else if (strcmp(argv[i], "-t") == 0 && value) {
+            seconds = atoi(value);
+        } else {
+            print_usage(argv[0]);
+            return strcmp(argv[i], "-h") == 0 ? 0 : 1;
+        }
+        i++;
+    }
+    if (count < 1 || seconds < 1 || write_wav(10) != 0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    RhythmEngine **engines = calloc((size_t)count, sizeof(RhythmEngine *));
+    if (!engines) return 1;
+
+    long rss_before;
+    int threads_before;
+    read_process(&rss_before, &threads_before);
+
+    double create_start = now_s(CLOCK_MONOTONIC);
+    for (int i = 0; i < count; i++) {
+        engines[i] = rhythm_engine_create();
+        if (!engines[i] || rhythm_engine_load_file(engines[i], WAV_PATH) != RHYTHM_OK ||
+            rhythm_engine_play(engines[i]) != RHYTHM_OK) {
+            fprintf(stderr, "Engine %d failed to start\n", i);
+            return 1;
+        }
+    }
+    double create_ms = (now_s(CLOCK_MONOTONIC) - create_start) * 1000.0;
+
+    // let every decode-ahead ring fill before measuring the steady state
+    usleep(500000);
+    DecoderPool *pool = audio_context_acquire_pool();
+    DecoderPoolStats pool_before, pool_after;
+    decoder_pool_get_stats(pool, &pool_before);
+
+    double wall_start = now_s(CLOCK_MONOTONIC);
+    double cpu_start = now_s(CLOCK_PROCESS_CPUTIME_ID);
+    sleep((unsigned)seconds);
+    double cpu_s = now_s(CLOCK_PROCESS_CPUTIME_ID) - cpu_start;
+    double wall_s = now_s(CLOCK_MONOTONIC) - wall_start;
+
+    decoder_pool_get_stats(pool, &pool_after);
+    audio_context_release_pool();
+
+    long rss_after;
+    int threads_after;
+    read_process(&rss_after, &threads_after);
+
+    printf("engines=%d pool_threads=%d pool_jobs=%d\n", count, pool_after.threads, pool_after.jobs);
+    printf("start:   %.2f ms per engine (create, load, play)\n", create_ms / count);
+    printf("threads: %d -> %d (%.2f per engine)\n", threads_before, threads_after,
+           (double)(threads_after - threads_before) / count);
+    printf("memory:  %ld KB -> %ld KB RSS (%.0f KB per engine)\n", rss_before, rss_after,
+           (double)(rss_after - rss_before) / count);
+    printf("cpu:     %.3f%% of one core total, %.4f%% per engine\n", 100.0 * cpu_s / wall_s,
+           100.0 * cpu_s / wall_s / count);
+    printf("pool:    %.0f wakeups/s, %.0f steps/s, %.0f steals/s\n",
+           (double)(pool_after.wakeups - pool_before.wakeups) / wall_s,
+           (double)(pool_after.steps - pool_before.steps) / wall_s,
+           (double)(pool_after.steals - pool_before.steals) / wall_s);
+
+    for (int i = 0; i < count; i++) rhythm_engine_destroy(engines[i]);
+    free(engines);
+    unlink(WAV_PATH);
+    return 0;
+}
@@ -0,0 +1,123 @@
+// Decode time of replaying and seeking back through a file with and without the PCM
+// cache: decodes the whole file once, then replays it and reads from a set of earlier
+// positions, and reports per phase the CPU time of each and the cache's hits and memory.
+// Without a file a five minute WAV is written to /tmp; MP3s show the larger difference.
+#include "core/pcm_cache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define WAV_PATH "/tmp/rhythm_pcm_cache_replay.wav"
+#define SEEKS 64
+#define SEEK_FRAMES 4096
+
+static int write_wav(const char *path, int seconds) {
+    FILE *f = fopen(path, "wb");
+    if (!f) return -1;
+
+    uint16_t format = 1, channels = 2, bits = 16, block_align = 4;
+    uint32_t rate = 44100, byte_rate = rate * block_align, fmt_size = 16;
+    uint32_t data_size = rate * (uint32_t)seconds * block_align, riff_size = 36 + data_size;
+
+    fwrite("RIFF", 1, 4, f);
+    fwrite(&riff_size, 4, 1, f);
+    fwrite("WAVEfmt ", 1, 8, f);
+    fwrite(&fmt_size, 4, 1, f);
+    fwrite(&format, 2, 1, f);
+    fwrite(&channels, 2, 1, f);
+    fwrite(&rate, 4, 1, f);
+    fwrite(&byte_rate, 4, 1, f);
+    fwrite(&block_align, 2, 1, f);
+    fwrite(&bits, 2, 1, f);
+    fwrite("data", 1, 4, f);
+    fwrite(&data_size, 4, 1, f);
+    for (uint32_t i = 0; i < data_size / 2; i++) {
+        int16_t sample = (int16_t)((i * 37) & 0x0fff);
+        fwrite(&sample, sizeof(sample), 1, f);
+    }
+    fclose(f);
+    return 0;
+}
+
+static double cpu_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static long long read_frames(Decoder *decoder, float *buffer, long long limit) {
+    long long total = 0;
+    size_t frames = 0;
+    while ((limit < 0 || total < limit) && decoder_read(decoder, buffer, SEEK_FRAMES, &frames) == DECODER_OK) {
+        total += (long long)frames;
+    }
+    return total;
+}
+
+static int run_phase(const char *path, const char *name, size_t budget, bool pack16) {
+    Decoder *source = wav_decoder_probe(path) ? wav_decoder_create() : mpg123_decoder_create();
+    PcmCache *cache = pcm_cache_create(budget, pack16);
+    Decoder *decoder = pcm_cache_decoder_create(cache);
+    float *buffer = malloc(SEEK_FRAMES * DECODER_MAX_CHANNELS * sizeof(float));
+    if (!source || !decoder || !buffer) return -1;
+    pcm_cache_decoder_set_source(decoder, source);
+
+    double start = cpu_ms();
+    if (decoder_open(decoder, path) != 0) return -1;
+    long long length = read_frames(decoder, buffer, -1);
+    decoder_close(decoder);
+    double first = cpu_ms() - start;
+
+    start = cpu_ms();
+    decoder_open(decoder, path);
+    read_frames(decoder, buffer, -1);
+    double replay = cpu_ms() - start;
+
+    // back from the end in even steps, as a listener scrubbing backwards would
+    start = cpu_ms();
+    for (int i = SEEKS; i > 0; i--) {
+        decoder_seek(decoder, length * i / (SEEKS + 1));
+        read_frames(decoder, buffer, SEEK_FRAMES);
+    }
+    double seeks = cpu_ms() - start;
+    decoder_close(decoder);
+
+    PcmCacheStats stats;
+    pcm_cache_get_stats(cache, &stats);
+    printf("%-7s first %.1f ms  replay %.1f ms  %d seeks back %.1f ms  hits %llu/%llu  memory %.1f MB\n",
+           name, first, replay, SEEKS, seeks, (unsigned long long)stats.hits,
+           (unsigned long long)(stats.hits + stats.misses), stats.bytes / (1024.0 * 1024.0));
+
+    decoder_destroy(decoder);
+    decoder_destroy(source);
+    pcm_cache_destroy(cache);
+    free(buffer);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 2 || (argc == 2 && strcmp(argv[1], "-h") == 0)) {
+        printf("Usage: %s [file]\n\n  file  MP3 or WAV to replay (default: a generated WAV in %s)\n", argv[0], WAV_PATH);
+        return argc == 2 ? 0 : 1;
+    }
+
+    const char *path = argc == 2 ? argv[1] : WAV_PATH;
+    if (argc == 1 && write_wav(path, 300) != 0) {
+        fprintf(stderr, "Cannot write %s\n", path);
+        return 1;
+    }
+
+    // a budget larger than the file, so every segment stays
+    size_t budget = 512 * 1024 * 1024;
+    if (run_phase(path, "off", 0, false) != 0 ||
+        run_phase(path, "float", budget, false) != 0 ||
+        run_phase(path, "16-bit", budget, true) != 0) {
+        fprintf(stderr, "Cannot decode %s\n", path);
+        return 1;
+    }
+
+    if (argc == 1) unlink(path);
+    return 0;
+}
@@ -0,0 +1,167 @@
+// Wakeups and CPU use of background playback with and without low-power mode: plays a
+// WAV, ticks the engine the way a front-end would (every get_tick_interval_ms) and
+// reports per phase the context switches of all the process's threads per second, the
+// process CPU time as a share of one CPU, device callbacks per second and, where the
+// kernel exposes cpuidle, the share of time the CPUs spent in a deeper idle state.
+#include "core/rhythm_engine.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <dirent.h>
+#include <unistd.h>
+
+#define WAV_PATH "/tmp/rhythm_power_usage.wav"
+
+static int write_wav(int seconds) {
+    FILE *f = fopen(WAV_PATH, "wb");
+    if (!f) return -1;
+
+    uint16_t format = 1, channels = 2, bits = 16, block_align = 4;
+    uint32_t rate = 44100, byte_rate = rate * block_align, fmt_size = 16;
+    uint32_t data_size = rate * (uint32_t)seconds * block_align, riff_size = 36 + data_size;
+
+    fwrite("RIFF", 1, 4, f);
+    fwrite(&riff_size, 4, 1, f);
+    fwrite("WAVEfmt ", 1, 8, f);
+    fwrite(&fmt_size, 4, 1, f);
+    fwrite(&format, 2, 1, f);
+    fwrite(&channels, 2, 1, f);
+    fwrite(&rate, 4, 1, f);
+    fwrite(&byte_rate, 4, 1, f);
+    fwrite(&block_align, 2, 1, f);
+    fwrite(&bits, 2, 1, f);
+    fwrite("data", 1, 4, f);
+    fwrite(&data_size, 4, 1, f);
+    for (uint32_t i = 0; i < data_size / 2; i++) {
+        int16_t sample = (int16_t)((i * 37) & 0x0fff);
+        fwrite(&sample, sizeof(sample), 1, f);
+    }
+    fclose(f);
+    return 0;
+}
+
+static double now_seconds(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// voluntary and involuntary switches summed over every thread: each is one wakeup
+static unsigned long long context_switches(void) {
+    unsigned long long total = 0;
+    DIR *tasks = opendir("/proc/self/task");
+    if (!tasks) return 0;
+
+    struct dirent *entry;
+    while ((entry = readdir(tasks)) != NULL) {
+        if (entry->d_name[0] == '.') continue;
+        char path[300];
+        snprintf(path, sizeof(path), "/proc/self/task/%s/status", entry->d_name);
+        FILE *f = fopen(path, "r");
+        if (!f) continue;
+
+        char line[256];
+        unsigned long long value;
+        while (fgets(line, sizeof(line), f)) {
+            if (sscanf(line, "voluntary_ctxt_switches: %llu", &value) == 1 ||
+                sscanf(line, "nonvoluntary_ctxt_switches: %llu", &value) == 1) {
+                total += value;
+            }
+        }
+        fclose(f);
+    }
+    closedir(tasks);
+    return total;
+}
+
+// microseconds all CPUs spent in idle states past the first (polling) one; -1 without cpuidle
+static double deep_idle_us(void) {
+    double total = 0.0;
+    bool found = false;
+    for (int cpu = 0; cpu < 1024; cpu++) {
+        for (int state = 1; state < 16; state++) {
+            char path[128];
+            snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cpuidle/state%d/time", cpu, state);
+            FILE *f = fopen(path, "r");
+            if (!f) break;
+            unsigned long long us;
+            if (fscanf(f, "%llu", &us) == 1) {
+                total += (double)us;
+                found = true;
+            }
+            fclose(f);
+        }
+    }
+    return found ? total : -1.0;
+}
+
+static void run_phase(RhythmEngine *engine, const char *name, int seconds) {
+    RhythmStats stats;
+    rhythm_engine_reset_stats(engine);
+    unsigned long long switches = context_switches();
+    double idle = deep_idle_us();
+    double wall = now_seconds(CLOCK_MONOTONIC);
+    double cpu = now_seconds(CLOCK_PROCESS_CPUTIME_ID);
+
+    while (now_seconds(CLOCK_MONOTONIC) - wall < seconds) {
+        rhythm_engine_update(engine);
+        RhythmStatus status = rhythm_engine_get_status(engine);
+        (void)status;
+        usleep((useconds_t)rhythm_engine_get_tick_interval_ms(engine) * 1000);
+    }
+
+    double elapsed = now_seconds(CLOCK_MONOTONIC) - wall;
+    double cpu_used = now_seconds(CLOCK_PROCESS_CPUTIME_ID) - cpu;
+    unsigned long long woken = context_switches() - switches;
+    rhythm_engine_get_stats(engine, &stats);
+
+    RhythmAudioInfo info;
+    rhythm_engine_get_audio_info(engine, &info);
+    printf("%-7s wakeups %7.1f/s  cpu %5.2f%%  callbacks %6.1f/s  period %5d  ring %6.0f ms  underflows %llu",
+           name, woken / elapsed, 100.0 * cpu_used / elapsed, stats.callbacks / elapsed, info.frames_per_buffer,
+           stats.ring_capacity_ms, (unsigned long long)(stats.underflows + stats.starved_callbacks));
+
+    double idle_after = deep_idle_us();
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (idle >= 0.0 && idle_after >= idle && cpus > 0) {
+        printf("  deep idle %5.1f%%\n", 100.0 * (idle_after - idle) / (elapsed * 1e6 * (double)cpus));
+    } else {
+        printf("  deep idle n/a\n");
+    }
+}
+
+int main(int argc, char *argv[]) {
+    int seconds = 10;
+    if (argc == 3 && strcmp(argv[1], "-t") == 0) {
+        seconds = atoi(argv[2]);
+    } else if (argc != 1) {
+        printf("Usage: %s [-t seconds per phase, default 10]\n", argv[0]);
+        return strcmp(argv[1], "-h") == 0 ? 0 : 1;
+    }
+    if (seconds < 1 || write_wav(seconds * 2 + 5) != 0) {
+        fprintf(stderr, "Cannot write %s\n", WAV_PATH);
+        return 1;
+    }
+
+    RhythmEngine *engine = rhythm_engine_create();
+    if (!engine || rhythm_engine_set_power_mode(engine, RHYTHM_POWER_NORMAL) != RHYTHM_OK ||
+        rhythm_engine_load_file(engine, WAV_PATH) != RHYTHM_OK || rhythm_engine_play(engine) != RHYTHM_OK) {
+        fprintf(stderr, "Engine failed to start\n");
+        return 1;
+    }
+    usleep(500000);
+
+    run_phase(engine, "normal", seconds);
+    if (rhythm_engine_set_power_mode(engine, RHYTHM_POWER_LOW) != RHYTHM_OK) {
+        fprintf(stderr, "Cannot switch to low power\n");
+        return 1;
+    }
+    // the deep ring fills once after the switch; measure the steady state after it
+    usleep(500000);
+    run_phase(engine, "low", seconds);
+
+    rhythm_engine_destroy(engine);
+    unlink(WAV_PATH);
+    return 0;
+}
@@ -0,0 +1,167 @@
+// Time to first sample of track changes with and without read-ahead: evicts every file
+// of a directory from the page cache, plays it, lets each track run for a while and
+// skips to the next, then reports per phase how many starts found their track cached
+// and how long starts took from the play request to the first decoded sample. Without a
+// directory a set of WAVs is written to /tmp. Eviction uses POSIX_FADV_DONTNEED, which
+// tmpfs ignores; NFS mounts are best dropped with "echo 1 > /proc/sys/vm/drop_caches".
+#include "core/rhythm_engine.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define WAV_DIR "/tmp/rhythm_prefetch_latency"
+#define WAV_TRACKS 8
+
+static int write_wav(const char *path, int seconds) {
+    FILE *f = fopen(path, "wb");
+    if (!f) return -1;
+
+    uint16_t format = 1, channels = 2, bits = 16, block_align = 4;
+    uint32_t rate = 44100, byte_rate = rate * block_align, fmt_size = 16;
+    uint32_t data_size = rate * (uint32_t)seconds * block_align, riff_size = 36 + data_size;
+
+    fwrite("RIFF", 1, 4, f);
+    fwrite(&riff_size, 4, 1, f);
+    fwrite("WAVEfmt ", 1, 8, f);
+    fwrite(&fmt_size, 4, 1, f);
+    fwrite(&format, 2, 1, f);
+    fwrite(&channels, 2, 1, f);
+    fwrite(&rate, 4, 1, f);
+    fwrite(&byte_rate, 4, 1, f);
+    fwrite(&block_align, 2, 1, f);
+    fwrite(&bits, 2, 1, f);
+    fwrite("data", 1, 4, f);
+    fwrite(&data_size, 4, 1, f);
+    for (uint32_t i = 0; i < data_size / 2; i++) {
+        int16_t sample = (int16_t)((i * 37) & 0x0fff);
+        fwrite(&sample, sizeof(sample), 1, f);
+    }
+    // written back first, or DONTNEED cannot drop the dirty pages
+    fflush(f);
+    fsync(fileno(f));
+    fclose(f);
+    return 0;
+}
+
+static void evict(Playlist *playlist) {
+    for (int i = 0; i < playlist_get_count(playlist); i++) {
+        int fd = open(playlist_get_file_at(playlist, i), O_RDONLY);
+        if (fd < 0) continue;
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+}
+
+static void tick_for(RhythmEngine *engine, int ms) {
+    struct timespec tick = { 0, 10000000 };
+    for (int i = 0; i < ms / 10; i++) {
+        rhythm_engine_update(engine);
+        nanosleep(&tick, NULL);
+    }
+}
+
+static int run_phase(const char *directory, const char *name, int lookahead, int tracks, int seconds) {
+    RhythmEngine *engine = rhythm_engine_create();
+    if (!engine || rhythm_engine_set_prefetch(engine, lookahead, 0) != RHYTHM_OK) return -1;
+    if (rhythm_engine_load_directory(engine, directory) != RHYTHM_OK) {
+        rhythm_engine_destroy(engine);
+        return -1;
+    }
+    // the load already queued the first tracks; start them cold like the rest
+    RhythmPrefetchStats stats;
+    do {
+        tick_for(engine, 10);
+        rhythm_engine_get_prefetch_stats(engine, &stats);
+    } while (!stats.idle);
+    evict(rhythm_engine_get_playlist(engine));
+
+    if (rhythm_engine_play(engine) != RHYTHM_OK) {
+        rhythm_engine_destroy(engine);
+        return -1;
+    }
+    for (int i = 1; i < tracks; i++) {
+        tick_for(engine, seconds * 1000);
+        rhythm_engine_next_track(engine);
+    }
+    tick_for(engine, 500);
+
+    rhythm_engine_get_prefetch_stats(engine, &stats);
+    printf("%-9s cached %llu/%llu starts  first sample cached %.1f ms  cold %.1f ms  read ahead %.1f MB  cancelled %llu\n",
+           name, (unsigned long long)stats.hits, (unsigned long long)(stats.hits + stats.misses),
+           stats.first_sample_hit_ms, stats.first_sample_miss_ms, stats.bytes / (1024.0 * 1024.0),
+           (unsigned long long)stats.cancelled);
+    rhythm_engine_destroy(engine);
+    return 0;
+}
+
+static void print_usage(const char *program_name) {
+    printf("Usage: %s [-d directory] [-n tracks] [-t seconds] [-l lookahead]\n", program_name);
+    printf("\n  -d  music directory (default: %d generated WAVs in %s)\n", WAV_TRACKS, WAV_DIR);
+    printf("  -n  track changes per phase (default: every track)\n");
+    printf("  -t  seconds each track plays before skipping (default 3)\n");
+    printf("  -l  tracks read ahead with prefetch on (default %d)\n", PREFETCH_DEFAULT_TRACKS);
+}
+
+int main(int argc, char *argv[]) {
+    const char *directory = NULL;
+    int tracks = 0;
+    int seconds = 3;
+    int lookahead = PREFETCH_DEFAULT_TRACKS;
+
+    for (int i = 1; i < argc; i++) {
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(argv[i], "-d") == 0 && value) {
+            directory = value;
+        } else if (strcmp(argv[i], "-n") == 0 && value) {
+            tracks = atoi(value);
+        } else if (strcmp(argv[i], "-t") == 0 && value) {
+            seconds = atoi(value);
+        } else if (strcmp(argv[i], "-l") == 0 && value) {
+            lookahead = atoi(value);
+        } else {
+            print_usage(argv[0]);
+            return strcmp(argv[i], "-h") == 0 ? 0 : 1;
+        }
+        i++;
+    }
+    if (seconds < 1 || lookahead < 1 || lookahead > PREFETCH_MAX_TRACKS || tracks < 0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    bool generated = directory == NULL;
+    if (generated) {
+        mkdir(WAV_DIR, 0755);
+        for (int i = 0; i < WAV_TRACKS; i++) {
+            char path[256];
+            snprintf(path, sizeof(path), "%s/track%02d.wav", WAV_DIR, i);
+            if (write_wav(path, 60) != 0) {
+                fprintf(stderr, "Cannot write %s\n", path);
+                return 1;
+            }
+        }
+        directory = WAV_DIR;
+    }
+    if (tracks == 0) tracks = generated ? WAV_TRACKS : 10;
+
+    printf("%d tracks per phase, %d s each\n", tracks, seconds);
+    if (run_phase(directory, "off", 0, tracks, seconds) != 0 ||
+        run_phase(directory, "prefetch", lookahead, tracks, seconds) != 0) {
+        fprintf(stderr, "Cannot play %s\n", directory);
+        return 1;
+    }
+
+    if (generated) {
+        for (int i = 0; i < WAV_TRACKS; i++) {
+            char path[256];
+            snprintf(path, sizeof(path), "%s/track%02d.wav", WAV_DIR, i);
+            unlink(path);
+        }
+        rmdir(WAV_DIR);
+    }
+    return 0;
+}
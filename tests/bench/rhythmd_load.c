@@ -0,0 +1,190 @@
+// Load generator for rhythmd: N client threads each issue requests over their own
+// connection with up to `depth` in flight, then commands/sec and round-trip
+// latency percentiles are reported across all of them.
+#include "client/rhythm_remote.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+typedef enum { LOAD_PING, LOAD_STATUS, LOAD_VOLUME } LoadOp;
+
+typedef struct {
+    const char *socket_path;
+    LoadOp op;
+    long requests;
+    int depth;
+    double *latencies_us;                       // one per answered request
+    long recorded;
+    long completed;
+    long failed;
+} LoadWorker;
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static int64_t send_request(RhythmRemote *remote, LoadOp op) {
+    switch (op) {
+        case LOAD_PING:
+            return rhythm_remote_send(remote, RHYTHM_MSG_PING, NULL, 0);
+        case LOAD_STATUS:
+            return rhythm_remote_send(remote, RHYTHM_MSG_GET_STATUS, NULL, 0);
+        case LOAD_VOLUME:
+            return rhythm_remote_send_command(remote, ENGINE_COMMAND_SET_VOLUME, 0, 1.0f, NULL);
+    }
+    return -1;
+}
+
+static void *worker_main(void *arg) {
+    LoadWorker *worker = arg;
+    RhythmRemote *remote = rhythm_remote_connect(worker->socket_path);
+    if (!remote) {
+        worker->failed = worker->requests;
+        return NULL;
+    }
+
+    // ids are sequential per connection, so the send time of id i sits at slot i % depth
+    double *sent_at = calloc((size_t)worker->depth, sizeof(double));
+    RhythmMessage *message = malloc(sizeof(RhythmMessage));
+    long sent = 0;
+    uint32_t first_id = 0;
+
+    while (worker->completed + worker->failed < worker->requests) {
+        while (sent < worker->requests && sent - worker->completed - worker->failed < worker->depth) {
+            int64_t id = send_request(remote, worker->op);
+            if (id < 0) goto done;
+            if (sent == 0) first_id = (uint32_t)id;
+            sent_at[sent % worker->depth] = now_us();
+            sent++;
+        }
+
+        if (rhythm_remote_receive(remote, message, 5000) != 1) goto done;
+        long index = (long)(message->header.id - first_id);
+        if (index < 0 || index >= sent) continue;
+
+        worker->latencies_us[worker->recorded++] = now_us() - sent_at[index % worker->depth];
+        bool ok = message->header.type == RHYTHM_MSG_STATUS ||
+                  (message->header.type == RHYTHM_MSG_RESULT && message->payload.result.result == RHYTHM_OK);
+        if (ok) {
+            worker->completed++;
+        } else {
+            worker->failed++;
+        }
+    }
+
+done:
+    if (worker->completed + worker->failed < worker->requests) {
+        worker->failed = worker->requests - worker->completed;
+    }
+    free(message);
+    free(sent_at);
+    rhythm_remote_close(remote);
+    return NULL;
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(const double *sorted, long count, double p) {
+    if (count == 0) return 0.0;
+    long index = (long)(p * (double)(count - 1) + 0.5);
+    return sorted[index];
+}
+
+static void print_usage(const char *program_name) {
+    printf("Usage: %s [-s socket] [-c clients] [-n requests] [-d depth] [-o ping|status|volume]\n", program_name);
+    printf("\n  -c  concurrent connections (default 4)\n");
+    printf("  -n  requests per connection (default 20000)\n");
+    printf("  -d  requests in flight per connection (default 1)\n");
+    printf("  -o  request type (default ping)\n");
+}
+
+int main(int argc, char *argv[]) {
+    const char *socket_path = NULL;
+    int clients = 4;
+    long requests = 20000;
+    int depth = 1;
+    LoadOp op = LOAD_PING;
+    const char *op_name = "ping";
+
+    for (int i = 1; i < argc; i++) {
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(argv[i], "-s") == 0 && value) {
+            socket_path = value;
+        } else if (strcmp(argv[i], "-c") == 0 && value) {
+            clients = atoi(value);
+        } else if (strcmp(argv[i], "-n") == 0 && value) {
+            requests = atol(value);
+        } else if (strcmp(argv[i], "-d") == 0 && value) {
+            depth = atoi(value);
+        } else if (strcmp(argv[i], "-o") == 0 && value) {
+            op_name = value;
+            if (strcmp(value, "ping") == 0) op = LOAD_PING;
+            else if (strcmp(value, "status") == 0) op = LOAD_STATUS;
+            else if (strcmp(value, "volume") == 0) op = LOAD_VOLUME;
+            else { print_usage(argv[0]); return 1; }
+        } else {
+            print_usage(argv[0]);
+            return strcmp(argv[i], "-h") == 0 ? 0 : 1;
+        }
+        i++;
+    }
+    if (clients < 1 || requests < 1 || depth < 1) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    RhythmRemote *probe = rhythm_remote_connect(socket_path);
+    if (!probe || rhythm_remote_ping(probe, 2000) != RHYTHM_OK) {
+        fprintf(stderr, "rhythmd is not answering%s%s\n", socket_path ? " on " : "", socket_path ? socket_path : "");
+        rhythm_remote_close(probe);
+        return 1;
+    }
+    rhythm_remote_close(probe);
+
+    LoadWorker *workers = calloc((size_t)clients, sizeof(LoadWorker));
+    pthread_t *threads = calloc((size_t)clients, sizeof(pthread_t));
+    double *latencies = malloc((size_t)clients * (size_t)requests * sizeof(double));
+    if (!workers || !threads || !latencies) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    double start = now_us();
+    for (int i = 0; i < clients; i++) {
+        workers[i] = (LoadWorker){socket_path, op, requests, depth, latencies + (size_t)i * (size_t)requests, 0, 0, 0};
+        pthread_create(&threads[i], NULL, worker_main, &workers[i]);
+    }
+    long completed = 0, failed = 0;
+    for (int i = 0; i < clients; i++) {
+        pthread_join(threads[i], NULL);
+        completed += workers[i].completed;
+        failed += workers[i].failed;
+    }
+    double elapsed_s = (now_us() - start) / 1e6;
+
+    // only the samples each worker actually recorded are ranked
+    long samples = 0;
+    for (int i = 0; i < clients; i++) {
+        memmove(latencies + samples, workers[i].latencies_us, (size_t)workers[i].recorded * sizeof(double));
+        samples += workers[i].recorded;
+    }
+    qsort(latencies, (size_t)samples, sizeof(double), compare_doubles);
+
+    printf("op=%s clients=%d depth=%d requests=%ld failed=%ld\n", op_name, clients, depth, completed, failed);
+    printf("throughput: %.0f requests/s over %.2f s\n", completed / elapsed_s, elapsed_s);
+    printf("round trip: p50 %.1f us  p99 %.1f us  p99.9 %.1f us  max %.1f us\n",
+           percentile(latencies, samples, 0.5), percentile(latencies, samples, 0.99),
+           percentile(latencies, samples, 0.999), samples ? latencies[samples - 1] : 0.0);
+
+    free(latencies);
+    free(threads);
+    free(workers);
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,192 @@
+// Xruns with and without the real-time profile under a synthetic load: plays a WAV,
+// then for each phase starts CPU hog and memory churn processes beside the engine and
+// reports the device underflows, starved and late callbacks and callback latency,
+// followed by the guarantees the profile actually obtained. The load runs in child
+// processes so the profile's locked memory and CPU pinning apply to the engine alone.
+#include "core/rhythm_engine.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#define WAV_PATH "/tmp/rhythm_rt_stress.wav"
+#define MAX_HOGS 256
+
+static int write_wav(int seconds) {
+    FILE *f = fopen(WAV_PATH, "wb");
+    if (!f) return -1;
+
+    uint16_t format = 1, channels = 2, bits = 16, block_align = 4;
+    uint32_t rate = 44100, byte_rate = rate * block_align, fmt_size = 16;
+    uint32_t data_size = rate * (uint32_t)seconds * block_align, riff_size = 36 + data_size;
+
+    fwrite("RIFF", 1, 4, f);
+    fwrite(&riff_size, 4, 1, f);
+    fwrite("WAVEfmt ", 1, 8, f);
+    fwrite(&fmt_size, 4, 1, f);
+    fwrite(&format, 2, 1, f);
+    fwrite(&channels, 2, 1, f);
+    fwrite(&rate, 4, 1, f);
+    fwrite(&byte_rate, 4, 1, f);
+    fwrite(&block_align, 2, 1, f);
+    fwrite(&bits, 2, 1, f);
+    fwrite("data", 1, 4, f);
+    fwrite(&data_size, 4, 1, f);
+    for (uint32_t i = 0; i < data_size / 2; i++) {
+        int16_t sample = (int16_t)((i * 37) & 0x0fff);
+        fwrite(&sample, sizeof(sample), 1, f);
+    }
+    fclose(f);
+    return 0;
+}
+
+static void cpu_hog(void) {
+    volatile double x = 1.0;
+    for (;;) x = x * 1.0000001 + 0.0000001;
+}
+
+// maps, dirties and drops a block over and over, pushing other pages out under pressure
+static void memory_churn(size_t bytes) {
+    long page = sysconf(_SC_PAGESIZE);
+    for (;;) {
+        char *block = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (block == MAP_FAILED) {
+            usleep(10000);
+            continue;
+        }
+        for (size_t i = 0; i < bytes; i += (size_t)page) block[i] = (char)i;
+        munmap(block, bytes);
+    }
+}
+
+static int start_load(pid_t *children, int hogs, size_t churn_bytes) {
+    int count = 0;
+    for (int i = 0; i < hogs + (churn_bytes > 0); i++) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            if (i < hogs) cpu_hog();
+            memory_churn(churn_bytes);
+            _exit(0);
+        }
+        if (pid > 0) children[count++] = pid;
+    }
+    return count;
+}
+
+static void stop_load(pid_t *children, int count) {
+    for (int i = 0; i < count; i++) kill(children[i], SIGKILL);
+    for (int i = 0; i < count; i++) waitpid(children[i], NULL, 0);
+}
+
+static void print_realtime(RhythmEngine *engine) {
+    RhythmRealtimeStatus status;
+    rhythm_engine_get_realtime_status(engine, &status);
+    static const char *ROLE_NAMES[REALTIME_ROLES] = { "audio", "decoder" };
+    for (int role = 0; role < REALTIME_ROLES; role++) {
+        const RealtimeRoleStatus *r = &status.roles[role];
+        printf("  %-8s %d threads, %d promoted, weakest %s priority %d, %d pinned\n", ROLE_NAMES[role],
+               r->threads, r->promoted, realtime_method_name(r->method), r->priority, r->pinned);
+    }
+    printf("  memory   %s, rings locked %zu KB, prefaulted %zu KB\n",
+           status.memory_locked ? "all locked" : "pageable", status.buffers_locked / 1024,
+           status.buffers_prefaulted / 1024);
+}
+
+static void run_phase(RhythmEngine *engine, const char *name, int seconds, int hogs, size_t churn_bytes) {
+    pid_t children[MAX_HOGS + 1];
+    rhythm_engine_reset_stats(engine);
+    int count = start_load(children, hogs, churn_bytes);
+
+    struct timespec tick = { 0, 10000000 };
+    for (int i = 0; i < seconds * 100; i++) {
+        rhythm_engine_update(engine);
+        nanosleep(&tick, NULL);
+    }
+    stop_load(children, count);
+
+    RhythmStats stats;
+    rhythm_engine_get_stats(engine, &stats);
+    printf("%-9s callbacks %llu  underflows %llu  starved %llu  late %llu  p99 %.0f us  max %.0f us\n", name,
+           (unsigned long long)stats.callbacks, (unsigned long long)stats.underflows,
+           (unsigned long long)stats.starved_callbacks, (unsigned long long)stats.deadline_misses,
+           stats.callback_p99_us, stats.callback_max_us);
+}
+
+static void print_usage(const char *program_name) {
+    printf("Usage: %s [-t seconds] [-c hogs] [-m megabytes] [-a cpus] [-d cpus] [-p priority]\n", program_name);
+    printf("\n  -t  seconds per phase (default 10)\n");
+    printf("  -c  CPU hog processes (default two per CPU)\n");
+    printf("  -m  megabytes dirtied and dropped in a loop, 0 for none (default 256)\n");
+    printf("  -a  CPUs for the audio threads with the profile on, e.g. \"3\" (default unpinned)\n");
+    printf("  -d  CPUs for the decoder threads, e.g. \"2-3\" (default unpinned)\n");
+    printf("  -p  SCHED_FIFO priority of the audio threads (default 70)\n");
+}
+
+int main(int argc, char *argv[]) {
+    int seconds = 10;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int hogs = (int)(cpus > 0 ? cpus * 2 : 2);
+    int megabytes = 256;
+    RhythmRealtimeConfig config;
+    realtime_config_defaults(&config);
+    config.enabled = true;
+
+    for (int i = 1; i < argc; i++) {
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        bool valid = value != NULL;
+        if (strcmp(argv[i], "-t") == 0 && value) {
+            seconds = atoi(value);
+        } else if (strcmp(argv[i], "-c") == 0 && value) {
+            hogs = atoi(value);
+        } else if (strcmp(argv[i], "-m") == 0 && value) {
+            megabytes = atoi(value);
+        } else if (strcmp(argv[i], "-a") == 0 && value) {
+            valid = realtime_parse_cpus(value, &config.cpus[REALTIME_ROLE_AUDIO]) == 0;
+        } else if (strcmp(argv[i], "-d") == 0 && value) {
+            valid = realtime_parse_cpus(value, &config.cpus[REALTIME_ROLE_DECODER]) == 0;
+        } else if (strcmp(argv[i], "-p") == 0 && value) {
+            config.priority[REALTIME_ROLE_AUDIO] = atoi(value);
+            config.priority[REALTIME_ROLE_DECODER] = atoi(value) > 10 ? atoi(value) - 10 : 1;
+        } else {
+            valid = false;
+        }
+        if (!valid) {
+            print_usage(argv[0]);
+            return strcmp(argv[i], "-h") == 0 ? 0 : 1;
+        }
+        i++;
+    }
+    if (seconds < 1 || hogs < 0 || hogs > MAX_HOGS || megabytes < 0 || write_wav(seconds * 2 + 5) != 0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    RhythmEngine *engine = rhythm_engine_create();
+    if (!engine || rhythm_engine_load_file(engine, WAV_PATH) != RHYTHM_OK || rhythm_engine_play(engine) != RHYTHM_OK) {
+        fprintf(stderr, "Engine failed to start\n");
+        return 1;
+    }
+    // the first callbacks register the audio thread; let the decode-ahead ring fill too
+    usleep(500000);
+    printf("load: %d CPU hogs, %d MB memory churn, %d s per phase\n", hogs, megabytes, seconds);
+
+    size_t churn_bytes = (size_t)megabytes * 1024 * 1024;
+    run_phase(engine, "default", seconds, hogs, churn_bytes);
+
+    if (rhythm_engine_set_realtime(engine, &config) != RHYTHM_OK) {
+        fprintf(stderr, "Invalid real-time configuration\n");
+        return 1;
+    }
+    run_phase(engine, "realtime", seconds, hogs, churn_bytes);
+    print_realtime(engine);
+
+    config.enabled = false;
+    rhythm_engine_set_realtime(engine, &config);
+    rhythm_engine_destroy(engine);
+    unlink(WAV_PATH);
+    return 0;
+}
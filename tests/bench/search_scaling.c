@@ -0,0 +1,194 @@
+// Build cost, memory and query latency of the playlist search index at library scale:
+// indexes N synthetic Artist/Album/Title paths drawn from a skewed vocabulary, then
+// times single queries of several shapes and reports latency percentiles per shape.
+#include "core/search_index.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define VOCABULARY_WORDS 20000
+#define MAX_RESULTS 50
+
+static const char CONSONANTS[] = "bcdfghjklmnprstvwyz";
+static const char VOWELS[] = "aeiou";
+
+static char vocabulary[VOCABULARY_WORDS][16];
+static unsigned long long rng_state = 0x2545F4914F6CDD1DULL;
+
+static unsigned int next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return (unsigned int)(rng_state >> 32);
+}
+
+// skewed towards the front of the vocabulary, like word use in real titles
+static const char *pick_word(void) {
+    double u = (double)next_random() / 4294967296.0;
+    return vocabulary[(int)(u * u * VOCABULARY_WORDS)];
+}
+
+static const char *pick_any_word(void) {
+    return vocabulary[next_random() % VOCABULARY_WORDS];
+}
+
+// 4-9 letters, about two in five vowels
+static void build_vocabulary(void) {
+    for (int i = 0; i < VOCABULARY_WORDS; i++) {
+        int length = 4 + (int)(next_random() % 6);
+        for (int c = 0; c < length; c++) {
+            vocabulary[i][c] = next_random() % 5 < 2 ? VOWELS[next_random() % (sizeof(VOWELS) - 1)]
+                                                     : CONSONANTS[next_random() % (sizeof(CONSONANTS) - 1)];
+        }
+        vocabulary[i][length] = '\0';
+        vocabulary[i][0] = (char)(vocabulary[i][0] - 'a' + 'A');
+    }
+}
+
+static void append_words(char *out, size_t size, int words) {
+    for (int w = 0; w < words; w++) {
+        size_t length = strlen(out);
+        snprintf(out + length, size - length, "%s%s", w ? " " : "", pick_word());
+    }
+}
+
+static void make_path(char *path, size_t size, int i) {
+    char artist[64] = "", album[96] = "", title[128] = "";
+    append_words(artist, sizeof(artist), 1 + (int)(next_random() % 2));
+    append_words(album, sizeof(album), 1 + (int)(next_random() % 3));
+    append_words(title, sizeof(title), 2 + (int)(next_random() % 4));
+    snprintf(path, size, "/home/user/Music/%s/%s/%02d - %s.mp3", artist, album, 1 + i % 20, title);
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double da = *(const double *)a;
+    double db = *(const double *)b;
+    return (da > db) - (da < db);
+}
+
+static long read_rss_kb(void) {
+    long rss_kb = 0;
+    FILE *f = fopen("/proc/self/status", "r");
+    if (!f) return 0;
+
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        if (strncmp(line, "VmRSS:", 6) == 0) rss_kb = atol(line + 6);
+    }
+    fclose(f);
+    return rss_kb;
+}
+
+typedef enum {
+    QUERY_WORD,         // any word of the vocabulary, as when looking for a name
+    QUERY_COMMON_WORD,  // drawn as often as titles use it: many matches to rank
+    QUERY_TWO_WORDS,
+    QUERY_PREFIX,       // the first 3-5 letters of a word, as while typing
+    QUERY_SHORT,        // two letters: no trigram, answered from word prefix lists
+    QUERY_SHAPES
+} QueryShape;
+
+static const char *SHAPE_NAMES[QUERY_SHAPES] = { "word", "common", "two words", "prefix", "2 letters" };
+
+static void make_query(QueryShape shape, char *query, size_t size) {
+    switch (shape) {
+        case QUERY_WORD:
+            snprintf(query, size, "%s", pick_any_word());
+            break;
+        case QUERY_COMMON_WORD:
+            snprintf(query, size, "%s", pick_word());
+            break;
+        case QUERY_TWO_WORDS:
+            snprintf(query, size, "%s %s", pick_any_word(), pick_word());
+            break;
+        case QUERY_PREFIX:
+            snprintf(query, size, "%.*s", 3 + (int)(next_random() % 3), pick_any_word());
+            break;
+        default:
+            snprintf(query, size, "%.2s", pick_any_word());
+            break;
+    }
+}
+
+static void print_usage(const char *program_name) {
+    printf("Usage: %s [-n entries] [-q queries]\n", program_name);
+    printf("\n  -n  playlist entries to index (default 1000000)\n");
+    printf("  -q  queries timed per shape (default 2000)\n");
+}
+
+int main(int argc, char *argv[]) {
+    int count = 1000000;
+    int queries = 2000;
+    for (int i = 1; i < argc; i++) {
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(argv[i], "-n") == 0 && value) {
+            count = atoi(value);
+        } else if (strcmp(argv[i], "-q") == 0 && value) {
+            queries = atoi(value);
+        } else {
+            print_usage(argv[0]);
+            return strcmp(argv[i], "-h") == 0 ? 0 : 1;
+        }
+        i++;
+    }
+    if (count < 1 || queries < 1) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    build_vocabulary();
+    SearchIndex *index = search_index_create();
+    double *samples = malloc(sizeof(double) * (size_t)queries);
+    if (!index || !samples) return 1;
+
+    long rss_before = read_rss_kb();
+    double build_ns = 0.0;
+    char path[512];
+    for (int i = 0; i < count; i++) {
+        make_path(path, sizeof(path), i);
+        double start = now_ns();
+        if (search_index_add_path(index, path) != 0) {
+            fprintf(stderr, "Indexing failed at entry %d\n", i);
+            return 1;
+        }
+        build_ns += now_ns() - start;
+    }
+    long rss_after = read_rss_kb();
+
+    SearchIndexStats stats;
+    search_index_get_stats(index, &stats);
+    printf("entries=%zu trigrams=%zu postings=%zu (%.1f per entry)\n", stats.entries, stats.trigrams,
+           stats.postings, (double)stats.postings / count);
+    printf("build:   %.0f ms total, %.2f us per entry\n", build_ns / 1e6, build_ns / 1e3 / count);
+    printf("memory:  %.1f MB, %.1f bytes per entry (RSS +%.1f MB)\n", stats.memory_bytes / 1048576.0,
+           (double)stats.memory_bytes / count, (rss_after - rss_before) / 1024.0);
+
+    int results[MAX_RESULTS];
+    char query[64];
+    for (int shape = 0; shape < QUERY_SHAPES; shape++) {
+        int runs = queries;
+        long matched = 0;
+        for (int q = 0; q < runs; q++) {
+            make_query((QueryShape)shape, query, sizeof(query));
+            double start = now_ns();
+            int found = search_index_query(index, query, results, MAX_RESULTS);
+            samples[q] = (now_ns() - start) / 1e3;
+            matched += found > 0 ? found : 0;
+        }
+        qsort(samples, (size_t)runs, sizeof(double), compare_doubles);
+        printf("query %-10s p50 %7.1f us  p99 %7.1f us  p99.9 %7.1f us  max %7.1f us  (%.1f results)\n",
+               SHAPE_NAMES[shape], samples[runs / 2], samples[(int)(runs * 0.99)], samples[(int)(runs * 0.999)],
+               samples[runs - 1], (double)matched / runs);
+    }
+
+    free(samples);
+    search_index_destroy(index);
+    return 0;
+}
@@ -4,7 +4,26 @@
 #include <assert.h>
 #include <unistd.h>
 #include <sys/stat.h>
+#include <math.h>
+#include <ctype.h>
+#include <dirent.h>
+#include <stdatomic.h>
 #include "core/rhythm_engine.h"
+#include "core/engine_host.h"
+#include "core/audio_context.h"
+#include "core/playlist_view.h"
+#include "core/session.h"
+#include "core/ring_buffer.h"
+#include "client/rhythm_client.h"
+#include "client/rhythm_remote.h"
+#include "daemon/rhythm_server.h"
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
 
 #define TEST_ASSERT(condition, message) \
     do { \
@@ -42,6 +61,35 @@ static void create_test_directory(const char* dirname) {
     create_test_file(filepath);
 }
 
+// 16-bit stereo ramp where frame i holds (i, -i)
+static void create_test_wav(const char* filename, int sample_rate, int frames) {
+    FILE* f = fopen(filename, "wb");
+    if (!f) return;
+
+    unsigned int data_size = (unsigned int)frames * 4;
+    unsigned int riff_size = 36 + data_size;
+    unsigned int fmt_size = 16, byte_rate = (unsigned int)sample_rate * 4;
+    unsigned short format = 1, channels = 2, block_align = 4, bits = 16;
+
+    fwrite("RIFF", 1, 4, f);
+    fwrite(&riff_size, 4, 1, f);
+    fwrite("WAVEfmt ", 1, 8, f);
+    fwrite(&fmt_size, 4, 1, f);
+    fwrite(&format, 2, 1, f);
+    fwrite(&channels, 2, 1, f);
+    fwrite(&sample_rate, 4, 1, f);
+    fwrite(&byte_rate, 4, 1, f);
+    fwrite(&block_align, 2, 1, f);
+    fwrite(&bits, 2, 1, f);
+    fwrite("data", 1, 4, f);
+    fwrite(&data_size, 4, 1, f);
+    for (int i = 0; i < frames; i++) {
+        short frame[2] = {(short)(i % 32768), (short)-(i % 32768)};
+        fwrite(frame, 2, 2, f);
+    }
+    fclose(f);
+}
+
 static void cleanup_test_files(void) {
     unlink("test_file.mp3");
     unlink("test_dir/test1.mp3");
@@ -259,6 +307,1748 @@ static int test_status_updates(void) {
     TEST_PASS();
 }
 
+static int test_status_frame(void) {
+    RhythmEngine* engine = rhythm_engine_create();
+    TEST_ASSERT(engine != NULL, "Engine creation should succeed");
+
+    RhythmStatusFrame frame;
+    memset(&frame, 0, sizeof(frame));
+    TEST_ASSERT(rhythm_engine_get_status_frame(NULL, &frame) == RHYTHM_ERROR_NULL_POINTER, "NULL engine should fail");
+    TEST_ASSERT(rhythm_engine_get_status_frame(engine, NULL) == RHYTHM_ERROR_NULL_POINTER, "NULL frame should fail");
+    TEST_ASSERT(rhythm_engine_get_status_frame(engine, &frame) == RHYTHM_OK, "Frame should be filled");
+    TEST_ASSERT(frame.sequence == 1 && frame.file_sequence == 0, "Empty name should not count as a change");
+    TEST_ASSERT(frame.file_name[0] == '\0' && frame.status.total_tracks == 0, "Empty engine should report nothing");
+
+    create_test_directory("test_dir");
+    rhythm_engine_load_directory(engine, "test_dir");
+    rhythm_engine_set_volume(engine, 0.25f);
+    TEST_ASSERT(rhythm_engine_get_status_frame(engine, &frame) == RHYTHM_OK, "Frame should be filled");
+    RhythmStatus status = rhythm_engine_get_status(engine);
+    TEST_ASSERT(frame.sequence == 2 && frame.file_sequence == 1, "New file should bump the file sequence");
+    TEST_ASSERT(strcmp(frame.file_name, status.current_file) == 0, "Name should match the by-value status");
+    TEST_ASSERT(frame.status.current_file == NULL, "Frame should not hold allocated strings");
+    TEST_ASSERT(frame.status.total_tracks == 2 && frame.status.volume == 0.25f, "Fields should match the engine");
+
+    rhythm_engine_get_status_frame(engine, &frame);
+    TEST_ASSERT(frame.sequence == 3 && frame.file_sequence == 1, "Same file should keep its sequence");
+    rhythm_engine_next_track(engine);
+    rhythm_engine_get_status_frame(engine, &frame);
+    TEST_ASSERT(frame.file_sequence == 2 && frame.status.current_track == 2, "Track change should be seen");
+
+    rhythm_engine_destroy(engine);
+    cleanup_test_files();
+    TEST_PASS();
+}
+
+static int test_audio_configuration(void) {
+    RhythmAudioConfig config;
+    rhythm_engine_default_audio_config(&config);
+    TEST_ASSERT(config.channels == CHANNELS, "Default config should use stereo output");
+
+    RhythmEngine* engine = rhythm_engine_create_with_config(&config);
+    TEST_ASSERT(engine != NULL, "Engine creation with config should succeed");
+
+    RhythmAudioInfo info;
+    TEST_ASSERT(rhythm_engine_get_audio_info(engine, &info) == RHYTHM_OK, "Audio info should be available");
+    TEST_ASSERT(info.sample_rate > 0, "Reported sample rate should be positive");
+    TEST_ASSERT(info.channels == config.channels, "Reported channels should match config");
+    TEST_ASSERT(!info.resampling, "Nothing should be resampled without a track");
+
+    RhythmAudioConfig invalid = config;
+    invalid.channels = 6;
+    TEST_ASSERT(rhythm_engine_configure_audio(engine, &invalid) != RHYTHM_OK,
+                "Unsupported channel count should be rejected");
+
+    config.channels = 1;
+    config.frames_per_buffer = 256;
+    TEST_ASSERT(rhythm_engine_configure_audio(engine, &config) == RHYTHM_OK, "Reconfiguring should succeed");
+    rhythm_engine_get_audio_info(engine, &info);
+    TEST_ASSERT(info.channels == 1, "Reported channels should follow the new config");
+
+    TEST_ASSERT(rhythm_engine_get_audio_info(NULL, &info) == RHYTHM_ERROR_NULL_POINTER,
+                "Should return NULL pointer error");
+
+    rhythm_engine_destroy(engine);
+    TEST_PASS();
+}
+
+static int test_audio_stats(void) {
+    RhythmEngine* engine = rhythm_engine_create();
+    TEST_ASSERT(engine != NULL, "Engine creation should succeed");
+
+    RhythmStats stats;
+    TEST_ASSERT(rhythm_engine_get_stats(engine, &stats) == RHYTHM_OK, "Stats should be available");
+    TEST_ASSERT(stats.callbacks == 0, "No callbacks should have run without playback");
+    TEST_ASSERT(stats.ring_capacity_ms > 0.0f, "Ring capacity should be reported");
+    TEST_ASSERT(rhythm_engine_reset_stats(engine) == RHYTHM_OK, "Stats reset should succeed");
+    TEST_ASSERT(rhythm_engine_get_stats(NULL, &stats) == RHYTHM_ERROR_NULL_POINTER,
+                "Should return NULL pointer error");
+
+    LatencyHistogram histogram;
+    latency_histogram_reset(&histogram);
+    for (uint64_t i = 1; i <= 1000; i++) {
+        latency_histogram_record(&histogram, i * 1000);
+    }
+    uint64_t p50 = latency_histogram_percentile(&histogram, 50.0);
+    uint64_t p99 = latency_histogram_percentile(&histogram, 99.0);
+    TEST_ASSERT(latency_histogram_count(&histogram) == 1000, "Histogram should count every sample");
+    TEST_ASSERT(p50 >= 470000 && p50 <= 540000, "Median should be within bucket resolution");
+    TEST_ASSERT(p99 >= 940000 && p99 <= 1000000, "p99 should be within bucket resolution");
+    TEST_ASSERT(latency_histogram_percentile(&histogram, 100.0) == 1000000, "p100 should be the maximum");
+
+    rhythm_engine_destroy(engine);
+    TEST_PASS();
+}
+
+static int test_wav_playback(void) {
+    create_test_wav("test_file.wav", 48000, 96000);
+
+    Decoder* decoder = wav_decoder_create();
+    TEST_ASSERT(decoder != NULL, "WAV decoder creation should succeed");
+    TEST_ASSERT(wav_decoder_probe("test_file.wav"), "WAV header should be recognised");
+    TEST_ASSERT(decoder_open(decoder, "test_file.wav") == 0, "WAV file should open");
+    TEST_ASSERT(decoder->rate == 48000 && decoder->channels == 2, "Format should come from the fmt chunk");
+    TEST_ASSERT(decoder->length_frames == 96000, "Length should come from the data chunk");
+
+    float samples[8];
+    size_t frames = 0;
+    TEST_ASSERT(decoder_read(decoder, samples, 4, &frames) == DECODER_OK && frames == 4, "Read should fill the request");
+    TEST_ASSERT(samples[6] == 3.0f / 32768.0f && samples[7] == -3.0f / 32768.0f, "Samples should be scaled to float");
+
+    TEST_ASSERT(decoder_seek(decoder, 1000) == 0, "Seek should succeed");
+    decoder_read(decoder, samples, 1, &frames);
+    TEST_ASSERT(samples[0] == 1000.0f / 32768.0f, "Seek should be sample accurate");
+
+    decoder_seek(decoder, 96000);
+    TEST_ASSERT(decoder_read(decoder, samples, 4, &frames) == DECODER_DONE && frames == 0, "Reading past the end should finish");
+    decoder_destroy(decoder);
+
+    RhythmEngine* engine = rhythm_engine_create();
+    TEST_ASSERT(engine != NULL, "Engine creation should succeed");
+    TEST_ASSERT(rhythm_engine_load_file(engine, "test_file.wav") == RHYTHM_OK, "WAV file should load");
+    TEST_ASSERT(rhythm_engine_play(engine) == RHYTHM_OK, "WAV file should play without mpg123");
+
+    RhythmStatus status = rhythm_engine_get_status(engine);
+    TEST_ASSERT(status.total_time == 2, "Duration should be known up front");
+    TEST_ASSERT(rhythm_engine_seek(engine, 0.5f) == RHYTHM_OK, "Seek should succeed");
+
+    rhythm_engine_destroy(engine);
+    unlink("test_file.wav");
+    TEST_PASS();
+}
+
+static bool wait_for_scan(RhythmEngine* engine, RhythmLoudnessScanStatus* status) {
+    for (int i = 0; i < 500; i++) {
+        rhythm_engine_get_loudness_scan_status(engine, status);
+        if (!status->running) return true;
+        usleep(10000);
+    }
+    return false;
+}
+
+static int test_loudness_scan(void) {
+    // 997 Hz at -20 dBFS in both channels reads -20 LUFS per BS.1770
+    LoudnessMeter* meter = loudness_meter_create(48000, 2);
+    TEST_ASSERT(meter != NULL, "Meter creation should succeed");
+    float block[2 * 4800];
+    for (int b = 0; b < 100; b++) {
+        for (int i = 0; i < 4800; i++) {
+            float x = 0.1f * sinf(2.0f * (float)M_PI * 997.0f * (float)(b * 4800 + i) / 48000.0f);
+            block[2 * i] = x;
+            block[2 * i + 1] = x;
+        }
+        loudness_meter_add_frames(meter, block, 4800);
+    }
+    LoudnessResult result;
+    loudness_meter_get_result(meter, &result);
+    loudness_meter_destroy(meter);
+    TEST_ASSERT(fabsf(result.integrated_lufs + 20.0f) < 0.1f, "Integrated loudness should match the reference tone");
+    TEST_ASSERT(result.loudness_range < 0.1f, "A steady tone should have no loudness range");
+    TEST_ASSERT(fabsf(result.true_peak_dbtp + 20.0f) < 0.2f, "True peak should match the tone amplitude");
+    TEST_ASSERT(fabsf(loudness_track_gain_db(&result, -18.0f) - 2.0f) < 0.1f, "Gain should reach the target");
+
+    setenv("RHYTHM_LOUDNESS_CACHE", "test_loudness.cache", 1);
+    mkdir("test_loudness", 0755);
+    create_test_wav("test_loudness/a.wav", 44100, 20000);
+    create_test_wav("test_loudness/b.wav", 48000, 24000);
+
+    RhythmEngine* engine = rhythm_engine_create();
+    TEST_ASSERT(engine != NULL, "Engine creation should succeed");
+    TEST_ASSERT(rhythm_engine_load_directory(engine, "test_loudness") == RHYTHM_OK, "Directory should load");
+    TEST_ASSERT(rhythm_engine_start_loudness_scan(engine, 2) == RHYTHM_OK, "Scan should start");
+
+    RhythmLoudnessScanStatus status;
+    TEST_ASSERT(wait_for_scan(engine, &status), "Scan should finish");
+    TEST_ASSERT(status.analysed == 2 && status.failed == 0, "Both tracks should be analysed");
+
+    TEST_ASSERT(rhythm_engine_start_loudness_scan(engine, 2) == RHYTHM_OK, "Rescan should start");
+    TEST_ASSERT(wait_for_scan(engine, &status), "Rescan should finish");
+    TEST_ASSERT(status.cached == 2 && status.analysed == 0, "Rescan should resume from the cache");
+
+    rhythm_engine_play(engine);
+    RhythmTrackLoudness loudness;
+    rhythm_engine_get_track_loudness(engine, &loudness);
+    TEST_ASSERT(loudness.measured, "Playing track should have a cached measurement");
+    TEST_ASSERT(fabsf(loudness.true_peak_dbtp + loudness.applied_gain_db + 1.0f) < 0.01f,
+                "Boost of a quiet track should stop at -1 dBTP");
+
+    rhythm_engine_destroy(engine);
+    unlink("test_loudness/a.wav");
+    unlink("test_loudness/b.wav");
+    rmdir("test_loudness");
+    unlink("test_loudness.cache");
+    unsetenv("RHYTHM_LOUDNESS_CACHE");
+    TEST_PASS();
+}
+
+static float process_sine(DspChain* dsp, float frequency, int blocks) {
+    float block[512 * 2];
+    float peak = 0.0f;
+    long frame = 0;
+    for (int b = 0; b < blocks; b++) {
+        for (int i = 0; i < 512; i++, frame++) {
+            float sample = 0.1f * sinf(2.0f * (float)M_PI * frequency * (float)frame / 48000.0f);
+            block[i * 2] = sample;
+            block[i * 2 + 1] = sample;
+        }
+        dsp_chain_process(dsp, block, 512, 2, 48000);
+        if (b == blocks - 1) {
+            for (int i = 0; i < 512 * 2; i++) {
+                if (fabsf(block[i]) > peak) peak = fabsf(block[i]);
+            }
+        }
+    }
+    return peak / 0.1f;
+}
+
+static int test_dsp_chain(void) {
+    DspChain* dsp = dsp_chain_create();
+    TEST_ASSERT(dsp != NULL, "Chain should be created");
+
+    DspStageParams preamp = { DSP_STAGE_PREAMP, 0.0f, -6.0206f, 0.0f, true };
+    DspStageParams peak = { DSP_STAGE_PEAKING, 1000.0f, 12.0f, 1.41f, true };
+    TEST_ASSERT(dsp_chain_add_stage(dsp, &preamp) == 0, "Preamp should be stage 0");
+    TEST_ASSERT(dsp_chain_add_stage(dsp, &peak) == 1, "Peaking band should be stage 1");
+
+    float gain = process_sine(dsp, 1000.0f, 40);
+    TEST_ASSERT(fabsf(gain - 0.5f * 3.981f) < 0.05f, "1 kHz should get preamp plus 12 dB");
+    gain = process_sine(dsp, 100.0f, 40);
+    TEST_ASSERT(fabsf(gain - 0.5f) < 0.03f, "100 Hz should only get the preamp");
+
+    // updates glide in over the following blocks
+    preamp.gain_db = 0.0f;
+    peak.gain_db = 0.0f;
+    TEST_ASSERT(dsp_chain_set_stage(dsp, 0, &preamp) == 0, "Stage update should succeed");
+    TEST_ASSERT(dsp_chain_set_stage(dsp, 1, &peak) == 0, "Stage update should succeed");
+    TEST_ASSERT(dsp_chain_set_stage(dsp, 2, &peak) != 0, "Unknown stage should be rejected");
+    gain = process_sine(dsp, 1000.0f, 1);
+    TEST_ASSERT(gain > 1.1f, "Gain should not jump in a single block");
+    gain = process_sine(dsp, 1000.0f, 60);
+    TEST_ASSERT(fabsf(gain - 1.0f) < 0.01f, "Flat chain should settle to unity");
+    dsp_chain_destroy(dsp);
+
+    RhythmEngine* engine = rhythm_engine_create();
+    TEST_ASSERT(engine != NULL, "Engine creation should succeed");
+
+    RhythmEqualizer eq;
+    TEST_ASSERT(rhythm_engine_set_eq_band(engine, 3, 30.0f) == RHYTHM_OK, "Band gain should be set");
+    TEST_ASSERT(rhythm_engine_set_eq_band(engine, RHYTHM_EQ_BANDS, 1.0f) != RHYTHM_OK, "Out of range band should fail");
+    TEST_ASSERT(rhythm_engine_set_eq_preamp(engine, -3.0f) == RHYTHM_OK, "Preamp should be set");
+    TEST_ASSERT(rhythm_engine_get_eq(engine, &eq) == RHYTHM_OK, "EQ should be readable");
+    TEST_ASSERT(eq.enabled && eq.band_gain_db[3] == 24.0f, "Band gain should be clamped");
+    TEST_ASSERT(eq.preamp_db == -3.0f && eq.band_frequency[5] == 1000.0f, "EQ layout should be reported");
+    rhythm_engine_destroy(engine);
+
+    TEST_PASS();
+}
+
+static int count_directory_entries(const char* path) {
+    DIR* dir = opendir(path);
+    if (!dir) return 0;
+    int count = 0;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] != '.') count++;
+    }
+    closedir(dir);
+    return count;
+}
+
+static void remove_waveform_cache(void) {
+    DIR* dir = opendir("test_waveform_cache");
+    struct dirent* entry;
+    while (dir && (entry = readdir(dir)) != NULL) {
+        char path[512];
+        snprintf(path, sizeof(path), "test_waveform_cache/%s", entry->d_name);
+        if (entry->d_name[0] != '.') unlink(path);
+    }
+    if (dir) closedir(dir);
+    rmdir("test_waveform_cache");
+}
+
+static bool wait_for_waveform(Waveform* waveform) {
+    for (int i = 0; i < 500 && !waveform_is_complete(waveform); i++) {
+        usleep(10000);
+    }
+    return waveform_is_complete(waveform);
+}
+
+static int test_waveform_overview(void) {
+    remove_waveform_cache();
+    create_test_wav("test_waveform.wav", 44100, 20000);
+
+    Waveform* waveform = waveform_open("test_waveform.wav", "test_waveform_cache");
+    TEST_ASSERT(waveform != NULL, "Waveform build should start");
+    TEST_ASSERT(wait_for_waveform(waveform), "Waveform build should finish");
+    TEST_ASSERT(waveform_total_frames(waveform) == 20000, "Length should be exact once complete");
+    TEST_ASSERT(waveform_progress(waveform) == 1.0f, "Progress should be complete");
+
+    // the test ramp rises linearly on the left channel and falls on the right
+    WaveformBucket buckets[10];
+    TEST_ASSERT(waveform_get_buckets(waveform, 0, 20000, buckets, 10) == 0, "Buckets should be returned");
+    for (int b = 0; b < 10; b++) {
+        float expected = (float)((b + 1) * 2000) / 32768.0f;
+        TEST_ASSERT(fabsf(buckets[b].max - expected) < 0.04f, "Bucket max should follow the ramp");
+        TEST_ASSERT(fabsf(buckets[b].min + expected) < 0.04f, "Bucket min should mirror the max");
+        TEST_ASSERT(buckets[b].rms > 0.0f && buckets[b].rms < buckets[b].max, "RMS should lie below the peak");
+    }
+
+    // zooming into one base bin and past the end of the file
+    WaveformBucket fine[4];
+    TEST_ASSERT(waveform_get_buckets(waveform, 19900, 20100, fine, 4) == 0, "Narrow range should work");
+    TEST_ASSERT(fine[0].max > 0.6f && fine[3].max == 0.0f, "Frames past the end should be empty");
+    TEST_ASSERT(waveform_get_buckets(waveform, 100, 100, fine, 4) != 0, "Empty range should be rejected");
+    waveform_destroy(waveform);
+
+    TEST_ASSERT(count_directory_entries("test_waveform_cache") == 1, "Overview should be cached on disk");
+    waveform = waveform_open("test_waveform.wav", "test_waveform_cache");
+    TEST_ASSERT(waveform != NULL && wait_for_waveform(waveform), "Cached overview should load");
+    WaveformBucket cached[10];
+    waveform_get_buckets(waveform, 0, 20000, cached, 10);
+    TEST_ASSERT(memcmp(cached, buckets, sizeof(buckets)) == 0, "Cached overview should match the decoded one");
+    waveform_destroy(waveform);
+
+    RhythmEngine* engine = rhythm_engine_create();
+    TEST_ASSERT(engine != NULL, "Engine creation should succeed");
+    float ready = 0.0f;
+    TEST_ASSERT(rhythm_engine_get_waveform(engine, 0.0f, 1.0f, cached, 10, &ready) == RHYTHM_ERROR_INVALID_STATE,
+                "No overview should exist before playback");
+    rhythm_engine_destroy(engine);
+
+    remove_waveform_cache();
+    unlink("test_waveform.wav");
+
+    TEST_PASS();
+}
+
+static void push_kick_track(FeatureAnalyzer* analyzer, long start, long frames, long beat_frames) {
+    float block[512 * 2];
+    unsigned seed = 1;
+    for (long frame = start; frame < start + frames; ) {
+        for (int i = 0; i < 512; i++, frame++) {
+            long since = frame % beat_frames;
+            float t = (float)since / 48000.0f;
+            float sample = 0.6f * expf(-t * 40.0f) * sinf(2.0f * (float)M_PI * 60.0f * t)
+                         + 0.01f * sinf(2.0f * (float)M_PI * 5000.0f * (float)frame / 48000.0f);
+            if (since < 150) {
+                seed = seed * 1103515245u + 12345u;
+                sample += 0.3f * ((float)((seed >> 16) & 0x7fff) / 16384.0f - 1.0f);
+            }
+            block[i * 2] = sample;
+            block[i * 2 + 1] = sample;
+        }
+        feature_analyzer_push(analyzer, block, 512, 2, 48000);
+        if (frame % 12288 == 0) feature_analyzer_drain(analyzer, 2000);
+    }
+}
+
+static int test_audio_features(void) {
+    FeatureAnalyzer* analyzer = feature_analyzer_create(true);
+    TEST_ASSERT(analyzer != NULL, "Analyzer should be created");
+
+    // a kick drum every 24000 frames is 120 BPM at 48 kHz
+    const long beat_frames = 24000, total = 48000 * 12;
+    push_kick_track(analyzer, 0, total, beat_frames);
+    TEST_ASSERT(feature_analyzer_drain(analyzer, 2000) == 0, "Analysis should keep up");
+
+    AudioFeatures features;
+    feature_analyzer_get(analyzer, &features, 0);
+    TEST_ASSERT(fabsf(features.bpm - 120.0f) < 3.0f, "Tempo should be 120 BPM");
+    TEST_ASSERT(features.beat_confidence > 0.2f, "Regular kicks should give a confident tempo");
+    TEST_ASSERT(features.onset_count >= 20 && features.onset_count <= 26, "Each kick should be one onset");
+    TEST_ASSERT(features.centroid_hz > 1000.0f && features.centroid_hz < 6000.0f, "Centroid should follow the tone between kicks");
+    TEST_ASSERT(features.high > 0.05f && features.bass < 0.01f, "Only the tone should be left between kicks");
+
+    // the pushed frames end mid-beat; the tracker should know where
+    float expected = (float)(total % beat_frames) / beat_frames;
+    float error = fabsf(features.beat_phase - expected);
+    if (error > 0.5f) error = 1.0f - error;
+    TEST_ASSERT(error < 0.1f, "Beat phase should follow the kicks");
+    TEST_ASSERT(features.beat_count >= 10, "Beats should be counted");
+
+    // latency moves the phase back by the same fraction of a beat
+    AudioFeatures delayed;
+    feature_analyzer_get(analyzer, &delayed, beat_frames / 4);
+    float shift = features.beat_phase - delayed.beat_phase;
+    if (shift < 0.0f) shift += 1.0f;
+    TEST_ASSERT(fabsf(shift - 0.25f) < 0.01f, "Output latency should delay the phase");
+
+    feature_analyzer_reset(analyzer);
+    feature_analyzer_get(analyzer, &features, 0);
+    TEST_ASSERT(features.bpm == 0.0f && features.onset_count == 0, "Reset should forget the tempo");
+    feature_analyzer_destroy(analyzer);
+
+    RhythmEngine* engine = rhythm_engine_create();
+    TEST_ASSERT(engine != NULL, "Engine creation should succeed");
+    RhythmStatus status = rhythm_engine_get_status(engine);
+    TEST_ASSERT(status.features.bpm == 0.0f && status.features.bass == 0.0f, "Idle engine should report no features");
+    rhythm_engine_destroy(engine);
+
+    TEST_PASS();
+}
+
+static int test_engine_host(void) {
+    char name[64];
+    snprintf(name, sizeof(name), "/rhythm-test-%d", (int)getpid());
+    TEST_ASSERT(rhythm_client_connect(name) == NULL, "Connecting without a host should fail");
+
+    RhythmEngine* engine = rhythm_engine_create();
+    TEST_ASSERT(engine != NULL, "Engine creation should succeed");
+    EngineHost* host = engine_host_create(engine, name);
+    TEST_ASSERT(host != NULL && strcmp(engine_host_name(host), name) == 0, "Host should serve the engine");
+
+    RhythmClient* client = rhythm_client_connect(name);
+    TEST_ASSERT(client != NULL, "Client should attach to the host");
+    TEST_ASSERT(rhythm_client_host_alive(client), "Host should be alive");
+
+    RhythmStatusFrame frame;
+    memset(&frame, 0, sizeof(frame));
+    TEST_ASSERT(rhythm_client_get_status_frame(client, &frame) == RHYTHM_OK, "Status should be readable");
+    TEST_ASSERT(frame.status.total_tracks == 0, "Nothing should be loaded yet");
+
+    create_test_directory("test_dir");
+    TEST_ASSERT(rhythm_client_call(client, ENGINE_COMMAND_LOAD_DIRECTORY, 0, 0.0f, "test_dir", 2000) == RHYTHM_OK,
+                "Directory should load on the host");
+    TEST_ASSERT(rhythm_client_call(client, ENGINE_COMMAND_LOAD_FILE, 0, 0.0f, "/nonexistent/file.mp3", 2000) != RHYTHM_OK,
+                "Host errors should come back to the client");
+
+    // queued commands run in order and the state that follows is published with them
+    int64_t ticket = rhythm_client_send(client, ENGINE_COMMAND_SET_VOLUME, 0, 0.5f, NULL);
+    int64_t eq_ticket = rhythm_client_send(client, ENGINE_COMMAND_SET_EQ_BAND, 2, 6.0f, NULL);
+    TEST_ASSERT(ticket >= 0 && eq_ticket == ticket + 1, "Commands should be queued");
+    TEST_ASSERT(rhythm_client_wait(client, eq_ticket, 2000) == RHYTHM_OK, "Commands should complete");
+    TEST_ASSERT(rhythm_client_wait(client, ticket, 0) == RHYTHM_OK, "Earlier ticket should be done too");
+    rhythm_client_get_status_frame(client, &frame);
+    TEST_ASSERT(frame.status.total_tracks == 2 && frame.status.volume == 0.5f, "Host state should be published");
+    TEST_ASSERT(strcmp(frame.file_name, "test1.mp3") == 0 || strcmp(frame.file_name, "test2.mp3") == 0,
+                "File name should be published");
+    RhythmEqualizer eq;
+    TEST_ASSERT(rhythm_client_get_eq(client, &eq) == RHYTHM_OK && eq.band_gain_db[2] == 6.0f, "EQ should be published");
+
+    RhythmWaveformBucket buckets[8];
+    float ready = 1.0f;
+    TEST_ASSERT(rhythm_client_get_waveform(client, 0.0f, 1.0f, buckets, 8, &ready) == RHYTHM_OK, "Overview should be readable");
+    TEST_ASSERT(ready == 0.0f && buckets[0].max == 0.0f, "No overview should exist before playback");
+    TEST_ASSERT(rhythm_client_get_waveform(client, 0.5f, 0.5f, buckets, 8, &ready) != RHYTHM_OK, "Empty range should be rejected");
+
+    char long_path[ENGINE_SHM_PATH_MAX + 8];
+    memset(long_path, 'a', sizeof(long_path) - 1);
+    long_path[sizeof(long_path) - 1] = '\0';
+    TEST_ASSERT(rhythm_client_send(client, ENGINE_COMMAND_LOAD_FILE, 0, 0.0f, long_path) < 0, "Oversized paths should be refused");
+
+    engine_host_destroy(host);
+    TEST_ASSERT(!rhythm_client_host_alive(client), "Host should be gone");
+    rhythm_client_disconnect(client);
+    TEST_ASSERT(rhythm_client_connect(name) == NULL, "Segment should be unlinked");
+
+    rhythm_engine_destroy(engine);
+    cleanup_test_files();
+    TEST_PASS();
+}
+
+static int test_rhythm_server(void) {
+    const char* path = "rhythmd_test.sock";
+    unlink(path);
+    TEST_ASSERT(rhythm_remote_connect(path) == NULL, "Connecting without a daemon should fail");
+
+    RhythmEngine* engine = rhythm_engine_create();
+    TEST_ASSERT(engine != NULL, "Engine creation should succeed");
+    RhythmServer* server = rhythm_server_create(engine, path);
+    TEST_ASSERT(server != NULL, "Server should listen");
+    TEST_ASSERT(rhythm_server_create(engine, path) == NULL, "A second daemon on the same socket should be refused");
+
+    RhythmRemote* control = rhythm_remote_connect(path);
+    RhythmRemote* watcher = rhythm_remote_connect(path);
+    TEST_ASSERT(control != NULL && watcher != NULL, "Clients should connect");
+    TEST_ASSERT(rhythm_remote_ping(control, 2000) == RHYTHM_OK, "Ping should be answered");
+    TEST_ASSERT(rhythm_remote_subscribe(watcher, RHYTHM_SUBSCRIBE_EVENTS, 2000) == RHYTHM_OK, "Subscription should succeed");
+
+    create_test_directory("test_dir");
+    TEST_ASSERT(rhythm_remote_command(control, ENGINE_COMMAND_LOAD_DIRECTORY, 0, 0.0f, "test_dir", 2000) == RHYTHM_OK,
+                "Directory should load through the daemon");
+    TEST_ASSERT(rhythm_remote_command(control, ENGINE_COMMAND_LOAD_FILE, 0, 0.0f, "/nonexistent/file.mp3", 2000)
+                == RHYTHM_ERROR_FILE_NOT_FOUND, "Engine errors should come back to the client");
+
+    // pipelined requests are answered in order
+    int64_t first = rhythm_remote_send_command(control, ENGINE_COMMAND_SET_VOLUME, 0, 0.25f, NULL);
+    int64_t second = rhythm_remote_send(control, RHYTHM_MSG_GET_STATUS, NULL, 0);
+    RhythmMessage* message = malloc(sizeof(RhythmMessage));
+    TEST_ASSERT(message != NULL && first > 0 && second == first + 1, "Requests should be sent");
+    TEST_ASSERT(rhythm_remote_receive(control, message, 2000) == 1 && message->header.id == (uint32_t)first &&
+                message->header.type == RHYTHM_MSG_RESULT && message->payload.result.result == RHYTHM_OK,
+                "Command result should come first");
+    TEST_ASSERT(rhythm_remote_receive(control, message, 2000) == 1 && message->header.id == (uint32_t)second &&
+                message->header.type == RHYTHM_MSG_STATUS, "Status should follow");
+    TEST_ASSERT(message->payload.status.status.total_tracks == 2 && message->payload.status.status.volume == 0.25f,
+                "Status should reflect the commands");
+
+    // the playlist change reaches the subscriber, the control connection gets no stream
+    bool playlist_event = false;
+    while (!playlist_event && rhythm_remote_receive(watcher, message, 2000) == 1) {
+        playlist_event = message->header.type == RHYTHM_MSG_EVENT && message->payload.event.event == RHYTHM_EVENT_PLAYLIST &&
+                         message->payload.event.value == 2;
+    }
+    TEST_ASSERT(playlist_event, "Subscriber should see the playlist event");
+    TEST_ASSERT(rhythm_remote_receive(control, message, 50) == 0, "Unsubscribed clients should get no stream");
+
+    TEST_ASSERT(rhythm_remote_subscribe(watcher, RHYTHM_SUBSCRIBE_VIS, 2000) == RHYTHM_OK, "Vis subscription should succeed");
+    bool vis = false;
+    for (int i = 0; i < 10 && !vis; i++) {
+        vis = rhythm_remote_receive(watcher, message, 500) == 1 && message->header.type == RHYTHM_MSG_VIS;
+    }
+    TEST_ASSERT(vis, "Vis frames should stream");
+
+    // a malformed frame costs only that connection
+    struct sockaddr_un address = {.sun_family = AF_UNIX};
+    strcpy(address.sun_path, path);
+    int raw = socket(AF_UNIX, SOCK_STREAM, 0);
+    TEST_ASSERT(raw >= 0 && connect(raw, (struct sockaddr*)&address, sizeof(address)) == 0, "Raw socket should connect");
+    RhythmMessageHeader bad = {.length = RHYTHM_PROTOCOL_MAX_PAYLOAD + 1, .type = RHYTHM_MSG_PING,
+                               .version = RHYTHM_PROTOCOL_VERSION, .id = 1};
+    TEST_ASSERT(write(raw, &bad, sizeof(bad)) == (ssize_t)sizeof(bad), "Bad header should be written");
+    char byte;
+    TEST_ASSERT(read(raw, &byte, 1) == 0, "Daemon should close a malformed connection");
+    close(raw);
+    TEST_ASSERT(rhythm_remote_ping(control, 2000) == RHYTHM_OK, "Other clients should be unaffected");
+
+    RhythmServerStats stats;
+    rhythm_server_get_stats(server, &stats);
+    TEST_ASSERT(stats.accepted >= 3 && stats.clients == 2 && stats.protocol_errors == 1, "Stats should count clients and errors");
+
+    rhythm_remote_close(watcher);
+    rhythm_server_destroy(server);
+    TEST_ASSERT(rhythm_remote_ping(control, 500) != RHYTHM_OK, "Daemon should be gone");
+    TEST_ASSERT(access(path, F_OK) != 0, "Socket file should be removed");
+    rhythm_remote_close(control);
+
+    free(message);
+    rhythm_engine_destroy(engine);
+    cleanup_test_files();
+    TEST_PASS();
+}
+
+static int test_mixer(void) {
+    create_test_wav("test_mixer.wav", 48000, 4800);
+    Mixer* mixer = mixer_create(false);
+    TEST_ASSERT(mixer != NULL, "Mixer creation should succeed");
+    mixer_set_format(mixer, 48000, 2);
+
+    MixerVoiceParams params = {.gain = 1.0f, .pan = 0.0f};
+    int voice = mixer_play(mixer, "test_mixer.wav", &params);
+    TEST_ASSERT(voice >= 0 && mixer_voice_active(mixer, voice), "Voice should start");
+    TEST_ASSERT(mixer_play(mixer, "missing.wav", &params) < 0, "Missing files should be refused");
+    while (mixer_decode(mixer)) {}
+
+    // the first block fades in from silence, the next is the source at unity
+    float bus[256 * 2];
+    memset(bus, 0, sizeof(bus));
+    mixer_render(mixer, bus, 256, 2, 48000, 1.0f);
+    TEST_ASSERT(bus[0] == 0.0f && bus[511] < 0.0f, "Voice should fade in");
+    memset(bus, 0, sizeof(bus));
+    mixer_render(mixer, bus, 256, 2, 48000, 1.0f);
+    TEST_ASSERT(fabsf(bus[0] - 256.0f / 32768.0f) < 1e-5f && bus[1] == -bus[0], "Centered voice should sum at unity");
+
+    // hard right at half gain: one block to glide, then the left side is silent
+    params.gain = 0.5f;
+    params.pan = 1.0f;
+    TEST_ASSERT(mixer_set_voice(mixer, voice, &params) == 0, "Parameters should be accepted");
+    memset(bus, 0, sizeof(bus));
+    mixer_render(mixer, bus, 256, 2, 48000, 1.0f);
+    memset(bus, 0, sizeof(bus));
+    mixer_render(mixer, bus, 256, 2, 48000, 1.0f);
+    TEST_ASSERT(fabsf(bus[0]) < 1e-5f && fabsf(bus[1] + 0.5f * 768.0f / 32768.0f) < 1e-5f, "Pan should silence the far side");
+
+    for (int i = 0; i < 32 && mixer_voice_active(mixer, voice); i++) {
+        mixer_render(mixer, bus, 256, 2, 48000, 1.0f);
+        mixer_decode(mixer);
+    }
+    MixerStats stats;
+    mixer_get_stats(mixer, &stats);
+    TEST_ASSERT(!mixer_voice_active(mixer, voice) && stats.active == 0 && stats.finished == 1, "Voice should end at EOF");
+    TEST_ASSERT(mixer_set_voice(mixer, voice, &params) != 0 && mixer_stop(mixer, voice) != 0, "Stale ids should be rejected");
+
+    // a looping announcement ducks the music until it is stopped
+    MixerVoiceParams duck = {.gain = 0.0f, .duck = true, .loop = true};
+    int announcement = mixer_play(mixer, "test_mixer.wav", &duck);
+    TEST_ASSERT(announcement >= 0 && announcement != voice, "Slot should be reused under a new id");
+    for (int i = 0; i < 48; i++) {
+        mixer_decode(mixer);
+        for (int j = 0; j < 512; j++) bus[j] = 0.5f;
+        mixer_render(mixer, bus, 256, 2, 48000, 1.0f);
+    }
+    mixer_get_stats(mixer, &stats);
+    TEST_ASSERT(mixer_voice_active(mixer, announcement), "Looping voice should continue past its end");
+    TEST_ASSERT(fabsf(stats.duck_gain - powf(10.0f, -12.0f / 20.0f)) < 0.01f && fabsf(bus[0] - 0.5f * stats.duck_gain) < 0.01f,
+                "Music should be ducked by 12 dB");
+
+    TEST_ASSERT(mixer_stop(mixer, announcement) == 0, "Stop should be accepted");
+    for (int i = 0; i < 1000; i++) {
+        mixer_decode(mixer);
+        mixer_render(mixer, bus, 256, 2, 48000, 1.0f);
+    }
+    mixer_get_stats(mixer, &stats);
+    TEST_ASSERT(stats.duck_gain == 1.0f && stats.finished == 2 && stats.starved_blocks == 0, "Ducking should release after stop");
+    mixer_destroy(mixer);
+
+    RhythmEngine* engine = rhythm_engine_create();
+    TEST_ASSERT(engine != NULL, "Engine creation should succeed");
+    int id = -1;
+    TEST_ASSERT(rhythm_engine_play_overlay(engine, "missing.wav", &params, &id) == RHYTHM_ERROR_FILE_NOT_FOUND,
+                "Missing overlays should be reported");
+    TEST_ASSERT(rhythm_engine_play_overlay(engine, "test_mixer.wav", &params, &id) == RHYTHM_OK && id >= 0,
+                "Overlay should start");
+    TEST_ASSERT(rhythm_engine_stop_overlay(engine, id) == RHYTHM_OK, "Overlay should stop");
+    TEST_ASSERT(rhythm_engine_stop_overlay(engine, -1) == RHYTHM_ERROR_INVALID_STATE, "Unknown voices should be rejected");
+    rhythm_engine_destroy(engine);
+
+    unlink("test_mixer.wav");
+    TEST_PASS();
+}
+
+typedef struct {
+    atomic_int runs;
+    atomic_int inside;
+    atomic_bool overlapped;
+    int work;                       // steps that report more to do
+} PoolCounter;
+
+static bool pool_counter_step(void* arg) {
+    PoolCounter* counter = arg;
+    if (atomic_fetch_add(&counter->inside, 1) != 0) atomic_store(&counter->overlapped, true);
+    atomic_fetch_add(&counter->runs, 1);
+    usleep(100);
+    bool more = counter->work > 0;
+    if (more) counter->work--;
+    atomic_fetch_sub(&counter->inside, 1);
+    return more;
+}
+
+static int test_decoder_pool(void) {
+    DecoderPool* pool = decoder_pool_create(2);
+    TEST_ASSERT(pool != NULL, "Pool creation should succeed");
+
+    // a job that keeps reporting work is stepped until it is done, one worker at a time
+    PoolCounter busy = {.work = 100};
+    PoolCounter idle = {0};
+    DecoderJob* busy_job = decoder_pool_add(pool, pool_counter_step, &busy, 1000);
+    DecoderJob* idle_job = decoder_pool_add(pool, pool_counter_step, &idle, 1000);
+    TEST_ASSERT(busy_job != NULL && idle_job != NULL, "Jobs should be added");
+    for (int i = 0; i < 2000 && busy.work > 0; i++) {
+        decoder_pool_wake(busy_job);
+        usleep(1000);
+    }
+    TEST_ASSERT(busy.work == 0 && !atomic_load(&busy.overlapped), "Busy job should run to completion without overlap");
+
+    // a parked job runs again when woken, long before its poll interval
+    usleep(20000);
+    int before = atomic_load(&idle.runs);
+    decoder_pool_wake(idle_job);
+    for (int i = 0; i < 200 && atomic_load(&idle.runs) == before; i++) usleep(1000);
+    TEST_ASSERT(atomic_load(&idle.runs) > before, "Wake should run a parked job");
+
+    DecoderPoolStats stats;
+    decoder_pool_get_stats(pool, &stats);
+    TEST_ASSERT(stats.threads == 2 && stats.jobs == 2 && stats.steps >= 100, "Stats should count threads, jobs and steps");
+
+    decoder_pool_remove(pool, busy_job);
+    int runs = atomic_load(&busy.runs);
+    usleep(20000);
+    TEST_ASSERT(atomic_load(&busy.runs) == runs, "Removed jobs should not run again");
+    decoder_pool_remove(pool, idle_job);
+    decoder_pool_destroy(pool);
+
+    // engines share one pool and can be torn down in any order
+    create_test_wav("test_pool.wav", 44100, 44100);
+    RhythmEngine* engines[4];
+    for (int i = 0; i < 4; i++) {
+        engines[i] = rhythm_engine_create();
+        TEST_ASSERT(engines[i] != NULL, "Engine creation should succeed");
+        TEST_ASSERT(rhythm_engine_load_file(engines[i], "test_pool.wav") == RHYTHM_OK &&
+                    rhythm_engine_play(engines[i]) == RHYTHM_OK, "Every engine should play");
+    }
+    DecoderPool* shared = audio_context_acquire_pool();
+    decoder_pool_get_stats(shared, &stats);
+    TEST_ASSERT(stats.jobs == 12, "Every engine should run its jobs on the shared pool");
+    audio_context_release_pool();
+
+    rhythm_engine_destroy(engines[1]);
+    rhythm_engine_destroy(engines[3]);
+    RhythmStats engine_stats;
+    for (int i = 0; i < 200; i++) {
+        rhythm_engine_get_stats(engines[0], &engine_stats);
+        if (engine_stats.decode_p50_us > 0.0f) break;
+        usleep(1000);
+    }
+    TEST_ASSERT(engine_stats.decode_p50_us > 0.0f, "Remaining engines should keep decoding");
+    rhythm_engine_destroy(engines[0]);
+    rhythm_engine_destroy(engines[2]);
+
+    RhythmEngine* engine = rhythm_engine_create();
+    TEST_ASSERT(engine != NULL && rhythm_engine_load_file(engine, "test_pool.wav") == RHYTHM_OK,
+                "A new engine should start after the last one is gone");
+    rhythm_engine_destroy(engine);
+
+    unlink("test_pool.wav");
+    TEST_PASS();
+}
+
+static int test_conversion_plan(void) {
+    ConversionPlan plan;
+    TEST_ASSERT(conversion_plan_init(&plan, 48000, 2, 48000, 2, 2048) == 0, "Matching formats should plan");
+    TEST_ASSERT(plan.passthrough && !plan.remap && !plan.resample && plan.max_out_samples == 2050 * 2,
+                "Matching formats should pass straight through");
+    TEST_ASSERT(conversion_plan_init(&plan, 0, 2, 48000, 2, 2048) != 0, "Unknown rates should be refused");
+    TEST_ASSERT(conversion_plan_init(&plan, 48000, 3, 48000, 2, 2048) != 0, "Unsupported layouts should be refused");
+
+    // the specialized kernels must produce exactly what the generic converters do
+    float input[441 * 2], generic_mixed[441 * 2], generic[480 * 2], planned_mixed[441 * 2], planned[480 * 2];
+    for (int i = 0; i < 441 * 2; i++) input[i] = sinf((float)i * 0.05f);
+
+    TEST_ASSERT(conversion_plan_init(&plan, 44100, 1, 48000, 2, 2048) == 0, "Mono 44.1 kHz should plan");
+    TEST_ASSERT(!plan.passthrough && plan.remap && plan.resample, "Both stages should be resolved");
+    convert_audio_format(input, generic_mixed, 441, 1, 2);
+    resample_audio(generic_mixed, generic, 441, 480, 2);
+    plan.remap(input, planned_mixed, 441);
+    plan.resample(planned_mixed, planned, 441, 480);
+    TEST_ASSERT(memcmp(generic, planned, sizeof(planned)) == 0, "Mono to stereo kernels should match");
+
+    TEST_ASSERT(conversion_plan_init(&plan, 44100, 2, 48000, 1, 2048) == 0 && plan.remap && plan.resample,
+                "Stereo to mono should plan");
+    convert_audio_format(input, generic_mixed, 441, 2, 1);
+    resample_audio(generic_mixed, generic, 441, 480, 1);
+    plan.remap(input, planned_mixed, 441);
+    plan.resample(planned_mixed, planned, 441, 480);
+    TEST_ASSERT(memcmp(generic, planned, 480 * sizeof(float)) == 0, "Stereo to mono kernels should match");
+
+    // a 44.1 kHz track on a 48 kHz output plays through the planned path
+    create_test_wav("test_plan.wav", 44100, 44100);
+    RhythmEngine* engine = rhythm_engine_create();
+    TEST_ASSERT(engine != NULL, "Engine creation should succeed");
+    TEST_ASSERT(rhythm_engine_load_file(engine, "test_plan.wav") == RHYTHM_OK && rhythm_engine_play(engine) == RHYTHM_OK,
+                "Resampled track should play");
+    RhythmAudioInfo info;
+    TEST_ASSERT(rhythm_engine_get_audio_info(engine, &info) == RHYTHM_OK && info.resampling, "Output should be resampling");
+    rhythm_engine_destroy(engine);
+    unlink("test_plan.wav");
+    TEST_PASS();
+}
+
+// minimal HTTP/1.0 server answering GET /<name> with <root>/<name>, stalling once mid-body
+typedef struct {
+    int listen_fd;
+    int port;
+    const char* root;
+    size_t stall_at;
+    int stall_ms;
+    int connections;
+    pthread_t thread;
+} HttpStandIn;
+
+static void* http_stand_in_main(void* arg) {
+    HttpStandIn* server = arg;
+    for (int c = 0; c < server->connections; c++) {
+        int fd = accept(server->listen_fd, NULL, NULL);
+        if (fd < 0) break;
+
+        char request[1024] = {0};
+        size_t used = 0;
+        while (used < sizeof(request) - 1 && !strstr(request, "\r\n\r\n")) {
+            ssize_t got = read(fd, request + used, sizeof(request) - 1 - used);
+            if (got <= 0) break;
+            used += (size_t)got;
+        }
+
+        char name[256] = "", path[1024];
+        sscanf(request, "GET /%255s", name);
+        snprintf(path, sizeof(path), "%s/%s", server->root, name);
+        FILE* f = fopen(path, "rb");
+        const char* head = f ? "HTTP/1.0 200 OK\r\nContent-Type: application/octet-stream\r\n\r\n"
+                             : "HTTP/1.0 404 Not Found\r\n\r\n";
+        send(fd, head, strlen(head), MSG_NOSIGNAL);
+
+        char buffer[4096];
+        size_t sent = 0, n;
+        bool stalled = false;
+        while (f && (n = fread(buffer, 1, sizeof(buffer), f)) > 0) {
+            if (!stalled && server->stall_ms > 0 && sent >= server->stall_at) {
+                usleep((useconds_t)server->stall_ms * 1000);
+                stalled = true;
+            }
+            if (send(fd, buffer, n, MSG_NOSIGNAL) != (ssize_t)n) break;
+            sent += n;
+        }
+        if (f) fclose(f);
+        close(fd);
+    }
+    return NULL;
+}
+
+static bool http_stand_in_start(HttpStandIn* server, const char* root, int connections) {
+    struct sockaddr_in address = {.sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK)};
+    socklen_t length = sizeof(address);
+    server->root = root;
+    server->connections = connections;
+    server->listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (server->listen_fd < 0 || bind(server->listen_fd, (struct sockaddr*)&address, sizeof(address)) != 0 ||
+        listen(server->listen_fd, 4) != 0 || getsockname(server->listen_fd, (struct sockaddr*)&address, &length) != 0) {
+        return false;
+    }
+    server->port = ntohs(address.sin_port);
+    return pthread_create(&server->thread, NULL, http_stand_in_main, server) == 0;
+}
+
+static void http_stand_in_stop(HttpStandIn* server) {
+    shutdown(server->listen_fd, SHUT_RDWR);
+    pthread_join(server->thread, NULL);
+    close(server->listen_fd);
+}
+
+// reads a stream decoder to its end, checking the ramp from create_test_wav
+static long long drain_stream(Decoder* decoder, bool* ramp_ok) {
+    float samples[1024 * 2];
+    long long total = 0;
+    *ramp_ok = true;
+    for (int idle = 0; idle < 5000;) {
+        size_t frames = 0;
+        DecoderStatus status = decoder_read(decoder, samples, 1024, &frames);
+        for (size_t i = 0; i < frames; i++) {
+            if (samples[i * 2] != (float)((total + (long long)i) % 32768) / 32768.0f) *ramp_ok = false;
+        }
+        total += (long long)frames;
+        if (status == DECODER_DONE || status == DECODER_ERROR) break;
+        if (frames == 0) {
+            usleep(1000);
+            idle++;
+        }
+    }
+    return total;
+}
+
+static void* write_fifo(void* arg) {
+    const char* path = arg;
+    FILE* out = fopen(path, "wb");
+    FILE* in = fopen("test_stream.wav", "rb");
+    char buffer[4096];
+    size_t n;
+    while (out && in && (n = fread(buffer, 1, sizeof(buffer), in)) > 0) fwrite(buffer, 1, n, out);
+    if (in) fclose(in);
+    if (out) fclose(out);
+    return NULL;
+}
+
+static int test_stream_sources(void) {
+    create_test_wav("test_stream.wav", 48000, 48000);
+    unlink("test_stream.fifo");
+    TEST_ASSERT(mkfifo("test_stream.fifo", 0600) == 0, "FIFO should be created");
+    TEST_ASSERT(stream_source_is_stream("-") && stream_source_is_stream("http://localhost/live") &&
+                stream_source_is_stream("test_stream.fifo") && !stream_source_is_stream("test_stream.wav"),
+                "Stdin, URLs and FIFOs should be streams, regular files not");
+
+    // the transport alone, against a real MP3 from the repository
+    HttpStandIn media = {0};
+    TEST_ASSERT(http_stand_in_start(&media, RHYTHM_TEST_MEDIA_DIR, 2), "Media server should start");
+    char url[128];
+    snprintf(url, sizeof(url), "http://127.0.0.1:%d/test.mp3", media.port);
+    StreamSource* source = stream_source_create();
+    TEST_ASSERT(source != NULL && stream_source_open(source, url) == 0, "HTTP stream should open");
+    char* buffer = malloc(65536);
+    long long received = 0;
+    size_t got;
+    while (buffer && (got = stream_source_read(source, buffer, 65536, 2000)) > 0) received += (long long)got;
+    StreamStats stats;
+    stream_source_get_stats(source, &stats);
+    struct stat st;
+    TEST_ASSERT(stat(RHYTHM_TEST_MEDIA_DIR "/test.mp3", &st) == 0 && received == (long long)st.st_size &&
+                stats.ended && stats.bytes_received == (uint64_t)st.st_size, "Every byte of the body should arrive");
+    snprintf(url, sizeof(url), "http://127.0.0.1:%d/missing.mp3", media.port);
+    TEST_ASSERT(stream_source_open(source, url) != 0, "A 404 should fail the open");
+    stream_source_destroy(source);
+    free(buffer);
+    http_stand_in_stop(&media);
+
+    // WAV over HTTP with the sender stalling three quarters in: the buffer runs dry once
+    HttpStandIn server = {.stall_at = 144000, .stall_ms = 300};
+    TEST_ASSERT(http_stand_in_start(&server, ".", 2), "WAV server should start");
+    snprintf(url, sizeof(url), "http://127.0.0.1:%d/test_stream.wav", server.port);
+    Decoder* decoder = stream_decoder_create();
+    TEST_ASSERT(decoder != NULL && decoder_open(decoder, url) == 0, "WAV stream should open");
+    TEST_ASSERT(decoder->rate == 48000 && decoder->channels == 2 && decoder->length_frames == -1,
+                "Format should be read from the stream, length left unknown");
+    TEST_ASSERT(decoder_seek(decoder, 100) != 0, "Streams should refuse to seek");
+    bool ramp_ok;
+    TEST_ASSERT(drain_stream(decoder, &ramp_ok) == 48000 && ramp_ok, "Every frame should arrive in order");
+    stream_decoder_get_stats(decoder, &stats);
+    TEST_ASSERT(stats.underruns >= 1 && stats.target_ms > STREAM_JITTER_START_MS && stats.ended,
+                "The stall should count an underrun and grow the jitter target");
+
+    // the same bytes through a FIFO
+    pthread_t writer;
+    TEST_ASSERT(pthread_create(&writer, NULL, write_fifo, "test_stream.fifo") == 0, "Writer should start");
+    TEST_ASSERT(decoder_open(decoder, "test_stream.fifo") == 0, "FIFO stream should open");
+    TEST_ASSERT(drain_stream(decoder, &ramp_ok) == 48000 && ramp_ok, "FIFO should deliver every frame");
+    pthread_join(writer, NULL);
+    decoder_destroy(decoder);
+
+    // engine: no duration, progress or seeking while a stream plays
+    RhythmEngine* engine = rhythm_engine_create();
+    TEST_ASSERT(engine != NULL, "Engine creation should succeed");
+    TEST_ASSERT(rhythm_engine_load_file(engine, url) == RHYTHM_OK, "URLs should load without a file");
+    TEST_ASSERT(rhythm_engine_play(engine) == RHYTHM_OK, "Stream should play");
+    RhythmStatus status = rhythm_engine_get_status(engine);
+    TEST_ASSERT(!status.duration_known && status.total_time == 0 && status.progress == 0.0f,
+                "Status should report an unknown duration");
+    TEST_ASSERT(rhythm_engine_seek(engine, 0.5f) != RHYTHM_OK, "Seeking a stream should fail");
+    RhythmStreamStats stream_stats;
+    TEST_ASSERT(rhythm_engine_get_stream_stats(engine, &stream_stats) == RHYTHM_OK && stream_stats.active &&
+                stream_stats.byte_rate == 192000.0f, "Stream stats should describe the open stream");
+    rhythm_engine_stop(engine);
+    http_stand_in_stop(&server);
+
+    TEST_ASSERT(rhythm_engine_load_file(engine, "test_stream.wav") == RHYTHM_OK &&
+                rhythm_engine_play(engine) == RHYTHM_OK, "WAV file should play");
+    status = rhythm_engine_get_status(engine);
+    TEST_ASSERT(status.duration_known && status.total_time == 1, "Files should report their duration");
+
+    rhythm_engine_destroy(engine);
+    unlink("test_stream.fifo");
+    unlink("test_stream.wav");
+    TEST_PASS();
+}
+
+static int test_playlist_view(void) {
+    Playlist* playlist = playlist_create();
+    PlaylistView* view = playlist_view_create();
+    TEST_ASSERT(playlist && view, "Playlist and view creation should succeed");
+
+    char path[64];
+    for (int i = 0; i < 5000; i++) {
+        snprintf(path, sizeof(path), "/music/%s_%04d.mp3", i % 3 == 0 ? "Live" : "studio", i);
+        playlist_add_file(playlist, path);
+    }
+
+    playlist_view_sync(view, playlist, 10);
+    TEST_ASSERT(playlist_view_count(view) == 5000, "Unfiltered view should show every entry");
+    TEST_ASSERT(playlist_view_index_at(view, 42) == 42, "Unfiltered positions should be playlist indices");
+    TEST_ASSERT(playlist_view_index_at(view, 5000) == -1, "Positions past the end should map to nothing");
+
+    playlist_view_move(view, 25);
+    TEST_ASSERT(playlist_view_cursor(view) == 25, "Cursor should move");
+    TEST_ASSERT(playlist_view_top(view) == 16, "Window should scroll just enough to show the cursor");
+    playlist_view_move(view, 1000000);
+    TEST_ASSERT(playlist_view_cursor(view) == 4999 && playlist_view_top(view) == 4990,
+                "Moving past the end should stop on the last entry");
+
+    playlist_view_jump(view, 2500);
+    TEST_ASSERT(playlist_view_cursor(view) == 2500 && playlist_view_top(view) == 2495,
+                "Jump should centre the window on the entry");
+
+    // a zero budget still makes progress, in bounded steps
+    playlist_view_set_query(view, "LIVE_1");
+    TEST_ASSERT(playlist_view_step(view, playlist, 0), "A zero budget should leave the scan unfinished");
+    TEST_ASSERT(playlist_view_scanning(view), "View should report the scan in progress");
+    TEST_ASSERT(playlist_view_scan_progress(view) > 0.0f && playlist_view_scan_progress(view) < 1.0f,
+                "Scan progress should be partial");
+    while (playlist_view_step(view, playlist, 0)) {
+    }
+
+    // typed characters narrow the matches; each result must equal a full scan
+    const char* queries[] = { "live_1", "live_12", "live_123", "live_12", "studio_4", "" };
+    for (size_t q = 0; q < sizeof(queries) / sizeof(queries[0]); q++) {
+        playlist_view_set_query(view, queries[q]);
+        while (playlist_view_step(view, playlist, 1000000)) {
+        }
+
+        int expected = 0;
+        bool ordered = true;
+        for (int i = 0; i < 5000; i++) {
+            const char* name = strrchr(playlist_get_file_at(playlist, i), '/') + 1;
+            char lowered[64];
+            size_t n = 0;
+            for (; name[n] && n < sizeof(lowered) - 1; n++) lowered[n] = (char)tolower((unsigned char)name[n]);
+            lowered[n] = '\0';
+            if (!strstr(lowered, queries[q])) continue;
+            if (playlist_view_index_at(view, expected) != i) ordered = false;
+            expected++;
+        }
+        TEST_ASSERT(!playlist_view_scanning(view), "Scan should finish");
+        TEST_ASSERT(playlist_view_count(view) == expected, "Match count should equal a full scan");
+        TEST_ASSERT(ordered, "Matches should keep playlist order");
+    }
+    TEST_ASSERT(playlist_view_query(view)[0] == '\0', "Empty query should clear the filter");
+
+    playlist_view_set_query(view, "studio");
+    playlist_view_jump(view, 3);
+    TEST_ASSERT(playlist_view_count(view) == 5000 && playlist_view_cursor(view) == 3,
+                "Jump should clear the filter");
+
+    playlist_view_destroy(view);
+    playlist_destroy(playlist);
+
+    RhythmEngine* engine = rhythm_engine_create();
+    TEST_ASSERT(playlist_get_count(rhythm_engine_get_playlist(engine)) == 0, "Playlist should be empty before a load");
+    create_test_directory("test_dir");
+    rhythm_engine_load_directory(engine, "test_dir");
+    TEST_ASSERT(playlist_get_count(rhythm_engine_get_playlist(engine)) == 2, "Engine should expose its playlist");
+    TEST_ASSERT(rhythm_engine_play_track(engine, 5) == RHYTHM_ERROR_INVALID_STATE,
+                "Playing an index outside the playlist should fail");
+    rhythm_engine_play_track(engine, 1);
+    RhythmStatus status = rhythm_engine_get_status(engine);
+    TEST_ASSERT(status.current_track == 2, "Play track should select the entry");
+
+    rhythm_engine_destroy(engine);
+    cleanup_test_files();
+    TEST_PASS();
+}
+
+static int test_search_index(void) {
+    SearchIndex* index = search_index_create();
+    TEST_ASSERT(index != NULL, "Index creation should succeed");
+
+    search_index_add_path(index, "/music/The Beatles/Abbey Road/07 Here Comes the Sun.mp3");   // 0
+    search_index_add_path(index, "/music/Nina Simone/Pastel Blues/Sunday in Savannah.mp3");    // 1
+    search_index_add_path(index, "/music/Sun Ra/Lanquidity/Where Pathways Meet.mp3");          // 2
+    search_index_add_path(index, "/music/Various/Sunny Days/Beatles Medley.wav");              // 3
+    search_index_add(index, "Sunshine", NULL, NULL);                                          // 4
+    for (int i = 0; i < 2000; i++) {
+        char path[96];
+        snprintf(path, sizeof(path), "/music/Filler %d/Album %d/Track %d.mp3", i % 50, i % 7, i);
+        search_index_add_path(index, path);
+    }
+    TEST_ASSERT(search_index_count(index) == 2005, "Every entry should be indexed");
+
+    int results[16];
+    int found = search_index_query(index, "sun", results, 16);
+    TEST_ASSERT(found == 5, "Substring should match inside words and in every field");
+    TEST_ASSERT(results[0] == 0, "Whole word in the title should rank first");
+    TEST_ASSERT(results[1] == 4 && results[2] == 1, "Word starts in titles should follow, shorter first");
+    TEST_ASSERT(results[3] == 2, "Artist match should rank above album match");
+    TEST_ASSERT(results[4] == 3, "Album match should rank last");
+
+    found = search_index_query(index, "BEATLES", results, 16);
+    TEST_ASSERT(found == 2 && results[0] == 3 && results[1] == 0, "Title should beat artist, case-insensitively");
+
+    found = search_index_query(index, "sun beatles", results, 16);
+    TEST_ASSERT(found == 2, "Every query word should have to match");
+
+    found = search_index_query(index, "here-comes", results, 16);
+    TEST_ASSERT(found == 1 && results[0] == 0, "Punctuation should separate words");
+
+    found = search_index_query(index, "track 1234", results, 16);
+    TEST_ASSERT(found == 1 && results[0] == 5 + 1234, "Intersection should find the one entry with both words");
+
+    found = search_index_query(index, "track", results, 16);
+    TEST_ASSERT(found == 16, "Results should be capped at max_results");
+    TEST_ASSERT(results[0] == 5 && results[9] == 5 + 9 && results[10] == 5 + 50,
+                "Equal matches should rank by length, then index");
+
+    found = search_index_query(index, "7", results, 16);
+    TEST_ASSERT(found == 16, "Short words should match word starts through their prefix lists");
+
+    TEST_ASSERT(search_index_query(index, "zzz", results, 16) == 0, "Unknown trigram should match nothing");
+    TEST_ASSERT(search_index_query(index, "  ", results, 16) == 0, "Blank query should match nothing");
+
+    SearchIndexStats stats;
+    search_index_get_stats(index, &stats);
+    TEST_ASSERT(stats.entries == 2005 && stats.trigrams > 0 && stats.postings > stats.entries,
+                "Stats should count entries, trigrams and postings");
+    TEST_ASSERT(stats.memory_bytes > 0, "Stats should report memory");
+
+    search_index_clear(index);
+    TEST_ASSERT(search_index_count(index) == 0 && search_index_query(index, "sun", results, 16) == 0,
+                "Clear should empty the index");
+    search_index_destroy(index);
+
+    RhythmEngine* engine = rhythm_engine_create();
+    create_test_directory("test_dir");
+    rhythm_engine_load_directory(engine, "test_dir");
+    RhythmError result = rhythm_engine_search(engine, "test2", results, 16, &found);
+    TEST_ASSERT(result == RHYTHM_OK && found == 1, "Engine search should succeed");
+    TEST_ASSERT(strstr(playlist_get_file_at(rhythm_engine_get_playlist(engine), results[0]), "test2.mp3") != NULL,
+                "Engine search should return playlist indices");
+    RhythmSearchStats search_stats;
+    rhythm_engine_get_search_stats(engine, &search_stats);
+    TEST_ASSERT(search_stats.entries == 2, "Engine index should follow the playlist");
+
+    rhythm_engine_destroy(engine);
+    cleanup_test_files();
+    TEST_PASS();
+}
+
+static int test_session_snapshot(void) {
+    const char* path = "test_session.bin";
+    unlink(path);
+
+    Playlist* playlist = playlist_create();
+    char file[64];
+    for (int i = 0; i < 1000; i++) {
+        snprintf(file, sizeof(file), "/music/album %d/track %04d.mp3", i / 10, i);
+        playlist_add_file(playlist, file);
+    }
+    playlist_set_current(playlist, 123);
+    TEST_ASSERT(playlist_set_shuffle(playlist, true, 42) == 0 && playlist_is_shuffled(playlist),
+                "Shuffle should turn on");
+    TEST_ASSERT(playlist_get_current_index(playlist) == 123, "Shuffling should keep the current track");
+    playlist_next(playlist);
+    playlist_next(playlist);
+    int shuffled_current = playlist_get_current_index(playlist);
+    TEST_ASSERT(shuffled_current != 124, "Next should follow the shuffled order");
+
+    SessionState state = { shuffled_current, 48000 * 75, 0.6f, true };
+    TEST_ASSERT(session_save(path, playlist, &state, false) == 0, "Save should succeed");
+    TEST_ASSERT(access("test_session.bin.tmp", F_OK) != 0, "Save should not leave its temporary file");
+
+    // the second save of the same playlist rewrites only the header, in place
+    struct stat before, after;
+    stat(path, &before);
+    state.position_frames += 48000;
+    TEST_ASSERT(session_save(path, playlist, &state, true) == 0, "Header-only save should succeed");
+    stat(path, &after);
+    TEST_ASSERT(after.st_ino == before.st_ino && after.st_size == before.st_size,
+                "Header-only save should update the snapshot in place");
+
+    Playlist* restored = playlist_create();
+    playlist_add_file(restored, "/music/replaced.mp3");
+    SessionState loaded;
+    TEST_ASSERT(session_restore(path, restored, &loaded) == 0, "Restore should succeed");
+    TEST_ASSERT(playlist_get_count(restored) == 1000, "Restore should replace the entries");
+    TEST_ASSERT(loaded.current_index == shuffled_current && playlist_get_current_index(restored) == shuffled_current,
+                "Restore should select the saved track");
+    TEST_ASSERT(loaded.position_frames == 48000 * 76 && loaded.playing && fabsf(loaded.volume - 0.6f) < 1e-6f,
+                "Restore should return the last saved state");
+    bool same_paths = true;
+    for (int i = 0; i < 1000; i++) {
+        if (strcmp(playlist_get_file_at(restored, i), playlist_get_file_at(playlist, i)) != 0) same_paths = false;
+    }
+    TEST_ASSERT(same_paths, "Paths should survive the round trip");
+    TEST_ASSERT(playlist_is_shuffled(restored), "Shuffle should survive the round trip");
+    bool same_order = true;
+    for (int i = 0; i < 20; i++) {
+        if (playlist_next(restored) != playlist_next(playlist)) same_order = false;
+    }
+    TEST_ASSERT(same_order, "Restored shuffle should continue in the saved order");
+
+    TEST_ASSERT(playlist_set_shuffle(restored, false, 0) == 0 && !playlist_is_shuffled(restored),
+                "Shuffle should turn off");
+    int current = playlist_get_current_index(restored);
+    TEST_ASSERT(playlist_next(restored) == current + 1, "Unshuffled next should be the following entry");
+    playlist_destroy(restored);
+    playlist_destroy(playlist);
+
+    // a truncated snapshot is refused and the playlist it would replace is kept
+    FILE* f = fopen(path, "r+b");
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fclose(f);
+    TEST_ASSERT(truncate(path, size - 10) == 0, "Truncating the snapshot should succeed");
+    playlist = playlist_create();
+    playlist_add_file(playlist, "/music/kept.mp3");
+    TEST_ASSERT(session_restore(path, playlist, &loaded) != 0, "Damaged snapshot should be refused");
+    TEST_ASSERT(playlist_get_count(playlist) == 1, "Refused snapshot should leave the playlist alone");
+    playlist_destroy(playlist);
+    unlink(path);
+
+    // engine: resume on the saved track at the saved position
+    mkdir("test_dir", 0755);
+    create_test_wav("test_dir/a.wav", 44100, 44100 * 4);
+    create_test_wav("test_dir/b.wav", 44100, 44100 * 4);
+    RhythmEngine* engine = rhythm_engine_create();
+    rhythm_engine_load_directory(engine, "test_dir");
+    rhythm_engine_set_volume(engine, 0.4f);
+    rhythm_engine_play_track(engine, 1);
+    rhythm_engine_seek(engine, 0.5f);
+    TEST_ASSERT(rhythm_engine_set_session_file(engine, path, 0) == RHYTHM_OK, "Session file should be accepted");
+    rhythm_engine_destroy(engine);
+    TEST_ASSERT(access(path, F_OK) == 0, "Destroy should save the session");
+
+    engine = rhythm_engine_create();
+    TEST_ASSERT(rhythm_engine_restore_session(engine, "missing_session.bin") == RHYTHM_ERROR_FILE_NOT_FOUND,
+                "Missing snapshot should report file not found");
+    TEST_ASSERT(rhythm_engine_restore_session(engine, path) == RHYTHM_OK, "Engine restore should succeed");
+    RhythmStatus status = rhythm_engine_get_status(engine);
+    TEST_ASSERT(status.total_tracks == 2 && status.current_track == 2, "Engine should restore the playlist");
+    TEST_ASSERT(status.state == PLAYER_STATE_PLAYING, "A playing session should play on after restore");
+    TEST_ASSERT(status.current_time == 2, "Playback should resume from the saved position");
+    TEST_ASSERT(fabsf(status.volume - 0.4f) < 1e-6f, "Volume should be restored");
+
+    TEST_ASSERT(rhythm_engine_set_shuffle(engine, true) == RHYTHM_OK && rhythm_engine_get_shuffle(engine),
+                "Engine shuffle should turn on");
+    status = rhythm_engine_get_status(engine);
+    TEST_ASSERT(status.shuffle, "Status should report shuffle");
+    rhythm_engine_destroy(engine);
+
+    unlink(path);
+    unlink("test_dir/a.wav");
+    unlink("test_dir/b.wav");
+    rmdir("test_dir");
+    TEST_PASS();
+}
+
+static atomic_int realtime_test_tid;
+static atomic_bool realtime_test_done;
+
+static void* realtime_test_thread(void* arg) {
+    (void)arg;
+    realtime_register_thread(REALTIME_ROLE_DECODER);
+    atomic_store(&realtime_test_tid, (int)syscall(SYS_gettid));
+    while (!atomic_load(&realtime_test_done)) usleep(1000);
+    return NULL;
+}
+
+// the Cpus_allowed_list line of a thread, as the kernel sees it
+static void read_thread_cpus(int tid, char* cpus, size_t size) {
+    char path[64], line[256];
+    snprintf(path, sizeof(path), "/proc/self/task/%d/status", tid);
+    cpus[0] = '\0';
+    FILE* f = fopen(path, "r");
+    if (!f) return;
+    while (fgets(line, sizeof(line), f)) {
+        if (strncmp(line, "Cpus_allowed_list:", 18) == 0) {
+            const char* value = line + 18 + strspn(line + 18, " \t");
+            snprintf(cpus, size, "%.*s", (int)strcspn(value, " \t\n"), value);
+        }
+    }
+    fclose(f);
+}
+
+static int test_realtime_profile(void) {
+    uint64_t mask = 0;
+    TEST_ASSERT(realtime_parse_cpus("0-2,5", &mask) == 0 && mask == 0x27, "CPU list should parse ranges");
+    TEST_ASSERT(realtime_parse_cpus("3", &mask) == 0 && mask == 0x8, "CPU list should parse one CPU");
+    TEST_ASSERT(realtime_parse_cpus("2-1", &mask) != 0, "Backwards range should be refused");
+    TEST_ASSERT(realtime_parse_cpus("64", &mask) != 0, "CPUs past 63 should be refused");
+    TEST_ASSERT(realtime_parse_cpus("a", &mask) != 0, "Garbage should be refused");
+
+    RealtimeConfig config;
+    realtime_config_defaults(&config);
+    TEST_ASSERT(!config.enabled && config.lock_memory, "Profile should be off by default");
+    setenv("RHYTHM_REALTIME", "1", 1);
+    setenv("RHYTHM_RT_PRIORITY", "30", 1);
+    setenv("RHYTHM_RT_DECODER_CPUS", "0", 1);
+    realtime_config_from_env(&config);
+    unsetenv("RHYTHM_REALTIME");
+    unsetenv("RHYTHM_RT_PRIORITY");
+    unsetenv("RHYTHM_RT_DECODER_CPUS");
+    TEST_ASSERT(config.enabled, "RHYTHM_REALTIME should enable the profile");
+    TEST_ASSERT(config.priority[REALTIME_ROLE_AUDIO] == 30 && config.priority[REALTIME_ROLE_DECODER] == 20,
+                "Decoders should run below the audio priority");
+    TEST_ASSERT(config.cpus[REALTIME_ROLE_DECODER] == 1 && config.cpus[REALTIME_ROLE_AUDIO] == 0,
+                "Only the named role should be pinned");
+
+    pthread_t thread;
+    atomic_store(&realtime_test_tid, 0);
+    atomic_store(&realtime_test_done, false);
+    pthread_create(&thread, NULL, realtime_test_thread, NULL);
+    while (atomic_load(&realtime_test_tid) == 0) usleep(1000);
+    int tid = atomic_load(&realtime_test_tid);
+
+    config.lock_memory = false;
+    TEST_ASSERT(realtime_enable(&config) == 0, "Enabling should succeed whatever it obtains");
+    RealtimeStatus status;
+    realtime_get_status(&status);
+    RealtimeRoleStatus* decoder = &status.roles[REALTIME_ROLE_DECODER];
+    TEST_ASSERT(status.enabled && decoder->threads >= 1, "Registered thread should be counted");
+    TEST_ASSERT(decoder->promoted <= decoder->threads && decoder->pinned <= decoder->threads,
+                "Guarantees should be counted per thread");
+
+    // whatever was obtained, the report must match what the kernel says
+    if (decoder->method == REALTIME_METHOD_FIFO || decoder->method == REALTIME_METHOD_RTKIT) {
+        TEST_ASSERT((sched_getscheduler(tid) & 0xff) == SCHED_FIFO, "Reported SCHED_FIFO should be in effect");
+    }
+    char cpus[64];
+    if (decoder->pinned == decoder->threads) {
+        read_thread_cpus(tid, cpus, sizeof(cpus));
+        TEST_ASSERT(strcmp(cpus, "0") == 0, "Reported pinning should be in effect");
+    }
+
+    realtime_disable();
+    realtime_get_status(&status);
+    TEST_ASSERT(!status.enabled && status.roles[REALTIME_ROLE_DECODER].promoted == 0, "Disable should demote");
+    TEST_ASSERT((sched_getscheduler(tid) & 0xff) == SCHED_OTHER, "Thread should be back on SCHED_OTHER");
+
+    int threads_before = status.roles[REALTIME_ROLE_DECODER].threads;
+    atomic_store(&realtime_test_done, true);
+    pthread_join(thread, NULL);
+    realtime_apply();
+    realtime_get_status(&status);
+    TEST_ASSERT(status.roles[REALTIME_ROLE_DECODER].threads == threads_before - 1,
+                "Exited threads should be forgotten");
+
+    // sample rings are locked, or at least prefaulted, while the profile is on
+    config.lock_memory = true;
+    realtime_enable(&config);
+    RingBuffer* ring = ring_buffer_create(1 << 16);
+    realtime_get_status(&status);
+    TEST_ASSERT(status.memory_locked || status.buffers_locked + status.buffers_prefaulted >= (1 << 16) * sizeof(float),
+                "New rings should be locked or prefaulted");
+    realtime_disable();
+    realtime_get_status(&status);
+    TEST_ASSERT(!status.memory_locked && status.buffers_locked == 0, "Disable should unlock memory");
+    ring_buffer_destroy(ring);
+
+    RhythmEngine* engine = rhythm_engine_create();
+    RhythmRealtimeStatus engine_status;
+    TEST_ASSERT(rhythm_engine_get_realtime_status(engine, &engine_status) == RHYTHM_OK && !engine_status.enabled,
+                "Engine should report the profile off");
+    config.priority[REALTIME_ROLE_AUDIO] = 0;
+    TEST_ASSERT(rhythm_engine_set_realtime(engine, &config) == RHYTHM_ERROR_INVALID_STATE,
+                "Out of range priority should be refused");
+    rhythm_engine_destroy(engine);
+    TEST_PASS();
+}
+
+static int test_low_power(void) {
+    create_test_wav("test_power.wav", 44100, 44100 * 10);
+    RhythmEngine* engine = rhythm_engine_create();
+    TEST_ASSERT(engine != NULL, "Engine creation should succeed");
+    TEST_ASSERT(rhythm_engine_set_power_mode(engine, RHYTHM_POWER_AUTO) == RHYTHM_OK && !rhythm_engine_is_low_power(engine),
+                "Engines should start interactive");
+    TEST_ASSERT(rhythm_engine_get_tick_interval_ms(engine) == RHYTHM_TICK_MS, "Ticks should be short while interactive");
+    TEST_ASSERT(rhythm_engine_set_power_mode(engine, (RhythmPowerMode)7) == RHYTHM_ERROR_INVALID_STATE,
+                "Unknown modes should be refused");
+
+    TEST_ASSERT(rhythm_engine_load_file(engine, "test_power.wav") == RHYTHM_OK &&
+                rhythm_engine_play(engine) == RHYTHM_OK && rhythm_engine_seek(engine, 0.5f) == RHYTHM_OK,
+                "Playback should start");
+    RhythmStats stats;
+    rhythm_engine_get_stats(engine, &stats);
+    float normal_ring_ms = stats.ring_capacity_ms;
+
+    // nobody looking: deep ring, long periods, coalesced ticks, same position
+    TEST_ASSERT(rhythm_engine_set_interactive(engine, false) == RHYTHM_OK && rhythm_engine_is_low_power(engine),
+                "Auto mode should save power without an interactive front-end");
+    TEST_ASSERT(rhythm_engine_get_tick_interval_ms(engine) == RHYTHM_LOW_POWER_TICK_MS, "Ticks should coalesce");
+    RhythmAudioInfo info;
+    rhythm_engine_get_audio_info(engine, &info);
+    rhythm_engine_get_stats(engine, &stats);
+    TEST_ASSERT(info.backend != AUDIO_BACKEND_PORTAUDIO || info.frames_per_buffer >= 4096,
+                "PortAudio periods should grow");
+    TEST_ASSERT(stats.ring_capacity_ms >= 4000.0f && stats.ring_capacity_ms > normal_ring_ms * 8,
+                "Decode-ahead should hold seconds");
+    for (int i = 0; i < 500 && info.buffer_latency_ms < 1000.0f; i++) {
+        usleep(2000);
+        rhythm_engine_get_audio_info(engine, &info);
+    }
+    TEST_ASSERT(info.buffer_latency_ms >= 1000.0f, "The deep ring should fill past the normal one");
+    RhythmStatus status = rhythm_engine_get_status(engine);
+    TEST_ASSERT(status.state == PLAYER_STATE_PLAYING && fabsf(status.progress - 0.5f) < 0.02f,
+                "Switching should keep playing from the same position");
+
+    TEST_ASSERT(rhythm_engine_set_interactive(engine, true) == RHYTHM_OK && !rhythm_engine_is_low_power(engine),
+                "Interactivity should bring normal buffering back");
+    rhythm_engine_get_stats(engine, &stats);
+    status = rhythm_engine_get_status(engine);
+    TEST_ASSERT(stats.ring_capacity_ms == normal_ring_ms && status.state == PLAYER_STATE_PLAYING &&
+                fabsf(status.progress - 0.5f) < 0.02f, "Switching back should be seamless");
+
+    // an explicit mode wins over interactivity; the hosted GUI reports it as a command
+    TEST_ASSERT(rhythm_engine_set_power_mode(engine, RHYTHM_POWER_LOW) == RHYTHM_OK && rhythm_engine_is_low_power(engine),
+                "Low mode should apply while interactive");
+    TEST_ASSERT(rhythm_engine_set_power_mode(engine, RHYTHM_POWER_NORMAL) == RHYTHM_OK &&
+                engine_host_run_command(engine, ENGINE_COMMAND_SET_INTERACTIVE, 0, 0.0f, NULL) == RHYTHM_OK &&
+                !rhythm_engine_is_low_power(engine), "Normal mode should stay normal when nobody is looking");
+    TEST_ASSERT(rhythm_engine_set_power_mode(engine, RHYTHM_POWER_AUTO) == RHYTHM_OK && rhythm_engine_is_low_power(engine),
+                "Auto mode should follow the hidden front-end");
+    TEST_ASSERT(engine_host_run_command(engine, ENGINE_COMMAND_SET_INTERACTIVE, 1, 0.0f, NULL) == RHYTHM_OK &&
+                !rhythm_engine_is_low_power(engine), "Showing the window should end low power");
+
+    rhythm_engine_destroy(engine);
+    unlink("test_power.wav");
+    TEST_PASS();
+}
+
+static void create_sparse_file(const char* path, off_t size) {
+    FILE* f = fopen(path, "wb");
+    if (!f) return;
+    ftruncate(fileno(f), size);
+    fclose(f);
+}
+
+static bool wait_prefetch_idle(Prefetcher* prefetcher) {
+    for (int i = 0; i < 500 && !prefetch_is_idle(prefetcher); i++) usleep(2000);
+    return prefetch_is_idle(prefetcher);
+}
+
+static int test_prefetch(void) {
+    // the budget covers the queue, nearest first
+    const char* big[] = { "prefetch_a.bin", "prefetch_b.bin", "prefetch_c.bin", "prefetch_d.bin" };
+    for (int i = 0; i < 4; i++) create_sparse_file(big[i], 4 * PREFETCH_CHUNK_BYTES);
+    Prefetcher* prefetcher = prefetch_create(6 * PREFETCH_CHUNK_BYTES);
+    TEST_ASSERT(prefetcher != NULL && prefetch_is_idle(prefetcher), "Prefetcher should start idle");
+    TEST_ASSERT(prefetch_schedule(prefetcher, big, 3) == 0 && wait_prefetch_idle(prefetcher), "Queue should drain");
+    PrefetchStats stats;
+    prefetch_get_stats(prefetcher, &stats);
+    TEST_ASSERT(stats.scheduled == 3 && stats.warmed == 2 && stats.bytes == 6 * PREFETCH_CHUNK_BYTES,
+                "Read-ahead should stop at the budget");
+
+    // the same queue is left alone; a new one cancels whatever of the old is unread
+    TEST_ASSERT(prefetch_schedule(prefetcher, big, 3) == 0, "Rescheduling should succeed");
+    prefetch_get_stats(prefetcher, &stats);
+    TEST_ASSERT(stats.scheduled == 3, "An unchanged queue should not be read again");
+    const char* reordered[] = { big[1], big[2], big[0] };
+    prefetch_set_budget(prefetcher, 64 * PREFETCH_CHUNK_BYTES);
+    prefetch_schedule(prefetcher, reordered, 3);
+    prefetch_schedule(prefetcher, big + 3, 1);
+    TEST_ASSERT(wait_prefetch_idle(prefetcher), "Queue should drain");
+    prefetch_get_stats(prefetcher, &stats);
+    TEST_ASSERT(stats.scheduled == 7 && stats.warmed + stats.cancelled == 6,
+                "Every replaced entry should be read or cancelled");
+    TEST_ASSERT(prefetch_note_start(prefetcher, "missing.bin") == false, "Missing files are not hits");
+    prefetch_destroy(prefetcher);
+    for (int i = 0; i < 4; i++) unlink(big[i]);
+
+    // the engine queues the current track while stopped, then the next ones in play order
+    mkdir("prefetch_dir", 0755);
+    create_test_wav("prefetch_dir/a.wav", 44100, 44100 * 2);
+    create_test_wav("prefetch_dir/b.wav", 44100, 44100 * 2);
+    create_test_wav("prefetch_dir/c.wav", 44100, 44100 * 2);
+    RhythmEngine* engine = rhythm_engine_create();
+    TEST_ASSERT(engine != NULL, "Engine creation should succeed");
+    TEST_ASSERT(rhythm_engine_set_prefetch(engine, PREFETCH_MAX_TRACKS + 1, 0) == RHYTHM_ERROR_INVALID_STATE,
+                "Too deep a look-ahead should be refused");
+    TEST_ASSERT(rhythm_engine_set_prefetch(engine, 1, 0) == RHYTHM_OK &&
+                rhythm_engine_load_directory(engine, "prefetch_dir") == RHYTHM_OK, "Directory should load");
+    RhythmPrefetchStats engine_stats;
+    for (int i = 0; i < 500; i++) {
+        rhythm_engine_get_prefetch_stats(engine, &engine_stats);
+        if (engine_stats.idle) break;
+        usleep(2000);
+    }
+    TEST_ASSERT(engine_stats.scheduled == 2 && engine_stats.warmed == 2, "Current and next track should be warmed");
+
+    TEST_ASSERT(rhythm_engine_play(engine) == RHYTHM_OK, "Playback should start");
+    for (int i = 0; i < 500 && engine_stats.first_sample_ms == 0.0f; i++) {
+        usleep(2000);
+        rhythm_engine_get_prefetch_stats(engine, &engine_stats);
+    }
+    TEST_ASSERT(engine_stats.hits == 1 && engine_stats.misses == 0 && engine_stats.hit_rate == 1.0f,
+                "A warmed track should start from the cache");
+    TEST_ASSERT(engine_stats.first_sample_ms > 0.0f, "Time to first sample should be measured");
+
+    // reshuffling requeues from the new order
+    TEST_ASSERT(rhythm_engine_set_shuffle(engine, true) == RHYTHM_OK, "Shuffle should turn on");
+    Playlist* playlist = rhythm_engine_get_playlist(engine);
+    int upcoming[4];
+    TEST_ASSERT(playlist_get_upcoming(playlist, upcoming, 4) == 2 &&
+                upcoming[0] == playlist->order[(playlist->order_position + 1) % 3], "Upcoming should follow the shuffle");
+    TEST_ASSERT(rhythm_engine_next_track(engine) == RHYTHM_OK, "Next track should start");
+    rhythm_engine_get_prefetch_stats(engine, &engine_stats);
+    TEST_ASSERT(engine_stats.hits + engine_stats.misses == 2 && engine_stats.first_sample_hit_ms > 0.0f,
+                "The first start should be counted as a hit");
+
+    TEST_ASSERT(rhythm_engine_set_prefetch(engine, 0, 0) == RHYTHM_OK, "Prefetch should turn off");
+    rhythm_engine_destroy(engine);
+    unlink("prefetch_dir/a.wav");
+    unlink("prefetch_dir/b.wav");
+    unlink("prefetch_dir/c.wav");
+    rmdir("prefetch_dir");
+    TEST_PASS();
+}
+
+// reads the whole file through decoder into out, which holds frames stereo frames
+static size_t decode_all(Decoder* decoder, float* out, size_t frames) {
+    size_t total = 0, read = 0;
+    while (total < frames && decoder_read(decoder, out + total * 2, 4096, &read) == DECODER_OK) {
+        total += read;
+    }
+    return total;
+}
+
+// FORMAT_SWITCH_FRAMES of stereo at 44.1 kHz, then a switch to mono at 22.05 kHz and as
+// many frames again, each frame's samples holding its index
+#define FORMAT_SWITCH_FRAMES 1000
+
+typedef struct {
+    Decoder base;
+    long long position;
+} FormatSwitchDecoder;
+
+static int format_switch_open(Decoder* decoder, const char* path) {
+    (void)path;
+    decoder->rate = 44100;
+    decoder->channels = 2;
+    decoder->length_frames = -1;
+    ((FormatSwitchDecoder*)decoder)->position = 0;
+    return 0;
+}
+
+static DecoderStatus format_switch_read(Decoder* decoder, float* out, size_t max_frames, size_t* frames_read) {
+    FormatSwitchDecoder* fake = (FormatSwitchDecoder*)decoder;
+    *frames_read = 0;
+    if (fake->position == FORMAT_SWITCH_FRAMES && decoder->channels == 2) {
+        decoder->rate = 22050;
+        decoder->channels = 1;
+        return DECODER_NEW_FORMAT;
+    }
+    if (fake->position >= 2 * FORMAT_SWITCH_FRAMES) return DECODER_DONE;
+    long long end = fake->position < FORMAT_SWITCH_FRAMES ? FORMAT_SWITCH_FRAMES : 2 * FORMAT_SWITCH_FRAMES;
+    size_t frames = (size_t)(end - fake->position) < max_frames ? (size_t)(end - fake->position) : max_frames;
+    for (size_t i = 0; i < frames * (size_t)decoder->channels; i++) {
+        out[i] = (float)(fake->position + (long long)(i / (size_t)decoder->channels));
+    }
+    fake->position += (long long)frames;
+    *frames_read = frames;
+    return DECODER_OK;
+}
+
+static int format_switch_seek(Decoder* decoder, long long frame) {
+    ((FormatSwitchDecoder*)decoder)->position = frame;
+    return frame == 0 ? 0 : -1;
+}
+
+static void format_switch_close(Decoder* decoder) {
+    (void)decoder;
+}
+
+static void format_switch_destroy(Decoder* decoder) {
+    free(decoder);
+}
+
+static const DecoderOps format_switch_ops = {
+    .name = "format_switch",
+    .open = format_switch_open,
+    .read = format_switch_read,
+    .seek = format_switch_seek,
+    .close = format_switch_close,
+    .destroy = format_switch_destroy,
+};
+
+static int test_pcm_cache(void) {
+    // three segments, the last one short
+    const size_t frames = 2 * PCM_CACHE_SEGMENT_FRAMES + 18928;
+    create_test_wav("test_pcm_cache.wav", 44100, (int)frames);
+    float* direct = malloc(frames * 2 * sizeof(float));
+    float* cached = malloc(frames * 2 * sizeof(float));
+    Decoder* source = wav_decoder_create();
+    TEST_ASSERT(direct && cached && source, "Buffers and decoder should be created");
+    TEST_ASSERT(decoder_open(source, "test_pcm_cache.wav") == 0 && decode_all(source, direct, frames) == frames,
+                "Direct decode should read the whole file");
+    decoder_close(source);
+
+    PcmCache* cache = pcm_cache_create(PCM_CACHE_DEFAULT_BUDGET, false);
+    Decoder* decoder = pcm_cache_decoder_create(cache);
+    TEST_ASSERT(cache && decoder, "Cache and its decoder should be created");
+    pcm_cache_decoder_set_source(decoder, source);
+    TEST_ASSERT(decoder_open(decoder, "test_pcm_cache.wav") == 0 && decoder->length_frames == (long long)frames,
+                "Cached decoder should open with the source's format");
+    TEST_ASSERT(decode_all(decoder, cached, frames) == frames &&
+                memcmp(direct, cached, frames * 2 * sizeof(float)) == 0, "First pass should match the source");
+    PcmCacheStats stats;
+    pcm_cache_get_stats(cache, &stats);
+    TEST_ASSERT(stats.misses == 3 && stats.hits == 0 && stats.segments == 3 &&
+                stats.bytes == frames * 2 * sizeof(float), "First pass should fill three segments");
+
+    // a replay reads memory only, and so does seeking back
+    decoder_close(decoder);
+    memset(cached, 0, frames * 2 * sizeof(float));
+    TEST_ASSERT(decoder_open(decoder, "test_pcm_cache.wav") == 0 && decoder->rate == 44100 &&
+                decode_all(decoder, cached, frames) == frames &&
+                memcmp(direct, cached, frames * 2 * sizeof(float)) == 0, "Replay should match the source");
+    float sample[2];
+    size_t read = 0;
+    TEST_ASSERT(decoder_seek(decoder, 70000) == 0 && decoder_read(decoder, sample, 1, &read) == DECODER_OK &&
+                read == 1 && sample[0] == direct[70000 * 2], "Seeking back should be sample accurate");
+    pcm_cache_get_stats(cache, &stats);
+    TEST_ASSERT(stats.misses == 3 && stats.hits == 4, "Replay and seek should hit every segment");
+    decoder_close(decoder);
+
+    // packing halves the memory and is lossless for 16-bit sources
+    pcm_cache_configure(cache, PCM_CACHE_DEFAULT_BUDGET, true);
+    pcm_cache_get_stats(cache, &stats);
+    TEST_ASSERT(stats.packed && stats.segments == 0, "Switching to packing should empty the cache");
+    for (int pass = 0; pass < 2; pass++) {
+        memset(cached, 0, frames * 2 * sizeof(float));
+        TEST_ASSERT(decoder_open(decoder, "test_pcm_cache.wav") == 0 && decode_all(decoder, cached, frames) == frames &&
+                    memcmp(direct, cached, frames * 2 * sizeof(float)) == 0, "Packed samples should round-trip");
+        decoder_close(decoder);
+    }
+    pcm_cache_get_stats(cache, &stats);
+    TEST_ASSERT(stats.bytes == frames * 2 * sizeof(int16_t) && stats.hits == 7, "Packed segments should be reused");
+
+    // the least recently used segments go to stay within the budget
+    size_t segment_bytes = PCM_CACHE_SEGMENT_FRAMES * 2 * sizeof(float);
+    pcm_cache_configure(cache, 2 * segment_bytes, false);
+    TEST_ASSERT(decoder_open(decoder, "test_pcm_cache.wav") == 0 && decode_all(decoder, cached, frames) == frames,
+                "Decode under a small budget should succeed");
+    decoder_close(decoder);
+    pcm_cache_get_stats(cache, &stats);
+    TEST_ASSERT(stats.bytes <= 2 * segment_bytes && stats.evictions > 0, "Cache should stay within its budget");
+
+    pcm_cache_configure(cache, 0, false);
+    TEST_ASSERT(decoder_open(decoder, "test_pcm_cache.wav") == 0 && decode_all(decoder, cached, frames) == frames &&
+                memcmp(direct, cached, frames * 2 * sizeof(float)) == 0, "A zero budget should pass through");
+    decoder_close(decoder);
+    pcm_cache_get_stats(cache, &stats);
+    TEST_ASSERT(stats.segments == 0 && stats.bytes == 0, "A zero budget should keep nothing");
+
+    // frames decoded before a format change are played, not dropped, and not cached
+    pcm_cache_configure(cache, PCM_CACHE_DEFAULT_BUDGET, false);
+    FormatSwitchDecoder* fake = calloc(1, sizeof(FormatSwitchDecoder));
+    TEST_ASSERT(fake != NULL, "Fake decoder should be created");
+    fake->base.ops = &format_switch_ops;
+    pcm_cache_decoder_set_source(decoder, &fake->base);
+    TEST_ASSERT(decoder_open(decoder, "test_pcm_cache.wav") == 0, "Cached decoder should open the fake source");
+    size_t before = 0, after = 0;
+    DecoderStatus status;
+    while ((status = decoder_read(decoder, cached + before * 2, 256, &read)) == DECODER_OK && read > 0) {
+        before += read;
+    }
+    TEST_ASSERT(before == FORMAT_SWITCH_FRAMES && cached[0] == 0.0f &&
+                cached[(FORMAT_SWITCH_FRAMES - 1) * 2] == (float)(FORMAT_SWITCH_FRAMES - 1),
+                "Every frame before the format change should be read");
+    TEST_ASSERT(status == DECODER_NEW_FORMAT && decoder->rate == 22050 && decoder->channels == 1,
+                "The format change should follow them");
+    while (decoder_read(decoder, cached + after, 256, &read) == DECODER_OK && read > 0) {
+        after += read;
+    }
+    TEST_ASSERT(after == FORMAT_SWITCH_FRAMES && cached[0] == (float)FORMAT_SWITCH_FRAMES,
+                "The new format should continue where the old one ended");
+    pcm_cache_get_stats(cache, &stats);
+    TEST_ASSERT(stats.segments == 0, "A segment with a format change should not be cached");
+    decoder_close(decoder);
+    decoder_destroy(&fake->base);
+
+    decoder_destroy(decoder);
+    decoder_destroy(source);
+    pcm_cache_destroy(cache);
+    free(direct);
+    free(cached);
+
+    // the engine plays local files through its cache
+    RhythmEngine* engine = rhythm_engine_create();
+    TEST_ASSERT(engine != NULL, "Engine creation should succeed");
+    RhythmPcmCacheStats engine_stats;
+    TEST_ASSERT(rhythm_engine_set_pcm_cache(engine, PCM_CACHE_DEFAULT_BUDGET, true) == RHYTHM_OK &&
+                rhythm_engine_get_pcm_cache_stats(engine, &engine_stats) == RHYTHM_OK &&
+                engine_stats.packed && engine_stats.budget == PCM_CACHE_DEFAULT_BUDGET, "Cache should be configured");
+    create_test_wav("test_pcm_short.wav", 44100, 4410);
+    TEST_ASSERT(rhythm_engine_load_file(engine, "test_pcm_short.wav") == RHYTHM_OK &&
+                rhythm_engine_play(engine) == RHYTHM_OK, "WAV file should play");
+    for (int i = 0; i < 500 && engine_stats.segments == 0; i++) {
+        usleep(2000);
+        rhythm_engine_get_pcm_cache_stats(engine, &engine_stats);
+    }
+    TEST_ASSERT(engine_stats.segments == 1 && engine_stats.misses == 1, "Playback should cache the track");
+    TEST_ASSERT(rhythm_engine_play_track(engine, 0) == RHYTHM_OK, "Replay should start");
+    for (int i = 0; i < 500 && engine_stats.hits == 0; i++) {
+        usleep(2000);
+        rhythm_engine_get_pcm_cache_stats(engine, &engine_stats);
+    }
+    TEST_ASSERT(engine_stats.hits >= 1 && engine_stats.misses == 1, "Replay should come from the cache");
+
+    // one budget for the process: a second engine sees the same cache
+    RhythmEngine* other = rhythm_engine_create();
+    RhythmPcmCacheStats other_stats;
+    TEST_ASSERT(other != NULL && rhythm_engine_get_pcm_cache_stats(other, &other_stats) == RHYTHM_OK &&
+                other_stats.packed && other_stats.segments == engine_stats.segments,
+                "Engines should share one PCM cache");
+    rhythm_engine_destroy(other);
+    rhythm_engine_destroy(engine);
+    unlink("test_pcm_short.wav");
+    unlink("test_pcm_cache.wav");
+    TEST_PASS();
+}
+
+typedef struct {
+    pthread_mutex_t lock;
+    int count;
+    int errors;
+    char last[LOG_MESSAGE_MAX];
+} LogCapture;
+
+static void capture_log(RhythmLogLevel level, const char* message, void* user_data) {
+    LogCapture* capture = user_data;
+    pthread_mutex_lock(&capture->lock);
+    capture->count++;
+    if (level == LOG_LEVEL_ERROR) capture->errors++;
+    snprintf(capture->last, sizeof(capture->last), "%s", message);
+    pthread_mutex_unlock(&capture->lock);
+}
+
+static void* log_from_thread(void* arg) {
+    char name[16];
+    snprintf(name, sizeof(name), "worker %d", *(int*)arg);
+    LOG_WARN("%s at %.1f%% of %u, %5d", name, 12.5, 44100u, -3);
+    return NULL;
+}
+
+static void* log_unlimited_from_thread(void* arg) {
+    LOG_ALWAYS(LOG_LEVEL_INFO, "thread %d", *(int*)arg);
+    return NULL;
+}
+
+static int check_positive(int value) {
+    CHECK_ERROR(value <= 0, -1, "value must be positive");
+    return 0;
+}
+
+static int test_logging(void) {
+    RhythmEngine* engine = rhythm_engine_create();
+    TEST_ASSERT(engine != NULL, "Engine creation should succeed");
+    LogCapture capture = { .lock = PTHREAD_MUTEX_INITIALIZER };
+    TEST_ASSERT(rhythm_engine_set_log_callback(engine, capture_log, &capture) == RHYTHM_OK &&
+                rhythm_engine_set_log_level(engine, LOG_LEVEL_INFO) == RHYTHM_OK, "Log sink should be set");
+    TEST_ASSERT(rhythm_engine_set_log_level(engine, (RhythmLogLevel)9) == RHYTHM_ERROR_INVALID_STATE,
+                "Unknown levels should be refused");
+
+    // arguments are captured on the logging thread, formatted on the drain thread
+    int id = 7;
+    pthread_t thread;
+    pthread_create(&thread, NULL, log_from_thread, &id);
+    pthread_join(thread, NULL);
+    LOG_DEBUG("below the level %d", 1);
+    log_flush();
+    TEST_ASSERT(capture.count == 1 && strcmp(capture.last, "worker 7 at 12.5% of 44100,    -3") == 0,
+                "Records should be formatted after the fact");
+
+    // one site repeating itself is held to the burst, the rest counted
+    RhythmLogStats before, after;
+    rhythm_engine_get_log_stats(engine, &before);
+    for (int i = 0; i < 100; i++) LOG_INFO("repeated %d", i);
+    log_flush();
+    rhythm_engine_get_log_stats(engine, &after);
+    TEST_ASSERT(capture.count == 1 + LOG_RATE_BURST && after.suppressed - before.suppressed == 100 - LOG_RATE_BURST,
+                "A noisy site should be rate limited");
+
+    // rings of exited threads go back to the pool
+    for (int i = 0; i < LOG_MAX_THREADS * 2; i++) {
+        pthread_create(&thread, NULL, log_unlimited_from_thread, &i);
+        pthread_join(thread, NULL);
+        log_flush();
+    }
+    rhythm_engine_get_log_stats(engine, &after);
+    TEST_ASSERT(after.dropped == before.dropped && capture.count == 1 + LOG_RATE_BURST + LOG_MAX_THREADS * 2,
+                "Short-lived threads should not run out of rings");
+
+    TEST_ASSERT(check_positive(-5) == -1 && check_positive(5) == 0, "CHECK_ERROR should return the error");
+    log_flush();
+    TEST_ASSERT(capture.errors == 1 && strcmp(capture.last, "value must be positive") == 0,
+                "CHECK_ERROR should log instead of exiting");
+
+    rhythm_engine_set_log_callback(engine, NULL, NULL);
+    rhythm_engine_destroy(engine);
+    TEST_PASS();
+}
+
 static int test_error_strings(void) {
     const char* error_str;
 
@@ -293,6 +2083,28 @@ int main(void) {
     total++; if (test_playlist_navigation()) passed++;
     total++; if (test_seek_functionality()) passed++;
     total++; if (test_status_updates()) passed++;
+    total++; if (test_status_frame()) passed++;
+    total++; if (test_audio_configuration()) passed++;
+    total++; if (test_audio_stats()) passed++;
+    total++; if (test_wav_playback()) passed++;
+    total++; if (test_loudness_scan()) passed++;
+    total++; if (test_dsp_chain()) passed++;
+    total++; if (test_waveform_overview()) passed++;
+    total++; if (test_audio_features()) passed++;
+    total++; if (test_engine_host()) passed++;
+    total++; if (test_rhythm_server()) passed++;
+    total++; if (test_mixer()) passed++;
+    total++; if (test_decoder_pool()) passed++;
+    total++; if (test_conversion_plan()) passed++;
+    total++; if (test_stream_sources()) passed++;
+    total++; if (test_playlist_view()) passed++;
+    total++; if (test_search_index()) passed++;
+    total++; if (test_session_snapshot()) passed++;
+    total++; if (test_realtime_profile()) passed++;
+    total++; if (test_low_power()) passed++;
+    total++; if (test_logging()) passed++;
+    total++; if (test_prefetch()) passed++;
+    total++; if (test_pcm_cache()) passed++;
     total++; if (test_error_strings()) passed++;
 
     printf("\n================================\n");